@@ -4329,9 +4329,10 @@ gst_av1_parser_parse_tile_list_obu (GstAV1Parser * parser,
     GstAV1OBU * obu, GstAV1TileListOBU * tile_list)
 {
   GstAV1ParserResult retval = GST_AV1_PARSER_OK;
-  GstBitReader *br;
-  GstBitReader bitreader;
+  const guint8 *data;
+  guint32 pos, size;
   gint tile;
+  GstBitReader bitreader;
 
   g_return_val_if_fail (parser != NULL, GST_AV1_PARSER_INVALID_OPERATION);
   g_return_val_if_fail (obu != NULL, GST_AV1_PARSER_INVALID_OPERATION);
@@ -4339,40 +4340,60 @@ gst_av1_parser_parse_tile_list_obu (GstAV1Parser * parser,
       GST_AV1_PARSER_INVALID_OPERATION);
   g_return_val_if_fail (tile_list != NULL, GST_AV1_PARSER_INVALID_OPERATION);
 
-  br = &bitreader;
-  memset (tile_list, 0, sizeof (*tile_list));
-  gst_bit_reader_init (br, obu->data, obu->obu_size);
-  if (AV1_REMAINING_BITS (br) < 8 + 8 + 16) {
+  /* Every syntax element of the tile list is byte aligned, so read the
+   * entries straight from the OBU data. Only the entries which are
+   * actually present are written. */
+  memset (tile_list, 0, G_STRUCT_OFFSET (GstAV1TileListOBU, entry));
+  data = obu->data;
+  size = obu->obu_size;
+  if (size < 4) {
     retval = GST_AV1_PARSER_NO_MORE_DATA;
     goto error;
   }
 
-  tile_list->output_frame_width_in_tiles_minus_1 = AV1_READ_BITS (br, 8);
-  tile_list->output_frame_height_in_tiles_minus_1 = AV1_READ_BITS (br, 8);
-  tile_list->tile_count_minus_1 = AV1_READ_BITS (br, 16);
+  tile_list->output_frame_width_in_tiles_minus_1 = data[0];
+  tile_list->output_frame_height_in_tiles_minus_1 = data[1];
+  tile_list->tile_count_minus_1 = GST_READ_UINT16_BE (data + 2);
+  pos = 4;
+
+  if (tile_list->tile_count_minus_1 >= GST_AV1_MAX_TILE_COUNT) {
+    GST_WARNING ("Invalid tile_count_minus_1 %d",
+        tile_list->tile_count_minus_1);
+    retval = GST_AV1_PARSER_BITSTREAM_ERROR;
+    goto error;
+  }
+
   for (tile = 0; tile <= tile_list->tile_count_minus_1; tile++) {
-    if (AV1_REMAINING_BITS (br) < 8 + 8 + 8 + 16) {
+    guint32 tile_data_size;
+
+    if (size - pos < 5) {
       retval = GST_AV1_PARSER_NO_MORE_DATA;
       goto error;
     }
-    tile_list->entry[tile].anchor_frame_idx = AV1_READ_BITS (br, 8);
-    tile_list->entry[tile].anchor_tile_row = AV1_READ_BITS (br, 8);
-    tile_list->entry[tile].anchor_tile_col = AV1_READ_BITS (br, 8);
-    tile_list->entry[tile].tile_data_size_minus_1 = AV1_READ_BITS (br, 16);
-
-    g_assert (gst_bit_reader_get_pos (br) % 8 == 0);
-
-    tile_list->entry[tile].coded_tile_data =
-        obu->data + gst_bit_reader_get_pos (br) / 8;
-    /* skip the coded_tile_data */
-    if (!gst_bit_reader_skip (br,
-            tile_list->entry[tile].tile_data_size_minus_1 + 1)) {
+    tile_list->entry[tile].anchor_frame_idx = data[pos];
+    tile_list->entry[tile].anchor_tile_row = data[pos + 1];
+    tile_list->entry[tile].anchor_tile_col = data[pos + 2];
+    tile_list->entry[tile].tile_data_size_minus_1 =
+        GST_READ_UINT16_BE (data + pos + 3);
+    pos += 5;
+
+    tile_data_size = tile_list->entry[tile].tile_data_size_minus_1 + 1;
+    if (size - pos < tile_data_size) {
       retval = GST_AV1_PARSER_NO_MORE_DATA;
       goto error;
     }
+
+    tile_list->entry[tile].coded_tile_data = (guint8 *) data + pos;
+    /* skip the coded_tile_data */
+    pos += tile_data_size;
   }
 
-  retval = av1_skip_trailing_bits (parser, br, obu);
+  /* A tile list has no trailing bits (5.3.1), the last coded tile data runs
+   * to the end of the OBU, but go through the common check like every
+   * other OBU does */
+  gst_bit_reader_init (&bitreader, data, size);
+  gst_bit_reader_set_pos (&bitreader, pos * 8);
+  retval = av1_skip_trailing_bits (parser, &bitreader, obu);
   if (retval != GST_AV1_PARSER_OK)
     goto error;
 
@@ -4389,18 +4410,25 @@ gst_av1_parse_tile_group (GstAV1Parser * parser, GstBitReader * br,
     GstAV1TileGroupOBU * tile_group)
 {
   GstAV1ParserResult retval = GST_AV1_PARSER_OK;
-  gint tile_num /* TileNum */ , end_bit_pos /* endBitPos */ ;
-  gint header_bytes /* headerBytes */ , start_bitpos /* startBitPos */ ;
-  guint32 sz = AV1_REMAINING_BYTES (br);
+  gint tile_num /* TileNum */ ;
   guint32 tile_row /* tileRow */ ;
   guint32 tile_col /* tileCol */ ;
   guint32 tile_size /* tileSize */ ;
+  guint8 tile_size_bytes = parser->state.tile_size_bytes;
+  const guint8 *data;
+  guint32 pos, end, i;
 
-  memset (tile_group, 0, sizeof (*tile_group));
+  /* Only the entries from tg_start to tg_end are written */
+  memset (tile_group, 0, G_STRUCT_OFFSET (GstAV1TileGroupOBU, entry));
   tile_group->num_tiles = parser->state.tile_cols * parser->state.tile_rows;
-  start_bitpos = gst_bit_reader_get_pos (br);
   tile_group->tile_start_and_end_present_flag = 0;
 
+  if (tile_group->num_tiles == 0 ||
+      tile_group->num_tiles > GST_AV1_MAX_TILE_COUNT) {
+    retval = GST_AV1_PARSER_BITSTREAM_ERROR;
+    goto error;
+  }
+
   if (tile_group->num_tiles > 1) {
     tile_group->tile_start_and_end_present_flag =
         AV1_READ_BIT_CHECKED (br, &retval);
@@ -4427,33 +4455,51 @@ gst_av1_parse_tile_group (GstAV1Parser * parser, GstBitReader * br,
     goto error;
   }
 
+  if (tile_group->tg_end >= tile_group->num_tiles) {
+    retval = GST_AV1_PARSER_BITSTREAM_ERROR;
+    goto error;
+  }
+
   if (!gst_bit_reader_skip_to_byte (br)) {
     retval = GST_AV1_PARSER_NO_MORE_DATA;
     goto error;
   }
 
-  end_bit_pos = gst_bit_reader_get_pos (br);
-  header_bytes = (end_bit_pos - start_bitpos) / 8;
-  sz -= header_bytes;
+  /* The tile sizes are byte aligned, so walk them directly on the data
+   * instead of going through the bit reader for each tile */
+  data = br->data;
+  pos = gst_bit_reader_get_pos (br) / 8;
+  end = br->size;
+  tile_row = tile_group->tg_start / parser->state.tile_cols;
+  tile_col = tile_group->tg_start % parser->state.tile_cols;
 
   for (tile_num = tile_group->tg_start; tile_num <= tile_group->tg_end;
       tile_num++) {
-    tile_row = tile_num / parser->state.tile_cols;
-    tile_col = tile_num % parser->state.tile_cols;
     /* if last tile */
     if (tile_num == tile_group->tg_end) {
-      tile_size = sz;
+      tile_size = end - pos;
     } else {
-      gint tile_size_minus_1 = av1_bitstreamfn_le (br,
-          parser->state.tile_size_bytes, &retval);
-      if (retval != GST_AV1_PARSER_OK)
+      if (end - pos < tile_size_bytes) {
+        retval = GST_AV1_PARSER_NO_MORE_DATA;
         goto error;
-      tile_size = tile_size_minus_1 + 1;
-      sz -= (tile_size + parser->state.tile_size_bytes);
+      }
+
+      /* le(TileSizeBytes) */
+      tile_size = 0;
+      for (i = 0; i < tile_size_bytes; i++)
+        tile_size |= ((guint32) data[pos + i]) << (i * 8);
+      tile_size += 1;
+      pos += tile_size_bytes;
+
+      /* Skip the real data to the next one */
+      if (end - pos < tile_size) {
+        retval = GST_AV1_PARSER_NO_MORE_DATA;
+        goto error;
+      }
     }
 
     tile_group->entry[tile_num].tile_size = tile_size;
-    tile_group->entry[tile_num].tile_offset = gst_bit_reader_get_pos (br) / 8;
+    tile_group->entry[tile_num].tile_offset = pos;
     tile_group->entry[tile_num].tile_row = tile_row;
     tile_group->entry[tile_num].tile_col = tile_col;
 
@@ -4471,14 +4517,18 @@ gst_av1_parse_tile_group (GstAV1Parser * parser, GstBitReader * br,
        exit_symbol( )
      */
 
-    /* Skip the real data to the next one */
-    if (tile_num < tile_group->tg_end &&
-        !gst_bit_reader_skip (br, tile_size * 8)) {
-      retval = GST_AV1_PARSER_NO_MORE_DATA;
-      goto error;
+    if (tile_num < tile_group->tg_end)
+      pos += tile_size;
+
+    if (++tile_col == parser->state.tile_cols) {
+      tile_col = 0;
+      tile_row++;
     }
   }
 
+  /* Leave the reader at the start of the last tile, like a bitwise walk */
+  gst_bit_reader_set_pos (br, pos * 8);
+
   if (tile_group->tg_end == tile_group->num_tiles - 1) {
     /* Not implement here, the real decoder process
        if ( !disable_frame_end_update_cdf ) {
@@ -1653,6 +1653,8 @@ struct _GstAV1ReferenceFrameInfo {
  *   units. It is a requirement of bitstream conformance that @anchor_tile_col is less than @tile_cols.
  * @tile_data_size_minus_1: plus one is the size of the coded tile data, @coded_tile_data, in bytes.
  * @coded_tile_data: are the @tile_data_size_minus_1 + 1 bytes of the coded tile.
+ *
+ * Only the first @tile_count_minus_1 + 1 entries are filled by the parser.
  */
 struct _GstAV1TileListOBU {
   guint8 output_frame_width_in_tiles_minus_1;
@@ -1691,6 +1693,8 @@ struct _GstAV1TileListOBU {
  * @mi_col_start: start position in mi cols
  * @mi_col_end: end position in mi cols
  * @num_tiles: specifies the total number of tiles in the frame.
+ *
+ * Only the entries from @tg_start to @tg_end are filled by the parser.
  */
 struct _GstAV1TileGroupOBU {
   gboolean tile_start_and_end_present_flag;
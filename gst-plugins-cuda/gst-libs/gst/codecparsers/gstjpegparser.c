@@ -250,23 +250,34 @@ jpeg_parse_to_next_marker (GstByteReader * br, GstJpegMarker * marker)
  * code. If found, the function returns an offset to the marker code,
  * including the 0xff prefix code but excluding any extra fill bytes.
  *
+ * The 0xff prefixes are located with memchr(), which the C library
+ * implements with vector instructions. In entropy coded data they only
+ * show up about once every 256 bytes, so most of the scan runs there.
+ *
  * Returns: offset to the marker code if found, or -1 if not found.
  */
 static gint
 gst_jpeg_scan_for_marker_code (const guint8 * data, gsize size, guint offset)
 {
-  guint i;
+  const guint8 *p = data + offset;
+  const guint8 *const end = data + size;
+
+  if (size < 2 || offset >= size - 1)
+    return -1;
+
+  while (p < end - 1) {
+    p = memchr (p, 0xff, end - 1 - p);
+    if (!p)
+      return -1;
 
-  i = offset + 1;
-  while (i < size) {
-    const guint8 v = data[i];
-    if (v < 0xc0)
-      i += 2;
-    else if (v < 0xff && data[i - 1] == 0xff)
-      return i - 1;
-    else
-      i++;
+    /* 0xff00 is a stuffed byte, 0xffff a fill byte in front of the
+     * actual prefix */
+    if (p[1] >= 0xc0 && p[1] < 0xff)
+      return p - data;
+
+    p++;
   }
+
   return -1;
 }
 
@@ -761,3 +772,119 @@ gst_jpeg_parse (GstJpegSegment * segment,
 failed:
   return FALSE;
 }
+
+/**
+ * gst_jpeg_segment_index_init:
+ * @index: a #GstJpegSegmentIndex
+ *
+ * Initializes @index, which can then be filled repeatedly by
+ * gst_jpeg_parse_all_segments(). Release it with
+ * gst_jpeg_segment_index_clear().
+ */
+void
+gst_jpeg_segment_index_init (GstJpegSegmentIndex * index)
+{
+  g_return_if_fail (index != NULL);
+
+  index->segments = g_array_new (FALSE, FALSE, sizeof (GstJpegSegment));
+  index->restarts = g_array_new (FALSE, FALSE, sizeof (guint));
+  index->sof = -1;
+  index->sos = -1;
+  index->eoi = -1;
+}
+
+/**
+ * gst_jpeg_segment_index_clear:
+ * @index: a #GstJpegSegmentIndex
+ *
+ * Frees the resources allocated by gst_jpeg_segment_index_init().
+ */
+void
+gst_jpeg_segment_index_clear (GstJpegSegmentIndex * index)
+{
+  g_return_if_fail (index != NULL);
+
+  g_clear_pointer (&index->segments, g_array_unref);
+  g_clear_pointer (&index->restarts, g_array_unref);
+}
+
+/**
+ * gst_jpeg_parse_all_segments:
+ * @index: an initialized #GstJpegSegmentIndex to fill in
+ * @data: The data to parse
+ * @size: The size of @data
+ * @offset: The offset from which to start parsing
+ *
+ * Parses all the segments of the JPEG image contained in @data in a single
+ * pass, up to and including the EOI marker. Restart markers are not added to
+ * @index->segments, the offset of the entropy coded data following each of
+ * them is added to @index->restarts instead, so that the restart intervals
+ * of a scan can be located without scanning the data again.
+ *
+ * The previous content of @index is replaced.
+ *
+ * Returns: TRUE if a frame header and at least one scan were found and no
+ *   segment exceeds the available data.
+ */
+gboolean
+gst_jpeg_parse_all_segments (GstJpegSegmentIndex * index,
+    const guint8 * data, gsize size, guint offset)
+{
+  GstJpegSegment seg;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+  g_return_val_if_fail (index->segments != NULL, FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  g_array_set_size (index->segments, 0);
+  g_array_set_size (index->restarts, 0);
+  index->sof = -1;
+  index->sos = -1;
+  index->eoi = -1;
+
+  while (gst_jpeg_parse (&seg, data, size, offset)) {
+    if (seg.marker >= GST_JPEG_MARKER_RST_MIN &&
+        seg.marker <= GST_JPEG_MARKER_RST_MAX) {
+      g_array_append_val (index->restarts, seg.offset);
+      offset = seg.offset;
+      continue;
+    }
+
+    if (seg.size < 0 || seg.offset + seg.size > size) {
+      GST_DEBUG ("segment 0x%02x at offset %u exceeds the data", seg.marker,
+          seg.offset);
+      return FALSE;
+    }
+
+    switch (seg.marker) {
+      case GST_JPEG_MARKER_SOF0:
+      case GST_JPEG_MARKER_SOF1:
+      case GST_JPEG_MARKER_SOF2:
+      case GST_JPEG_MARKER_SOF3:
+      case GST_JPEG_MARKER_SOF9:
+      case GST_JPEG_MARKER_SOF10:
+      case GST_JPEG_MARKER_SOF11:
+        if (index->sof < 0)
+          index->sof = index->segments->len;
+        break;
+      case GST_JPEG_MARKER_SOS:
+        if (index->sos < 0)
+          index->sos = index->segments->len;
+        break;
+      case GST_JPEG_MARKER_EOI:
+        index->eoi = index->segments->len;
+        break;
+      default:
+        break;
+    }
+
+    g_array_append_val (index->segments, seg);
+
+    if (seg.marker == GST_JPEG_MARKER_EOI)
+      break;
+
+    offset = seg.offset + seg.size;
+  }
+
+  return index->sof >= 0 && index->sos >= 0;
+}
@@ -67,6 +67,7 @@ typedef struct _GstJpegScanHdr          GstJpegScanHdr;
 typedef struct _GstJpegFrameComponent   GstJpegFrameComponent;
 typedef struct _GstJpegFrameHdr         GstJpegFrameHdr;
 typedef struct _GstJpegSegment          GstJpegSegment;
+typedef struct _GstJpegSegmentIndex     GstJpegSegmentIndex;
 
 /**
  * GstJpegMarker:
@@ -375,12 +376,48 @@ struct _GstJpegSegment
   gssize size;
 };
 
+/**
+ * GstJpegSegmentIndex:
+ * @segments: (element-type GstJpegSegment): the segments of the image in
+ *   bitstream order, restart markers excluded
+ * @restarts: (element-type guint): the offsets of the entropy coded data
+ *   following each restart marker, in bitstream order
+ * @sof: index of the first frame header in @segments, or -1
+ * @sos: index of the first scan header in @segments, or -1. The entropy
+ *   coded data of a scan starts right after its header
+ * @eoi: index of the EOI marker in @segments, or -1 if the image is
+ *   truncated
+ *
+ * All the segments of a JPEG image, as found by
+ * gst_jpeg_parse_all_segments().
+ */
+struct _GstJpegSegmentIndex
+{
+  GArray *segments;
+  GArray *restarts;
+  gint sof;
+  gint sos;
+  gint eoi;
+};
+
 GST_CODEC_PARSERS_API
 gboolean  gst_jpeg_parse (GstJpegSegment * seg,
                           const guint8   * data,
                           gsize            size,
                           guint            offset);
 
+GST_CODEC_PARSERS_API
+void      gst_jpeg_segment_index_init  (GstJpegSegmentIndex * index);
+
+GST_CODEC_PARSERS_API
+void      gst_jpeg_segment_index_clear (GstJpegSegmentIndex * index);
+
+GST_CODEC_PARSERS_API
+gboolean  gst_jpeg_parse_all_segments  (GstJpegSegmentIndex * index,
+                                        const guint8        * data,
+                                        gsize                 size,
+                                        guint                 offset);
+
 GST_CODEC_PARSERS_API
 gboolean  gst_jpeg_segment_parse_frame_header  (const GstJpegSegment  * segment,
                                                 GstJpegFrameHdr       * frame_hdr);
@@ -12,54 +12,55 @@
 #endif
 
 #include "gstvp8rangedecoder.h"
-#include "dboolhuff.h"
+#include "gstvpxbooldecoder.h"
 
 #define BOOL_DECODER_CAST(rd) \
-  ((BOOL_DECODER *)(&(rd)->_gst_reserved[0]))
+  ((GstVpxBoolDecoder *)(&(rd)->_gst_reserved[0]))
 
 gboolean
 gst_vp8_range_decoder_init (GstVp8RangeDecoder * rd, const guchar * buf,
     guint buf_size)
 {
-  BOOL_DECODER *const bd = BOOL_DECODER_CAST (rd);
+  GstVpxBoolDecoder *const bd = BOOL_DECODER_CAST (rd);
 
   g_return_val_if_fail (sizeof (rd->_gst_reserved) >= sizeof (*bd), FALSE);
 
   rd->buf = buf;
   rd->buf_size = buf_size;
-  return vp8dx_start_decode (bd, buf, buf_size, NULL, NULL) == 0;
+  return gst_vpx_bool_decoder_init (bd, buf, buf_size);
 }
 
 gint
 gst_vp8_range_decoder_read (GstVp8RangeDecoder * rd, guint8 prob)
 {
-  return vp8dx_decode_bool (BOOL_DECODER_CAST (rd), prob);
+  return gst_vpx_bool_decoder_read (BOOL_DECODER_CAST (rd), prob);
 }
 
 gint
 gst_vp8_range_decoder_read_literal (GstVp8RangeDecoder * rd, gint bits)
 {
-  return vp8_decode_value (BOOL_DECODER_CAST (rd), bits);
+  return gst_vpx_bool_decoder_read_literal (BOOL_DECODER_CAST (rd), bits);
 }
 
 guint
 gst_vp8_range_decoder_get_pos (GstVp8RangeDecoder * rd)
 {
-  BOOL_DECODER *const bd = BOOL_DECODER_CAST (rd);
+  GstVpxBoolDecoder *const bd = BOOL_DECODER_CAST (rd);
 
-  return (bd->user_buffer - rd->buf) * 8 - (8 + bd->count);
+  return (bd->buffer - rd->buf) * 8 - (8 + bd->count);
 }
 
 void
 gst_vp8_range_decoder_get_state (GstVp8RangeDecoder * rd,
     GstVp8RangeDecoderState * state)
 {
-  BOOL_DECODER *const bd = BOOL_DECODER_CAST (rd);
+  GstVpxBoolDecoder *const bd = BOOL_DECODER_CAST (rd);
 
   if (bd->count < 0)
-    vp8dx_bool_decoder_fill (bd);
+    gst_vpx_bool_decoder_fill (bd);
 
   state->range = bd->range;
-  state->value = (guint8) ((bd->value) >> (VP8_BD_VALUE_SIZE - 8));
+  state->value =
+      (guint8) ((bd->value) >> (GST_VPX_BOOL_DECODER_VALUE_SIZE - 8));
   state->count = (8 + bd->count) % 8;
 }
@@ -0,0 +1,108 @@
+/*
+ * gstvpxbooldecoder.c - VP8/VP9 boolean (range) decoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The refill strategy follows the libvpx boolean decoder, see
+ * dboolhuff.LICENSE, dboolhuff.PATENTS and dboolhuff.AUTHORS */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include "gstvpxbooldecoder.h"
+
+/**
+ * gst_vpx_bool_decoder_init:
+ * @bd: a #GstVpxBoolDecoder
+ * @data: the data to decode
+ * @size: the size of @data in bytes
+ *
+ * Initializes @bd to decode @size bytes of @data.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+gst_vpx_bool_decoder_init (GstVpxBoolDecoder * bd, const guint8 * data,
+    gsize size)
+{
+  g_return_val_if_fail (bd != NULL, FALSE);
+
+  bd->buffer = data;
+  bd->buffer_end = data + size;
+  bd->value = 0;
+  bd->count = -8;
+  bd->range = 255;
+
+  if (size && !data)
+    return FALSE;
+
+  gst_vpx_bool_decoder_fill (bd);
+
+  return TRUE;
+}
+
+/**
+ * gst_vpx_bool_decoder_fill:
+ * @bd: a #GstVpxBoolDecoder
+ *
+ * Loads as many whole bytes as fit into the decoding window. Called by
+ * gst_vpx_bool_decoder_read() once the window runs low.
+ */
+void
+gst_vpx_bool_decoder_fill (GstVpxBoolDecoder * bd)
+{
+  const guint8 *buffer = bd->buffer;
+  guint64 value = bd->value;
+  gint count = bd->count;
+  gsize bits_left = (bd->buffer_end - buffer) * 8;
+  gint shift = GST_VPX_BOOL_DECODER_VALUE_SIZE - 8 - (count + 8);
+
+  if (bits_left > GST_VPX_BOOL_DECODER_VALUE_SIZE) {
+    /* At least 9 bytes left, load all the bytes fitting into the window
+     * with a single big endian read */
+    const gint bits = (shift & ~7) + 8;
+    guint64 next = GST_READ_UINT64_BE (buffer);
+
+    next >>= GST_VPX_BOOL_DECODER_VALUE_SIZE - bits;
+    value |= next << (shift & 7);
+    count += bits;
+    buffer += bits >> 3;
+  } else {
+    gint bits_over = shift + 8 - (gint) bits_left;
+    gint loop_end = 0;
+
+    if (bits_over >= 0) {
+      count += GST_VPX_BOOL_DECODER_LOTS_OF_BITS;
+      loop_end = bits_over;
+    }
+
+    if (bits_over < 0 || bits_left) {
+      while (shift >= loop_end) {
+        count += 8;
+        value |= ((guint64) * buffer) << shift;
+        buffer++;
+        shift -= 8;
+      }
+    }
+  }
+
+  bd->buffer = buffer;
+  bd->value = value;
+  bd->count = count;
+}
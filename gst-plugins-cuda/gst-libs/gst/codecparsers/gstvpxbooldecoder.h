@@ -0,0 +1,175 @@
+/*
+ * gstvpxbooldecoder.h - VP8/VP9 boolean (range) decoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_VPX_BOOL_DECODER_H
+#define GST_VPX_BOOL_DECODER_H
+
+#include <glib.h>
+#include <gst/gstconfig.h>
+#include <gst/codecparsers/codecparsers-prelude.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* Number of bits in the decoding window */
+#define GST_VPX_BOOL_DECODER_VALUE_SIZE 64
+
+/* Added to the bit count once the end of the buffer was reached, so that the
+ * decoder keeps returning zero bits without refilling. Reading past it is
+ * reported by gst_vpx_bool_decoder_has_error() */
+#define GST_VPX_BOOL_DECODER_LOTS_OF_BITS 0x40000000
+
+typedef struct _GstVpxBoolDecoder GstVpxBoolDecoder;
+
+/**
+ * GstVpxBoolDecoder:
+ *
+ * Boolean entropy decoder shared by the VP8 and VP9 parsers.
+ *
+ * The not yet decoded bits are kept MSB aligned in a 64-bit window which is
+ * refilled with up to 7 bytes at once, so that several booleans are decoded
+ * per refill. Renormalization uses a count-leading-zeros instruction instead
+ * of a lookup table.
+ */
+struct _GstVpxBoolDecoder
+{
+  /*< private >*/
+  const guint8 *buffer;
+  const guint8 *buffer_end;
+  guint64 value;
+  /* Number of bits in value, minus 8 */
+  gint count;
+  guint range;
+};
+
+GST_CODEC_PARSERS_API
+gboolean gst_vpx_bool_decoder_init (GstVpxBoolDecoder * bd,
+                                    const guint8 * data,
+                                    gsize size);
+
+GST_CODEC_PARSERS_API
+void     gst_vpx_bool_decoder_fill (GstVpxBoolDecoder * bd);
+
+static inline guint
+gst_vpx_bool_decoder_norm (guint range)
+{
+  /* range is in [1, 255], shift it back to [128, 255] */
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clz (range) - 24;
+#elif defined(_MSC_VER)
+  unsigned long msb;
+
+  _BitScanReverse (&msb, range);
+  return 7 - msb;
+#else
+  guint shift = 0;
+
+  while (range < 128) {
+    range <<= 1;
+    shift++;
+  }
+
+  return shift;
+#endif
+}
+
+/**
+ * gst_vpx_bool_decoder_read:
+ * @bd: a #GstVpxBoolDecoder
+ * @prob: the probability of the boolean being zero, in 1/256 units
+ *
+ * Returns: the decoded boolean
+ */
+static inline gboolean
+gst_vpx_bool_decoder_read (GstVpxBoolDecoder * bd, guint8 prob)
+{
+  guint split = 1 + (((bd->range - 1) * prob) >> 8);
+  guint64 big_split;
+  guint64 value;
+  guint range;
+  guint shift;
+  gboolean bit;
+
+  if (bd->count < 0)
+    gst_vpx_bool_decoder_fill (bd);
+
+  value = bd->value;
+  big_split = (guint64) split << (GST_VPX_BOOL_DECODER_VALUE_SIZE - 8);
+
+  if (value >= big_split) {
+    range = bd->range - split;
+    value -= big_split;
+    bit = TRUE;
+  } else {
+    range = split;
+    bit = FALSE;
+  }
+
+  /* Most booleans are coded with a skewed probability and leave the range
+   * normalized, skip the variable shifts for them */
+  if (range < 128) {
+    shift = gst_vpx_bool_decoder_norm (range);
+    range <<= shift;
+    value <<= shift;
+    bd->count -= shift;
+  }
+
+  bd->range = range;
+  bd->value = value;
+
+  return bit;
+}
+
+/**
+ * gst_vpx_bool_decoder_read_literal:
+ * @bd: a #GstVpxBoolDecoder
+ * @bits: the number of bits to read, at most 32
+ *
+ * Returns: the @bits bits unsigned value, most significant bit first
+ */
+static inline guint
+gst_vpx_bool_decoder_read_literal (GstVpxBoolDecoder * bd, guint bits)
+{
+  guint value = 0;
+
+  while (bits--)
+    value = (value << 1) | gst_vpx_bool_decoder_read (bd, 128);
+
+  return value;
+}
+
+/**
+ * gst_vpx_bool_decoder_has_error:
+ * @bd: a #GstVpxBoolDecoder
+ *
+ * Returns: %TRUE if more bits than available in the buffer were decoded
+ */
+static inline gboolean
+gst_vpx_bool_decoder_has_error (const GstVpxBoolDecoder * bd)
+{
+  return bd->count > GST_VPX_BOOL_DECODER_VALUE_SIZE &&
+      bd->count < GST_VPX_BOOL_DECODER_LOTS_OF_BITS;
+}
+
+G_END_DECLS
+
+#endif /* GST_VPX_BOOL_DECODER_H */
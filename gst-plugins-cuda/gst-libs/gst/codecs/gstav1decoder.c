@@ -29,6 +29,8 @@
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include "gstav1decoder.h"
 
 GST_DEBUG_CATEGORY (gst_av1_decoder_debug);
@@ -43,6 +45,13 @@ struct _GstAV1DecoderPrivate
   GstAV1Dpb *dpb;
   GstAV1Picture *current_picture;
   GstVideoCodecFrame *current_frame;
+
+  /* Tiles of the current frame, for decode_frame_tiles() */
+  GstAV1TileEntry tiles[GST_AV1_MAX_TILE_COUNT];
+  guint num_tiles_collected;
+
+  /* Reused for decode_tile(), too large for the stack */
+  GstAV1Tile tile;
 };
 
 #define parent_class gst_av1_decoder_parent_class
@@ -311,8 +320,9 @@ gst_av1_decoder_decode_tile_group (GstAV1Decoder * self,
   GstAV1DecoderPrivate *priv = self->priv;
   GstAV1DecoderClass *klass = GST_AV1_DECODER_GET_CLASS (self);
   GstAV1Picture *picture = priv->current_picture;
-  GstAV1Tile tile;
+  GstAV1Tile *tile = &priv->tile;
   GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
 
   if (!picture) {
     GST_ERROR_OBJECT (self, "No picture has created for current frame");
@@ -324,11 +334,52 @@ gst_av1_decoder_decode_tile_group (GstAV1Decoder * self,
     return GST_FLOW_ERROR;
   }
 
-  tile.obu = *obu;
-  tile.tile_group = *tile_group;
+  if (klass->decode_frame_tiles) {
+    for (i = tile_group->tg_start; i <= tile_group->tg_end; i++) {
+      GstAV1TileEntry *entry = &priv->tiles[i];
+
+      entry->data = obu->data + tile_group->entry[i].tile_offset;
+      entry->size = tile_group->entry[i].tile_size;
+      entry->tile_row = tile_group->entry[i].tile_row;
+      entry->tile_col = tile_group->entry[i].tile_col;
+    }
+
+    priv->num_tiles_collected += tile_group->tg_end - tile_group->tg_start + 1;
+
+    /* Not the last tile group of this frame yet */
+    if (tile_group->tg_end != tile_group->num_tiles - 1)
+      return GST_FLOW_OK;
+
+    if (priv->num_tiles_collected != tile_group->num_tiles) {
+      GST_WARNING_OBJECT (self, "Got %u tiles out of %u",
+          priv->num_tiles_collected, tile_group->num_tiles);
+      return GST_FLOW_ERROR;
+    }
+
+    ret = klass->decode_frame_tiles (self, picture, priv->tiles,
+        tile_group->num_tiles);
+    if (ret != GST_FLOW_OK) {
+      GST_WARNING_OBJECT (self, "Decode frame tiles error");
+      return ret;
+    }
+
+    return GST_FLOW_OK;
+  }
+
+  /* Only the entries of this tile group are valid */
+  tile->obu = *obu;
+  tile->tile_group.tile_start_and_end_present_flag =
+      tile_group->tile_start_and_end_present_flag;
+  tile->tile_group.tg_start = tile_group->tg_start;
+  tile->tile_group.tg_end = tile_group->tg_end;
+  tile->tile_group.num_tiles = tile_group->num_tiles;
+  memcpy (&tile->tile_group.entry[tile_group->tg_start],
+      &tile_group->entry[tile_group->tg_start],
+      (tile_group->tg_end - tile_group->tg_start + 1) *
+      sizeof (tile_group->entry[0]));
 
   g_assert (klass->decode_tile);
-  ret = klass->decode_tile (self, picture, &tile);
+  ret = klass->decode_tile (self, picture, tile);
   if (ret != GST_FLOW_OK) {
     GST_WARNING_OBJECT (self, "Decode tile error");
     return ret;
@@ -353,6 +404,8 @@ gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
     return GST_FLOW_ERROR;
   }
 
+  priv->num_tiles_collected = 0;
+
   if (frame_header->show_existing_frame) {
     GstAV1Picture *ref_picture;
 
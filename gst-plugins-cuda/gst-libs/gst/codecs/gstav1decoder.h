@@ -132,6 +132,22 @@ struct _GstAV1DecoderClass
   GstFlowReturn   (*decode_tile)       (GstAV1Decoder * decoder,
                                         GstAV1Picture * picture,
                                         GstAV1Tile * tile);
+  /**
+   * GstAV1DecoderClass::decode_frame_tiles:
+   * @decoder: a #GstAV1Decoder
+   * @picture: (transfer none): a #GstAV1Picture
+   * @tiles: (array length=num_tiles): the tiles of the frame, indexed by
+   *   tile number
+   * @num_tiles: the number of tiles in the frame
+   *
+   * Optional. If implemented, called once per frame with all the tiles of
+   * the frame once its last tile group was parsed, instead of calling
+   * #GstAV1DecoderClass::decode_tile for each tile group.
+   */
+  GstFlowReturn   (*decode_frame_tiles) (GstAV1Decoder * decoder,
+                                         GstAV1Picture * picture,
+                                         const GstAV1TileEntry * tiles,
+                                         guint num_tiles);
   /**
    * GstAV1DecoderClass::end_picture:
    * @decoder: a #GstAV1Decoder
@@ -160,7 +176,7 @@ struct _GstAV1DecoderClass
                                         GstAV1Picture * picture);
 
   /*< private >*/
-  gpointer padding[GST_PADDING_LARGE];
+  gpointer padding[GST_PADDING_LARGE - 1];
 };
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstAV1Decoder, gst_object_unref)
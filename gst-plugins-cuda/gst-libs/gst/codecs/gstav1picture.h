@@ -46,6 +46,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstAV1Picture GstAV1Picture;
 typedef struct _GstAV1Tile GstAV1Tile;
+typedef struct _GstAV1TileEntry GstAV1TileEntry;
 
 /**
  * GstAV1Tile:
@@ -59,6 +60,24 @@ struct _GstAV1Tile
   GstAV1OBU obu;
 };
 
+/**
+ * GstAV1TileEntry:
+ * @data: the coded tile data, points into the input buffer (no ownership)
+ * @size: the size of @data in bytes
+ * @tile_row: the tile row
+ * @tile_col: the tile column
+ *
+ * One entry of the per frame tile index passed to
+ * #GstAV1DecoderClass::decode_frame_tiles.
+ */
+struct _GstAV1TileEntry
+{
+  const guint8 *data;
+  guint32 size;
+  guint16 tile_row;
+  guint16 tile_col;
+};
+
 /**
  * GstAV1Picture:
  *
@@ -0,0 +1,380 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstcodecpreparser
+ * @title: GstCodecPreparser
+ * @short_description: Splits input frames into parsing units on a worker
+ *   thread
+ *
+ * #GstCodecPreparser moves the stateless part of the bitstream parsing
+ * (e.g. start code scanning and NAL unit identification) off the streaming
+ * thread, so that the bitstream of frame N+1 is parsed while frame N is being
+ * decoded and submitted to the hardware.
+ *
+ * Frames go through a bounded ring of preallocated jobs. The streaming thread
+ * is the only producer (gst_codec_preparser_push()) and the only consumer
+ * (gst_codec_preparser_pop() / gst_codec_preparser_release()), and the worker
+ * thread only advances the "parsed" index in between. Each index is written
+ * by a single thread, so the ring itself does not need any lock. The mutex is
+ * only taken by a thread about to sleep, and by the other side when it sees
+ * that thread sleeping.
+ *
+ * Jobs are popped in push order, so the decoding order is unchanged.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include "gstcodecpreparser.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_codec_preparser_debug);
+#define GST_CAT_DEFAULT gst_codec_preparser_debug
+
+typedef struct
+{
+  GstCodecPreparserJob job;
+
+  /* Holds a ref so that the consumer can steal the frame at any time */
+  GstBuffer *buffer;
+} GstCodecPreparserSlot;
+
+struct _GstCodecPreparser
+{
+  GstCodecPreparserSlot *slots;
+  guint depth;
+  guint mask;
+
+  /* Free running ring indices, each written by a single thread.
+   * head: next slot to be pushed, written by the streaming thread
+   * parsed: next slot to be parsed, written by the worker thread
+   * tail: next slot to be popped, written by the streaming thread */
+  gint head;
+  gint parsed;
+  gint tail;
+
+  GstCodecPreparserFunc func;
+  gpointer user_data;
+
+  /* Only used for sleeping */
+  GMutex lock;
+  GCond worker_cond;
+  GCond consumer_cond;
+  gint worker_waiting;
+  gint consumer_waiting;
+  gint stopping;
+
+  GThread *thread;
+};
+
+static inline void
+gst_codec_preparser_wake (GstCodecPreparser * self, gint * waiting,
+    GCond * cond)
+{
+  /* The waiting thread sets the flag and re-checks the index with the lock
+   * held, so taking the lock here cannot miss it */
+  if (g_atomic_int_get (waiting)) {
+    g_mutex_lock (&self->lock);
+    g_cond_signal (cond);
+    g_mutex_unlock (&self->lock);
+  }
+}
+
+static gpointer
+gst_codec_preparser_thread_func (GstCodecPreparser * self)
+{
+  while (TRUE) {
+    guint parsed = (guint) g_atomic_int_get (&self->parsed);
+    GstCodecPreparserJob *job;
+
+    if (parsed == (guint) g_atomic_int_get (&self->head)) {
+      g_mutex_lock (&self->lock);
+      g_atomic_int_set (&self->worker_waiting, 1);
+      while (!g_atomic_int_get (&self->stopping) &&
+          parsed == (guint) g_atomic_int_get (&self->head)) {
+        g_cond_wait (&self->worker_cond, &self->lock);
+      }
+      g_atomic_int_set (&self->worker_waiting, 0);
+      g_mutex_unlock (&self->lock);
+
+      if (g_atomic_int_get (&self->stopping))
+        break;
+
+      continue;
+    }
+
+    job = &self->slots[parsed & self->mask].job;
+    g_array_set_size (job->units, 0);
+    if (job->map.size > 0)
+      self->func (job, self->user_data);
+
+    g_atomic_int_set (&self->parsed, parsed + 1);
+    gst_codec_preparser_wake (self,
+        &self->consumer_waiting, &self->consumer_cond);
+  }
+
+  return NULL;
+}
+
+/**
+ * gst_codec_preparser_new:
+ * @name: the name of the worker thread
+ * @depth: the number of jobs in the ring, must be a power of two
+ * @unit_size: the element size of #GstCodecPreparserJob.units
+ * @func: (scope notified): a #GstCodecPreparserFunc
+ * @user_data: user data passed to @func
+ *
+ * Creates a new #GstCodecPreparser and starts its worker thread.
+ *
+ * Returns: (transfer full) (nullable): a new #GstCodecPreparser or %NULL
+ *   if the worker thread could not be started
+ */
+GstCodecPreparser *
+gst_codec_preparser_new (const gchar * name, guint depth, guint unit_size,
+    GstCodecPreparserFunc func, gpointer user_data)
+{
+  GstCodecPreparser *self;
+  GError *err = NULL;
+  guint i;
+
+  g_return_val_if_fail (depth > 0 && (depth & (depth - 1)) == 0, NULL);
+  g_return_val_if_fail (unit_size > 0, NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_codec_preparser_debug, "codecpreparser", 0,
+      "Codec bitstream pre-parser");
+
+  self = g_new0 (GstCodecPreparser, 1);
+  self->slots = g_new0 (GstCodecPreparserSlot, depth);
+  self->depth = depth;
+  self->mask = depth - 1;
+  self->func = func;
+  self->user_data = user_data;
+
+  for (i = 0; i < depth; i++)
+    self->slots[i].job.units = g_array_sized_new (FALSE, FALSE, unit_size, 16);
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->worker_cond);
+  g_cond_init (&self->consumer_cond);
+
+  self->thread = g_thread_try_new (name,
+      (GThreadFunc) gst_codec_preparser_thread_func, self, &err);
+  if (!self->thread) {
+    GST_ERROR ("Couldn't start pre-parsing thread, %s",
+        err ? err->message : "unknown error");
+    g_clear_error (&err);
+    gst_codec_preparser_free (self);
+    return NULL;
+  }
+
+  return self;
+}
+
+static void
+gst_codec_preparser_clear_job (GstCodecPreparserSlot * slot)
+{
+  GstCodecPreparserJob *job = &slot->job;
+
+  if (job->mapped)
+    gst_buffer_unmap (slot->buffer, &job->map);
+  job->mapped = FALSE;
+  memset (&job->map, 0, sizeof (GstMapInfo));
+
+  gst_clear_buffer (&slot->buffer);
+  g_clear_pointer (&job->frame, gst_video_codec_frame_unref);
+}
+
+/**
+ * gst_codec_preparser_free:
+ * @preparser: a #GstCodecPreparser
+ *
+ * Stops the worker thread, releases all pending jobs and frees @preparser.
+ */
+void
+gst_codec_preparser_free (GstCodecPreparser * preparser)
+{
+  guint head, tail, i;
+
+  g_return_if_fail (preparser != NULL);
+
+  if (preparser->thread) {
+    g_mutex_lock (&preparser->lock);
+    g_atomic_int_set (&preparser->stopping, 1);
+    g_cond_signal (&preparser->worker_cond);
+    g_mutex_unlock (&preparser->lock);
+
+    g_thread_join (preparser->thread);
+    preparser->thread = NULL;
+  }
+
+  head = (guint) g_atomic_int_get (&preparser->head);
+  tail = (guint) g_atomic_int_get (&preparser->tail);
+  for (; tail != head; tail++)
+    gst_codec_preparser_clear_job (&preparser->slots[tail & preparser->mask]);
+
+  for (i = 0; i < preparser->depth; i++)
+    g_array_unref (preparser->slots[i].job.units);
+
+  g_mutex_clear (&preparser->lock);
+  g_cond_clear (&preparser->worker_cond);
+  g_cond_clear (&preparser->consumer_cond);
+
+  g_free (preparser->slots);
+  g_free (preparser);
+}
+
+/**
+ * gst_codec_preparser_push:
+ * @preparser: a #GstCodecPreparser
+ * @frame: (transfer full): a #GstVideoCodecFrame
+ * @param: codec specific value to be stored in #GstCodecPreparserJob.param
+ *
+ * Queues @frame to be parsed by the worker thread. Must be called from
+ * the streaming thread.
+ *
+ * Returns: %TRUE if @frame was queued. If the ring is full, %FALSE is
+ *   returned and @frame is not consumed
+ */
+gboolean
+gst_codec_preparser_push (GstCodecPreparser * preparser,
+    GstVideoCodecFrame * frame, gint param)
+{
+  GstCodecPreparserSlot *slot;
+  guint head, tail;
+
+  g_return_val_if_fail (preparser != NULL, FALSE);
+  g_return_val_if_fail (frame != NULL, FALSE);
+
+  head = (guint) g_atomic_int_get (&preparser->head);
+  tail = (guint) g_atomic_int_get (&preparser->tail);
+  if (head - tail >= preparser->depth)
+    return FALSE;
+
+  slot = &preparser->slots[head & preparser->mask];
+  slot->buffer = gst_buffer_ref (frame->input_buffer);
+  slot->job.frame = frame;
+  slot->job.param = param;
+  slot->job.mapped = gst_buffer_map (slot->buffer, &slot->job.map,
+      GST_MAP_READ);
+  if (!slot->job.mapped) {
+    GST_WARNING ("Couldn't map input buffer of frame %u",
+        frame->system_frame_number);
+    memset (&slot->job.map, 0, sizeof (GstMapInfo));
+  }
+
+  g_atomic_int_set (&preparser->head, head + 1);
+  gst_codec_preparser_wake (preparser,
+      &preparser->worker_waiting, &preparser->worker_cond);
+
+  return TRUE;
+}
+
+/**
+ * gst_codec_preparser_pop:
+ * @preparser: a #GstCodecPreparser
+ *
+ * Returns the oldest pending job, waiting for the worker thread to finish
+ * parsing it if needed. The job must be given back with
+ * gst_codec_preparser_release() before the next call.
+ *
+ * Returns: (transfer none) (nullable): a #GstCodecPreparserJob or %NULL if
+ *   no frame is pending
+ */
+GstCodecPreparserJob *
+gst_codec_preparser_pop (GstCodecPreparser * preparser)
+{
+  guint tail;
+
+  g_return_val_if_fail (preparser != NULL, NULL);
+
+  tail = (guint) g_atomic_int_get (&preparser->tail);
+  if (tail == (guint) g_atomic_int_get (&preparser->head))
+    return NULL;
+
+  if (tail == (guint) g_atomic_int_get (&preparser->parsed)) {
+    g_mutex_lock (&preparser->lock);
+    g_atomic_int_set (&preparser->consumer_waiting, 1);
+    while (tail == (guint) g_atomic_int_get (&preparser->parsed))
+      g_cond_wait (&preparser->consumer_cond, &preparser->lock);
+    g_atomic_int_set (&preparser->consumer_waiting, 0);
+    g_mutex_unlock (&preparser->lock);
+  }
+
+  return &preparser->slots[tail & preparser->mask].job;
+}
+
+/**
+ * gst_codec_preparser_release:
+ * @preparser: a #GstCodecPreparser
+ * @job: the #GstCodecPreparserJob returned by gst_codec_preparser_pop()
+ *
+ * Unmaps the input buffer of @job, releases its frame if it was not stolen
+ * and makes the slot available for a new frame.
+ */
+void
+gst_codec_preparser_release (GstCodecPreparser * preparser,
+    GstCodecPreparserJob * job)
+{
+  guint tail;
+  GstCodecPreparserSlot *slot;
+
+  g_return_if_fail (preparser != NULL);
+
+  tail = (guint) g_atomic_int_get (&preparser->tail);
+  slot = &preparser->slots[tail & preparser->mask];
+
+  g_return_if_fail (job == &slot->job);
+
+  gst_codec_preparser_clear_job (slot);
+  g_atomic_int_set (&preparser->tail, tail + 1);
+}
+
+/**
+ * gst_codec_preparser_flush:
+ * @preparser: a #GstCodecPreparser
+ *
+ * Releases all pending jobs without decoding them.
+ */
+void
+gst_codec_preparser_flush (GstCodecPreparser * preparser)
+{
+  GstCodecPreparserJob *job;
+
+  g_return_if_fail (preparser != NULL);
+
+  while ((job = gst_codec_preparser_pop (preparser)) != NULL)
+    gst_codec_preparser_release (preparser, job);
+}
+
+/**
+ * gst_codec_preparser_get_pending:
+ * @preparser: a #GstCodecPreparser
+ *
+ * Returns: the number of frames which were pushed but not released yet
+ */
+guint
+gst_codec_preparser_get_pending (GstCodecPreparser * preparser)
+{
+  g_return_val_if_fail (preparser != NULL, 0);
+
+  return (guint) g_atomic_int_get (&preparser->head) -
+      (guint) g_atomic_int_get (&preparser->tail);
+}
@@ -0,0 +1,95 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CODEC_PREPARSER_H__
+#define __GST_CODEC_PREPARSER_H__
+
+#include <gst/codecs/codecs-prelude.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstCodecPreparser GstCodecPreparser;
+typedef struct _GstCodecPreparserJob GstCodecPreparserJob;
+
+/**
+ * GstCodecPreparserJob:
+ * @frame: (transfer full): the #GstVideoCodecFrame to be decoded. The
+ *   consumer can steal it by setting this field to %NULL, otherwise it is
+ *   released by gst_codec_preparser_release()
+ * @map: the mapped input buffer of @frame, valid until the job is released
+ * @param: codec specific value captured by gst_codec_preparser_push()
+ * @units: an array of parsed units (e.g. #GstH264NalUnit) filled by the
+ *   worker thread. The array is cleared and reused for every job
+ *
+ * A frame travelling through a #GstCodecPreparser.
+ */
+struct _GstCodecPreparserJob
+{
+  GstVideoCodecFrame *frame;
+  GstMapInfo map;
+  gint param;
+  GArray *units;
+
+  /*< private >*/
+  gboolean mapped;
+};
+
+/**
+ * GstCodecPreparserFunc:
+ * @job: a #GstCodecPreparserJob
+ * @user_data: the user data passed to gst_codec_preparser_new()
+ *
+ * Called from the worker thread for each pushed frame. The function must
+ * only split @job->map into @job->units and must not touch any decoder state
+ * which is also accessed from the streaming thread.
+ */
+typedef void (*GstCodecPreparserFunc) (GstCodecPreparserJob * job,
+                                       gpointer user_data);
+
+GST_CODECS_API
+GstCodecPreparser * gst_codec_preparser_new     (const gchar * name,
+                                                 guint depth,
+                                                 guint unit_size,
+                                                 GstCodecPreparserFunc func,
+                                                 gpointer user_data);
+
+GST_CODECS_API
+void                gst_codec_preparser_free    (GstCodecPreparser * preparser);
+
+GST_CODECS_API
+gboolean            gst_codec_preparser_push    (GstCodecPreparser * preparser,
+                                                 GstVideoCodecFrame * frame,
+                                                 gint param);
+
+GST_CODECS_API
+GstCodecPreparserJob * gst_codec_preparser_pop  (GstCodecPreparser * preparser);
+
+GST_CODECS_API
+void                gst_codec_preparser_release (GstCodecPreparser * preparser,
+                                                 GstCodecPreparserJob * job);
+
+GST_CODECS_API
+void                gst_codec_preparser_flush   (GstCodecPreparser * preparser);
+
+GST_CODECS_API
+guint               gst_codec_preparser_get_pending (GstCodecPreparser * preparser);
+
+G_END_DECLS
+
+#endif /* __GST_CODEC_PREPARSER_H__ */
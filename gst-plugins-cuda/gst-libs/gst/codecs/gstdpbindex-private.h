@@ -0,0 +1,158 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Small open addressing (linear probing) index mapping an integer key
+ * (pic_num, poc, system_frame_number, ...) to the slots of the DPB picture
+ * array.
+ *
+ * Every picture of the DPB has its own entry, several pictures may share a
+ * key, for instance the two fields of a frame or a non-reference picture
+ * keeping a stale pic_num. The DPB keeps it up to date as pictures are
+ * added and removed and as their keys change, instead of rebuilding it.
+ * The table is sized to be at least four times the number of DPB slots so
+ * that probing sequences stay short. */
+#define GST_DPB_INDEX_SIZE 128
+#define GST_DPB_INDEX_MASK (GST_DPB_INDEX_SIZE - 1)
+
+typedef struct
+{
+  gint32 key;
+  gint16 slot;
+} GstDpbIndexEntry;
+
+typedef struct
+{
+  GstDpbIndexEntry entries[GST_DPB_INDEX_SIZE];
+} GstDpbIndex;
+
+static inline guint
+gst_dpb_index_hash (gint32 key)
+{
+  /* Fibonacci hashing, keeps consecutive pic_num/poc values apart */
+  return (((guint32) key) * 2654435761u) >> (32 - 7);
+}
+
+static inline void
+gst_dpb_index_clear (GstDpbIndex * index)
+{
+  guint i;
+
+  for (i = 0; i < GST_DPB_INDEX_SIZE; i++)
+    index->entries[i].slot = -1;
+}
+
+static inline void
+gst_dpb_index_insert (GstDpbIndex * index, gint32 key, gint slot)
+{
+  guint pos = gst_dpb_index_hash (key) & GST_DPB_INDEX_MASK;
+
+  while (index->entries[pos].slot >= 0)
+    pos = (pos + 1) & GST_DPB_INDEX_MASK;
+
+  index->entries[pos].key = key;
+  index->entries[pos].slot = slot;
+}
+
+/* Removes the entry of @slot for @key, moving the following entries of the
+ * probing sequence back so that no tombstone is needed */
+static inline void
+gst_dpb_index_remove (GstDpbIndex * index, gint32 key, gint slot)
+{
+  guint pos = gst_dpb_index_hash (key) & GST_DPB_INDEX_MASK;
+  guint next;
+
+  while (index->entries[pos].slot >= 0) {
+    if (index->entries[pos].key == key && index->entries[pos].slot == slot)
+      break;
+
+    pos = (pos + 1) & GST_DPB_INDEX_MASK;
+  }
+
+  if (index->entries[pos].slot < 0)
+    return;
+
+  for (next = (pos + 1) & GST_DPB_INDEX_MASK; index->entries[next].slot >= 0;
+      next = (next + 1) & GST_DPB_INDEX_MASK) {
+    guint home = gst_dpb_index_hash (index->entries[next].key) &
+        GST_DPB_INDEX_MASK;
+
+    /* the entry can fill the hole if its home is not in (pos, next] */
+    if (((next - home) & GST_DPB_INDEX_MASK) >=
+        ((next - pos) & GST_DPB_INDEX_MASK)) {
+      index->entries[pos] = index->entries[next];
+      pos = next;
+    }
+  }
+
+  index->entries[pos].slot = -1;
+}
+
+/* Updates the entry of @slot once its key changed from @old_key to
+ * @new_key */
+static inline void
+gst_dpb_index_rekey (GstDpbIndex * index, gint32 old_key, gint32 new_key,
+    gint slot)
+{
+  if (old_key == new_key)
+    return;
+
+  gst_dpb_index_remove (index, old_key, slot);
+  gst_dpb_index_insert (index, new_key, slot);
+}
+
+/* Renumbers the entries once the picture of @slot was removed and the
+ * following ones moved down by one slot */
+static inline void
+gst_dpb_index_shift_down (GstDpbIndex * index, gint slot)
+{
+  guint i;
+
+  for (i = 0; i < GST_DPB_INDEX_SIZE; i++) {
+    if (index->entries[i].slot > slot)
+      index->entries[i].slot--;
+  }
+}
+
+/* Iterates over the slots of the entries of @key, in no particular order.
+ * *@iter has to be set to 0 before the first call, -1 is returned once all
+ * the slots were returned */
+static inline gint
+gst_dpb_index_lookup_next (const GstDpbIndex * index, gint32 key,
+    guint * iter)
+{
+  guint pos = (gst_dpb_index_hash (key) + *iter) & GST_DPB_INDEX_MASK;
+
+  while (*iter < GST_DPB_INDEX_SIZE && index->entries[pos].slot >= 0) {
+    (*iter)++;
+
+    if (index->entries[pos].key == key)
+      return index->entries[pos].slot;
+
+    pos = (pos + 1) & GST_DPB_INDEX_MASK;
+  }
+
+  return -1;
+}
+
+G_END_DECLS
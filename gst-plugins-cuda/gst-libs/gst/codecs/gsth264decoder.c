@@ -60,6 +60,7 @@
 
 #include <gst/base/base.h>
 #include "gsth264decoder.h"
+#include "gstcodecpreparser.h"
 
 GST_DEBUG_CATEGORY (gst_h264_decoder_debug);
 #define GST_CAT_DEFAULT gst_h264_decoder_debug
@@ -78,9 +79,13 @@ typedef enum
   GST_H264_DECODER_ALIGN_AU
 } GstH264DecoderAlign;
 
+/* Frame N+1 is parsed while frame N is decoded */
+#define GST_H264_DECODER_PREPARSE_DEPTH 2
+
 struct _GstH264DecoderPrivate
 {
   GstH264DecoderCompliance compliance;
+  gboolean pipelined;
 
   guint8 profile_idc;
   gint width, height;
@@ -152,6 +157,11 @@ struct _GstH264DecoderPrivate
 
   /* For delayed output */
   GstQueueArray *output_queue;
+
+  /* NAL unit identification on a worker thread, in pipelined mode only.
+   * The worker uses its own parser instance */
+  GstCodecPreparser *preparser;
+  GstH264NalParser *preparse_parser;
 };
 
 typedef struct
@@ -200,6 +210,8 @@ static gboolean gst_h264_decoder_calculate_poc (GstH264Decoder * self,
 static gboolean gst_h264_decoder_init_gap_picture (GstH264Decoder * self,
     GstH264Picture * picture, gint frame_num);
 static GstFlowReturn gst_h264_decoder_drain_internal (GstH264Decoder * self);
+static GstFlowReturn gst_h264_decoder_process_preparsed (GstH264Decoder * self,
+    guint keep);
 static void gst_h264_decoder_finish_current_picture (GstH264Decoder * self,
     GstFlowReturn * ret);
 static void gst_h264_decoder_finish_picture (GstH264Decoder * self,
@@ -222,6 +234,7 @@ enum
 {
   PROP_0,
   PROP_COMPLIANCE,
+  PROP_PIPELINED,
 };
 
 /**
@@ -271,6 +284,11 @@ gst_h264_decoder_get_property (GObject * object, guint property_id,
       g_value_set_enum (value, priv->compliance);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_PIPELINED:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, priv->pipelined);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -290,6 +308,11 @@ gst_h264_decoder_set_property (GObject * object, guint property_id,
       priv->compliance = g_value_get_enum (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_PIPELINED:
+      GST_OBJECT_LOCK (self);
+      priv->pipelined = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -330,6 +353,20 @@ gst_h264_decoder_class_init (GstH264DecoderClass * klass)
           "The decoder's behavior in compliance with the h264 spec.",
           GST_TYPE_H264_DECODER_COMPLIANCE, GST_H264_DECODER_COMPLIANCE_AUTO,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT));
+
+  /**
+   * GstH264Decoder:pipelined:
+   *
+   * Identify the NAL units of the next frame on a worker thread while the
+   * current frame is being decoded. This adds one frame of latency and
+   * takes effect on the next start of the decoder.
+   */
+  g_object_class_install_property (object_class, PROP_PIPELINED,
+      g_param_spec_boolean ("pipelined", "Pipelined",
+          "Parse the next frame on a worker thread while decoding the current "
+          "one (adds one frame of latency)", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
@@ -408,6 +445,8 @@ gst_h264_decoder_reset (GstH264Decoder * self)
 {
   GstH264DecoderPrivate *priv = self->priv;
 
+  g_clear_pointer (&priv->preparser, gst_codec_preparser_free);
+  g_clear_pointer (&priv->preparse_parser, gst_h264_nal_parser_free);
   gst_clear_buffer (&priv->codec_data);
   g_clear_pointer (&self->input_state, gst_video_codec_state_unref);
   g_clear_pointer (&priv->parser, gst_h264_nal_parser_free);
@@ -420,17 +459,72 @@ gst_h264_decoder_reset (GstH264Decoder * self)
   priv->nal_length_size = 4;
 }
 
+/* Called on the pre-parsing thread, must not touch the decoder state */
+static void
+gst_h264_decoder_preparse (GstCodecPreparserJob * job, GstH264Decoder * self)
+{
+  GstH264NalParser *parser = self->priv->preparse_parser;
+  const GstMapInfo *map = &job->map;
+  GstH264NalUnit nalu;
+  GstH264ParserResult pres;
+
+  if (job->param > 0) {
+    pres = gst_h264_parser_identify_nalu_avc (parser,
+        map->data, 0, map->size, job->param, &nalu);
+
+    while (pres == GST_H264_PARSER_OK) {
+      g_array_append_val (job->units, nalu);
+
+      pres = gst_h264_parser_identify_nalu_avc (parser,
+          map->data, nalu.offset + nalu.size, map->size, job->param, &nalu);
+    }
+  } else {
+    pres = gst_h264_parser_identify_nalu (parser, map->data, 0, map->size,
+        &nalu);
+
+    if (pres == GST_H264_PARSER_NO_NAL_END)
+      pres = GST_H264_PARSER_OK;
+
+    while (pres == GST_H264_PARSER_OK) {
+      g_array_append_val (job->units, nalu);
+
+      pres = gst_h264_parser_identify_nalu (parser,
+          map->data, nalu.offset + nalu.size, map->size, &nalu);
+
+      if (pres == GST_H264_PARSER_NO_NAL_END)
+        pres = GST_H264_PARSER_OK;
+    }
+  }
+}
+
 static gboolean
 gst_h264_decoder_start (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
   GstH264DecoderPrivate *priv = self->priv;
+  gboolean pipelined;
 
   gst_h264_decoder_reset (self);
 
   priv->parser = gst_h264_nal_parser_new ();
   priv->dpb = gst_h264_dpb_new ();
 
+  GST_OBJECT_LOCK (self);
+  pipelined = priv->pipelined;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pipelined) {
+    priv->preparse_parser = gst_h264_nal_parser_new ();
+    priv->preparser = gst_codec_preparser_new ("h264-preparse",
+        GST_H264_DECODER_PREPARSE_DEPTH, sizeof (GstH264NalUnit),
+        (GstCodecPreparserFunc) gst_h264_decoder_preparse, self);
+
+    if (!priv->preparser) {
+      GST_WARNING_OBJECT (self, "Pipelined mode is not available");
+      g_clear_pointer (&priv->preparse_parser, gst_h264_nal_parser_free);
+    }
+  }
+
   return TRUE;
 }
 
@@ -491,6 +585,9 @@ gst_h264_decoder_flush (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
 
+  if (self->priv->preparser)
+    gst_codec_preparser_flush (self->priv->preparser);
+
   gst_h264_decoder_clear_dpb (self, TRUE);
 
   return TRUE;
@@ -500,9 +597,15 @@ static GstFlowReturn
 gst_h264_decoder_drain (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (self->priv->preparser)
+    ret = gst_h264_decoder_process_preparsed (self, 0);
 
   /* dpb will be cleared by this method */
-  return gst_h264_decoder_drain_internal (self);
+  UPDATE_FLOW_RETURN (&ret, gst_h264_decoder_drain_internal (self));
+
+  return ret;
 }
 
 static GstFlowReturn
@@ -511,6 +614,67 @@ gst_h264_decoder_finish (GstVideoDecoder * decoder)
   return gst_h264_decoder_drain (decoder);
 }
 
+static GstFlowReturn
+gst_h264_decoder_finish_frame_decoding (GstH264Decoder * self,
+    GstVideoCodecFrame * frame, GstFlowReturn decode_ret)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
+  if (decode_ret != GST_FLOW_OK) {
+    if (decode_ret == GST_FLOW_ERROR) {
+      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+          ("Failed to decode data"), (NULL), decode_ret);
+    }
+
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (self), frame);
+    gst_h264_picture_clear (&priv->current_picture);
+    priv->current_frame = NULL;
+
+    return decode_ret;
+  }
+
+  gst_h264_decoder_finish_current_picture (self, &decode_ret);
+  gst_video_codec_frame_unref (frame);
+  priv->current_frame = NULL;
+
+  if (decode_ret == GST_FLOW_ERROR) {
+    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+        ("Failed to decode data"), (NULL), decode_ret);
+  }
+
+  return decode_ret;
+}
+
+/* Decodes pre-parsed frames in order until at most @keep frames are left
+ * in flight */
+static GstFlowReturn
+gst_h264_decoder_process_preparsed (GstH264Decoder * self, guint keep)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (ret == GST_FLOW_OK &&
+      gst_codec_preparser_get_pending (priv->preparser) > keep) {
+    GstCodecPreparserJob *job = gst_codec_preparser_pop (priv->preparser);
+    GstVideoCodecFrame *frame = job->frame;
+    guint i;
+
+    job->frame = NULL;
+    priv->current_frame = frame;
+
+    for (i = 0; i < job->units->len && ret == GST_FLOW_OK; i++) {
+      ret = gst_h264_decoder_decode_nal (self,
+          &g_array_index (job->units, GstH264NalUnit, i));
+    }
+
+    gst_codec_preparser_release (priv->preparser, job);
+
+    ret = gst_h264_decoder_finish_frame_decoding (self, frame, ret);
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame)
@@ -528,6 +692,23 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
       GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
       GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
 
+  if (priv->preparser) {
+    gint nal_length_size = priv->in_format == GST_H264_DECODER_FORMAT_AVC ?
+        priv->nal_length_size : 0;
+
+    /* At most one frame is left in flight, so there should always be room */
+    if (!gst_codec_preparser_push (priv->preparser, frame, nal_length_size)) {
+      GST_ERROR_OBJECT (self, "Couldn't queue frame %u for pre-parsing",
+          frame->system_frame_number);
+
+      return gst_h264_decoder_finish_frame_decoding (self, frame,
+          GST_FLOW_ERROR);
+    }
+
+    return gst_h264_decoder_process_preparsed (self,
+        GST_H264_DECODER_PREPARSE_DEPTH - 1);
+  }
+
   priv->current_frame = frame;
 
   gst_buffer_map (in_buf, &map, GST_MAP_READ);
@@ -562,29 +743,7 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
 
   gst_buffer_unmap (in_buf, &map);
 
-  if (decode_ret != GST_FLOW_OK) {
-    if (decode_ret == GST_FLOW_ERROR) {
-      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-          ("Failed to decode data"), (NULL), decode_ret);
-    }
-
-    gst_video_decoder_drop_frame (decoder, frame);
-    gst_h264_picture_clear (&priv->current_picture);
-    priv->current_frame = NULL;
-
-    return decode_ret;
-  }
-
-  gst_h264_decoder_finish_current_picture (self, &decode_ret);
-  gst_video_codec_frame_unref (frame);
-  priv->current_frame = NULL;
-
-  if (decode_ret == GST_FLOW_ERROR) {
-    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-        ("Failed to decode data"), (NULL), decode_ret);
-  }
-
-  return decode_ret;
+  return gst_h264_decoder_finish_frame_decoding (self, frame, decode_ret);
 }
 
 static GstFlowReturn
@@ -751,38 +910,9 @@ gst_h264_decoder_update_pic_nums (GstH264Decoder * self,
     GstH264Picture * current_picture, gint frame_num)
 {
   GstH264DecoderPrivate *priv = self->priv;
-  GArray *dpb = gst_h264_dpb_get_pictures_all (priv->dpb);
-  gint i;
-
-  for (i = 0; i < dpb->len; i++) {
-    GstH264Picture *picture = g_array_index (dpb, GstH264Picture *, i);
-
-    if (!GST_H264_PICTURE_IS_REF (picture))
-      continue;
-
-    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture)) {
-      if (GST_H264_PICTURE_IS_FRAME (current_picture))
-        picture->long_term_pic_num = picture->long_term_frame_idx;
-      else if (current_picture->field == picture->field)
-        picture->long_term_pic_num = 2 * picture->long_term_frame_idx + 1;
-      else
-        picture->long_term_pic_num = 2 * picture->long_term_frame_idx;
-    } else {
-      if (picture->frame_num > frame_num)
-        picture->frame_num_wrap = picture->frame_num - priv->max_frame_num;
-      else
-        picture->frame_num_wrap = picture->frame_num;
-
-      if (GST_H264_PICTURE_IS_FRAME (current_picture))
-        picture->pic_num = picture->frame_num_wrap;
-      else if (picture->field == current_picture->field)
-        picture->pic_num = 2 * picture->frame_num_wrap + 1;
-      else
-        picture->pic_num = 2 * picture->frame_num_wrap;
-    }
-  }
 
-  g_array_unref (dpb);
+  gst_h264_dpb_update_pic_nums (priv->dpb, current_picture, frame_num,
+      priv->max_frame_num);
 }
 
 static GstH264Picture *
@@ -1163,12 +1293,12 @@ gst_h264_decoder_find_first_field_picture (GstH264Decoder * self,
       in_dpb = FALSE;
     } else if (gst_h264_dpb_get_size (priv->dpb) > 0) {
       GstH264Picture *prev_picture;
-      GArray *pictures;
+      GstH264Picture *const *pictures;
+      guint num_pictures;
 
-      pictures = gst_h264_dpb_get_pictures_all (priv->dpb);
-      prev_picture =
-          g_array_index (pictures, GstH264Picture *, pictures->len - 1);
-      g_array_unref (pictures); /* prev_picture should be held */
+      /* prev_picture is held by the DPB */
+      pictures = gst_h264_dpb_peek_pictures_all (priv->dpb, &num_pictures);
+      prev_picture = pictures[num_pictures - 1];
 
       /* Previous picture was a field picture. */
       if (!GST_H264_PICTURE_IS_FRAME (prev_picture)
@@ -1405,6 +1535,12 @@ gst_h264_decoder_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (decoder, "Set format");
 
+  /* Pending frames were parsed against the previous codec_data */
+  if (priv->preparser &&
+      gst_h264_decoder_process_preparsed (self, 0) != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (self, "Failed to decode pending frames");
+  }
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
 
@@ -3020,8 +3156,9 @@ gst_h264_decoder_prepare_ref_pic_lists (GstH264Decoder * self,
 {
   GstH264DecoderPrivate *priv = self->priv;
   gboolean construct_list = FALSE;
-  gint i;
-  GArray *dpb_array = gst_h264_dpb_get_pictures_all (priv->dpb);
+  guint i, num_pictures;
+  GstH264Picture *const *dpb_array =
+      gst_h264_dpb_peek_pictures_all (priv->dpb, &num_pictures);
 
   /* 8.2.4.2.1 ~ 8.2.4.2.4
    * When this process is invoked, there shall be at least one reference entry
@@ -3029,14 +3166,13 @@ gst_h264_decoder_prepare_ref_pic_lists (GstH264Decoder * self,
    * (i.e., as "used for short-term reference" or "used for long-term reference")
    * and is not marked as "non-existing"
    */
-  for (i = 0; i < dpb_array->len; i++) {
-    GstH264Picture *picture = g_array_index (dpb_array, GstH264Picture *, i);
+  for (i = 0; i < num_pictures; i++) {
+    GstH264Picture *picture = dpb_array[i];
     if (GST_H264_PICTURE_IS_REF (picture) && !picture->nonexisting) {
       construct_list = TRUE;
       break;
     }
   }
-  g_array_unref (dpb_array);
 
   if (!construct_list) {
     gst_h264_decoder_clear_ref_pic_lists (self);
@@ -22,7 +22,9 @@
 #endif
 
 #include "gsth264picture.h"
+#include "gstdpbindex-private.h"
 #include <stdlib.h>
+#include <string.h>
 
 GST_DEBUG_CATEGORY_EXTERN (gst_h264_decoder_debug);
 #define GST_CAT_DEFAULT gst_h264_decoder_debug
@@ -103,9 +105,16 @@ gst_h264_picture_get_user_data (GstH264Picture * picture)
   return picture->user_data;
 }
 
+/* One extra slot so that overflowing streams are reported by
+ * gst_h264_dpb_add() instead of writing out of bounds */
+#define GST_H264_DPB_MAX_PICTURES (GST_H264_DPB_MAX_NUM_PICTURES + 1)
+
 struct _GstH264Dpb
 {
-  GArray *pic_list;
+  /* Pictures in decoding order, owned by the DPB */
+  GstH264Picture *pic_list[GST_H264_DPB_MAX_PICTURES];
+  guint num_pics;
+
   gint max_num_frames;
   gint num_output_needed;
   guint32 max_num_reorder_frames;
@@ -113,6 +122,15 @@ struct _GstH264Dpb
   gboolean last_output_non_ref;
 
   gboolean interlaced;
+
+  /* Side indices into pic_list, updated as pictures are added and removed
+   * and as gst_h264_dpb_update_pic_nums() changes their picture numbers.
+   * A hit is always validated against the picture itself, and a miss falls
+   * back to a linear scan, so a subclass changing the numbers behind our
+   * back can never get a wrong picture */
+  GstDpbIndex pic_num_index;
+  GstDpbIndex long_term_pic_num_index;
+  GstDpbIndex frame_number_index;
 };
 
 static void
@@ -123,6 +141,42 @@ gst_h264_dpb_init (GstH264Dpb * dpb)
   dpb->last_output_non_ref = FALSE;
 }
 
+static void
+gst_h264_dpb_reset_indices (GstH264Dpb * dpb)
+{
+  gst_dpb_index_clear (&dpb->pic_num_index);
+  gst_dpb_index_clear (&dpb->long_term_pic_num_index);
+  gst_dpb_index_clear (&dpb->frame_number_index);
+}
+
+/* Keeps decoding order, the last picture needs to be referenced for
+ * bumping decision */
+static void
+gst_h264_dpb_remove_index (GstH264Dpb * dpb, guint index)
+{
+  GstH264Picture *picture = dpb->pic_list[index];
+
+  gst_dpb_index_remove (&dpb->pic_num_index, picture->pic_num, index);
+  gst_dpb_index_remove (&dpb->long_term_pic_num_index,
+      picture->long_term_pic_num, index);
+  gst_dpb_index_remove (&dpb->frame_number_index,
+      picture->system_frame_number, index);
+
+  if (index + 1 < dpb->num_pics) {
+    memmove (&dpb->pic_list[index], &dpb->pic_list[index + 1],
+        (dpb->num_pics - index - 1) * sizeof (GstH264Picture *));
+
+    gst_dpb_index_shift_down (&dpb->pic_num_index, index);
+    gst_dpb_index_shift_down (&dpb->long_term_pic_num_index, index);
+    gst_dpb_index_shift_down (&dpb->frame_number_index, index);
+  }
+
+  dpb->num_pics--;
+  dpb->pic_list[dpb->num_pics] = NULL;
+
+  gst_h264_picture_unref (picture);
+}
+
 /**
  * gst_h264_dpb_new: (skip)
  *
@@ -137,12 +191,7 @@ gst_h264_dpb_new (void)
 
   dpb = g_new0 (GstH264Dpb, 1);
   gst_h264_dpb_init (dpb);
-
-  dpb->pic_list =
-      g_array_sized_new (FALSE, TRUE, sizeof (GstH264Picture *),
-      GST_H264_DPB_MAX_SIZE);
-  g_array_set_clear_func (dpb->pic_list,
-      (GDestroyNotify) gst_h264_picture_clear);
+  gst_h264_dpb_reset_indices (dpb);
 
   return dpb;
 }
@@ -223,7 +272,6 @@ gst_h264_dpb_free (GstH264Dpb * dpb)
   g_return_if_fail (dpb != NULL);
 
   gst_h264_dpb_clear (dpb);
-  g_array_unref (dpb->pic_list);
   g_free (dpb);
 }
 
@@ -236,10 +284,16 @@ gst_h264_dpb_free (GstH264Dpb * dpb)
 void
 gst_h264_dpb_clear (GstH264Dpb * dpb)
 {
+  guint i;
+
   g_return_if_fail (dpb != NULL);
 
-  g_array_set_size (dpb->pic_list, 0);
+  for (i = 0; i < dpb->num_pics; i++)
+    gst_h264_picture_clear (&dpb->pic_list[i]);
+  dpb->num_pics = 0;
+
   gst_h264_dpb_init (dpb);
+  gst_h264_dpb_reset_indices (dpb);
 }
 
 /**
@@ -273,6 +327,14 @@ gst_h264_dpb_add (GstH264Dpb * dpb, GstH264Picture * picture)
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (GST_IS_H264_PICTURE (picture));
 
+  /* Before anything is accounted for or linked to the dropped picture */
+  if (dpb->num_pics >= GST_H264_DPB_MAX_PICTURES) {
+    GST_ERROR ("DPB is full, dropping picture %p (frame num: %d, poc: %d)",
+        picture, picture->frame_num, picture->pic_order_cnt);
+    gst_h264_picture_unref (picture);
+    return;
+  }
+
   /* C.4.2 Decoding of gaps in frame_num and storage of "non-existing" pictures
    *
    * The "non-existing" frame is stored in an empty frame buffer and is marked
@@ -297,11 +359,17 @@ gst_h264_dpb_add (GstH264Dpb * dpb, GstH264Picture * picture)
     picture->other_field->other_field = picture;
   }
 
-  g_array_append_val (dpb->pic_list, picture);
+  dpb->pic_list[dpb->num_pics] = picture;
+  gst_dpb_index_insert (&dpb->pic_num_index, picture->pic_num, dpb->num_pics);
+  gst_dpb_index_insert (&dpb->long_term_pic_num_index,
+      picture->long_term_pic_num, dpb->num_pics);
+  gst_dpb_index_insert (&dpb->frame_number_index,
+      picture->system_frame_number, dpb->num_pics);
+  dpb->num_pics++;
 
-  if (dpb->pic_list->len > dpb->max_num_frames * (dpb->interlaced + 1))
+  if (dpb->num_pics > dpb->max_num_frames * (dpb->interlaced + 1))
     GST_ERROR ("DPB size is %d, exceed the max size %d",
-        dpb->pic_list->len, dpb->max_num_frames * (dpb->interlaced + 1));
+        dpb->num_pics, dpb->max_num_frames * (dpb->interlaced + 1));
 
   /* The IDR frame or mem_mgmt_5 */
   if (picture->pic_order_cnt == 0) {
@@ -320,22 +388,19 @@ gst_h264_dpb_add (GstH264Dpb * dpb, GstH264Picture * picture)
 void
 gst_h264_dpb_delete_unused (GstH264Dpb * dpb)
 {
-  gint i;
+  guint i;
 
   g_return_if_fail (dpb != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  /* Backwards, so that the pictures left to check do not move */
+  for (i = dpb->num_pics; i > 0; i--) {
+    GstH264Picture *picture = dpb->pic_list[i - 1];
 
-    /* NOTE: don't use g_array_remove_index_fast here since the last picture
-     * need to be referenced for bumping decision */
     if (!picture->needed_for_output && !GST_H264_PICTURE_IS_REF (picture)) {
       GST_TRACE
           ("remove picture %p (frame num: %d, poc: %d, field: %d) from dpb",
           picture, picture->frame_num, picture->pic_order_cnt, picture->field);
-      g_array_remove_index (dpb->pic_list, i);
-      i--;
+      gst_h264_dpb_remove_index (dpb, i - 1);
     }
   }
 }
@@ -356,9 +421,8 @@ gst_h264_dpb_num_ref_frames (GstH264Dpb * dpb)
 
   g_return_val_if_fail (dpb != NULL, -1);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     /* Count frame, not field picture */
     if (picture->second_field)
@@ -384,9 +448,8 @@ gst_h264_dpb_mark_all_non_ref (GstH264Dpb * dpb)
 
   g_return_if_fail (dpb != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     gst_h264_picture_set_reference (picture, GST_H264_PICTURE_REF_NONE, FALSE);
   }
@@ -404,13 +467,32 @@ gst_h264_dpb_mark_all_non_ref (GstH264Dpb * dpb)
 GstH264Picture *
 gst_h264_dpb_get_short_ref_by_pic_num (GstH264Dpb * dpb, gint pic_num)
 {
+  guint iter = 0;
+  gint found = -1;
   gint i;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  /* Non-reference pictures may keep the same stale pic_num, the first
+   * matching picture in decoding order wins as with the linear scan */
+  while ((i = gst_dpb_index_lookup_next (&dpb->pic_num_index, pic_num,
+              &iter)) >= 0) {
+    GstH264Picture *picture;
+
+    if (i >= dpb->num_pics || (found >= 0 && i > found))
+      continue;
+
+    picture = dpb->pic_list[i];
+    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture)
+        && picture->pic_num == pic_num)
+      found = i;
+  }
+
+  if (found >= 0)
+    return dpb->pic_list[found];
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture)
         && picture->pic_num == pic_num)
@@ -437,13 +519,30 @@ GstH264Picture *
 gst_h264_dpb_get_long_ref_by_long_term_pic_num (GstH264Dpb * dpb,
     gint long_term_pic_num)
 {
+  guint iter = 0;
+  gint found = -1;
   gint i;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  while ((i = gst_dpb_index_lookup_next (&dpb->long_term_pic_num_index,
+              long_term_pic_num, &iter)) >= 0) {
+    GstH264Picture *picture;
+
+    if (i >= dpb->num_pics || (found >= 0 && i > found))
+      continue;
+
+    picture = dpb->pic_list[i];
+    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture) &&
+        picture->long_term_pic_num == long_term_pic_num)
+      found = i;
+  }
+
+  if (found >= 0)
+    return dpb->pic_list[found];
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture) &&
         picture->long_term_pic_num == long_term_pic_num)
@@ -471,9 +570,8 @@ gst_h264_dpb_get_lowest_frame_num_short_ref (GstH264Dpb * dpb)
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture) &&
         (!ret || picture->frame_num_wrap < ret->frame_num_wrap))
@@ -508,9 +606,8 @@ gst_h264_dpb_get_pictures_short_term_ref (GstH264Dpb * dpb,
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (out != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (!include_second_field && picture->second_field)
       continue;
@@ -545,9 +642,8 @@ gst_h264_dpb_get_pictures_long_term_ref (GstH264Dpb * dpb,
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (out != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (!include_second_field && picture->second_field)
       continue;
@@ -559,6 +655,139 @@ gst_h264_dpb_get_pictures_long_term_ref (GstH264Dpb * dpb,
   }
 }
 
+/**
+ * gst_h264_dpb_peek_pictures_short_term_ref:
+ * @dpb: a #GstH264Dpb
+ * @include_non_existing: %TRUE if non-existing pictures need to be included
+ * @include_second_field: %TRUE if the second field pictures need to be included
+ * @out: (out caller-allocates) (array length=out_size) (transfer none):
+ *   a caller provided array of #GstH264Picture pointers
+ * @out_size: the number of elements @out can hold
+ *
+ * Allocation and refcount free version of
+ * gst_h264_dpb_get_pictures_short_term_ref(). Pointers stored in @out are
+ * only valid until @dpb is modified.
+ *
+ * Returns: the number of pictures written to @out
+ */
+guint
+gst_h264_dpb_peek_pictures_short_term_ref (GstH264Dpb * dpb,
+    gboolean include_non_existing, gboolean include_second_field,
+    GstH264Picture ** out, guint out_size)
+{
+  guint i;
+  guint n = 0;
+
+  g_return_val_if_fail (dpb != NULL, 0);
+  g_return_val_if_fail (out != NULL || out_size == 0, 0);
+
+  for (i = 0; i < dpb->num_pics && n < out_size; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
+
+    if (!include_second_field && picture->second_field)
+      continue;
+
+    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture) &&
+        (include_non_existing || !picture->nonexisting))
+      out[n++] = picture;
+  }
+
+  return n;
+}
+
+/**
+ * gst_h264_dpb_peek_pictures_long_term_ref:
+ * @dpb: a #GstH264Dpb
+ * @include_second_field: %TRUE if the second field pictures need to be included
+ * @out: (out caller-allocates) (array length=out_size) (transfer none):
+ *   a caller provided array of #GstH264Picture pointers
+ * @out_size: the number of elements @out can hold
+ *
+ * Allocation and refcount free version of
+ * gst_h264_dpb_get_pictures_long_term_ref(). Pointers stored in @out are
+ * only valid until @dpb is modified.
+ *
+ * Returns: the number of pictures written to @out
+ */
+guint
+gst_h264_dpb_peek_pictures_long_term_ref (GstH264Dpb * dpb,
+    gboolean include_second_field, GstH264Picture ** out, guint out_size)
+{
+  guint i;
+  guint n = 0;
+
+  g_return_val_if_fail (dpb != NULL, 0);
+  g_return_val_if_fail (out != NULL || out_size == 0, 0);
+
+  for (i = 0; i < dpb->num_pics && n < out_size; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
+
+    if (!include_second_field && picture->second_field)
+      continue;
+
+    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
+      out[n++] = picture;
+  }
+
+  return n;
+}
+
+/**
+ * gst_h264_dpb_update_pic_nums:
+ * @dpb: a #GstH264Dpb
+ * @current_picture: the #GstH264Picture being decoded
+ * @frame_num: frame_num of @current_picture
+ * @max_frame_num: MaxFrameNum of the active SPS
+ *
+ * Derive FrameNumWrap, PicNum and LongTermPicNum of all reference pictures
+ * in @dpb as specified in "8.2.4.1 Decoding process for picture numbers", and
+ * refresh the picture number lookup indices accordingly.
+ */
+void
+gst_h264_dpb_update_pic_nums (GstH264Dpb * dpb,
+    GstH264Picture * current_picture, gint frame_num, gint max_frame_num)
+{
+  guint i;
+
+  g_return_if_fail (dpb != NULL);
+  g_return_if_fail (current_picture != NULL);
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
+    gint pic_num = picture->pic_num;
+    gint long_term_pic_num = picture->long_term_pic_num;
+
+    if (!GST_H264_PICTURE_IS_REF (picture))
+      continue;
+
+    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture)) {
+      if (GST_H264_PICTURE_IS_FRAME (current_picture))
+        picture->long_term_pic_num = picture->long_term_frame_idx;
+      else if (current_picture->field == picture->field)
+        picture->long_term_pic_num = 2 * picture->long_term_frame_idx + 1;
+      else
+        picture->long_term_pic_num = 2 * picture->long_term_frame_idx;
+
+      gst_dpb_index_rekey (&dpb->long_term_pic_num_index, long_term_pic_num,
+          picture->long_term_pic_num, i);
+    } else {
+      if (picture->frame_num > frame_num)
+        picture->frame_num_wrap = picture->frame_num - max_frame_num;
+      else
+        picture->frame_num_wrap = picture->frame_num;
+
+      if (GST_H264_PICTURE_IS_FRAME (current_picture))
+        picture->pic_num = picture->frame_num_wrap;
+      else if (picture->field == current_picture->field)
+        picture->pic_num = 2 * picture->frame_num_wrap + 1;
+      else
+        picture->pic_num = 2 * picture->frame_num_wrap;
+
+      gst_dpb_index_rekey (&dpb->pic_num_index, pic_num, picture->pic_num, i);
+    }
+  }
+}
+
 /**
  * gst_h264_dpb_get_pictures_all:
  * @dpb: a #GstH264Dpb
@@ -569,9 +798,43 @@ gst_h264_dpb_get_pictures_long_term_ref (GstH264Dpb * dpb,
 GArray *
 gst_h264_dpb_get_pictures_all (GstH264Dpb * dpb)
 {
+  GArray *ret;
+  guint i;
+
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  return g_array_ref (dpb->pic_list);
+  ret = g_array_sized_new (FALSE, TRUE, sizeof (GstH264Picture *),
+      dpb->num_pics);
+  g_array_set_clear_func (ret, (GDestroyNotify) gst_h264_picture_clear);
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = gst_h264_picture_ref (dpb->pic_list[i]);
+    g_array_append_val (ret, picture);
+  }
+
+  return ret;
+}
+
+/**
+ * gst_h264_dpb_peek_pictures_all:
+ * @dpb: a #GstH264Dpb
+ * @num_pictures: (out): the number of pictures in the returned array
+ *
+ * Allocation free version of gst_h264_dpb_get_pictures_all(). The returned
+ * array is owned by @dpb and is only valid until @dpb is modified.
+ *
+ * Return: (array length=num_pictures) (transfer none): the #GstH264Picture
+ *   stored in @dpb, in decoding order
+ */
+GstH264Picture *const *
+gst_h264_dpb_peek_pictures_all (GstH264Dpb * dpb, guint * num_pictures)
+{
+  g_return_val_if_fail (dpb != NULL, NULL);
+  g_return_val_if_fail (num_pictures != NULL, NULL);
+
+  *num_pictures = dpb->num_pics;
+
+  return dpb->pic_list;
 }
 
 /**
@@ -585,7 +848,7 @@ gst_h264_dpb_get_size (GstH264Dpb * dpb)
 {
   g_return_val_if_fail (dpb != NULL, -1);
 
-  return dpb->pic_list->len;
+  return dpb->num_pics;
 }
 
 /**
@@ -602,13 +865,27 @@ gst_h264_dpb_get_size (GstH264Dpb * dpb)
 GstH264Picture *
 gst_h264_dpb_get_picture (GstH264Dpb * dpb, guint32 system_frame_number)
 {
+  guint iter = 0;
+  gint found = -1;
   gint i;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  /* Both fields of a frame share the system frame number */
+  while ((i = gst_dpb_index_lookup_next (&dpb->frame_number_index,
+              system_frame_number, &iter)) >= 0) {
+    if (i >= dpb->num_pics || (found >= 0 && i > found))
+      continue;
+
+    if (dpb->pic_list[i]->system_frame_number == system_frame_number)
+      found = i;
+  }
+
+  if (found >= 0)
+    return gst_h264_picture_ref (dpb->pic_list[found]);
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (picture->system_frame_number == system_frame_number) {
       gst_h264_picture_ref (picture);
@@ -631,15 +908,14 @@ gboolean
 gst_h264_dpb_has_empty_frame_buffer (GstH264Dpb * dpb)
 {
   if (!dpb->interlaced) {
-    if (dpb->pic_list->len < dpb->max_num_frames)
+    if (dpb->num_pics < dpb->max_num_frames)
       return TRUE;
   } else {
     gint i;
     gint count = 0;
     /* Count the number of complementary field pairs */
-    for (i = 0; i < dpb->pic_list->len; i++) {
-      GstH264Picture *picture =
-          g_array_index (dpb->pic_list, GstH264Picture *, i);
+    for (i = 0; i < dpb->num_pics; i++) {
+      GstH264Picture *picture = dpb->pic_list[i];
 
       if (picture->second_field)
         continue;
@@ -665,9 +941,8 @@ gst_h264_dpb_get_lowest_output_needed_picture (GstH264Dpb * dpb,
 
   *picture = NULL;
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH264Picture *picture = dpb->pic_list[i];
 
     if (!picture->needed_for_output)
       continue;
@@ -758,7 +1033,7 @@ gst_h264_dpb_needs_bump (GstH264Dpb * dpb, GstH264Picture * to_insert,
 
       need_output = 0;
       for (i = 0; i < lowest_index; i++) {
-        GstH264Picture *p = g_array_index (dpb->pic_list, GstH264Picture *, i);
+        GstH264Picture *p = dpb->pic_list[i];
         if (p->needed_for_output)
           need_output++;
       }
@@ -895,10 +1170,10 @@ gst_h264_dpb_bump (GstH264Dpb * dpb, gboolean drain)
   dpb->num_output_needed--;
   g_assert (dpb->num_output_needed >= 0);
 
-  /* NOTE: don't use g_array_remove_index_fast here since the last picture
+  /* NOTE: the removal keeps decoding order since the last picture
    * need to be referenced for bumping decision */
   if (!GST_H264_PICTURE_IS_REF (picture) || drain)
-    g_array_remove_index (dpb->pic_list, index);
+    gst_h264_dpb_remove_index (dpb, index);
 
   other_picture = picture->other_field;
   if (other_picture) {
@@ -913,12 +1188,11 @@ gst_h264_dpb_bump (GstH264Dpb * dpb, gboolean drain)
       picture->buffer_flags |= GST_VIDEO_BUFFER_FLAG_TFF;
 
     if (!other_picture->ref) {
-      for (i = 0; i < dpb->pic_list->len; i++) {
-        GstH264Picture *tmp =
-            g_array_index (dpb->pic_list, GstH264Picture *, i);
+      for (i = 0; i < dpb->num_pics; i++) {
+        GstH264Picture *tmp = dpb->pic_list[i];
 
         if (tmp == other_picture) {
-          g_array_remove_index (dpb->pic_list, i);
+          gst_h264_dpb_remove_index (dpb, i);
           break;
         }
       }
@@ -1035,9 +1309,8 @@ gst_h264_dpb_perform_memory_management_control_operation (GstH264Dpb * dpb,
 
       /* If we have long-term ref picture for LongTermFrameIdx,
        * mark the picture as non-reference */
-      for (i = 0; i < dpb->pic_list->len; i++) {
-        GstH264Picture *tmp =
-            g_array_index (dpb->pic_list, GstH264Picture *, i);
+      for (i = 0; i < dpb->num_pics; i++) {
+        GstH264Picture *tmp = dpb->pic_list[i];
 
         if (GST_H264_PICTURE_IS_LONG_TERM_REF (tmp)
             && tmp->long_term_frame_idx == ref_pic_marking->long_term_frame_idx) {
@@ -1113,8 +1386,8 @@ gst_h264_dpb_perform_memory_management_control_operation (GstH264Dpb * dpb,
 
       GST_TRACE ("MMCO-4: max_long_term_frame_idx %d", max_long_term_frame_idx);
 
-      for (i = 0; i < dpb->pic_list->len; i++) {
-        other = g_array_index (dpb->pic_list, GstH264Picture *, i);
+      for (i = 0; i < dpb->num_pics; i++) {
+        other = dpb->pic_list[i];
 
         if (GST_H264_PICTURE_IS_LONG_TERM_REF (other) &&
             other->long_term_frame_idx > max_long_term_frame_idx) {
@@ -1127,8 +1400,8 @@ gst_h264_dpb_perform_memory_management_control_operation (GstH264Dpb * dpb,
       break;
     case 5:
       /* 8.2.5.4.5 Unmark all reference pictures */
-      for (i = 0; i < dpb->pic_list->len; i++) {
-        other = g_array_index (dpb->pic_list, GstH264Picture *, i);
+      for (i = 0; i < dpb->num_pics; i++) {
+        other = dpb->pic_list[i];
         gst_h264_picture_set_reference (other,
             GST_H264_PICTURE_REF_NONE, FALSE);
       }
@@ -1157,8 +1430,8 @@ gst_h264_dpb_perform_memory_management_control_operation (GstH264Dpb * dpb,
 
       /* If we have long-term ref picture for LongTermFrameIdx,
        * mark the picture as non-reference */
-      for (i = 0; i < dpb->pic_list->len; i++) {
-        other = g_array_index (dpb->pic_list, GstH264Picture *, i);
+      for (i = 0; i < dpb->num_pics; i++) {
+        other = dpb->pic_list[i];
 
         if (GST_H264_PICTURE_IS_LONG_TERM_REF (other) &&
             other->long_term_frame_idx ==
@@ -37,6 +37,10 @@ typedef struct _GstH264Picture GstH264Picture;
 /* As specified in A.3.1 h) and A.3.2 f) */
 #define GST_H264_DPB_MAX_SIZE 16
 
+/* Upper bound of pictures stored in a #GstH264Dpb, a frame may be stored as
+ * two field pictures */
+#define GST_H264_DPB_MAX_NUM_PICTURES (GST_H264_DPB_MAX_SIZE * 2)
+
 /**
  * GST_H264_PICTURE_IS_REF:
  * @picture: a #GstH264Picture
@@ -289,9 +293,32 @@ void  gst_h264_dpb_get_pictures_long_term_ref  (GstH264Dpb * dpb,
                                                 gboolean include_second_field,
                                                 GArray * out);
 
+GST_CODECS_API
+guint gst_h264_dpb_peek_pictures_short_term_ref (GstH264Dpb * dpb,
+                                                 gboolean include_non_existing,
+                                                 gboolean include_second_field,
+                                                 GstH264Picture ** out,
+                                                 guint out_size);
+
+GST_CODECS_API
+guint gst_h264_dpb_peek_pictures_long_term_ref  (GstH264Dpb * dpb,
+                                                 gboolean include_second_field,
+                                                 GstH264Picture ** out,
+                                                 guint out_size);
+
 GST_CODECS_API
 GArray * gst_h264_dpb_get_pictures_all         (GstH264Dpb * dpb);
 
+GST_CODECS_API
+GstH264Picture * const * gst_h264_dpb_peek_pictures_all (GstH264Dpb * dpb,
+                                                         guint * num_pictures);
+
+GST_CODECS_API
+void  gst_h264_dpb_update_pic_nums (GstH264Dpb * dpb,
+                                    GstH264Picture * current_picture,
+                                    gint frame_num,
+                                    gint max_frame_num);
+
 GST_CODECS_API
 GstH264Picture * gst_h264_dpb_get_picture      (GstH264Dpb * dpb,
                                                 guint32 system_frame_number);
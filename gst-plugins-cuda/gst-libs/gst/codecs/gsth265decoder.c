@@ -31,6 +31,7 @@
 #endif
 
 #include "gsth265decoder.h"
+#include "gstcodecpreparser.h"
 
 GST_DEBUG_CATEGORY (gst_h265_decoder_debug);
 #define GST_CAT_DEFAULT gst_h265_decoder_debug
@@ -50,8 +51,13 @@ typedef enum
   GST_H265_DECODER_ALIGN_AU
 } GstH265DecoderAlign;
 
+/* Frame N+1 is parsed while frame N is decoded */
+#define GST_H265_DECODER_PREPARSE_DEPTH 2
+
 struct _GstH265DecoderPrivate
 {
+  gboolean pipelined;
+
   gint width, height;
 
   guint8 conformance_window_flag;
@@ -123,6 +129,17 @@ struct _GstH265DecoderPrivate
   GArray *ref_pic_list_tmp;
   GArray *ref_pic_list0;
   GArray *ref_pic_list1;
+
+  /* NAL unit identification on a worker thread, in pipelined mode only.
+   * The worker uses its own parser instance */
+  GstCodecPreparser *preparser;
+  GstH265Parser *preparse_parser;
+};
+
+enum
+{
+  PROP_0,
+  PROP_PIPELINED,
 };
 
 #define UPDATE_FLOW_RETURN(ret,new_ret) G_STMT_START { \
@@ -156,6 +173,46 @@ static void gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush);
 static GstFlowReturn gst_h265_decoder_drain_internal (GstH265Decoder * self);
 static GstFlowReturn
 gst_h265_decoder_start_current_picture (GstH265Decoder * self);
+static GstFlowReturn gst_h265_decoder_process_preparsed (GstH265Decoder * self,
+    guint keep);
+
+static void
+gst_h265_decoder_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (property_id) {
+    case PROP_PIPELINED:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, priv->pipelined);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h265_decoder_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (property_id) {
+    case PROP_PIPELINED:
+      GST_OBJECT_LOCK (self);
+      priv->pipelined = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
 
 static void
 gst_h265_decoder_class_init (GstH265DecoderClass * klass)
@@ -164,6 +221,8 @@ gst_h265_decoder_class_init (GstH265DecoderClass * klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->finalize = GST_DEBUG_FUNCPTR (gst_h265_decoder_finalize);
+  object_class->get_property = gst_h265_decoder_get_property;
+  object_class->set_property = gst_h265_decoder_set_property;
 
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_h265_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_h265_decoder_stop);
@@ -173,6 +232,20 @@ gst_h265_decoder_class_init (GstH265DecoderClass * klass)
   decoder_class->drain = GST_DEBUG_FUNCPTR (gst_h265_decoder_drain);
   decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_h265_decoder_handle_frame);
+
+  /**
+   * GstH265Decoder:pipelined:
+   *
+   * Identify the NAL units of the next frame on a worker thread while the
+   * current frame is being decoded. This adds one frame of latency and
+   * takes effect on the next start of the decoder.
+   */
+  g_object_class_install_property (object_class, PROP_PIPELINED,
+      g_param_spec_boolean ("pipelined", "Pipelined",
+          "Parse the next frame on a worker thread while decoding the current "
+          "one (adds one frame of latency)", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
@@ -207,17 +280,72 @@ gst_h265_decoder_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* Called on the pre-parsing thread, must not touch the decoder state */
+static void
+gst_h265_decoder_preparse (GstCodecPreparserJob * job, GstH265Decoder * self)
+{
+  GstH265Parser *parser = self->priv->preparse_parser;
+  const GstMapInfo *map = &job->map;
+  GstH265NalUnit nalu;
+  GstH265ParserResult pres;
+
+  if (job->param > 0) {
+    pres = gst_h265_parser_identify_nalu_hevc (parser,
+        map->data, 0, map->size, job->param, &nalu);
+
+    while (pres == GST_H265_PARSER_OK) {
+      g_array_append_val (job->units, nalu);
+
+      pres = gst_h265_parser_identify_nalu_hevc (parser,
+          map->data, nalu.offset + nalu.size, map->size, job->param, &nalu);
+    }
+  } else {
+    pres = gst_h265_parser_identify_nalu (parser, map->data, 0, map->size,
+        &nalu);
+
+    if (pres == GST_H265_PARSER_NO_NAL_END)
+      pres = GST_H265_PARSER_OK;
+
+    while (pres == GST_H265_PARSER_OK) {
+      g_array_append_val (job->units, nalu);
+
+      pres = gst_h265_parser_identify_nalu (parser,
+          map->data, nalu.offset + nalu.size, map->size, &nalu);
+
+      if (pres == GST_H265_PARSER_NO_NAL_END)
+        pres = GST_H265_PARSER_OK;
+    }
+  }
+}
+
 static gboolean
 gst_h265_decoder_start (GstVideoDecoder * decoder)
 {
   GstH265Decoder *self = GST_H265_DECODER (decoder);
   GstH265DecoderPrivate *priv = self->priv;
+  gboolean pipelined;
 
   priv->parser = gst_h265_parser_new ();
   priv->dpb = gst_h265_dpb_new ();
   priv->new_bitstream = TRUE;
   priv->prev_nal_is_eos = FALSE;
 
+  GST_OBJECT_LOCK (self);
+  pipelined = priv->pipelined;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pipelined) {
+    priv->preparse_parser = gst_h265_parser_new ();
+    priv->preparser = gst_codec_preparser_new ("h265-preparse",
+        GST_H265_DECODER_PREPARSE_DEPTH, sizeof (GstH265NalUnit),
+        (GstCodecPreparserFunc) gst_h265_decoder_preparse, self);
+
+    if (!priv->preparser) {
+      GST_WARNING_OBJECT (self, "Pipelined mode is not available");
+      g_clear_pointer (&priv->preparse_parser, gst_h265_parser_free);
+    }
+  }
+
   return TRUE;
 }
 
@@ -227,6 +355,9 @@ gst_h265_decoder_stop (GstVideoDecoder * decoder)
   GstH265Decoder *self = GST_H265_DECODER (decoder);
   GstH265DecoderPrivate *priv = self->priv;
 
+  g_clear_pointer (&priv->preparser, gst_codec_preparser_free);
+  g_clear_pointer (&priv->preparse_parser, gst_h265_parser_free);
+
   if (self->input_state) {
     gst_video_codec_state_unref (self->input_state);
     self->input_state = NULL;
@@ -903,6 +1034,12 @@ gst_h265_decoder_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (decoder, "Set format");
 
+  /* Pending frames were parsed against the previous codec_data */
+  if (priv->preparser &&
+      gst_h265_decoder_process_preparsed (self, 0) != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (self, "Failed to decode pending frames");
+  }
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
 
@@ -985,6 +1122,9 @@ gst_h265_decoder_flush (GstVideoDecoder * decoder)
 {
   GstH265Decoder *self = GST_H265_DECODER (decoder);
 
+  if (self->priv->preparser)
+    gst_codec_preparser_flush (self->priv->preparser);
+
   gst_h265_decoder_clear_dpb (self, TRUE);
 
   return TRUE;
@@ -994,9 +1134,15 @@ static GstFlowReturn
 gst_h265_decoder_drain (GstVideoDecoder * decoder)
 {
   GstH265Decoder *self = GST_H265_DECODER (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (self->priv->preparser)
+    ret = gst_h265_decoder_process_preparsed (self, 0);
 
   /* dpb will be cleared by this method */
-  return gst_h265_decoder_drain_internal (self);
+  UPDATE_FLOW_RETURN (&ret, gst_h265_decoder_drain_internal (self));
+
+  return ret;
 }
 
 static GstFlowReturn
@@ -1258,7 +1404,8 @@ gst_h265_decoder_derive_and_mark_rps (GstH265Decoder * self,
 {
   GstH265DecoderPrivate *priv = self->priv;
   guint i;
-  GArray *dpb_array;
+  GstH265Picture *const *dpb_array;
+  guint num_pictures;
 
   gst_h265_decoder_clear_ref_pic_sets (self);
 
@@ -1315,9 +1462,9 @@ gst_h265_decoder_derive_and_mark_rps (GstH265Decoder * self,
   }
 
   /* Mark all dpb pics not beloging to RefPicSet*[] as unused for ref */
-  dpb_array = gst_h265_dpb_get_pictures_all (priv->dpb);
-  for (i = 0; i < dpb_array->len; i++) {
-    GstH265Picture *dpb_pic = g_array_index (dpb_array, GstH265Picture *, i);
+  dpb_array = gst_h265_dpb_peek_pictures_all (priv->dpb, &num_pictures);
+  for (i = 0; i < num_pictures; i++) {
+    GstH265Picture *dpb_pic = dpb_array[i];
 
     if (dpb_pic &&
         !has_entry_in_rps (dpb_pic, self->RefPicSetLtCurr, self->NumPocLtCurr)
@@ -1335,8 +1482,6 @@ gst_h265_decoder_derive_and_mark_rps (GstH265Decoder * self,
       dpb_pic->long_term = FALSE;
     }
   }
-
-  g_array_unref (dpb_array);
 }
 
 static gboolean
@@ -1747,6 +1892,75 @@ gst_h265_decoder_reset_frame_state (GstH265Decoder * self)
   priv->cur_duplicate_flag = 0;
 }
 
+static GstFlowReturn
+gst_h265_decoder_finish_frame_decoding (GstH265Decoder * self,
+    GstVideoCodecFrame * frame, GstFlowReturn decode_ret)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  priv->current_frame = NULL;
+
+  if (decode_ret != GST_FLOW_OK) {
+    if (decode_ret == GST_FLOW_ERROR) {
+      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+          ("Failed to decode data"), (NULL), decode_ret);
+    }
+
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (self), frame);
+    gst_h265_picture_clear (&priv->current_picture);
+
+    return decode_ret;
+  }
+
+  if (priv->current_picture) {
+    gst_h265_decoder_finish_current_picture (self, &decode_ret);
+    gst_video_codec_frame_unref (frame);
+  } else {
+    /* This picture was dropped */
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (self), frame);
+  }
+
+  if (decode_ret == GST_FLOW_ERROR) {
+    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+        ("Failed to decode data"), (NULL), decode_ret);
+  }
+
+  return decode_ret;
+}
+
+/* Decodes pre-parsed frames in order until at most @keep frames are left
+ * in flight */
+static GstFlowReturn
+gst_h265_decoder_process_preparsed (GstH265Decoder * self, guint keep)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (ret == GST_FLOW_OK &&
+      gst_codec_preparser_get_pending (priv->preparser) > keep) {
+    GstCodecPreparserJob *job = gst_codec_preparser_pop (priv->preparser);
+    GstVideoCodecFrame *frame = job->frame;
+    GstClockTime pts = GST_BUFFER_PTS (frame->input_buffer);
+    guint i;
+
+    job->frame = NULL;
+    priv->current_frame = frame;
+
+    gst_h265_decoder_reset_frame_state (self);
+
+    for (i = 0; i < job->units->len && ret == GST_FLOW_OK; i++) {
+      ret = gst_h265_decoder_decode_nal (self,
+          &g_array_index (job->units, GstH265NalUnit, i), pts);
+    }
+
+    gst_codec_preparser_release (priv->preparser, job);
+
+    ret = gst_h265_decoder_finish_frame_decoding (self, frame, ret);
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame)
@@ -1764,6 +1978,26 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
       GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
       GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
 
+  if (priv->preparser) {
+    gint nal_length_size = 0;
+
+    if (priv->in_format == GST_H265_DECODER_FORMAT_HVC1 ||
+        priv->in_format == GST_H265_DECODER_FORMAT_HEV1)
+      nal_length_size = priv->nal_length_size;
+
+    /* At most one frame is left in flight, so there should always be room */
+    if (!gst_codec_preparser_push (priv->preparser, frame, nal_length_size)) {
+      GST_ERROR_OBJECT (self, "Couldn't queue frame %u for pre-parsing",
+          frame->system_frame_number);
+
+      return gst_h265_decoder_finish_frame_decoding (self, frame,
+          GST_FLOW_ERROR);
+    }
+
+    return gst_h265_decoder_process_preparsed (self,
+        GST_H265_DECODER_PREPARSE_DEPTH - 1);
+  }
+
   priv->current_frame = frame;
 
   gst_h265_decoder_reset_frame_state (self);
@@ -1807,34 +2041,8 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
   }
 
   gst_buffer_unmap (in_buf, &map);
-  priv->current_frame = NULL;
-
-  if (decode_ret != GST_FLOW_OK) {
-    if (decode_ret == GST_FLOW_ERROR) {
-      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-          ("Failed to decode data"), (NULL), decode_ret);
-    }
-
-    gst_video_decoder_drop_frame (decoder, frame);
-    gst_h265_picture_clear (&priv->current_picture);
-
-    return decode_ret;
-  }
-
-  if (priv->current_picture) {
-    gst_h265_decoder_finish_current_picture (self, &decode_ret);
-    gst_video_codec_frame_unref (frame);
-  } else {
-    /* This picture was dropped */
-    gst_video_decoder_release_frame (decoder, frame);
-  }
 
-  if (decode_ret == GST_FLOW_ERROR) {
-    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-        ("Failed to decode data"), (NULL), decode_ret);
-  }
-
-  return decode_ret;
+  return gst_h265_decoder_finish_frame_decoding (self, frame, decode_ret);
 }
 
 /**
@@ -22,6 +22,8 @@
 #endif
 
 #include "gsth265picture.h"
+#include "gstdpbindex-private.h"
+#include <string.h>
 
 GST_DEBUG_CATEGORY_EXTERN (gst_h265_decoder_debug);
 #define GST_CAT_DEFAULT gst_h265_decoder_debug
@@ -105,13 +107,165 @@ gst_h265_picture_get_user_data (GstH265Picture * picture)
   return picture->user_data;
 }
 
+/* The current picture is added before bumping, and one extra slot so that
+ * overflowing streams are reported by gst_h265_dpb_add() instead of writing
+ * out of bounds */
+#define GST_H265_DPB_MAX_PICTURES (GST_H265_DPB_MAX_SIZE + 2)
+
 struct _GstH265Dpb
 {
-  GArray *pic_list;
+  /* Pictures owned by the DPB */
+  GstH265Picture *pic_list[GST_H265_DPB_MAX_PICTURES];
+  guint num_pics;
+
   gint max_num_pics;
   gint num_output_needed;
+
+  /* Side indices into pic_list, updated on add and removal. POC values don't
+   * change once a picture is stored, but reference marking does, so a hit is
+   * always validated and a miss falls back to a linear scan */
+  GstDpbIndex poc_index;
+  GstDpbIndex poc_lsb_index;
+  GstDpbIndex frame_number_index;
 };
 
+typedef gboolean (*GstH265DpbMatchFunc) (GstH265Picture * picture,
+    gint32 key);
+
+static void
+gst_h265_dpb_reset_indices (GstH265Dpb * dpb)
+{
+  gst_dpb_index_clear (&dpb->poc_index);
+  gst_dpb_index_clear (&dpb->poc_lsb_index);
+  gst_dpb_index_clear (&dpb->frame_number_index);
+}
+
+static void
+gst_h265_dpb_index_picture (GstH265Dpb * dpb, GstH265Picture * picture,
+    guint index)
+{
+  gst_dpb_index_insert (&dpb->poc_index, picture->pic_order_cnt, index);
+  gst_dpb_index_insert (&dpb->poc_lsb_index, picture->pic_order_cnt_lsb,
+      index);
+  gst_dpb_index_insert (&dpb->frame_number_index,
+      picture->system_frame_number, index);
+}
+
+static void
+gst_h265_dpb_unindex_picture (GstH265Dpb * dpb, GstH265Picture * picture,
+    guint index)
+{
+  gst_dpb_index_remove (&dpb->poc_index, picture->pic_order_cnt, index);
+  gst_dpb_index_remove (&dpb->poc_lsb_index, picture->pic_order_cnt_lsb,
+      index);
+  gst_dpb_index_remove (&dpb->frame_number_index,
+      picture->system_frame_number, index);
+}
+
+/* Same as g_array_remove_index_fast(), the last picture fills the hole */
+static void
+gst_h265_dpb_remove_index_fast (GstH265Dpb * dpb, guint index)
+{
+  GstH265Picture *picture = dpb->pic_list[index];
+
+  gst_h265_dpb_unindex_picture (dpb, picture, index);
+
+  dpb->num_pics--;
+  if (index < dpb->num_pics) {
+    GstH265Picture *last = dpb->pic_list[dpb->num_pics];
+
+    gst_h265_dpb_unindex_picture (dpb, last, dpb->num_pics);
+    gst_h265_dpb_index_picture (dpb, last, index);
+    dpb->pic_list[index] = last;
+  }
+  dpb->pic_list[dpb->num_pics] = NULL;
+
+  gst_h265_picture_unref (picture);
+}
+
+/* Same as g_array_remove_index(), keeps the order of the pictures */
+static void
+gst_h265_dpb_remove_index (GstH265Dpb * dpb, guint index)
+{
+  GstH265Picture *picture = dpb->pic_list[index];
+
+  gst_h265_dpb_unindex_picture (dpb, picture, index);
+
+  if (index + 1 < dpb->num_pics) {
+    memmove (&dpb->pic_list[index], &dpb->pic_list[index + 1],
+        (dpb->num_pics - index - 1) * sizeof (GstH265Picture *));
+
+    gst_dpb_index_shift_down (&dpb->poc_index, index);
+    gst_dpb_index_shift_down (&dpb->poc_lsb_index, index);
+    gst_dpb_index_shift_down (&dpb->frame_number_index, index);
+  }
+
+  dpb->num_pics--;
+  dpb->pic_list[dpb->num_pics] = NULL;
+
+  gst_h265_picture_unref (picture);
+}
+
+/* Returns the first picture of the DPB with @key in @index for which @match
+ * returns %TRUE, as a linear scan would */
+static GstH265Picture *
+gst_h265_dpb_find (GstH265Dpb * dpb, const GstDpbIndex * index, gint32 key,
+    GstH265DpbMatchFunc match)
+{
+  guint iter = 0;
+  gint found = -1;
+  gint i;
+
+  while ((i = gst_dpb_index_lookup_next (index, key, &iter)) >= 0) {
+    if (i >= dpb->num_pics || (found >= 0 && i > found))
+      continue;
+
+    if (match (dpb->pic_list[i], key))
+      found = i;
+  }
+
+  if (found >= 0)
+    return dpb->pic_list[found];
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    if (match (dpb->pic_list[i], key))
+      return dpb->pic_list[i];
+  }
+
+  return NULL;
+}
+
+static gboolean
+gst_h265_dpb_match_ref_by_poc (GstH265Picture * picture, gint32 poc)
+{
+  return picture->ref && picture->pic_order_cnt == poc;
+}
+
+static gboolean
+gst_h265_dpb_match_ref_by_poc_lsb (GstH265Picture * picture, gint32 poc_lsb)
+{
+  return picture->ref && picture->pic_order_cnt_lsb == poc_lsb;
+}
+
+static gboolean
+gst_h265_dpb_match_short_ref_by_poc (GstH265Picture * picture, gint32 poc)
+{
+  return picture->ref && !picture->long_term && picture->pic_order_cnt == poc;
+}
+
+static gboolean
+gst_h265_dpb_match_long_ref_by_poc (GstH265Picture * picture, gint32 poc)
+{
+  return picture->ref && picture->long_term && picture->pic_order_cnt == poc;
+}
+
+static gboolean
+gst_h265_dpb_match_frame_number (GstH265Picture * picture,
+    gint32 system_frame_number)
+{
+  return picture->system_frame_number == (guint32) system_frame_number;
+}
+
 /**
  * gst_h265_dpb_new: (skip)
  *
@@ -125,12 +279,7 @@ gst_h265_dpb_new (void)
   GstH265Dpb *dpb;
 
   dpb = g_new0 (GstH265Dpb, 1);
-
-  dpb->pic_list =
-      g_array_sized_new (FALSE, TRUE, sizeof (GstH265Picture *),
-      GST_H265_DPB_MAX_SIZE);
-  g_array_set_clear_func (dpb->pic_list,
-      (GDestroyNotify) gst_h265_picture_clear);
+  gst_h265_dpb_reset_indices (dpb);
 
   return dpb;
 }
@@ -176,7 +325,6 @@ gst_h265_dpb_free (GstH265Dpb * dpb)
   g_return_if_fail (dpb != NULL);
 
   gst_h265_dpb_clear (dpb);
-  g_array_unref (dpb->pic_list);
   g_free (dpb);
 }
 
@@ -189,10 +337,16 @@ gst_h265_dpb_free (GstH265Dpb * dpb)
 void
 gst_h265_dpb_clear (GstH265Dpb * dpb)
 {
+  guint i;
+
   g_return_if_fail (dpb != NULL);
 
-  g_array_set_size (dpb->pic_list, 0);
+  for (i = 0; i < dpb->num_pics; i++)
+    gst_h265_picture_clear (&dpb->pic_list[i]);
+  dpb->num_pics = 0;
   dpb->num_output_needed = 0;
+
+  gst_h265_dpb_reset_indices (dpb);
 }
 
 /**
@@ -209,12 +363,18 @@ gst_h265_dpb_add (GstH265Dpb * dpb, GstH265Picture * picture)
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (GST_IS_H265_PICTURE (picture));
 
+  if (dpb->num_pics >= GST_H265_DPB_MAX_PICTURES) {
+    GST_ERROR ("DPB is full, dropping picture %p (poc %d)",
+        picture, picture->pic_order_cnt);
+    gst_h265_picture_unref (picture);
+    return;
+  }
+
   if (picture->output_flag) {
     gint i;
 
-    for (i = 0; i < dpb->pic_list->len; i++) {
-      GstH265Picture *other =
-          g_array_index (dpb->pic_list, GstH265Picture *, i);
+    for (i = 0; i < dpb->num_pics; i++) {
+      GstH265Picture *other = dpb->pic_list[i];
 
       if (other->needed_for_output)
         other->pic_latency_cnt++;
@@ -230,7 +390,9 @@ gst_h265_dpb_add (GstH265Dpb * dpb, GstH265Picture * picture)
   picture->ref = TRUE;
   picture->long_term = FALSE;
 
-  g_array_append_val (dpb->pic_list, picture);
+  dpb->pic_list[dpb->num_pics] = picture;
+  gst_h265_dpb_index_picture (dpb, picture, dpb->num_pics);
+  dpb->num_pics++;
 }
 
 /**
@@ -242,19 +404,18 @@ gst_h265_dpb_add (GstH265Dpb * dpb, GstH265Picture * picture)
 void
 gst_h265_dpb_delete_unused (GstH265Dpb * dpb)
 {
-  gint i;
+  guint i;
 
   g_return_if_fail (dpb != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
+  /* Backwards, so that the pictures left to check do not move */
+  for (i = dpb->num_pics; i > 0; i--) {
+    GstH265Picture *picture = dpb->pic_list[i - 1];
 
     if (!picture->needed_for_output && !picture->ref) {
       GST_TRACE ("remove picture %p (poc %d) from dpb",
           picture, picture->pic_order_cnt);
-      g_array_remove_index (dpb->pic_list, i);
-      i--;
+      gst_h265_dpb_remove_index (dpb, i - 1);
     }
   }
 }
@@ -273,9 +434,8 @@ gst_h265_dpb_num_ref_pictures (GstH265Dpb * dpb)
 
   g_return_val_if_fail (dpb != NULL, -1);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH265Picture *picture = dpb->pic_list[i];
 
     if (picture->ref)
       ret++;
@@ -297,9 +457,8 @@ gst_h265_dpb_mark_all_non_ref (GstH265Dpb * dpb)
 
   g_return_if_fail (dpb != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH265Picture *picture = dpb->pic_list[i];
 
     picture->ref = FALSE;
   }
@@ -317,17 +476,14 @@ gst_h265_dpb_mark_all_non_ref (GstH265Dpb * dpb)
 GstH265Picture *
 gst_h265_dpb_get_ref_by_poc (GstH265Dpb * dpb, gint poc)
 {
-  gint i;
+  GstH265Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (picture->ref && picture->pic_order_cnt == poc)
-      return gst_h265_picture_ref (picture);
-  }
+  picture = gst_h265_dpb_find (dpb, &dpb->poc_index, poc,
+      gst_h265_dpb_match_ref_by_poc);
+  if (picture)
+    return gst_h265_picture_ref (picture);
 
   GST_DEBUG ("No short term reference picture for %d", poc);
 
@@ -346,17 +502,14 @@ gst_h265_dpb_get_ref_by_poc (GstH265Dpb * dpb, gint poc)
 GstH265Picture *
 gst_h265_dpb_get_ref_by_poc_lsb (GstH265Dpb * dpb, gint poc_lsb)
 {
-  gint i;
+  GstH265Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (picture->ref && picture->pic_order_cnt_lsb == poc_lsb)
-      return gst_h265_picture_ref (picture);
-  }
+  picture = gst_h265_dpb_find (dpb, &dpb->poc_lsb_index, poc_lsb,
+      gst_h265_dpb_match_ref_by_poc_lsb);
+  if (picture)
+    return gst_h265_picture_ref (picture);
 
   GST_DEBUG ("No short term reference picture for %d", poc_lsb);
 
@@ -375,17 +528,14 @@ gst_h265_dpb_get_ref_by_poc_lsb (GstH265Dpb * dpb, gint poc_lsb)
 GstH265Picture *
 gst_h265_dpb_get_short_ref_by_poc (GstH265Dpb * dpb, gint poc)
 {
-  gint i;
+  GstH265Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (picture->ref && !picture->long_term && picture->pic_order_cnt == poc)
-      return gst_h265_picture_ref (picture);
-  }
+  picture = gst_h265_dpb_find (dpb, &dpb->poc_index, poc,
+      gst_h265_dpb_match_short_ref_by_poc);
+  if (picture)
+    return gst_h265_picture_ref (picture);
 
   GST_DEBUG ("No short term reference picture for %d", poc);
 
@@ -404,17 +554,14 @@ gst_h265_dpb_get_short_ref_by_poc (GstH265Dpb * dpb, gint poc)
 GstH265Picture *
 gst_h265_dpb_get_long_ref_by_poc (GstH265Dpb * dpb, gint poc)
 {
-  gint i;
+  GstH265Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (picture->ref && picture->long_term && picture->pic_order_cnt == poc)
-      return gst_h265_picture_ref (picture);
-  }
+  picture = gst_h265_dpb_find (dpb, &dpb->poc_index, poc,
+      gst_h265_dpb_match_long_ref_by_poc);
+  if (picture)
+    return gst_h265_picture_ref (picture);
 
   GST_DEBUG ("No long term reference picture for %d", poc);
 
@@ -431,9 +578,43 @@ gst_h265_dpb_get_long_ref_by_poc (GstH265Dpb * dpb, gint poc)
 GArray *
 gst_h265_dpb_get_pictures_all (GstH265Dpb * dpb)
 {
+  GArray *ret;
+  guint i;
+
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  return g_array_ref (dpb->pic_list);
+  ret = g_array_sized_new (FALSE, TRUE, sizeof (GstH265Picture *),
+      dpb->num_pics);
+  g_array_set_clear_func (ret, (GDestroyNotify) gst_h265_picture_clear);
+
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH265Picture *picture = gst_h265_picture_ref (dpb->pic_list[i]);
+    g_array_append_val (ret, picture);
+  }
+
+  return ret;
+}
+
+/**
+ * gst_h265_dpb_peek_pictures_all:
+ * @dpb: a #GstH265Dpb
+ * @num_pictures: (out): the number of pictures in the returned array
+ *
+ * Allocation free version of gst_h265_dpb_get_pictures_all(). The returned
+ * array is owned by @dpb and is only valid until @dpb is modified.
+ *
+ * Return: (array length=num_pictures) (transfer none): the #GstH265Picture
+ *   stored in @dpb
+ */
+GstH265Picture *const *
+gst_h265_dpb_peek_pictures_all (GstH265Dpb * dpb, guint * num_pictures)
+{
+  g_return_val_if_fail (dpb != NULL, NULL);
+  g_return_val_if_fail (num_pictures != NULL, NULL);
+
+  *num_pictures = dpb->num_pics;
+
+  return dpb->pic_list;
 }
 
 /**
@@ -447,7 +628,7 @@ gst_h265_dpb_get_size (GstH265Dpb * dpb)
 {
   g_return_val_if_fail (dpb != NULL, -1);
 
-  return dpb->pic_list->len;
+  return dpb->num_pics;
 }
 
 /**
@@ -464,19 +645,14 @@ gst_h265_dpb_get_size (GstH265Dpb * dpb)
 GstH265Picture *
 gst_h265_dpb_get_picture (GstH265Dpb * dpb, guint32 system_frame_number)
 {
-  gint i;
+  GstH265Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (picture->system_frame_number == system_frame_number) {
-      gst_h265_picture_ref (picture);
-      return picture;
-    }
-  }
+  picture = gst_h265_dpb_find (dpb, &dpb->frame_number_index,
+      system_frame_number, gst_h265_dpb_match_frame_number);
+  if (picture)
+    return gst_h265_picture_ref (picture);
 
   return NULL;
 }
@@ -486,9 +662,8 @@ gst_h265_dpb_check_latency_count (GstH265Dpb * dpb, guint32 max_latency)
 {
   gint i;
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH265Picture *picture = dpb->pic_list[i];
 
     if (!picture->needed_for_output)
       continue;
@@ -522,9 +697,9 @@ gst_h265_dpb_needs_bump (GstH265Dpb * dpb, guint max_num_reorder_pics,
   /* If DPB is full and there is no empty space to store current picture,
    * need bumping.
    * NOTE: current picture was added already by our decoding flow, so we
-   * need to do bumping until dpb->pic_list->len == dpb->max_num_pic
+   * need to do bumping until dpb->num_pics == dpb->max_num_pic
    */
-  if (dpb->pic_list->len > dpb->max_num_pics) {
+  if (dpb->num_pics > dpb->max_num_pics) {
     GST_TRACE ("No empty frame buffer, need bumping");
     return TRUE;
   }
@@ -544,9 +719,9 @@ gst_h265_dpb_needs_bump (GstH265Dpb * dpb, guint max_num_reorder_pics,
   }
 
   /* C.5.2.2 */
-  if (max_dec_pic_buffering && dpb->pic_list->len >= max_dec_pic_buffering) {
+  if (max_dec_pic_buffering && dpb->num_pics >= max_dec_pic_buffering) {
     GST_TRACE ("dpb size (%d) >= max_dec_pic_buffering (%d)",
-        dpb->pic_list->len, max_dec_pic_buffering);
+        dpb->num_pics, max_dec_pic_buffering);
     return TRUE;
   }
 
@@ -563,9 +738,8 @@ gst_h265_dpb_get_lowest_output_needed_picture (GstH265Dpb * dpb,
 
   *picture = NULL;
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
+  for (i = 0; i < dpb->num_pics; i++) {
+    GstH265Picture *picture = dpb->pic_list[i];
 
     if (!picture->needed_for_output)
       continue;
@@ -622,7 +796,7 @@ gst_h265_dpb_bump (GstH265Dpb * dpb, gboolean drain)
   g_assert (dpb->num_output_needed >= 0);
 
   if (!picture->ref || drain)
-    g_array_remove_index_fast (dpb->pic_list, index);
+    gst_h265_dpb_remove_index_fast (dpb, index);
 
   return picture;
 }
@@ -184,6 +184,10 @@ GstH265Picture * gst_h265_dpb_get_long_ref_by_poc  (GstH265Dpb * dpb,
 GST_CODECS_API
 GArray * gst_h265_dpb_get_pictures_all         (GstH265Dpb * dpb);
 
+GST_CODECS_API
+GstH265Picture * const * gst_h265_dpb_peek_pictures_all (GstH265Dpb * dpb,
+                                                         guint * num_pictures);
+
 GST_CODECS_API
 GstH265Picture * gst_h265_dpb_get_picture      (GstH265Dpb * dpb,
                                                 guint32 system_frame_number);
@@ -66,6 +66,7 @@
 #endif
 
 #include <gst/base/gstbitreader.h>
+#include <gst/codecparsers/gstvpxbooldecoder.h>
 #include "gstvp9statefulparser.h"
 #include <string.h>
 
@@ -149,30 +150,7 @@ ensure_debug_category (void)
 #define CHECK_ALLOWED(val, min, max) \
   CHECK_ALLOWED_WITH_DEBUG (G_STRINGIFY (val), val, min, max)
 
-typedef struct _Vp9BoolDecoder
-{
-  guint64 value;
-  guint32 range;
-  guint32 bits_left;
-  gint count_to_fill;
-  GstBitReader *bit_reader;
-  gboolean out_of_bits;
-} Vp9BoolDecoder;
-
-/* how much to shift to get range > 128 */
-const static guint8 bool_shift_table[256] = {
-  0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3,
-  3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-};
+typedef GstVpxBoolDecoder Vp9BoolDecoder;
 
 static const guint8 inv_map_table[255] = {
   7, 20, 33, 46, 59, 72, 85, 98, 111, 124, 137, 150, 163, 176,
@@ -196,74 +174,16 @@ static const guint8 inv_map_table[255] = {
   252, 253, 253,
 };
 
-static void
-fill_bool (Vp9BoolDecoder * bd)
-{
-  guint max_bits_to_read;
-  guint bits_to_read;
-  guint64 data;
-
-  if (G_UNLIKELY (bd->bits_left < bd->count_to_fill)) {
-    GST_ERROR
-        ("Invalid VP9 bitstream: the boolean decoder ran out of bits to read");
-    bd->out_of_bits = TRUE;
-    return;
-  }
-
-  max_bits_to_read =
-      8 * (sizeof (bd->value) - sizeof (guint8)) + bd->count_to_fill;
-  bits_to_read = MIN (max_bits_to_read, bd->bits_left);
-
-  data =
-      gst_bit_reader_get_bits_uint64_unchecked (bd->bit_reader, bits_to_read);
-
-  bd->value |= data << (max_bits_to_read - bits_to_read);
-  bd->count_to_fill -= bits_to_read;
-  bd->bits_left -= bits_to_read;
-}
-
-static gboolean
+static inline gboolean
 read_bool (Vp9BoolDecoder * bd, guint8 probability)
 {
-  guint64 split;
-  guint64 big_split;
-  guint count;
-  gboolean bit;
-
-  if (bd->count_to_fill > 0)
-    fill_bool (bd);
-
-  split = 1 + (((bd->range - 1) * probability) >> 8);
-  big_split = split << 8 * (sizeof (bd->value) - sizeof (guint8));
-
-  if (bd->value < big_split) {
-    bd->range = split;
-    bit = FALSE;
-  } else {
-    bd->range -= split;
-    bd->value -= big_split;
-    bit = TRUE;
-  }
-
-  count = bool_shift_table[bd->range];
-  bd->range <<= count;
-  bd->value <<= count;
-  bd->count_to_fill += count;
-
-  return bit;
+  return gst_vpx_bool_decoder_read (bd, probability);
 }
 
-static guint
+static inline guint
 read_literal (Vp9BoolDecoder * bd, guint n)
 {
-  guint ret = 0;
-  guint i;
-
-  for (i = 0; G_UNLIKELY (!bd->out_of_bits) && i < n; i++) {
-    ret = 2 * ret + read_bool (bd, 128);
-  }
-
-  return ret;
+  return gst_vpx_bool_decoder_read_literal (bd, n);
 }
 
 static GstVp9ParserResult
@@ -277,12 +197,15 @@ init_bool (Vp9BoolDecoder * bd, GstBitReader * br, guint size_in_bytes)
   if ((gst_bit_reader_get_pos (br) % 8) != 0)
     GST_ERROR ("VP9 Boolean Decoder was passed an unaligned buffer");
 
-  bd->value = 0;
-  bd->range = 255;
-  bd->bits_left = 8 * size_in_bytes;
-  bd->bit_reader = br;
-  bd->count_to_fill = 8;
-  bd->out_of_bits = FALSE;
+  if (gst_bit_reader_get_remaining (br) < 8 * size_in_bytes) {
+    GST_ERROR ("Compressed header size %u exceeds the frame", size_in_bytes);
+    return GST_VP9_PARSER_BROKEN_DATA;
+  }
+
+  /* The bool decoder reads the bytes directly, the bit reader is moved
+   * past the compressed header once it was parsed */
+  gst_vpx_bool_decoder_init (bd,
+      br->data + gst_bit_reader_get_pos (br) / 8, size_in_bytes);
 
   marker_bit = read_literal (bd, 1);
   if (marker_bit != 0) {
@@ -294,24 +217,28 @@ init_bool (Vp9BoolDecoder * bd, GstBitReader * br, guint size_in_bytes)
 }
 
 static GstVp9ParserResult
-exit_bool (Vp9BoolDecoder * bd)
+exit_bool (Vp9BoolDecoder * bd, GstBitReader * br, guint size_in_bytes)
 {
-  guint8 padding;
-  guint8 bits = bd->bits_left;
-  guint8 n;
-
-  while (bits) {
-    n = MIN (bits, 8);
-    padding = gst_bit_reader_get_bits_uint32_unchecked (bd->bit_reader, n);
-    if (padding != 0 || (n < 8 && (padding & 0xe0) == 0xc0)) {
-      GST_ERROR
-          ("Invalid padding at end of frame. Total padding bits is %d and the wrong byte is: %x",
-          bd->bits_left, padding);
+  const guint8 *padding;
+
+  if (gst_vpx_bool_decoder_has_error (bd)) {
+    GST_ERROR
+        ("Invalid VP9 bitstream: the boolean decoder ran out of bits to read");
+    return GST_VP9_PARSER_BROKEN_DATA;
+  }
+
+  /* The bytes which were not loaded into the decoding window yet must be
+   * zero padding */
+  for (padding = bd->buffer; padding < bd->buffer_end; padding++) {
+    if (*padding != 0) {
+      GST_ERROR ("Invalid padding at end of frame, wrong byte is: %x",
+          *padding);
       return GST_VP9_PARSER_BROKEN_DATA;
     }
-    bits -= n;
   }
 
+  gst_bit_reader_skip_unchecked (br, 8 * size_in_bytes);
+
   return GST_VP9_PARSER_OK;
 }
 
@@ -684,7 +611,7 @@ parse_compressed_header (GstVp9StatefulParser * self, GstVp9FrameHeader * hdr,
       return rst;
   }
 
-  rst = exit_bool (&bd);
+  rst = exit_bool (&bd, br, hdr->header_size_in_bytes);
   if (rst != GST_VP9_PARSER_OK) {
     GST_ERROR ("The boolean decoder did not exit cleanly.");
     return rst;
@@ -0,0 +1,489 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Adds the features of a run of optical flow vectors to the sums of a
+ * grid cell.
+ *
+ * \param[in] vectors A pointer to the X and Y components of the first vector.
+ * \param[in] number_of_vectors The number of vectors in the run.
+ * \param[in] threshold The threshold the squared X and Y components have to
+ * exceed.
+ * \param[in] weight The number of pixels of the cell each vector covers.
+ * \param[in,out] sums A pointer to the sums of the cell, indexed by
+ * GstAlgorithmFeature.
+ */
+static void gst_algorithm_features_sum_vectors(
+    const gfloat *vectors,
+    guint number_of_vectors,
+    gfloat threshold,
+    gfloat weight,
+    gfloat *sums);
+
+/****************************** Static Variables ******************************/
+
+/**
+ * \brief The names of the features, indexed by GstAlgorithmFeature.
+ */
+static const gchar *feature_names[ALGORITHM_NUMBER_OF_FEATURES]
+    = {"Count",
+       "Pixels",
+       "X0-To-X1-Magnitude",
+       "X1-To-X0-Magnitude",
+       "Y0-To-Y1-Magnitude",
+       "Y1-To-Y0-Magnitude"};
+
+/**************************** Function Definitions ****************************/
+
+static inline guint ceil_div_guint(guint size, guint divisor)
+{
+    return ((size + divisor - 1) / (divisor));
+}
+
+GType gst_algorithm_feature_flags_get_type(void)
+{
+    static GType feature_flags_type = 0;
+    static const GFlagsValue feature_flags[]
+        = {{ALGORITHM_FEATURE_FLAG_COUNT,
+            "The number of pixels with a qualifying vector",
+            "count"},
+           {ALGORITHM_FEATURE_FLAG_PIXELS,
+            "The number of pixels covered by a vector",
+            "pixels"},
+           {ALGORITHM_FEATURE_FLAG_X0_TO_X1_MAGNITUDE,
+            "The sum of the qualifying positive X components",
+            "x0-to-x1-magnitude"},
+           {ALGORITHM_FEATURE_FLAG_X1_TO_X0_MAGNITUDE,
+            "The sum of the qualifying negative X components",
+            "x1-to-x0-magnitude"},
+           {ALGORITHM_FEATURE_FLAG_Y0_TO_Y1_MAGNITUDE,
+            "The sum of the qualifying positive Y components",
+            "y0-to-y1-magnitude"},
+           {ALGORITHM_FEATURE_FLAG_Y1_TO_Y0_MAGNITUDE,
+            "The sum of the qualifying negative Y components",
+            "y1-to-y0-magnitude"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&feature_flags_type))
+    {
+        GType new_type = g_flags_register_static(
+            g_intern_static_string("GstAlgorithmFeatureFlags"), feature_flags);
+        g_once_init_leave(&feature_flags_type, new_type);
+    }
+
+    return feature_flags_type;
+}
+
+const gchar *gst_algorithm_feature_get_name(GstAlgorithmFeature feature)
+{
+    g_return_val_if_fail(
+        (gint)feature >= 0 && feature < ALGORITHM_NUMBER_OF_FEATURES, NULL);
+
+    return feature_names[feature];
+}
+
+guint gst_algorithm_features_get_number_of_planes(guint feature_mask)
+{
+    guint number_of_planes = 1;
+
+    for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES; feature++)
+    {
+        if(feature_mask & (1u << feature))
+        {
+            number_of_planes++;
+        }
+    }
+
+    return number_of_planes;
+}
+
+gsize gst_algorithm_features_get_number_of_aggregates(
+    gsize number_of_features,
+    guint features_per_aggregation)
+{
+    return (number_of_features + features_per_aggregation - 1)
+           / features_per_aggregation;
+}
+
+void gst_algorithm_features_aggregate(
+    const gfloat *features,
+    gsize number_of_features,
+    guint features_per_aggregation,
+    gfloat *aggregates)
+{
+    gsize number_of_aggregates = gst_algorithm_features_get_number_of_aggregates(
+        number_of_features, features_per_aggregation);
+
+    for(gsize aggregate_idx = 0; aggregate_idx < number_of_aggregates;
+        aggregate_idx++)
+    {
+        gsize first = aggregate_idx * features_per_aggregation;
+        gsize last = MIN(first + features_per_aggregation, number_of_features);
+        gfloat maximum = 0.0f;
+
+        for(gsize idx = first; idx < last; idx++)
+        {
+            maximum = MAX(maximum, features[idx]);
+        }
+
+        aggregates[aggregate_idx] = maximum;
+    }
+}
+
+static void gst_algorithm_features_sum_vectors(
+    const gfloat *vectors,
+    guint number_of_vectors,
+    gfloat threshold,
+    gfloat weight,
+    gfloat *sums)
+{
+    gfloat count = 0.0f;
+    gfloat x_positive = 0.0f;
+    gfloat x_negative = 0.0f;
+    gfloat y_positive = 0.0f;
+    gfloat y_negative = 0.0f;
+    guint idx = 0;
+
+#if defined(__SSE2__)
+    /*
+     * A component that does not qualify is masked to zero, after which its
+     * positive and negative parts are split with MAX and MIN, so that no
+     * branches are needed per vector.
+     */
+    if(number_of_vectors >= 4)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 threshold_ps = _mm_set1_ps(threshold);
+        __m128 count_ps = zero;
+        __m128 x_positive_ps = zero;
+        __m128 x_negative_ps = zero;
+        __m128 y_positive_ps = zero;
+        __m128 y_negative_ps = zero;
+        gfloat lanes[4];
+
+        for(; idx + 4 <= number_of_vectors; idx += 4)
+        {
+            __m128 low = _mm_loadu_ps(vectors + 2 * idx);
+            __m128 high = _mm_loadu_ps(vectors + 2 * idx + 4);
+            __m128 x = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 y = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128 x_qualifies
+                = _mm_cmpgt_ps(_mm_mul_ps(x, x), threshold_ps);
+            __m128 y_qualifies
+                = _mm_cmpgt_ps(_mm_mul_ps(y, y), threshold_ps);
+
+            x = _mm_and_ps(x_qualifies, x);
+            y = _mm_and_ps(y_qualifies, y);
+
+            count_ps = _mm_add_ps(
+                count_ps, _mm_and_ps(_mm_or_ps(x_qualifies, y_qualifies), one));
+            x_positive_ps = _mm_add_ps(x_positive_ps, _mm_max_ps(x, zero));
+            x_negative_ps = _mm_sub_ps(x_negative_ps, _mm_min_ps(x, zero));
+            y_positive_ps = _mm_add_ps(y_positive_ps, _mm_max_ps(y, zero));
+            y_negative_ps = _mm_sub_ps(y_negative_ps, _mm_min_ps(y, zero));
+        }
+
+        _mm_storeu_ps(lanes, count_ps);
+        count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, x_positive_ps);
+        x_positive += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, x_negative_ps);
+        x_negative += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, y_positive_ps);
+        y_positive += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_storeu_ps(lanes, y_negative_ps);
+        y_negative += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(__ARM_NEON)
+    if(number_of_vectors >= 4)
+    {
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+        const float32x4_t threshold_ps = vdupq_n_f32(threshold);
+        float32x4_t count_ps = zero;
+        float32x4_t x_positive_ps = zero;
+        float32x4_t x_negative_ps = zero;
+        float32x4_t y_positive_ps = zero;
+        float32x4_t y_negative_ps = zero;
+
+        for(; idx + 4 <= number_of_vectors; idx += 4)
+        {
+            float32x4x2_t xy = vld2q_f32(vectors + 2 * idx);
+            uint32x4_t x_qualifies = vcgtq_f32(
+                vmulq_f32(xy.val[0], xy.val[0]), threshold_ps);
+            uint32x4_t y_qualifies = vcgtq_f32(
+                vmulq_f32(xy.val[1], xy.val[1]), threshold_ps);
+            float32x4_t x = vreinterpretq_f32_u32(
+                vandq_u32(x_qualifies, vreinterpretq_u32_f32(xy.val[0])));
+            float32x4_t y = vreinterpretq_f32_u32(
+                vandq_u32(y_qualifies, vreinterpretq_u32_f32(xy.val[1])));
+
+            count_ps = vaddq_f32(
+                count_ps,
+                vreinterpretq_f32_u32(
+                    vandq_u32(vorrq_u32(x_qualifies, y_qualifies), one)));
+            x_positive_ps = vaddq_f32(x_positive_ps, vmaxq_f32(x, zero));
+            x_negative_ps = vsubq_f32(x_negative_ps, vminq_f32(x, zero));
+            y_positive_ps = vaddq_f32(y_positive_ps, vmaxq_f32(y, zero));
+            y_negative_ps = vsubq_f32(y_negative_ps, vminq_f32(y, zero));
+        }
+
+        count += vgetq_lane_f32(count_ps, 0) + vgetq_lane_f32(count_ps, 1)
+                 + vgetq_lane_f32(count_ps, 2) + vgetq_lane_f32(count_ps, 3);
+        x_positive += vgetq_lane_f32(x_positive_ps, 0)
+                      + vgetq_lane_f32(x_positive_ps, 1)
+                      + vgetq_lane_f32(x_positive_ps, 2)
+                      + vgetq_lane_f32(x_positive_ps, 3);
+        x_negative += vgetq_lane_f32(x_negative_ps, 0)
+                      + vgetq_lane_f32(x_negative_ps, 1)
+                      + vgetq_lane_f32(x_negative_ps, 2)
+                      + vgetq_lane_f32(x_negative_ps, 3);
+        y_positive += vgetq_lane_f32(y_positive_ps, 0)
+                      + vgetq_lane_f32(y_positive_ps, 1)
+                      + vgetq_lane_f32(y_positive_ps, 2)
+                      + vgetq_lane_f32(y_positive_ps, 3);
+        y_negative += vgetq_lane_f32(y_negative_ps, 0)
+                      + vgetq_lane_f32(y_negative_ps, 1)
+                      + vgetq_lane_f32(y_negative_ps, 2)
+                      + vgetq_lane_f32(y_negative_ps, 3);
+    }
+#endif
+
+    for(; idx < number_of_vectors; idx++)
+    {
+        gfloat x = vectors[2 * idx];
+        gfloat y = vectors[2 * idx + 1];
+        gboolean x_qualifies = x * x > threshold;
+        gboolean y_qualifies = y * y > threshold;
+
+        if(x_qualifies || y_qualifies)
+        {
+            count += 1.0f;
+        }
+
+        if(x_qualifies)
+        {
+            if(x >= 0.0f)
+            {
+                x_positive += x;
+            }
+            else
+            {
+                x_negative -= x;
+            }
+        }
+
+        if(y_qualifies)
+        {
+            if(y >= 0.0f)
+            {
+                y_positive += y;
+            }
+            else
+            {
+                y_negative -= y;
+            }
+        }
+    }
+
+    sums[ALGORITHM_FEATURE_COUNT] += weight * count;
+    sums[ALGORITHM_FEATURE_PIXELS] += weight * (gfloat)number_of_vectors;
+    sums[ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE] += weight * x_positive;
+    sums[ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE] += weight * x_negative;
+    sums[ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE] += weight * y_positive;
+    sums[ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE] += weight * y_negative;
+}
+
+void gst_algorithm_features_extract(
+    const guint8 *flow,
+    gsize stride,
+    gsize elem_size,
+    guint flow_width,
+    guint flow_height,
+    guint grid_size,
+    guint frame_width,
+    guint frame_height,
+    guint cell_width,
+    guint cell_height,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    gfloat threshold,
+    guint feature_mask,
+    gfloat *features)
+{
+    gsize plane_size = (gsize)features_matrix_width * features_matrix_height;
+    guint number_of_planes
+        = gst_algorithm_features_get_number_of_planes(feature_mask);
+    guint vectors_per_row = 0;
+    guint number_of_rows = 0;
+    guint pixels_per_row = 0;
+    gfloat *row_sums = NULL;
+    gfloat *converted_vectors = NULL;
+
+    g_return_if_fail(features != NULL || plane_size == 0);
+    g_return_if_fail(grid_size > 0 && cell_width > 0 && cell_height > 0);
+    g_return_if_fail(
+        elem_size == 2 * sizeof(gint16) || elem_size == 2 * sizeof(gfloat));
+
+    if(plane_size == 0)
+    {
+        return;
+    }
+
+    memset(features, 0, sizeof(gfloat) * plane_size * number_of_planes);
+
+    /*
+     * Only the vectors covering a pixel of the frame contribute, as the last
+     * vector of a row or column may be partially outside of the frame.
+     */
+    vectors_per_row = MIN(flow_width, ceil_div_guint(frame_width, grid_size));
+    number_of_rows = MIN(flow_height, ceil_div_guint(frame_height, grid_size));
+    pixels_per_row = MIN(frame_width, vectors_per_row * grid_size);
+
+    if(flow == NULL || vectors_per_row == 0 || number_of_rows == 0)
+    {
+        return;
+    }
+
+    row_sums = g_new(gfloat, features_matrix_width * ALGORITHM_NUMBER_OF_FEATURES);
+
+    if(elem_size == 2 * sizeof(gint16))
+    {
+        converted_vectors = g_new(gfloat, 2 * vectors_per_row);
+    }
+
+    for(guint row = 0; row < number_of_rows; row++)
+    {
+        const gfloat *vectors = (const gfloat *)(flow + stride * row);
+        guint y_limit = MIN(frame_height, (row + 1) * grid_size);
+
+        if(converted_vectors != NULL)
+        {
+            const gint16 *fixed_point_vectors
+                = (const gint16 *)(flow + stride * row);
+
+            for(guint idx = 0; idx < 2 * vectors_per_row; idx++)
+            {
+                converted_vectors[idx]
+                    = fixed_point_vectors[idx] / (gfloat)(1 << 5);
+            }
+
+            vectors = converted_vectors;
+        }
+
+        memset(
+            row_sums,
+            0,
+            sizeof(gfloat) * features_matrix_width
+                * ALGORITHM_NUMBER_OF_FEATURES);
+
+        /*
+         * The row of vectors is summed once per grid cell column, with the
+         * vectors straddling a column boundary weighted by the number of
+         * their pixels on either side of it.
+         */
+        for(guint x_start = 0; x_start < pixels_per_row;)
+        {
+            guint column = x_start / cell_width;
+            guint x_end = column + 1 >= features_matrix_width
+                              ? pixels_per_row
+                              : MIN((column + 1) * cell_width, pixels_per_row);
+            guint first_vector = x_start / grid_size;
+            guint last_vector = (x_end - 1) / grid_size;
+            gfloat *sums
+                = row_sums
+                  + (gsize)MIN(column, features_matrix_width - 1)
+                        * ALGORITHM_NUMBER_OF_FEATURES;
+
+            if(first_vector == last_vector)
+            {
+                gst_algorithm_features_sum_vectors(
+                    vectors + 2 * first_vector,
+                    1,
+                    threshold,
+                    (gfloat)(x_end - x_start),
+                    sums);
+            }
+            else
+            {
+                gst_algorithm_features_sum_vectors(
+                    vectors + 2 * first_vector,
+                    1,
+                    threshold,
+                    (gfloat)((first_vector + 1) * grid_size - x_start),
+                    sums);
+                gst_algorithm_features_sum_vectors(
+                    vectors + 2 * (first_vector + 1),
+                    last_vector - first_vector - 1,
+                    threshold,
+                    (gfloat)grid_size,
+                    sums);
+                gst_algorithm_features_sum_vectors(
+                    vectors + 2 * last_vector,
+                    1,
+                    threshold,
+                    (gfloat)(x_end - last_vector * grid_size),
+                    sums);
+            }
+
+            x_start = x_end;
+        }
+
+        for(guint y_start = row * grid_size; y_start < y_limit;)
+        {
+            guint cell_row = y_start / cell_height;
+            guint y_end = cell_row + 1 >= features_matrix_height
+                              ? y_limit
+                              : MIN((cell_row + 1) * cell_height, y_limit);
+            gfloat weight = (gfloat)(y_end - y_start);
+            gfloat *cell_features
+                = features
+                  + (gsize)MIN(cell_row, features_matrix_height - 1)
+                        * features_matrix_width;
+
+            for(guint column = 0; column < features_matrix_width; column++)
+            {
+                const gfloat *sums
+                    = row_sums + (gsize)column * ALGORITHM_NUMBER_OF_FEATURES;
+                gsize plane_offset = plane_size;
+
+                cell_features[column]
+                    += weight
+                       * (sums[ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE]
+                          + sums[ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE]
+                          + sums[ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE]
+                          + sums[ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE]);
+
+                for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES;
+                    feature++)
+                {
+                    if(feature_mask & (1u << feature))
+                    {
+                        cell_features[plane_offset + column]
+                            += weight * sums[feature];
+                        plane_offset += plane_size;
+                    }
+                }
+            }
+
+            y_start = y_end;
+        }
+    }
+
+    g_free(converted_vectors);
+    g_free(row_sums);
+}
+
+/******************************************************************************/
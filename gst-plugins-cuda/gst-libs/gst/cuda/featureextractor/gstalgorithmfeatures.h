@@ -0,0 +1,194 @@
+#ifndef __GST_ALGORITHM_FEATURES_H__
+#define __GST_ALGORITHM_FEATURES_H__
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_ALGORITHM_FEATURE_FLAGS \
+    (gst_algorithm_feature_flags_get_type())
+
+/**
+ * \brief An enumeration containing the list of features extracted for each
+ * grid cell of a frame.
+ *
+ * \details A pixel of the frame takes the optical flow vector it lies in. A
+ * component of the vector only qualifies for a feature if its square exceeds
+ * the magnitude quadrant threshold.
+ */
+typedef enum _GstAlgorithmFeature
+{
+    /**
+     * \brief The number of pixels with either component of their vector
+     * qualifying.
+     */
+    ALGORITHM_FEATURE_COUNT = 0,
+    /**
+     * \brief The number of pixels covered by an optical flow vector.
+     */
+    ALGORITHM_FEATURE_PIXELS = 1,
+    /**
+     * \brief The sum of the qualifying positive X components.
+     */
+    ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE = 2,
+    /**
+     * \brief The sum of the absolute qualifying negative X components.
+     */
+    ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE = 3,
+    /**
+     * \brief The sum of the qualifying positive Y components.
+     */
+    ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE = 4,
+    /**
+     * \brief The sum of the absolute qualifying negative Y components.
+     */
+    ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE = 5,
+    /**
+     * \brief The number of features in this enumeration.
+     */
+    ALGORITHM_NUMBER_OF_FEATURES = 6,
+
+} GstAlgorithmFeature;
+
+/**
+ * \brief A set of flags selecting which of the GstAlgorithmFeature features
+ * are extracted.
+ */
+typedef enum _GstAlgorithmFeatureFlags
+{
+    ALGORITHM_FEATURE_FLAG_COUNT = (1 << ALGORITHM_FEATURE_COUNT),
+    ALGORITHM_FEATURE_FLAG_PIXELS = (1 << ALGORITHM_FEATURE_PIXELS),
+    ALGORITHM_FEATURE_FLAG_X0_TO_X1_MAGNITUDE
+    = (1 << ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE),
+    ALGORITHM_FEATURE_FLAG_X1_TO_X0_MAGNITUDE
+    = (1 << ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE),
+    ALGORITHM_FEATURE_FLAG_Y0_TO_Y1_MAGNITUDE
+    = (1 << ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE),
+    ALGORITHM_FEATURE_FLAG_Y1_TO_Y0_MAGNITUDE
+    = (1 << ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE),
+    ALGORITHM_FEATURE_FLAGS_ALL = ((1 << ALGORITHM_NUMBER_OF_FEATURES) - 1),
+
+} GstAlgorithmFeatureFlags;
+
+/**
+ * \brief Type creation/retrieval function for the GstAlgorithmFeatureFlags
+ * flags type.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstAlgorithmFeatureFlags flags type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_algorithm_feature_flags_get_type(void);
+
+/**
+ * \brief Retrieves the name of a feature, as used in the JSON output of the
+ * feature extractor.
+ *
+ * \param[in] feature The feature.
+ *
+ * \returns The name of the feature, e.g. "X0-To-X1-Magnitude".
+ */
+extern __attribute__((visibility("default"))) const gchar *
+gst_algorithm_feature_get_name(GstAlgorithmFeature feature);
+
+/**
+ * \brief Retrieves the number of feature planes extracted for a feature mask.
+ *
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the features.
+ *
+ * \returns One plane for the spatial magnitude, plus one per selected
+ * feature.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_algorithm_features_get_number_of_planes(guint feature_mask);
+
+/**
+ * \brief Extracts the features of every grid cell of an optical flow matrix
+ * on the host.
+ *
+ * \details This matches the feature extractor kernel of cudafeatureextractor,
+ * with SSE2 or NEON instructions classifying four vectors at a time where
+ * available. The pixel at x belongs to the column `x / cell_width`, and uses
+ * the vector at `x / grid_size`.
+ *
+ * \details The features are written as planes of features_matrix_width *
+ * features_matrix_height cells in row-major order. The first plane holds the
+ * spatial magnitude, which is the sum of the four magnitude features. It is
+ * followed by one plane per feature selected by feature_mask, in the order of
+ * GstAlgorithmFeature.
+ *
+ * \param[in] flow A pointer to the first row of the optical flow matrix.
+ * \param[in] stride The number of bytes between two rows of the matrix.
+ * \param[in] elem_size The size of a vector; 4 for 16-bit S10.5 fixed point
+ * vectors, or 8 for 32-bit floating point vectors.
+ * \param[in] flow_width The number of vectors per row of the matrix.
+ * \param[in] flow_height The number of rows of the matrix.
+ * \param[in] grid_size The number of pixels per vector in each direction.
+ * \param[in] frame_width The number of columns of the frame.
+ * \param[in] frame_height The number of rows of the frame.
+ * \param[in] cell_width The number of columns of pixels per grid cell.
+ * \param[in] cell_height The number of rows of pixels per grid cell.
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] threshold The threshold the squared X and Y components have to
+ * exceed.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the features to
+ * extract.
+ * \param[out] features A pointer to room for
+ * gst_algorithm_features_get_number_of_planes() planes.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_extract(
+    const guint8 *flow,
+    gsize stride,
+    gsize elem_size,
+    guint flow_width,
+    guint flow_height,
+    guint grid_size,
+    guint frame_width,
+    guint frame_height,
+    guint cell_width,
+    guint cell_height,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    gfloat threshold,
+    guint feature_mask,
+    gfloat *features);
+
+/**
+ * \brief Retrieves the number of aggregates a features array is reduced to.
+ *
+ * \param[in] number_of_features The number of features in the array.
+ * \param[in] features_per_aggregation The number of features per aggregate.
+ *
+ * \returns The number of aggregates, rounded up.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_algorithm_features_get_number_of_aggregates(
+    gsize number_of_features,
+    guint features_per_aggregation);
+
+/**
+ * \brief Aggregates a features array using the MAX aggregation operator.
+ *
+ * \details Every run of features_per_aggregation features is reduced to its
+ * maximum, with the last run holding whatever features remain. This writes
+ * into memory provided by the caller, so it does not allocate.
+ *
+ * \param[in] features A pointer to the features array.
+ * \param[in] number_of_features The number of features in the array.
+ * \param[in] features_per_aggregation The number of features per aggregate.
+ * \param[out] aggregates A pointer to room for
+ * gst_algorithm_features_get_number_of_aggregates() aggregates.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_aggregate(
+    const gfloat *features,
+    gsize number_of_features,
+    guint features_per_aggregation,
+    gfloat *aggregates);
+
+G_END_DECLS
+
+#endif
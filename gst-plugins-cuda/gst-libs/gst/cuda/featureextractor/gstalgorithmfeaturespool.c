@@ -0,0 +1,160 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/featureextractor/gstalgorithmfeaturespool.h>
+
+/************************** Type/Struct Definitions ***************************/
+
+/**
+ * \brief The header of a free slab, linking it to the next free slab.
+ *
+ * \details The header overlays the start of the slab, so slabs are never
+ * smaller than it.
+ */
+typedef struct _GstAlgorithmFeaturesSlab
+{
+    struct _GstAlgorithmFeaturesSlab *next;
+} GstAlgorithmFeaturesSlab;
+
+struct _GstAlgorithmFeaturesPool
+{
+    /**
+     * \brief The number of references to the pool, modified atomically.
+     */
+    gint ref_count;
+
+    /**
+     * \brief The number of bytes of each slab.
+     */
+    gsize slab_size;
+
+    /**
+     * \brief Protects free_slabs and number_of_slabs.
+     */
+    GMutex lock;
+
+    /**
+     * \brief The most recently released slab, or NULL if none are free.
+     */
+    GstAlgorithmFeaturesSlab *free_slabs;
+
+    /**
+     * \brief The number of slabs allocated, whether they are free or not.
+     */
+    guint number_of_slabs;
+};
+
+/**************************** Function Definitions ****************************/
+
+GstAlgorithmFeaturesPool *gst_algorithm_features_pool_new(gsize slab_size)
+{
+    GstAlgorithmFeaturesPool *pool = g_new0(GstAlgorithmFeaturesPool, 1);
+
+    pool->ref_count = 1;
+    pool->slab_size = MAX(slab_size, sizeof(GstAlgorithmFeaturesSlab));
+    pool->free_slabs = NULL;
+    pool->number_of_slabs = 0;
+    g_mutex_init(&pool->lock);
+
+    return pool;
+}
+
+GstAlgorithmFeaturesPool *
+gst_algorithm_features_pool_ref(GstAlgorithmFeaturesPool *pool)
+{
+    g_return_val_if_fail(pool != NULL, NULL);
+
+    g_atomic_int_inc(&pool->ref_count);
+
+    return pool;
+}
+
+void gst_algorithm_features_pool_unref(GstAlgorithmFeaturesPool *pool)
+{
+    g_return_if_fail(pool != NULL);
+
+    if(!g_atomic_int_dec_and_test(&pool->ref_count))
+    {
+        return;
+    }
+
+    /*
+     * The slabs still acquired hold a reference each, so every slab is free
+     * by the time the last reference is dropped.
+     */
+    while(pool->free_slabs != NULL)
+    {
+        GstAlgorithmFeaturesSlab *slab = pool->free_slabs;
+
+        pool->free_slabs = slab->next;
+        g_free(slab);
+    }
+
+    g_mutex_clear(&pool->lock);
+    g_free(pool);
+}
+
+gpointer gst_algorithm_features_pool_acquire(GstAlgorithmFeaturesPool *pool)
+{
+    GstAlgorithmFeaturesSlab *slab = NULL;
+
+    g_return_val_if_fail(pool != NULL, NULL);
+
+    g_mutex_lock(&pool->lock);
+
+    slab = pool->free_slabs;
+
+    if(slab != NULL)
+    {
+        pool->free_slabs = slab->next;
+    }
+    else
+    {
+        pool->number_of_slabs++;
+    }
+
+    g_mutex_unlock(&pool->lock);
+
+    if(slab == NULL)
+    {
+        slab = (GstAlgorithmFeaturesSlab *)g_malloc(pool->slab_size);
+    }
+
+    return slab;
+}
+
+void gst_algorithm_features_pool_release(GstAlgorithmFeaturesPool *pool, gpointer slab)
+{
+    GstAlgorithmFeaturesSlab *free_slab = (GstAlgorithmFeaturesSlab *)slab;
+
+    g_return_if_fail(pool != NULL);
+    g_return_if_fail(slab != NULL);
+
+    g_mutex_lock(&pool->lock);
+
+    free_slab->next = pool->free_slabs;
+    pool->free_slabs = free_slab;
+
+    g_mutex_unlock(&pool->lock);
+}
+
+gsize gst_algorithm_features_pool_get_slab_size(GstAlgorithmFeaturesPool *pool)
+{
+    g_return_val_if_fail(pool != NULL, 0);
+
+    return pool->slab_size;
+}
+
+guint gst_algorithm_features_pool_get_number_of_slabs(GstAlgorithmFeaturesPool *pool)
+{
+    guint number_of_slabs = 0;
+
+    g_return_val_if_fail(pool != NULL, 0);
+
+    g_mutex_lock(&pool->lock);
+    number_of_slabs = pool->number_of_slabs;
+    g_mutex_unlock(&pool->lock);
+
+    return number_of_slabs;
+}
+
+/******************************************************************************/
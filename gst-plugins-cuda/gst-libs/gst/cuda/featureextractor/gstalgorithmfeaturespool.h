@@ -0,0 +1,100 @@
+#ifndef __GST_ALGORITHM_FEATURES_POOL_H__
+#define __GST_ALGORITHM_FEATURES_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * \brief A pool of equally sized slabs of memory for the features of
+ * GstMetaAlgorithmFeatures instances.
+ *
+ * \details A slab released to the pool is kept on a free list and handed out
+ * again by the next acquisition, so once the pool holds as many slabs as
+ * there are frames in flight, acquiring and releasing slabs does not allocate.
+ * The free list is threaded through the released slabs themselves, so it
+ * never allocates either.
+ *
+ * \details The pool is reference counted. Every slab acquired from it should
+ * hold a reference to it, so that the slabs of buffers outliving the element
+ * that created them can still be released.
+ */
+typedef struct _GstAlgorithmFeaturesPool GstAlgorithmFeaturesPool;
+
+/**
+ * \brief Creates a pool of slabs.
+ *
+ * \param[in] slab_size The number of bytes of each slab.
+ *
+ * \returns A new GstAlgorithmFeaturesPool instance without any slabs, to be
+ * released with gst_algorithm_features_pool_unref().
+ */
+extern __attribute__((visibility("default"))) GstAlgorithmFeaturesPool *
+gst_algorithm_features_pool_new(gsize slab_size);
+
+/**
+ * \brief Adds a reference to a pool.
+ *
+ * \param[in] pool The pool.
+ *
+ * \returns The pool.
+ */
+extern __attribute__((visibility("default"))) GstAlgorithmFeaturesPool *
+gst_algorithm_features_pool_ref(GstAlgorithmFeaturesPool *pool);
+
+/**
+ * \brief Drops a reference to a pool, freeing it and its free slabs once the
+ * last one is gone.
+ *
+ * \param[in] pool The pool.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_pool_unref(GstAlgorithmFeaturesPool *pool);
+
+/**
+ * \brief Acquires a slab from a pool.
+ *
+ * \details The most recently released slab is reused, as it is the most
+ * likely to still be cached. A new slab is only allocated if none are free.
+ * The contents of the slab are undefined.
+ *
+ * \param[in] pool The pool.
+ *
+ * \returns A pointer to a slab of gst_algorithm_features_pool_get_slab_size()
+ * bytes, aligned for any type.
+ */
+extern __attribute__((visibility("default"))) gpointer
+gst_algorithm_features_pool_acquire(GstAlgorithmFeaturesPool *pool);
+
+/**
+ * \brief Releases a slab back to the pool it was acquired from.
+ *
+ * \param[in] pool The pool.
+ * \param[in] slab A slab acquired with gst_algorithm_features_pool_acquire().
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_pool_release(GstAlgorithmFeaturesPool *pool, gpointer slab);
+
+/**
+ * \brief Retrieves the size of the slabs of a pool.
+ *
+ * \param[in] pool The pool.
+ *
+ * \returns The number of bytes of each slab.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_algorithm_features_pool_get_slab_size(GstAlgorithmFeaturesPool *pool);
+
+/**
+ * \brief Retrieves the number of slabs a pool has allocated.
+ *
+ * \param[in] pool The pool.
+ *
+ * \returns The number of slabs allocated, whether they are free or not.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_algorithm_features_pool_get_number_of_slabs(GstAlgorithmFeaturesPool *pool);
+
+G_END_DECLS
+
+#endif
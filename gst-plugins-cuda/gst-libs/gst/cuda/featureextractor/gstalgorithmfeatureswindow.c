@@ -0,0 +1,310 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/featureextractor/gstalgorithmfeatureswindow.h>
+
+/************************** Type/Struct Definitions ***************************/
+
+struct _GstAlgorithmFeaturesWindow
+{
+    /**
+     * \brief The number of frames the window holds once full.
+     */
+    guint window_size;
+
+    /**
+     * \brief The number of features per frame.
+     */
+    gsize length;
+
+    /**
+     * \brief The number of frames between calculating the running sums again.
+     */
+    guint renormalisation_interval;
+
+    /**
+     * \brief The number of frames pushed since the running sums were last
+     * calculated again.
+     */
+    guint frames_since_renormalisation;
+
+    /**
+     * \brief The number of frames within the window.
+     */
+    guint number_of_frames;
+
+    /**
+     * \brief The slot of the ring buffer the next frame is written to, which
+     * holds the oldest frame once the window is full.
+     */
+    guint head;
+
+    /**
+     * \brief The ring buffer of window_size slots of length features.
+     */
+    gfloat *features;
+
+    /**
+     * \brief The running sum of each feature over the window.
+     */
+    gdouble *sums;
+
+    /**
+     * \brief The running sum of the square of each feature over the window.
+     */
+    gdouble *sums_of_squares;
+
+    /**
+     * \brief A queue of slots per feature, as a ring of window_size slots,
+     * with the values of the feature decreasing from the front to the back.
+     *
+     * \details The front of the queue is the slot holding the maximum. A frame
+     * can never be the maximum once a later frame has a greater or equal
+     * value, so it is dropped from the back when that frame is pushed.
+     */
+    guint *max_queues;
+
+    /**
+     * \brief The position of the front of the queue of each feature.
+     */
+    guint *max_queue_fronts;
+
+    /**
+     * \brief The number of slots in the queue of each feature.
+     */
+    guint *max_queue_sizes;
+};
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Calculates the running sums of a window again from its ring buffer,
+ * discarding the rounding errors accumulated by the incremental updates.
+ *
+ * \param[in,out] window The window.
+ */
+static void
+gst_algorithm_features_window_renormalise(GstAlgorithmFeaturesWindow *window);
+
+/**************************** Function Definitions ****************************/
+
+GstAlgorithmFeaturesWindow *gst_algorithm_features_window_new(
+    guint window_size,
+    gsize length,
+    guint renormalisation_interval)
+{
+    GstAlgorithmFeaturesWindow *window = NULL;
+
+    g_return_val_if_fail(window_size > 0, NULL);
+
+    window = g_new0(GstAlgorithmFeaturesWindow, 1);
+    window->window_size = window_size;
+    window->length = length;
+    window->renormalisation_interval
+        = renormalisation_interval > 0 ? renormalisation_interval : window_size;
+
+    window->features = g_new(gfloat, (gsize)window_size * length);
+    window->sums = g_new(gdouble, length);
+    window->sums_of_squares = g_new(gdouble, length);
+    window->max_queues = g_new(guint, (gsize)window_size * length);
+    window->max_queue_fronts = g_new(guint, length);
+    window->max_queue_sizes = g_new(guint, length);
+
+    gst_algorithm_features_window_reset(window);
+
+    return window;
+}
+
+void gst_algorithm_features_window_free(GstAlgorithmFeaturesWindow *window)
+{
+    if(window == NULL)
+    {
+        return;
+    }
+
+    g_free(window->features);
+    g_free(window->sums);
+    g_free(window->sums_of_squares);
+    g_free(window->max_queues);
+    g_free(window->max_queue_fronts);
+    g_free(window->max_queue_sizes);
+    g_free(window);
+}
+
+void gst_algorithm_features_window_reset(GstAlgorithmFeaturesWindow *window)
+{
+    g_return_if_fail(window != NULL);
+
+    window->number_of_frames = 0;
+    window->head = 0;
+    window->frames_since_renormalisation = 0;
+
+    for(gsize idx = 0; idx < window->length; idx++)
+    {
+        window->sums[idx] = 0.0;
+        window->sums_of_squares[idx] = 0.0;
+        window->max_queue_fronts[idx] = 0;
+        window->max_queue_sizes[idx] = 0;
+    }
+}
+
+void gst_algorithm_features_window_push(
+    GstAlgorithmFeaturesWindow *window,
+    const gfloat *features)
+{
+    g_return_if_fail(window != NULL);
+    g_return_if_fail(features != NULL || window->length == 0);
+
+    const guint window_size = window->window_size;
+    const guint slot = window->head;
+    const gboolean is_full = window->number_of_frames == window_size;
+    gfloat *slot_features = window->features + (gsize)slot * window->length;
+
+    for(gsize idx = 0; idx < window->length; idx++)
+    {
+        gfloat feature = features[idx];
+        guint *max_queue = window->max_queues + idx * window_size;
+        guint *front = &window->max_queue_fronts[idx];
+        guint *size = &window->max_queue_sizes[idx];
+
+        if(is_full)
+        {
+            gdouble oldest_feature = slot_features[idx];
+
+            window->sums[idx] -= oldest_feature;
+            window->sums_of_squares[idx] -= oldest_feature * oldest_feature;
+
+            /*
+             * The oldest frame is the only one leaving the window, and it can
+             * only be at the front of the queue if it is in it at all.
+             */
+            if(*size > 0 && max_queue[*front] == slot)
+            {
+                *front = (*front + 1) % window_size;
+                (*size)--;
+            }
+        }
+
+        while(*size > 0)
+        {
+            guint back = max_queue[(*front + *size - 1) % window_size];
+
+            if(window->features[(gsize)back * window->length + idx] > feature)
+            {
+                break;
+            }
+
+            (*size)--;
+        }
+
+        max_queue[(*front + *size) % window_size] = slot;
+        (*size)++;
+
+        slot_features[idx] = feature;
+        window->sums[idx] += feature;
+        window->sums_of_squares[idx] += (gdouble)feature * feature;
+    }
+
+    window->head = (slot + 1) % window_size;
+
+    if(!is_full)
+    {
+        window->number_of_frames++;
+    }
+
+    if(++window->frames_since_renormalisation
+       >= window->renormalisation_interval)
+    {
+        gst_algorithm_features_window_renormalise(window);
+    }
+}
+
+void gst_algorithm_features_window_get_statistics(
+    const GstAlgorithmFeaturesWindow *window,
+    gfloat *mean,
+    gfloat *max,
+    gfloat *variance)
+{
+    g_return_if_fail(window != NULL);
+
+    const guint number_of_frames = window->number_of_frames;
+
+    for(gsize idx = 0; idx < window->length; idx++)
+    {
+        if(number_of_frames == 0)
+        {
+            mean[idx] = 0.0f;
+            max[idx] = 0.0f;
+            variance[idx] = 0.0f;
+            continue;
+        }
+
+        gdouble feature_mean = window->sums[idx] / number_of_frames;
+        gdouble feature_variance
+            = window->sums_of_squares[idx] / number_of_frames
+              - feature_mean * feature_mean;
+        guint max_slot = window->max_queues
+                             [idx * window->window_size
+                              + window->max_queue_fronts[idx]];
+
+        mean[idx] = (gfloat)feature_mean;
+        max[idx] = window->features[(gsize)max_slot * window->length + idx];
+        /* Rounding can leave a tiny negative variance for constant features */
+        variance[idx] = (gfloat)MAX(feature_variance, 0.0);
+    }
+}
+
+guint gst_algorithm_features_window_get_number_of_frames(
+    const GstAlgorithmFeaturesWindow *window)
+{
+    g_return_val_if_fail(window != NULL, 0);
+
+    return window->number_of_frames;
+}
+
+guint gst_algorithm_features_window_get_window_size(
+    const GstAlgorithmFeaturesWindow *window)
+{
+    g_return_val_if_fail(window != NULL, 0);
+
+    return window->window_size;
+}
+
+gsize gst_algorithm_features_window_get_length(
+    const GstAlgorithmFeaturesWindow *window)
+{
+    g_return_val_if_fail(window != NULL, 0);
+
+    return window->length;
+}
+
+static void
+gst_algorithm_features_window_renormalise(GstAlgorithmFeaturesWindow *window)
+{
+    window->frames_since_renormalisation = 0;
+
+    for(gsize idx = 0; idx < window->length; idx++)
+    {
+        window->sums[idx] = 0.0;
+        window->sums_of_squares[idx] = 0.0;
+    }
+
+    /*
+     * The slots are summed in order, so that it only takes one pass over the
+     * ring buffer in the order it is stored in memory.
+     */
+    for(guint slot = 0; slot < window->number_of_frames; slot++)
+    {
+        const gfloat *slot_features
+            = window->features + (gsize)slot * window->length;
+
+        for(gsize idx = 0; idx < window->length; idx++)
+        {
+            gdouble feature = slot_features[idx];
+
+            window->sums[idx] += feature;
+            window->sums_of_squares[idx] += feature * feature;
+        }
+    }
+}
+
+/******************************************************************************/
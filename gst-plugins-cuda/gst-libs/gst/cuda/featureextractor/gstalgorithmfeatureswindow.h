@@ -0,0 +1,129 @@
+#ifndef __GST_ALGORITHM_FEATURES_WINDOW_H__
+#define __GST_ALGORITHM_FEATURES_WINDOW_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * \brief The mean, maximum and variance of an array of features over a
+ * sliding window of frames, updated incrementally as each frame is pushed.
+ *
+ * \details The features of the frames within the window are kept in a ring
+ * buffer. The mean and the variance come from running sums of the features
+ * and of their squares: the features of the frame leaving the window are
+ * subtracted as the features of the new frame are added. The maximum comes
+ * from a monotonic queue of frames per feature, so each frame is added to
+ * and removed from a queue at most once.
+ *
+ * \details Pushing a frame and retrieving the statistics are O(1) per
+ * feature, and neither allocates. Subtracting from the running sums slowly
+ * accumulates rounding errors, so they are calculated again from the ring
+ * buffer every renormalisation interval frames, which is O(1) per feature
+ * and frame on average when the interval is at least the window size.
+ */
+typedef struct _GstAlgorithmFeaturesWindow GstAlgorithmFeaturesWindow;
+
+/**
+ * \brief Creates an empty sliding window.
+ *
+ * \param[in] window_size The number of frames in the window.
+ * \param[in] length The number of features per frame.
+ * \param[in] renormalisation_interval The number of frames between
+ * calculating the running sums again from the ring buffer, or 0 for the
+ * window size.
+ *
+ * \returns A new GstAlgorithmFeaturesWindow instance, to be released with
+ * gst_algorithm_features_window_free().
+ */
+extern __attribute__((visibility("default"))) GstAlgorithmFeaturesWindow *
+gst_algorithm_features_window_new(
+    guint window_size,
+    gsize length,
+    guint renormalisation_interval);
+
+/**
+ * \brief Releases a sliding window.
+ *
+ * \param[in] window The window, or NULL.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_window_free(GstAlgorithmFeaturesWindow *window);
+
+/**
+ * \brief Removes every frame from a sliding window, e.g. after a
+ * discontinuity.
+ *
+ * \param[in,out] window The window.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_window_reset(GstAlgorithmFeaturesWindow *window);
+
+/**
+ * \brief Pushes the features of a frame into a sliding window, removing the
+ * oldest frame once the window is full.
+ *
+ * \param[in,out] window The window.
+ * \param[in] features A pointer to the features of the frame.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_window_push(
+    GstAlgorithmFeaturesWindow *window,
+    const gfloat *features);
+
+/**
+ * \brief Retrieves the statistics of every feature over the frames within a
+ * sliding window.
+ *
+ * \details The variance is the population variance of the frames within the
+ * window. Every statistic is 0 if the window is empty.
+ *
+ * \param[in] window The window.
+ * \param[out] mean A pointer to room for the mean of each feature.
+ * \param[out] max A pointer to room for the maximum of each feature.
+ * \param[out] variance A pointer to room for the variance of each feature.
+ */
+extern __attribute__((visibility("default"))) void
+gst_algorithm_features_window_get_statistics(
+    const GstAlgorithmFeaturesWindow *window,
+    gfloat *mean,
+    gfloat *max,
+    gfloat *variance);
+
+/**
+ * \brief Retrieves the number of frames within a sliding window.
+ *
+ * \param[in] window The window.
+ *
+ * \returns The number of frames pushed since the window was created or
+ * reset, up to the window size.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_algorithm_features_window_get_number_of_frames(
+    const GstAlgorithmFeaturesWindow *window);
+
+/**
+ * \brief Retrieves the size of a sliding window.
+ *
+ * \param[in] window The window.
+ *
+ * \returns The number of frames the window holds once full.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_algorithm_features_window_get_window_size(
+    const GstAlgorithmFeaturesWindow *window);
+
+/**
+ * \brief Retrieves the number of features per frame of a sliding window.
+ *
+ * \param[in] window The window.
+ *
+ * \returns The number of features per frame.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_algorithm_features_window_get_length(
+    const GstAlgorithmFeaturesWindow *window);
+
+G_END_DECLS
+
+#endif
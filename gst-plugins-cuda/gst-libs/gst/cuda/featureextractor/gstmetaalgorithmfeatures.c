@@ -2,6 +2,8 @@
 
 #include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
 
+#include <string.h>
+
 /*
  * Just some setup for the GStreamer debug logger.
  *
@@ -10,6 +12,22 @@
 GST_DEBUG_CATEGORY_STATIC(gst_meta_algorithm_features_debug);
 #define GST_CAT_DEFAULT gst_meta_algorithm_features_debug
 
+/**
+ * \brief The magic number at the start of serialised metadata, "GAFT".
+ */
+#define GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAGIC 0x54464147u
+
+/**
+ * \brief The number of bytes of the header of serialised metadata.
+ */
+#define GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE 28u
+
+/**
+ * \brief The largest number of columns or rows of grid cells, and of regions
+ * of interest, of deserialised metadata.
+ */
+#define GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAX_DIMENSION G_MAXUINT16
+
 /************************** Type/Struct Definitions ***************************/
 
 /*************************** Function Declarations ****************************/
@@ -18,8 +36,8 @@ GST_DEBUG_CATEGORY_STATIC(gst_meta_algorithm_features_debug);
  * \brief Initialises an instance of the GstMetaAlgorithmFeatures metadata type.
  *
  * \details This method is used as an override for the `init` method for the
- * GstMetaAlgorithmFeatures metadata type. Specifically, it sets the pointer to
- * the FeatureExtractorCUDA::FeaturesMatrix instance to a nullptr.
+ * GstMetaAlgorithmFeatures metadata type. Specifically, it clears the layout
+ * and sets the pointers to the arrays to NULL.
  *
  * \param[in,out] meta A pointer to the GstMetaAlgorithmFeatures instance.
  * \param[in] params A pointer to a structure containing a list of parameters
@@ -38,9 +56,8 @@ static gboolean gst_meta_algorithm_features_init(
  * \brief Cleans up an instance of the GstMetaAlgorithmFeatures metadata type.
  *
  * \details This method is used as an override for the `free` method for the
- * GstMetaAlgorithmFeatures metadata type. Specifically, it deletes the pointer
- * to the the FeatureExtractorCUDA::FeaturesMatrix instance and sets it to
- * nullptr.
+ * GstMetaAlgorithmFeatures metadata type. Specifically, it releases the slab
+ * holding the arrays back to its pool.
  *
  * \param[in,out] meta A pointer to the GstMetaAlgorithmFeatures instance.
  * \param[in] buf A pointer to the buffer that the GstMetaAlgorithmFeatures
@@ -58,10 +75,8 @@ static void gst_meta_algorithm_features_free(GstMeta *meta, GstBuffer *buf);
  *
  * \details For the "copy" transformation type, a new instance of the
  * GstMetaAlgorithmFeatures metadata type is created on the new buffer
- * (transbuf). The pointer to the existing FeatureExtractorCUDA::FeaturesMatrix
- * instance is then assigned to the new GstMetaAlgorithmFeatures instance,
- * increasing the reference count to the FeatureExtractorCUDA::FeaturesMatrix
- * instance.
+ * (transbuf). The new instance acquires a slab from the pool of the existing
+ * instance with the same layout, and the arrays are copied into it.
  *
  * \param[in,out] transbuf The buffer to perform the "copy" transformation
  * onto.
@@ -79,6 +94,91 @@ static gboolean gst_meta_algorithm_features_transform(
     GQuark type,
     gpointer data);
 
+/**
+ * \brief Releases the slab of a GstMetaAlgorithmFeatures instance, and sets
+ * the pointers to the arrays to NULL.
+ *
+ * \param[in,out] algorithm_features_meta A pointer to the
+ * GstMetaAlgorithmFeatures instance.
+ */
+static void gst_meta_algorithm_features_clear(
+    GstMetaAlgorithmFeatures *algorithm_features_meta);
+
+/**
+ * \brief Copies 32-bit words between host and little-endian byte order.
+ *
+ * \details Every value of the slab is a 32-bit gfloat or gint32, so the slab
+ * is copied as is on little-endian hosts, and with each word byte-swapped on
+ * big-endian hosts.
+ *
+ * \param[out] destination A pointer to room for the words.
+ * \param[in] source A pointer to the words.
+ * \param[in] number_of_words The number of words to copy.
+ */
+static void gst_meta_algorithm_features_copy_words_le(
+    guint8 *destination,
+    const guint8 *source,
+    gsize number_of_words);
+
+/**
+ * \brief Calculates the size of the slab of a layout read from serialised
+ * metadata, guarding against it overflowing.
+ *
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] features_per_aggregation The number of grid cells per aggregate.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the feature arrays.
+ * \param[in] number_of_rois The number of regions of interest.
+ * \param[out] slab_size The number of bytes of the slab.
+ *
+ * \returns TRUE if the layout is valid, FALSE if it exceeds the limits of
+ * deserialised metadata or its size does not fit in a gsize.
+ */
+static gboolean gst_meta_algorithm_features_get_checked_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois,
+    gsize *slab_size);
+
+#if GST_CHECK_VERSION(1, 24, 0)
+/**
+ * \brief Serialises an instance of the GstMetaAlgorithmFeatures metadata type
+ * for GStreamer, e.g. for the unixfdsink element.
+ *
+ * \param[in] meta A pointer to the GstMetaAlgorithmFeatures instance.
+ * \param[in,out] data The byte array to append the serialised metadata to.
+ * \param[out] version The version of the serialised metadata.
+ *
+ * \returns TRUE if the metadata was serialised, FALSE otherwise.
+ */
+static gboolean gst_meta_algorithm_features_serialize_func(
+    const GstMeta *meta,
+    GstByteArrayInterface *data,
+    guint8 *version);
+
+/**
+ * \brief Deserialises an instance of the GstMetaAlgorithmFeatures metadata
+ * type for GStreamer, e.g. for the unixfdsrc element.
+ *
+ * \param[in] info The GstMetaInfo of the GstMetaAlgorithmFeatures type.
+ * \param[in,out] buffer The buffer to add the metadata to.
+ * \param[in] data A pointer to the serialised metadata.
+ * \param[in] size The number of bytes of the serialised metadata.
+ * \param[in] version The version of the serialised metadata.
+ *
+ * \returns The GstMetaAlgorithmFeatures instance added to the buffer, or NULL
+ * if the data is not valid.
+ */
+static GstMeta *gst_meta_algorithm_features_deserialize_func(
+    const GstMetaInfo *info,
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    guint8 version);
+#endif
+
 /****************************** Static Variables ******************************/
 
 /************************** GObject Type Definitions **************************/
@@ -104,14 +204,36 @@ const GstMetaInfo *gst_meta_algorithm_features_get_info(void)
 {
     static const GstMetaInfo *meta_algorithm_features_info = NULL;
 
-    GST_DEBUG_CATEGORY_INIT(
-        gst_meta_algorithm_features_debug,
-        "GstMetaAlgorithmFeatures",
-        0,
-        "GStreamer CUDA Algorithm Features Metadata");
-
+    /*
+     * This is called every time the metadata is added to a buffer, so the
+     * debug category is only initialised once, as initialising it allocates.
+     */
     if(g_once_init_enter((GstMetaInfo **)&meta_algorithm_features_info))
     {
+        GST_DEBUG_CATEGORY_INIT(
+            gst_meta_algorithm_features_debug,
+            "GstMetaAlgorithmFeatures",
+            0,
+            "GStreamer CUDA Algorithm Features Metadata");
+
+#if GST_CHECK_VERSION(1, 24, 0)
+        /*
+         * GStreamer 1.24 onwards can carry metadata across process boundaries
+         * if it knows how to serialise it, so the serialisation is registered
+         * along with the rest of the metadata type.
+         */
+        GstMetaInfo *info = gst_meta_info_new(
+            GST_META_ALGORITHM_FEATURES_API_TYPE,
+            "GstMetaAlgorithmFeatures",
+            sizeof(GstMetaAlgorithmFeatures));
+        info->init_func = gst_meta_algorithm_features_init;
+        info->free_func = gst_meta_algorithm_features_free;
+        info->transform_func = gst_meta_algorithm_features_transform;
+        info->serialize_func = gst_meta_algorithm_features_serialize_func;
+        info->deserialize_func = gst_meta_algorithm_features_deserialize_func;
+
+        const GstMetaInfo *mi = gst_meta_info_register(info);
+#else
         const GstMetaInfo *mi = gst_meta_register(
             GST_META_ALGORITHM_FEATURES_API_TYPE,
             "GstMetaAlgorithmFeatures",
@@ -119,6 +241,7 @@ const GstMetaInfo *gst_meta_algorithm_features_get_info(void)
             gst_meta_algorithm_features_init,
             gst_meta_algorithm_features_free,
             gst_meta_algorithm_features_transform);
+#endif
         g_once_init_leave(
             (GstMetaInfo **)&meta_algorithm_features_info, (GstMetaInfo *)mi);
     }
@@ -139,7 +262,9 @@ gst_meta_algorithm_features_init(GstMeta *meta, gpointer params, GstBuffer *buf)
         meta,
         buf);
 
-    algorithm_features_meta->features = NULL;
+    algorithm_features_meta->pool = NULL;
+    algorithm_features_meta->slab = NULL;
+    gst_meta_algorithm_features_clear(algorithm_features_meta);
 
     return TRUE;
 }
@@ -156,11 +281,7 @@ static void gst_meta_algorithm_features_free(GstMeta *meta, GstBuffer *buf)
         meta,
         buf);
 
-    if(algorithm_features_meta->features != NULL)
-    {
-        g_array_unref(algorithm_features_meta->features);
-        algorithm_features_meta->features = NULL;
-    }
+    gst_meta_algorithm_features_clear(algorithm_features_meta);
 }
 
 static gboolean gst_meta_algorithm_features_transform(
@@ -188,10 +309,33 @@ static gboolean gst_meta_algorithm_features_transform(
     {
         new_algorithm_features_meta = GST_META_ALGORITHM_FEATURES_ADD(transbuf);
 
-        if(old_algorithm_features_meta->features != NULL)
+        /*
+         * The copy gets its own slab rather than sharing one, so that either
+         * buffer can go back to the pool on its own.
+         */
+        if(old_algorithm_features_meta->slab != NULL)
         {
-            new_algorithm_features_meta->features
-                = g_array_ref(old_algorithm_features_meta->features);
+            result = gst_meta_algorithm_features_set_layout(
+                new_algorithm_features_meta,
+                old_algorithm_features_meta->pool,
+                old_algorithm_features_meta->features_matrix_width,
+                old_algorithm_features_meta->features_matrix_height,
+                old_algorithm_features_meta->features_per_aggregation,
+                old_algorithm_features_meta->feature_mask,
+                old_algorithm_features_meta->number_of_rois);
+
+            if(result)
+            {
+                memcpy(
+                    new_algorithm_features_meta->slab,
+                    old_algorithm_features_meta->slab,
+                    gst_meta_algorithm_features_get_slab_size(
+                        old_algorithm_features_meta->features_matrix_width,
+                        old_algorithm_features_meta->features_matrix_height,
+                        old_algorithm_features_meta->features_per_aggregation,
+                        old_algorithm_features_meta->feature_mask,
+                        old_algorithm_features_meta->number_of_rois));
+            }
         }
     }
     else
@@ -202,4 +346,407 @@ static gboolean gst_meta_algorithm_features_transform(
     return result;
 }
 
+static void gst_meta_algorithm_features_clear(
+    GstMetaAlgorithmFeatures *algorithm_features_meta)
+{
+    if(algorithm_features_meta->slab != NULL)
+    {
+        gst_algorithm_features_pool_release(
+            algorithm_features_meta->pool, algorithm_features_meta->slab);
+        algorithm_features_meta->slab = NULL;
+    }
+
+    if(algorithm_features_meta->pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(algorithm_features_meta->pool);
+        algorithm_features_meta->pool = NULL;
+    }
+
+    algorithm_features_meta->features_matrix_width = 0;
+    algorithm_features_meta->features_matrix_height = 0;
+    algorithm_features_meta->features_per_aggregation = 0;
+    algorithm_features_meta->length = 0;
+    algorithm_features_meta->features = NULL;
+    algorithm_features_meta->feature_mask = 0;
+
+    for(guint idx = 0; idx < ALGORITHM_NUMBER_OF_FEATURES; idx++)
+    {
+        algorithm_features_meta->feature_arrays[idx] = NULL;
+    }
+
+    algorithm_features_meta->number_of_rois = 0;
+    algorithm_features_meta->roi_ids = NULL;
+    algorithm_features_meta->roi_features = NULL;
+}
+
+gsize gst_meta_algorithm_features_get_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois)
+{
+    gsize length = gst_algorithm_features_get_number_of_aggregates(
+        (gsize)features_matrix_width * features_matrix_height,
+        features_per_aggregation);
+    gsize number_of_arrays
+        = gst_algorithm_features_get_number_of_planes(feature_mask)
+          + number_of_rois;
+
+    return length * number_of_arrays * sizeof(gfloat)
+           + (gsize)number_of_rois * sizeof(gint);
+}
+
+gboolean gst_meta_algorithm_features_set_layout(
+    GstMetaAlgorithmFeatures *meta,
+    GstAlgorithmFeaturesPool *pool,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois)
+{
+    gfloat *arrays = NULL;
+    gsize slab_size = 0;
+
+    g_return_val_if_fail(meta != NULL, FALSE);
+    g_return_val_if_fail(pool != NULL, FALSE);
+    g_return_val_if_fail(features_per_aggregation > 0, FALSE);
+
+    slab_size = gst_meta_algorithm_features_get_slab_size(
+        features_matrix_width,
+        features_matrix_height,
+        features_per_aggregation,
+        feature_mask,
+        number_of_rois);
+
+    if(gst_algorithm_features_pool_get_slab_size(pool) < slab_size)
+    {
+        GST_WARNING(
+            "The slabs of %" G_GSIZE_FORMAT " bytes are too small for %"
+            G_GSIZE_FORMAT " bytes of features",
+            gst_algorithm_features_pool_get_slab_size(pool),
+            slab_size);
+        return FALSE;
+    }
+
+    gst_meta_algorithm_features_clear(meta);
+
+    meta->pool = gst_algorithm_features_pool_ref(pool);
+    meta->slab = gst_algorithm_features_pool_acquire(pool);
+
+    meta->features_matrix_width = features_matrix_width;
+    meta->features_matrix_height = features_matrix_height;
+    meta->features_per_aggregation = features_per_aggregation;
+    meta->length = (guint)gst_algorithm_features_get_number_of_aggregates(
+        (gsize)features_matrix_width * features_matrix_height,
+        features_per_aggregation);
+    meta->feature_mask = feature_mask & ALGORITHM_FEATURE_FLAGS_ALL;
+    meta->number_of_rois = number_of_rois;
+
+    /*
+     * The arrays of gfloat come first, in the order the feature extractor
+     * kernels write their planes, followed by the IDs of the regions.
+     */
+    arrays = (gfloat *)meta->slab;
+    meta->features = arrays;
+    arrays += meta->length;
+
+    for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES; feature++)
+    {
+        if(meta->feature_mask & (1u << feature))
+        {
+            meta->feature_arrays[feature] = arrays;
+            arrays += meta->length;
+        }
+    }
+
+    if(number_of_rois > 0)
+    {
+        meta->roi_features = arrays;
+        arrays += (gsize)meta->length * number_of_rois;
+        meta->roi_ids = (gint *)arrays;
+    }
+
+    return TRUE;
+}
+
+gsize gst_meta_algorithm_features_get_serialized_size(
+    const GstMetaAlgorithmFeatures *meta)
+{
+    gsize size = GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE;
+
+    g_return_val_if_fail(meta != NULL, 0);
+
+    if(meta->slab != NULL)
+    {
+        size += gst_meta_algorithm_features_get_slab_size(
+            meta->features_matrix_width,
+            meta->features_matrix_height,
+            meta->features_per_aggregation,
+            meta->feature_mask,
+            meta->number_of_rois);
+    }
+
+    return size;
+}
+
+gboolean gst_meta_algorithm_features_serialize(
+    const GstMetaAlgorithmFeatures *meta,
+    guint8 *data,
+    gsize size)
+{
+    gsize serialized_size = 0;
+
+    g_return_val_if_fail(meta != NULL, FALSE);
+    g_return_val_if_fail(data != NULL, FALSE);
+
+    serialized_size = gst_meta_algorithm_features_get_serialized_size(meta);
+
+    if(size < serialized_size)
+    {
+        GST_WARNING(
+            "%" G_GSIZE_FORMAT " bytes are too few for %" G_GSIZE_FORMAT
+            " bytes of serialised features",
+            size,
+            serialized_size);
+        return FALSE;
+    }
+
+    /*
+     * Metadata without a slab is written with a layout of zeroes, so that it
+     * is still carried across as metadata without any features.
+     */
+    GST_WRITE_UINT32_LE(data, GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAGIC);
+    GST_WRITE_UINT8(
+        data + 4, GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION);
+    GST_WRITE_UINT8(data + 5, 0);
+    GST_WRITE_UINT16_LE(data + 6, 0);
+    GST_WRITE_UINT32_LE(
+        data + 8, meta->slab != NULL ? meta->features_matrix_width : 0);
+    GST_WRITE_UINT32_LE(
+        data + 12, meta->slab != NULL ? meta->features_matrix_height : 0);
+    GST_WRITE_UINT32_LE(
+        data + 16, meta->slab != NULL ? meta->features_per_aggregation : 0);
+    GST_WRITE_UINT32_LE(data + 20, meta->slab != NULL ? meta->feature_mask : 0);
+    GST_WRITE_UINT32_LE(
+        data + 24, meta->slab != NULL ? meta->number_of_rois : 0);
+
+    gst_meta_algorithm_features_copy_words_le(
+        data + GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE,
+        (const guint8 *)meta->slab,
+        (serialized_size
+         - GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE)
+            / sizeof(guint32));
+
+    return TRUE;
+}
+
+GstMetaAlgorithmFeatures *gst_meta_algorithm_features_deserialize(
+    GstBuffer *buffer,
+    GstAlgorithmFeaturesPool *pool,
+    const guint8 *data,
+    gsize size)
+{
+    GstMetaAlgorithmFeatures *meta = NULL;
+    GstAlgorithmFeaturesPool *own_pool = NULL;
+    guint features_matrix_width = 0;
+    guint features_matrix_height = 0;
+    guint features_per_aggregation = 0;
+    guint feature_mask = 0;
+    guint number_of_rois = 0;
+    gsize slab_size = 0;
+
+    g_return_val_if_fail(buffer != NULL, NULL);
+    g_return_val_if_fail(data != NULL || size == 0, NULL);
+
+    if(size < GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE
+       || GST_READ_UINT32_LE(data)
+              != GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAGIC)
+    {
+        GST_WARNING("The data is not serialised algorithm features metadata");
+        return NULL;
+    }
+
+    if(GST_READ_UINT8(data + 4)
+       != GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION)
+    {
+        GST_WARNING(
+            "Version %u of serialised algorithm features metadata is not "
+            "supported",
+            GST_READ_UINT8(data + 4));
+        return NULL;
+    }
+
+    features_matrix_width = GST_READ_UINT32_LE(data + 8);
+    features_matrix_height = GST_READ_UINT32_LE(data + 12);
+    features_per_aggregation = GST_READ_UINT32_LE(data + 16);
+    feature_mask = GST_READ_UINT32_LE(data + 20);
+    number_of_rois = GST_READ_UINT32_LE(data + 24);
+
+    if(!gst_meta_algorithm_features_get_checked_slab_size(
+           features_matrix_width,
+           features_matrix_height,
+           features_per_aggregation,
+           feature_mask,
+           number_of_rois,
+           &slab_size)
+       || size - GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE
+              != slab_size)
+    {
+        GST_WARNING(
+            "%" G_GSIZE_FORMAT " bytes do not match the layout of the "
+            "serialised algorithm features metadata",
+            size);
+        return NULL;
+    }
+
+    meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    if(slab_size == 0)
+    {
+        return meta;
+    }
+
+    if(pool == NULL
+       || gst_algorithm_features_pool_get_slab_size(pool) < slab_size)
+    {
+        own_pool = gst_algorithm_features_pool_new(slab_size);
+        pool = own_pool;
+    }
+
+    if(gst_meta_algorithm_features_set_layout(
+           meta,
+           pool,
+           features_matrix_width,
+           features_matrix_height,
+           features_per_aggregation,
+           feature_mask,
+           number_of_rois))
+    {
+        gst_meta_algorithm_features_copy_words_le(
+            (guint8 *)meta->slab,
+            data + GST_META_ALGORITHM_FEATURES_SERIALIZATION_HEADER_SIZE,
+            slab_size / sizeof(guint32));
+    }
+    else
+    {
+        gst_buffer_remove_meta(buffer, GST_META_CAST(meta));
+        meta = NULL;
+    }
+
+    /* The metadata holds its own reference to the pool */
+    if(own_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(own_pool);
+    }
+
+    return meta;
+}
+
+static void gst_meta_algorithm_features_copy_words_le(
+    guint8 *destination,
+    const guint8 *source,
+    gsize number_of_words)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    if(number_of_words > 0)
+    {
+        memcpy(destination, source, number_of_words * sizeof(guint32));
+    }
+#else
+    for(gsize idx = 0; idx < number_of_words; idx++)
+    {
+        GST_WRITE_UINT32_LE(
+            destination + idx * sizeof(guint32),
+            GST_READ_UINT32_BE(source + idx * sizeof(guint32)));
+    }
+#endif
+}
+
+static gboolean gst_meta_algorithm_features_get_checked_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois,
+    gsize *slab_size)
+{
+    gsize length = 0;
+    gsize number_of_arrays = 0;
+    gsize arrays_size = 0;
+    gsize roi_ids_size = 0;
+
+    *slab_size = 0;
+
+    if(feature_mask & ~(guint)ALGORITHM_FEATURE_FLAGS_ALL
+       || features_matrix_width
+              > GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAX_DIMENSION
+       || features_matrix_height
+              > GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAX_DIMENSION
+       || number_of_rois
+              > GST_META_ALGORITHM_FEATURES_SERIALIZATION_MAX_DIMENSION)
+    {
+        return FALSE;
+    }
+
+    /* Metadata without features is written with a layout of zeroes */
+    if(features_per_aggregation == 0)
+    {
+        return features_matrix_width == 0 && features_matrix_height == 0
+               && feature_mask == 0 && number_of_rois == 0;
+    }
+
+    length = gst_algorithm_features_get_number_of_aggregates(
+        (gsize)features_matrix_width * features_matrix_height,
+        features_per_aggregation);
+    number_of_arrays = gst_algorithm_features_get_number_of_planes(feature_mask)
+                       + number_of_rois;
+
+    return g_size_checked_mul(&arrays_size, length, number_of_arrays)
+           && g_size_checked_mul(&arrays_size, arrays_size, sizeof(gfloat))
+           && g_size_checked_mul(&roi_ids_size, number_of_rois, sizeof(gint))
+           && g_size_checked_add(slab_size, arrays_size, roi_ids_size);
+}
+
+#if GST_CHECK_VERSION(1, 24, 0)
+static gboolean gst_meta_algorithm_features_serialize_func(
+    const GstMeta *meta,
+    GstByteArrayInterface *data,
+    guint8 *version)
+{
+    const GstMetaAlgorithmFeatures *algorithm_features_meta
+        = (const GstMetaAlgorithmFeatures *)(meta);
+    gsize size = gst_meta_algorithm_features_get_serialized_size(
+        algorithm_features_meta);
+    guint8 *serialized = gst_byte_array_interface_append(data, size);
+
+    if(serialized == NULL)
+    {
+        return FALSE;
+    }
+
+    *version = GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION;
+
+    return gst_meta_algorithm_features_serialize(
+        algorithm_features_meta, serialized, size);
+}
+
+static GstMeta *gst_meta_algorithm_features_deserialize_func(
+    const GstMetaInfo *info,
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    guint8 version)
+{
+    if(version != GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION)
+    {
+        return NULL;
+    }
+
+    return (GstMeta *)gst_meta_algorithm_features_deserialize(
+        buffer, NULL, data, size);
+}
+#endif
+
 /******************************************************************************/
@@ -3,6 +3,8 @@
 
 #include <glib-object.h>
 #include <gmodule.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeaturespool.h>
 #include <gst/gst.h>
 
 G_BEGIN_DECLS
@@ -16,14 +18,30 @@ G_BEGIN_DECLS
     ((GstMetaAlgorithmFeatures *)(gst_buffer_get_meta( \
         buf, gst_meta_algorithm_features_api_get_type())))
 
+/**
+ * \brief The version of the binary format written by
+ * gst_meta_algorithm_features_serialize().
+ */
+#define GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION 1
+
 /**
  * \brief The structure for the GstMetaAlgorithmFeatures metadata type.
  *
  * \details This structure contains the structure to the parent GstMeta
- * type, and a pointer to a FeaturesMatrix instance. The FeaturesMatrix
- * instance will contain the 6 features (Count, Pixels, X0ToX1Magnitude,
- * X1ToX0Magnitude, Y0ToY1Magnitude, Y1ToY0Magnitude) extracted for each grid
- * cell of the frame in a 20x20 (by default) matrix.
+ * type, the spatial magnitude extracted for each grid cell of the frame in a
+ * 20x20 (by default) matrix, and up to 6 further features (Count, Pixels,
+ * X0ToX1Magnitude, X1ToX0Magnitude, Y0ToY1Magnitude, Y1ToY0Magnitude) for the
+ * same grid cells.
+ *
+ * \details The features are stored as a structure of arrays, with one array
+ * per feature, so that a consumer of a single feature only touches its own
+ * array.
+ *
+ * \details Every array lives in a single slab acquired from a
+ * GstAlgorithmFeaturesPool by gst_meta_algorithm_features_set_layout(), and
+ * holds length aggregates of gfloat. The slab goes back to the pool when the
+ * metadata is freed, so the metadata does not allocate once the pool holds
+ * enough slabs for the frames in flight.
  */
 typedef struct _GstMetaAlgorithmFeatures
 {
@@ -45,7 +63,91 @@ typedef struct _GstMetaAlgorithmFeatures
      */
     GstMeta meta;
 
-    GArray *features;
+    /**
+     * \brief The number of columns of grid cells the features were extracted
+     * for.
+     */
+    guint features_matrix_width;
+
+    /**
+     * \brief The number of rows of grid cells the features were extracted
+     * for.
+     */
+    guint features_matrix_height;
+
+    /**
+     * \brief The number of grid cells, in row-major order, reduced to each
+     * aggregate using the MAX aggregation operator.
+     */
+    guint features_per_aggregation;
+
+    /**
+     * \brief The number of aggregates in each of the arrays.
+     */
+    guint length;
+
+    /**
+     * \brief The spatial magnitude of each grid cell, aggregated in groups of
+     * 10 (by default) using the MAX aggregation operator, or NULL if no
+     * features were extracted.
+     *
+     * \details The spatial magnitude is the sum of the X0ToX1Magnitude,
+     * X1ToX0Magnitude, Y0ToY1Magnitude and Y1ToY0Magnitude features.
+     *
+     * \details The arrays of feature_arrays follow this array in feature
+     * order, so it starts a single block of
+     * gst_algorithm_features_get_number_of_planes() arrays.
+     */
+    gfloat *features;
+
+    /**
+     * \brief The GstAlgorithmFeatureFlags of the features in feature_arrays.
+     */
+    guint feature_mask;
+
+    /**
+     * \brief The array of each feature, indexed by GstAlgorithmFeature, or
+     * NULL for the features not selected by feature_mask.
+     *
+     * \details Each array has the same layout as features. They are only
+     * extracted for the whole frame, not for regions of interest.
+     */
+    gfloat *feature_arrays[ALGORITHM_NUMBER_OF_FEATURES];
+
+    /**
+     * \brief The number of regions of interest the features were extracted
+     * for, or 0 if the whole frame was processed.
+     *
+     * \details When regions of interest are used, features only covers the
+     * pixels within any of the regions.
+     */
+    guint number_of_rois;
+
+    /**
+     * \brief The IDs of the regions of interest, or NULL if the whole frame
+     * was processed.
+     */
+    gint *roi_ids;
+
+    /**
+     * \brief The features of each region of interest, as number_of_rois
+     * consecutive arrays in the same order as roi_ids, or NULL if the whole
+     * frame was processed.
+     *
+     * \details Each array has the same layout as features, and only covers
+     * the pixels within its region.
+     */
+    gfloat *roi_features;
+
+    /**
+     * \brief The pool the slab was acquired from, or NULL if there is none.
+     */
+    GstAlgorithmFeaturesPool *pool;
+
+    /**
+     * \brief The slab holding every array, or NULL if there is none.
+     */
+    gpointer slab;
 } GstMetaAlgorithmFeatures;
 
 /**
@@ -83,6 +185,118 @@ gst_meta_algorithm_features_api_get_type(void);
 extern __attribute__((visibility("default"))) const GstMetaInfo *
 gst_meta_algorithm_features_get_info(void);
 
+/**
+ * \brief Calculates the size of the slab holding the arrays of a
+ * GstMetaAlgorithmFeatures instance.
+ *
+ * \details A GstAlgorithmFeaturesPool created with this size can be passed to
+ * gst_meta_algorithm_features_set_layout() with the same parameters.
+ *
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] features_per_aggregation The number of grid cells per aggregate.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the feature arrays.
+ * \param[in] number_of_rois The number of regions of interest, or 0 for the
+ * whole frame.
+ *
+ * \returns The number of bytes of the slab.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_meta_algorithm_features_get_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois);
+
+/**
+ * \brief Describes the layout of the features of a GstMetaAlgorithmFeatures
+ * instance, and acquires the slab holding them.
+ *
+ * \details The features, feature_arrays, roi_ids and roi_features pointers
+ * are set to their place within the slab, for the caller to fill in. Any slab
+ * the instance already held is released first.
+ *
+ * \param[in,out] meta The GstMetaAlgorithmFeatures instance.
+ * \param[in] pool The pool to acquire the slab from. Its slabs have to be at
+ * least gst_meta_algorithm_features_get_slab_size() bytes.
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] features_per_aggregation The number of grid cells per aggregate.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the feature arrays.
+ * \param[in] number_of_rois The number of regions of interest, or 0 for the
+ * whole frame.
+ *
+ * \returns TRUE if the slab was acquired, FALSE if the slabs of the pool are
+ * too small.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_meta_algorithm_features_set_layout(
+    GstMetaAlgorithmFeatures *meta,
+    GstAlgorithmFeaturesPool *pool,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask,
+    guint number_of_rois);
+
+/**
+ * \brief Calculates the number of bytes
+ * gst_meta_algorithm_features_serialize() writes for a
+ * GstMetaAlgorithmFeatures instance.
+ *
+ * \param[in] meta The GstMetaAlgorithmFeatures instance.
+ *
+ * \returns The number of bytes of the serialised metadata.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_meta_algorithm_features_get_serialized_size(
+    const GstMetaAlgorithmFeatures *meta);
+
+/**
+ * \brief Serialises a GstMetaAlgorithmFeatures instance into a compact,
+ * versioned binary format, e.g. to carry it across a process boundary.
+ *
+ * \details The format is a 28 byte header, holding the "GAFT" magic, the
+ * format version, the layout of the features and the number of regions of
+ * interest, followed by the slab of the metadata as is: the arrays of gfloat
+ * and then the IDs of the regions as gint32. Every value is little-endian.
+ *
+ * \param[in] meta The GstMetaAlgorithmFeatures instance.
+ * \param[out] data A pointer to room for the serialised metadata.
+ * \param[in] size The number of bytes of room, which has to be at least
+ * gst_meta_algorithm_features_get_serialized_size().
+ *
+ * \returns TRUE if the metadata was serialised, FALSE if there is not enough
+ * room.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_meta_algorithm_features_serialize(
+    const GstMetaAlgorithmFeatures *meta,
+    guint8 *data,
+    gsize size);
+
+/**
+ * \brief Deserialises a GstMetaAlgorithmFeatures instance written by
+ * gst_meta_algorithm_features_serialize(), and adds it to a buffer.
+ *
+ * \param[in,out] buffer The buffer to add the metadata to.
+ * \param[in] pool The pool to acquire the slab from, or NULL. A pool with
+ * slabs of the right size is created for the metadata if this is NULL or its
+ * slabs are too small.
+ * \param[in] data A pointer to the serialised metadata.
+ * \param[in] size The number of bytes of the serialised metadata.
+ *
+ * \returns The GstMetaAlgorithmFeatures instance added to the buffer, or NULL
+ * if the data is not valid serialised metadata of a supported version.
+ */
+extern __attribute__((visibility("default"))) GstMetaAlgorithmFeatures *
+gst_meta_algorithm_features_deserialize(
+    GstBuffer *buffer,
+    GstAlgorithmFeaturesPool *pool,
+    const guint8 *data,
+    gsize size);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,361 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeaturesstats.h>
+
+#include <string.h>
+
+/*
+ * Just some setup for the GStreamer debug logger.
+ */
+GST_DEBUG_CATEGORY_STATIC(gst_meta_algorithm_features_stats_debug);
+#define GST_CAT_DEFAULT gst_meta_algorithm_features_stats_debug
+
+/************************** Type/Struct Definitions ***************************/
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Initialises an instance of the GstMetaAlgorithmFeaturesStats metadata
+ * type.
+ *
+ * \details This method is used as an override for the `init` method for the
+ * GstMetaAlgorithmFeaturesStats metadata type. Specifically, it clears the
+ * layout and sets the pointers to the arrays to NULL.
+ *
+ * \param[in,out] meta A pointer to the GstMetaAlgorithmFeaturesStats instance.
+ * \param[in] params A pointer to a structure containing a list of parameters
+ * passed to the init function.
+ * \param[in] buf A pointer to the buffer that the GstMetaAlgorithmFeaturesStats
+ * instance is being initialised on.
+ *
+ * \returns TRUE under all circumstances.
+ */
+static gboolean gst_meta_algorithm_features_stats_init(
+    GstMeta *meta,
+    gpointer params,
+    GstBuffer *buf);
+
+/**
+ * \brief Cleans up an instance of the GstMetaAlgorithmFeaturesStats metadata
+ * type.
+ *
+ * \details This method is used as an override for the `free` method for the
+ * GstMetaAlgorithmFeaturesStats metadata type. Specifically, it releases the
+ * slab holding the arrays back to its pool.
+ *
+ * \param[in,out] meta A pointer to the GstMetaAlgorithmFeaturesStats instance.
+ * \param[in] buf A pointer to the buffer that the GstMetaAlgorithmFeaturesStats
+ * instance is being freed from.
+ */
+static void
+gst_meta_algorithm_features_stats_free(GstMeta *meta, GstBuffer *buf);
+
+/**
+ * \brief Performs a transformation function on an instance of the
+ * GstMetaAlgorithmFeaturesStats metadata type.
+ *
+ * \details This method is used as an override for the `transform` method for
+ * the GstMetaAlgorithmFeaturesStats metadata type. Specifically, it deals
+ * exclusively with the "copy" transformation type.
+ *
+ * \details For the "copy" transformation type, a new instance of the
+ * GstMetaAlgorithmFeaturesStats metadata type is created on the new buffer
+ * (transbuf). The new instance acquires a slab from the pool of the existing
+ * instance with the same layout, and the arrays are copied into it.
+ *
+ * \param[in,out] transbuf The buffer to perform the "copy" transformation
+ * onto.
+ * \param[in] meta A pointer to the GstMetaAlgorithmFeaturesStats instance.
+ * \param[in] buf A pointer to the buffer that the GstMetaAlgorithmFeaturesStats
+ * instance is being transformed on.
+ * \param[in] type The type of transformation function to perform.
+ * \param[in] data A pointer to a structure containing a list of parameters
+ * passed to the transform function.
+ */
+static gboolean gst_meta_algorithm_features_stats_transform(
+    GstBuffer *transbuf,
+    GstMeta *meta,
+    GstBuffer *buf,
+    GQuark type,
+    gpointer data);
+
+/**
+ * \brief Releases the slab of a GstMetaAlgorithmFeaturesStats instance, and
+ * sets the pointers to the arrays to NULL.
+ *
+ * \param[in,out] stats_meta A pointer to the GstMetaAlgorithmFeaturesStats
+ * instance.
+ */
+static void
+gst_meta_algorithm_features_stats_clear(GstMetaAlgorithmFeaturesStats *stats_meta);
+
+/****************************** Static Variables ******************************/
+
+/************************** GObject Type Definitions **************************/
+
+/**************************** Function Definitions ****************************/
+
+GType gst_meta_algorithm_features_stats_api_get_type(void)
+{
+    static GType type = 0;
+    static const gchar *tags[] = {NULL};
+
+    if(g_once_init_enter(&type))
+    {
+        GType _type = gst_meta_api_type_register(
+            "GstMetaAlgorithmFeaturesStatsAPI", tags);
+        g_once_init_leave(&type, _type);
+    }
+
+    return type;
+}
+
+const GstMetaInfo *gst_meta_algorithm_features_stats_get_info(void)
+{
+    static const GstMetaInfo *meta_algorithm_features_stats_info = NULL;
+
+    if(g_once_init_enter((GstMetaInfo **)&meta_algorithm_features_stats_info))
+    {
+        GST_DEBUG_CATEGORY_INIT(
+            gst_meta_algorithm_features_stats_debug,
+            "GstMetaAlgorithmFeaturesStats",
+            0,
+            "GStreamer CUDA Algorithm Features Statistics Metadata");
+
+        const GstMetaInfo *mi = gst_meta_register(
+            GST_META_ALGORITHM_FEATURES_STATS_API_TYPE,
+            "GstMetaAlgorithmFeaturesStats",
+            sizeof(GstMetaAlgorithmFeaturesStats),
+            gst_meta_algorithm_features_stats_init,
+            gst_meta_algorithm_features_stats_free,
+            gst_meta_algorithm_features_stats_transform);
+        g_once_init_leave(
+            (GstMetaInfo **)&meta_algorithm_features_stats_info,
+            (GstMetaInfo *)mi);
+    }
+
+    return meta_algorithm_features_stats_info;
+}
+
+static gboolean gst_meta_algorithm_features_stats_init(
+    GstMeta *meta,
+    gpointer params,
+    GstBuffer *buf)
+{
+    GstMetaAlgorithmFeaturesStats *stats_meta
+        = (GstMetaAlgorithmFeaturesStats *)(meta);
+
+    GST_DEBUG(
+        "GstMetaAlgorithmFeaturesStats instance stored at %p initialised on "
+        "the buffer at %p",
+        meta,
+        buf);
+
+    stats_meta->pool = NULL;
+    stats_meta->slab = NULL;
+    gst_meta_algorithm_features_stats_clear(stats_meta);
+
+    return TRUE;
+}
+
+static void
+gst_meta_algorithm_features_stats_free(GstMeta *meta, GstBuffer *buf)
+{
+    GstMetaAlgorithmFeaturesStats *stats_meta
+        = (GstMetaAlgorithmFeaturesStats *)(meta);
+
+    GST_DEBUG(
+        "GstMetaAlgorithmFeaturesStats instance stored at %p freed from the "
+        "buffer at %p",
+        meta,
+        buf);
+
+    gst_meta_algorithm_features_stats_clear(stats_meta);
+}
+
+static gboolean gst_meta_algorithm_features_stats_transform(
+    GstBuffer *transbuf,
+    GstMeta *meta,
+    GstBuffer *buf,
+    GQuark type,
+    gpointer data)
+{
+    GstMetaAlgorithmFeaturesStats *old_stats_meta
+        = (GstMetaAlgorithmFeaturesStats *)(meta);
+    GstMetaAlgorithmFeaturesStats *new_stats_meta
+        = (GstMetaAlgorithmFeaturesStats *)(meta);
+    gboolean result = TRUE;
+
+    GST_DEBUG(
+        "GstMetaAlgorithmFeaturesStats instance stored at %p is being "
+        "transformed from the buffer at %p to the buffer at %p",
+        meta,
+        buf,
+        transbuf);
+
+    if(GST_META_TRANSFORM_IS_COPY(type))
+    {
+        new_stats_meta = GST_META_ALGORITHM_FEATURES_STATS_ADD(transbuf);
+
+        if(old_stats_meta->slab != NULL)
+        {
+            result = gst_meta_algorithm_features_stats_set_layout(
+                new_stats_meta,
+                old_stats_meta->pool,
+                old_stats_meta->features_matrix_width,
+                old_stats_meta->features_matrix_height,
+                old_stats_meta->features_per_aggregation,
+                old_stats_meta->feature_mask);
+
+            if(result)
+            {
+                new_stats_meta->window_size = old_stats_meta->window_size;
+                new_stats_meta->number_of_frames
+                    = old_stats_meta->number_of_frames;
+                memcpy(
+                    new_stats_meta->slab,
+                    old_stats_meta->slab,
+                    gst_meta_algorithm_features_stats_get_slab_size(
+                        old_stats_meta->features_matrix_width,
+                        old_stats_meta->features_matrix_height,
+                        old_stats_meta->features_per_aggregation,
+                        old_stats_meta->feature_mask));
+            }
+        }
+    }
+    else
+    {
+        result = FALSE;
+    }
+
+    return result;
+}
+
+static void
+gst_meta_algorithm_features_stats_clear(GstMetaAlgorithmFeaturesStats *stats_meta)
+{
+    const GstAlgorithmFeaturesStatistics no_statistics = {NULL, NULL, NULL};
+
+    if(stats_meta->slab != NULL)
+    {
+        gst_algorithm_features_pool_release(stats_meta->pool, stats_meta->slab);
+        stats_meta->slab = NULL;
+    }
+
+    if(stats_meta->pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(stats_meta->pool);
+        stats_meta->pool = NULL;
+    }
+
+    stats_meta->window_size = 0;
+    stats_meta->number_of_frames = 0;
+    stats_meta->features_matrix_width = 0;
+    stats_meta->features_matrix_height = 0;
+    stats_meta->features_per_aggregation = 0;
+    stats_meta->length = 0;
+    stats_meta->features = no_statistics;
+    stats_meta->feature_mask = 0;
+
+    for(guint idx = 0; idx < ALGORITHM_NUMBER_OF_FEATURES; idx++)
+    {
+        stats_meta->feature_arrays[idx] = no_statistics;
+    }
+}
+
+gsize gst_meta_algorithm_features_stats_get_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask)
+{
+    gsize length = gst_algorithm_features_get_number_of_aggregates(
+        (gsize)features_matrix_width * features_matrix_height,
+        features_per_aggregation);
+
+    /* The mean, the maximum and the variance of every plane */
+    return 3 * length * gst_algorithm_features_get_number_of_planes(feature_mask)
+           * sizeof(gfloat);
+}
+
+gboolean gst_meta_algorithm_features_stats_set_layout(
+    GstMetaAlgorithmFeaturesStats *meta,
+    GstAlgorithmFeaturesPool *pool,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask)
+{
+    gfloat *means = NULL;
+    gfloat *maxes = NULL;
+    gfloat *variances = NULL;
+    gsize block_length = 0;
+    gsize slab_size = 0;
+
+    g_return_val_if_fail(meta != NULL, FALSE);
+    g_return_val_if_fail(pool != NULL, FALSE);
+    g_return_val_if_fail(features_per_aggregation > 0, FALSE);
+
+    slab_size = gst_meta_algorithm_features_stats_get_slab_size(
+        features_matrix_width,
+        features_matrix_height,
+        features_per_aggregation,
+        feature_mask);
+
+    if(gst_algorithm_features_pool_get_slab_size(pool) < slab_size)
+    {
+        GST_WARNING(
+            "The slabs of %" G_GSIZE_FORMAT " bytes are too small for %"
+            G_GSIZE_FORMAT " bytes of statistics",
+            gst_algorithm_features_pool_get_slab_size(pool),
+            slab_size);
+        return FALSE;
+    }
+
+    gst_meta_algorithm_features_stats_clear(meta);
+
+    meta->pool = gst_algorithm_features_pool_ref(pool);
+    meta->slab = gst_algorithm_features_pool_acquire(pool);
+
+    meta->features_matrix_width = features_matrix_width;
+    meta->features_matrix_height = features_matrix_height;
+    meta->features_per_aggregation = features_per_aggregation;
+    meta->length = (guint)gst_algorithm_features_get_number_of_aggregates(
+        (gsize)features_matrix_width * features_matrix_height,
+        features_per_aggregation);
+    meta->feature_mask = feature_mask & ALGORITHM_FEATURE_FLAGS_ALL;
+
+    /*
+     * Each statistic gets one block laid out like the arrays of
+     * GstMetaAlgorithmFeatures, so that a sliding window over the whole block
+     * of features fills in a block per statistic in one go.
+     */
+    block_length = meta->length
+                   * gst_algorithm_features_get_number_of_planes(
+                       meta->feature_mask);
+    means = (gfloat *)meta->slab;
+    maxes = means + block_length;
+    variances = maxes + block_length;
+
+    meta->features.mean = means;
+    meta->features.max = maxes;
+    meta->features.variance = variances;
+
+    for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES; feature++)
+    {
+        if(meta->feature_mask & (1u << feature))
+        {
+            means += meta->length;
+            maxes += meta->length;
+            variances += meta->length;
+
+            meta->feature_arrays[feature].mean = means;
+            meta->feature_arrays[feature].max = maxes;
+            meta->feature_arrays[feature].variance = variances;
+        }
+    }
+
+    return TRUE;
+}
+
+/******************************************************************************/
@@ -0,0 +1,228 @@
+#ifndef __GST_META_ALGORITHM_FEATURES_STATS_H__
+#define __GST_META_ALGORITHM_FEATURES_STATS_H__
+
+#include <glib-object.h>
+#include <gmodule.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeaturespool.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_META_ALGORITHM_FEATURES_STATS_API_TYPE \
+    (gst_meta_algorithm_features_stats_api_get_type())
+#define GST_META_ALGORITHM_FEATURES_STATS_ADD(buf)          \
+    ((GstMetaAlgorithmFeaturesStats *)(gst_buffer_add_meta( \
+        buf, gst_meta_algorithm_features_stats_get_info(), NULL)))
+#define GST_META_ALGORITHM_FEATURES_STATS_GET(buf)          \
+    ((GstMetaAlgorithmFeaturesStats *)(gst_buffer_get_meta( \
+        buf, gst_meta_algorithm_features_stats_api_get_type())))
+
+/**
+ * \brief The statistics of an array of features over a sliding window of
+ * frames.
+ *
+ * \details Each pointer is NULL if there are no statistics for the array, or
+ * points to length gfloat aggregates with the same layout as the array in
+ * GstMetaAlgorithmFeatures.
+ */
+typedef struct _GstAlgorithmFeaturesStatistics
+{
+    /**
+     * \brief The mean of each aggregate over the window.
+     */
+    gfloat *mean;
+
+    /**
+     * \brief The maximum of each aggregate over the window.
+     */
+    gfloat *max;
+
+    /**
+     * \brief The population variance of each aggregate over the window.
+     */
+    gfloat *variance;
+} GstAlgorithmFeaturesStatistics;
+
+/**
+ * \brief The structure for the GstMetaAlgorithmFeaturesStats metadata type.
+ *
+ * \details This structure contains the structure to the parent GstMeta
+ * type, and the mean, maximum and variance of the arrays of the
+ * GstMetaAlgorithmFeatures instance on the same buffer over the last
+ * window_size (at most) frames, including the frame of the buffer.
+ *
+ * \details Every array lives in a single slab acquired from a
+ * GstAlgorithmFeaturesPool by gst_meta_algorithm_features_stats_set_layout(),
+ * like the arrays of GstMetaAlgorithmFeatures.
+ */
+typedef struct _GstMetaAlgorithmFeaturesStats
+{
+    /**
+     * \brief The parent class' instance data.
+     *
+     * \details This is the structure for the parent class' instance data. When
+     * a pointer to an instance of this class is cast to an instance to the
+     * parent class or any other classes higher up in the class hierarchy, only
+     * the variables available to that class will be available to be modified
+     * or used.
+     *
+     * \notes As per above, this relies on a bit of trickery regarding how C
+     * stores its data structures in memory. The order that the structures are
+     * defined here are the order they will be stored in memory by C. That
+     * allows us to "cheat" by casting a pointer to this structure to a pointer
+     * of the parent structure(s); thereby giving us an inheritance-like
+     * nature to these structures.
+     */
+    GstMeta meta;
+
+    /**
+     * \brief The number of frames the window holds once full.
+     */
+    guint window_size;
+
+    /**
+     * \brief The number of frames the statistics were calculated over, which
+     * is less than window_size until the window fills up.
+     */
+    guint number_of_frames;
+
+    /**
+     * \brief The number of columns of grid cells the features were extracted
+     * for.
+     */
+    guint features_matrix_width;
+
+    /**
+     * \brief The number of rows of grid cells the features were extracted
+     * for.
+     */
+    guint features_matrix_height;
+
+    /**
+     * \brief The number of grid cells reduced to each aggregate.
+     */
+    guint features_per_aggregation;
+
+    /**
+     * \brief The number of aggregates in each of the arrays.
+     */
+    guint length;
+
+    /**
+     * \brief The statistics of the spatial magnitude.
+     */
+    GstAlgorithmFeaturesStatistics features;
+
+    /**
+     * \brief The GstAlgorithmFeatureFlags of the features in feature_arrays.
+     */
+    guint feature_mask;
+
+    /**
+     * \brief The statistics of each feature, indexed by GstAlgorithmFeature,
+     * with NULL pointers for the features not selected by feature_mask.
+     */
+    GstAlgorithmFeaturesStatistics
+        feature_arrays[ALGORITHM_NUMBER_OF_FEATURES];
+
+    /**
+     * \brief The pool the slab was acquired from, or NULL if there is none.
+     */
+    GstAlgorithmFeaturesPool *pool;
+
+    /**
+     * \brief The slab holding every array, or NULL if there is none.
+     */
+    gpointer slab;
+} GstMetaAlgorithmFeaturesStats;
+
+/**
+ * \brief Type creation/retrieval function for the
+ * GstMetaAlgorithmFeaturesStats metadata type.
+ *
+ * \details This function creates and registers the
+ * GstMetaAlgorithmFeaturesStats metadata type for the first invocation. The
+ * GType instance for the GstMetaAlgorithmFeaturesStats metadata type is then
+ * returned.
+ *
+ * \details For subsequent invocations, the GType instance for the
+ * GstMetaAlgorithmFeaturesStats metadata type is returned immediately.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstMetaAlgorithmFeaturesStats metadata type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_meta_algorithm_features_stats_api_get_type(void);
+
+/**
+ * \brief GstMetaInfo creation/retrieval function for the
+ * GstMetaAlgorithmFeaturesStats metadata type.
+ *
+ * \details This function creates and registers the GstMetaInfo instance for
+ * the GstMetaAlgorithmFeaturesStats metadata type for the first invocation.
+ * The GstMetaInfo instance for the GstMetaAlgorithmFeaturesStats metadata type
+ * is then returned.
+ *
+ * \details For subsequent invocations, the GstMetaInfo instance for the
+ * GstMetaAlgorithmFeaturesStats metadata type is then returned immediately.
+ *
+ * \returns A GstMetaInfo instance representing the registration information
+ * for the GstMetaAlgorithmFeaturesStats metadata type.
+ */
+extern __attribute__((visibility("default"))) const GstMetaInfo *
+gst_meta_algorithm_features_stats_get_info(void);
+
+/**
+ * \brief Calculates the size of the slab holding the arrays of a
+ * GstMetaAlgorithmFeaturesStats instance.
+ *
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] features_per_aggregation The number of grid cells per aggregate.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the feature arrays.
+ *
+ * \returns The number of bytes of the slab.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_meta_algorithm_features_stats_get_slab_size(
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask);
+
+/**
+ * \brief Describes the layout of the statistics of a
+ * GstMetaAlgorithmFeaturesStats instance, and acquires the slab holding them.
+ *
+ * \details The means of the spatial magnitude and of the selected features
+ * are stored as one block, in the same order as the arrays of
+ * GstMetaAlgorithmFeatures, followed by a block of the maximums and a block
+ * of the variances. The block of each statistic can therefore be filled in
+ * from the block starting at features.mean, features.max and
+ * features.variance respectively. Any slab the instance already held is
+ * released first.
+ *
+ * \param[in,out] meta The GstMetaAlgorithmFeaturesStats instance.
+ * \param[in] pool The pool to acquire the slab from. Its slabs have to be at
+ * least gst_meta_algorithm_features_stats_get_slab_size() bytes.
+ * \param[in] features_matrix_width The number of columns of grid cells.
+ * \param[in] features_matrix_height The number of rows of grid cells.
+ * \param[in] features_per_aggregation The number of grid cells per aggregate.
+ * \param[in] feature_mask The GstAlgorithmFeatureFlags of the feature arrays.
+ *
+ * \returns TRUE if the slab was acquired, FALSE if the slabs of the pool are
+ * too small.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_meta_algorithm_features_stats_set_layout(
+    GstMetaAlgorithmFeaturesStats *meta,
+    GstAlgorithmFeaturesPool *pool,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    guint features_per_aggregation,
+    guint feature_mask);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,420 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcudaabrladder.h"
+
+typedef struct _GstCudaAbrSession
+{
+    gpointer handle;
+
+    /* slots submitted but not output yet, oldest first */
+    GQueue pending;
+
+    GstFlowReturn last_flow;
+} GstCudaAbrSession;
+
+struct _GstCudaAbrLadder
+{
+    const GstCudaAbrSessionFuncs *funcs;
+    gpointer user_data;
+
+    GstCudaAbrSession *sessions;
+    guint n_sessions;
+
+    /* number of sessions which did not output the picture of the slot yet,
+     * the slot is free once it drops to zero */
+    guint *slot_refs;
+    guint n_slots;
+};
+
+static gboolean parse_uint(const gchar *str, gchar **end, guint *value)
+{
+    guint64 parsed;
+
+    if(!g_ascii_isdigit(*str))
+        return FALSE;
+
+    parsed = g_ascii_strtoull(str, end, 10);
+    if(parsed == 0 || parsed > G_MAXINT)
+        return FALSE;
+
+    *value = (guint)parsed;
+
+    return TRUE;
+}
+
+/**
+ * gst_cuda_abr_rendition_parse:
+ * @str: a comma separated list of WIDTHxHEIGHT:KBPS renditions, e.g.
+ * "1280x720:3000,640x360:800"
+ *
+ * Returns: (transfer full) (nullable): a #GArray of #GstCudaAbrRendition, or
+ * %NULL if @str is malformed, lists an odd dimension or more than
+ * %GST_CUDA_ABR_LADDER_MAX_RENDITIONS renditions
+ */
+GArray *gst_cuda_abr_rendition_parse(const gchar *str)
+{
+    GArray *renditions;
+    gchar **tokens;
+    guint i;
+
+    g_return_val_if_fail(str != NULL, NULL);
+
+    tokens = g_strsplit(str, ",", -1);
+    renditions = g_array_new(FALSE, TRUE, sizeof(GstCudaAbrRendition));
+
+    for(i = 0; tokens[i]; i++)
+    {
+        GstCudaAbrRendition rendition;
+        gchar *token = g_strstrip(tokens[i]);
+        gchar *end;
+
+        if(!parse_uint(token, &end, &rendition.width) || *end != 'x')
+            goto error;
+
+        if(!parse_uint(end + 1, &end, &rendition.height) || *end != ':')
+            goto error;
+
+        if(!parse_uint(end + 1, &end, &rendition.bitrate) || *end != '\0')
+            goto error;
+
+        /* 4:2:0 chroma */
+        if(rendition.width % 2 || rendition.height % 2)
+            goto error;
+
+        g_array_append_val(renditions, rendition);
+    }
+
+    if(renditions->len == 0 || renditions->len > GST_CUDA_ABR_LADDER_MAX_RENDITIONS)
+        goto error;
+
+    g_strfreev(tokens);
+
+    return renditions;
+
+error:
+    g_strfreev(tokens);
+    g_array_unref(renditions);
+
+    return NULL;
+}
+
+/**
+ * gst_cuda_abr_rendition_get_layout:
+ * @renditions: the renditions of the ladder
+ * @n_renditions: the number of @renditions
+ * @pitch_align: the alignment of the pitch and of the planes, a power of two
+ * @layouts: (out caller-allocates): the @n_renditions plane layouts
+ *
+ * Lays the NV12 pictures of @renditions out one after the other in a single
+ * input, so that scaling the input into all the renditions writes a single
+ * allocation.
+ *
+ * Returns: the size of the input, in bytes
+ */
+gsize gst_cuda_abr_rendition_get_layout(
+    const GstCudaAbrRendition *renditions,
+    guint n_renditions,
+    guint pitch_align,
+    GstCudaAbrPlaneLayout *layouts)
+{
+    gsize size = 0;
+    guint i;
+
+    g_return_val_if_fail(renditions != NULL, 0);
+    g_return_val_if_fail(layouts != NULL, 0);
+    g_return_val_if_fail(pitch_align > 0 && (pitch_align & (pitch_align - 1)) == 0, 0);
+
+    for(i = 0; i < n_renditions; i++)
+    {
+        gsize pitch = (renditions[i].width + pitch_align - 1) & ~((gsize)pitch_align - 1);
+
+        layouts[i].pitch = pitch;
+        layouts[i].luma_offset = size;
+        layouts[i].chroma_offset = size + pitch * renditions[i].height;
+
+        /* the height is even, so the next picture stays aligned */
+        size = layouts[i].chroma_offset + pitch * (renditions[i].height / 2);
+    }
+
+    return size;
+}
+
+/**
+ * gst_cuda_abr_ladder_new:
+ * @funcs: the encoder driven by the ladder, must outlive it
+ * @user_data: passed to @funcs open and push
+ * @renditions: the renditions to encode
+ * @n_renditions: the number of @renditions
+ * @n_slots: the number of input slots, which bounds the number of pictures
+ * in flight
+ *
+ * Opens one encode session per rendition.
+ *
+ * Returns: (nullable): a new #GstCudaAbrLadder, or %NULL if a session could
+ * not be opened
+ */
+GstCudaAbrLadder *gst_cuda_abr_ladder_new(
+    const GstCudaAbrSessionFuncs *funcs,
+    gpointer user_data,
+    const GstCudaAbrRendition *renditions,
+    guint n_renditions,
+    guint n_slots)
+{
+    GstCudaAbrLadder *ladder;
+    guint i;
+
+    g_return_val_if_fail(funcs != NULL, NULL);
+    g_return_val_if_fail(renditions != NULL, NULL);
+    g_return_val_if_fail(n_renditions > 0, NULL);
+    g_return_val_if_fail(n_renditions <= GST_CUDA_ABR_LADDER_MAX_RENDITIONS, NULL);
+    g_return_val_if_fail(n_slots > 0, NULL);
+
+    ladder = g_new0(GstCudaAbrLadder, 1);
+    ladder->funcs = funcs;
+    ladder->user_data = user_data;
+    ladder->sessions = g_new0(GstCudaAbrSession, n_renditions);
+    ladder->slot_refs = g_new0(guint, n_slots);
+    ladder->n_slots = n_slots;
+
+    for(i = 0; i < n_renditions; i++)
+    {
+        GstCudaAbrSession *session = &ladder->sessions[i];
+
+        session->handle = funcs->open(user_data, i, &renditions[i]);
+        if(!session->handle)
+        {
+            gst_cuda_abr_ladder_free(ladder);
+            return NULL;
+        }
+
+        g_queue_init(&session->pending);
+        session->last_flow = GST_FLOW_OK;
+        ladder->n_sessions++;
+    }
+
+    return ladder;
+}
+
+/**
+ * gst_cuda_abr_ladder_free:
+ * @ladder: a #GstCudaAbrLadder
+ *
+ * Closes the encode sessions, dropping the pictures which were not output.
+ */
+void gst_cuda_abr_ladder_free(GstCudaAbrLadder *ladder)
+{
+    guint i;
+
+    g_return_if_fail(ladder != NULL);
+
+    for(i = 0; i < ladder->n_sessions; i++)
+    {
+        ladder->funcs->close(ladder->sessions[i].handle);
+        g_queue_clear(&ladder->sessions[i].pending);
+    }
+
+    g_free(ladder->sessions);
+    g_free(ladder->slot_refs);
+    g_free(ladder);
+}
+
+/**
+ * gst_cuda_abr_ladder_get_n_renditions:
+ * @ladder: a #GstCudaAbrLadder
+ *
+ * Returns: the number of renditions encoded by @ladder
+ */
+guint gst_cuda_abr_ladder_get_n_renditions(GstCudaAbrLadder *ladder)
+{
+    g_return_val_if_fail(ladder != NULL, 0);
+
+    return ladder->n_sessions;
+}
+
+/**
+ * gst_cuda_abr_ladder_acquire_slot:
+ * @ladder: a #GstCudaAbrLadder
+ *
+ * Acquires an input slot to scale the next input picture into. The slot is
+ * handed back once every session has output its picture.
+ *
+ * Returns: the input slot, or -1 if all of them are in flight
+ */
+gint gst_cuda_abr_ladder_acquire_slot(GstCudaAbrLadder *ladder)
+{
+    guint i;
+
+    g_return_val_if_fail(ladder != NULL, -1);
+
+    for(i = 0; i < ladder->n_slots; i++)
+    {
+        if(ladder->slot_refs[i] == 0)
+        {
+            ladder->slot_refs[i] = ladder->n_sessions;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* the same rules as GstFlowCombiner, a rendition nobody links to or which
+ * reached EOS does not stop the others */
+static GstFlowReturn gst_cuda_abr_ladder_combine_flows(GstCudaAbrLadder *ladder)
+{
+    gboolean all_eos = TRUE;
+    gboolean all_not_linked = TRUE;
+    guint i;
+
+    for(i = 0; i < ladder->n_sessions; i++)
+    {
+        GstFlowReturn flow = ladder->sessions[i].last_flow;
+
+        if(flow <= GST_FLOW_NOT_NEGOTIATED || flow == GST_FLOW_FLUSHING)
+            return flow;
+
+        if(flow != GST_FLOW_EOS)
+            all_eos = FALSE;
+        if(flow != GST_FLOW_NOT_LINKED)
+            all_not_linked = FALSE;
+    }
+
+    if(all_not_linked)
+        return GST_FLOW_NOT_LINKED;
+    if(all_eos)
+        return GST_FLOW_EOS;
+
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn gst_cuda_abr_ladder_output(GstCudaAbrLadder *ladder, guint index)
+{
+    GstCudaAbrSession *session = &ladder->sessions[index];
+
+    while(!g_queue_is_empty(&session->pending))
+    {
+        gint slot = GPOINTER_TO_INT(g_queue_pop_head(&session->pending));
+        GstBuffer *buffer;
+
+        buffer = ladder->funcs->lock_bitstream(session->handle, slot);
+        ladder->slot_refs[slot]--;
+
+        if(!buffer)
+        {
+            session->last_flow = GST_FLOW_ERROR;
+            return GST_FLOW_ERROR;
+        }
+
+        session->last_flow = ladder->funcs->push(ladder->user_data, index, buffer);
+    }
+
+    return GST_FLOW_OK;
+}
+
+/**
+ * gst_cuda_abr_ladder_submit:
+ * @ladder: a #GstCudaAbrLadder
+ * @slot: the input slot holding the scaled pictures, from
+ * gst_cuda_abr_ladder_acquire_slot()
+ * @pts: the presentation timestamp of the input picture
+ * @duration: the duration of the input picture
+ *
+ * Submits the pictures of @slot to every session, in rendition order, and
+ * pushes the encoded pictures the sessions can output.
+ *
+ * Returns: the combined flow of the renditions
+ */
+GstFlowReturn gst_cuda_abr_ladder_submit(
+    GstCudaAbrLadder *ladder,
+    gint slot,
+    GstClockTime pts,
+    GstClockTime duration)
+{
+    guint i;
+
+    g_return_val_if_fail(ladder != NULL, GST_FLOW_ERROR);
+    g_return_val_if_fail(slot >= 0 && (guint)slot < ladder->n_slots, GST_FLOW_ERROR);
+    g_return_val_if_fail(ladder->slot_refs[slot] == ladder->n_sessions, GST_FLOW_ERROR);
+
+    for(i = 0; i < ladder->n_sessions; i++)
+    {
+        GstCudaAbrSession *session = &ladder->sessions[i];
+        GstCudaAbrEncodeStatus status;
+
+        status = ladder->funcs->encode(session->handle, slot, pts, duration);
+        if(status == GST_CUDA_ABR_ENCODE_ERROR)
+        {
+            /* the remaining sessions never see the slot */
+            ladder->slot_refs[slot] -= ladder->n_sessions - i;
+            session->last_flow = GST_FLOW_ERROR;
+            return GST_FLOW_ERROR;
+        }
+
+        g_queue_push_tail(&session->pending, GINT_TO_POINTER(slot));
+
+        if(status == GST_CUDA_ABR_ENCODE_OK && gst_cuda_abr_ladder_output(ladder, i) != GST_FLOW_OK)
+        {
+            ladder->slot_refs[slot] -= ladder->n_sessions - i - 1;
+            return GST_FLOW_ERROR;
+        }
+    }
+
+    return gst_cuda_abr_ladder_combine_flows(ladder);
+}
+
+/**
+ * gst_cuda_abr_ladder_drain:
+ * @ladder: a #GstCudaAbrLadder
+ *
+ * Signals the end of the stream to every session and pushes all the
+ * pictures they were still holding on to. All the input slots are free
+ * afterwards.
+ *
+ * Returns: the combined flow of the renditions
+ */
+GstFlowReturn gst_cuda_abr_ladder_drain(GstCudaAbrLadder *ladder)
+{
+    guint i;
+
+    g_return_val_if_fail(ladder != NULL, GST_FLOW_ERROR);
+
+    for(i = 0; i < ladder->n_sessions; i++)
+    {
+        GstCudaAbrSession *session = &ladder->sessions[i];
+
+        if(g_queue_is_empty(&session->pending))
+            continue;
+
+        if(ladder->funcs->encode(session->handle, -1, GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE)
+           != GST_CUDA_ABR_ENCODE_OK)
+        {
+            session->last_flow = GST_FLOW_ERROR;
+            return GST_FLOW_ERROR;
+        }
+
+        if(gst_cuda_abr_ladder_output(ladder, i) != GST_FLOW_OK)
+            return GST_FLOW_ERROR;
+    }
+
+    return gst_cuda_abr_ladder_combine_flows(ladder);
+}
@@ -0,0 +1,152 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CUDA_ABR_LADDER_H__
+#define __GST_CUDA_ABR_LADDER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_CUDA_ABR_LADDER_MAX_RENDITIONS 8
+
+/*
+ * GstCudaAbrRendition:
+ * @width: the width of the rendition, in pixels
+ * @height: the height of the rendition, in pixels
+ * @bitrate: the bitrate of the rendition, in kbit/sec
+ */
+typedef struct _GstCudaAbrRendition
+{
+    guint width;
+    guint height;
+    guint bitrate;
+} GstCudaAbrRendition;
+
+/*
+ * GstCudaAbrPlaneLayout:
+ * @pitch: the number of bytes between two rows of either plane
+ * @luma_offset: the offset of the luma plane from the start of the input
+ * @chroma_offset: the offset of the interleaved chroma plane
+ *
+ * Where the NV12 picture of a rendition lives in the input shared by all the
+ * renditions of a ladder.
+ */
+typedef struct _GstCudaAbrPlaneLayout
+{
+    gsize pitch;
+    gsize luma_offset;
+    gsize chroma_offset;
+} GstCudaAbrPlaneLayout;
+
+/*
+ * GstCudaAbrEncodeStatus:
+ * @GST_CUDA_ABR_ENCODE_OK: all the pictures submitted so far can be output
+ * @GST_CUDA_ABR_ENCODE_NEED_MORE_INPUT: the encoder holds on to the pictures
+ * submitted so far, e.g. to reorder them for B-frames
+ * @GST_CUDA_ABR_ENCODE_ERROR: the picture could not be submitted
+ *
+ * The outcome of submitting a picture, mirroring NvEncEncodePicture().
+ */
+typedef enum
+{
+    GST_CUDA_ABR_ENCODE_OK,
+    GST_CUDA_ABR_ENCODE_NEED_MORE_INPUT,
+    GST_CUDA_ABR_ENCODE_ERROR,
+} GstCudaAbrEncodeStatus;
+
+/*
+ * GstCudaAbrSessionFuncs:
+ * @open: opens the encode session of the rendition @index. Returns the
+ * session, or %NULL on error
+ * @encode: submits the picture of the input slot @slot to @session. @slot is
+ * -1 to signal the end of the stream, after which the session returns
+ * %GST_CUDA_ABR_ENCODE_OK once it has no picture left to submit
+ * @lock_bitstream: retrieves the encoded picture of the input slot @slot,
+ * which is the oldest picture of @session which was not retrieved yet.
+ * Returns %NULL on error
+ * @push: hands the encoded picture of the rendition @index downstream
+ * @close: closes @session
+ *
+ * The encoder the ladder drives, one session per rendition. All the
+ * functions are called from the thread feeding the ladder.
+ */
+typedef struct _GstCudaAbrSessionFuncs
+{
+    gpointer (*open)(gpointer user_data, guint index, const GstCudaAbrRendition *rendition);
+    GstCudaAbrEncodeStatus (*encode)(
+        gpointer session,
+        gint slot,
+        GstClockTime pts,
+        GstClockTime duration);
+    GstBuffer *(*lock_bitstream)(gpointer session, gint slot);
+    GstFlowReturn (*push)(gpointer user_data, guint index, GstBuffer *buffer);
+    void (*close)(gpointer session);
+} GstCudaAbrSessionFuncs;
+
+/*
+ * GstCudaAbrLadder:
+ *
+ * Encodes one input into several renditions at once. The input is scaled
+ * into the renditions of a single input slot, whose pictures stay
+ * registered with the encode sessions, and every session encodes its own
+ * picture of the slot. A slot is reused once every session has output the
+ * picture it holds, since sessions reordering pictures for B-frames keep
+ * them for a few more frames.
+ *
+ * The ladder is not thread-safe, it is fed from the streaming thread.
+ */
+typedef struct _GstCudaAbrLadder GstCudaAbrLadder;
+
+extern __attribute__((visibility("default"))) GArray *
+gst_cuda_abr_rendition_parse(const gchar *str);
+
+extern __attribute__((visibility("default"))) gsize gst_cuda_abr_rendition_get_layout(
+    const GstCudaAbrRendition *renditions,
+    guint n_renditions,
+    guint pitch_align,
+    GstCudaAbrPlaneLayout *layouts);
+
+extern __attribute__((visibility("default"))) GstCudaAbrLadder *gst_cuda_abr_ladder_new(
+    const GstCudaAbrSessionFuncs *funcs,
+    gpointer user_data,
+    const GstCudaAbrRendition *renditions,
+    guint n_renditions,
+    guint n_slots);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_abr_ladder_free(GstCudaAbrLadder *ladder);
+
+extern __attribute__((visibility("default"))) guint
+gst_cuda_abr_ladder_get_n_renditions(GstCudaAbrLadder *ladder);
+
+extern __attribute__((visibility("default"))) gint
+gst_cuda_abr_ladder_acquire_slot(GstCudaAbrLadder *ladder);
+
+extern __attribute__((visibility("default"))) GstFlowReturn gst_cuda_abr_ladder_submit(
+    GstCudaAbrLadder *ladder,
+    gint slot,
+    GstClockTime pts,
+    GstClockTime duration);
+
+extern __attribute__((visibility("default"))) GstFlowReturn
+gst_cuda_abr_ladder_drain(GstCudaAbrLadder *ladder);
+
+G_END_DECLS
+
+#endif /* __GST_CUDA_ABR_LADDER_H__ */
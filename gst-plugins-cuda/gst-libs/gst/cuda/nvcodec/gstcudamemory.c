@@ -160,6 +160,69 @@ GstMemory *gst_cuda_allocator_alloc(
     return GST_MEMORY_CAST(mem);
 }
 
+/**
+ * gst_cuda_allocator_alloc_wrapped:
+ * @allocator: a #GstCudaAllocator
+ * @params: the allocation parameters, only the video info and the memory
+ * flags are used
+ * @data: the device memory to wrap
+ * @stride: the stride of @data
+ * @offset: the offset of each plane in @data
+ * @user_data: data passed to @notify
+ * @notify: called with @user_data once the memory is freed
+ *
+ * Wraps device memory which is not allocated by @allocator, such as a
+ * mapped decoder surface, without copying it. @data must stay valid until
+ * @notify is called.
+ *
+ * Returns: a new #GstCudaMemory wrapping @data
+ */
+GstMemory *gst_cuda_allocator_alloc_wrapped(
+    GstAllocator *allocator,
+    GstCudaAllocationParams *params,
+    CUdeviceptr data,
+    gint stride,
+    const gsize offset[GST_VIDEO_MAX_PLANES],
+    gpointer user_data,
+    GDestroyNotify notify)
+{
+    GstCudaAllocator *self = GST_CUDA_ALLOCATOR_CAST(allocator);
+    GstCudaMemory *mem;
+    gsize size = GST_VIDEO_INFO_SIZE(&params->info);
+    gint i;
+
+    g_return_val_if_fail(GST_IS_CUDA_ALLOCATOR(allocator), NULL);
+    g_return_val_if_fail(data != 0, NULL);
+    g_return_val_if_fail(stride > 0, NULL);
+
+    GST_CAT_DEBUG_OBJECT(GST_CAT_MEMORY, self, "wrap cuda memory");
+
+    mem = g_new0(GstCudaMemory, 1);
+    g_mutex_init(&mem->lock);
+    mem->data = data;
+    mem->alloc_params = *params;
+    mem->stride = stride;
+
+    for(i = 0; i < GST_VIDEO_INFO_N_PLANES(&params->info); i++)
+        mem->offset[i] = offset[i];
+
+    mem->context = gst_object_ref(self->context);
+    mem->user_data = user_data;
+    mem->notify = notify;
+
+    gst_memory_init(
+        GST_MEMORY_CAST(mem),
+        params->parent.flags,
+        GST_ALLOCATOR_CAST(self),
+        NULL,
+        size,
+        gst_memory_alignment,
+        0,
+        size);
+
+    return GST_MEMORY_CAST(mem);
+}
+
 static void gst_cuda_allocator_free(GstAllocator *allocator, GstMemory *memory)
 {
     GstCudaAllocator *self = GST_CUDA_ALLOCATOR_CAST(allocator);
@@ -170,13 +233,17 @@ static void gst_cuda_allocator_free(GstAllocator *allocator, GstMemory *memory)
     g_mutex_clear(&mem->lock);
 
     gst_cuda_context_push(self->context);
-    if(mem->data)
+    if(mem->data && !mem->notify)
         gst_cuda_result(CuMemFree(mem->data));
 
     if(mem->map_alloc_data)
         gst_cuda_result(CuMemFreeHost(mem->map_alloc_data));
 
     gst_cuda_context_pop(NULL);
+
+    if(mem->notify)
+        mem->notify(mem->user_data);
+
     gst_object_unref(mem->context);
 
     g_free(mem);
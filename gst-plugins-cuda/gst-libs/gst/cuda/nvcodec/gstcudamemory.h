@@ -103,6 +103,16 @@ gst_cuda_allocator_alloc(
     gsize size,
     GstCudaAllocationParams *params);
 
+extern __attribute__((visibility("default"))) GstMemory *
+gst_cuda_allocator_alloc_wrapped(
+    GstAllocator *allocator,
+    GstCudaAllocationParams *params,
+    CUdeviceptr data,
+    gint stride,
+    const gsize offset[GST_VIDEO_MAX_PLANES],
+    gpointer user_data,
+    GDestroyNotify notify);
+
 /**
  * GstCudaMemoryTransfer:
  * @GST_CUDA_MEMORY_TRANSFER_NEED_DOWNLOAD: the device memory needs downloading
@@ -141,6 +151,11 @@ struct _GstCudaMemory
     gint map_count;
 
     GMutex lock;
+
+    /* set for memory wrapping device memory owned by someone else, called
+     * on free instead of releasing the device memory */
+    gpointer user_data;
+    GDestroyNotify notify;
 };
 
 extern __attribute__((visibility("default"))) gboolean
@@ -0,0 +1,356 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcudaspscring.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+#define CACHE_LINE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+
+struct _GstCudaSpscRing
+{
+    gpointer *slots;
+    guint capacity;
+    guint mask;
+
+    /* written by the producer. ATOMIC */
+    CACHE_LINE_ALIGNED gint head;
+    gint not_empty_seq;
+    gint producer_waiting;
+
+    /* written by the consumer. ATOMIC */
+    CACHE_LINE_ALIGNED gint tail;
+    gint not_full_seq;
+    gint consumer_waiting;
+
+    CACHE_LINE_ALIGNED gint closed; /* ATOMIC */
+
+#ifndef __linux__
+    GMutex lock;
+    GCond cond;
+#endif
+};
+
+/* Sleeps as long as *word is still @value, or until woken up. Spurious
+ * wakeups are fine, the callers loop */
+static void gst_cuda_spsc_ring_wait(GstCudaSpscRing *ring, gint *word, gint value)
+{
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    g_mutex_lock(&ring->lock);
+    if(g_atomic_int_get(word) == value)
+        g_cond_wait(&ring->cond, &ring->lock);
+    g_mutex_unlock(&ring->lock);
+#endif
+}
+
+static void gst_cuda_spsc_ring_wake(GstCudaSpscRing *ring, gint *word)
+{
+    g_atomic_int_inc(word);
+
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, G_MAXINT, NULL, NULL, 0);
+#else
+    g_mutex_lock(&ring->lock);
+    g_cond_broadcast(&ring->cond);
+    g_mutex_unlock(&ring->lock);
+#endif
+}
+
+/**
+ * gst_cuda_spsc_ring_new:
+ * @min_capacity: the number of items the ring must be able to hold
+ *
+ * Returns: a new #GstCudaSpscRing, whose capacity is @min_capacity rounded
+ * up to a power of two
+ */
+GstCudaSpscRing *gst_cuda_spsc_ring_new(guint min_capacity)
+{
+    GstCudaSpscRing *ring;
+    guint capacity = 1;
+
+    g_return_val_if_fail(min_capacity > 0, NULL);
+    g_return_val_if_fail(min_capacity <= G_MAXINT / 2, NULL);
+
+    while(capacity < min_capacity)
+        capacity <<= 1;
+
+    ring = g_new0(GstCudaSpscRing, 1);
+    ring->slots = g_new0(gpointer, capacity);
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+
+#ifndef __linux__
+    g_mutex_init(&ring->lock);
+    g_cond_init(&ring->cond);
+#endif
+
+    return ring;
+}
+
+/**
+ * gst_cuda_spsc_ring_free:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Frees @ring. The items still queued are not freed.
+ */
+void gst_cuda_spsc_ring_free(GstCudaSpscRing *ring)
+{
+    g_return_if_fail(ring != NULL);
+
+#ifndef __linux__
+    g_mutex_clear(&ring->lock);
+    g_cond_clear(&ring->cond);
+#endif
+
+    g_free(ring->slots);
+    g_free(ring);
+}
+
+/**
+ * gst_cuda_spsc_ring_get_capacity:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Returns: the number of items @ring can hold
+ */
+guint gst_cuda_spsc_ring_get_capacity(GstCudaSpscRing *ring)
+{
+    g_return_val_if_fail(ring != NULL, 0);
+
+    return ring->capacity;
+}
+
+/**
+ * gst_cuda_spsc_ring_get_length:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Returns: the number of queued items. Exact only when called from the
+ * producer or the consumer while the other side is idle
+ */
+guint gst_cuda_spsc_ring_get_length(GstCudaSpscRing *ring)
+{
+    guint tail;
+    guint head;
+
+    g_return_val_if_fail(ring != NULL, 0);
+
+    tail = (guint)g_atomic_int_get(&ring->tail);
+    head = (guint)g_atomic_int_get(&ring->head);
+
+    return head - tail;
+}
+
+/**
+ * gst_cuda_spsc_ring_try_push:
+ * @ring: a #GstCudaSpscRing
+ * @item: (transfer full): the item to queue, not %NULL
+ *
+ * Queues @item if there is room. Producer only.
+ *
+ * Returns: %TRUE if @item was queued, %FALSE if @ring is full or closed
+ */
+gboolean gst_cuda_spsc_ring_try_push(GstCudaSpscRing *ring, gpointer item)
+{
+    guint head;
+    guint tail;
+
+    g_return_val_if_fail(ring != NULL, FALSE);
+    g_return_val_if_fail(item != NULL, FALSE);
+
+    if(g_atomic_int_get(&ring->closed))
+        return FALSE;
+
+    head = (guint)g_atomic_int_get(&ring->head);
+    tail = (guint)g_atomic_int_get(&ring->tail);
+    if(head - tail == ring->capacity)
+        return FALSE;
+
+    ring->slots[head & ring->mask] = item;
+
+    /* publishes the slot */
+    g_atomic_int_set(&ring->head, (gint)(head + 1));
+
+    if(g_atomic_int_get(&ring->consumer_waiting) > 0)
+        gst_cuda_spsc_ring_wake(ring, &ring->not_empty_seq);
+
+    return TRUE;
+}
+
+/**
+ * gst_cuda_spsc_ring_push:
+ * @ring: a #GstCudaSpscRing
+ * @item: (transfer full): the item to queue, not %NULL
+ *
+ * Queues @item, waiting for the consumer to make room if @ring is full.
+ * Producer only.
+ *
+ * Returns: %TRUE if @item was queued, %FALSE if @ring is closed
+ */
+gboolean gst_cuda_spsc_ring_push(GstCudaSpscRing *ring, gpointer item)
+{
+    g_return_val_if_fail(ring != NULL, FALSE);
+    g_return_val_if_fail(item != NULL, FALSE);
+
+    while(!gst_cuda_spsc_ring_try_push(ring, item))
+    {
+        gint seq;
+
+        if(g_atomic_int_get(&ring->closed))
+            return FALSE;
+
+        seq = g_atomic_int_get(&ring->not_full_seq);
+        g_atomic_int_inc(&ring->producer_waiting);
+
+        /* the consumer checks for waiters after freeing a slot, so
+         * checking again after registering cannot miss a wakeup */
+        if(gst_cuda_spsc_ring_get_length(ring) == ring->capacity
+           && !g_atomic_int_get(&ring->closed))
+            gst_cuda_spsc_ring_wait(ring, &ring->not_full_seq, seq);
+
+        g_atomic_int_add(&ring->producer_waiting, -1);
+    }
+
+    return TRUE;
+}
+
+/**
+ * gst_cuda_spsc_ring_try_pop:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Dequeues the oldest item, if any. Consumer only.
+ *
+ * Returns: (transfer full) (nullable): the item, or %NULL if @ring is empty
+ */
+gpointer gst_cuda_spsc_ring_try_pop(GstCudaSpscRing *ring)
+{
+    gpointer item;
+    guint tail;
+    guint head;
+
+    g_return_val_if_fail(ring != NULL, NULL);
+
+    tail = (guint)g_atomic_int_get(&ring->tail);
+    head = (guint)g_atomic_int_get(&ring->head);
+    if(head == tail)
+        return NULL;
+
+    item = ring->slots[tail & ring->mask];
+
+    /* hands the slot back to the producer */
+    g_atomic_int_set(&ring->tail, (gint)(tail + 1));
+
+    if(g_atomic_int_get(&ring->producer_waiting) > 0)
+        gst_cuda_spsc_ring_wake(ring, &ring->not_full_seq);
+
+    return item;
+}
+
+/**
+ * gst_cuda_spsc_ring_pop:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Dequeues the oldest item, waiting for the producer if @ring is empty.
+ * Consumer only.
+ *
+ * Returns: (transfer full) (nullable): the item, or %NULL once @ring is
+ * closed and all the items queued before were dequeued
+ */
+gpointer gst_cuda_spsc_ring_pop(GstCudaSpscRing *ring)
+{
+    gpointer item;
+
+    g_return_val_if_fail(ring != NULL, NULL);
+
+    while(!(item = gst_cuda_spsc_ring_try_pop(ring)))
+    {
+        gint seq;
+
+        /* the items pushed before closing are visible by now */
+        if(g_atomic_int_get(&ring->closed))
+            return gst_cuda_spsc_ring_try_pop(ring);
+
+        seq = g_atomic_int_get(&ring->not_empty_seq);
+        g_atomic_int_inc(&ring->consumer_waiting);
+
+        if(gst_cuda_spsc_ring_get_length(ring) == 0
+           && !g_atomic_int_get(&ring->closed))
+            gst_cuda_spsc_ring_wait(ring, &ring->not_empty_seq, seq);
+
+        g_atomic_int_add(&ring->consumer_waiting, -1);
+    }
+
+    return item;
+}
+
+/**
+ * gst_cuda_spsc_ring_close:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Stops accepting new items and wakes up both sides. The consumer can
+ * still dequeue the items queued so far, after which
+ * gst_cuda_spsc_ring_pop() returns %NULL without waiting. Can be called
+ * from any thread.
+ */
+void gst_cuda_spsc_ring_close(GstCudaSpscRing *ring)
+{
+    g_return_if_fail(ring != NULL);
+
+    g_atomic_int_set(&ring->closed, TRUE);
+
+    gst_cuda_spsc_ring_wake(ring, &ring->not_empty_seq);
+    gst_cuda_spsc_ring_wake(ring, &ring->not_full_seq);
+}
+
+/**
+ * gst_cuda_spsc_ring_is_closed:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Returns: whether gst_cuda_spsc_ring_close() was called since @ring was
+ * created or reopened
+ */
+gboolean gst_cuda_spsc_ring_is_closed(GstCudaSpscRing *ring)
+{
+    g_return_val_if_fail(ring != NULL, FALSE);
+
+    return g_atomic_int_get(&ring->closed);
+}
+
+/**
+ * gst_cuda_spsc_ring_reopen:
+ * @ring: a #GstCudaSpscRing
+ *
+ * Accepts items again after gst_cuda_spsc_ring_close(), keeping the queued
+ * ones. Must not be called while the producer or the consumer is using
+ * @ring.
+ */
+void gst_cuda_spsc_ring_reopen(GstCudaSpscRing *ring)
+{
+    g_return_if_fail(ring != NULL);
+
+    g_atomic_int_set(&ring->closed, FALSE);
+}
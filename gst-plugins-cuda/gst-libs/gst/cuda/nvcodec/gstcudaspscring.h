@@ -0,0 +1,78 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CUDA_SPSC_RING_H__
+#define __GST_CUDA_SPSC_RING_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * GstCudaSpscRing:
+ *
+ * Bounded queue of pointers between exactly one producer thread and one
+ * consumer thread, used to hand frames over between the streaming thread
+ * of an element and its worker thread.
+ *
+ * Pushing and popping only take atomic operations. A thread which has to
+ * wait for the ring to become non-empty or non-full sleeps on a futex
+ * which the other side only wakes when a waiter is registered.
+ *
+ * Closing the ring lets the consumer drain the items pushed so far, after
+ * which gst_cuda_spsc_ring_pop() returns %NULL instead of blocking. %NULL
+ * cannot be pushed.
+ */
+typedef struct _GstCudaSpscRing GstCudaSpscRing;
+
+extern __attribute__((visibility("default"))) GstCudaSpscRing *
+gst_cuda_spsc_ring_new(guint min_capacity);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_spsc_ring_free(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) guint
+gst_cuda_spsc_ring_get_capacity(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) guint
+gst_cuda_spsc_ring_get_length(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_spsc_ring_push(GstCudaSpscRing *ring, gpointer item);
+
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_spsc_ring_try_push(GstCudaSpscRing *ring, gpointer item);
+
+extern __attribute__((visibility("default"))) gpointer
+gst_cuda_spsc_ring_pop(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) gpointer
+gst_cuda_spsc_ring_try_pop(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_spsc_ring_close(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_spsc_ring_is_closed(GstCudaSpscRing *ring);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_spsc_ring_reopen(GstCudaSpscRing *ring);
+
+G_END_DECLS
+
+#endif /* __GST_CUDA_SPSC_RING_H__ */
@@ -0,0 +1,361 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcudasurfacepool.h"
+
+#define WORD_BITS 32
+#define FULL_WORD 0xffffffffu
+
+struct _GstCudaSurfacePool
+{
+    gint ref_count; /* ATOMIC */
+
+    guint max_size;
+
+    /* number of usable surfaces, only grows. ATOMIC */
+    gint size;
+
+    /* one bit per surface, set while the surface is acquired. The bits of
+     * the surfaces the pool has not grown to yet are set as well, so that
+     * the lookup does not need to look at the size. ATOMIC */
+    guint *busy;
+    guint n_words;
+
+    /* stats, ATOMIC */
+    gint in_use;
+    gint peak_in_use;
+    gint num_acquired;
+    gint num_waits;
+    gint num_failures;
+
+    /* acquisitions do not wait while set. ATOMIC */
+    gint flushing;
+
+    /* slow path, only used once all the surfaces are acquired */
+    gint n_waiters; /* ATOMIC */
+    GMutex lock;
+    GCond cond;
+};
+
+static inline guint count_trailing_zeros(guint value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    guint count = 0;
+
+    while(!(value & 1))
+    {
+        value >>= 1;
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+/**
+ * gst_cuda_surface_pool_new:
+ * @initial_size: the number of surfaces usable from the start
+ * @max_size: the number of surfaces the pool can grow to
+ *
+ * Creates a pool handing out the indices 0 to @max_size - 1. The caller is
+ * expected to have allocated @max_size surfaces, the pool only limits how
+ * many of them are in use.
+ *
+ * Returns: a new #GstCudaSurfacePool, or %NULL if @initial_size is zero or
+ * larger than @max_size
+ */
+GstCudaSurfacePool *gst_cuda_surface_pool_new(guint initial_size, guint max_size)
+{
+    GstCudaSurfacePool *pool;
+    guint i;
+
+    g_return_val_if_fail(initial_size > 0, NULL);
+    g_return_val_if_fail(initial_size <= max_size, NULL);
+    g_return_val_if_fail(max_size <= G_MAXINT, NULL);
+
+    pool = g_new0(GstCudaSurfacePool, 1);
+    pool->ref_count = 1;
+    pool->max_size = max_size;
+    pool->size = initial_size;
+    pool->n_words = (max_size + WORD_BITS - 1) / WORD_BITS;
+    pool->busy = g_new(guint, pool->n_words);
+
+    for(i = 0; i < pool->n_words; i++)
+    {
+        guint first = i * WORD_BITS;
+        guint bits = 0;
+
+        if(initial_size < first + WORD_BITS)
+        {
+            guint n_free = initial_size > first ? initial_size - first : 0;
+
+            bits = FULL_WORD << n_free;
+        }
+
+        pool->busy[i] = bits;
+    }
+
+    g_mutex_init(&pool->lock);
+    g_cond_init(&pool->cond);
+
+    return pool;
+}
+
+/**
+ * gst_cuda_surface_pool_ref:
+ * @pool: a #GstCudaSurfacePool
+ *
+ * Returns: @pool
+ */
+GstCudaSurfacePool *gst_cuda_surface_pool_ref(GstCudaSurfacePool *pool)
+{
+    g_return_val_if_fail(pool != NULL, NULL);
+
+    g_atomic_int_inc(&pool->ref_count);
+
+    return pool;
+}
+
+/**
+ * gst_cuda_surface_pool_unref:
+ * @pool: a #GstCudaSurfacePool
+ *
+ * Drops a reference of @pool, freeing it once the last one is gone.
+ */
+void gst_cuda_surface_pool_unref(GstCudaSurfacePool *pool)
+{
+    g_return_if_fail(pool != NULL);
+
+    if(!g_atomic_int_dec_and_test(&pool->ref_count))
+        return;
+
+    g_mutex_clear(&pool->lock);
+    g_cond_clear(&pool->cond);
+    g_free(pool->busy);
+    g_free(pool);
+}
+
+static gint gst_cuda_surface_pool_try_acquire(GstCudaSurfacePool *pool)
+{
+    guint i;
+    gint size;
+
+    for(i = 0; i < pool->n_words; i++)
+    {
+        guint bits = (guint)g_atomic_int_get((gint *)&pool->busy[i]);
+
+        while(bits != FULL_WORD)
+        {
+            guint bit = count_trailing_zeros(~bits);
+
+            if(g_atomic_int_compare_and_exchange(
+                   (gint *)&pool->busy[i], (gint)bits, (gint)(bits | (1u << bit))))
+                return i * WORD_BITS + bit;
+
+            bits = (guint)g_atomic_int_get((gint *)&pool->busy[i]);
+        }
+    }
+
+    /* everything is in use, grow. The bit of the new surface is already set,
+     * so it belongs to whoever increments the size */
+    size = g_atomic_int_get(&pool->size);
+    while(size < (gint)pool->max_size)
+    {
+        if(g_atomic_int_compare_and_exchange(&pool->size, size, size + 1))
+            return size;
+
+        size = g_atomic_int_get(&pool->size);
+    }
+
+    return -1;
+}
+
+static void gst_cuda_surface_pool_update_in_use(GstCudaSurfacePool *pool)
+{
+    gint in_use = g_atomic_int_add(&pool->in_use, 1) + 1;
+    gint peak = g_atomic_int_get(&pool->peak_in_use);
+
+    while(in_use > peak
+          && !g_atomic_int_compare_and_exchange(&pool->peak_in_use, peak, in_use))
+        peak = g_atomic_int_get(&pool->peak_in_use);
+
+    g_atomic_int_inc(&pool->num_acquired);
+}
+
+/**
+ * gst_cuda_surface_pool_acquire:
+ * @pool: a #GstCudaSurfacePool
+ * @timeout: how long to wait for a surface to be released once the pool
+ * cannot grow anymore. 0 to not wait, %GST_CLOCK_TIME_NONE to wait forever
+ *
+ * Acquires the lowest free surface index, growing the pool if all the
+ * surfaces are in use. This does not take any lock unless it has to wait.
+ * While @pool is flushing, this does not wait and a waiting acquisition
+ * gives up.
+ *
+ * Returns: the index of the acquired surface, or -1 if there was none
+ * available within @timeout
+ */
+gint gst_cuda_surface_pool_acquire(GstCudaSurfacePool *pool, GstClockTime timeout)
+{
+    gint64 end_time = 0;
+    gint index;
+
+    g_return_val_if_fail(pool != NULL, -1);
+
+    index = gst_cuda_surface_pool_try_acquire(pool);
+    if(index >= 0 || timeout == 0 || g_atomic_int_get(&pool->flushing))
+        goto done;
+
+    if(GST_CLOCK_TIME_IS_VALID(timeout))
+        end_time = g_get_monotonic_time() + timeout / GST_USECOND;
+
+    g_mutex_lock(&pool->lock);
+    g_atomic_int_inc(&pool->n_waiters);
+    g_atomic_int_inc(&pool->num_waits);
+
+    /* the waiter count is raised before retrying, so that a release which
+     * happens from now on signals the condition */
+    while((index = gst_cuda_surface_pool_try_acquire(pool)) < 0)
+    {
+        if(g_atomic_int_get(&pool->flushing))
+        {
+            break;
+        }
+        else if(!GST_CLOCK_TIME_IS_VALID(timeout))
+        {
+            g_cond_wait(&pool->cond, &pool->lock);
+        }
+        else if(!g_cond_wait_until(&pool->cond, &pool->lock, end_time))
+        {
+            index = gst_cuda_surface_pool_try_acquire(pool);
+            break;
+        }
+    }
+
+    g_atomic_int_add(&pool->n_waiters, -1);
+    g_mutex_unlock(&pool->lock);
+
+done:
+    if(index >= 0)
+        gst_cuda_surface_pool_update_in_use(pool);
+    else
+        g_atomic_int_inc(&pool->num_failures);
+
+    return index;
+}
+
+/**
+ * gst_cuda_surface_pool_release:
+ * @pool: a #GstCudaSurfacePool
+ * @index: a surface index returned by gst_cuda_surface_pool_acquire()
+ *
+ * Releases the surface @index, waking up an acquisition waiting for it.
+ */
+void gst_cuda_surface_pool_release(GstCudaSurfacePool *pool, gint index)
+{
+    guint mask;
+
+    g_return_if_fail(pool != NULL);
+    g_return_if_fail(index >= 0 && index < (gint)pool->max_size);
+
+    mask = 1u << (index % WORD_BITS);
+
+    if(!(g_atomic_int_and(&pool->busy[index / WORD_BITS], ~mask) & mask))
+    {
+        g_critical("Surface %d released twice", index);
+        return;
+    }
+
+    g_atomic_int_add(&pool->in_use, -1);
+
+    if(g_atomic_int_get(&pool->n_waiters) > 0)
+    {
+        g_mutex_lock(&pool->lock);
+        g_cond_signal(&pool->cond);
+        g_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * gst_cuda_surface_pool_set_flushing:
+ * @pool: a #GstCudaSurfacePool
+ * @flushing: whether @pool is flushing
+ *
+ * While @pool is flushing, gst_cuda_surface_pool_acquire() fails right away
+ * instead of waiting for a surface to be released, and the acquisitions
+ * already waiting give up. Used to unblock the streaming thread on flush and
+ * on state changes.
+ */
+void gst_cuda_surface_pool_set_flushing(GstCudaSurfacePool *pool, gboolean flushing)
+{
+    g_return_if_fail(pool != NULL);
+
+    g_atomic_int_set(&pool->flushing, flushing ? 1 : 0);
+
+    if(flushing)
+    {
+        /* taking the lock makes sure a waiter either sees the flag before
+         * waiting or is woken up here */
+        g_mutex_lock(&pool->lock);
+        g_cond_broadcast(&pool->cond);
+        g_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * gst_cuda_surface_pool_get_max_size:
+ * @pool: a #GstCudaSurfacePool
+ *
+ * Returns: the number of surfaces @pool can grow to
+ */
+guint gst_cuda_surface_pool_get_max_size(GstCudaSurfacePool *pool)
+{
+    g_return_val_if_fail(pool != NULL, 0);
+
+    return pool->max_size;
+}
+
+/**
+ * gst_cuda_surface_pool_get_stats:
+ * @pool: a #GstCudaSurfacePool
+ * @stats: (out): the occupancy statistics of @pool
+ *
+ * Fills @stats with a snapshot of the occupancy of @pool.
+ */
+void gst_cuda_surface_pool_get_stats(
+    GstCudaSurfacePool *pool,
+    GstCudaSurfacePoolStats *stats)
+{
+    g_return_if_fail(pool != NULL);
+    g_return_if_fail(stats != NULL);
+
+    stats->size = g_atomic_int_get(&pool->size);
+    stats->max_size = pool->max_size;
+    stats->in_use = g_atomic_int_get(&pool->in_use);
+    stats->peak_in_use = g_atomic_int_get(&pool->peak_in_use);
+    stats->num_acquired = g_atomic_int_get(&pool->num_acquired);
+    stats->num_waits = g_atomic_int_get(&pool->num_waits);
+    stats->num_failures = g_atomic_int_get(&pool->num_failures);
+}
@@ -0,0 +1,90 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CUDA_SURFACE_POOL_H__
+#define __GST_CUDA_SURFACE_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * GstCudaSurfacePool:
+ *
+ * Allocator for the indices of a fixed set of decode surfaces, as used by
+ * NVDEC (CUVIDPICPARAMS::CurrPicIdx).
+ *
+ * Free surfaces are tracked in a bitmap which is updated with atomic
+ * operations only, so that acquiring and releasing a surface is lock-free.
+ * The pool starts with a number of usable surfaces and grows one surface at
+ * a time, up to its maximum size, when all of them are in use. Once the
+ * maximum size is reached, acquiring can block until a surface is released
+ * or the pool is set flushing.
+ */
+typedef struct _GstCudaSurfacePool GstCudaSurfacePool;
+
+/*
+ * GstCudaSurfacePoolStats:
+ * @size: the number of surfaces the pool has grown to
+ * @max_size: the maximum number of surfaces
+ * @in_use: the number of surfaces currently acquired
+ * @peak_in_use: the highest number of surfaces acquired at the same time
+ * @num_acquired: the number of successful acquisitions
+ * @num_waits: the number of acquisitions which had to wait for a release
+ * @num_failures: the number of acquisitions which failed or timed out
+ */
+typedef struct _GstCudaSurfacePoolStats
+{
+    guint size;
+    guint max_size;
+    guint in_use;
+    guint peak_in_use;
+    guint num_acquired;
+    guint num_waits;
+    guint num_failures;
+} GstCudaSurfacePoolStats;
+
+extern __attribute__((visibility("default"))) GstCudaSurfacePool *
+gst_cuda_surface_pool_new(guint initial_size, guint max_size);
+
+extern __attribute__((visibility("default"))) GstCudaSurfacePool *
+gst_cuda_surface_pool_ref(GstCudaSurfacePool *pool);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_surface_pool_unref(GstCudaSurfacePool *pool);
+
+extern __attribute__((visibility("default"))) gint
+gst_cuda_surface_pool_acquire(GstCudaSurfacePool *pool, GstClockTime timeout);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_surface_pool_release(GstCudaSurfacePool *pool, gint index);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_surface_pool_set_flushing(GstCudaSurfacePool *pool, gboolean flushing);
+
+extern __attribute__((visibility("default"))) guint
+gst_cuda_surface_pool_get_max_size(GstCudaSurfacePool *pool);
+
+extern __attribute__((visibility("default"))) void
+gst_cuda_surface_pool_get_stats(
+    GstCudaSurfacePool *pool,
+    GstCudaSurfacePoolStats *stats);
+
+G_END_DECLS
+
+#endif /* __GST_CUDA_SURFACE_POOL_H__ */
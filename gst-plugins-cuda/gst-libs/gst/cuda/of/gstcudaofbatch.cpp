@@ -0,0 +1,112 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaofbatch.h>
+
+#include <cstring>
+#include <glib-object.h>
+#include <gst/gst.h>
+
+/*
+ * The radius of the neighbourhood of the polynomial expansion used by the
+ * cudaofbatch element, plus the two rows the 5-tap Gaussian filter of the
+ * pyramid reaches into.
+ */
+#define BATCH_GUARD_KERNEL_ROWS (5 + 2)
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_batch_backend_get_type()
+{
+    static GType backend_type = 0;
+    static const GEnumValue backends[]
+        = {{BATCH_BACKEND_CUDA,
+            "Calculate the batch on the GPU with a single launch",
+            "cuda"},
+           {BATCH_BACKEND_CPU, "Calculate the batch on the host", "cpu"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&backend_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfBatchBackend"), backends);
+        g_once_init_leave(&backend_type, new_type);
+    }
+
+    return backend_type;
+}
+
+extern guint gst_cuda_of_batch_slot_rows(
+    guint height,
+    guint window_size,
+    guint number_of_levels)
+{
+    guint levels = MAX(number_of_levels, 1u);
+    guint alignment = 1u << levels;
+
+    /*
+     * A row of the coarsest level covers 2 ^ (levels - 1) rows of the frame,
+     * so the guard has to be scaled up by that much to still separate the
+     * frames there.
+     */
+    guint guard = (window_size / 2u + BATCH_GUARD_KERNEL_ROWS) << (levels - 1u);
+    guint rows = height + guard;
+
+    return ((rows + alignment - 1u) / alignment) * alignment;
+}
+
+extern void gst_cuda_of_batch_features(
+    const gfloat *flow,
+    gsize stride,
+    guint width,
+    guint height,
+    guint slot_rows,
+    guint slots,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    gfloat threshold,
+    gfloat *features)
+{
+    gsize features_per_slot = (gsize)features_matrix_width * features_matrix_height;
+
+    g_return_if_fail(features != NULL || features_per_slot * slots == 0);
+    g_return_if_fail(flow != NULL || slots == 0 || width == 0 || height == 0);
+
+    if(features_per_slot == 0)
+    {
+        return;
+    }
+
+    std::memset(features, 0, sizeof(gfloat) * features_per_slot * slots);
+
+    for(guint slot = 0; slot < slots; slot++)
+    {
+        gfloat *slot_features = features + features_per_slot * slot;
+
+        for(guint y = 0; y < height; y++)
+        {
+            const gfloat *row = (const gfloat *)((const guint8 *)flow
+                                                 + stride * ((gsize)slot * slot_rows + y));
+            gfloat *feature_row = slot_features
+                                  + (gsize)features_matrix_width
+                                        * ((guint64)y * features_matrix_height / height);
+
+            for(guint x = 0; x < width; x++)
+            {
+                gfloat flow_x = row[2 * x];
+                gfloat flow_y = row[2 * x + 1];
+                gfloat *feature = feature_row
+                                  + (guint64)x * features_matrix_width / width;
+
+                if(flow_x * flow_x > threshold)
+                {
+                    *feature += flow_x >= 0.0f ? flow_x : -flow_x;
+                }
+
+                if(flow_y * flow_y > threshold)
+                {
+                    *feature += flow_y >= 0.0f ? flow_y : -flow_y;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef _CUDA_OF_BATCH_H_
+#define _CUDA_OF_BATCH_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_BATCH_BACKEND (gst_cuda_of_batch_backend_get_type())
+
+/**
+ * \brief An enumeration containing the list of backends the cudaofbatch
+ * element can calculate the batched optical flow and features with.
+ */
+typedef enum _GstCudaOfBatchBackend
+{
+    /**
+     * \brief The stacked luma is processed on the GPU with a single Farneback
+     * calculation and a single feature extraction kernel launch.
+     *
+     * \notes This requires buffers with the CUDAMemory memory type.
+     */
+    BATCH_BACKEND_CUDA = 0,
+    /**
+     * \brief The stacked luma is processed on the host with OpenCV.
+     *
+     * \notes This exists to test the batching without a GPU. Only the
+     * features are attached, as there is no GPU matrix to attach the optical
+     * flow vectors with.
+     */
+    BATCH_BACKEND_CPU = 1,
+
+} GstCudaOfBatchBackend;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfBatchBackend enum
+ * type.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfBatchBackend enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_batch_backend_get_type();
+
+/**
+ * \brief Calculates the number of rows each frame occupies in the stacked
+ * luma and optical flow matrices.
+ *
+ * \details The frames are separated by rows of zeros, so that the
+ * neighbourhoods of the polynomial expansion and of the Farneback window do
+ * not reach into the neighbouring frames on any level of the pyramid. The
+ * rows per frame are rounded up to a multiple of the pyramid's scale, so that
+ * every frame starts on the same row of every level.
+ *
+ * \param[in] height The number of rows of a frame.
+ * \param[in] window_size The size of the Farneback window.
+ * \param[in] number_of_levels The number of levels of the Farneback pyramid.
+ *
+ * \returns The number of rows between the first rows of two stacked frames.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_cuda_of_batch_slot_rows(
+    guint height,
+    guint window_size,
+    guint number_of_levels);
+
+/**
+ * \brief Extracts the spatial magnitude features of every frame of a stacked
+ * optical flow matrix on the host.
+ *
+ * \details A vector contributes its absolute X and Y values to the feature of
+ * the cell it lies in, if the squared value exceeds the threshold. The frame
+ * is split into cells evenly, with the pixel at x belonging to the column
+ * `x * features_matrix_width / width`. This matches the feature kernel of the
+ * CUDA backend.
+ *
+ * \param[in] flow A pointer to the first row of the stacked 2-channel 32-bit
+ * floating point optical flow matrix.
+ * \param[in] stride The number of bytes between two rows of the matrix.
+ * \param[in] width The number of vectors per row of a frame.
+ * \param[in] height The number of rows of a frame.
+ * \param[in] slot_rows The number of rows between the first rows of two
+ * stacked frames.
+ * \param[in] slots The number of stacked frames.
+ * \param[in] features_matrix_width The number of feature columns per frame.
+ * \param[in] features_matrix_height The number of feature rows per frame.
+ * \param[in] threshold The threshold the squared X and Y values have to exceed.
+ * \param[out] features A pointer to slots * features_matrix_height *
+ * features_matrix_width features, written frame by frame in row-major order.
+ */
+extern __attribute__((visibility("default"))) void gst_cuda_of_batch_features(
+    const gfloat *flow,
+    gsize stride,
+    guint width,
+    guint height,
+    guint slot_rows,
+    guint slots,
+    guint features_matrix_width,
+    guint features_matrix_height,
+    gfloat threshold,
+    gfloat *features);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,28 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaofflowscale.h>
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_flow_scale_get_type()
+{
+    static GType flow_scale_type = 0;
+    static const GEnumValue flow_scales[]
+        = {{OPTICAL_FLOW_SCALE_1, "Full resolution", "1/1"},
+           {OPTICAL_FLOW_SCALE_2, "Half resolution", "1/2"},
+           {OPTICAL_FLOW_SCALE_4, "Quarter resolution", "1/4"},
+           {OPTICAL_FLOW_SCALE_8, "Eighth resolution", "1/8"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&flow_scale_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfFlowScale"), flow_scales);
+        g_once_init_leave(&flow_scale_type, new_type);
+    }
+
+    return flow_scale_type;
+}
@@ -0,0 +1,63 @@
+#ifndef _CUDA_OF_FLOW_SCALE_H_
+#define _CUDA_OF_FLOW_SCALE_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_FLOW_SCALE (gst_cuda_of_flow_scale_get_type())
+
+/**
+ * \brief An enumeration containing the list of resolutions, relative to the
+ * frames, the optical flow can be calculated at.
+ *
+ * \notes The value of each entry is the factor the width and height of the
+ * luma are divided by before the optical flow is calculated. Each optical
+ * flow vector then covers that many more pixels of the frame, which is
+ * recorded in the vector grid size of the metadata.
+ */
+typedef enum _GstCudaOfFlowScale
+{
+    /**
+     * \brief The optical flow is calculated at the resolution of the frames.
+     */
+    OPTICAL_FLOW_SCALE_1 = 1,
+    /**
+     * \brief The optical flow is calculated at half the width and height of
+     * the frames.
+     */
+    OPTICAL_FLOW_SCALE_2 = 2,
+    /**
+     * \brief The optical flow is calculated at a quarter of the width and
+     * height of the frames.
+     */
+    OPTICAL_FLOW_SCALE_4 = 4,
+    /**
+     * \brief The optical flow is calculated at an eighth of the width and
+     * height of the frames.
+     */
+    OPTICAL_FLOW_SCALE_8 = 8
+
+} GstCudaOfFlowScale;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfFlowScale enum
+ * type.
+ *
+ * \details This function creates and registers the GstCudaOfFlowScale enum
+ * type for the first invocation. The GType instance for the
+ * GstCudaOfFlowScale enum type is then returned.
+ *
+ * \details For subsequent invocations, the GType instance for the
+ * GstCudaOfFlowScale enum type is returned immediately.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfFlowScale enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_flow_scale_get_type();
+
+G_END_DECLS
+
+#endif
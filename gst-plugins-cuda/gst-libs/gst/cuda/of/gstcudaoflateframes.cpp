@@ -0,0 +1,29 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaoflateframes.h>
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_late_frames_get_type()
+{
+    static GType late_frames_type = 0;
+    static const GEnumValue late_frames[]
+        = {{LATE_FRAMES_PROCESS, "Process late frames", "process"},
+           {LATE_FRAMES_DROP, "Drop late frames", "drop"},
+           {LATE_FRAMES_SKIP,
+            "Attach synthetic optical flow to late frames",
+            "skip"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&late_frames_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfLateFrames"), late_frames);
+        g_once_init_leave(&late_frames_type, new_type);
+    }
+
+    return late_frames_type;
+}
@@ -0,0 +1,55 @@
+#ifndef _CUDA_OF_LATE_FRAMES_H_
+#define _CUDA_OF_LATE_FRAMES_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_LATE_FRAMES (gst_cuda_of_late_frames_get_type())
+
+/**
+ * \brief An enumeration containing the list of ways to handle frames that
+ * the QoS events received from downstream report as late.
+ */
+typedef enum _GstCudaOfLateFrames
+{
+    /**
+     * \brief Late frames are processed like any other frame.
+     */
+    LATE_FRAMES_PROCESS = 0,
+    /**
+     * \brief Late frames are dropped, without calculating their optical flow.
+     */
+    LATE_FRAMES_DROP = 1,
+    /**
+     * \brief Late frames are passed on with synthetic optical flow vectors,
+     * as if the motion gate had skipped them.
+     *
+     * \notes This keeps every frame flowing downstream, which matters when
+     * the frames are recorded or encoded after the analytics.
+     */
+    LATE_FRAMES_SKIP = 2,
+
+} GstCudaOfLateFrames;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfLateFrames enum
+ * type.
+ *
+ * \details This function creates and registers the GstCudaOfLateFrames enum
+ * type for the first invocation. The GType instance for the
+ * GstCudaOfLateFrames enum type is then returned.
+ *
+ * \details For subsequent invocations, the GType instance for the
+ * GstCudaOfLateFrames enum type is returned immediately.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfLateFrames enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_late_frames_get_type();
+
+G_END_DECLS
+
+#endif
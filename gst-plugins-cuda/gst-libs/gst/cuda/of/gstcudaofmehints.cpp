@@ -0,0 +1,479 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/nvcodec/gstcudacontext.h>
+#include <gst/cuda/of/gstcudaofmehints.h>
+#include <gst/cuda/of/gstmetaopticalflow.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glib-object.h>
+#include <gst/gst.h>
+#include <opencv2/core.hpp>
+#include <vector>
+
+/*
+ * The ranges of the S12.0 horizontal and S10.0 vertical motion vector
+ * components of NVENC_EXTERNAL_ME_HINT.
+ */
+#define ME_HINT_MVX_MIN (-2048)
+#define ME_HINT_MVX_MAX 2047
+#define ME_HINT_MVY_MIN (-512)
+#define ME_HINT_MVY_MAX 511
+
+/*
+ * The bit layout of NVENC_EXTERNAL_ME_HINT, see nvEncodeAPI.h. The reference
+ * index, direction and partition type are all left at zero, i.e. reference
+ * zero of L0 and the 16x16 partition.
+ */
+#define ME_HINT_MVX_SHIFT 0
+#define ME_HINT_MVX_MASK 0xfffu
+#define ME_HINT_MVY_SHIFT 12
+#define ME_HINT_MVY_MASK 0x3ffu
+#define ME_HINT_LAST_OF_PART (1u << 30)
+#define ME_HINT_LAST_OF_MB (1u << 31)
+
+/* The NVIDIA Optical Flow vectors are S10.5 fixed point values. */
+#define FIXED_POINT_VECTOR_SCALE (1.0f / 32.0f)
+
+/************************** Type/Struct Definitions ***************************/
+
+struct _GstCudaOfMeHints
+{
+    /**
+     * \brief The dimensions, in pixels, of the frames being encoded.
+     */
+    guint frame_width;
+    guint frame_height;
+
+    /**
+     * \brief The number of 16x16 blocks per row and per column of the frames
+     * being encoded.
+     */
+    guint blocks_x;
+    guint blocks_y;
+
+    /**
+     * \brief The method used to pool the optical flow vectors of a block.
+     */
+    GstCudaOfMeHintPooling pooling;
+
+    /**
+     * \brief The optical flow vector components of the block being converted.
+     *
+     * \notes These are only ever grown, so that no memory is allocated once
+     * the first frame was converted.
+     */
+    std::vector<float> block_vectors_x;
+    std::vector<float> block_vectors_y;
+
+    /**
+     * \brief The first and past the last optical flow vector columns of each
+     * column of blocks.
+     */
+    std::vector<guint> block_cols;
+
+    /**
+     * \brief The host copy of the optical flow vectors of the last buffer
+     * given to gst_cuda_of_me_hints_convert_buffer().
+     */
+    cv::Mat host_optical_flow_vectors;
+};
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Maps a range of pixels of the encoded frame to the range of optical
+ * flow vectors covering it.
+ *
+ * \param[in] first The first pixel of the range.
+ * \param[in] last The pixel following the last pixel of the range.
+ * \param[in] scale The ratio between the size of the frame the optical flow
+ * was computed on and the size of the encoded frame.
+ * \param[in] grid_size The size, in pixels, of the square covered by a single
+ * optical flow vector.
+ * \param[in] count The number of optical flow vectors along the dimension.
+ * \param[out] first_vector The first optical flow vector of the range.
+ * \param[out] last_vector The optical flow vector following the last optical
+ * flow vector of the range.
+ */
+static void gst_cuda_of_me_hints_map_range(
+    guint first,
+    guint last,
+    double scale,
+    guint grid_size,
+    guint count,
+    guint *first_vector,
+    guint *last_vector);
+
+/**
+ * \brief Copies the optical flow vectors covering a block into the block
+ * vector components of the converter.
+ *
+ * \tparam T The type of the optical flow vector components.
+ *
+ * \param[in,out] hints A pointer to the converter.
+ * \param[in] optical_flow_vectors A pointer to the first row of optical flow
+ * vectors.
+ * \param[in] stride The number of bytes between two rows of optical flow
+ * vectors.
+ * \param[in] first_col The first optical flow vector column of the block.
+ * \param[in] last_col The optical flow vector column following the last
+ * column of the block.
+ * \param[in] first_row The first optical flow vector row of the block.
+ * \param[in] last_row The optical flow vector row following the last row of
+ * the block.
+ */
+template<typename T>
+static void gst_cuda_of_me_hints_gather(
+    GstCudaOfMeHints *hints,
+    const guint8 *optical_flow_vectors,
+    gsize stride,
+    guint first_col,
+    guint last_col,
+    guint first_row,
+    guint last_row);
+
+/**
+ * \brief Pools the optical flow vector components of a block.
+ *
+ * \param[in] pooling The pooling method.
+ * \param[in,out] components The components to pool, reordered when using the
+ * median.
+ * \param[in] count The number of components to pool.
+ *
+ * \returns The pooled component.
+ */
+static float gst_cuda_of_me_hints_pool(
+    GstCudaOfMeHintPooling pooling,
+    std::vector<float> &components,
+    gsize count);
+
+/**
+ * \brief Packs a motion vector into the bit layout of NVENC_EXTERNAL_ME_HINT.
+ *
+ * \param[in] mvx The horizontal component, in pixels.
+ * \param[in] mvy The vertical component, in pixels.
+ *
+ * \returns The packed motion estimation hint.
+ */
+static guint32 gst_cuda_of_me_hints_pack(float mvx, float mvy);
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_me_hint_pooling_get_type()
+{
+    static GType me_hint_pooling_type = 0;
+    static const GEnumValue me_hint_poolings[]
+        = {{ME_HINT_POOLING_MEAN, "Mean of the block's vectors", "mean"},
+           {ME_HINT_POOLING_MEDIAN, "Median of the block's vectors", "median"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&me_hint_pooling_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfMeHintPooling"),
+            me_hint_poolings);
+        g_once_init_leave(&me_hint_pooling_type, new_type);
+    }
+
+    return me_hint_pooling_type;
+}
+
+extern GstCudaOfMeHints *gst_cuda_of_me_hints_new(
+    guint frame_width,
+    guint frame_height,
+    GstCudaOfMeHintPooling pooling)
+{
+    g_return_val_if_fail(frame_width > 0 && frame_height > 0, NULL);
+
+    GstCudaOfMeHints *hints = new GstCudaOfMeHints();
+
+    hints->frame_width = frame_width;
+    hints->frame_height = frame_height;
+    hints->blocks_x = (frame_width + GST_CUDA_OF_ME_HINT_BLOCK_SIZE - 1)
+                      / GST_CUDA_OF_ME_HINT_BLOCK_SIZE;
+    hints->blocks_y = (frame_height + GST_CUDA_OF_ME_HINT_BLOCK_SIZE - 1)
+                      / GST_CUDA_OF_ME_HINT_BLOCK_SIZE;
+    hints->pooling = pooling;
+
+    return hints;
+}
+
+extern void gst_cuda_of_me_hints_free(GstCudaOfMeHints *hints)
+{
+    delete hints;
+}
+
+extern guint gst_cuda_of_me_hints_get_num_blocks(const GstCudaOfMeHints *hints)
+{
+    g_return_val_if_fail(hints != NULL, 0);
+
+    return hints->blocks_x * hints->blocks_y;
+}
+
+extern gboolean gst_cuda_of_me_hints_convert(
+    GstCudaOfMeHints *hints,
+    const guint8 *optical_flow_vectors,
+    gsize stride,
+    gsize element_size,
+    guint cols,
+    guint rows,
+    guint grid_size,
+    guint32 *packed_hints)
+{
+    g_return_val_if_fail(hints != NULL, FALSE);
+    g_return_val_if_fail(optical_flow_vectors != NULL, FALSE);
+    g_return_val_if_fail(packed_hints != NULL, FALSE);
+    g_return_val_if_fail(element_size == 4 || element_size == 8, FALSE);
+    g_return_val_if_fail(cols > 0 && rows > 0 && grid_size > 0, FALSE);
+    g_return_val_if_fail(stride >= cols * element_size, FALSE);
+
+    /*
+     * The vectors only cover a slightly larger area than the frame when the
+     * frame size is not a multiple of the grid size. Any other difference
+     * means that the optical flow was computed on a scaled frame, in which
+     * case both the grid and the vectors are scaled back.
+     */
+    double scale_x = 1.0;
+    double scale_y = 1.0;
+
+    if((guint64)(cols)*grid_size < hints->frame_width
+       || (guint64)(cols - 1) * grid_size >= hints->frame_width)
+    {
+        scale_x = (double)(cols)*grid_size / hints->frame_width;
+    }
+
+    if((guint64)(rows)*grid_size < hints->frame_height
+       || (guint64)(rows - 1) * grid_size >= hints->frame_height)
+    {
+        scale_y = (double)(rows)*grid_size / hints->frame_height;
+    }
+
+    const float vector_scale_x = (float)(1.0 / scale_x)
+                                 * (element_size == 4 ? FIXED_POINT_VECTOR_SCALE
+                                                      : 1.0f);
+    const float vector_scale_y = (float)(1.0 / scale_y)
+                                 * (element_size == 4 ? FIXED_POINT_VECTOR_SCALE
+                                                      : 1.0f);
+
+    /* The column ranges are the same for every row of blocks */
+    hints->block_cols.resize(2 * hints->blocks_x);
+
+    for(guint block_x = 0; block_x < hints->blocks_x; block_x++)
+    {
+        gst_cuda_of_me_hints_map_range(
+            block_x * GST_CUDA_OF_ME_HINT_BLOCK_SIZE,
+            MIN((block_x + 1) * GST_CUDA_OF_ME_HINT_BLOCK_SIZE,
+                hints->frame_width),
+            scale_x,
+            grid_size,
+            cols,
+            &hints->block_cols[2 * block_x],
+            &hints->block_cols[2 * block_x + 1]);
+    }
+
+    for(guint block_y = 0; block_y < hints->blocks_y; block_y++)
+    {
+        guint first_row, last_row;
+        gst_cuda_of_me_hints_map_range(
+            block_y * GST_CUDA_OF_ME_HINT_BLOCK_SIZE,
+            MIN((block_y + 1) * GST_CUDA_OF_ME_HINT_BLOCK_SIZE,
+                hints->frame_height),
+            scale_y,
+            grid_size,
+            rows,
+            &first_row,
+            &last_row);
+
+        for(guint block_x = 0; block_x < hints->blocks_x; block_x++)
+        {
+            const guint first_col = hints->block_cols[2 * block_x];
+            const guint last_col = hints->block_cols[2 * block_x + 1];
+            const gsize count
+                = (gsize)(last_row - first_row) * (last_col - first_col);
+
+            if(hints->block_vectors_x.size() < count)
+            {
+                hints->block_vectors_x.resize(count);
+                hints->block_vectors_y.resize(count);
+            }
+
+            if(element_size == 4)
+            {
+                gst_cuda_of_me_hints_gather<gint16>(
+                    hints,
+                    optical_flow_vectors,
+                    stride,
+                    first_col,
+                    last_col,
+                    first_row,
+                    last_row);
+            }
+            else
+            {
+                gst_cuda_of_me_hints_gather<float>(
+                    hints,
+                    optical_flow_vectors,
+                    stride,
+                    first_col,
+                    last_col,
+                    first_row,
+                    last_row);
+            }
+
+            /*
+             * The optical flow points from the previous frame into the
+             * current one, whereas the hint points from the current block
+             * into the reference frame, hence the negation.
+             */
+            packed_hints[block_y * hints->blocks_x + block_x]
+                = gst_cuda_of_me_hints_pack(
+                    -vector_scale_x
+                        * gst_cuda_of_me_hints_pool(
+                            hints->pooling, hints->block_vectors_x, count),
+                    -vector_scale_y
+                        * gst_cuda_of_me_hints_pool(
+                            hints->pooling, hints->block_vectors_y, count));
+        }
+    }
+
+    return TRUE;
+}
+
+extern gboolean gst_cuda_of_me_hints_convert_buffer(
+    GstCudaOfMeHints *hints,
+    GstBuffer *buffer,
+    guint32 *packed_hints)
+{
+    g_return_val_if_fail(hints != NULL, FALSE);
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), FALSE);
+
+    GstMetaOpticalFlow *meta = GST_META_OPTICAL_FLOW_GET(buffer);
+
+    if(meta == NULL || meta->optical_flow_vectors == nullptr
+       || meta->optical_flow_vectors->empty() || meta->context == NULL)
+    {
+        return FALSE;
+    }
+
+    if(!gst_cuda_context_push(meta->context))
+    {
+        GST_WARNING("Could not push the CUDA context of the optical flow.");
+        return FALSE;
+    }
+
+    gboolean result = TRUE;
+
+    try
+    {
+        meta->optical_flow_vectors->download(hints->host_optical_flow_vectors);
+    }
+    catch(cv::Exception &ex)
+    {
+        GST_WARNING("Could not download the optical flow - %s", ex.what());
+        result = FALSE;
+    }
+
+    gst_cuda_context_pop(NULL);
+
+    if(!result)
+    {
+        return FALSE;
+    }
+
+    const cv::Mat &vectors = hints->host_optical_flow_vectors;
+
+    return gst_cuda_of_me_hints_convert(
+        hints,
+        vectors.data,
+        vectors.step,
+        vectors.elemSize(),
+        vectors.cols,
+        vectors.rows,
+        MAX(meta->optical_flow_vector_grid_size, 1),
+        packed_hints);
+}
+
+static void gst_cuda_of_me_hints_map_range(
+    guint first,
+    guint last,
+    double scale,
+    guint grid_size,
+    guint count,
+    guint *first_vector,
+    guint *last_vector)
+{
+    guint start = (guint)(first * scale) / grid_size;
+    guint end = (guint)(std::ceil(last * scale)) / grid_size
+                + ((guint)(std::ceil(last * scale)) % grid_size != 0);
+
+    start = MIN(start, count - 1);
+    end = CLAMP(end, start + 1, count);
+
+    *first_vector = start;
+    *last_vector = end;
+}
+
+template<typename T>
+static void gst_cuda_of_me_hints_gather(
+    GstCudaOfMeHints *hints,
+    const guint8 *optical_flow_vectors,
+    gsize stride,
+    guint first_col,
+    guint last_col,
+    guint first_row,
+    guint last_row)
+{
+    float *vectors_x = hints->block_vectors_x.data();
+    float *vectors_y = hints->block_vectors_y.data();
+
+    for(guint row = first_row; row < last_row; row++)
+    {
+        const guint8 *row_data = optical_flow_vectors + row * stride;
+
+        for(guint col = first_col; col < last_col; col++)
+        {
+            /* The rows of a downloaded matrix are not necessarily aligned */
+            T vector[2];
+            memcpy(vector, row_data + col * sizeof(vector), sizeof(vector));
+            *vectors_x++ = vector[0];
+            *vectors_y++ = vector[1];
+        }
+    }
+}
+
+static float gst_cuda_of_me_hints_pool(
+    GstCudaOfMeHintPooling pooling,
+    std::vector<float> &components,
+    gsize count)
+{
+    if(pooling == ME_HINT_POOLING_MEDIAN)
+    {
+        auto middle = components.begin() + count / 2;
+        std::nth_element(components.begin(), middle, components.begin() + count);
+        return *middle;
+    }
+
+    float sum = 0.0f;
+
+    for(gsize idx = 0; idx < count; idx++)
+    {
+        sum += components[idx];
+    }
+
+    return sum / count;
+}
+
+static guint32 gst_cuda_of_me_hints_pack(float mvx, float mvy)
+{
+    /* fmax() also maps invalid vectors (NaN) to the range */
+    gint x = (gint)(std::lround(
+        std::fmin(std::fmax(mvx, ME_HINT_MVX_MIN), ME_HINT_MVX_MAX)));
+    gint y = (gint)(std::lround(
+        std::fmin(std::fmax(mvy, ME_HINT_MVY_MIN), ME_HINT_MVY_MAX)));
+
+    return (((guint32)(x)&ME_HINT_MVX_MASK) << ME_HINT_MVX_SHIFT)
+           | (((guint32)(y)&ME_HINT_MVY_MASK) << ME_HINT_MVY_SHIFT)
+           | ME_HINT_LAST_OF_PART | ME_HINT_LAST_OF_MB;
+}
@@ -0,0 +1,187 @@
+#ifndef _CUDA_OF_ME_HINTS_H_
+#define _CUDA_OF_ME_HINTS_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_ME_HINT_POOLING (gst_cuda_of_me_hint_pooling_get_type())
+
+/**
+ * \brief The size of the blocks, in pixels, that the motion estimation hints
+ * are generated for.
+ *
+ * \notes NVENC takes one hint per 16x16 macroblock for the 16x16 partition
+ * type, which is the only partition type that the hints are generated for.
+ */
+#define GST_CUDA_OF_ME_HINT_BLOCK_SIZE 16
+
+/**
+ * \brief An enumeration containing the list of methods used to pool the
+ * optical flow vectors covering a block into the single motion vector of the
+ * block's motion estimation hint.
+ */
+typedef enum _GstCudaOfMeHintPooling
+{
+    /**
+     * \brief Uses the mean of the optical flow vectors covering the block.
+     *
+     * \notes This is the cheapest method, but a few outlier vectors, e.g. on
+     * object boundaries, pull the hint away from the dominant motion of the
+     * block.
+     */
+    ME_HINT_POOLING_MEAN = 0,
+    /**
+     * \brief Uses the component-wise median of the optical flow vectors
+     * covering the block.
+     */
+    ME_HINT_POOLING_MEDIAN = 1,
+
+} GstCudaOfMeHintPooling;
+
+/**
+ * \brief An opaque structure holding the state used to convert optical flow
+ * vectors into NVENC external motion estimation hints.
+ *
+ * \details The structure holds the dimensions of the frames being encoded and
+ * the scratch memory used during the conversion, so that converting the
+ * optical flow vectors of a frame does not allocate any memory once the
+ * first frame was converted.
+ */
+typedef struct _GstCudaOfMeHints GstCudaOfMeHints;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfMeHintPooling
+ * enum type.
+ *
+ * \details This function creates and registers the GstCudaOfMeHintPooling
+ * enum type for the first invocation. The GType instance for the
+ * GstCudaOfMeHintPooling enum type is then returned.
+ *
+ * \details For subsequent invocations, the GType instance for the
+ * GstCudaOfMeHintPooling enum type is returned immediately.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfMeHintPooling enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_me_hint_pooling_get_type();
+
+/**
+ * \brief Creates a new optical flow to motion estimation hint converter.
+ *
+ * \param[in] frame_width The width, in pixels, of the frames being encoded.
+ * \param[in] frame_height The height, in pixels, of the frames being encoded.
+ * \param[in] pooling The method used to pool the optical flow vectors
+ * covering a block.
+ *
+ * \returns A pointer to the new converter, or NULL if either of the frame
+ * dimensions is zero. The converter must be freed with
+ * gst_cuda_of_me_hints_free().
+ */
+extern __attribute__((visibility("default"))) GstCudaOfMeHints *
+gst_cuda_of_me_hints_new(
+    guint frame_width,
+    guint frame_height,
+    GstCudaOfMeHintPooling pooling);
+
+/**
+ * \brief Frees a converter created with gst_cuda_of_me_hints_new().
+ *
+ * \param[in] hints A pointer to the converter, may be NULL.
+ */
+extern __attribute__((visibility("default"))) void
+gst_cuda_of_me_hints_free(GstCudaOfMeHints *hints);
+
+/**
+ * \brief Retrieves the number of motion estimation hints generated per frame.
+ *
+ * \details This is the number of 16x16 blocks covering the frame, and
+ * therefore the number of 32-bit words that the hint arrays given to
+ * gst_cuda_of_me_hints_convert() must be able to hold.
+ *
+ * \param[in] hints A pointer to the converter.
+ *
+ * \returns The number of motion estimation hints generated per frame.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_cuda_of_me_hints_get_num_blocks(const GstCudaOfMeHints *hints);
+
+/**
+ * \brief Converts a field of optical flow vectors into motion estimation
+ * hints.
+ *
+ * \details The optical flow vectors are expected to describe the motion from
+ * the previous frame to the current frame, as produced by the cudaof element.
+ * For every 16x16 block of the current frame, the vectors covering the block
+ * are pooled into a single vector which is negated, rounded to integer pixels
+ * and clamped to the range of the hint, so that it points from the block into
+ * the previous frame.
+ *
+ * \details The optical flow vectors are resampled from their grid to the
+ * 16x16 block grid. If the optical flow vectors were computed on a frame of a
+ * different size than the frame being encoded, both the grid and the vectors
+ * are scaled accordingly.
+ *
+ * \details The hints are written in raster scan order of the blocks, using
+ * the bit layout of the NVENC_EXTERNAL_ME_HINT structure: a single L0 hint
+ * for the 16x16 partition of reference index zero, which is both the last
+ * hint of the partition and of the macroblock.
+ *
+ * \param[in] hints A pointer to the converter.
+ * \param[in] optical_flow_vectors A pointer to the first row of optical flow
+ * vectors, stored on the host.
+ * \param[in] stride The number of bytes between two rows of optical flow
+ * vectors.
+ * \param[in] element_size The size, in bytes, of an optical flow vector.
+ * Either 8 for 2-channel 32-bit floating point vectors, or 4 for 2-channel
+ * 16-bit signed S10.5 fixed point vectors as produced by the NVIDIA Optical
+ * Flow algorithms.
+ * \param[in] cols The number of optical flow vectors per row.
+ * \param[in] rows The number of rows of optical flow vectors.
+ * \param[in] grid_size The size, in pixels, of the square covered by a single
+ * optical flow vector.
+ * \param[out] packed_hints A pointer to an array of at least
+ * gst_cuda_of_me_hints_get_num_blocks() 32-bit words to write the hints into.
+ *
+ * \returns TRUE if the hints were written, FALSE if the arguments are
+ * invalid.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_me_hints_convert(
+    GstCudaOfMeHints *hints,
+    const guint8 *optical_flow_vectors,
+    gsize stride,
+    gsize element_size,
+    guint cols,
+    guint rows,
+    guint grid_size,
+    guint32 *packed_hints);
+
+/**
+ * \brief Converts the optical flow vectors attached to a buffer into motion
+ * estimation hints.
+ *
+ * \details The optical flow vectors of the GstMetaOpticalFlow metadata of the
+ * buffer are downloaded into host memory owned by the converter and converted
+ * using gst_cuda_of_me_hints_convert().
+ *
+ * \param[in] hints A pointer to the converter.
+ * \param[in] buffer A pointer to the buffer holding the GstMetaOpticalFlow
+ * metadata.
+ * \param[out] packed_hints A pointer to an array of at least
+ * gst_cuda_of_me_hints_get_num_blocks() 32-bit words to write the hints into.
+ *
+ * \returns TRUE if the hints were written, FALSE if the buffer has no
+ * optical flow metadata or the vectors could not be downloaded.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_me_hints_convert_buffer(
+    GstCudaOfMeHints *hints,
+    GstBuffer *buffer,
+    guint32 *packed_hints);
+
+G_END_DECLS
+
+#endif
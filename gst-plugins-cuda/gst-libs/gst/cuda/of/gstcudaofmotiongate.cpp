@@ -0,0 +1,233 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaofmotiongate.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <glib-object.h>
+#include <gst/gst.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * The number of bits a luma value is shifted by to get its histogram bin.
+ */
+#define HISTOGRAM_BIN_SHIFT 3
+
+G_STATIC_ASSERT((256 >> HISTOGRAM_BIN_SHIFT) == GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS);
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Calculates the sum of absolute differences between two rows of luma.
+ *
+ * \param[in] current A pointer to the row of the current frame.
+ * \param[in] previous A pointer to the row of the previous frame.
+ * \param[in] width The number of pixels in the row.
+ *
+ * \returns The sum of absolute differences of the row.
+ */
+static guint64 gst_cuda_of_motion_gate_sad_row(
+    const guint8 *current,
+    const guint8 *previous,
+    guint width);
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_motion_gate_get_type()
+{
+    static GType motion_gate_type = 0;
+    static const GEnumValue motion_gates[]
+        = {{MOTION_GATE_DISABLED,
+            "Calculate the optical flow for every frame",
+            "disabled"},
+           {MOTION_GATE_CPU,
+            "Compare the sampled luma on the host using SIMD instructions",
+            "cpu"},
+           {MOTION_GATE_CUDA, "Compare the sampled luma on the GPU", "cuda"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&motion_gate_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfMotionGate"), motion_gates);
+        g_once_init_leave(&motion_gate_type, new_type);
+    }
+
+    return motion_gate_type;
+}
+
+extern GType gst_cuda_of_motion_gate_metric_get_type()
+{
+    static GType metric_type = 0;
+    static const GEnumValue metrics[]
+        = {{MOTION_GATE_METRIC_SAD,
+            "Mean absolute difference of the sampled luma",
+            "sad"},
+           {MOTION_GATE_METRIC_HISTOGRAM,
+            "Distance between the histograms of the sampled luma",
+            "histogram"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&metric_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfMotionGateMetric"), metrics);
+        g_once_init_leave(&metric_type, new_type);
+    }
+
+    return metric_type;
+}
+
+extern GType gst_cuda_of_motion_gate_synthetic_get_type()
+{
+    static GType synthetic_type = 0;
+    static const GEnumValue synthetics[]
+        = {{MOTION_GATE_SYNTHETIC_ZERO, "Attach zero motion vectors", "zero"},
+           {MOTION_GATE_SYNTHETIC_REUSE,
+            "Attach the last calculated motion vectors",
+            "reuse"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&synthetic_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfMotionGateSynthetic"),
+            synthetics);
+        g_once_init_leave(&synthetic_type, new_type);
+    }
+
+    return synthetic_type;
+}
+
+static guint64 gst_cuda_of_motion_gate_sad_row(
+    const guint8 *current,
+    const guint8 *previous,
+    guint width)
+{
+    guint64 sum = 0;
+    guint x = 0;
+
+#if defined(__SSE2__)
+    /*
+     * _mm_sad_epu8 leaves two 16-bit partial sums in the low words of the two
+     * 64-bit lanes, so they can be accumulated as 64-bit integers without
+     * ever overflowing.
+     */
+    __m128i acc = _mm_setzero_si128();
+
+    for(; x + 16 <= width; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(current + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(previous + x));
+
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(a, b));
+    }
+
+    sum += (guint64)_mm_cvtsi128_si32(acc)
+           + (guint64)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#elif defined(__ARM_NEON)
+    /*
+     * Each 32-bit lane gains at most 4 * 255 per iteration, so a row has to
+     * be over 16 million pixels wide before the accumulator overflows.
+     */
+    uint32x4_t acc = vdupq_n_u32(0);
+
+    for(; x + 16 <= width; x += 16)
+    {
+        uint8x16_t difference
+            = vabdq_u8(vld1q_u8(current + x), vld1q_u8(previous + x));
+
+        acc = vpadalq_u16(acc, vpaddlq_u8(difference));
+    }
+
+    sum += (guint64)vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1)
+           + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+
+    for(; x < width; x++)
+    {
+        sum += (guint64)std::abs((gint)current[x] - (gint)previous[x]);
+    }
+
+    return sum;
+}
+
+extern gdouble gst_cuda_of_motion_gate_sad(
+    const guint8 *current,
+    gsize current_stride,
+    const guint8 *previous,
+    gsize previous_stride,
+    guint width,
+    guint rows)
+{
+    guint64 sum = 0;
+
+    g_return_val_if_fail(current != NULL || rows == 0, 0.0);
+    g_return_val_if_fail(previous != NULL || rows == 0, 0.0);
+
+    if(width == 0 || rows == 0)
+    {
+        return 0.0;
+    }
+
+    for(guint y = 0; y < rows; y++)
+    {
+        sum += gst_cuda_of_motion_gate_sad_row(
+            current + y * current_stride, previous + y * previous_stride, width);
+    }
+
+    return (gdouble)sum / (255.0 * (gdouble)width * (gdouble)rows);
+}
+
+extern void gst_cuda_of_motion_gate_histogram(
+    const guint8 *luma,
+    gsize stride,
+    guint width,
+    guint rows,
+    guint32 *bins)
+{
+    g_return_if_fail(bins != NULL);
+    g_return_if_fail(luma != NULL || rows == 0);
+
+    std::memset(bins, 0, sizeof(guint32) * GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS);
+
+    for(guint y = 0; y < rows; y++)
+    {
+        const guint8 *row = luma + y * stride;
+
+        for(guint x = 0; x < width; x++)
+        {
+            bins[row[x] >> HISTOGRAM_BIN_SHIFT]++;
+        }
+    }
+}
+
+extern gdouble gst_cuda_of_motion_gate_histogram_difference(
+    const guint32 *current,
+    const guint32 *previous)
+{
+    guint64 distance = 0;
+    guint64 total = 0;
+
+    g_return_val_if_fail(current != NULL, 0.0);
+    g_return_val_if_fail(previous != NULL, 0.0);
+
+    for(guint i = 0; i < GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS; i++)
+    {
+        distance += current[i] > previous[i] ? current[i] - previous[i]
+                                             : previous[i] - current[i];
+        total += (guint64)current[i] + previous[i];
+    }
+
+    if(total == 0)
+    {
+        return 0.0;
+    }
+
+    return (gdouble)distance / (gdouble)total;
+}
@@ -0,0 +1,191 @@
+#ifndef _CUDA_OF_MOTION_GATE_H_
+#define _CUDA_OF_MOTION_GATE_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_MOTION_GATE (gst_cuda_of_motion_gate_get_type())
+#define GST_TYPE_CUDA_OF_MOTION_GATE_METRIC \
+    (gst_cuda_of_motion_gate_metric_get_type())
+#define GST_TYPE_CUDA_OF_MOTION_GATE_SYNTHETIC \
+    (gst_cuda_of_motion_gate_synthetic_get_type())
+
+/**
+ * \brief The number of bins of the luma histograms compared by the histogram
+ * motion gate metric.
+ *
+ * \notes Each bin covers 8 consecutive luma values, so that sensor noise
+ * mostly moves samples within a bin rather than between bins.
+ */
+#define GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS 32
+
+/**
+ * \brief An enumeration containing the list of implementations of the motion
+ * gate, which decides whether the optical flow between two frames needs to be
+ * calculated at all.
+ */
+typedef enum _GstCudaOfMotionGate
+{
+    /**
+     * \brief The optical flow is calculated for every pair of frames.
+     */
+    MOTION_GATE_DISABLED = 0,
+    /**
+     * \brief The sampled rows of luma are downloaded and compared on the host
+     * using SIMD instructions.
+     *
+     * \notes Only the sampled rows are copied, and the previous rows are kept
+     * on the host, so each frame costs a single strided copy.
+     */
+    MOTION_GATE_CPU = 1,
+    /**
+     * \brief The sampled rows of luma are compared on the GPU.
+     *
+     * \notes Only the metric itself is copied back to the host.
+     */
+    MOTION_GATE_CUDA = 2,
+
+} GstCudaOfMotionGate;
+
+/**
+ * \brief An enumeration containing the list of metrics the motion gate uses
+ * to measure the difference between two frames.
+ */
+typedef enum _GstCudaOfMotionGateMetric
+{
+    /**
+     * \brief The mean absolute difference of the sampled luma values.
+     */
+    MOTION_GATE_METRIC_SAD = 0,
+    /**
+     * \brief The L1 distance between the luma histograms of the sampled rows.
+     *
+     * \notes This ignores motion that does not change the distribution of the
+     * luma values, e.g. a small object moving over a uniform background, but
+     * it is far less sensitive to camera shake and noise.
+     */
+    MOTION_GATE_METRIC_HISTOGRAM = 1,
+
+} GstCudaOfMotionGateMetric;
+
+/**
+ * \brief An enumeration containing the list of optical flow vectors attached
+ * to frames skipped by the motion gate.
+ */
+typedef enum _GstCudaOfMotionGateSynthetic
+{
+    /**
+     * \brief Attaches optical flow vectors that are all zero.
+     */
+    MOTION_GATE_SYNTHETIC_ZERO = 0,
+    /**
+     * \brief Attaches the optical flow vectors of the last pair of frames the
+     * optical flow was calculated for.
+     *
+     * \notes The vectors are shared with the previous metadata rather than
+     * copied. If no optical flow was calculated yet, zero vectors are
+     * attached instead.
+     */
+    MOTION_GATE_SYNTHETIC_REUSE = 1,
+
+} GstCudaOfMotionGateSynthetic;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfMotionGate enum
+ * type.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfMotionGate enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_motion_gate_get_type();
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfMotionGateMetric
+ * enum type.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfMotionGateMetric enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_motion_gate_metric_get_type();
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfMotionGateSynthetic
+ * enum type.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfMotionGateSynthetic enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_motion_gate_synthetic_get_type();
+
+/**
+ * \brief Calculates the normalised sum of absolute differences between two
+ * sets of luma rows.
+ *
+ * \details Every pixel of the given rows is compared, 16 pixels at a time
+ * where SSE2 or NEON is available. The rows are expected to be sampled from
+ * the frames already, which keeps the loads contiguous.
+ *
+ * \param[in] current A pointer to the first row of the current frame.
+ * \param[in] current_stride The number of bytes between two rows of the
+ * current frame.
+ * \param[in] previous A pointer to the first row of the previous frame.
+ * \param[in] previous_stride The number of bytes between two rows of the
+ * previous frame.
+ * \param[in] width The number of pixels per row.
+ * \param[in] rows The number of rows.
+ *
+ * \returns The mean absolute difference divided by 255, in the range [0, 1].
+ * 0 is returned if there are no pixels to compare.
+ */
+extern __attribute__((visibility("default"))) gdouble
+gst_cuda_of_motion_gate_sad(
+    const guint8 *current,
+    gsize current_stride,
+    const guint8 *previous,
+    gsize previous_stride,
+    guint width,
+    guint rows);
+
+/**
+ * \brief Calculates the luma histogram of a set of rows.
+ *
+ * \param[in] luma A pointer to the first row.
+ * \param[in] stride The number of bytes between two rows.
+ * \param[in] width The number of pixels per row.
+ * \param[in] rows The number of rows.
+ * \param[out] bins A pointer to an array of
+ * GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS counters to write the histogram into.
+ */
+extern __attribute__((visibility("default"))) void
+gst_cuda_of_motion_gate_histogram(
+    const guint8 *luma,
+    gsize stride,
+    guint width,
+    guint rows,
+    guint32 *bins);
+
+/**
+ * \brief Calculates the normalised L1 distance between two luma histograms.
+ *
+ * \param[in] current A pointer to the GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS
+ * counters of the current frame.
+ * \param[in] previous A pointer to the GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS
+ * counters of the previous frame.
+ *
+ * \returns The L1 distance divided by the total number of samples of both
+ * histograms, in the range [0, 1]. 0 is returned if both histograms are
+ * empty.
+ */
+extern __attribute__((visibility("default"))) gdouble
+gst_cuda_of_motion_gate_histogram_difference(
+    const guint32 *current,
+    const guint32 *previous);
+
+G_END_DECLS
+
+#endif
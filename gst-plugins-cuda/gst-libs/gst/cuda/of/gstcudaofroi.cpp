@@ -0,0 +1,637 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaofroi.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glib-object.h>
+#include <gst/gst.h>
+#include <gst/video/gstvideometa.h>
+
+/************************** Type/Struct Definitions ***************************/
+
+/**
+ * \brief A single region of interest of a GstCudaOfRoiSet.
+ *
+ * \details A region is either a polygon, or the pixels of a bitmask carrying
+ * its label. Rectangles are stored as 4-point polygons.
+ */
+typedef struct _GstCudaOfRoi
+{
+    gint id;
+    std::vector<std::pair<gdouble, gdouble>> polygon;
+    std::shared_ptr<const std::vector<guint8>> mask;
+    guint mask_width;
+    guint mask_height;
+    guint8 mask_label;
+
+    /*
+     * The bounding rectangle of the label within the bitmask, with the end
+     * column and row being exclusive.
+     */
+    guint mask_x_start;
+    guint mask_x_end;
+    guint mask_y_start;
+    guint mask_y_end;
+} GstCudaOfRoi;
+
+struct _GstCudaOfRoiSet
+{
+    std::vector<GstCudaOfRoi> rois;
+};
+
+/**************************** Function Definitions ****************************/
+
+static gboolean gst_cuda_of_roi_get_bounds(
+    const GstCudaOfRoi &roi,
+    guint width,
+    guint height,
+    guint *x_start,
+    guint *y_start,
+    guint *x_end,
+    guint *y_end)
+{
+    if(roi.mask)
+    {
+        /*
+         * The pixel at x samples the column x * mask_width / width of the
+         * bitmask, so the first pixel sampling a column at or after
+         * mask_x_start is the ceiling of mask_x_start * width / mask_width.
+         */
+        *x_start = (guint)(((guint64)roi.mask_x_start * width
+                            + roi.mask_width - 1)
+                           / roi.mask_width);
+        *x_end = (guint)(((guint64)roi.mask_x_end * width + roi.mask_width - 1)
+                         / roi.mask_width);
+        *y_start = (guint)(((guint64)roi.mask_y_start * height
+                            + roi.mask_height - 1)
+                           / roi.mask_height);
+        *y_end = (guint)(((guint64)roi.mask_y_end * height + roi.mask_height
+                          - 1)
+                         / roi.mask_height);
+    }
+    else
+    {
+        gdouble min_x = G_MAXDOUBLE;
+        gdouble min_y = G_MAXDOUBLE;
+        gdouble max_x = -G_MAXDOUBLE;
+        gdouble max_y = -G_MAXDOUBLE;
+
+        for(const std::pair<gdouble, gdouble> &point : roi.polygon)
+        {
+            min_x = MIN(min_x, point.first);
+            min_y = MIN(min_y, point.second);
+            max_x = MAX(max_x, point.first);
+            max_y = MAX(max_y, point.second);
+        }
+
+        *x_start = (guint)CLAMP(std::floor(min_x), 0.0, (gdouble)width);
+        *y_start = (guint)CLAMP(std::floor(min_y), 0.0, (gdouble)height);
+        *x_end = (guint)CLAMP(std::ceil(max_x), 0.0, (gdouble)width);
+        *y_end = (guint)CLAMP(std::ceil(max_y), 0.0, (gdouble)height);
+    }
+
+    *x_end = MIN(*x_end, width);
+    *y_end = MIN(*y_end, height);
+
+    return *x_start < *x_end && *y_start < *y_end;
+}
+
+static void gst_cuda_of_roi_rasterize(
+    const GstCudaOfRoi &roi,
+    guint32 bit,
+    guint width,
+    guint height,
+    guint32 *mask)
+{
+    guint x_start = 0;
+    guint y_start = 0;
+    guint x_end = 0;
+    guint y_end = 0;
+    std::vector<gdouble> crossings;
+
+    if(!gst_cuda_of_roi_get_bounds(
+           roi, width, height, &x_start, &y_start, &x_end, &y_end))
+    {
+        return;
+    }
+
+    for(guint y = y_start; y < y_end; y++)
+    {
+        guint32 *row = mask + (gsize)width * y;
+
+        if(roi.mask)
+        {
+            const guint8 *mask_row
+                = roi.mask->data()
+                  + (gsize)roi.mask_width
+                        * ((guint64)y * roi.mask_height / height);
+
+            for(guint x = x_start; x < x_end; x++)
+            {
+                if(mask_row[(guint64)x * roi.mask_width / width]
+                   == roi.mask_label)
+                {
+                    row[x] |= bit;
+                }
+            }
+
+            continue;
+        }
+
+        /*
+         * A scanline through the centres of the pixels of the row. The pixels
+         * between every other pair of crossings with the edges of the polygon
+         * are inside of it.
+         */
+        gdouble centre_y = (gdouble)y + 0.5;
+
+        crossings.clear();
+
+        for(gsize idx = 0; idx < roi.polygon.size(); idx++)
+        {
+            const std::pair<gdouble, gdouble> &from = roi.polygon[idx];
+            const std::pair<gdouble, gdouble> &to
+                = roi.polygon[(idx + 1) % roi.polygon.size()];
+
+            if((from.second <= centre_y) != (to.second <= centre_y))
+            {
+                crossings.push_back(
+                    from.first
+                    + (centre_y - from.second) * (to.first - from.first)
+                          / (to.second - from.second));
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        for(gsize idx = 0; idx + 1 < crossings.size(); idx += 2)
+        {
+            gdouble first = std::ceil(crossings[idx] - 0.5);
+            gdouble last = std::ceil(crossings[idx + 1] - 0.5);
+
+            first = CLAMP(first, (gdouble)x_start, (gdouble)x_end);
+            last = CLAMP(last, (gdouble)x_start, (gdouble)x_end);
+
+            for(guint x = (guint)first; x < (guint)last; x++)
+            {
+                row[x] |= bit;
+            }
+        }
+    }
+}
+
+extern guint gst_cuda_of_roi_active_tiles(
+    const guint32 *mask,
+    guint width,
+    guint height,
+    guint tile_width,
+    guint tile_height,
+    guint32 *tiles)
+{
+    guint number_of_tiles = 0;
+
+    g_return_val_if_fail(tile_width > 0 && tile_height > 0, 0);
+    g_return_val_if_fail(mask != NULL || width == 0 || height == 0, 0);
+
+    guint tiles_x = (width + tile_width - 1) / tile_width;
+    guint tiles_y = (height + tile_height - 1) / tile_height;
+
+    for(guint tile_y = 0; tile_y < tiles_y; tile_y++)
+    {
+        guint y_end = MIN((tile_y + 1) * tile_height, height);
+
+        for(guint tile_x = 0; tile_x < tiles_x; tile_x++)
+        {
+            guint x_end = MIN((tile_x + 1) * tile_width, width);
+            guint32 bits = 0;
+
+            for(guint y = tile_y * tile_height; y < y_end && bits == 0; y++)
+            {
+                const guint32 *row = mask + (gsize)width * y;
+
+                for(guint x = tile_x * tile_width; x < x_end; x++)
+                {
+                    bits |= row[x];
+                }
+            }
+
+            if(bits != 0)
+            {
+                tiles[number_of_tiles++] = tile_y * tiles_x + tile_x;
+            }
+        }
+    }
+
+    return number_of_tiles;
+}
+
+extern guint gst_cuda_of_roi_set_add_from_buffer(
+    GstCudaOfRoiSet *roi_set,
+    GstBuffer *buffer)
+{
+    gpointer state = NULL;
+    GstMeta *meta = NULL;
+    guint added = 0;
+
+    g_return_val_if_fail(roi_set != NULL, 0);
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), 0);
+
+    while((meta = gst_buffer_iterate_meta_filtered(
+               buffer, &state, GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))
+          != NULL)
+    {
+        GstVideoRegionOfInterestMeta *roi_meta
+            = (GstVideoRegionOfInterestMeta *)meta;
+
+        if(gst_cuda_of_roi_set_add_rectangle(
+               roi_set,
+               roi_meta->id,
+               (gint)roi_meta->x,
+               (gint)roi_meta->y,
+               roi_meta->w,
+               roi_meta->h))
+        {
+            added++;
+        }
+    }
+
+    return added;
+}
+
+extern gboolean gst_cuda_of_roi_set_add_mask(
+    GstCudaOfRoiSet *roi_set,
+    const guint8 *mask,
+    guint width,
+    guint height,
+    gsize stride)
+{
+    std::vector<GstCudaOfRoi> rois;
+    std::shared_ptr<std::vector<guint8>> mask_copy;
+
+    g_return_val_if_fail(roi_set != NULL, FALSE);
+    g_return_val_if_fail(mask != NULL || width == 0 || height == 0, FALSE);
+
+    if(width == 0 || height == 0)
+    {
+        return FALSE;
+    }
+
+    mask_copy = std::make_shared<std::vector<guint8>>((gsize)width * height);
+
+    for(guint y = 0; y < height; y++)
+    {
+        std::memcpy(
+            mask_copy->data() + (gsize)width * y, mask + stride * y, width);
+    }
+
+    GstCudaOfRoi labels[G_MAXUINT8 + 1];
+
+    for(guint label = 1; label <= G_MAXUINT8; label++)
+    {
+        labels[label].id = (gint)label;
+        labels[label].mask_width = width;
+        labels[label].mask_height = height;
+        labels[label].mask_label = (guint8)label;
+        labels[label].mask_x_start = width;
+        labels[label].mask_y_start = height;
+        labels[label].mask_x_end = 0;
+        labels[label].mask_y_end = 0;
+    }
+
+    for(guint y = 0; y < height; y++)
+    {
+        const guint8 *row = mask_copy->data() + (gsize)width * y;
+
+        for(guint x = 0; x < width; x++)
+        {
+            GstCudaOfRoi &roi = labels[row[x]];
+
+            roi.mask_x_start = MIN(roi.mask_x_start, x);
+            roi.mask_y_start = MIN(roi.mask_y_start, y);
+            roi.mask_x_end = MAX(roi.mask_x_end, x + 1);
+            roi.mask_y_end = MAX(roi.mask_y_end, y + 1);
+        }
+    }
+
+    /*
+     * The labels are listed in ascending order, so that the same bitmask
+     * always gives the same set.
+     */
+    for(guint label = 1; label <= G_MAXUINT8; label++)
+    {
+        if(labels[label].mask_x_start < labels[label].mask_x_end)
+        {
+            labels[label].mask = mask_copy;
+            rois.push_back(labels[label]);
+        }
+    }
+
+    if(rois.empty()
+       || roi_set->rois.size() + rois.size() > GST_CUDA_OF_ROI_SET_MAX_SIZE)
+    {
+        return FALSE;
+    }
+
+    roi_set->rois.insert(roi_set->rois.end(), rois.begin(), rois.end());
+
+    return TRUE;
+}
+
+extern gboolean gst_cuda_of_roi_set_add_polygon(
+    GstCudaOfRoiSet *roi_set,
+    gint id,
+    const gdouble *points,
+    guint number_of_points)
+{
+    GstCudaOfRoi roi = {};
+
+    g_return_val_if_fail(roi_set != NULL, FALSE);
+    g_return_val_if_fail(points != NULL || number_of_points == 0, FALSE);
+
+    if(number_of_points < 3
+       || roi_set->rois.size() >= GST_CUDA_OF_ROI_SET_MAX_SIZE)
+    {
+        return FALSE;
+    }
+
+    roi.id = id;
+
+    for(guint idx = 0; idx < number_of_points; idx++)
+    {
+        roi.polygon.emplace_back(points[2 * idx], points[2 * idx + 1]);
+    }
+
+    roi_set->rois.push_back(roi);
+
+    return TRUE;
+}
+
+extern gboolean gst_cuda_of_roi_set_add_rectangle(
+    GstCudaOfRoiSet *roi_set,
+    gint id,
+    gint x,
+    gint y,
+    guint width,
+    guint height)
+{
+    gdouble points[] = {(gdouble)x,
+                        (gdouble)y,
+                        (gdouble)x + width,
+                        (gdouble)y,
+                        (gdouble)x + width,
+                        (gdouble)y + height,
+                        (gdouble)x,
+                        (gdouble)y + height};
+
+    if(width == 0 || height == 0)
+    {
+        return FALSE;
+    }
+
+    return gst_cuda_of_roi_set_add_polygon(roi_set, id, points, 4);
+}
+
+extern GstCudaOfRoiSet *gst_cuda_of_roi_set_copy(const GstCudaOfRoiSet *roi_set)
+{
+    g_return_val_if_fail(roi_set != NULL, NULL);
+
+    return new GstCudaOfRoiSet(*roi_set);
+}
+
+extern gboolean gst_cuda_of_roi_set_equal(
+    const GstCudaOfRoiSet *roi_set,
+    const GstCudaOfRoiSet *other_roi_set)
+{
+    if(gst_cuda_of_roi_set_get_size(roi_set)
+       != gst_cuda_of_roi_set_get_size(other_roi_set))
+    {
+        return FALSE;
+    }
+
+    if(gst_cuda_of_roi_set_get_size(roi_set) == 0)
+    {
+        return TRUE;
+    }
+
+    for(gsize idx = 0; idx < roi_set->rois.size(); idx++)
+    {
+        const GstCudaOfRoi &roi = roi_set->rois[idx];
+        const GstCudaOfRoi &other_roi = other_roi_set->rois[idx];
+
+        /*
+         * A bitmask is only ever shared between sets copied from each other,
+         * so comparing the pointers avoids comparing every pixel per frame.
+         */
+        if(roi.id != other_roi.id || roi.polygon != other_roi.polygon
+           || roi.mask != other_roi.mask
+           || roi.mask_label != other_roi.mask_label)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+extern void gst_cuda_of_roi_set_free(GstCudaOfRoiSet *roi_set)
+{
+    delete roi_set;
+}
+
+extern gboolean gst_cuda_of_roi_set_get_bounds(
+    const GstCudaOfRoiSet *roi_set,
+    gint index,
+    guint width,
+    guint height,
+    guint *x,
+    guint *y,
+    guint *bounds_width,
+    guint *bounds_height)
+{
+    guint x_start = width;
+    guint y_start = height;
+    guint x_end = 0;
+    guint y_end = 0;
+
+    g_return_val_if_fail(roi_set != NULL, FALSE);
+    g_return_val_if_fail(index < (gint)roi_set->rois.size(), FALSE);
+
+    for(gsize idx = 0; idx < roi_set->rois.size(); idx++)
+    {
+        guint roi_x_start = 0;
+        guint roi_y_start = 0;
+        guint roi_x_end = 0;
+        guint roi_y_end = 0;
+
+        if((index >= 0 && (gsize)index != idx)
+           || !gst_cuda_of_roi_get_bounds(
+               roi_set->rois[idx],
+               width,
+               height,
+               &roi_x_start,
+               &roi_y_start,
+               &roi_x_end,
+               &roi_y_end))
+        {
+            continue;
+        }
+
+        x_start = MIN(x_start, roi_x_start);
+        y_start = MIN(y_start, roi_y_start);
+        x_end = MAX(x_end, roi_x_end);
+        y_end = MAX(y_end, roi_y_end);
+    }
+
+    if(x_start >= x_end || y_start >= y_end)
+    {
+        return FALSE;
+    }
+
+    *x = x_start;
+    *y = y_start;
+    *bounds_width = x_end - x_start;
+    *bounds_height = y_end - y_start;
+
+    return TRUE;
+}
+
+extern gint gst_cuda_of_roi_set_get_id(const GstCudaOfRoiSet *roi_set, guint index)
+{
+    g_return_val_if_fail(roi_set != NULL, 0);
+    g_return_val_if_fail(index < roi_set->rois.size(), 0);
+
+    return roi_set->rois[index].id;
+}
+
+extern guint gst_cuda_of_roi_set_get_size(const GstCudaOfRoiSet *roi_set)
+{
+    return roi_set != NULL ? (guint)roi_set->rois.size() : 0;
+}
+
+extern GstCudaOfRoiSet *gst_cuda_of_roi_set_new(void)
+{
+    return new GstCudaOfRoiSet();
+}
+
+extern gboolean gst_cuda_of_roi_set_parse_polygons(
+    GstCudaOfRoiSet *roi_set,
+    const gchar *polygons)
+{
+    gboolean result = TRUE;
+    gchar **polygon_descriptions = NULL;
+    std::vector<GstCudaOfRoi> rois;
+
+    g_return_val_if_fail(roi_set != NULL, FALSE);
+
+    if(polygons == NULL)
+    {
+        return TRUE;
+    }
+
+    polygon_descriptions = g_strsplit(polygons, ";", -1);
+
+    for(gchar **polygon_description = polygon_descriptions;
+        result && *polygon_description != NULL;
+        polygon_description++)
+    {
+        GstCudaOfRoi roi = {};
+        gchar *vertices = g_strstrip(*polygon_description);
+        gchar *separator = strchr(vertices, ':');
+        gchar **vertex_descriptions = NULL;
+
+        if(*vertices == '\0')
+        {
+            continue;
+        }
+
+        roi.id = (gint)rois.size();
+
+        if(separator != NULL)
+        {
+            gchar *end = NULL;
+
+            *separator = '\0';
+            roi.id = (gint)g_ascii_strtoll(vertices, &end, 10);
+            result = end != vertices && *g_strstrip(end) == '\0';
+            vertices = separator + 1;
+        }
+
+        vertex_descriptions = g_strsplit_set(vertices, " \t\n", -1);
+
+        for(gchar **vertex_description = vertex_descriptions;
+            result && *vertex_description != NULL;
+            vertex_description++)
+        {
+            gchar *end = NULL;
+            gdouble x = 0.0;
+            gdouble y = 0.0;
+
+            if(**vertex_description == '\0')
+            {
+                continue;
+            }
+
+            x = g_ascii_strtod(*vertex_description, &end);
+            result = end != *vertex_description && *end == ',';
+
+            if(result)
+            {
+                gchar *start = end + 1;
+
+                y = g_ascii_strtod(start, &end);
+                result = end != start && *end == '\0';
+            }
+
+            if(result)
+            {
+                roi.polygon.emplace_back(x, y);
+            }
+        }
+
+        g_strfreev(vertex_descriptions);
+
+        result = result && roi.polygon.size() >= 3;
+
+        if(result)
+        {
+            rois.push_back(roi);
+        }
+    }
+
+    g_strfreev(polygon_descriptions);
+
+    result = result
+             && roi_set->rois.size() + rois.size()
+                    <= GST_CUDA_OF_ROI_SET_MAX_SIZE;
+
+    if(result)
+    {
+        roi_set->rois.insert(roi_set->rois.end(), rois.begin(), rois.end());
+    }
+
+    return result;
+}
+
+extern void gst_cuda_of_roi_set_rasterize(
+    const GstCudaOfRoiSet *roi_set,
+    guint width,
+    guint height,
+    guint32 *mask)
+{
+    g_return_if_fail(roi_set != NULL);
+    g_return_if_fail(mask != NULL || width == 0 || height == 0);
+
+    std::memset(mask, 0, sizeof(guint32) * width * height);
+
+    for(gsize idx = 0; idx < roi_set->rois.size(); idx++)
+    {
+        gst_cuda_of_roi_rasterize(
+            roi_set->rois[idx], 1u << idx, width, height, mask);
+    }
+}
@@ -0,0 +1,268 @@
+#ifndef _CUDA_OF_ROI_H_
+#define _CUDA_OF_ROI_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * \brief The maximum number of regions of interest in a GstCudaOfRoiSet.
+ *
+ * \notes The membership of a pixel is stored as one bit per region in a
+ * 32-bit mask.
+ */
+#define GST_CUDA_OF_ROI_SET_MAX_SIZE 32u
+
+/**
+ * \brief An opaque set of regions of interest within a frame.
+ *
+ * \details A region is either a polygon or a rectangle in pixels of the frame,
+ * or a label of a bitmask that is scaled to the frame. Each region keeps the
+ * ID it was added with, so that the features calculated for it can be related
+ * back to it downstream.
+ */
+typedef struct _GstCudaOfRoiSet GstCudaOfRoiSet;
+
+/**
+ * \brief Creates an empty set of regions of interest.
+ *
+ * \returns A pointer to the new set, to be freed with
+ * gst_cuda_of_roi_set_free().
+ */
+extern __attribute__((visibility("default"))) GstCudaOfRoiSet *
+gst_cuda_of_roi_set_new(void);
+
+/**
+ * \brief Creates a copy of a set of regions of interest.
+ *
+ * \details The bitmasks are shared between the copies, as they are never
+ * modified once added.
+ *
+ * \param[in] roi_set The set to copy.
+ *
+ * \returns A pointer to the new set, to be freed with
+ * gst_cuda_of_roi_set_free().
+ */
+extern __attribute__((visibility("default"))) GstCudaOfRoiSet *
+gst_cuda_of_roi_set_copy(const GstCudaOfRoiSet *roi_set);
+
+/**
+ * \brief Frees a set of regions of interest.
+ *
+ * \param[in] roi_set The set to free, or NULL.
+ */
+extern __attribute__((visibility("default"))) void
+gst_cuda_of_roi_set_free(GstCudaOfRoiSet *roi_set);
+
+/**
+ * \brief Adds each GstVideoRegionOfInterestMeta of a buffer to a set of
+ * regions of interest as a rectangle.
+ *
+ * \param[in,out] roi_set The set to add the regions to.
+ * \param[in] buffer The buffer to read the metadata from.
+ *
+ * \returns The number of regions added. Regions beyond
+ * GST_CUDA_OF_ROI_SET_MAX_SIZE are ignored.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_cuda_of_roi_set_add_from_buffer(
+    GstCudaOfRoiSet *roi_set,
+    GstBuffer *buffer);
+
+/**
+ * \brief Adds the labels of an 8-bit bitmask to a set of regions of interest.
+ *
+ * \details Each distinct non-zero value of the bitmask becomes a region with
+ * the value as its ID, so a single bitmask can hold several regions. The
+ * bitmask is scaled to the frame with nearest neighbour interpolation.
+ *
+ * \param[in,out] roi_set The set to add the regions to.
+ * \param[in] mask A pointer to the first row of the bitmask.
+ * \param[in] width The number of columns of the bitmask.
+ * \param[in] height The number of rows of the bitmask.
+ * \param[in] stride The number of bytes between two rows of the bitmask.
+ *
+ * \returns TRUE if all of the labels were added, FALSE if the bitmask is
+ * empty or the set would exceed GST_CUDA_OF_ROI_SET_MAX_SIZE regions.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_add_mask(
+    GstCudaOfRoiSet *roi_set,
+    const guint8 *mask,
+    guint width,
+    guint height,
+    gsize stride);
+
+/**
+ * \brief Adds a polygon to a set of regions of interest.
+ *
+ * \details A pixel belongs to the polygon if its centre lies inside of it,
+ * using the even-odd rule.
+ *
+ * \param[in,out] roi_set The set to add the region to.
+ * \param[in] id The ID of the region.
+ * \param[in] points A pointer to the X and Y coordinates of the vertices, in
+ * pixels of the frame.
+ * \param[in] number_of_points The number of vertices, at least 3.
+ *
+ * \returns TRUE if the polygon was added, FALSE otherwise.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_add_polygon(
+    GstCudaOfRoiSet *roi_set,
+    gint id,
+    const gdouble *points,
+    guint number_of_points);
+
+/**
+ * \brief Adds a rectangle to a set of regions of interest.
+ *
+ * \param[in,out] roi_set The set to add the region to.
+ * \param[in] id The ID of the region.
+ * \param[in] x The first column of the rectangle.
+ * \param[in] y The first row of the rectangle.
+ * \param[in] width The number of columns of the rectangle.
+ * \param[in] height The number of rows of the rectangle.
+ *
+ * \returns TRUE if the rectangle was added, FALSE otherwise.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_add_rectangle(
+    GstCudaOfRoiSet *roi_set,
+    gint id,
+    gint x,
+    gint y,
+    guint width,
+    guint height);
+
+/**
+ * \brief Compares two sets of regions of interest.
+ *
+ * \param[in] roi_set A set of regions, or NULL.
+ * \param[in] other_roi_set Another set of regions, or NULL.
+ *
+ * \returns TRUE if both sets contain the same regions in the same order, with
+ * NULL being equal to an empty set.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_equal(
+    const GstCudaOfRoiSet *roi_set,
+    const GstCudaOfRoiSet *other_roi_set);
+
+/**
+ * \brief Calculates the bounding rectangle of one or all of the regions of a
+ * set of regions of interest within a frame.
+ *
+ * \param[in] roi_set The set of regions.
+ * \param[in] index The index of the region, or -1 for the union of all of the
+ * regions.
+ * \param[in] width The number of columns of the frame.
+ * \param[in] height The number of rows of the frame.
+ * \param[out] x The first column of the bounding rectangle.
+ * \param[out] y The first row of the bounding rectangle.
+ * \param[out] bounds_width The number of columns of the bounding rectangle.
+ * \param[out] bounds_height The number of rows of the bounding rectangle.
+ *
+ * \returns TRUE if the region covers any pixel of the frame, FALSE otherwise.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_get_bounds(
+    const GstCudaOfRoiSet *roi_set,
+    gint index,
+    guint width,
+    guint height,
+    guint *x,
+    guint *y,
+    guint *bounds_width,
+    guint *bounds_height);
+
+/**
+ * \brief Retrieves the ID of a region of a set of regions of interest.
+ *
+ * \param[in] roi_set The set of regions.
+ * \param[in] index The index of the region.
+ *
+ * \returns The ID the region was added with.
+ */
+extern __attribute__((visibility("default"))) gint
+gst_cuda_of_roi_set_get_id(const GstCudaOfRoiSet *roi_set, guint index);
+
+/**
+ * \brief Retrieves the number of regions of a set of regions of interest.
+ *
+ * \param[in] roi_set The set of regions, or NULL.
+ *
+ * \returns The number of regions.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_cuda_of_roi_set_get_size(const GstCudaOfRoiSet *roi_set);
+
+/**
+ * \brief Parses a list of polygons into a set of regions of interest.
+ *
+ * \details The polygons are separated by semicolons and their vertices by
+ * spaces, with each vertex written as `x,y` in pixels of the frame. A polygon
+ * may be prefixed with `id:` to set its ID; otherwise its ID is its position
+ * in the list. For example: `0,0 320,0 320,240; 7: 10,10 50,10 50,50 10,50`.
+ *
+ * \param[in,out] roi_set The set to add the polygons to.
+ * \param[in] polygons The list of polygons.
+ *
+ * \returns TRUE if the whole list was parsed, FALSE otherwise. Nothing is
+ * added if the list can not be parsed.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_cuda_of_roi_set_parse_polygons(
+    GstCudaOfRoiSet *roi_set,
+    const gchar *polygons);
+
+/**
+ * \brief Rasterises a set of regions of interest into a membership mask.
+ *
+ * \details Bit N of a pixel of the mask is set if the pixel belongs to the
+ * region at index N of the set.
+ *
+ * \param[in] roi_set The set of regions.
+ * \param[in] width The number of columns of the frame.
+ * \param[in] height The number of rows of the frame.
+ * \param[out] mask A pointer to width * height membership masks, written in
+ * row-major order.
+ */
+extern __attribute__((visibility("default"))) void gst_cuda_of_roi_set_rasterize(
+    const GstCudaOfRoiSet *roi_set,
+    guint width,
+    guint height,
+    guint32 *mask);
+
+/**
+ * \brief Lists the tiles of a membership mask that contain a pixel of any
+ * region of interest.
+ *
+ * \details The frame is split into tiles of tile_width * tile_height pixels,
+ * in the same way as the blocks of a CUDA kernel launched over the frame, so
+ * that a kernel can be launched over the listed tiles alone.
+ *
+ * \param[in] mask A pointer to width * height membership masks, as written by
+ * gst_cuda_of_roi_set_rasterize().
+ * \param[in] width The number of columns of the frame.
+ * \param[in] height The number of rows of the frame.
+ * \param[in] tile_width The number of columns of a tile.
+ * \param[in] tile_height The number of rows of a tile.
+ * \param[out] tiles A pointer to room for one index per tile. The row-major
+ * indices of the tiles containing a region are written in ascending order.
+ *
+ * \returns The number of tiles written.
+ */
+extern __attribute__((visibility("default"))) guint
+gst_cuda_of_roi_active_tiles(
+    const guint32 *mask,
+    guint width,
+    guint height,
+    guint tile_width,
+    guint tile_height,
+    guint32 *tiles);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,34 @@
+/**************************** Includes and Macros *****************************/
+
+#include <gst/cuda/of/gstcudaofwarmstart.h>
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+/**************************** Function Definitions ****************************/
+
+extern GType gst_cuda_of_warm_start_get_type()
+{
+    static GType warm_start_type = 0;
+    static const GEnumValue warm_starts[]
+        = {{WARM_START_DISABLED,
+            "Calculate every pair of frames from scratch",
+            "disabled"},
+           {WARM_START_ENABLED,
+            "Use the previous optical flow as the initial estimate",
+            "enabled"},
+           {WARM_START_ADAPTIVE,
+            "Use the previous optical flow as the initial estimate and lower "
+            "the iterations and levels while it converges",
+            "adaptive"},
+           {0, NULL, NULL}};
+
+    if(g_once_init_enter(&warm_start_type))
+    {
+        GType new_type = g_enum_register_static(
+            g_intern_static_string("GstCudaOfWarmStart"), warm_starts);
+        g_once_init_leave(&warm_start_type, new_type);
+    }
+
+    return warm_start_type;
+}
@@ -0,0 +1,59 @@
+#ifndef _CUDA_OF_WARM_START_H_
+#define _CUDA_OF_WARM_START_H_
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_OF_WARM_START (gst_cuda_of_warm_start_get_type())
+
+/**
+ * \brief An enumeration containing the list of modes for re-using the
+ * previous optical flow vectors as the initial estimate of the Farneback
+ * optical flow algorithm.
+ */
+typedef enum _GstCudaOfWarmStart
+{
+    /**
+     * \brief Every pair of frames is calculated from scratch.
+     */
+    WARM_START_DISABLED = 0,
+    /**
+     * \brief The previous optical flow vectors are passed as the initial
+     * estimate, using the configured number of iterations and levels.
+     */
+    WARM_START_ENABLED = 1,
+    /**
+     * \brief The previous optical flow vectors are passed as the initial
+     * estimate, and the number of iterations and levels are lowered for as
+     * long as the algorithm converges close to that estimate.
+     *
+     * \notes The configured number of iterations and levels are the upper
+     * bounds, which are restored as soon as the estimate turns out to be
+     * poor, e.g. after a scene cut.
+     */
+    WARM_START_ADAPTIVE = 2,
+
+} GstCudaOfWarmStart;
+
+/**
+ * \brief Type creation/retrieval function for the GstCudaOfWarmStart enum
+ * type.
+ *
+ * \details This function creates and registers the GstCudaOfWarmStart enum
+ * type for the first invocation. The GType instance for the
+ * GstCudaOfWarmStart enum type is then returned.
+ *
+ * \details For subsequent invocations, the GType instance for the
+ * GstCudaOfWarmStart enum type is returned immediately.
+ *
+ * \returns A GType instance representing the type information for the
+ * GstCudaOfWarmStart enum type.
+ */
+extern __attribute__((visibility("default"))) GType
+gst_cuda_of_warm_start_get_type();
+
+G_END_DECLS
+
+#endif
@@ -4,6 +4,13 @@
 #include <gst/cuda/of/gstcudaofoutputvectorgridsize.h>
 #include <gst/cuda/of/gstmetaopticalflow.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 /*
  * Just some setup for the GStreamer debug logger.
  *
@@ -12,6 +19,33 @@
 GST_DEBUG_CATEGORY_STATIC(gst_meta_optical_flow_debug);
 #define GST_CAT_DEFAULT gst_meta_optical_flow_debug
 
+/**
+ * \brief The magic number at the start of serialised metadata, "GOFL".
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_MAGIC 0x4C464F47u
+
+/**
+ * \brief The number of bytes of the header of serialised metadata.
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE 24u
+
+/**
+ * \brief The flag of serialised metadata for synthetic optical flow values.
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SYNTHETIC (1u << 0)
+
+/**
+ * \brief The flag of serialised metadata for optical flow values passed in a
+ * shared memory file.
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SHARED_MEMORY (1u << 1)
+
+/**
+ * \brief The largest number of rows or columns of deserialised optical flow
+ * values, which keeps their size well within the range of OpenCV.
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_MAX_DIMENSION G_MAXUINT16
+
 /************************** Type/Struct Definitions ***************************/
 
 /*************************** Function Declarations ****************************/
@@ -78,6 +112,95 @@ static gboolean gst_meta_optical_flow_transform(
     GQuark type,
     gpointer data);
 
+/**
+ * \brief Retrieves the dimensions and the OpenCV type of the optical flow
+ * values of a GstMetaOpticalFlow instance, whether they are hosted on the GPU
+ * or in host memory.
+ *
+ * \param[in] meta A pointer to the GstMetaOpticalFlow instance.
+ * \param[out] cols The number of columns of the matrix.
+ * \param[out] rows The number of rows of the matrix.
+ * \param[out] type The OpenCV type of the matrix.
+ *
+ * \returns TRUE if the instance holds optical flow values, FALSE otherwise.
+ */
+static gboolean gst_meta_optical_flow_get_dimensions(
+    const GstMetaOpticalFlow *meta,
+    gint *cols,
+    gint *rows,
+    gint *type);
+
+/**
+ * \brief Copies the optical flow values of a GstMetaOpticalFlow instance into
+ * host memory, row after row without any padding, in little-endian byte
+ * order.
+ *
+ * \details Values hosted on the GPU are downloaded straight into the
+ * destination, with the CUDA context of the instance pushed.
+ *
+ * \param[in] meta A pointer to the GstMetaOpticalFlow instance.
+ * \param[out] data A pointer to room for the values.
+ *
+ * \returns TRUE if the values were copied, FALSE otherwise.
+ */
+static gboolean gst_meta_optical_flow_copy_to_host(
+    const GstMetaOpticalFlow *meta,
+    guint8 *data);
+
+/**
+ * \brief Converts packed optical flow values between host and little-endian
+ * byte order, in place.
+ *
+ * \details This does nothing on little-endian hosts. The conversion is its
+ * own inverse on big-endian hosts.
+ *
+ * \param[in,out] data A pointer to the values.
+ * \param[in] size The number of bytes of the values.
+ * \param[in] type The OpenCV type of the values.
+ */
+static void
+gst_meta_optical_flow_convert_byte_order(guint8 *data, gsize size, gint type);
+
+#if GST_CHECK_VERSION(1, 24, 0)
+/**
+ * \brief Serialises an instance of the GstMetaOpticalFlow metadata type for
+ * GStreamer, e.g. for the unixfdsink element.
+ *
+ * \details The optical flow values are always within the serialised metadata,
+ * as GStreamer has no way of passing the shared memory file alongside.
+ *
+ * \param[in] meta A pointer to the GstMetaOpticalFlow instance.
+ * \param[in,out] data The byte array to append the serialised metadata to.
+ * \param[out] version The version of the serialised metadata.
+ *
+ * \returns TRUE if the metadata was serialised, FALSE otherwise.
+ */
+static gboolean gst_meta_optical_flow_serialize_func(
+    const GstMeta *meta,
+    GstByteArrayInterface *data,
+    guint8 *version);
+
+/**
+ * \brief Deserialises an instance of the GstMetaOpticalFlow metadata type for
+ * GStreamer, e.g. for the unixfdsrc element.
+ *
+ * \param[in] info The GstMetaInfo of the GstMetaOpticalFlow type.
+ * \param[in,out] buffer The buffer to add the metadata to.
+ * \param[in] data A pointer to the serialised metadata.
+ * \param[in] size The number of bytes of the serialised metadata.
+ * \param[in] version The version of the serialised metadata.
+ *
+ * \returns The GstMetaOpticalFlow instance added to the buffer, or NULL if the
+ * data is not valid.
+ */
+static GstMeta *gst_meta_optical_flow_deserialize_func(
+    const GstMetaInfo *info,
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    guint8 version);
+#endif
+
 /**************************** Function Definitions ****************************/
 
 extern GType gst_meta_optical_flow_api_get_type()
@@ -106,6 +229,19 @@ extern const GstMetaInfo *gst_meta_optical_flow_get_info()
 
     if(g_once_init_enter((GstMetaInfo **)&meta_optical_flow_info))
     {
+#if GST_CHECK_VERSION(1, 24, 0)
+        GstMetaInfo *info = gst_meta_info_new(
+            GST_META_OPTICAL_FLOW_API_TYPE,
+            "GstMetaOpticalFlow",
+            sizeof(GstMetaOpticalFlow));
+        info->init_func = gst_meta_optical_flow_init;
+        info->free_func = gst_meta_optical_flow_free;
+        info->transform_func = gst_meta_optical_flow_transform;
+        info->serialize_func = gst_meta_optical_flow_serialize_func;
+        info->deserialize_func = gst_meta_optical_flow_deserialize_func;
+
+        const GstMetaInfo *mi = gst_meta_info_register(info);
+#else
         const GstMetaInfo *mi = gst_meta_register(
             GST_META_OPTICAL_FLOW_API_TYPE,
             "GstMetaOpticalFlow",
@@ -113,6 +249,7 @@ extern const GstMetaInfo *gst_meta_optical_flow_get_info()
             gst_meta_optical_flow_init,
             gst_meta_optical_flow_free,
             gst_meta_optical_flow_transform);
+#endif
         g_once_init_leave(
             (GstMetaInfo **)&meta_optical_flow_info, (GstMetaInfo *)mi);
     }
@@ -134,6 +271,10 @@ gst_meta_optical_flow_init(GstMeta *meta, gpointer params, GstBuffer *buf)
     optical_flow_meta->optical_flow_vectors = nullptr;
     optical_flow_meta->optical_flow_vector_grid_size
         = OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_1;
+    optical_flow_meta->synthetic = FALSE;
+    optical_flow_meta->host_optical_flow_vectors = nullptr;
+    optical_flow_meta->shared_memory = NULL;
+    optical_flow_meta->shared_memory_size = 0;
 
     return TRUE;
 }
@@ -160,6 +301,18 @@ static void gst_meta_optical_flow_free(GstMeta *meta, GstBuffer *buf)
     }
 
     gst_clear_object(&optical_flow_meta->context);
+
+    delete optical_flow_meta->host_optical_flow_vectors;
+    optical_flow_meta->host_optical_flow_vectors = nullptr;
+
+    if(optical_flow_meta->shared_memory != NULL)
+    {
+        munmap(
+            optical_flow_meta->shared_memory,
+            optical_flow_meta->shared_memory_size);
+        optical_flow_meta->shared_memory = NULL;
+        optical_flow_meta->shared_memory_size = 0;
+    }
 }
 
 static gboolean gst_meta_optical_flow_transform(
@@ -184,18 +337,33 @@ static gboolean gst_meta_optical_flow_transform(
     {
         new_optical_flow_meta = GST_META_OPTICAL_FLOW_ADD(transbuf);
 
-        new_optical_flow_meta->context
-            = GST_CUDA_CONTEXT(gst_object_ref(old_optical_flow_meta->context));
+        if(old_optical_flow_meta->context != NULL)
+        {
+            new_optical_flow_meta->context = GST_CUDA_CONTEXT(
+                gst_object_ref(old_optical_flow_meta->context));
+
+            if(gst_cuda_context_push(new_optical_flow_meta->context))
+            {
+                new_optical_flow_meta->optical_flow_vectors
+                    = new cv::cuda::GpuMat(
+                        *(old_optical_flow_meta->optical_flow_vectors));
+                gst_cuda_context_pop(NULL);
+            }
+        }
 
-        if(gst_cuda_context_push(new_optical_flow_meta->context))
+        /*
+         * The copy gets its own host values rather than sharing the shared
+         * memory mapping, so that either buffer can be freed on its own.
+         */
+        if(old_optical_flow_meta->host_optical_flow_vectors != nullptr)
         {
-            new_optical_flow_meta->optical_flow_vectors = new cv::cuda::GpuMat(
-                *(old_optical_flow_meta->optical_flow_vectors));
-            gst_cuda_context_pop(NULL);
+            new_optical_flow_meta->host_optical_flow_vectors = new cv::Mat(
+                old_optical_flow_meta->host_optical_flow_vectors->clone());
         }
 
         new_optical_flow_meta->optical_flow_vector_grid_size
             = old_optical_flow_meta->optical_flow_vector_grid_size;
+        new_optical_flow_meta->synthetic = old_optical_flow_meta->synthetic;
     }
     else
     {
@@ -205,4 +373,456 @@ static gboolean gst_meta_optical_flow_transform(
     return result;
 }
 
+gsize gst_meta_optical_flow_get_serialized_size(
+    const GstMetaOpticalFlow *meta,
+    gboolean shared_memory)
+{
+    gint cols = 0;
+    gint rows = 0;
+    gint type = 0;
+    gsize size = GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE;
+
+    g_return_val_if_fail(meta != NULL, 0);
+
+    if(!shared_memory
+       && gst_meta_optical_flow_get_dimensions(meta, &cols, &rows, &type))
+    {
+        size += (gsize)cols * rows * CV_ELEM_SIZE(type);
+    }
+
+    return size;
+}
+
+gboolean gst_meta_optical_flow_serialize(
+    const GstMetaOpticalFlow *meta,
+    guint8 *data,
+    gsize size,
+    gboolean shared_memory)
+{
+    gint cols = 0;
+    gint rows = 0;
+    gint type = 0;
+    guint8 flags = 0;
+    gsize serialized_size = 0;
+
+    g_return_val_if_fail(meta != NULL, FALSE);
+    g_return_val_if_fail(data != NULL, FALSE);
+
+    serialized_size
+        = gst_meta_optical_flow_get_serialized_size(meta, shared_memory);
+
+    if(size < serialized_size)
+    {
+        GST_WARNING(
+            "%" G_GSIZE_FORMAT " bytes are too few for %" G_GSIZE_FORMAT
+            " bytes of serialised optical flow",
+            size,
+            serialized_size);
+        return FALSE;
+    }
+
+    gboolean has_vectors
+        = gst_meta_optical_flow_get_dimensions(meta, &cols, &rows, &type);
+
+    if(meta->synthetic)
+    {
+        flags |= GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SYNTHETIC;
+    }
+
+    if(has_vectors && shared_memory)
+    {
+        flags |= GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SHARED_MEMORY;
+    }
+
+    GST_WRITE_UINT32_LE(data, GST_META_OPTICAL_FLOW_SERIALIZATION_MAGIC);
+    GST_WRITE_UINT8(data + 4, GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION);
+    GST_WRITE_UINT8(data + 5, flags);
+    GST_WRITE_UINT16_LE(data + 6, 0);
+    GST_WRITE_UINT32_LE(data + 8, (guint32)meta->optical_flow_vector_grid_size);
+    GST_WRITE_UINT32_LE(data + 12, (guint32)cols);
+    GST_WRITE_UINT32_LE(data + 16, (guint32)rows);
+    GST_WRITE_UINT32_LE(data + 20, (guint32)type);
+
+    if(has_vectors && !shared_memory)
+    {
+        return gst_meta_optical_flow_copy_to_host(
+            meta, data + GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE);
+    }
+
+    return TRUE;
+}
+
+GstMetaOpticalFlow *gst_meta_optical_flow_deserialize(
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    gint shared_memory_fd)
+{
+    GstMetaOpticalFlow *meta = NULL;
+    guint8 flags = 0;
+    guint32 cols = 0;
+    guint32 rows = 0;
+    gint type = 0;
+    gsize payload_size = 0;
+    gsize expected_size = GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE;
+    gpointer shared_memory = NULL;
+
+    g_return_val_if_fail(buffer != NULL, NULL);
+    g_return_val_if_fail(data != NULL || size == 0, NULL);
+
+    if(size < GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE
+       || GST_READ_UINT32_LE(data) != GST_META_OPTICAL_FLOW_SERIALIZATION_MAGIC)
+    {
+        GST_WARNING("The data is not serialised optical flow metadata");
+        return NULL;
+    }
+
+    if(GST_READ_UINT8(data + 4) != GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION)
+    {
+        GST_WARNING(
+            "Version %u of serialised optical flow metadata is not supported",
+            GST_READ_UINT8(data + 4));
+        return NULL;
+    }
+
+    flags = GST_READ_UINT8(data + 5);
+    cols = GST_READ_UINT32_LE(data + 12);
+    rows = GST_READ_UINT32_LE(data + 16);
+    type = (gint)GST_READ_UINT32_LE(data + 20);
+
+    if(cols > 0 && rows > 0)
+    {
+        /*
+         * Only the types the optical flow algorithms output are accepted, so
+         * that malformed data can never describe an unexpected matrix.
+         */
+        if((type != CV_32FC2 && type != CV_16SC2)
+           || cols > GST_META_OPTICAL_FLOW_SERIALIZATION_MAX_DIMENSION
+           || rows > GST_META_OPTICAL_FLOW_SERIALIZATION_MAX_DIMENSION)
+        {
+            GST_WARNING(
+                "A %ux%u matrix of type %d is not valid optical flow",
+                cols,
+                rows,
+                type);
+            return NULL;
+        }
+
+        payload_size = (gsize)cols * rows * CV_ELEM_SIZE(type);
+    }
+
+    if(!(flags & GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SHARED_MEMORY))
+    {
+        expected_size += payload_size;
+    }
+    else if(payload_size == 0 || shared_memory_fd < 0)
+    {
+        GST_WARNING(
+            "The optical flow values are in shared memory, but no shared "
+            "memory file was given");
+        return NULL;
+    }
+
+    if(size != expected_size)
+    {
+        GST_WARNING(
+            "%" G_GSIZE_FORMAT " bytes do not match the layout of the "
+            "serialised optical flow metadata",
+            size);
+        return NULL;
+    }
+
+    if(flags & GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SHARED_MEMORY)
+    {
+        struct stat shared_memory_stat;
+
+        if(fstat(shared_memory_fd, &shared_memory_stat) != 0
+           || (gsize)shared_memory_stat.st_size < payload_size)
+        {
+            GST_WARNING(
+                "The shared memory file is too small for %" G_GSIZE_FORMAT
+                " bytes of optical flow values",
+                payload_size);
+            return NULL;
+        }
+
+        /*
+         * The mapping is private, so that the values can be modified, or
+         * their byte order converted, without a copy unless that happens.
+         */
+        shared_memory = mmap(
+            NULL,
+            payload_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE,
+            shared_memory_fd,
+            0);
+
+        if(shared_memory == MAP_FAILED)
+        {
+            GST_WARNING(
+                "Could not map the shared memory file - %s", g_strerror(errno));
+            return NULL;
+        }
+    }
+
+    meta = GST_META_OPTICAL_FLOW_ADD(buffer);
+    meta->optical_flow_vector_grid_size = (gint)GST_READ_UINT32_LE(data + 8);
+    meta->synthetic
+        = (flags & GST_META_OPTICAL_FLOW_SERIALIZATION_FLAG_SYNTHETIC) != 0;
+
+    if(payload_size == 0)
+    {
+        return meta;
+    }
+
+    try
+    {
+        if(shared_memory != NULL)
+        {
+            meta->shared_memory = shared_memory;
+            meta->shared_memory_size = payload_size;
+            meta->host_optical_flow_vectors
+                = new cv::Mat((gint)rows, (gint)cols, type, shared_memory);
+        }
+        else
+        {
+            meta->host_optical_flow_vectors
+                = new cv::Mat((gint)rows, (gint)cols, type);
+            memcpy(
+                meta->host_optical_flow_vectors->data,
+                data + GST_META_OPTICAL_FLOW_SERIALIZATION_HEADER_SIZE,
+                payload_size);
+        }
+
+        gst_meta_optical_flow_convert_byte_order(
+            meta->host_optical_flow_vectors->data, payload_size, type);
+    }
+    catch(cv::Exception &ex)
+    {
+        GST_WARNING("Could not hold the optical flow values - %s", ex.what());
+        gst_buffer_remove_meta(buffer, GST_META_CAST(meta));
+        meta = NULL;
+    }
+
+    return meta;
+}
+
+gint gst_meta_optical_flow_export_shared_memory(const GstMetaOpticalFlow *meta)
+{
+    gint cols = 0;
+    gint rows = 0;
+    gint type = 0;
+    gint fd = -1;
+    gsize size = 0;
+    gpointer mapping = MAP_FAILED;
+    gboolean copied = FALSE;
+
+    g_return_val_if_fail(meta != NULL, -1);
+
+    if(!gst_meta_optical_flow_get_dimensions(meta, &cols, &rows, &type))
+    {
+        GST_WARNING("There are no optical flow values to export");
+        return -1;
+    }
+
+    size = (gsize)cols * rows * CV_ELEM_SIZE(type);
+    fd = memfd_create(
+        "gst-meta-optical-flow", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if(fd < 0)
+    {
+        GST_WARNING(
+            "Could not create a shared memory file - %s", g_strerror(errno));
+        return -1;
+    }
+
+    if(ftruncate(fd, (off_t)size) == 0)
+    {
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    if(mapping == MAP_FAILED)
+    {
+        GST_WARNING(
+            "Could not map the shared memory file - %s", g_strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    copied = gst_meta_optical_flow_copy_to_host(meta, (guint8 *)mapping);
+    munmap(mapping, size);
+
+    /*
+     * The seals guarantee the receiving process that the file can neither
+     * shrink under its mapping nor change while it reads it. Sealing writes
+     * only works once the writable mapping is gone.
+     */
+    if(!copied
+       || fcntl(
+              fd,
+              F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)
+              != 0)
+    {
+        GST_WARNING("Could not export the optical flow values");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static gboolean gst_meta_optical_flow_get_dimensions(
+    const GstMetaOpticalFlow *meta,
+    gint *cols,
+    gint *rows,
+    gint *type)
+{
+    if(meta->optical_flow_vectors != nullptr
+       && !meta->optical_flow_vectors->empty())
+    {
+        *cols = meta->optical_flow_vectors->cols;
+        *rows = meta->optical_flow_vectors->rows;
+        *type = meta->optical_flow_vectors->type();
+        return TRUE;
+    }
+
+    if(meta->host_optical_flow_vectors != nullptr
+       && !meta->host_optical_flow_vectors->empty())
+    {
+        *cols = meta->host_optical_flow_vectors->cols;
+        *rows = meta->host_optical_flow_vectors->rows;
+        *type = meta->host_optical_flow_vectors->type();
+        return TRUE;
+    }
+
+    *cols = 0;
+    *rows = 0;
+    *type = 0;
+
+    return FALSE;
+}
+
+static gboolean gst_meta_optical_flow_copy_to_host(
+    const GstMetaOpticalFlow *meta,
+    guint8 *data)
+{
+    gint cols = 0;
+    gint rows = 0;
+    gint type = 0;
+    gboolean result = TRUE;
+
+    if(!gst_meta_optical_flow_get_dimensions(meta, &cols, &rows, &type))
+    {
+        return FALSE;
+    }
+
+    /*
+     * The destination wraps the given memory with the same dimensions and
+     * type as the values, so OpenCV copies into it rather than reallocating.
+     */
+    cv::Mat destination(rows, cols, type, data);
+
+    if(meta->optical_flow_vectors != nullptr
+       && !meta->optical_flow_vectors->empty())
+    {
+        if(meta->context == NULL || !gst_cuda_context_push(meta->context))
+        {
+            GST_WARNING("Could not push the CUDA context of the optical flow");
+            return FALSE;
+        }
+
+        try
+        {
+            meta->optical_flow_vectors->download(destination);
+        }
+        catch(cv::Exception &ex)
+        {
+            GST_WARNING("Could not download the optical flow - %s", ex.what());
+            result = FALSE;
+        }
+
+        gst_cuda_context_pop(NULL);
+    }
+    else
+    {
+        meta->host_optical_flow_vectors->copyTo(destination);
+    }
+
+    if(result)
+    {
+        gst_meta_optical_flow_convert_byte_order(
+            data, (gsize)cols * rows * CV_ELEM_SIZE(type), type);
+    }
+
+    return result;
+}
+
+static void
+gst_meta_optical_flow_convert_byte_order(guint8 *data, gsize size, gint type)
+{
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    if(CV_ELEM_SIZE1(type) == sizeof(guint16))
+    {
+        for(gsize offset = 0; offset < size; offset += sizeof(guint16))
+        {
+            GST_WRITE_UINT16_LE(
+                data + offset, GST_READ_UINT16_BE(data + offset));
+        }
+    }
+    else
+    {
+        for(gsize offset = 0; offset < size; offset += sizeof(guint32))
+        {
+            GST_WRITE_UINT32_LE(
+                data + offset, GST_READ_UINT32_BE(data + offset));
+        }
+    }
+#else
+    (void)data;
+    (void)size;
+    (void)type;
+#endif
+}
+
+#if GST_CHECK_VERSION(1, 24, 0)
+static gboolean gst_meta_optical_flow_serialize_func(
+    const GstMeta *meta,
+    GstByteArrayInterface *data,
+    guint8 *version)
+{
+    const GstMetaOpticalFlow *optical_flow_meta
+        = (const GstMetaOpticalFlow *)(meta);
+    gsize size
+        = gst_meta_optical_flow_get_serialized_size(optical_flow_meta, FALSE);
+    guint8 *serialized = gst_byte_array_interface_append(data, size);
+
+    if(serialized == NULL)
+    {
+        return FALSE;
+    }
+
+    *version = GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION;
+
+    return gst_meta_optical_flow_serialize(
+        optical_flow_meta, serialized, size, FALSE);
+}
+
+static GstMeta *gst_meta_optical_flow_deserialize_func(
+    const GstMetaInfo *info,
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    guint8 version)
+{
+    if(version != GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION)
+    {
+        return NULL;
+    }
+
+    return (GstMeta *)gst_meta_optical_flow_deserialize(buffer, data, size, -1);
+}
+#endif
+
 /******************************************************************************/
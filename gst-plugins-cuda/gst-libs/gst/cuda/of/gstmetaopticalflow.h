@@ -17,6 +17,12 @@ G_BEGIN_DECLS
     ((GstMetaOpticalFlow *)(gst_buffer_get_meta( \
         buf, gst_meta_optical_flow_api_get_type())))
 
+/**
+ * \brief The version of the binary format written by
+ * gst_meta_optical_flow_serialize().
+ */
+#define GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION 1
+
 typedef struct _GstMetaOpticalFlow GstMetaOpticalFlow;
 
 /**
@@ -27,6 +33,10 @@ typedef struct _GstMetaOpticalFlow GstMetaOpticalFlow;
  * cv::cuda::GpuMat instance will contain a 2-channel 2D matrix of 32-bit
  * floating point values representing the output of the optical flow
  * algorithms.
+ *
+ * \details Metadata deserialised by gst_meta_optical_flow_deserialize(), e.g.
+ * in another process, has no CUDA context. Its optical flow values are held
+ * in host memory by host_optical_flow_vectors instead.
  */
 struct _GstMetaOpticalFlow
 {
@@ -70,6 +80,33 @@ struct _GstMetaOpticalFlow
      * pixels on the frame.
      */
     gint optical_flow_vector_grid_size;
+
+    /**
+     * \brief A flag that is set when the optical flow vectors were not
+     * calculated for this buffer.
+     *
+     * \notes This is set by the motion gate of the cudaof element for frames
+     * that barely differ from the previous frame. The optical flow vectors are
+     * then either all zero or those of the last frame the optical flow was
+     * calculated for.
+     */
+    gboolean synthetic;
+
+    /**
+     * \brief A pointer to a 2-channel 2D matrix of optical flow values as
+     * hosted in host memory, or nullptr.
+     *
+     * \details This is only set for deserialised metadata, in which case
+     * context and optical_flow_vectors are not.
+     */
+    cv::Mat *host_optical_flow_vectors;
+
+    /**
+     * \brief The shared memory mapping host_optical_flow_vectors points into,
+     * and its number of bytes, or NULL if it owns its values.
+     */
+    gpointer shared_memory;
+    gsize shared_memory_size;
 };
 
 /**
@@ -107,6 +144,97 @@ gst_meta_optical_flow_api_get_type();
 extern __attribute__((visibility("default"))) const GstMetaInfo *
 gst_meta_optical_flow_get_info();
 
+/**
+ * \brief Calculates the number of bytes gst_meta_optical_flow_serialize()
+ * writes for a GstMetaOpticalFlow instance.
+ *
+ * \param[in] meta The GstMetaOpticalFlow instance.
+ * \param[in] shared_memory TRUE if the optical flow values are passed in a
+ * shared memory file rather than within the serialised metadata.
+ *
+ * \returns The number of bytes of the serialised metadata.
+ */
+extern __attribute__((visibility("default"))) gsize
+gst_meta_optical_flow_get_serialized_size(
+    const GstMetaOpticalFlow *meta,
+    gboolean shared_memory);
+
+/**
+ * \brief Serialises a GstMetaOpticalFlow instance into a compact, versioned
+ * binary format, e.g. to carry it across a process boundary.
+ *
+ * \details The format is a 24 byte header, holding the "GOFL" magic, the
+ * format version, the synthetic and shared memory flags, the vector grid
+ * size, and the number of columns, rows and the OpenCV type of the matrix,
+ * followed by the optical flow values row after row without any padding.
+ * Every value is little-endian.
+ *
+ * \details With shared_memory set, the values are left out, and have to be
+ * passed alongside as the file from
+ * gst_meta_optical_flow_export_shared_memory().
+ *
+ * \param[in] meta The GstMetaOpticalFlow instance.
+ * \param[out] data A pointer to room for the serialised metadata.
+ * \param[in] size The number of bytes of room, which has to be at least
+ * gst_meta_optical_flow_get_serialized_size().
+ * \param[in] shared_memory TRUE if the optical flow values are passed in a
+ * shared memory file rather than within the serialised metadata.
+ *
+ * \returns TRUE if the metadata was serialised, FALSE if there is not enough
+ * room or the optical flow values could not be downloaded.
+ */
+extern __attribute__((visibility("default"))) gboolean
+gst_meta_optical_flow_serialize(
+    const GstMetaOpticalFlow *meta,
+    guint8 *data,
+    gsize size,
+    gboolean shared_memory);
+
+/**
+ * \brief Deserialises a GstMetaOpticalFlow instance written by
+ * gst_meta_optical_flow_serialize(), and adds it to a buffer.
+ *
+ * \details The optical flow values are held in host memory by
+ * host_optical_flow_vectors. If they were passed in a shared memory file, the
+ * file is mapped rather than copied, and the mapping is released along with
+ * the metadata.
+ *
+ * \param[in,out] buffer The buffer to add the metadata to.
+ * \param[in] data A pointer to the serialised metadata.
+ * \param[in] size The number of bytes of the serialised metadata.
+ * \param[in] shared_memory_fd The file descriptor of the shared memory file
+ * holding the optical flow values, or -1 if they are within the serialised
+ * metadata. The file descriptor is not taken over, and can be closed once
+ * this returns.
+ *
+ * \returns The GstMetaOpticalFlow instance added to the buffer, or NULL if the
+ * data is not valid serialised metadata of a supported version.
+ */
+extern __attribute__((visibility("default"))) GstMetaOpticalFlow *
+gst_meta_optical_flow_deserialize(
+    GstBuffer *buffer,
+    const guint8 *data,
+    gsize size,
+    gint shared_memory_fd);
+
+/**
+ * \brief Copies the optical flow values of a GstMetaOpticalFlow instance into
+ * a new sealed memfd shared memory file.
+ *
+ * \details The file holds the values row after row without any padding, as
+ * within the serialised metadata, and is sealed against writes and resizes so
+ * that the receiving process can map it safely. It can be passed to another
+ * process over a UNIX domain socket, along with the metadata serialised with
+ * shared_memory set, so that the values are not copied through a pipe.
+ *
+ * \param[in] meta The GstMetaOpticalFlow instance.
+ *
+ * \returns The file descriptor of the file, to be closed by the caller, or -1
+ * if an error occurs.
+ */
+extern __attribute__((visibility("default"))) gint
+gst_meta_optical_flow_export_shared_memory(const GstMetaOpticalFlow *meta);
+
 G_END_DECLS
 
 #endif
@@ -29,6 +29,15 @@
 #define GST_TRANSCODER_MESSAGE_DATA_ERROR "error"
 #define GST_TRANSCODER_MESSAGE_DATA_WARNING "warning"
 #define GST_TRANSCODER_MESSAGE_DATA_ISSUE_DETAILS "issue-details"
+#define GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR "realtime-factor"
+#define GST_TRANSCODER_MESSAGE_DATA_CPU_USAGE "cpu-usage"
+#define GST_TRANSCODER_MESSAGE_DATA_N_PENDING "n-pending"
+#define GST_TRANSCODER_MESSAGE_DATA_N_RUNNING "n-running"
+#define GST_TRANSCODER_MESSAGE_DATA_N_DONE "n-done"
+#define GST_TRANSCODER_MESSAGE_DATA_N_FAILED "n-failed"
+#define GST_TRANSCODER_MESSAGE_DATA_JOB_ID "job-id"
+#define GST_TRANSCODER_MESSAGE_DATA_FPS "fps"
+#define GST_TRANSCODER_MESSAGE_DATA_ELEMENTS "elements"
 
 struct _GstTranscoderSignalAdapter
 {
@@ -42,3 +51,29 @@ struct _GstTranscoderSignalAdapter
 
 GstTranscoderSignalAdapter * gst_transcoder_signal_adapter_new_sync_emit (GstTranscoder * transcoder);
 GstTranscoderSignalAdapter * gst_transcoder_signal_adapter_new           (GstTranscoder * transcoder, GMainContext * context);
+
+gboolean gst_transcoder_run_segments (const gchar * source_uri,
+                                      const gchar * dest_uri,
+                                      GstEncodingProfile * profile,
+                                      gint cpu_usage,
+                                      guint n_segments,
+                                      GError ** error);
+
+gboolean gst_transcoder_run_clip     (const gchar * source_uri,
+                                      const gchar * dest_uri,
+                                      GstEncodingProfile * profile,
+                                      gint cpu_usage,
+                                      GstClockTime start,
+                                      GstClockTime stop,
+                                      gboolean smart_render,
+                                      GError ** error);
+
+typedef struct _GstTranscoderStats GstTranscoderStats;
+
+GstTranscoderStats * gst_transcoder_stats_new    (GstElement * pipeline,
+                                                  const gchar * trace_file);
+GstStructure *       gst_transcoder_stats_sample (GstTranscoderStats * stats,
+                                                  GstClockTime position,
+                                                  gdouble * fps,
+                                                  gdouble * realtime_factor);
+void                 gst_transcoder_stats_free   (GstTranscoderStats * stats);
@@ -0,0 +1,951 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Segmented transcoding: the source is split into time ranges starting at
+ * video keyframes, which are transcoded in parallel by one uritranscodebin
+ * each, and the transcoded ranges are then concatenated without being
+ * decoded again.
+ *
+ * Every range starts at a keyframe, so no frame is decoded twice and every
+ * part starts with a keyframe of its own. The ranges only depend on the
+ * keyframes of the source, so the output does not depend on the order in
+ * which the parts finish. concat offsets the running time of each part by
+ * the duration of the parts before it, which keeps the timestamps of the
+ * output continuous.
+ *
+ * Clipping reuses the same machinery. With smart rendering, the GOPs that lie
+ * entirely inside the clip range are copied without being decoded and only
+ * the GOPs the range starts and ends in are transcoded. The keyframes are
+ * found by parsing the NAL units of the H.264 or H.265 source, which costs
+ * about as much as reading it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsttranscoder.h"
+#include "gsttranscoder-private.h"
+
+#include <glib/gstdio.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_transcoder_segments_debug);
+#define GST_CAT_DEFAULT gst_transcoder_segments_debug
+
+typedef struct
+{
+  const gchar *source_uri;
+  GstEncodingProfile *profile;
+  gint cpu_usage;
+
+  gchar *dest_uri;
+  GstClockTime start;
+  GstClockTime stop;
+  /* the range starts and ends at keyframes and is copied as is */
+  gboolean copy;
+
+  GThread *thread;
+  GError *error;
+} GstTranscoderSegment;
+
+static gboolean
+wait_for_eos (GstElement * pipeline, GError ** error)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+  gboolean ret = TRUE;
+
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_propagate_error (error, err);
+    ret = FALSE;
+  }
+
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+static gboolean
+preroll (GstElement * pipeline, GError ** error)
+{
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE ||
+      gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE) {
+    GstBus *bus = gst_element_get_bus (pipeline);
+    GstMessage *msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+
+    if (msg) {
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_propagate_error (error, err);
+      gst_message_unref (msg);
+    } else {
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "Could not preroll %s", GST_OBJECT_NAME (pipeline));
+    }
+    gst_object_unref (bus);
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Splits the source into @n_segments ranges of about the same duration,
+ * each starting at the video keyframe found by a key unit seek. Returns
+ * the start of every range followed by the stop of the last one */
+static GArray *
+find_boundaries (const gchar * source_uri, guint n_segments, GError ** error)
+{
+  GstElement *pipeline;
+  GstElement *src;
+  GArray *boundaries = NULL;
+  gint64 duration;
+  GstClockTime start = 0;
+  guint i;
+
+  pipeline = gst_parse_launch ("uridecodebin name=src caps=video/x-raw "
+      "expose-all-streams=false ! fakesink sync=false", error);
+  if (!pipeline)
+    return NULL;
+
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  g_object_set (src, "uri", source_uri, NULL);
+  gst_object_unref (src);
+
+  if (!preroll (pipeline, error))
+    goto done;
+
+  if (!gst_element_query_duration (pipeline, GST_FORMAT_TIME, &duration) ||
+      duration <= 0) {
+    g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+        "Segmented transcoding needs a source of known duration");
+    goto done;
+  }
+
+  boundaries = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  g_array_append_val (boundaries, start);
+
+  for (i = 1; i < n_segments; i++) {
+    GstClockTime target = gst_util_uint64_scale (duration, i, n_segments);
+    gint64 position;
+
+    if (!gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+            GST_SEEK_FLAG_SNAP_BEFORE, target) ||
+        gst_element_get_state (pipeline, NULL, NULL,
+            GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE ||
+        !gst_element_query_position (pipeline, GST_FORMAT_TIME, &position)) {
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "Could not find the keyframe before %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (target));
+      g_clear_pointer (&boundaries, g_array_unref);
+      goto done;
+    }
+
+    /* a GOP longer than a range merges it with the next one */
+    if ((GstClockTime) position > g_array_index (boundaries, GstClockTime,
+            boundaries->len - 1)) {
+      start = position;
+      g_array_append_val (boundaries, start);
+    }
+  }
+
+  start = GST_CLOCK_TIME_NONE;
+  g_array_append_val (boundaries, start);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return boundaries;
+}
+
+/* links @pad to a new fakesink, in the bin of @sibling */
+static void
+link_to_fakesink (GstElement * sibling, GstPad * pad)
+{
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (sibling));
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstPad *sinkpad;
+
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (parent), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+  gst_object_unref (parent);
+}
+
+static gboolean
+link_to_encodebin (GstPad * pad, GstElement * encodebin)
+{
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstPad *sinkpad = NULL;
+  gboolean ret;
+
+  g_signal_emit_by_name (encodebin, "request-pad", caps, &sinkpad);
+  ret = sinkpad && gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK;
+
+  gst_clear_object (&sinkpad);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+/* returns a "urisourcebin ! parsebin" pipeline reading @source_uri */
+static GstElement *
+make_parse_pipeline (const gchar * source_uri, GstElement ** parsebin,
+    GError ** error)
+{
+  GstElement *pipeline;
+  GstElement *src;
+
+  pipeline = gst_parse_launch ("urisourcebin name=src ! parsebin name=parse",
+      error);
+  if (!pipeline)
+    return NULL;
+
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  g_object_set (src, "uri", source_uri, NULL);
+  gst_object_unref (src);
+
+  *parsebin = gst_bin_get_by_name (GST_BIN (pipeline), "parse");
+
+  return pipeline;
+}
+
+static void
+copy_decoded_pad_added_cb (GstElement * decodebin, GstPad * pad,
+    GstElement * encodebin)
+{
+  if (!link_to_encodebin (pad, encodebin))
+    link_to_fakesink (decodebin, pad);
+}
+
+static void
+copy_pad_added_cb (GstElement * parsebin, GstPad * pad, GstElement * encodebin)
+{
+  GstObject *parent;
+  GstElement *decodebin;
+  GstPad *sinkpad;
+
+  /* streams that already have the format of the profile are passed
+   * through */
+  if (link_to_encodebin (pad, encodebin))
+    return;
+
+  /* and the other ones transcoded */
+  decodebin = gst_element_factory_make ("decodebin", NULL);
+  if (!decodebin) {
+    link_to_fakesink (parsebin, pad);
+    return;
+  }
+
+  parent = gst_object_get_parent (GST_OBJECT (parsebin));
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (copy_decoded_pad_added_cb), encodebin);
+  gst_bin_add (GST_BIN (parent), decodebin);
+  sinkpad = gst_element_get_static_pad (decodebin, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (decodebin);
+  gst_object_unref (parent);
+}
+
+/* remuxes the range without decoding the streams the profile can take as
+ * they are */
+static GstElement *
+make_copy_pipeline (GstTranscoderSegment * segment, GError ** error)
+{
+  GstElement *pipeline;
+  GstElement *parsebin;
+  GstElement *encodebin;
+  GstElement *sink;
+
+  pipeline = make_parse_pipeline (segment->source_uri, &parsebin, error);
+  if (!pipeline)
+    return NULL;
+
+  encodebin = gst_element_factory_make ("encodebin", NULL);
+  sink = gst_element_make_from_uri (GST_URI_SINK, segment->dest_uri, NULL,
+      error);
+  if (!encodebin || !sink) {
+    if (!sink && error && !*error)
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "Could not create a sink for %s", segment->dest_uri);
+    gst_clear_object (&encodebin);
+    gst_clear_object (&sink);
+    gst_object_unref (parsebin);
+    gst_object_unref (pipeline);
+    return NULL;
+  }
+
+  g_object_set (encodebin, "profile", segment->profile, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), encodebin, sink, NULL);
+  gst_element_link (encodebin, sink);
+
+  g_signal_connect (parsebin, "pad-added", G_CALLBACK (copy_pad_added_cb),
+      encodebin);
+  gst_object_unref (parsebin);
+
+  return pipeline;
+}
+
+static gpointer
+run_segment (gpointer data)
+{
+  GstTranscoderSegment *segment = data;
+  GstElement *transcodebin;
+  GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
+
+  GST_DEBUG ("%s %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT
+      " to %s", segment->copy ? "Copying" : "Transcoding",
+      GST_TIME_ARGS (segment->start), GST_TIME_ARGS (segment->stop),
+      segment->dest_uri);
+
+  if (segment->copy) {
+    transcodebin = make_copy_pipeline (segment, &segment->error);
+    if (!transcodebin)
+      return NULL;
+  } else {
+    transcodebin = gst_element_factory_make ("uritranscodebin", NULL);
+    if (!transcodebin) {
+      g_set_error (&segment->error, GST_TRANSCODER_ERROR,
+          GST_TRANSCODER_ERROR_FAILED, "No uritranscodebin element");
+      return NULL;
+    }
+
+    g_object_set (transcodebin, "source-uri", segment->source_uri,
+        "dest-uri", segment->dest_uri, "profile", segment->profile,
+        "cpu-usage", segment->cpu_usage, NULL);
+
+    /* decodes from the keyframe before the start of the range and drops the
+     * frames outside of it */
+    flags |= GST_SEEK_FLAG_ACCURATE;
+  }
+
+  if (!preroll (transcodebin, &segment->error))
+    goto done;
+
+  if (!gst_element_seek (transcodebin, 1.0, GST_FORMAT_TIME, flags,
+          GST_SEEK_TYPE_SET, segment->start,
+          GST_CLOCK_TIME_IS_VALID (segment->stop) ?
+          GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, segment->stop)) {
+    g_set_error (&segment->error, GST_TRANSCODER_ERROR,
+        GST_TRANSCODER_ERROR_FAILED, "Could not seek to %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (segment->start));
+    goto done;
+  }
+
+  if (gst_element_set_state (transcodebin,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    g_set_error (&segment->error, GST_TRANSCODER_ERROR,
+        GST_TRANSCODER_ERROR_FAILED, "Could not start transcoding");
+    goto done;
+  }
+
+  wait_for_eos (transcodebin, &segment->error);
+
+done:
+  gst_element_set_state (transcodebin, GST_STATE_NULL);
+  gst_object_unref (transcodebin);
+
+  return NULL;
+}
+
+typedef struct
+{
+  /* (GstElement) concat of each stream profile, in profile order */
+  GPtrArray *concats;
+  /* (GstEncodingProfile) */
+  const GList *stream_profiles;
+  guint part;
+} GstTranscoderConcatPart;
+
+static void
+parsebin_pad_added_cb (GstElement * parsebin, GstPad * pad,
+    GstTranscoderConcatPart * part)
+{
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  const GList *l;
+  guint i;
+
+  /* each part has the streams of the profile, in the same order */
+  for (l = part->stream_profiles, i = 0; l; l = l->next, i++) {
+    GstCaps *format = gst_encoding_profile_get_format (l->data);
+    gchar *name = g_strdup_printf ("sink_%u", part->part);
+    GstPad *sinkpad;
+
+    if (gst_caps_can_intersect (caps, format)) {
+      sinkpad = gst_element_get_static_pad (g_ptr_array_index (part->concats,
+              i), name);
+      if (sinkpad && !gst_pad_is_linked (sinkpad))
+        gst_pad_link (pad, sinkpad);
+      gst_clear_object (&sinkpad);
+    }
+
+    g_free (name);
+    gst_caps_unref (format);
+
+    if (gst_pad_is_linked (pad))
+      break;
+  }
+
+  /* streams the profile does not output are dropped */
+  if (!gst_pad_is_linked (pad))
+    link_to_fakesink (parsebin, pad);
+
+  gst_caps_unref (caps);
+}
+
+/* concatenates the transcoded parts, which already have the format of the
+ * profile, so encodebin passes them through to the muxer */
+static gboolean
+concat_segments (GstTranscoderSegment * segments, guint n_segments,
+    const gchar * dest_uri, GstEncodingProfile * profile, GError ** error)
+{
+  GstElement *pipeline = gst_pipeline_new ("concat-segments");
+  GstElement *encodebin;
+  GstElement *sink;
+  GstTranscoderConcatPart *parts;
+  GList single = { profile, NULL, NULL };
+  const GList *stream_profiles = &single;
+  GPtrArray *concats;
+  const GList *l;
+  gboolean ret = FALSE;
+  guint i;
+
+  if (GST_IS_ENCODING_CONTAINER_PROFILE (profile)) {
+    stream_profiles = gst_encoding_container_profile_get_profiles
+        (GST_ENCODING_CONTAINER_PROFILE (profile));
+  }
+
+  parts = g_new0 (GstTranscoderConcatPart, n_segments);
+  concats = g_ptr_array_new ();
+
+  encodebin = gst_element_factory_make ("encodebin", NULL);
+  sink = gst_element_make_from_uri (GST_URI_SINK, dest_uri, NULL, error);
+  if (!encodebin || !sink) {
+    if (!sink && error && !*error)
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "Could not create a sink for %s", dest_uri);
+    gst_clear_object (&encodebin);
+    gst_clear_object (&sink);
+    goto done;
+  }
+
+  g_object_set (encodebin, "profile", profile, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), encodebin, sink, NULL);
+  gst_element_link (encodebin, sink);
+
+  for (l = stream_profiles; l; l = l->next) {
+    GstElement *concat = gst_element_factory_make ("concat", NULL);
+    GstCaps *format = gst_encoding_profile_get_format (l->data);
+    GstPad *srcpad;
+    GstPad *sinkpad = NULL;
+
+    gst_bin_add (GST_BIN (pipeline), concat);
+    g_ptr_array_add (concats, concat);
+
+    /* concat plays its sink pads in the order they were requested */
+    for (i = 0; i < n_segments; i++) {
+      GstPad *pad = gst_element_request_pad_simple (concat, "sink_%u");
+
+      gst_object_unref (pad);
+    }
+
+    g_signal_emit_by_name (encodebin, "request-pad", format, &sinkpad);
+    gst_caps_unref (format);
+
+    srcpad = gst_element_get_static_pad (concat, "src");
+    if (!sinkpad || gst_pad_link (srcpad, sinkpad) != GST_PAD_LINK_OK) {
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "Could not link the concatenated stream to encodebin");
+      gst_object_unref (srcpad);
+      gst_clear_object (&sinkpad);
+      goto done;
+    }
+    gst_object_unref (srcpad);
+    gst_object_unref (sinkpad);
+  }
+
+  for (i = 0; i < n_segments; i++) {
+    GstElement *src;
+    GstElement *parsebin;
+
+    src = gst_element_make_from_uri (GST_URI_SRC, segments[i].dest_uri, NULL,
+        error);
+    parsebin = gst_element_factory_make ("parsebin", NULL);
+    if (!src || !parsebin) {
+      gst_clear_object (&src);
+      gst_clear_object (&parsebin);
+      if (error && !*error)
+        g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+            "Could not read back %s", segments[i].dest_uri);
+      goto done;
+    }
+
+    parts[i].concats = concats;
+    parts[i].stream_profiles = stream_profiles;
+    parts[i].part = i;
+    g_signal_connect (parsebin, "pad-added",
+        G_CALLBACK (parsebin_pad_added_cb), &parts[i]);
+
+    gst_bin_add_many (GST_BIN (pipeline), src, parsebin, NULL);
+    gst_element_link (src, parsebin);
+  }
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+        "Could not start concatenating the segments");
+    goto done;
+  }
+
+  ret = wait_for_eos (pipeline, error);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_ptr_array_unref (concats);
+  g_free (parts);
+
+  return ret;
+}
+
+typedef struct
+{
+  GMutex lock;
+  /* caps of the indexed video stream, as the source has it */
+  GstCaps *caps;
+  GstH264NalParser *h264_parser;
+  GstH265Parser *h265_parser;
+  /* (GstClockTime) */
+  GArray *keyframes;
+} GstTranscoderKeyframeIndex;
+
+/* a copied range can only start at a picture that does not reference the
+ * ones before it, which rules out the CRA pictures of open GOPs */
+static gboolean
+index_buffer_is_keyframe (GstTranscoderKeyframeIndex * index,
+    GstBuffer * buffer)
+{
+  GstMapInfo map;
+  guint offset = 0;
+  gboolean ret = FALSE;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return FALSE;
+
+  while (!ret && offset < map.size) {
+    if (index->h264_parser) {
+      GstH264NalUnit nalu;
+      GstH264ParserResult res;
+
+      res = gst_h264_parser_identify_nalu (index->h264_parser, map.data,
+          offset, map.size, &nalu);
+      if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+        break;
+
+      ret = nalu.type == GST_H264_NAL_SLICE_IDR;
+      offset = nalu.offset + nalu.size;
+    } else {
+      GstH265NalUnit nalu;
+      GstH265ParserResult res;
+
+      res = gst_h265_parser_identify_nalu (index->h265_parser, map.data,
+          offset, map.size, &nalu);
+      if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+        break;
+
+      ret = GST_H265_IS_NAL_TYPE_IDR (nalu.type);
+      offset = nalu.offset + nalu.size;
+    }
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  return ret;
+}
+
+static void
+index_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GstTranscoderKeyframeIndex * index)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (pts) && index_buffer_is_keyframe (index,
+          buffer))
+    g_array_append_val (index->keyframes, pts);
+}
+
+static void
+index_pad_added_cb (GstElement * parsebin, GstPad * pad,
+    GstTranscoderKeyframeIndex * index)
+{
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstStructure *s;
+  const gchar *parser_name = NULL;
+  const gchar *filter_caps = NULL;
+  GstElement *parser = NULL;
+  GstObject *parent;
+  GstElement *filter;
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  g_mutex_lock (&index->lock);
+  if (!index->caps && !gst_caps_is_empty (caps)) {
+    s = gst_caps_get_structure (caps, 0);
+
+    if (gst_structure_has_name (s, "video/x-h264")) {
+      parser_name = "h264parse";
+      filter_caps = "video/x-h264,stream-format=byte-stream,alignment=au";
+    } else if (gst_structure_has_name (s, "video/x-h265")) {
+      parser_name = "h265parse";
+      filter_caps = "video/x-h265,stream-format=byte-stream,alignment=au";
+    }
+
+    if (parser_name)
+      parser = gst_element_factory_make (parser_name, NULL);
+
+    if (parser) {
+      index->caps = gst_caps_ref (caps);
+      if (gst_structure_has_name (s, "video/x-h264"))
+        index->h264_parser = gst_h264_nal_parser_new ();
+      else
+        index->h265_parser = gst_h265_parser_new ();
+    }
+  }
+  g_mutex_unlock (&index->lock);
+
+  gst_caps_unref (caps);
+
+  /* only the first H.264 or H.265 stream is indexed */
+  if (!parser) {
+    link_to_fakesink (parsebin, pad);
+    return;
+  }
+
+  /* byte-stream access units are parsed the same way whatever the source
+   * packs them as */
+  parent = gst_object_get_parent (GST_OBJECT (parsebin));
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  caps = gst_caps_from_string (filter_caps);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (index_handoff_cb), index);
+
+  gst_bin_add_many (GST_BIN (parent), parser, filter, sink, NULL);
+  gst_element_link_many (parser, filter, sink, NULL);
+  sinkpad = gst_element_get_static_pad (parser, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+  gst_element_sync_state_with_parent (filter);
+  gst_element_sync_state_with_parent (parser);
+  gst_object_unref (parent);
+}
+
+static GstCaps *
+get_video_format (GstEncodingProfile * profile)
+{
+  const GList *l;
+
+  if (GST_IS_ENCODING_VIDEO_PROFILE (profile))
+    return gst_encoding_profile_get_format (profile);
+
+  if (!GST_IS_ENCODING_CONTAINER_PROFILE (profile))
+    return NULL;
+
+  for (l = gst_encoding_container_profile_get_profiles
+      (GST_ENCODING_CONTAINER_PROFILE (profile)); l; l = l->next) {
+    if (GST_IS_ENCODING_VIDEO_PROFILE (l->data))
+      return gst_encoding_profile_get_format (l->data);
+  }
+
+  return NULL;
+}
+
+/* Returns the timestamps of the keyframes of the video stream of
+ * @source_uri, or an empty array if that stream can not be copied to the
+ * video format of @profile */
+static GArray *
+index_keyframes (const gchar * source_uri, GstEncodingProfile * profile,
+    GError ** error)
+{
+  GstTranscoderKeyframeIndex index = { 0, };
+  GstElement *pipeline;
+  GstElement *parsebin;
+  GstCaps *format;
+  gboolean ret;
+
+  index.keyframes = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+
+  format = get_video_format (profile);
+  if (!format)
+    return index.keyframes;
+
+  pipeline = make_parse_pipeline (source_uri, &parsebin, error);
+  if (!pipeline) {
+    gst_caps_unref (format);
+    g_array_unref (index.keyframes);
+    return NULL;
+  }
+
+  g_mutex_init (&index.lock);
+  g_signal_connect (parsebin, "pad-added", G_CALLBACK (index_pad_added_cb),
+      &index);
+  gst_object_unref (parsebin);
+
+  ret = gst_element_set_state (pipeline,
+      GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE;
+  if (ret)
+    ret = wait_for_eos (pipeline, error);
+  else
+    g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+        "Could not start indexing %s", source_uri);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  if (!ret) {
+    g_clear_pointer (&index.keyframes, g_array_unref);
+  } else if (!index.caps || !gst_caps_can_intersect (index.caps, format)) {
+    GST_INFO ("The video stream of %s can not be copied to %" GST_PTR_FORMAT,
+        source_uri, format);
+    g_array_set_size (index.keyframes, 0);
+  }
+
+  g_clear_pointer (&index.h264_parser, gst_h264_nal_parser_free);
+  g_clear_pointer (&index.h265_parser, gst_h265_parser_free);
+  gst_clear_caps (&index.caps);
+  gst_caps_unref (format);
+  g_mutex_clear (&index.lock);
+
+  return index.keyframes;
+}
+
+/* Runs the ranges in parallel and concatenates them into @dest_uri */
+static gboolean
+transcode_segments (GstTranscoderSegment * segments, guint n_segments,
+    const gchar * dest_uri, GstEncodingProfile * profile, GError ** error)
+{
+  gboolean ret = TRUE;
+  guint i;
+
+  for (i = 0; i < n_segments; i++) {
+    /* a single range needs no concatenation */
+    if (n_segments > 1)
+      segments[i].dest_uri = g_strdup_printf ("%s.part%u", dest_uri, i);
+    else
+      segments[i].dest_uri = g_strdup (dest_uri);
+
+    segments[i].thread = g_thread_new ("GstTranscoderSegment", run_segment,
+        &segments[i]);
+  }
+
+  for (i = 0; i < n_segments; i++) {
+    g_thread_join (segments[i].thread);
+
+    if (segments[i].error && ret) {
+      g_propagate_error (error, segments[i].error);
+      segments[i].error = NULL;
+      ret = FALSE;
+    }
+    g_clear_error (&segments[i].error);
+  }
+
+  if (ret && n_segments > 1)
+    ret = concat_segments (segments, n_segments, dest_uri, profile, error);
+
+  for (i = 0; i < n_segments; i++) {
+    if (n_segments > 1) {
+      gchar *filename = g_filename_from_uri (segments[i].dest_uri, NULL,
+          NULL);
+
+      if (filename)
+        g_unlink (filename);
+
+      g_free (filename);
+    }
+    g_free (segments[i].dest_uri);
+  }
+
+  return ret;
+}
+
+static void
+ensure_debug_category (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_transcoder_segments_debug,
+        "gst-transcoder-segments", 0, "GstTranscoder segmented transcoding");
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
+/*
+ * gst_transcoder_run_segments:
+ * @n_segments: the number of ranges to transcode in parallel
+ *
+ * Transcodes @source_uri to @dest_uri as @n_segments ranges transcoded in
+ * parallel. The ranges are written next to @dest_uri, which therefore has to
+ * be writable by a sink as well as readable by a source, and removed once
+ * they are concatenated.
+ */
+gboolean
+gst_transcoder_run_segments (const gchar * source_uri, const gchar * dest_uri,
+    GstEncodingProfile * profile, gint cpu_usage, guint n_segments,
+    GError ** error)
+{
+  GstTranscoderSegment *segments;
+  GArray *boundaries;
+  gboolean ret;
+  guint i;
+
+  ensure_debug_category ();
+
+  boundaries = find_boundaries (source_uri, n_segments, error);
+  if (!boundaries)
+    return FALSE;
+
+  n_segments = boundaries->len - 1;
+  GST_INFO ("Transcoding %s as %u segments", source_uri, n_segments);
+
+  segments = g_new0 (GstTranscoderSegment, n_segments);
+  for (i = 0; i < n_segments; i++) {
+    GstTranscoderSegment *segment = &segments[i];
+
+    segment->source_uri = source_uri;
+    segment->profile = profile;
+    segment->cpu_usage = cpu_usage;
+    segment->start = g_array_index (boundaries, GstClockTime, i);
+    segment->stop = g_array_index (boundaries, GstClockTime, i + 1);
+  }
+
+  ret = transcode_segments (segments, n_segments, dest_uri, profile, error);
+
+  g_free (segments);
+  g_array_unref (boundaries);
+
+  return ret;
+}
+
+/*
+ * gst_transcoder_run_clip:
+ * @start: the start of the range to keep
+ * @stop: the end of the range to keep, or %GST_CLOCK_TIME_NONE
+ * @smart_render: whether the GOPs inside the range are copied
+ *
+ * Transcodes the @start - @stop range of @source_uri to @dest_uri. With
+ * @smart_render, the GOPs of the video stream that lie entirely inside the
+ * range are copied, which needs the source to have the video format of
+ * @profile, and only the GOPs at the edges of the range are transcoded. The
+ * parts are written next to @dest_uri as for gst_transcoder_run_segments().
+ */
+gboolean
+gst_transcoder_run_clip (const gchar * source_uri, const gchar * dest_uri,
+    GstEncodingProfile * profile, gint cpu_usage, GstClockTime start,
+    GstClockTime stop, gboolean smart_render, GError ** error)
+{
+  /* the head of the range, its copied GOPs and its tail */
+  GstTranscoderSegment segments[3] = { {0,}, };
+  GstClockTime first = GST_CLOCK_TIME_NONE;
+  GstClockTime last = GST_CLOCK_TIME_NONE;
+  GArray *keyframes = NULL;
+  guint n_segments = 0;
+  guint i;
+
+  ensure_debug_category ();
+
+  if (smart_render) {
+    keyframes = index_keyframes (source_uri, profile, error);
+    if (!keyframes)
+      return FALSE;
+
+    /* the first and last keyframes inside of the range */
+    for (i = 0; i < keyframes->len; i++) {
+      GstClockTime keyframe = g_array_index (keyframes, GstClockTime, i);
+
+      if (keyframe < start)
+        continue;
+
+      if (GST_CLOCK_TIME_IS_VALID (stop) && keyframe > stop)
+        break;
+
+      if (!GST_CLOCK_TIME_IS_VALID (first))
+        first = keyframe;
+      last = keyframe;
+    }
+
+    g_array_unref (keyframes);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (segments); i++) {
+    segments[i].source_uri = source_uri;
+    segments[i].profile = profile;
+    segments[i].cpu_usage = cpu_usage;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (first) && (!GST_CLOCK_TIME_IS_VALID (stop) ||
+          first < last)) {
+    if (start < first) {
+      segments[n_segments].start = start;
+      segments[n_segments++].stop = first;
+    }
+
+    /* without an end, the range copies the last GOP too */
+    segments[n_segments].start = first;
+    segments[n_segments].stop = GST_CLOCK_TIME_IS_VALID (stop) ? last :
+        GST_CLOCK_TIME_NONE;
+    segments[n_segments++].copy = TRUE;
+
+    if (GST_CLOCK_TIME_IS_VALID (stop) && last < stop) {
+      segments[n_segments].start = last;
+      segments[n_segments++].stop = stop;
+    }
+
+    GST_INFO ("Copying %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT " of %s",
+        GST_TIME_ARGS (first), GST_TIME_ARGS (last), source_uri);
+  } else {
+    segments[n_segments].start = start;
+    segments[n_segments++].stop = stop;
+  }
+
+  return transcode_segments (segments, n_segments, dest_uri, profile, error);
+}
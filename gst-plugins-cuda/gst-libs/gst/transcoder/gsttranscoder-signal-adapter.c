@@ -41,6 +41,7 @@ enum
   SIGNAL_DONE,
   SIGNAL_ERROR,
   SIGNAL_WARNING,
+  SIGNAL_STATS,
   SIGNAL_LAST
 };
 
@@ -129,6 +130,25 @@ gst_transcoder_signal_adapter_emit (GstTranscoderSignalAdapter * self,
         gst_structure_free (details);
       break;
     }
+    case GST_TRANSCODER_MESSAGE_STATS:{
+      GstStructure *elements = NULL;
+      gdouble fps, realtime_factor;
+
+      gst_structure_get (message_data, GST_TRANSCODER_MESSAGE_DATA_FPS,
+          G_TYPE_DOUBLE, &fps, GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR,
+          G_TYPE_DOUBLE, &realtime_factor,
+          GST_TRANSCODER_MESSAGE_DATA_ELEMENTS, GST_TYPE_STRUCTURE, &elements,
+          NULL);
+      g_signal_emit (self, signals[SIGNAL_STATS], 0, fps, realtime_factor,
+          elements);
+      if (elements)
+        gst_structure_free (elements);
+      break;
+    }
+    case GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS:
+    case GST_TRANSCODER_MESSAGE_JOB_DONE:
+      /* only posted by GstTranscoderQueue, which has no signal adapter */
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -311,6 +331,19 @@ gst_transcoder_signal_adapter_class_init (GstTranscoderSignalAdapterClass *
       G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
       NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_TRANSCODER_STATE);
 
+  /**
+   * GstTranscoderSignalAdapter::stats:
+   * @fps: the frames output by the video encoders per second
+   * @realtime_factor: the media time transcoded per second
+   * @elements: the statistics of each element, see
+   * gst_transcoder_message_parse_stats()
+   */
+  signals[SIGNAL_STATS] =
+      g_signal_new ("stats", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 3, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+      GST_TYPE_STRUCTURE);
+
   /**
    * GstTranscoderSignalAdapter:transcoder:
    *
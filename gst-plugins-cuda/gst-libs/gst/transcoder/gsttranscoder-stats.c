@@ -0,0 +1,521 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Statistics of the elements of a transcoding pipeline, collected by pad
+ * probes on every element the pipeline contains.
+ *
+ * The processing latency of an element is the wall clock time between a
+ * buffer entering it and the buffer with the same PTS leaving it, which also
+ * covers the frames encoders and decoders hold back. Buffers whose PTS does
+ * not survive the element are matched to the last buffer that entered it.
+ *
+ * The trace file uses the Chrome trace event format, with one row per
+ * element, so that it can be loaded in chrome://tracing or Perfetto.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsttranscoder.h"
+#include "gsttranscoder-private.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_transcoder_stats_debug);
+#define GST_CAT_DEFAULT gst_transcoder_stats_debug
+
+/* powers of two of microseconds, the last bucket has no upper bound */
+#define N_LATENCY_BUCKETS 20
+/* buffers an element can hold before the oldest ones are forgotten */
+#define N_PENDING_BUFFERS 64
+
+typedef struct
+{
+  GstClockTime pts;
+  gint64 time;
+} GstTranscoderPendingBuffer;
+
+typedef struct
+{
+  GstTranscoderStats *stats;
+  GstElement *element;
+  gchar *name;
+  /* the name, escaped for the trace */
+  gchar *trace_name;
+  /* row of the element in the trace */
+  guint index;
+  gboolean is_video_encoder;
+  gboolean is_queue;
+  gulong pad_added_id;
+
+  GMutex lock;
+  GstTranscoderPendingBuffer pending[N_PENDING_BUFFERS];
+  guint n_pending;
+  gint64 last_entry;
+  guint64 n_buffers;
+  guint64 n_sampled_buffers;
+  guint64 n_latencies;
+  GstClockTime latency_sum;
+  GstClockTime latency_max;
+  guint64 histogram[N_LATENCY_BUCKETS];
+} GstTranscoderElementStats;
+
+typedef struct
+{
+  GstPad *pad;
+  gulong id;
+} GstTranscoderProbe;
+
+struct _GstTranscoderStats
+{
+  GstElement *pipeline;
+  gulong element_added_id;
+  gint64 start_time;
+
+  /* protects the elements, the probes and the trace file */
+  GMutex lock;
+  /* (GstTranscoderElementStats) */
+  GPtrArray *elements;
+  /* (GstTranscoderProbe) */
+  GArray *probes;
+  FILE *trace;
+  gboolean trace_empty;
+
+  gint64 last_sample_time;
+  GstClockTime last_position;
+};
+
+static void
+element_stats_free (GstTranscoderElementStats * element_stats)
+{
+  if (element_stats->pad_added_id)
+    g_signal_handler_disconnect (element_stats->element,
+        element_stats->pad_added_id);
+
+  gst_object_unref (element_stats->element);
+  g_free (element_stats->name);
+  g_free (element_stats->trace_name);
+  g_mutex_clear (&element_stats->lock);
+  g_free (element_stats);
+}
+
+/* called with the stats lock */
+static void
+write_trace_event (GstTranscoderStats * stats, const gchar * format, ...)
+{
+  va_list args;
+
+  if (!stats->trace)
+    return;
+
+  fputs (stats->trace_empty ? "\n" : ",\n", stats->trace);
+  stats->trace_empty = FALSE;
+
+  va_start (args, format);
+  vfprintf (stats->trace, format, args);
+  va_end (args);
+}
+
+static guint
+latency_bucket (GstClockTime latency)
+{
+  guint64 us = latency / GST_USECOND;
+  guint bucket = 0;
+
+  while (us > 1 && bucket < N_LATENCY_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+static GstBuffer *
+probe_info_get_buffer (GstPadProbeInfo * info)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+    return GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info)) == 0)
+    return NULL;
+
+  return gst_buffer_list_get (GST_PAD_PROBE_INFO_BUFFER_LIST (info), 0);
+}
+
+static GstPadProbeReturn
+sink_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    GstTranscoderElementStats * element_stats)
+{
+  GstBuffer *buffer = probe_info_get_buffer (info);
+  GstTranscoderPendingBuffer *pending;
+  gint64 now = g_get_monotonic_time ();
+
+  if (!buffer)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&element_stats->lock);
+  pending = &element_stats->pending[element_stats->n_pending++ %
+      N_PENDING_BUFFERS];
+  pending->pts = GST_BUFFER_PTS (buffer);
+  pending->time = now;
+  element_stats->last_entry = now;
+  g_mutex_unlock (&element_stats->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+src_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    GstTranscoderElementStats * element_stats)
+{
+  GstTranscoderStats *stats = element_stats->stats;
+  GstBuffer *buffer = probe_info_get_buffer (info);
+  gint64 now = g_get_monotonic_time ();
+  gint64 entry = 0;
+  GstClockTime latency;
+  guint n_pending;
+  guint i;
+
+  if (!buffer)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&element_stats->lock);
+  element_stats->n_buffers++;
+
+  /* the latest buffer with the same PTS first */
+  n_pending = MIN (element_stats->n_pending, N_PENDING_BUFFERS);
+  for (i = 1; i <= n_pending && GST_BUFFER_PTS_IS_VALID (buffer); i++) {
+    GstTranscoderPendingBuffer *pending =
+        &element_stats->pending[(element_stats->n_pending - i) %
+        N_PENDING_BUFFERS];
+
+    if (pending->pts == GST_BUFFER_PTS (buffer)) {
+      entry = pending->time;
+      break;
+    }
+  }
+
+  if (!entry)
+    entry = element_stats->last_entry;
+
+  /* sources have nothing entering them */
+  if (!entry) {
+    g_mutex_unlock (&element_stats->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  latency = (now - entry) * GST_USECOND;
+  element_stats->n_latencies++;
+  element_stats->latency_sum += latency;
+  element_stats->latency_max = MAX (element_stats->latency_max, latency);
+  element_stats->histogram[latency_bucket (latency)]++;
+  g_mutex_unlock (&element_stats->lock);
+
+  g_mutex_lock (&stats->lock);
+  write_trace_event (stats, "{\"name\":\"%s\",\"cat\":\"buffer\",\"ph\":\"X\","
+      "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":0,"
+      "\"tid\":%u}", element_stats->trace_name, entry - stats->start_time,
+      now - entry, element_stats->index);
+  g_mutex_unlock (&stats->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+add_probe (GstTranscoderElementStats * element_stats, GstPad * pad)
+{
+  GstTranscoderStats *stats = element_stats->stats;
+  GstTranscoderProbe probe;
+
+  probe.pad = gst_object_ref (pad);
+  probe.id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) (GST_PAD_IS_SINK (pad) ? sink_probe_cb :
+          src_probe_cb), element_stats, NULL);
+
+  g_mutex_lock (&stats->lock);
+  g_array_append_val (stats->probes, probe);
+  g_mutex_unlock (&stats->lock);
+}
+
+static gboolean
+add_probe_foreach (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  add_probe (user_data, pad);
+
+  return TRUE;
+}
+
+static void
+pad_added_cb (GstElement * element, GstPad * pad,
+    GstTranscoderElementStats * element_stats)
+{
+  add_probe (element_stats, pad);
+}
+
+static void
+add_element (GstTranscoderStats * stats, GstElement * element)
+{
+  GstTranscoderElementStats *element_stats;
+  GstElementFactory *factory;
+
+  /* the elements of bins are added on their own */
+  if (GST_IS_BIN (element))
+    return;
+
+  element_stats = g_new0 (GstTranscoderElementStats, 1);
+  element_stats->stats = stats;
+  element_stats->element = gst_object_ref (element);
+  element_stats->name = gst_element_get_name (element);
+  element_stats->trace_name = g_strescape (element_stats->name, NULL);
+  element_stats->is_queue =
+      g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+      "current-level-time") != NULL;
+  g_mutex_init (&element_stats->lock);
+
+  factory = gst_element_get_factory (element);
+  if (factory) {
+    const gchar *klass = gst_element_factory_get_metadata (factory,
+        GST_ELEMENT_METADATA_KLASS);
+
+    element_stats->is_video_encoder = klass && strstr (klass, "Encoder") &&
+        strstr (klass, "Video");
+  }
+
+  g_mutex_lock (&stats->lock);
+  element_stats->index = stats->elements->len;
+  g_ptr_array_add (stats->elements, element_stats);
+  write_trace_event (stats, "{\"name\":\"thread_name\",\"ph\":\"M\","
+      "\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", element_stats->index,
+      element_stats->trace_name);
+  g_mutex_unlock (&stats->lock);
+
+  element_stats->pad_added_id = g_signal_connect (element, "pad-added",
+      G_CALLBACK (pad_added_cb), element_stats);
+  gst_element_foreach_pad (element, add_probe_foreach, element_stats);
+
+  GST_DEBUG ("Collecting statistics of %s", element_stats->name);
+}
+
+static void
+deep_element_added_cb (GstBin * bin, GstBin * sub_bin, GstElement * element,
+    GstTranscoderStats * stats)
+{
+  add_element (stats, element);
+}
+
+static void
+add_element_foreach (const GValue * value, gpointer user_data)
+{
+  add_element (user_data, g_value_get_object (value));
+}
+
+/*
+ * gst_transcoder_stats_new:
+ * @pipeline: the pipeline to collect the statistics of
+ * @trace_file: (nullable): the file to write the timeline of the buffers to
+ *
+ * Starts collecting statistics of the elements @pipeline has or will have.
+ */
+GstTranscoderStats *
+gst_transcoder_stats_new (GstElement * pipeline, const gchar * trace_file)
+{
+  GstTranscoderStats *stats = g_new0 (GstTranscoderStats, 1);
+  GstIterator *it;
+
+  GST_DEBUG_CATEGORY_INIT (gst_transcoder_stats_debug,
+      "gst-transcoder-stats", 0, "GstTranscoder statistics");
+
+  stats->pipeline = gst_object_ref (pipeline);
+  stats->start_time = stats->last_sample_time = g_get_monotonic_time ();
+  stats->last_position = GST_CLOCK_TIME_NONE;
+  stats->elements =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) element_stats_free);
+  stats->probes = g_array_new (FALSE, FALSE, sizeof (GstTranscoderProbe));
+  stats->trace_empty = TRUE;
+  g_mutex_init (&stats->lock);
+
+  if (trace_file) {
+    stats->trace = g_fopen (trace_file, "w");
+    if (stats->trace)
+      fputs ("{\"traceEvents\":[", stats->trace);
+    else
+      GST_WARNING ("Could not open %s for writing", trace_file);
+  }
+
+  stats->element_added_id = g_signal_connect (pipeline, "deep-element-added",
+      G_CALLBACK (deep_element_added_cb), stats);
+
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  while (gst_iterator_foreach (it, add_element_foreach,
+          stats) == GST_ITERATOR_RESYNC)
+    gst_iterator_resync (it);
+  gst_iterator_free (it);
+
+  return stats;
+}
+
+static gdouble
+queue_fill (GstElement * queue)
+{
+  guint64 level_time, max_time;
+  guint level_buffers, max_buffers;
+  gdouble fill = 0.0;
+
+  g_object_get (queue, "current-level-time", &level_time,
+      "max-size-time", &max_time, "current-level-buffers", &level_buffers,
+      "max-size-buffers", &max_buffers, NULL);
+
+  /* the fullest of the limits the queue has */
+  if (max_time)
+    fill = MAX (fill, (gdouble) level_time / max_time);
+  if (max_buffers)
+    fill = MAX (fill, (gdouble) level_buffers / max_buffers);
+
+  return fill;
+}
+
+/*
+ * gst_transcoder_stats_sample:
+ * @position: the position of the pipeline
+ * @fps: (out): the frames output by the video encoders per second since the
+ * last sample
+ * @realtime_factor: (out): the media time transcoded per second since the
+ * last sample
+ *
+ * Returns: (transfer full): the statistics of every element, as a structure
+ * with one field of the name of each element
+ */
+GstStructure *
+gst_transcoder_stats_sample (GstTranscoderStats * stats,
+    GstClockTime position, gdouble * fps, gdouble * realtime_factor)
+{
+  GstStructure *elements = gst_structure_new_empty ("elements");
+  GString *fills = g_string_new (NULL);
+  gint64 now = g_get_monotonic_time ();
+  gdouble elapsed = (gdouble) (now - stats->last_sample_time) / G_USEC_PER_SEC;
+  guint64 n_frames = 0;
+  guint i, j;
+
+  g_mutex_lock (&stats->lock);
+  for (i = 0; i < stats->elements->len; i++) {
+    GstTranscoderElementStats *element_stats =
+        g_ptr_array_index (stats->elements, i);
+    GValue histogram = G_VALUE_INIT;
+    GstStructure *s;
+
+    gst_value_array_init (&histogram, N_LATENCY_BUCKETS);
+
+    g_mutex_lock (&element_stats->lock);
+    for (j = 0; j < N_LATENCY_BUCKETS; j++) {
+      GValue count = G_VALUE_INIT;
+
+      g_value_init (&count, G_TYPE_UINT64);
+      g_value_set_uint64 (&count, element_stats->histogram[j]);
+      gst_value_array_append_and_take_value (&histogram, &count);
+    }
+
+    s = gst_structure_new ("element-stats",
+        "buffers", G_TYPE_UINT64, element_stats->n_buffers,
+        "latency-mean", GST_TYPE_CLOCK_TIME, element_stats->n_latencies ?
+        element_stats->latency_sum / element_stats->n_latencies : 0,
+        "latency-max", GST_TYPE_CLOCK_TIME, element_stats->latency_max, NULL);
+    gst_structure_take_value (s, "latency-histogram", &histogram);
+
+    if (element_stats->is_video_encoder)
+      n_frames += element_stats->n_buffers - element_stats->n_sampled_buffers;
+    element_stats->n_sampled_buffers = element_stats->n_buffers;
+    g_mutex_unlock (&element_stats->lock);
+
+    if (element_stats->is_queue) {
+      gdouble fill = queue_fill (element_stats->element);
+
+      gst_structure_set (s, "queue-fill", G_TYPE_DOUBLE, fill, NULL);
+      g_string_append_printf (fills, "%s\"%s\":%.3f", fills->len ? "," : "",
+          element_stats->trace_name, fill);
+    }
+
+    gst_structure_set (elements, element_stats->name, GST_TYPE_STRUCTURE, s,
+        NULL);
+    gst_structure_free (s);
+  }
+
+  *fps = elapsed > 0 ? n_frames / elapsed : 0.0;
+  *realtime_factor = 0.0;
+  if (elapsed > 0 && GST_CLOCK_TIME_IS_VALID (position)) {
+    GstClockTime last = GST_CLOCK_TIME_IS_VALID (stats->last_position) ?
+        stats->last_position : 0;
+
+    if (position > last)
+      *realtime_factor = (gdouble) (position - last) / GST_SECOND / elapsed;
+    stats->last_position = position;
+  }
+  stats->last_sample_time = now;
+
+  write_trace_event (stats, "{\"name\":\"throughput\",\"ph\":\"C\","
+      "\"ts\":%" G_GINT64_FORMAT ",\"pid\":0,\"args\":{\"fps\":%.3f,"
+      "\"realtime-factor\":%.3f}}", now - stats->start_time, *fps,
+      *realtime_factor);
+  if (fills->len) {
+    write_trace_event (stats, "{\"name\":\"queue-fill\",\"ph\":\"C\","
+        "\"ts\":%" G_GINT64_FORMAT ",\"pid\":0,\"args\":{%s}}",
+        now - stats->start_time, fills->str);
+  }
+  g_mutex_unlock (&stats->lock);
+
+  g_string_free (fills, TRUE);
+
+  return elements;
+}
+
+/*
+ * gst_transcoder_stats_free:
+ *
+ * Stops collecting statistics and completes the trace file. Buffers must no
+ * longer flow through the pipeline.
+ */
+void
+gst_transcoder_stats_free (GstTranscoderStats * stats)
+{
+  guint i;
+
+  g_signal_handler_disconnect (stats->pipeline, stats->element_added_id);
+
+  for (i = 0; i < stats->probes->len; i++) {
+    GstTranscoderProbe *probe =
+        &g_array_index (stats->probes, GstTranscoderProbe, i);
+
+    gst_pad_remove_probe (probe->pad, probe->id);
+    gst_object_unref (probe->pad);
+  }
+
+  if (stats->trace) {
+    fputs ("\n]}\n", stats->trace);
+    fclose (stats->trace);
+  }
+
+  g_array_unref (stats->probes);
+  g_ptr_array_unref (stats->elements);
+  g_mutex_clear (&stats->lock);
+  gst_object_unref (stats->pipeline);
+  g_free (stats);
+}
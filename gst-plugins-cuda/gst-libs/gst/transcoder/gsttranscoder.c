@@ -40,6 +40,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_transcoder_debug);
 #define DEFAULT_DURATION GST_CLOCK_TIME_NONE
 #define DEFAULT_POSITION_UPDATE_INTERVAL_MS 100
 #define DEFAULT_AVOID_REENCODING   FALSE
+#define DEFAULT_N_SEGMENTS 1
+#define DEFAULT_CLIP_START 0
+#define DEFAULT_CLIP_STOP GST_CLOCK_TIME_NONE
+#define DEFAULT_SMART_RENDER FALSE
+#define DEFAULT_COLLECT_STATS FALSE
+#define DEFAULT_STATS_TRACE_FILE NULL
 
 GQuark
 gst_transcoder_error_quark (void)
@@ -63,6 +69,12 @@ enum
   PROP_PIPELINE,
   PROP_POSITION_UPDATE_INTERVAL,
   PROP_AVOID_REENCODING,
+  PROP_N_SEGMENTS,
+  PROP_CLIP_START,
+  PROP_CLIP_STOP,
+  PROP_SMART_RENDER,
+  PROP_COLLECT_STATS,
+  PROP_STATS_TRACE_FILE,
   PROP_LAST
 };
 
@@ -87,6 +99,13 @@ struct _GstTranscoder
 
   guint position_update_interval_ms;
   gint wanted_cpu_usage;
+  guint n_segments;
+  GstClockTime clip_start;
+  GstClockTime clip_stop;
+  gboolean smart_render;
+  gboolean collect_stats;
+  gchar *stats_trace_file;
+  GstTranscoderStats *stats;
 
   GstClockTime last_duration;
 
@@ -154,6 +173,11 @@ gst_transcoder_init (GstTranscoder * self)
   self->loop = g_main_loop_new (self->context, FALSE);
   self->api_bus = gst_bus_new ();
   self->wanted_cpu_usage = 100;
+  self->n_segments = DEFAULT_N_SEGMENTS;
+  self->clip_start = DEFAULT_CLIP_START;
+  self->clip_stop = DEFAULT_CLIP_STOP;
+  self->smart_render = DEFAULT_SMART_RENDER;
+  self->collect_stats = DEFAULT_COLLECT_STATS;
 
   self->position_update_interval_ms = DEFAULT_POSITION_UPDATE_INTERVAL_MS;
 
@@ -216,6 +240,80 @@ gst_transcoder_class_init (GstTranscoderClass * klass)
       "Whether to re-encode portions of compatible video streams that lay on segment boundaries",
       DEFAULT_AVOID_REENCODING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstTranscoder:n-segments:
+   *
+   * Number of time ranges gst_transcoder_run() splits the source into, at
+   * video keyframes, to transcode them in parallel before concatenating
+   * them. 1 transcodes the source as a whole.
+   */
+  param_specs[PROP_N_SEGMENTS] =
+      g_param_spec_uint ("n-segments", "Number of segments",
+      "Number of time ranges transcoded in parallel by gst_transcoder_run()",
+      1, 64, DEFAULT_N_SEGMENTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoder:clip-start:
+   *
+   * Start of the range of the source gst_transcoder_run() transcodes.
+   */
+  param_specs[PROP_CLIP_START] =
+      g_param_spec_uint64 ("clip-start", "Clip start",
+      "Start of the range of the source transcoded by gst_transcoder_run()",
+      0, G_MAXUINT64, DEFAULT_CLIP_START,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoder:clip-stop:
+   *
+   * End of the range of the source gst_transcoder_run() transcodes,
+   * %GST_CLOCK_TIME_NONE for the end of the source.
+   */
+  param_specs[PROP_CLIP_STOP] =
+      g_param_spec_uint64 ("clip-stop", "Clip stop",
+      "End of the range of the source transcoded by gst_transcoder_run() "
+      "(-1 = end of the source)", 0, G_MAXUINT64, DEFAULT_CLIP_STOP,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoder:smart-render:
+   *
+   * When clipping, copy the GOPs of the video stream that lie entirely
+   * inside the clip range instead of decoding and encoding them again, so
+   * that only the GOPs at its edges are transcoded. Needs an H.264 or H.265
+   * source that already has the video format of the profile, the whole
+   * range is transcoded otherwise.
+   */
+  param_specs[PROP_SMART_RENDER] =
+      g_param_spec_boolean ("smart-render", "Smart render",
+      "Copy the video GOPs inside the clip range instead of transcoding them",
+      DEFAULT_SMART_RENDER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoder:collect-stats:
+   *
+   * Collect the processing latency of every element of the pipeline, the
+   * fill level of its queues, the frame rate of its video encoders and the
+   * realtime factor, and post them as #GST_TRANSCODER_MESSAGE_STATS messages
+   * along with the position updates. Takes effect on the next run.
+   */
+  param_specs[PROP_COLLECT_STATS] =
+      g_param_spec_boolean ("collect-stats", "Collect stats",
+      "Post processing statistics of the pipeline with the position updates",
+      DEFAULT_COLLECT_STATS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoder:stats-trace-file:
+   *
+   * When #GstTranscoder:collect-stats is set, also write the time every
+   * buffer spent in every element to this file, in the Chrome trace event
+   * format.
+   */
+  param_specs[PROP_STATS_TRACE_FILE] =
+      g_param_spec_string ("stats-trace-file", "Stats trace file",
+      "File to write a Chrome trace of the buffers processed to",
+      DEFAULT_STATS_TRACE_FILE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 }
 
@@ -261,6 +359,7 @@ gst_transcoder_finalize (GObject * object)
 
   g_free (self->source_uri);
   g_free (self->dest_uri);
+  g_free (self->stats_trace_file);
   g_cond_clear (&self->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -330,6 +429,37 @@ gst_transcoder_set_property (GObject * object, guint prop_id,
       g_object_set (self->transcodebin, "avoid-reencoding",
           g_value_get_boolean (value), NULL);
       break;
+    case PROP_N_SEGMENTS:
+      GST_OBJECT_LOCK (self);
+      self->n_segments = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CLIP_START:
+      GST_OBJECT_LOCK (self);
+      self->clip_start = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CLIP_STOP:
+      GST_OBJECT_LOCK (self);
+      self->clip_stop = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SMART_RENDER:
+      GST_OBJECT_LOCK (self);
+      self->smart_render = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_COLLECT_STATS:
+      GST_OBJECT_LOCK (self);
+      self->collect_stats = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS_TRACE_FILE:
+      GST_OBJECT_LOCK (self);
+      g_free (self->stats_trace_file);
+      self->stats_trace_file = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -399,6 +529,36 @@ gst_transcoder_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, avoid_reencoding);
       break;
     }
+    case PROP_N_SEGMENTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->n_segments);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CLIP_START:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->clip_start);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CLIP_STOP:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->clip_stop);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SMART_RENDER:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->smart_render);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_COLLECT_STATS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->collect_stats);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS_TRACE_FILE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->stats_trace_file);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -468,6 +628,20 @@ tick_cb (gpointer user_data)
       GST_TRANSCODER_MESSAGE_DATA_POSITION, GST_TYPE_CLOCK_TIME, position,
       NULL);
 
+  if (self->stats) {
+    GstStructure *elements;
+    gdouble fps, realtime_factor;
+
+    elements = gst_transcoder_stats_sample (self->stats, position, &fps,
+        &realtime_factor);
+    api_bus_post_message (self, GST_TRANSCODER_MESSAGE_STATS,
+        GST_TRANSCODER_MESSAGE_DATA_FPS, G_TYPE_DOUBLE, fps,
+        GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR, G_TYPE_DOUBLE,
+        realtime_factor, GST_TRANSCODER_MESSAGE_DATA_ELEMENTS,
+        GST_TYPE_STRUCTURE, elements, NULL);
+    gst_structure_free (elements);
+  }
+
   return G_SOURCE_CONTINUE;
 }
 
@@ -619,6 +793,7 @@ eos_cb (G_GNUC_UNUSED GstBus * bus, G_GNUC_UNUSED GstMessage * msg,
       (gint64 *) & self->last_duration);
   tick_cb (self);
   remove_tick_source (self);
+  g_clear_pointer (&self->stats, gst_transcoder_stats_free);
 
   notify_state_changed (self, GST_TRANSCODER_STATE_STOPPED);
   api_bus_post_message (self, GST_TRANSCODER_MESSAGE_DONE, NULL, NULL);
@@ -840,6 +1015,7 @@ gst_transcoder_main (gpointer data)
   self->current_state = GST_STATE_NULL;
   if (self->transcodebin) {
     gst_element_set_state (self->transcodebin, GST_STATE_NULL);
+    g_clear_pointer (&self->stats, gst_transcoder_stats_free);
     g_clear_object (&self->transcodebin);
   }
 
@@ -963,15 +1139,51 @@ _done_cb (RunSyncData * data)
  * Run the transcoder task synchonously. You can connect
  * to the 'position' signal to get information about the
  * progress of the transcoding.
+ *
+ * When #GstTranscoder:n-segments is more than 1, the segments are
+ * transcoded in parallel and no position is reported.
+ *
+ * When #GstTranscoder:clip-start or #GstTranscoder:clip-stop are set, only
+ * that range of the source is transcoded, #GstTranscoder:n-segments is
+ * ignored and no position is reported either.
  */
 gboolean
 gst_transcoder_run (GstTranscoder * self, GError ** error)
 {
   RunSyncData data = { 0, };
   GstTranscoderSignalAdapter *signal_adapter;
+  guint n_segments;
+  GstClockTime clip_start, clip_stop;
+  gboolean smart_render, clipped;
 
   g_return_val_if_fail (GST_IS_TRANSCODER (self), FALSE);
 
+  GST_OBJECT_LOCK (self);
+  n_segments = self->n_segments;
+  clip_start = self->clip_start;
+  clip_stop = self->clip_stop;
+  smart_render = self->smart_render;
+  GST_OBJECT_UNLOCK (self);
+
+  clipped = clip_start > 0 || GST_CLOCK_TIME_IS_VALID (clip_stop);
+
+  if (n_segments > 1 || clipped) {
+    if (!self->profile) {
+      g_set_error (error, GST_TRANSCODER_ERROR, GST_TRANSCODER_ERROR_FAILED,
+          "No \"profile\" provided");
+      return FALSE;
+    }
+
+    if (clipped) {
+      return gst_transcoder_run_clip (self->source_uri, self->dest_uri,
+          self->profile, self->wanted_cpu_usage, clip_start, clip_stop,
+          smart_render, error);
+    }
+
+    return gst_transcoder_run_segments (self->source_uri, self->dest_uri,
+        self->profile, self->wanted_cpu_usage, n_segments, error);
+  }
+
   signal_adapter = gst_transcoder_get_signal_adapter (self, NULL);
 
   data.loop = g_main_loop_new (NULL, FALSE);
@@ -1026,6 +1238,13 @@ gst_transcoder_run_async (GstTranscoder * self)
     return;
   }
 
+  GST_OBJECT_LOCK (self);
+  if (self->collect_stats && !self->stats) {
+    self->stats = gst_transcoder_stats_new (self->transcodebin,
+        self->stats_trace_file);
+  }
+  GST_OBJECT_UNLOCK (self);
+
   self->target_state = GST_STATE_PLAYING;
   state_ret = gst_element_set_state (self->transcodebin, GST_STATE_PLAYING);
 
@@ -1233,6 +1452,181 @@ gst_transcoder_set_avoid_reencoding (GstTranscoder * self,
   g_object_set (self->transcodebin, "avoid-reencoding", avoid_reencoding, NULL);
 }
 
+/**
+ * gst_transcoder_get_n_segments:
+ * @self: #GstTranscoder instance
+ *
+ * Returns: the number of time ranges gst_transcoder_run() transcodes in
+ * parallel
+ */
+guint
+gst_transcoder_get_n_segments (GstTranscoder * self)
+{
+  guint val;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER (self), DEFAULT_N_SEGMENTS);
+
+  g_object_get (self, "n-segments", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_transcoder_set_n_segments:
+ * @self: #GstTranscoder instance
+ * @n_segments: the number of time ranges to transcode in parallel
+ *
+ * See #GstTranscoder:n-segments.
+ */
+void
+gst_transcoder_set_n_segments (GstTranscoder * self, guint n_segments)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  g_object_set (self, "n-segments", n_segments, NULL);
+}
+
+/**
+ * gst_transcoder_get_clip_range:
+ * @self: #GstTranscoder instance
+ * @start: (out) (optional): the start of the clip range
+ * @stop: (out) (optional): the end of the clip range
+ *
+ * See #GstTranscoder:clip-start and #GstTranscoder:clip-stop.
+ */
+void
+gst_transcoder_get_clip_range (GstTranscoder * self, GstClockTime * start,
+    GstClockTime * stop)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  GST_OBJECT_LOCK (self);
+  if (start)
+    *start = self->clip_start;
+  if (stop)
+    *stop = self->clip_stop;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/**
+ * gst_transcoder_set_clip_range:
+ * @self: #GstTranscoder instance
+ * @start: the start of the range to transcode
+ * @stop: the end of the range to transcode, or %GST_CLOCK_TIME_NONE
+ *
+ * See #GstTranscoder:clip-start and #GstTranscoder:clip-stop.
+ */
+void
+gst_transcoder_set_clip_range (GstTranscoder * self, GstClockTime start,
+    GstClockTime stop)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+  g_return_if_fail (!GST_CLOCK_TIME_IS_VALID (stop) || start < stop);
+
+  g_object_set (self, "clip-start", start, "clip-stop", stop, NULL);
+}
+
+/**
+ * gst_transcoder_get_smart_render:
+ * @self: #GstTranscoder instance
+ *
+ * Returns: %TRUE if the GOPs inside the clip range are copied
+ */
+gboolean
+gst_transcoder_get_smart_render (GstTranscoder * self)
+{
+  gboolean val;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER (self), DEFAULT_SMART_RENDER);
+
+  g_object_get (self, "smart-render", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_transcoder_set_smart_render:
+ * @self: #GstTranscoder instance
+ * @smart_render: whether to copy the GOPs inside the clip range
+ *
+ * See #GstTranscoder:smart-render.
+ */
+void
+gst_transcoder_set_smart_render (GstTranscoder * self, gboolean smart_render)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  g_object_set (self, "smart-render", smart_render, NULL);
+}
+
+/**
+ * gst_transcoder_get_collect_stats:
+ * @self: #GstTranscoder instance
+ *
+ * Returns: %TRUE if processing statistics are posted on the message bus
+ */
+gboolean
+gst_transcoder_get_collect_stats (GstTranscoder * self)
+{
+  gboolean val;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER (self), DEFAULT_COLLECT_STATS);
+
+  g_object_get (self, "collect-stats", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_transcoder_set_collect_stats:
+ * @self: #GstTranscoder instance
+ * @collect_stats: whether to post processing statistics
+ *
+ * See #GstTranscoder:collect-stats.
+ */
+void
+gst_transcoder_set_collect_stats (GstTranscoder * self, gboolean collect_stats)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  g_object_set (self, "collect-stats", collect_stats, NULL);
+}
+
+/**
+ * gst_transcoder_get_stats_trace_file:
+ * @self: #GstTranscoder instance
+ *
+ * Returns: (transfer full) (nullable): the file the trace of the buffers
+ * processed is written to
+ */
+gchar *
+gst_transcoder_get_stats_trace_file (GstTranscoder * self)
+{
+  gchar *val;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER (self), NULL);
+
+  g_object_get (self, "stats-trace-file", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_transcoder_set_stats_trace_file:
+ * @self: #GstTranscoder instance
+ * @trace_file: (nullable): the file to write the trace to
+ *
+ * See #GstTranscoder:stats-trace-file.
+ */
+void
+gst_transcoder_set_stats_trace_file (GstTranscoder * self,
+    const gchar * trace_file)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  g_object_set (self, "stats-trace-file", trace_file, NULL);
+}
+
 /**
  * gst_transcoder_error_get_name:
  * @error: a #GstTranscoderError
@@ -1494,6 +1888,81 @@ gst_transcoder_message_parse_warning (GstMessage * msg, GError * error,
       GST_TYPE_STRUCTURE, details);
 }
 
+/**
+ * gst_transcoder_message_parse_queue_progress:
+ * @msg: A #GstMessage
+ * @position: (out): the media time transcoded so far by all the jobs
+ * @duration: (out): the summed duration of the jobs started so far
+ * @realtime_factor: (out): the media time transcoded per second of wall
+ * clock time
+ *
+ * Parse the given queue progress @msg. The message also carries the
+ * "n-pending", "n-running", "n-done" and "n-failed" job counts and the
+ * measured "cpu-usage" of the process as fields.
+ */
+void
+gst_transcoder_message_parse_queue_progress (GstMessage * msg,
+    GstClockTime * position, GstClockTime * duration,
+    gdouble * realtime_factor)
+{
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_POSITION,
+      GST_TYPE_CLOCK_TIME, position);
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_DURATION,
+      GST_TYPE_CLOCK_TIME, duration);
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR,
+      G_TYPE_DOUBLE, realtime_factor);
+}
+
+/**
+ * gst_transcoder_message_parse_job_done:
+ * @msg: A #GstMessage
+ * @job_id: (out): the id of the job, as returned by
+ * gst_transcoder_queue_add_job()
+ * @error: (out) (transfer full) (nullable): the error the job failed with,
+ * or %NULL if it succeeded
+ */
+void
+gst_transcoder_message_parse_job_done (GstMessage * msg, guint * job_id,
+    GError ** error)
+{
+  const GstStructure *data;
+
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_JOB_ID, G_TYPE_UINT,
+      job_id);
+
+  if (error) {
+    *error = NULL;
+    data = gst_message_get_structure (msg);
+    if (gst_structure_has_field (data, GST_TRANSCODER_MESSAGE_DATA_ERROR))
+      gst_structure_get (data, GST_TRANSCODER_MESSAGE_DATA_ERROR,
+          G_TYPE_ERROR, error, NULL);
+  }
+}
+
+/**
+ * gst_transcoder_message_parse_stats:
+ * @msg: A #GstMessage
+ * @fps: (out): the frames output by the video encoders per second since the
+ * previous statistics
+ * @realtime_factor: (out): the media time transcoded per second since the
+ * previous statistics
+ * @elements: (out) (transfer full): the statistics of every element, one
+ * field per element name holding a structure with the "buffers" it output,
+ * its "latency-mean" and "latency-max", its "latency-histogram" of
+ * power-of-two microsecond buckets and, for queues, their "queue-fill"
+ */
+void
+gst_transcoder_message_parse_stats (GstMessage * msg, gdouble * fps,
+    gdouble * realtime_factor, GstStructure ** elements)
+{
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_FPS, G_TYPE_DOUBLE,
+      fps);
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR,
+      G_TYPE_DOUBLE, realtime_factor);
+  PARSE_MESSAGE_FIELD (msg, GST_TRANSCODER_MESSAGE_DATA_ELEMENTS,
+      GST_TYPE_STRUCTURE, elements);
+}
+
 /**
  * gst_transcoder_state_get_name:
  * @state: a #GstTranscoderState
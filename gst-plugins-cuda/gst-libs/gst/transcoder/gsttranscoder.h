@@ -60,6 +60,11 @@ const gchar * gst_transcoder_state_get_name                (GstTranscoderState s
  * @GST_TRANSCODER_MESSAGE_DONE: Transcoding is done
  * @GST_TRANSCODER_MESSAGE_ERROR: Message contains an error
  * @GST_TRANSCODER_MESSAGE_WARNING: Message contains an error
+ * @GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS: Aggregate progress of a
+ * #GstTranscoderQueue
+ * @GST_TRANSCODER_MESSAGE_JOB_DONE: A job of a #GstTranscoderQueue is done
+ * @GST_TRANSCODER_MESSAGE_STATS: Processing statistics of the pipeline, see
+ * #GstTranscoder:collect-stats
  *
  * Types of messages that will be posted on the transcoder API bus.
  *
@@ -75,6 +80,9 @@ typedef enum
   GST_TRANSCODER_MESSAGE_DONE,
   GST_TRANSCODER_MESSAGE_ERROR,
   GST_TRANSCODER_MESSAGE_WARNING,
+  GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS,
+  GST_TRANSCODER_MESSAGE_JOB_DONE,
+  GST_TRANSCODER_MESSAGE_STATS,
 } GstTranscoderMessage;
 
 GST_TRANSCODER_API
@@ -98,6 +106,15 @@ void           gst_transcoder_message_parse_error              (GstMessage * msg
 GST_TRANSCODER_API
 void           gst_transcoder_message_parse_warning            (GstMessage * msg, GError * error, GstStructure ** details);
 
+GST_TRANSCODER_API
+void           gst_transcoder_message_parse_queue_progress     (GstMessage * msg, GstClockTime * position, GstClockTime * duration, gdouble * realtime_factor);
+
+GST_TRANSCODER_API
+void           gst_transcoder_message_parse_job_done           (GstMessage * msg, guint * job_id, GError ** error);
+
+GST_TRANSCODER_API
+void           gst_transcoder_message_parse_stats              (GstMessage * msg, gdouble * fps, gdouble * realtime_factor, GstStructure ** elements);
+
 
 
 /*********** GstTranscoder definition  ************/
@@ -163,7 +180,41 @@ GST_TRANSCODER_API
 void gst_transcoder_set_avoid_reencoding                  (GstTranscoder * self,
                                                            gboolean avoid_reencoding);
 
+GST_TRANSCODER_API
+guint gst_transcoder_get_n_segments                       (GstTranscoder * self);
+GST_TRANSCODER_API
+void gst_transcoder_set_n_segments                        (GstTranscoder * self,
+                                                           guint n_segments);
+
+GST_TRANSCODER_API
+void gst_transcoder_get_clip_range                        (GstTranscoder * self,
+                                                           GstClockTime * start,
+                                                           GstClockTime * stop);
+GST_TRANSCODER_API
+void gst_transcoder_set_clip_range                        (GstTranscoder * self,
+                                                           GstClockTime start,
+                                                           GstClockTime stop);
+
+GST_TRANSCODER_API
+gboolean gst_transcoder_get_smart_render                  (GstTranscoder * self);
+GST_TRANSCODER_API
+void gst_transcoder_set_smart_render                      (GstTranscoder * self,
+                                                           gboolean smart_render);
+
+GST_TRANSCODER_API
+gboolean gst_transcoder_get_collect_stats                 (GstTranscoder * self);
+GST_TRANSCODER_API
+void gst_transcoder_set_collect_stats                     (GstTranscoder * self,
+                                                           gboolean collect_stats);
+
+GST_TRANSCODER_API
+gchar * gst_transcoder_get_stats_trace_file               (GstTranscoder * self);
+GST_TRANSCODER_API
+void gst_transcoder_set_stats_trace_file                  (GstTranscoder * self,
+                                                           const gchar * trace_file);
+
 #include "gsttranscoder-signal-adapter.h"
+#include "gsttranscoderqueue.h"
 
 GST_TRANSCODER_API
 GstTranscoderSignalAdapter*
@@ -0,0 +1,926 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gsttranscoderqueue
+ * @short_description: Run many transcoding jobs concurrently
+ *
+ * A #GstTranscoderQueue runs the jobs added to it with one #GstTranscoder
+ * each, at most #GstTranscoderQueue:max-jobs of them at once. Pending jobs
+ * are started by decreasing priority, and only while the measured CPU usage
+ * of the process leaves room for one more job.
+ *
+ * The CUDA contexts created by the jobs are handed to the jobs started
+ * later, so that all the jobs running on a device share one context.
+ *
+ * The progress of the queue as a whole is posted on the message bus
+ * returned by gst_transcoder_queue_get_message_bus(), as
+ * %GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS messages, and the outcome of every
+ * job as a %GST_TRANSCODER_MESSAGE_JOB_DONE message.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsttranscoder.h"
+#include "gsttranscoderqueue.h"
+#include "gsttranscoder-private.h"
+
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (gst_transcoder_queue_debug);
+#define GST_CAT_DEFAULT gst_transcoder_queue_debug
+
+#define DEFAULT_MAX_JOBS 2
+#define DEFAULT_MAX_CPU_USAGE 100
+#define DEFAULT_PROGRESS_UPDATE_INTERVAL_MS 500
+
+/* the context type of GstCudaContext, see gstcudacontext.h */
+#define CUDA_CONTEXT_TYPE "gst.cuda.context"
+
+enum
+{
+  PROP_0,
+  PROP_MAX_JOBS,
+  PROP_MAX_CPU_USAGE,
+  PROP_PROGRESS_UPDATE_INTERVAL,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstTranscoderQueue *queue;
+
+  guint id;
+  gint priority;
+  gchar *source_uri;
+  gchar *dest_uri;
+  GstEncodingProfile *profile;
+
+  GstTranscoder *transcoder;
+  GstTranscoderSignalAdapter *signal_adapter;
+  GstClockTime position;
+  GstClockTime duration;
+  GError *error;
+  gboolean finished;
+} GstTranscoderQueueJob;
+
+struct _GstTranscoderQueue
+{
+  GstObject parent;
+
+  guint max_jobs;
+  gint max_cpu_usage;
+  guint progress_update_interval_ms;
+
+  GThread *thread;
+  GCond cond;
+  GMainContext *context;
+  GMainLoop *loop;
+  GSource *tick_source;
+
+  /* (GstTranscoderQueueJob) sorted by decreasing priority */
+  GQueue pending;
+  /* (GstTranscoderQueueJob) */
+  GList *running;
+  guint next_id;
+  guint n_done;
+  guint n_failed;
+  GError *error;
+
+  /* media time transcoded by the finished jobs */
+  GstClockTime done_position;
+  GstClockTime done_duration;
+  gint64 start_time;
+
+  /* CPU usage of the process over the last tick, in percent of all the
+   * cores, or -1 when it cannot be measured */
+  gint64 last_sample_time;
+  gint64 last_cpu_time;
+  gint cpu_usage;
+  gboolean admitted_since_sample;
+
+  /* (GstContext) the CUDA contexts of the jobs, one per device */
+  GPtrArray *contexts;
+
+  GstBus *api_bus;
+};
+
+struct _GstTranscoderQueueClass
+{
+  GstObjectClass parent_class;
+};
+
+#define _do_init \
+  GST_DEBUG_CATEGORY_INIT (gst_transcoder_queue_debug, "gst-transcoder-queue", \
+      0, "GstTranscoderQueue")
+
+#define parent_class gst_transcoder_queue_parent_class
+G_DEFINE_TYPE_WITH_CODE (GstTranscoderQueue, gst_transcoder_queue,
+    GST_TYPE_OBJECT, _do_init);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gst_transcoder_queue_dispose (GObject * object);
+static void gst_transcoder_queue_finalize (GObject * object);
+static void gst_transcoder_queue_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_transcoder_queue_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_transcoder_queue_constructed (GObject * object);
+
+static gpointer gst_transcoder_queue_main (gpointer data);
+static void gst_transcoder_queue_wakeup (GstTranscoderQueue * self);
+
+static void
+gst_transcoder_queue_init (GstTranscoderQueue * self)
+{
+  g_cond_init (&self->cond);
+  g_queue_init (&self->pending);
+
+  self->context = g_main_context_new ();
+  self->loop = g_main_loop_new (self->context, FALSE);
+  self->api_bus = gst_bus_new ();
+  self->contexts =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_context_unref);
+
+  self->max_jobs = DEFAULT_MAX_JOBS;
+  self->max_cpu_usage = DEFAULT_MAX_CPU_USAGE;
+  self->progress_update_interval_ms = DEFAULT_PROGRESS_UPDATE_INTERVAL_MS;
+  self->next_id = 1;
+  self->cpu_usage = -1;
+  self->last_cpu_time = -1;
+}
+
+static void
+gst_transcoder_queue_class_init (GstTranscoderQueueClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_transcoder_queue_set_property;
+  gobject_class->get_property = gst_transcoder_queue_get_property;
+  gobject_class->dispose = gst_transcoder_queue_dispose;
+  gobject_class->finalize = gst_transcoder_queue_finalize;
+  gobject_class->constructed = gst_transcoder_queue_constructed;
+
+  param_specs[PROP_MAX_JOBS] =
+      g_param_spec_uint ("max-jobs", "Max jobs",
+      "Maximum number of jobs running at once", 1, G_MAXUINT,
+      DEFAULT_MAX_JOBS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstTranscoderQueue:max-cpu-usage:
+   *
+   * The percentage of the CPU, all cores together, the process should stay
+   * under. A pending job is only started while the jobs already running,
+   * plus one more using as much CPU as they do on average, fit in it.
+   */
+  param_specs[PROP_MAX_CPU_USAGE] =
+      g_param_spec_int ("max-cpu-usage", "Max CPU usage",
+      "Percentage of the CPU the running jobs may use before no more job "
+      "is started", 1, 100, DEFAULT_MAX_CPU_USAGE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_PROGRESS_UPDATE_INTERVAL] =
+      g_param_spec_uint ("progress-update-interval",
+      "Progress update interval",
+      "Interval in milliseconds between two queue progress messages", 10,
+      10000, DEFAULT_PROGRESS_UPDATE_INTERVAL_MS,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+static void
+gst_transcoder_queue_job_free (GstTranscoderQueueJob * job)
+{
+  if (job->signal_adapter) {
+    g_signal_handlers_disconnect_by_data (job->signal_adapter, job);
+    g_object_unref (job->signal_adapter);
+  }
+  gst_clear_object (&job->transcoder);
+  g_clear_object (&job->profile);
+  g_clear_error (&job->error);
+  g_free (job->source_uri);
+  g_free (job->dest_uri);
+  g_free (job);
+}
+
+static void
+gst_transcoder_queue_dispose (GObject * object)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (object);
+
+  GST_TRACE_OBJECT (self, "Stopping main thread");
+
+  GST_OBJECT_LOCK (self);
+  if (self->loop) {
+    g_main_loop_quit (self->loop);
+    GST_OBJECT_UNLOCK (self);
+
+    g_thread_join (self->thread);
+
+    GST_OBJECT_LOCK (self);
+    self->thread = NULL;
+
+    g_main_loop_unref (self->loop);
+    self->loop = NULL;
+
+    g_main_context_unref (self->context);
+    self->context = NULL;
+    GST_OBJECT_UNLOCK (self);
+  } else {
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_transcoder_queue_finalize (GObject * object)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (object);
+
+  g_queue_foreach (&self->pending, (GFunc) gst_transcoder_queue_job_free,
+      NULL);
+  g_queue_clear (&self->pending);
+  g_ptr_array_unref (self->contexts);
+  g_clear_error (&self->error);
+  gst_object_unref (self->api_bus);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+main_loop_running_cb (gpointer user_data)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (user_data);
+
+  GST_OBJECT_LOCK (self);
+  g_cond_broadcast (&self->cond);
+  GST_OBJECT_UNLOCK (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gst_transcoder_queue_constructed (GObject * object)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (object);
+
+  GST_OBJECT_LOCK (self);
+  self->thread = g_thread_new ("GstTranscoderQueue",
+      gst_transcoder_queue_main, self);
+  while (!self->loop || !g_main_loop_is_running (self->loop))
+    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+  GST_OBJECT_UNLOCK (self);
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static void
+gst_transcoder_queue_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (object);
+
+  switch (prop_id) {
+    case PROP_MAX_JOBS:
+      GST_OBJECT_LOCK (self);
+      self->max_jobs = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      if (self->loop)
+        gst_transcoder_queue_wakeup (self);
+      break;
+    case PROP_MAX_CPU_USAGE:
+      GST_OBJECT_LOCK (self);
+      self->max_cpu_usage = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PROGRESS_UPDATE_INTERVAL:
+      self->progress_update_interval_ms = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_transcoder_queue_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (object);
+
+  switch (prop_id) {
+    case PROP_MAX_JOBS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_jobs);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_CPU_USAGE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->max_cpu_usage);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PROGRESS_UPDATE_INTERVAL:
+      g_value_set_uint (value, self->progress_update_interval_ms);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/*
+ * Works same as gst_structure_set to set field/type/value triplets on message data
+ */
+static void
+api_bus_post_message (GstTranscoderQueue * self,
+    GstTranscoderMessage message_type, const gchar * firstfield, ...)
+{
+  GstStructure *message_data;
+  va_list varargs;
+
+  message_data = gst_structure_new (GST_TRANSCODER_MESSAGE_DATA,
+      GST_TRANSCODER_MESSAGE_DATA_TYPE, GST_TYPE_TRANSCODER_MESSAGE,
+      message_type, NULL);
+
+  va_start (varargs, firstfield);
+  gst_structure_set_valist (message_data, firstfield, varargs);
+  va_end (varargs);
+
+  gst_bus_post (self->api_bus,
+      gst_message_new_custom (GST_MESSAGE_APPLICATION, GST_OBJECT (self),
+          message_data));
+}
+
+/* the CPU time used by the process, in microseconds */
+static gint64
+get_process_cpu_time (void)
+{
+#ifdef G_OS_UNIX
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0) {
+    return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+        G_USEC_PER_SEC + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+  }
+#endif
+
+  return -1;
+}
+
+static void
+sample_cpu_usage (GstTranscoderQueue * self)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 cpu_time = get_process_cpu_time ();
+
+  if (cpu_time >= 0 && self->last_cpu_time >= 0 &&
+      now > self->last_sample_time) {
+    self->cpu_usage = (gint) (100 * (cpu_time - self->last_cpu_time) /
+        ((now - self->last_sample_time) * g_get_num_processors ()));
+  }
+
+  self->last_sample_time = now;
+  self->last_cpu_time = cpu_time;
+  self->admitted_since_sample = FALSE;
+}
+
+/* called with the object lock */
+static gboolean
+can_start_job (GstTranscoderQueue * self)
+{
+  guint n_running = g_list_length (self->running);
+
+  if (g_queue_is_empty (&self->pending) || n_running >= self->max_jobs)
+    return FALSE;
+
+  if (n_running == 0 || self->cpu_usage < 0)
+    return TRUE;
+
+  /* the usage of the last job started is not known yet */
+  if (self->admitted_since_sample)
+    return FALSE;
+
+  return self->cpu_usage * (n_running + 1) / n_running <= self->max_cpu_usage;
+}
+
+static GstBusSyncReply
+job_bus_sync_handler (G_GNUC_UNUSED GstBus * bus, GstMessage * msg,
+    gpointer user_data)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (user_data);
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_HAVE_CONTEXT:{
+      GstContext *context;
+      const GstStructure *s;
+      gint device_id = -1;
+      guint i;
+
+      gst_message_parse_have_context (msg, &context);
+      if (g_strcmp0 (gst_context_get_context_type (context),
+              CUDA_CONTEXT_TYPE) != 0) {
+        gst_context_unref (context);
+        break;
+      }
+
+      s = gst_context_get_structure (context);
+      gst_structure_get_int (s, "cuda-device-id", &device_id);
+
+      GST_OBJECT_LOCK (self);
+      for (i = 0; i < self->contexts->len; i++) {
+        gint other_device_id = -1;
+
+        s = gst_context_get_structure (g_ptr_array_index (self->contexts, i));
+        gst_structure_get_int (s, "cuda-device-id", &other_device_id);
+        if (other_device_id == device_id)
+          break;
+      }
+
+      if (i == self->contexts->len) {
+        GST_DEBUG_OBJECT (self, "Sharing CUDA context of device %d",
+            device_id);
+        g_ptr_array_add (self->contexts, context);
+      } else {
+        gst_context_unref (context);
+      }
+      GST_OBJECT_UNLOCK (self);
+      break;
+    }
+    case GST_MESSAGE_NEED_CONTEXT:{
+      const gchar *context_type;
+      GstElement *element = GST_ELEMENT (GST_MESSAGE_SRC (msg));
+      GPtrArray *contexts;
+      guint i;
+
+      if (!gst_message_parse_context_type (msg, &context_type) ||
+          g_strcmp0 (context_type, CUDA_CONTEXT_TYPE) != 0)
+        break;
+
+      GST_OBJECT_LOCK (self);
+      contexts = g_ptr_array_new_full (self->contexts->len,
+          (GDestroyNotify) gst_context_unref);
+      for (i = 0; i < self->contexts->len; i++) {
+        g_ptr_array_add (contexts,
+            gst_context_ref (g_ptr_array_index (self->contexts, i)));
+      }
+      GST_OBJECT_UNLOCK (self);
+
+      /* the element only picks the context of the device it runs on */
+      for (i = 0; i < contexts->len; i++)
+        gst_element_set_context (element, g_ptr_array_index (contexts, i));
+
+      g_ptr_array_unref (contexts);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return GST_BUS_PASS;
+}
+
+static void
+finish_job (GstTranscoderQueueJob * job, const GError * error)
+{
+  GstTranscoderQueue *self = job->queue;
+
+  if (job->finished)
+    return;
+
+  job->finished = TRUE;
+  if (error)
+    job->error = g_error_copy (error);
+
+  /* the signal adapter is still emitting, free the job from an idle
+   * callback */
+  gst_transcoder_queue_wakeup (self);
+}
+
+static void
+job_position_updated_cb (GstTranscoderQueueJob * job, GstClockTime position)
+{
+  job->position = position;
+}
+
+static void
+job_duration_changed_cb (GstTranscoderQueueJob * job, GstClockTime duration)
+{
+  job->duration = duration;
+}
+
+static void
+job_done_cb (GstTranscoderQueueJob * job)
+{
+  finish_job (job, NULL);
+}
+
+static void
+job_error_cb (GstTranscoderQueueJob * job, GError * error,
+    G_GNUC_UNUSED GstStructure * details)
+{
+  finish_job (job, error);
+}
+
+static void
+start_job (GstTranscoderQueue * self, GstTranscoderQueueJob * job)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+
+  GST_INFO_OBJECT (self, "Starting job %u: %s -> %s (priority %d)", job->id,
+      job->source_uri, job->dest_uri, job->priority);
+
+  job->transcoder = gst_transcoder_new_full (job->source_uri, job->dest_uri,
+      job->profile);
+  gst_transcoder_set_position_update_interval (job->transcoder,
+      self->progress_update_interval_ms);
+
+  pipeline = gst_transcoder_get_pipeline (job->transcoder);
+  bus = gst_element_get_bus (pipeline);
+  gst_bus_set_sync_handler (bus, job_bus_sync_handler, self, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  job->signal_adapter = gst_transcoder_get_signal_adapter (job->transcoder,
+      self->context);
+  g_signal_connect_swapped (job->signal_adapter, "position-updated",
+      G_CALLBACK (job_position_updated_cb), job);
+  g_signal_connect_swapped (job->signal_adapter, "duration-changed",
+      G_CALLBACK (job_duration_changed_cb), job);
+  g_signal_connect_swapped (job->signal_adapter, "done",
+      G_CALLBACK (job_done_cb), job);
+  g_signal_connect_swapped (job->signal_adapter, "error",
+      G_CALLBACK (job_error_cb), job);
+
+  gst_transcoder_run_async (job->transcoder);
+}
+
+static void
+post_progress (GstTranscoderQueue * self)
+{
+  GstClockTime position, duration;
+  gdouble realtime_factor = 0.0;
+  guint n_pending, n_running, n_done, n_failed;
+  gint cpu_usage;
+  GList *l;
+
+  GST_OBJECT_LOCK (self);
+  position = self->done_position;
+  duration = self->done_duration;
+  for (l = self->running; l; l = l->next) {
+    GstTranscoderQueueJob *job = l->data;
+
+    if (GST_CLOCK_TIME_IS_VALID (job->position))
+      position += job->position;
+    if (GST_CLOCK_TIME_IS_VALID (job->duration))
+      duration += job->duration;
+  }
+
+  if (self->start_time > 0) {
+    gint64 elapsed = g_get_monotonic_time () - self->start_time;
+
+    if (elapsed > 0)
+      realtime_factor = (gdouble) (position / GST_USECOND) / elapsed;
+  }
+
+  n_pending = self->pending.length;
+  n_running = g_list_length (self->running);
+  n_done = self->n_done;
+  n_failed = self->n_failed;
+  cpu_usage = self->cpu_usage;
+  GST_OBJECT_UNLOCK (self);
+
+  api_bus_post_message (self, GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS,
+      GST_TRANSCODER_MESSAGE_DATA_POSITION, GST_TYPE_CLOCK_TIME, position,
+      GST_TRANSCODER_MESSAGE_DATA_DURATION, GST_TYPE_CLOCK_TIME, duration,
+      GST_TRANSCODER_MESSAGE_DATA_REALTIME_FACTOR, G_TYPE_DOUBLE,
+      realtime_factor,
+      GST_TRANSCODER_MESSAGE_DATA_CPU_USAGE, G_TYPE_INT, cpu_usage,
+      GST_TRANSCODER_MESSAGE_DATA_N_PENDING, G_TYPE_UINT, n_pending,
+      GST_TRANSCODER_MESSAGE_DATA_N_RUNNING, G_TYPE_UINT, n_running,
+      GST_TRANSCODER_MESSAGE_DATA_N_DONE, G_TYPE_UINT, n_done,
+      GST_TRANSCODER_MESSAGE_DATA_N_FAILED, G_TYPE_UINT, n_failed, NULL);
+}
+
+/* frees the finished jobs and starts pending ones, runs on the queue
+ * thread */
+static void
+dispatch (GstTranscoderQueue * self)
+{
+  GList *finished = NULL;
+  GList *l, *next;
+  gboolean idle;
+
+  GST_OBJECT_LOCK (self);
+  for (l = self->running; l; l = next) {
+    GstTranscoderQueueJob *job = l->data;
+
+    next = l->next;
+    if (!job->finished)
+      continue;
+
+    self->running = g_list_delete_link (self->running, l);
+    finished = g_list_prepend (finished, job);
+
+    if (GST_CLOCK_TIME_IS_VALID (job->duration)) {
+      self->done_duration += job->duration;
+      self->done_position += job->error ? job->position : job->duration;
+    }
+
+    if (job->error) {
+      self->n_failed++;
+      if (!self->error)
+        self->error = g_error_copy (job->error);
+    } else {
+      self->n_done++;
+    }
+  }
+
+  while (can_start_job (self)) {
+    GstTranscoderQueueJob *job = g_queue_pop_head (&self->pending);
+
+    self->running = g_list_append (self->running, job);
+    self->admitted_since_sample = TRUE;
+    if (self->start_time == 0)
+      self->start_time = g_get_monotonic_time ();
+
+    GST_OBJECT_UNLOCK (self);
+    start_job (self, job);
+    GST_OBJECT_LOCK (self);
+  }
+
+  idle = !self->running && g_queue_is_empty (&self->pending);
+  if (finished && idle)
+    g_cond_broadcast (&self->cond);
+  GST_OBJECT_UNLOCK (self);
+
+  for (l = finished; l; l = l->next) {
+    GstTranscoderQueueJob *job = l->data;
+
+    GST_INFO_OBJECT (self, "Job %u done%s%s", job->id,
+        job->error ? ": " : "", job->error ? job->error->message : "");
+
+    if (job->error) {
+      api_bus_post_message (self, GST_TRANSCODER_MESSAGE_JOB_DONE,
+          GST_TRANSCODER_MESSAGE_DATA_JOB_ID, G_TYPE_UINT, job->id,
+          GST_TRANSCODER_MESSAGE_DATA_ERROR, G_TYPE_ERROR, job->error, NULL);
+    } else {
+      api_bus_post_message (self, GST_TRANSCODER_MESSAGE_JOB_DONE,
+          GST_TRANSCODER_MESSAGE_DATA_JOB_ID, G_TYPE_UINT, job->id, NULL);
+    }
+
+    gst_transcoder_queue_job_free (job);
+  }
+  g_list_free (finished);
+
+  if (finished && idle)
+    post_progress (self);
+}
+
+static gboolean
+dispatch_cb (gpointer user_data)
+{
+  dispatch (GST_TRANSCODER_QUEUE (user_data));
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+tick_cb (gpointer user_data)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (user_data);
+  gboolean busy;
+
+  GST_OBJECT_LOCK (self);
+  sample_cpu_usage (self);
+  busy = self->running != NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  dispatch (self);
+
+  if (busy)
+    post_progress (self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gst_transcoder_queue_wakeup (GstTranscoderQueue * self)
+{
+  GSource *source;
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, dispatch_cb, gst_object_ref (self),
+      gst_object_unref);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+}
+
+static gpointer
+gst_transcoder_queue_main (gpointer data)
+{
+  GstTranscoderQueue *self = GST_TRANSCODER_QUEUE (data);
+  GSource *source;
+  GList *running;
+
+  GST_TRACE_OBJECT (self, "Starting main thread");
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, main_loop_running_cb, self, NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  self->tick_source =
+      g_timeout_source_new (self->progress_update_interval_ms);
+  g_source_set_callback (self->tick_source, tick_cb, self, NULL);
+  g_source_attach (self->tick_source, self->context);
+
+  sample_cpu_usage (self);
+
+  g_main_loop_run (self->loop);
+
+  g_source_destroy (self->tick_source);
+  g_source_unref (self->tick_source);
+  self->tick_source = NULL;
+
+  /* stops the jobs still running */
+  GST_OBJECT_LOCK (self);
+  running = self->running;
+  self->running = NULL;
+  g_cond_broadcast (&self->cond);
+  GST_OBJECT_UNLOCK (self);
+
+  g_list_free_full (running, (GDestroyNotify) gst_transcoder_queue_job_free);
+
+  g_main_context_pop_thread_default (self->context);
+
+  GST_TRACE_OBJECT (self, "Stopped main thread");
+
+  return NULL;
+}
+
+static gint
+compare_job_priority (gconstpointer a, gconstpointer b,
+    G_GNUC_UNUSED gpointer user_data)
+{
+  const GstTranscoderQueueJob *job_a = a;
+  const GstTranscoderQueueJob *job_b = b;
+
+  /* jobs of the same priority run in the order they were added */
+  if (job_a->priority != job_b->priority)
+    return job_b->priority > job_a->priority ? 1 : -1;
+
+  return job_a->id < job_b->id ? -1 : 1;
+}
+
+/**
+ * gst_transcoder_queue_new:
+ * @max_jobs: the maximum number of jobs running at once
+ *
+ * Returns: a new #GstTranscoderQueue instance
+ */
+GstTranscoderQueue *
+gst_transcoder_queue_new (guint max_jobs)
+{
+  g_return_val_if_fail (max_jobs > 0, NULL);
+
+  return g_object_new (GST_TYPE_TRANSCODER_QUEUE, "max-jobs", max_jobs, NULL);
+}
+
+/**
+ * gst_transcoder_queue_add_job:
+ * @self: #GstTranscoderQueue instance
+ * @source_uri: The URI of the media stream to transcode
+ * @dest_uri: The URI of the destination of the transcoded stream
+ * @profile: The #GstEncodingProfile defining the output format
+ * @priority: jobs of higher priority are started first
+ *
+ * Adds a job to @self, which is started as soon as a running job leaves
+ * room for it.
+ *
+ * Returns: the id of the job, as found in the
+ * %GST_TRANSCODER_MESSAGE_JOB_DONE message posted once it is done
+ */
+guint
+gst_transcoder_queue_add_job (GstTranscoderQueue * self,
+    const gchar * source_uri, const gchar * dest_uri,
+    GstEncodingProfile * profile, gint priority)
+{
+  GstTranscoderQueueJob *job;
+  guint id;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER_QUEUE (self), 0);
+  g_return_val_if_fail (source_uri, 0);
+  g_return_val_if_fail (dest_uri, 0);
+
+  job = g_new0 (GstTranscoderQueueJob, 1);
+  job->queue = self;
+  job->priority = priority;
+  job->source_uri = g_strdup (source_uri);
+  job->dest_uri = g_strdup (dest_uri);
+  job->profile = profile ? g_object_ref (profile) : NULL;
+  job->position = GST_CLOCK_TIME_NONE;
+  job->duration = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_LOCK (self);
+  id = job->id = self->next_id++;
+  g_queue_insert_sorted (&self->pending, job, compare_job_priority, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Added job %u: %s -> %s", id, source_uri, dest_uri);
+
+  gst_transcoder_queue_wakeup (self);
+
+  return id;
+}
+
+/**
+ * gst_transcoder_queue_set_max_cpu_usage:
+ * @self: #GstTranscoderQueue instance
+ * @cpu_usage: The percentage of the CPU the process running the jobs should
+ * stay under. It takes into account the number of cores available.
+ *
+ * See #GstTranscoderQueue:max-cpu-usage.
+ */
+void
+gst_transcoder_queue_set_max_cpu_usage (GstTranscoderQueue * self,
+    gint cpu_usage)
+{
+  g_return_if_fail (GST_IS_TRANSCODER_QUEUE (self));
+
+  g_object_set (self, "max-cpu-usage", cpu_usage, NULL);
+}
+
+/**
+ * gst_transcoder_queue_get_message_bus:
+ * @self: #GstTranscoderQueue instance
+ *
+ * The bus the queue posts its %GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS and
+ * %GST_TRANSCODER_MESSAGE_JOB_DONE messages on, see
+ * gst_transcoder_get_message_bus().
+ *
+ * Returns: (transfer full): The queue message bus instance
+ */
+GstBus *
+gst_transcoder_queue_get_message_bus (GstTranscoderQueue * self)
+{
+  g_return_val_if_fail (GST_IS_TRANSCODER_QUEUE (self), NULL);
+
+  return gst_object_ref (self->api_bus);
+}
+
+/**
+ * gst_transcoder_queue_wait:
+ * @self: #GstTranscoderQueue instance
+ * @error: (allow-none): An error to be set if a job failed
+ *
+ * Waits until all the jobs added to @self are done.
+ *
+ * Returns: %TRUE if all the jobs succeeded, otherwise %FALSE and @error
+ * is set to the error of the first job which failed.
+ */
+gboolean
+gst_transcoder_queue_wait (GstTranscoderQueue * self, GError ** error)
+{
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER_QUEUE (self), FALSE);
+
+  GST_OBJECT_LOCK (self);
+  while (self->running || !g_queue_is_empty (&self->pending))
+    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+
+  if (self->error) {
+    if (error)
+      *error = g_error_copy (self->error);
+    ret = FALSE;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+#include <gst/transcoder/gsttranscoder.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstTranscoderQueue:
+ *
+ * Runs many transcoding jobs, a bounded number of them at once.
+ */
+
+/**
+ * GST_TYPE_TRANSCODER_QUEUE:
+ */
+#define GST_TYPE_TRANSCODER_QUEUE (gst_transcoder_queue_get_type ())
+GST_TRANSCODER_API
+
+/**
+ * GstTranscoderQueueClass:
+ */
+G_DECLARE_FINAL_TYPE (GstTranscoderQueue, gst_transcoder_queue, GST, TRANSCODER_QUEUE, GstObject)
+
+GST_TRANSCODER_API
+GstTranscoderQueue * gst_transcoder_queue_new             (guint max_jobs);
+
+GST_TRANSCODER_API
+guint gst_transcoder_queue_add_job                        (GstTranscoderQueue * self,
+                                                           const gchar * source_uri,
+                                                           const gchar * dest_uri,
+                                                           GstEncodingProfile * profile,
+                                                           gint priority);
+
+GST_TRANSCODER_API
+void gst_transcoder_queue_set_max_cpu_usage               (GstTranscoderQueue * self,
+                                                           gint cpu_usage);
+
+GST_TRANSCODER_API
+GstBus * gst_transcoder_queue_get_message_bus             (GstTranscoderQueue * self);
+
+GST_TRANSCODER_API
+gboolean gst_transcoder_queue_wait                        (GstTranscoderQueue * self,
+                                                           GError ** error);
+
+G_END_DECLS
@@ -0,0 +1,365 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-av1harnessdec
+ * @title: av1harnessdec
+ *
+ * Drives #GstAV1Decoder without decoding hardware, see #GstCodecHarness.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=stream.ivf ! ivfparse ! av1parse ! av1harnessdec backend=dpb-validator ! fakesink
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstav1harnessdec.h"
+
+#include <gst/codecs/gstav1decoder.h>
+
+#include "gstcodecharness.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_av1_harness_dec_debug);
+#define GST_CAT_DEFAULT gst_av1_harness_dec_debug
+
+struct _GstAV1HarnessDec
+{
+  GstAV1Decoder parent;
+
+  GstCodecHarness harness;
+};
+
+struct _GstAV1HarnessDecClass
+{
+  GstAV1DecoderClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1, stream-format = (string) obu-stream, "
+        "alignment = (string) frame"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS (GST_CODEC_HARNESS_SRC_CAPS));
+
+#define gst_av1_harness_dec_parent_class parent_class
+G_DEFINE_TYPE (GstAV1HarnessDec, gst_av1_harness_dec, GST_TYPE_AV1_DECODER);
+
+static void gst_av1_harness_dec_finalize (GObject * object);
+static void gst_av1_harness_dec_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_av1_harness_dec_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_av1_harness_dec_open (GstVideoDecoder * decoder);
+static gboolean gst_av1_harness_dec_close (GstVideoDecoder * decoder);
+static gboolean gst_av1_harness_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_av1_harness_dec_finish (GstVideoDecoder * decoder);
+
+/* GstAV1Decoder */
+static GstFlowReturn gst_av1_harness_dec_new_sequence (GstAV1Decoder *
+    decoder, const GstAV1SequenceHeaderOBU * seq_hdr);
+static GstFlowReturn gst_av1_harness_dec_new_picture (GstAV1Decoder *
+    decoder, GstVideoCodecFrame * frame, GstAV1Picture * picture);
+static GstAV1Picture *gst_av1_harness_dec_duplicate_picture (GstAV1Decoder *
+    decoder, GstAV1Picture * picture);
+static GstFlowReturn gst_av1_harness_dec_start_picture (GstAV1Decoder *
+    decoder, GstAV1Picture * picture, GstAV1Dpb * dpb);
+static GstFlowReturn gst_av1_harness_dec_decode_frame_tiles (GstAV1Decoder *
+    decoder, GstAV1Picture * picture, const GstAV1TileEntry * tiles,
+    guint num_tiles);
+static GstFlowReturn gst_av1_harness_dec_end_picture (GstAV1Decoder *
+    decoder, GstAV1Picture * picture);
+static GstFlowReturn gst_av1_harness_dec_output_picture (GstAV1Decoder *
+    decoder, GstVideoCodecFrame * frame, GstAV1Picture * picture);
+
+static void
+gst_av1_harness_dec_class_init (GstAV1HarnessDecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstAV1DecoderClass *av1decoder_class = GST_AV1_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_av1_harness_dec_finalize;
+  object_class->set_property = gst_av1_harness_dec_set_property;
+  object_class->get_property = gst_av1_harness_dec_get_property;
+
+  gst_codec_harness_install_properties (object_class);
+
+  gst_element_class_set_static_metadata (element_class,
+      "AV1 Stateless Decoder Harness", "Codec/Decoder/Video",
+      "Drives the AV1 decoder base class without decoding hardware",
+      "icetana");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_av1_harness_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_av1_harness_dec_close);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_av1_harness_dec_flush);
+  decoder_class->finish = GST_DEBUG_FUNCPTR (gst_av1_harness_dec_finish);
+
+  av1decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_new_sequence);
+  av1decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_new_picture);
+  av1decoder_class->duplicate_picture =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_duplicate_picture);
+  av1decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_start_picture);
+  av1decoder_class->decode_frame_tiles =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_decode_frame_tiles);
+  av1decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_end_picture);
+  av1decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_av1_harness_dec_output_picture);
+
+  GST_DEBUG_CATEGORY_INIT (gst_av1_harness_dec_debug,
+      "av1harnessdec", 0, "AV1 Stateless Decoder Harness");
+}
+
+static void
+gst_av1_harness_dec_init (GstAV1HarnessDec * self)
+{
+  gst_codec_harness_init (&self->harness, GST_ELEMENT (self));
+}
+
+static void
+gst_av1_harness_dec_finalize (GObject * object)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (object);
+
+  gst_codec_harness_clear (&self->harness);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_av1_harness_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_set_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_av1_harness_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_get_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_av1_harness_dec_open (GstVideoDecoder * decoder)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_open (&self->harness);
+}
+
+static gboolean
+gst_av1_harness_dec_close (GstVideoDecoder * decoder)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+
+  gst_codec_harness_close (&self->harness);
+
+  return TRUE;
+}
+
+static gboolean
+gst_av1_harness_dec_flush (GstVideoDecoder * decoder)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  gboolean ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+  gst_codec_harness_flush (&self->harness);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_finish (GstVideoDecoder * decoder)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  GstFlowReturn ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->finish (decoder);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_codec_harness_finish (&self->harness);
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_new_sequence (GstAV1Decoder * decoder,
+    const GstAV1SequenceHeaderOBU * seq_hdr)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_new_sequence (&self->harness, decoder->input_state,
+      seq_hdr->max_frame_width_minus_1 + 1,
+      seq_hdr->max_frame_height_minus_1 + 1, seq_hdr->bit_depth,
+      GST_AV1_NUM_REF_FRAMES);
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_new_picture (GstAV1Decoder * decoder,
+    GstVideoCodecFrame * frame, GstAV1Picture * picture)
+{
+  GstCodecHarnessPicture *hpic;
+
+  hpic = gst_codec_harness_picture_new (frame->system_frame_number);
+  /* showable frames are only shown later through show_existing_frame */
+  hpic->needed_for_output = picture->show_frame;
+
+  gst_av1_picture_set_user_data (picture, hpic, (GDestroyNotify) g_free);
+
+  return GST_FLOW_OK;
+}
+
+static GstAV1Picture *
+gst_av1_harness_dec_duplicate_picture (GstAV1Decoder * decoder,
+    GstAV1Picture * picture)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+  GstAV1Picture *new_picture;
+
+  hpic = (GstCodecHarnessPicture *) gst_av1_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "Parent picture does not have harness picture");
+    return NULL;
+  }
+
+  new_picture = gst_av1_picture_new ();
+
+  gst_av1_picture_set_user_data (new_picture,
+      gst_codec_harness_picture_duplicate (hpic), (GDestroyNotify) g_free);
+
+  return new_picture;
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_start_picture (GstAV1Decoder * decoder,
+    GstAV1Picture * picture, GstAV1Dpb * dpb)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+
+  hpic = (GstCodecHarnessPicture *) gst_av1_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* one frame is output per temporal unit, in decoding order */
+  return gst_codec_harness_start_picture (&self->harness, hpic,
+      hpic->system_frame_number, FALSE);
+}
+
+/* Every tile of the frame counts as one slice. The tile index is checked
+ * against the tile info of the frame header, as the base class collects it
+ * across all the tile groups of the frame */
+static GstFlowReturn
+gst_av1_harness_dec_decode_frame_tiles (GstAV1Decoder * decoder,
+    GstAV1Picture * picture, const GstAV1TileEntry * tiles, guint num_tiles)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  const GstAV1TileInfo *tile_info = &picture->frame_hdr.tile_info;
+  GstCodecHarnessPicture *hpic;
+  GstFlowReturn ret;
+  guint i;
+
+  hpic = (GstCodecHarnessPicture *) gst_av1_picture_get_user_data (picture);
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  if (num_tiles != tile_info->tile_cols * tile_info->tile_rows) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, ("Invalid tile index"),
+        ("%u tiles for a %ux%u tile grid", num_tiles, tile_info->tile_cols,
+            tile_info->tile_rows));
+    return GST_FLOW_ERROR;
+  }
+
+  for (i = 0; i < num_tiles; i++) {
+    if (!tiles[i].data || tiles[i].tile_row != i / tile_info->tile_cols ||
+        tiles[i].tile_col != i % tile_info->tile_cols) {
+      GST_ELEMENT_ERROR (self, STREAM, DECODE, ("Invalid tile index"),
+          ("Tile %u is at row %u, column %u", i, tiles[i].tile_row,
+              tiles[i].tile_col));
+      return GST_FLOW_ERROR;
+    }
+
+    ret = gst_codec_harness_decode_slice (&self->harness, hpic, tiles[i].size);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_end_picture (GstAV1Decoder * decoder,
+    GstAV1Picture * picture)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+
+  hpic = (GstCodecHarnessPicture *) gst_av1_picture_get_user_data (picture);
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_end_picture (&self->harness, hpic);
+}
+
+static GstFlowReturn
+gst_av1_harness_dec_output_picture (GstAV1Decoder * decoder,
+    GstVideoCodecFrame * frame, GstAV1Picture * picture)
+{
+  GstAV1HarnessDec *self = GST_AV1_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+  GstFlowReturn ret;
+
+  hpic = (GstCodecHarnessPicture *) gst_av1_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (decoder), frame);
+    gst_av1_picture_unref (picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* a shown existing frame is output in the order of the temporal unit
+   * showing it */
+  hpic->order = frame->system_frame_number;
+
+  ret = gst_codec_harness_output_picture (&self->harness, frame, hpic);
+  gst_av1_picture_unref (picture);
+
+  return ret;
+}
@@ -0,0 +1,677 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The stateless decoder harness drives the parsing and DPB management of the
+ * gst-libs/gst/codecs base classes without any decoding hardware. Each
+ * harness element is a thin subclass of one base class which translates its
+ * pictures into a #GstCodecHarnessPicture and forwards them to a backend:
+ *
+ * - the null backend only counts what it sees, to benchmark the parsing
+ *   throughput of the CPU half of the decode path
+ * - the DPB validator backend additionally checks that the base class outputs
+ *   every picture exactly once, in output order, and never holds more
+ *   pictures than the stream allows
+ *
+ * Output buffers are allocated but never written, the harness elements are
+ * meant to be linked to a fakesink.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcodecharness.h"
+
+#include "gstav1harnessdec.h"
+#include "gsth264harnessdec.h"
+#include "gsth265harnessdec.h"
+#include "gstmpeg2harnessdec.h"
+#include "gstvp9harnessdec.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_codec_harness_debug);
+#define GST_CAT_DEFAULT gst_codec_harness_debug
+
+#define DEFAULT_BACKEND GST_CODEC_HARNESS_BACKEND_NULL
+
+GType
+gst_codec_harness_backend_type_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_CODEC_HARNESS_BACKEND_NULL, "Count pictures, slices and bytes only",
+        "null"},
+    {GST_CODEC_HARNESS_BACKEND_DPB_VALIDATOR,
+        "Validate the output order and the DPB fullness", "dpb-validator"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstCodecHarnessBackendType", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+/* null backend */
+
+typedef struct
+{
+  GstElement *element;
+
+  guint64 sequences;
+  guint64 pictures;
+  guint64 slices;
+  guint64 bytes;
+  guint64 outputs;
+} GstCodecHarnessCounter;
+
+static gpointer
+gst_codec_harness_counter_open (GstElement * element)
+{
+  GstCodecHarnessCounter *self = g_new0 (GstCodecHarnessCounter, 1);
+
+  self->element = element;
+
+  return self;
+}
+
+static void
+gst_codec_harness_counter_close (gpointer backend)
+{
+  g_free (backend);
+}
+
+static gboolean
+gst_codec_harness_counter_new_sequence (gpointer backend,
+    const GstVideoInfo * info, guint max_dpb_size)
+{
+  GstCodecHarnessCounter *self = backend;
+
+  self->sequences++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_counter_start_picture (gpointer backend,
+    GstCodecHarnessPicture * picture)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_counter_decode_slice (gpointer backend,
+    GstCodecHarnessPicture * picture, gsize size)
+{
+  GstCodecHarnessCounter *self = backend;
+
+  self->slices++;
+  self->bytes += size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_counter_end_picture (gpointer backend,
+    GstCodecHarnessPicture * picture)
+{
+  GstCodecHarnessCounter *self = backend;
+
+  /* the second field of a frame ends the same picture again */
+  if (!picture->decoded)
+    self->pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_counter_output_picture (gpointer backend,
+    GstCodecHarnessPicture * picture)
+{
+  GstCodecHarnessCounter *self = backend;
+
+  self->outputs++;
+
+  return TRUE;
+}
+
+static void
+gst_codec_harness_counter_flush (gpointer backend)
+{
+}
+
+static gboolean
+gst_codec_harness_counter_finish (gpointer backend)
+{
+  return TRUE;
+}
+
+static GstStructure *
+gst_codec_harness_counter_get_stats (gpointer backend)
+{
+  GstCodecHarnessCounter *self = backend;
+
+  return gst_structure_new ("codec-harness-stats",
+      "sequences", G_TYPE_UINT64, self->sequences,
+      "pictures", G_TYPE_UINT64, self->pictures,
+      "slices", G_TYPE_UINT64, self->slices,
+      "bytes", G_TYPE_UINT64, self->bytes,
+      "outputs", G_TYPE_UINT64, self->outputs, NULL);
+}
+
+static const GstCodecHarnessBackend null_backend = {
+  "null",
+  gst_codec_harness_counter_open,
+  gst_codec_harness_counter_close,
+  gst_codec_harness_counter_new_sequence,
+  gst_codec_harness_counter_start_picture,
+  gst_codec_harness_counter_decode_slice,
+  gst_codec_harness_counter_end_picture,
+  gst_codec_harness_counter_output_picture,
+  gst_codec_harness_counter_flush,
+  gst_codec_harness_counter_finish,
+  gst_codec_harness_counter_get_stats,
+};
+
+/* DPB validator backend */
+
+typedef struct
+{
+  GstCodecHarnessCounter counter;
+
+  guint max_dpb_size;
+  /* system frame numbers of the decoded pictures waiting for output */
+  GHashTable *pending;
+  guint num_pending;
+  guint max_pending;
+
+  gboolean have_last;
+  guint64 last_epoch;
+  gint64 last_order;
+} GstCodecHarnessValidator;
+
+static gpointer
+gst_codec_harness_validator_open (GstElement * element)
+{
+  GstCodecHarnessValidator *self = g_new0 (GstCodecHarnessValidator, 1);
+
+  self->counter.element = element;
+  self->pending = g_hash_table_new (NULL, NULL);
+
+  return self;
+}
+
+static void
+gst_codec_harness_validator_close (gpointer backend)
+{
+  GstCodecHarnessValidator *self = backend;
+
+  g_hash_table_unref (self->pending);
+  g_free (self);
+}
+
+static gboolean
+gst_codec_harness_validator_new_sequence (gpointer backend,
+    const GstVideoInfo * info, guint max_dpb_size)
+{
+  GstCodecHarnessValidator *self = backend;
+
+  gst_codec_harness_counter_new_sequence (&self->counter, info, max_dpb_size);
+  self->max_dpb_size = max_dpb_size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_validator_end_picture (gpointer backend,
+    GstCodecHarnessPicture * picture)
+{
+  GstCodecHarnessValidator *self = backend;
+  gpointer key = GUINT_TO_POINTER (picture->system_frame_number);
+
+  gst_codec_harness_counter_end_picture (&self->counter, picture);
+
+  if (picture->decoded || picture->duplicate || !picture->needed_for_output)
+    return TRUE;
+
+  if (!g_hash_table_add (self->pending, key)) {
+    GST_ELEMENT_ERROR (self->counter.element, STREAM, DECODE,
+        ("Picture decoded twice"), ("Frame %u was decoded again before "
+            "being output", picture->system_frame_number));
+    return FALSE;
+  }
+
+  self->num_pending = g_hash_table_size (self->pending);
+  self->max_pending = MAX (self->max_pending, self->num_pending);
+
+  /* the DPB plus the picture just decoded */
+  if (self->max_dpb_size > 0 && self->num_pending > self->max_dpb_size + 1) {
+    GST_ELEMENT_ERROR (self->counter.element, STREAM, DECODE,
+        ("DPB overflow"), ("%u pictures waiting for output, the DPB size is "
+            "%u", self->num_pending, self->max_dpb_size));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_codec_harness_validator_output_picture (gpointer backend,
+    GstCodecHarnessPicture * picture)
+{
+  GstCodecHarnessValidator *self = backend;
+  gpointer key = GUINT_TO_POINTER (picture->system_frame_number);
+
+  gst_codec_harness_counter_output_picture (&self->counter, picture);
+
+  if (!picture->duplicate) {
+    if (!g_hash_table_remove (self->pending, key)) {
+      GST_ELEMENT_ERROR (self->counter.element, STREAM, DECODE,
+          ("Picture output twice"), ("Frame %u was output without a pending "
+              "decoded picture", picture->system_frame_number));
+      return FALSE;
+    }
+
+    self->num_pending = g_hash_table_size (self->pending);
+  }
+
+  if (self->have_last && (picture->epoch < self->last_epoch ||
+          (picture->epoch == self->last_epoch &&
+              picture->order <= self->last_order))) {
+    GST_ELEMENT_ERROR (self->counter.element, STREAM, DECODE,
+        ("Pictures output out of order"), ("Frame %u with order %"
+            G_GINT64_FORMAT " (epoch %" G_GUINT64_FORMAT ") was output after "
+            "order %" G_GINT64_FORMAT " (epoch %" G_GUINT64_FORMAT ")",
+            picture->system_frame_number, picture->order, picture->epoch,
+            self->last_order, self->last_epoch));
+    return FALSE;
+  }
+
+  self->have_last = TRUE;
+  self->last_epoch = picture->epoch;
+  self->last_order = picture->order;
+
+  return TRUE;
+}
+
+static void
+gst_codec_harness_validator_flush (gpointer backend)
+{
+  GstCodecHarnessValidator *self = backend;
+
+  /* the base class discards its DPB without output on flush */
+  g_hash_table_remove_all (self->pending);
+  self->num_pending = 0;
+  self->have_last = FALSE;
+}
+
+static gboolean
+gst_codec_harness_validator_finish (gpointer backend)
+{
+  GstCodecHarnessValidator *self = backend;
+
+  if (self->num_pending > 0) {
+    GST_ELEMENT_ERROR (self->counter.element, STREAM, DECODE,
+        ("Pictures never output"), ("%u decoded pictures were not output "
+            "after draining", self->num_pending));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstStructure *
+gst_codec_harness_validator_get_stats (gpointer backend)
+{
+  GstCodecHarnessValidator *self = backend;
+  GstStructure *stats;
+
+  stats = gst_codec_harness_counter_get_stats (&self->counter);
+  gst_structure_set (stats,
+      "pending", G_TYPE_UINT, self->num_pending,
+      "max-pending", G_TYPE_UINT, self->max_pending,
+      "max-dpb-size", G_TYPE_UINT, self->max_dpb_size, NULL);
+
+  return stats;
+}
+
+static const GstCodecHarnessBackend dpb_validator_backend = {
+  "dpb-validator",
+  gst_codec_harness_validator_open,
+  gst_codec_harness_validator_close,
+  gst_codec_harness_validator_new_sequence,
+  gst_codec_harness_counter_start_picture,
+  gst_codec_harness_counter_decode_slice,
+  gst_codec_harness_validator_end_picture,
+  gst_codec_harness_validator_output_picture,
+  gst_codec_harness_validator_flush,
+  gst_codec_harness_validator_finish,
+  gst_codec_harness_validator_get_stats,
+};
+
+/* helpers shared by the harness elements */
+
+void
+gst_codec_harness_init (GstCodecHarness * harness, GstElement * element)
+{
+  harness->element = element;
+  harness->backend_type = DEFAULT_BACKEND;
+}
+
+void
+gst_codec_harness_clear (GstCodecHarness * harness)
+{
+  gst_codec_harness_close (harness);
+  g_clear_pointer (&harness->stats, gst_structure_free);
+}
+
+void
+gst_codec_harness_install_properties (GObjectClass * object_class)
+{
+  /**
+   * GstCodecHarness:backend:
+   *
+   * The backend the pictures of the base class are forwarded to.
+   */
+  g_object_class_install_property (object_class,
+      GST_CODEC_HARNESS_PROP_BACKEND,
+      g_param_spec_enum ("backend", "Backend",
+          "The backend the pictures of the base class are forwarded to",
+          GST_TYPE_CODEC_HARNESS_BACKEND_TYPE, DEFAULT_BACKEND,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstCodecHarness:stats:
+   *
+   * The counters of the backend: sequences, pictures, slices, bytes and
+   * outputs, plus the pending, max-pending and max-dpb-size pictures of the
+   * DPB validator. Kept after the element is shut down.
+   */
+  g_object_class_install_property (object_class,
+      GST_CODEC_HARNESS_PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats", "The counters of the backend",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_CODEC_HARNESS_BACKEND_TYPE, 0);
+}
+
+gboolean
+gst_codec_harness_set_property (GstCodecHarness * harness, guint prop_id,
+    const GValue * value)
+{
+  switch (prop_id) {
+    case GST_CODEC_HARNESS_PROP_BACKEND:
+      harness->backend_type = g_value_get_enum (value);
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+gboolean
+gst_codec_harness_get_property (GstCodecHarness * harness, guint prop_id,
+    GValue * value)
+{
+  switch (prop_id) {
+    case GST_CODEC_HARNESS_PROP_BACKEND:
+      g_value_set_enum (value, harness->backend_type);
+      return TRUE;
+    case GST_CODEC_HARNESS_PROP_STATS:
+      GST_OBJECT_LOCK (harness->element);
+      if (harness->backend_data) {
+        g_value_take_boxed (value,
+            harness->backend->get_stats (harness->backend_data));
+      } else {
+        g_value_set_boxed (value, harness->stats);
+      }
+      GST_OBJECT_UNLOCK (harness->element);
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+gboolean
+gst_codec_harness_open (GstCodecHarness * harness)
+{
+  const GstCodecHarnessBackend *backend;
+  gpointer backend_data;
+
+  switch (harness->backend_type) {
+    case GST_CODEC_HARNESS_BACKEND_DPB_VALIDATOR:
+      backend = &dpb_validator_backend;
+      break;
+    case GST_CODEC_HARNESS_BACKEND_NULL:
+    default:
+      backend = &null_backend;
+      break;
+  }
+
+  backend_data = backend->open (harness->element);
+  if (!backend_data) {
+    GST_ERROR_OBJECT (harness->element, "Failed to open %s backend",
+        backend->name);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (harness->element, "Opened %s backend", backend->name);
+
+  GST_OBJECT_LOCK (harness->element);
+  harness->backend = backend;
+  harness->backend_data = backend_data;
+  harness->epoch = 0;
+  g_clear_pointer (&harness->stats, gst_structure_free);
+  GST_OBJECT_UNLOCK (harness->element);
+
+  return TRUE;
+}
+
+void
+gst_codec_harness_close (GstCodecHarness * harness)
+{
+  const GstCodecHarnessBackend *backend;
+  gpointer backend_data;
+
+  GST_OBJECT_LOCK (harness->element);
+  backend = harness->backend;
+  backend_data = harness->backend_data;
+  harness->backend_data = NULL;
+  if (backend_data) {
+    g_clear_pointer (&harness->stats, gst_structure_free);
+    harness->stats = backend->get_stats (backend_data);
+  }
+  GST_OBJECT_UNLOCK (harness->element);
+
+  if (backend_data) {
+    GST_DEBUG_OBJECT (harness->element, "Closing %s backend, stats %"
+        GST_PTR_FORMAT, backend->name, harness->stats);
+    backend->close (backend_data);
+  }
+}
+
+void
+gst_codec_harness_flush (GstCodecHarness * harness)
+{
+  if (harness->backend_data)
+    harness->backend->flush (harness->backend_data);
+}
+
+GstFlowReturn
+gst_codec_harness_finish (GstCodecHarness * harness)
+{
+  if (harness->backend_data &&
+      !harness->backend->finish (harness->backend_data))
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
+GstFlowReturn
+gst_codec_harness_new_sequence (GstCodecHarness * harness,
+    GstVideoCodecState * input_state, guint width, guint height,
+    guint bit_depth, guint max_dpb_size)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (harness->element);
+  GstVideoCodecState *output_state;
+  GstVideoFormat format;
+  GstVideoInfo info;
+
+  if (bit_depth <= 8)
+    format = GST_VIDEO_FORMAT_NV12;
+  else if (bit_depth == 10)
+    format = GST_VIDEO_FORMAT_P010_10LE;
+  else
+    format = GST_VIDEO_FORMAT_P016_LE;
+
+  GST_INFO_OBJECT (harness->element, "New sequence %ux%u, bit depth %u, "
+      "max DPB size %u", width, height, bit_depth, max_dpb_size);
+
+  gst_video_info_set_format (&info, format, width, height);
+  harness->epoch++;
+
+  if (!harness->backend->new_sequence (harness->backend_data, &info,
+          max_dpb_size))
+    return GST_FLOW_ERROR;
+
+  output_state = gst_video_decoder_set_output_state (decoder, format,
+      width, height, input_state);
+  gst_video_codec_state_unref (output_state);
+
+  if (!gst_video_decoder_negotiate (decoder)) {
+    GST_ERROR_OBJECT (harness->element, "Failed to negotiate with downstream");
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  return GST_FLOW_OK;
+}
+
+GstCodecHarnessPicture *
+gst_codec_harness_picture_new (guint32 system_frame_number)
+{
+  GstCodecHarnessPicture *picture = g_new0 (GstCodecHarnessPicture, 1);
+
+  picture->system_frame_number = system_frame_number;
+  picture->needed_for_output = TRUE;
+
+  return picture;
+}
+
+GstCodecHarnessPicture *
+gst_codec_harness_picture_duplicate (GstCodecHarnessPicture * picture)
+{
+  GstCodecHarnessPicture *new_picture = g_memdup2 (picture, sizeof (*picture));
+
+  new_picture->duplicate = TRUE;
+  new_picture->needed_for_output = TRUE;
+
+  return new_picture;
+}
+
+GstFlowReturn
+gst_codec_harness_start_picture (GstCodecHarness * harness,
+    GstCodecHarnessPicture * picture, gint64 order, gboolean restarts_order)
+{
+  /* a frame is output in the order of its first field */
+  if (picture->started) {
+    picture->order = MIN (picture->order, order);
+    return GST_FLOW_OK;
+  }
+
+  if (restarts_order)
+    harness->epoch++;
+
+  picture->order = order;
+  picture->epoch = harness->epoch;
+  picture->started = TRUE;
+
+  if (!harness->backend->start_picture (harness->backend_data, picture))
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
+GstFlowReturn
+gst_codec_harness_decode_slice (GstCodecHarness * harness,
+    GstCodecHarnessPicture * picture, gsize size)
+{
+  picture->num_slices++;
+  picture->size += size;
+
+  if (!harness->backend->decode_slice (harness->backend_data, picture, size))
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
+GstFlowReturn
+gst_codec_harness_end_picture (GstCodecHarness * harness,
+    GstCodecHarnessPicture * picture)
+{
+  gboolean ret;
+
+  ret = harness->backend->end_picture (harness->backend_data, picture);
+  picture->decoded = TRUE;
+
+  return ret ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
+GstFlowReturn
+gst_codec_harness_output_picture (GstCodecHarness * harness,
+    GstVideoCodecFrame * frame, GstCodecHarnessPicture * picture)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (harness->element);
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (harness->element, "Outputting frame %u, order %"
+      G_GINT64_FORMAT, picture->system_frame_number, picture->order);
+
+  if (!harness->backend->output_picture (harness->backend_data, picture)) {
+    gst_video_decoder_drop_frame (decoder, frame);
+    return GST_FLOW_ERROR;
+  }
+
+  ret = gst_video_decoder_allocate_output_frame (decoder, frame);
+  if (ret != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (harness->element, "Failed to allocate output buffer, "
+        "%s", gst_flow_get_name (ret));
+    gst_video_decoder_drop_frame (decoder, frame);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (decoder, frame);
+}
+
+void
+gst_codec_harness_plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_codec_harness_debug, "codecharness", 0,
+      "Stateless decoder harness");
+
+  gst_element_register (plugin, "h264harnessdec", GST_RANK_NONE,
+      GST_TYPE_H264_HARNESS_DEC);
+  gst_element_register (plugin, "h265harnessdec", GST_RANK_NONE,
+      GST_TYPE_H265_HARNESS_DEC);
+  gst_element_register (plugin, "vp9harnessdec", GST_RANK_NONE,
+      GST_TYPE_VP9_HARNESS_DEC);
+  gst_element_register (plugin, "av1harnessdec", GST_RANK_NONE,
+      GST_TYPE_AV1_HARNESS_DEC);
+  gst_element_register (plugin, "mpeg2harnessdec", GST_RANK_NONE,
+      GST_TYPE_MPEG2_HARNESS_DEC);
+}
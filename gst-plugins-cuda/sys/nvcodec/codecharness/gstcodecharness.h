@@ -0,0 +1,174 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CODEC_HARNESS_H__
+#define __GST_CODEC_HARNESS_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstCodecHarnessBackendType:
+ * @GST_CODEC_HARNESS_BACKEND_NULL: count pictures, slices and bytes only
+ * @GST_CODEC_HARNESS_BACKEND_DPB_VALIDATOR: additionally validate the output
+ *   order and the DPB fullness reported by the decoder base class
+ */
+typedef enum
+{
+  GST_CODEC_HARNESS_BACKEND_NULL,
+  GST_CODEC_HARNESS_BACKEND_DPB_VALIDATOR,
+} GstCodecHarnessBackendType;
+
+#define GST_TYPE_CODEC_HARNESS_BACKEND_TYPE (gst_codec_harness_backend_type_get_type ())
+GType gst_codec_harness_backend_type_get_type (void);
+
+typedef struct _GstCodecHarnessPicture GstCodecHarnessPicture;
+typedef struct _GstCodecHarnessBackend GstCodecHarnessBackend;
+typedef struct _GstCodecHarness GstCodecHarness;
+
+/* Codec agnostic view of a picture of the base class, attached as the user
+ * data of the codec picture */
+struct _GstCodecHarnessPicture
+{
+  guint32 system_frame_number;
+
+  /* the key pictures have to be output in: POC for H.264, H.265 and MPEG-2,
+   * the frame number for VP9 and AV1 */
+  gint64 order;
+  /* incremented at each sequence and at each picture restarting @order */
+  guint64 epoch;
+
+  /* whether the base class is expected to output this picture */
+  gboolean needed_for_output;
+  /* shown again through show_existing_frame, decoded earlier */
+  gboolean duplicate;
+  /* start_picture and end_picture were called, the second field of a frame
+   * shares the picture of the first one */
+  gboolean started;
+  gboolean decoded;
+
+  guint num_slices;
+  gsize size;
+};
+
+struct _GstCodecHarnessBackend
+{
+  const gchar *name;
+
+  gpointer      (*open)           (GstElement * element);
+  void          (*close)          (gpointer backend);
+  gboolean      (*new_sequence)   (gpointer backend,
+                                   const GstVideoInfo * info,
+                                   guint max_dpb_size);
+  gboolean      (*start_picture)  (gpointer backend,
+                                   GstCodecHarnessPicture * picture);
+  gboolean      (*decode_slice)   (gpointer backend,
+                                   GstCodecHarnessPicture * picture,
+                                   gsize size);
+  gboolean      (*end_picture)    (gpointer backend,
+                                   GstCodecHarnessPicture * picture);
+  gboolean      (*output_picture) (gpointer backend,
+                                   GstCodecHarnessPicture * picture);
+  void          (*flush)          (gpointer backend);
+  gboolean      (*finish)         (gpointer backend);
+  GstStructure *(*get_stats)      (gpointer backend);
+};
+
+struct _GstCodecHarness
+{
+  GstElement *element;
+
+  GstCodecHarnessBackendType backend_type;
+  const GstCodecHarnessBackend *backend;
+  gpointer backend_data;
+
+  guint64 epoch;
+
+  /* last stats of the closed backend, so they survive a state change to
+   * NULL at EOS */
+  GstStructure *stats;
+};
+
+enum
+{
+  GST_CODEC_HARNESS_PROP_0,
+  GST_CODEC_HARNESS_PROP_BACKEND,
+  GST_CODEC_HARNESS_PROP_STATS,
+};
+
+#define GST_CODEC_HARNESS_SRC_CAPS \
+    "video/x-raw, format = (string) { NV12, P010_10LE, P016_LE }, " \
+    "width = " GST_VIDEO_SIZE_RANGE ", height = " GST_VIDEO_SIZE_RANGE
+
+void          gst_codec_harness_init               (GstCodecHarness * harness,
+                                                    GstElement * element);
+
+void          gst_codec_harness_clear              (GstCodecHarness * harness);
+
+void          gst_codec_harness_install_properties (GObjectClass * object_class);
+
+gboolean      gst_codec_harness_set_property       (GstCodecHarness * harness,
+                                                    guint prop_id,
+                                                    const GValue * value);
+
+gboolean      gst_codec_harness_get_property       (GstCodecHarness * harness,
+                                                    guint prop_id,
+                                                    GValue * value);
+
+gboolean      gst_codec_harness_open               (GstCodecHarness * harness);
+
+void          gst_codec_harness_close              (GstCodecHarness * harness);
+
+void          gst_codec_harness_flush              (GstCodecHarness * harness);
+
+GstFlowReturn gst_codec_harness_finish             (GstCodecHarness * harness);
+
+GstFlowReturn gst_codec_harness_new_sequence       (GstCodecHarness * harness,
+                                                    GstVideoCodecState * input_state,
+                                                    guint width,
+                                                    guint height,
+                                                    guint bit_depth,
+                                                    guint max_dpb_size);
+
+GstCodecHarnessPicture * gst_codec_harness_picture_new (guint32 system_frame_number);
+
+GstCodecHarnessPicture * gst_codec_harness_picture_duplicate (GstCodecHarnessPicture * picture);
+
+GstFlowReturn gst_codec_harness_start_picture      (GstCodecHarness * harness,
+                                                    GstCodecHarnessPicture * picture,
+                                                    gint64 order,
+                                                    gboolean restarts_order);
+
+GstFlowReturn gst_codec_harness_decode_slice       (GstCodecHarness * harness,
+                                                    GstCodecHarnessPicture * picture,
+                                                    gsize size);
+
+GstFlowReturn gst_codec_harness_end_picture        (GstCodecHarness * harness,
+                                                    GstCodecHarnessPicture * picture);
+
+GstFlowReturn gst_codec_harness_output_picture     (GstCodecHarness * harness,
+                                                    GstVideoCodecFrame * frame,
+                                                    GstCodecHarnessPicture * picture);
+
+void          gst_codec_harness_plugin_init        (GstPlugin * plugin);
+
+G_END_DECLS
+
+#endif /* __GST_CODEC_HARNESS_H__ */
@@ -0,0 +1,329 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-h264harnessdec
+ * @title: h264harnessdec
+ *
+ * Drives #GstH264Decoder without decoding hardware, see #GstCodecHarness.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=stream.h264 ! h264parse ! h264harnessdec backend=dpb-validator ! fakesink
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsth264harnessdec.h"
+
+#include <gst/codecs/gsth264decoder.h>
+
+#include "gstcodecharness.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_h264_harness_dec_debug);
+#define GST_CAT_DEFAULT gst_h264_harness_dec_debug
+
+struct _GstH264HarnessDec
+{
+  GstH264Decoder parent;
+
+  GstCodecHarness harness;
+};
+
+struct _GstH264HarnessDecClass
+{
+  GstH264DecoderClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h264, "
+        "stream-format = (string) { avc, avc3, byte-stream }, "
+        "alignment = (string) au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS (GST_CODEC_HARNESS_SRC_CAPS));
+
+#define gst_h264_harness_dec_parent_class parent_class
+G_DEFINE_TYPE (GstH264HarnessDec, gst_h264_harness_dec, GST_TYPE_H264_DECODER);
+
+static void gst_h264_harness_dec_finalize (GObject * object);
+static void gst_h264_harness_dec_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_h264_harness_dec_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_h264_harness_dec_open (GstVideoDecoder * decoder);
+static gboolean gst_h264_harness_dec_close (GstVideoDecoder * decoder);
+static gboolean gst_h264_harness_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_h264_harness_dec_finish (GstVideoDecoder * decoder);
+
+/* GstH264Decoder */
+static GstFlowReturn gst_h264_harness_dec_new_sequence (GstH264Decoder *
+    decoder, const GstH264SPS * sps, gint max_dpb_size);
+static GstFlowReturn gst_h264_harness_dec_new_picture (GstH264Decoder *
+    decoder, GstVideoCodecFrame * frame, GstH264Picture * picture);
+static GstFlowReturn gst_h264_harness_dec_new_field_picture (GstH264Decoder *
+    decoder, const GstH264Picture * first_field, GstH264Picture * second_field);
+static GstFlowReturn gst_h264_harness_dec_start_picture (GstH264Decoder *
+    decoder, GstH264Picture * picture, GstH264Slice * slice, GstH264Dpb * dpb);
+static GstFlowReturn gst_h264_harness_dec_decode_slice (GstH264Decoder *
+    decoder, GstH264Picture * picture, GstH264Slice * slice,
+    GArray * ref_pic_list0, GArray * ref_pic_list1);
+static GstFlowReturn gst_h264_harness_dec_end_picture (GstH264Decoder *
+    decoder, GstH264Picture * picture);
+static GstFlowReturn gst_h264_harness_dec_output_picture (GstH264Decoder *
+    decoder, GstVideoCodecFrame * frame, GstH264Picture * picture);
+
+static void
+gst_h264_harness_dec_class_init (GstH264HarnessDecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_h264_harness_dec_finalize;
+  object_class->set_property = gst_h264_harness_dec_set_property;
+  object_class->get_property = gst_h264_harness_dec_get_property;
+
+  gst_codec_harness_install_properties (object_class);
+
+  gst_element_class_set_static_metadata (element_class,
+      "H.264 Stateless Decoder Harness", "Codec/Decoder/Video",
+      "Drives the H.264 decoder base class without decoding hardware",
+      "icetana");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_h264_harness_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_h264_harness_dec_close);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_h264_harness_dec_flush);
+  decoder_class->finish = GST_DEBUG_FUNCPTR (gst_h264_harness_dec_finish);
+
+  h264decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_new_sequence);
+  h264decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_new_picture);
+  h264decoder_class->new_field_picture =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_new_field_picture);
+  h264decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_start_picture);
+  h264decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_decode_slice);
+  h264decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_end_picture);
+  h264decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_h264_harness_dec_output_picture);
+
+  GST_DEBUG_CATEGORY_INIT (gst_h264_harness_dec_debug,
+      "h264harnessdec", 0, "H.264 Stateless Decoder Harness");
+}
+
+static void
+gst_h264_harness_dec_init (GstH264HarnessDec * self)
+{
+  gst_codec_harness_init (&self->harness, GST_ELEMENT (self));
+}
+
+static void
+gst_h264_harness_dec_finalize (GObject * object)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (object);
+
+  gst_codec_harness_clear (&self->harness);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_h264_harness_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_set_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_h264_harness_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_get_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_h264_harness_dec_open (GstVideoDecoder * decoder)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_open (&self->harness);
+}
+
+static gboolean
+gst_h264_harness_dec_close (GstVideoDecoder * decoder)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+
+  gst_codec_harness_close (&self->harness);
+
+  return TRUE;
+}
+
+static gboolean
+gst_h264_harness_dec_flush (GstVideoDecoder * decoder)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  gboolean ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+  gst_codec_harness_flush (&self->harness);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_finish (GstVideoDecoder * decoder)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  GstFlowReturn ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->finish (decoder);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_codec_harness_finish (&self->harness);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps, gint max_dpb_size)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  guint width = sps->width;
+  guint height = sps->height;
+
+  if (sps->frame_cropping_flag) {
+    width = sps->crop_rect_width;
+    height = sps->crop_rect_height;
+  }
+
+  return gst_codec_harness_new_sequence (&self->harness, decoder->input_state,
+      width, height, sps->bit_depth_luma_minus8 + 8, max_dpb_size);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_new_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  gst_h264_picture_set_user_data (picture,
+      gst_codec_harness_picture_new (frame->system_frame_number),
+      (GDestroyNotify) g_free);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_new_field_picture (GstH264Decoder * decoder,
+    const GstH264Picture * first_field, GstH264Picture * second_field)
+{
+  /* the second field shares the harness picture of the first field */
+  return GST_FLOW_OK;
+}
+
+static GstCodecHarnessPicture *
+gst_h264_harness_dec_get_picture (GstH264Picture * picture)
+{
+  if (picture->second_field && picture->other_field)
+    picture = picture->other_field;
+
+  return (GstCodecHarnessPicture *) gst_h264_picture_get_user_data (picture);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_start_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GstH264Dpb * dpb)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h264_harness_dec_get_picture (picture);
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* IDR and memory_management_control_operation 5 restart the POC */
+  return gst_codec_harness_start_picture (&self->harness, hpic,
+      picture->pic_order_cnt, picture->idr || picture->mem_mgmt_5);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h264_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_decode_slice (&self->harness, hpic,
+      slice->nalu.size);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_end_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h264_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_end_picture (&self->harness, hpic);
+}
+
+static GstFlowReturn
+gst_h264_harness_dec_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  GstH264HarnessDec *self = GST_H264_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h264_harness_dec_get_picture (picture);
+  GstFlowReturn ret;
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (decoder), frame);
+    gst_h264_picture_unref (picture);
+    return GST_FLOW_ERROR;
+  }
+
+  ret = gst_codec_harness_output_picture (&self->harness, frame, hpic);
+  gst_h264_picture_unref (picture);
+
+  return ret;
+}
@@ -0,0 +1,313 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-h265harnessdec
+ * @title: h265harnessdec
+ *
+ * Drives #GstH265Decoder without decoding hardware, see #GstCodecHarness.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=stream.h265 ! h265parse ! h265harnessdec backend=dpb-validator ! fakesink
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsth265harnessdec.h"
+
+#include <gst/codecs/gsth265decoder.h>
+
+#include "gstcodecharness.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_h265_harness_dec_debug);
+#define GST_CAT_DEFAULT gst_h265_harness_dec_debug
+
+struct _GstH265HarnessDec
+{
+  GstH265Decoder parent;
+
+  GstCodecHarness harness;
+};
+
+struct _GstH265HarnessDecClass
+{
+  GstH265DecoderClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h265, "
+        "stream-format = (string) { hvc1, hev1, byte-stream }, "
+        "alignment = (string) au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS (GST_CODEC_HARNESS_SRC_CAPS));
+
+#define gst_h265_harness_dec_parent_class parent_class
+G_DEFINE_TYPE (GstH265HarnessDec, gst_h265_harness_dec, GST_TYPE_H265_DECODER);
+
+static void gst_h265_harness_dec_finalize (GObject * object);
+static void gst_h265_harness_dec_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_h265_harness_dec_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_h265_harness_dec_open (GstVideoDecoder * decoder);
+static gboolean gst_h265_harness_dec_close (GstVideoDecoder * decoder);
+static gboolean gst_h265_harness_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_h265_harness_dec_finish (GstVideoDecoder * decoder);
+
+/* GstH265Decoder */
+static GstFlowReturn gst_h265_harness_dec_new_sequence (GstH265Decoder *
+    decoder, const GstH265SPS * sps, gint max_dpb_size);
+static GstFlowReturn gst_h265_harness_dec_new_picture (GstH265Decoder *
+    decoder, GstVideoCodecFrame * frame, GstH265Picture * picture);
+static GstFlowReturn gst_h265_harness_dec_start_picture (GstH265Decoder *
+    decoder, GstH265Picture * picture, GstH265Slice * slice, GstH265Dpb * dpb);
+static GstFlowReturn gst_h265_harness_dec_decode_slice (GstH265Decoder *
+    decoder, GstH265Picture * picture, GstH265Slice * slice,
+    GArray * ref_pic_list0, GArray * ref_pic_list1);
+static GstFlowReturn gst_h265_harness_dec_end_picture (GstH265Decoder *
+    decoder, GstH265Picture * picture);
+static GstFlowReturn gst_h265_harness_dec_output_picture (GstH265Decoder *
+    decoder, GstVideoCodecFrame * frame, GstH265Picture * picture);
+
+static void
+gst_h265_harness_dec_class_init (GstH265HarnessDecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_h265_harness_dec_finalize;
+  object_class->set_property = gst_h265_harness_dec_set_property;
+  object_class->get_property = gst_h265_harness_dec_get_property;
+
+  gst_codec_harness_install_properties (object_class);
+
+  gst_element_class_set_static_metadata (element_class,
+      "H.265 Stateless Decoder Harness", "Codec/Decoder/Video",
+      "Drives the H.265 decoder base class without decoding hardware",
+      "icetana");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_h265_harness_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_h265_harness_dec_close);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_h265_harness_dec_flush);
+  decoder_class->finish = GST_DEBUG_FUNCPTR (gst_h265_harness_dec_finish);
+
+  h265decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_new_sequence);
+  h265decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_new_picture);
+  h265decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_start_picture);
+  h265decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_decode_slice);
+  h265decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_end_picture);
+  h265decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_h265_harness_dec_output_picture);
+
+  GST_DEBUG_CATEGORY_INIT (gst_h265_harness_dec_debug,
+      "h265harnessdec", 0, "H.265 Stateless Decoder Harness");
+}
+
+static void
+gst_h265_harness_dec_init (GstH265HarnessDec * self)
+{
+  gst_codec_harness_init (&self->harness, GST_ELEMENT (self));
+}
+
+static void
+gst_h265_harness_dec_finalize (GObject * object)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (object);
+
+  gst_codec_harness_clear (&self->harness);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_h265_harness_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_set_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_h265_harness_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_get_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_h265_harness_dec_open (GstVideoDecoder * decoder)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_open (&self->harness);
+}
+
+static gboolean
+gst_h265_harness_dec_close (GstVideoDecoder * decoder)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+
+  gst_codec_harness_close (&self->harness);
+
+  return TRUE;
+}
+
+static gboolean
+gst_h265_harness_dec_flush (GstVideoDecoder * decoder)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  gboolean ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+  gst_codec_harness_flush (&self->harness);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_finish (GstVideoDecoder * decoder)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  GstFlowReturn ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->finish (decoder);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_codec_harness_finish (&self->harness);
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  guint width = sps->width;
+  guint height = sps->height;
+
+  if (sps->conformance_window_flag) {
+    width = sps->crop_rect_width;
+    height = sps->crop_rect_height;
+  }
+
+  return gst_codec_harness_new_sequence (&self->harness, decoder->input_state,
+      width, height, sps->bit_depth_luma_minus8 + 8, max_dpb_size);
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_new_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  gst_h265_picture_set_user_data (picture,
+      gst_codec_harness_picture_new (frame->system_frame_number),
+      (GDestroyNotify) g_free);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_start_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GstH265Dpb * dpb)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h265_harness_dec_get_picture (picture);
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* RASL pictures associated with a CRA starting the bitstream are decoded
+   * but never output */
+  hpic->needed_for_output = picture->output_flag;
+
+  /* PicOrderCntMsb is reset by IRAP pictures with NoRaslOutputFlag */
+  return gst_codec_harness_start_picture (&self->harness, hpic,
+      picture->pic_order_cnt, picture->RapPicFlag &&
+      picture->NoRaslOutputFlag);
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h265_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_decode_slice (&self->harness, hpic,
+      slice->nalu.size);
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h265_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_end_picture (&self->harness, hpic);
+}
+
+static GstFlowReturn
+gst_h265_harness_dec_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GstH265HarnessDec *self = GST_H265_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_h265_harness_dec_get_picture (picture);
+  GstFlowReturn ret;
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (decoder), frame);
+    gst_h265_picture_unref (picture);
+    return GST_FLOW_ERROR;
+  }
+
+  ret = gst_codec_harness_output_picture (&self->harness, frame, hpic);
+  gst_h265_picture_unref (picture);
+
+  return ret;
+}
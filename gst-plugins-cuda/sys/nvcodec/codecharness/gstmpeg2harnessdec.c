@@ -0,0 +1,337 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-mpeg2harnessdec
+ * @title: mpeg2harnessdec
+ *
+ * Drives #GstMpeg2Decoder without decoding hardware, see #GstCodecHarness.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=stream.m2v ! mpegvideoparse ! mpeg2harnessdec backend=dpb-validator ! fakesink
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstmpeg2harnessdec.h"
+
+#include <gst/codecs/gstmpeg2decoder.h>
+
+#include "gstcodecharness.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_mpeg2_harness_dec_debug);
+#define GST_CAT_DEFAULT gst_mpeg2_harness_dec_debug
+
+struct _GstMpeg2HarnessDec
+{
+  GstMpeg2Decoder parent;
+
+  GstCodecHarness harness;
+};
+
+struct _GstMpeg2HarnessDecClass
+{
+  GstMpeg2DecoderClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpeg, mpegversion = (int) 2, "
+        "systemstream = (boolean) false"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS (GST_CODEC_HARNESS_SRC_CAPS));
+
+#define gst_mpeg2_harness_dec_parent_class parent_class
+G_DEFINE_TYPE (GstMpeg2HarnessDec, gst_mpeg2_harness_dec,
+    GST_TYPE_MPEG2_DECODER);
+
+static void gst_mpeg2_harness_dec_finalize (GObject * object);
+static void gst_mpeg2_harness_dec_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_mpeg2_harness_dec_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_mpeg2_harness_dec_open (GstVideoDecoder * decoder);
+static gboolean gst_mpeg2_harness_dec_close (GstVideoDecoder * decoder);
+static gboolean gst_mpeg2_harness_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_mpeg2_harness_dec_finish (GstVideoDecoder * decoder);
+
+/* GstMpeg2Decoder */
+static GstFlowReturn gst_mpeg2_harness_dec_new_sequence (GstMpeg2Decoder *
+    decoder, const GstMpegVideoSequenceHdr * seq,
+    const GstMpegVideoSequenceExt * seq_ext,
+    const GstMpegVideoSequenceDisplayExt * seq_display_ext,
+    const GstMpegVideoSequenceScalableExt * seq_scalable_ext);
+static GstFlowReturn gst_mpeg2_harness_dec_new_picture (GstMpeg2Decoder *
+    decoder, GstVideoCodecFrame * frame, GstMpeg2Picture * picture);
+static GstFlowReturn gst_mpeg2_harness_dec_new_field_picture (GstMpeg2Decoder *
+    decoder, const GstMpeg2Picture * first_field,
+    GstMpeg2Picture * second_field);
+static GstFlowReturn gst_mpeg2_harness_dec_start_picture (GstMpeg2Decoder *
+    decoder, GstMpeg2Picture * picture, GstMpeg2Slice * slice,
+    GstMpeg2Picture * prev_picture, GstMpeg2Picture * next_picture);
+static GstFlowReturn gst_mpeg2_harness_dec_decode_slice (GstMpeg2Decoder *
+    decoder, GstMpeg2Picture * picture, GstMpeg2Slice * slice);
+static GstFlowReturn gst_mpeg2_harness_dec_end_picture (GstMpeg2Decoder *
+    decoder, GstMpeg2Picture * picture);
+static GstFlowReturn gst_mpeg2_harness_dec_output_picture (GstMpeg2Decoder *
+    decoder, GstVideoCodecFrame * frame, GstMpeg2Picture * picture);
+
+static void
+gst_mpeg2_harness_dec_class_init (GstMpeg2HarnessDecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstMpeg2DecoderClass *mpeg2decoder_class = GST_MPEG2_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_mpeg2_harness_dec_finalize;
+  object_class->set_property = gst_mpeg2_harness_dec_set_property;
+  object_class->get_property = gst_mpeg2_harness_dec_get_property;
+
+  gst_codec_harness_install_properties (object_class);
+
+  gst_element_class_set_static_metadata (element_class,
+      "MPEG-2 Stateless Decoder Harness", "Codec/Decoder/Video",
+      "Drives the MPEG-2 decoder base class without decoding hardware",
+      "icetana");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_close);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_flush);
+  decoder_class->finish = GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_finish);
+
+  mpeg2decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_new_sequence);
+  mpeg2decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_new_picture);
+  mpeg2decoder_class->new_field_picture =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_new_field_picture);
+  mpeg2decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_start_picture);
+  mpeg2decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_decode_slice);
+  mpeg2decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_end_picture);
+  mpeg2decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_mpeg2_harness_dec_output_picture);
+
+  GST_DEBUG_CATEGORY_INIT (gst_mpeg2_harness_dec_debug,
+      "mpeg2harnessdec", 0, "MPEG-2 Stateless Decoder Harness");
+}
+
+static void
+gst_mpeg2_harness_dec_init (GstMpeg2HarnessDec * self)
+{
+  gst_codec_harness_init (&self->harness, GST_ELEMENT (self));
+}
+
+static void
+gst_mpeg2_harness_dec_finalize (GObject * object)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (object);
+
+  gst_codec_harness_clear (&self->harness);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_mpeg2_harness_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_set_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_mpeg2_harness_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_get_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_mpeg2_harness_dec_open (GstVideoDecoder * decoder)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_open (&self->harness);
+}
+
+static gboolean
+gst_mpeg2_harness_dec_close (GstVideoDecoder * decoder)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+
+  gst_codec_harness_close (&self->harness);
+
+  return TRUE;
+}
+
+static gboolean
+gst_mpeg2_harness_dec_flush (GstVideoDecoder * decoder)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  gboolean ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+  gst_codec_harness_flush (&self->harness);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_finish (GstVideoDecoder * decoder)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  GstFlowReturn ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->finish (decoder);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_codec_harness_finish (&self->harness);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_new_sequence (GstMpeg2Decoder * decoder,
+    const GstMpegVideoSequenceHdr * seq,
+    const GstMpegVideoSequenceExt * seq_ext,
+    const GstMpegVideoSequenceDisplayExt * seq_display_ext,
+    const GstMpegVideoSequenceScalableExt * seq_scalable_ext)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  guint width = seq->width;
+  guint height = seq->height;
+
+  if (seq_ext) {
+    width = (seq_ext->horiz_size_ext << 12) | width;
+    height = (seq_ext->vert_size_ext << 12) | height;
+  }
+
+  /* the forward and backward reference pictures */
+  return gst_codec_harness_new_sequence (&self->harness, decoder->input_state,
+      width, height, 8, 2);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_new_picture (GstMpeg2Decoder * decoder,
+    GstVideoCodecFrame * frame, GstMpeg2Picture * picture)
+{
+  gst_mpeg2_picture_set_user_data (picture,
+      gst_codec_harness_picture_new (frame->system_frame_number),
+      (GDestroyNotify) g_free);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_new_field_picture (GstMpeg2Decoder * decoder,
+    const GstMpeg2Picture * first_field, GstMpeg2Picture * second_field)
+{
+  /* the second field shares the harness picture of the first field */
+  return GST_FLOW_OK;
+}
+
+static GstCodecHarnessPicture *
+gst_mpeg2_harness_dec_get_picture (GstMpeg2Picture * picture)
+{
+  if (picture->first_field)
+    picture = picture->first_field;
+
+  return (GstCodecHarnessPicture *) gst_mpeg2_picture_get_user_data (picture);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_start_picture (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture, GstMpeg2Slice * slice,
+    GstMpeg2Picture * prev_picture, GstMpeg2Picture * next_picture)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_mpeg2_harness_dec_get_picture (picture);
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* the base class derives the POC from temporal_reference, continuously
+   * across GOPs */
+  return gst_codec_harness_start_picture (&self->harness, hpic,
+      picture->pic_order_cnt, FALSE);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_decode_slice (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture, GstMpeg2Slice * slice)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_mpeg2_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_decode_slice (&self->harness, hpic, slice->size);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_end_picture (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_mpeg2_harness_dec_get_picture (picture);
+
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_end_picture (&self->harness, hpic);
+}
+
+static GstFlowReturn
+gst_mpeg2_harness_dec_output_picture (GstMpeg2Decoder * decoder,
+    GstVideoCodecFrame * frame, GstMpeg2Picture * picture)
+{
+  GstMpeg2HarnessDec *self = GST_MPEG2_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic = gst_mpeg2_harness_dec_get_picture (picture);
+  GstFlowReturn ret;
+
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (decoder), frame);
+    gst_mpeg2_picture_unref (picture);
+    return GST_FLOW_ERROR;
+  }
+
+  ret = gst_codec_harness_output_picture (&self->harness, frame, hpic);
+  gst_mpeg2_picture_unref (picture);
+
+  return ret;
+}
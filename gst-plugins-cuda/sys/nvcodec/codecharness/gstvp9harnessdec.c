@@ -0,0 +1,335 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp9harnessdec
+ * @title: vp9harnessdec
+ *
+ * Drives #GstVp9Decoder without decoding hardware, see #GstCodecHarness.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=stream.webm ! matroskademux ! vp9parse ! vp9harnessdec backend=dpb-validator ! fakesink
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvp9harnessdec.h"
+
+#include <gst/codecs/gstvp9decoder.h>
+
+#include "gstcodecharness.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_vp9_harness_dec_debug);
+#define GST_CAT_DEFAULT gst_vp9_harness_dec_debug
+
+struct _GstVp9HarnessDec
+{
+  GstVp9Decoder parent;
+
+  GstCodecHarness harness;
+};
+
+struct _GstVp9HarnessDecClass
+{
+  GstVp9DecoderClass parent_class;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9, alignment = (string) frame"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS (GST_CODEC_HARNESS_SRC_CAPS));
+
+#define gst_vp9_harness_dec_parent_class parent_class
+G_DEFINE_TYPE (GstVp9HarnessDec, gst_vp9_harness_dec, GST_TYPE_VP9_DECODER);
+
+static void gst_vp9_harness_dec_finalize (GObject * object);
+static void gst_vp9_harness_dec_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_vp9_harness_dec_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_vp9_harness_dec_open (GstVideoDecoder * decoder);
+static gboolean gst_vp9_harness_dec_close (GstVideoDecoder * decoder);
+static gboolean gst_vp9_harness_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_vp9_harness_dec_finish (GstVideoDecoder * decoder);
+
+/* GstVp9Decoder */
+static GstFlowReturn gst_vp9_harness_dec_new_sequence (GstVp9Decoder *
+    decoder, const GstVp9FrameHeader * frame_hdr);
+static GstFlowReturn gst_vp9_harness_dec_new_picture (GstVp9Decoder *
+    decoder, GstVideoCodecFrame * frame, GstVp9Picture * picture);
+static GstVp9Picture *gst_vp9_harness_dec_duplicate_picture (GstVp9Decoder *
+    decoder, GstVideoCodecFrame * frame, GstVp9Picture * picture);
+static GstFlowReturn gst_vp9_harness_dec_start_picture (GstVp9Decoder *
+    decoder, GstVp9Picture * picture);
+static GstFlowReturn gst_vp9_harness_dec_decode_picture (GstVp9Decoder *
+    decoder, GstVp9Picture * picture, GstVp9Dpb * dpb);
+static GstFlowReturn gst_vp9_harness_dec_end_picture (GstVp9Decoder *
+    decoder, GstVp9Picture * picture);
+static GstFlowReturn gst_vp9_harness_dec_output_picture (GstVp9Decoder *
+    decoder, GstVideoCodecFrame * frame, GstVp9Picture * picture);
+
+static void
+gst_vp9_harness_dec_class_init (GstVp9HarnessDecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstVp9DecoderClass *vp9decoder_class = GST_VP9_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_vp9_harness_dec_finalize;
+  object_class->set_property = gst_vp9_harness_dec_set_property;
+  object_class->get_property = gst_vp9_harness_dec_get_property;
+
+  gst_codec_harness_install_properties (object_class);
+
+  gst_element_class_set_static_metadata (element_class,
+      "VP9 Stateless Decoder Harness", "Codec/Decoder/Video",
+      "Drives the VP9 decoder base class without decoding hardware",
+      "icetana");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_close);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_flush);
+  decoder_class->finish = GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_finish);
+
+  vp9decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_new_sequence);
+  vp9decoder_class->new_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_new_picture);
+  vp9decoder_class->duplicate_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_duplicate_picture);
+  vp9decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_start_picture);
+  vp9decoder_class->decode_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_decode_picture);
+  vp9decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_end_picture);
+  vp9decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_vp9_harness_dec_output_picture);
+
+  GST_DEBUG_CATEGORY_INIT (gst_vp9_harness_dec_debug,
+      "vp9harnessdec", 0, "VP9 Stateless Decoder Harness");
+}
+
+static void
+gst_vp9_harness_dec_init (GstVp9HarnessDec * self)
+{
+  gst_codec_harness_init (&self->harness, GST_ELEMENT (self));
+}
+
+static void
+gst_vp9_harness_dec_finalize (GObject * object)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (object);
+
+  gst_codec_harness_clear (&self->harness);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_vp9_harness_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_set_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_vp9_harness_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (object);
+
+  if (!gst_codec_harness_get_property (&self->harness, prop_id, value))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_vp9_harness_dec_open (GstVideoDecoder * decoder)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_open (&self->harness);
+}
+
+static gboolean
+gst_vp9_harness_dec_close (GstVideoDecoder * decoder)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+
+  gst_codec_harness_close (&self->harness);
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_harness_dec_flush (GstVideoDecoder * decoder)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  gboolean ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+  gst_codec_harness_flush (&self->harness);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_finish (GstVideoDecoder * decoder)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstFlowReturn ret;
+
+  ret = GST_VIDEO_DECODER_CLASS (parent_class)->finish (decoder);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  return gst_codec_harness_finish (&self->harness);
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_new_sequence (GstVp9Decoder * decoder,
+    const GstVp9FrameHeader * frame_hdr)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+
+  return gst_codec_harness_new_sequence (&self->harness, decoder->input_state,
+      frame_hdr->width, frame_hdr->height, frame_hdr->bit_depth,
+      GST_VP9_REF_FRAMES);
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_new_picture (GstVp9Decoder * decoder,
+    GstVideoCodecFrame * frame, GstVp9Picture * picture)
+{
+  GstCodecHarnessPicture *hpic;
+
+  hpic = gst_codec_harness_picture_new (frame->system_frame_number);
+  /* hidden frames are only shown later through show_existing_frame */
+  hpic->needed_for_output = picture->frame_hdr.show_frame;
+
+  gst_vp9_picture_set_user_data (picture, hpic, (GDestroyNotify) g_free);
+
+  return GST_FLOW_OK;
+}
+
+static GstVp9Picture *
+gst_vp9_harness_dec_duplicate_picture (GstVp9Decoder * decoder,
+    GstVideoCodecFrame * frame, GstVp9Picture * picture)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+  GstVp9Picture *new_picture;
+
+  hpic = (GstCodecHarnessPicture *) gst_vp9_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "Parent picture does not have harness picture");
+    return NULL;
+  }
+
+  new_picture = gst_vp9_picture_new ();
+  new_picture->frame_hdr = picture->frame_hdr;
+
+  gst_vp9_picture_set_user_data (new_picture,
+      gst_codec_harness_picture_duplicate (hpic), (GDestroyNotify) g_free);
+
+  return new_picture;
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_start_picture (GstVp9Decoder * decoder,
+    GstVp9Picture * picture)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+
+  hpic = (GstCodecHarnessPicture *) gst_vp9_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* VP9 has no reordering, pictures are output in decoding order */
+  return gst_codec_harness_start_picture (&self->harness, hpic,
+      hpic->system_frame_number, FALSE);
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_decode_picture (GstVp9Decoder * decoder,
+    GstVp9Picture * picture, GstVp9Dpb * dpb)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+
+  hpic = (GstCodecHarnessPicture *) gst_vp9_picture_get_user_data (picture);
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_decode_slice (&self->harness, hpic, picture->size);
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_end_picture (GstVp9Decoder * decoder,
+    GstVp9Picture * picture)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+
+  hpic = (GstCodecHarnessPicture *) gst_vp9_picture_get_user_data (picture);
+  if (!hpic)
+    return GST_FLOW_ERROR;
+
+  return gst_codec_harness_end_picture (&self->harness, hpic);
+}
+
+static GstFlowReturn
+gst_vp9_harness_dec_output_picture (GstVp9Decoder * decoder,
+    GstVideoCodecFrame * frame, GstVp9Picture * picture)
+{
+  GstVp9HarnessDec *self = GST_VP9_HARNESS_DEC (decoder);
+  GstCodecHarnessPicture *hpic;
+  GstFlowReturn ret;
+
+  hpic = (GstCodecHarnessPicture *) gst_vp9_picture_get_user_data (picture);
+  if (!hpic) {
+    GST_ERROR_OBJECT (self, "No harness picture in picture %p", picture);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (decoder), frame);
+    gst_vp9_picture_unref (picture);
+    return GST_FLOW_ERROR;
+  }
+
+  /* a shown existing frame is output in the order of the frame showing it */
+  hpic->order = frame->system_frame_number;
+
+  ret = gst_codec_harness_output_picture (&self->harness, frame, hpic);
+  gst_vp9_picture_unref (picture);
+
+  return ret;
+}
@@ -0,0 +1,38 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VP9_HARNESS_DEC_H__
+#define __GST_VP9_HARNESS_DEC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VP9_HARNESS_DEC            (gst_vp9_harness_dec_get_type())
+#define GST_VP9_HARNESS_DEC(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_VP9_HARNESS_DEC, GstVp9HarnessDec))
+#define GST_VP9_HARNESS_DEC_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),  GST_TYPE_VP9_HARNESS_DEC, GstVp9HarnessDecClass))
+#define GST_VP9_HARNESS_DEC_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj),  GST_TYPE_VP9_HARNESS_DEC, GstVp9HarnessDecClass))
+
+typedef struct _GstVp9HarnessDec GstVp9HarnessDec;
+typedef struct _GstVp9HarnessDecClass GstVp9HarnessDecClass;
+
+GType gst_vp9_harness_dec_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_VP9_HARNESS_DEC_H__ */
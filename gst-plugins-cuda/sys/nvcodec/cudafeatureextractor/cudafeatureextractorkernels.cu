@@ -13,21 +13,111 @@ typedef struct _FrameDimensions
     size_t height;
 } FrameDimensions;
 
+/*
+ * The number of features of GstAlgorithmFeature, and the number of feature
+ * planes including the spatial magnitude.
+ */
+#define ALGORITHM_NUMBER_OF_FEATURES 6
+#define ALGORITHM_NUMBER_OF_PLANES (1 + ALGORITHM_NUMBER_OF_FEATURES)
+
+/*
+ * The indices of the features of GstAlgorithmFeature.
+ */
+#define ALGORITHM_FEATURE_COUNT 0
+#define ALGORITHM_FEATURE_PIXELS 1
+#define ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE 2
+#define ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE 3
+#define ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE 4
+#define ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE 5
+
+/*
+ * Calculates the spatial magnitude, in plane 0, and the features of
+ * GstAlgorithmFeature, in plane N + 1, of a single flow vector.
+ */
+__device__ __forceinline__ void gst_cuda_feature_extractor_pixel_features(
+    const float flow_vector_x,
+    const float flow_vector_y,
+    const float flow_vector_threshold,
+    float *pixel_features)
+{
+    bool flow_vector_x_qualifies
+        = flow_vector_x * flow_vector_x > flow_vector_threshold;
+    bool flow_vector_y_qualifies
+        = flow_vector_y * flow_vector_y > flow_vector_threshold;
+
+    if(flow_vector_x_qualifies)
+    {
+        if(flow_vector_x >= 0)
+        {
+            pixel_features[1 + ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE]
+                = flow_vector_x;
+        }
+        else
+        {
+            pixel_features[1 + ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE]
+                = -flow_vector_x;
+        }
+    }
+
+    if(flow_vector_y_qualifies)
+    {
+        if(flow_vector_y >= 0)
+        {
+            pixel_features[1 + ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE]
+                = flow_vector_y;
+        }
+        else
+        {
+            pixel_features[1 + ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE]
+                = -flow_vector_y;
+        }
+    }
+
+    pixel_features[0]
+        = pixel_features[1 + ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE]
+          + pixel_features[1 + ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE]
+          + pixel_features[1 + ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE]
+          + pixel_features[1 + ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE];
+    pixel_features[1 + ALGORITHM_FEATURE_COUNT]
+        = (flow_vector_x_qualifies || flow_vector_y_qualifies) ? 1.0f : 0.0f;
+    pixel_features[1 + ALGORITHM_FEATURE_PIXELS] = 1.0f;
+}
+
 extern "C" __global__ void gst_cuda_feature_extractor_kernel(
     const CUDA2DPitchedArray flow_vector_matrix,
     const FrameDimensions frame_dimensions,
     const int flow_vector_grid_size,
     const float flow_vector_threshold,
-    CUDA2DPitchedArray flow_features_matrix)
+    const unsigned int feature_mask,
+    const unsigned int dimensions_multiplier,
+    const unsigned int features_matrix_width,
+    const unsigned int features_matrix_height,
+    float *flow_features)
 {
     unsigned int y_frame_idx = (((blockIdx.y * blockDim.y) + threadIdx.y));
     unsigned int x_frame_idx = (((blockIdx.x * blockDim.x) + threadIdx.x));
     unsigned int y_idx = (y_frame_idx / flow_vector_grid_size);
     unsigned int x_idx = (x_frame_idx / flow_vector_grid_size);
+    unsigned int thread_idx = threadIdx.y * blockDim.x + threadIdx.x;
+    unsigned int number_of_threads = blockDim.x * blockDim.y;
 
-    __shared__ float block_spatial_magnitude;
+    /*
+     * Plane 0 holds the spatial magnitude, plane N + 1 the feature N of
+     * GstAlgorithmFeature. The spatial magnitude is always extracted.
+     */
+    unsigned int plane_mask = 1u | (feature_mask << 1);
+    float pixel_features[ALGORITHM_NUMBER_OF_PLANES] = {
+        0.0f,
+    };
 
-    atomicExch(&block_spatial_magnitude, 0.0f);
+    __shared__ float block_features[ALGORITHM_NUMBER_OF_PLANES];
+
+    /* A block may have fewer threads than there are planes */
+    for(unsigned int plane = thread_idx; plane < ALGORITHM_NUMBER_OF_PLANES;
+        plane += number_of_threads)
+    {
+        block_features[plane] = 0.0f;
+    }
 
     __syncthreads();
 
@@ -68,86 +158,204 @@ extern "C" __global__ void gst_cuda_feature_extractor_kernel(
                 break;
         }
 
-        float flow_vector_x_squared = flow_vector_x * flow_vector_x;
-        float flow_vector_y_squared = flow_vector_y * flow_vector_y;
-
-        if(flow_vector_x_squared > flow_vector_threshold)
-        {
-            if(flow_vector_x >= 0)
-            {
-                atomicAdd((float *)&block_spatial_magnitude, flow_vector_x);
-            }
-            else
-            {
-                atomicAdd((float *)&block_spatial_magnitude, -flow_vector_x);
-            }
-        }
+        gst_cuda_feature_extractor_pixel_features(
+            flow_vector_x, flow_vector_y, flow_vector_threshold, pixel_features);
+    }
 
-        if(flow_vector_y_squared > flow_vector_threshold)
+    /*
+     * The loop is unrolled, so that the features stay in registers and the
+     * mask test is uniform across the block; a feature that is not selected
+     * costs neither a shared nor a global atomic.
+     */
+#pragma unroll
+    for(unsigned int plane = 0; plane < ALGORITHM_NUMBER_OF_PLANES; plane++)
+    {
+        if((plane_mask & (1u << plane)) && pixel_features[plane] != 0.0f)
         {
-            if(flow_vector_y >= 0)
-            {
-                atomicAdd((float *)&block_spatial_magnitude, flow_vector_y);
-            }
-            else
-            {
-                atomicAdd((float *)&block_spatial_magnitude, -flow_vector_y);
-            }
+            atomicAdd(&block_features[plane], pixel_features[plane]);
         }
     }
 
     __syncthreads();
 
-    if(threadIdx.y + 1 == blockDim.y && threadIdx.x + 1 == blockDim.x)
+    /*
+     * Each block is one cell of the features matrix before consolidation, so
+     * the consolidation is done here by adding the block's features straight
+     * into the cell of the consolidated features matrix it belongs to. The
+     * selected features are packed, so plane N + 1 is stored after the number
+     * of selected features before it.
+     */
+    unsigned int feature_idx
+        = (blockIdx.y / dimensions_multiplier) * features_matrix_width
+          + (blockIdx.x / dimensions_multiplier);
+
+    for(unsigned int plane = thread_idx; plane < ALGORITHM_NUMBER_OF_PLANES;
+        plane += number_of_threads)
     {
-        unsigned int y_block_offset_index
-            = blockIdx.y * flow_features_matrix.pitch;
-        float *flow_spatial_feature
-            = (float
-                   *)((char *)(flow_features_matrix.device_ptr) + y_block_offset_index)
-              + blockIdx.x;
-        *flow_spatial_feature = block_spatial_magnitude;
+        if((plane_mask & (1u << plane)) && block_features[plane] != 0.0f)
+        {
+            unsigned int packed_plane
+                = __popc(plane_mask & ((1u << plane) - 1u));
+
+            atomicAdd(
+                &flow_features
+                    [packed_plane * features_matrix_width
+                         * features_matrix_height
+                     + feature_idx],
+                block_features[plane]);
+        }
     }
 }
 
-extern "C" __global__ void gst_cuda_feature_consolidation_kernel(
-    const CUDA2DPitchedArray flow_spatial_feature_matrix,
-    CUDA2DPitchedArray consolidated_flow_spatial_feature_matrix)
+extern "C" __global__ void gst_cuda_feature_extractor_roi_kernel(
+    const CUDA2DPitchedArray flow_vector_matrix,
+    const FrameDimensions frame_dimensions,
+    const int flow_vector_grid_size,
+    const float flow_vector_threshold,
+    const unsigned int feature_mask,
+    const CUDA2DPitchedArray roi_mask_matrix,
+    const unsigned int *active_tiles,
+    const unsigned int tiles_per_row,
+    const unsigned int dimensions_multiplier,
+    const unsigned int features_matrix_width,
+    const unsigned int features_matrix_height,
+    const unsigned int number_of_rois,
+    float *flow_features)
 {
-    unsigned int y_idx = ((blockIdx.y * blockDim.y) + threadIdx.y);
-    unsigned int x_idx = ((blockIdx.x * blockDim.x) + threadIdx.x);
+    extern __shared__ float block_features[];
 
-    __shared__ float consolidated_block_spatial_magnitude;
+    unsigned int tile_idx = active_tiles[blockIdx.x];
+    unsigned int tile_x = tile_idx % tiles_per_row;
+    unsigned int tile_y = tile_idx / tiles_per_row;
+    unsigned int y_frame_idx = ((tile_y * blockDim.y) + threadIdx.y);
+    unsigned int x_frame_idx = ((tile_x * blockDim.x) + threadIdx.x);
+    unsigned int y_idx = (y_frame_idx / flow_vector_grid_size);
+    unsigned int x_idx = (x_frame_idx / flow_vector_grid_size);
+    unsigned int thread_idx = threadIdx.y * blockDim.x + threadIdx.x;
+    unsigned int number_of_threads = blockDim.x * blockDim.y;
 
-    atomicExch(&consolidated_block_spatial_magnitude, 0.0f);
+    /*
+     * Plane 0 holds the spatial magnitude of the union of the regions, plane
+     * N + 1 the spatial magnitude of the region with the bit N in the
+     * membership mask. The selected features of the union of the regions are
+     * packed after them.
+     */
+    unsigned int number_of_planes = 1 + number_of_rois + __popc(feature_mask);
+    float pixel_features[ALGORITHM_NUMBER_OF_PLANES] = {
+        0.0f,
+    };
+
+    for(unsigned int plane = thread_idx; plane < number_of_planes;
+        plane += number_of_threads)
+    {
+        block_features[plane] = 0.0f;
+    }
 
     __syncthreads();
 
-    if(y_idx < flow_spatial_feature_matrix.height
-       && x_idx < (flow_spatial_feature_matrix.width / sizeof(float)))
+    if(y_frame_idx < frame_dimensions.height
+       && x_frame_idx < frame_dimensions.width
+       && y_idx < flow_vector_matrix.height
+       && x_idx < (flow_vector_matrix.width / flow_vector_matrix.elem_size))
     {
-        unsigned int y_offset_index = y_idx * flow_spatial_feature_matrix.pitch;
-        float *original_flow_spatial_feature
-            = ((float
-                    *)((char *)(flow_spatial_feature_matrix.device_ptr) + y_offset_index)
-               + x_idx);
-
-        atomicAdd(
-            (float *)(&consolidated_block_spatial_magnitude),
-            *original_flow_spatial_feature);
+        unsigned int membership
+            = ((unsigned int *)((char *)(roi_mask_matrix.device_ptr)
+                                + y_frame_idx * roi_mask_matrix.pitch))
+                [x_frame_idx];
+
+        if(membership != 0)
+        {
+            unsigned int y_offset_index = y_idx * flow_vector_matrix.pitch;
+
+            float flow_vector_x = 0.0;
+            float flow_vector_y = 0.0;
+
+            switch(flow_vector_matrix.elem_size)
+            {
+                case sizeof(short2):
+                    {
+                        short2 *flow_vectors
+                            = (short2
+                                   *)((char *)(flow_vector_matrix.device_ptr) + y_offset_index)
+                              + x_idx;
+
+                        flow_vector_x
+                            = (float)(flow_vectors->x / (float)(1 << 5));
+                        flow_vector_y
+                            = (float)(flow_vectors->y / (float)(1 << 5));
+                    }
+                    break;
+                case sizeof(float2):
+                    {
+                        float2 *flow_vectors
+                            = (float2
+                                   *)((char *)(flow_vector_matrix.device_ptr) + y_offset_index)
+                              + x_idx;
+                        flow_vector_x = flow_vectors->x;
+                        flow_vector_y = flow_vectors->y;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            gst_cuda_feature_extractor_pixel_features(
+                flow_vector_x,
+                flow_vector_y,
+                flow_vector_threshold,
+                pixel_features);
+
+            if(pixel_features[0] > 0.0f)
+            {
+                atomicAdd(&block_features[0], pixel_features[0]);
+
+                while(membership != 0)
+                {
+                    atomicAdd(
+                        &block_features[__ffs(membership)], pixel_features[0]);
+                    membership &= membership - 1;
+                }
+            }
+        }
+    }
+
+    /* As in the feature extractor kernel, the mask test is uniform */
+#pragma unroll
+    for(unsigned int feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES;
+        feature++)
+    {
+        if((feature_mask & (1u << feature))
+           && pixel_features[1 + feature] != 0.0f)
+        {
+            atomicAdd(
+                &block_features
+                    [1 + number_of_rois
+                     + __popc(feature_mask & ((1u << feature) - 1u))],
+                pixel_features[1 + feature]);
+        }
     }
 
     __syncthreads();
 
-    if(threadIdx.y + 1 == blockDim.y && threadIdx.x + 1 == blockDim.x)
-    {
+    /*
+     * Each tile is one cell of the features matrix before consolidation, so
+     * the cell of the consolidated features matrix it belongs to is found by
+     * dividing by the dimensions multiplier.
+     */
+    unsigned int feature_idx
+        = (tile_y / dimensions_multiplier) * features_matrix_width
+          + (tile_x / dimensions_multiplier);
 
-        unsigned int y_block_offset_index
-            = blockIdx.y * consolidated_flow_spatial_feature_matrix.pitch;
-        float *flow_spatial_feature
-            = (float
-                   *)((char *)(consolidated_flow_spatial_feature_matrix.device_ptr) + y_block_offset_index)
-              + blockIdx.x;
-        *flow_spatial_feature = consolidated_block_spatial_magnitude;
+    for(unsigned int plane = thread_idx; plane < number_of_planes;
+        plane += number_of_threads)
+    {
+        if(block_features[plane] != 0.0f)
+        {
+            atomicAdd(
+                &flow_features
+                    [plane * features_matrix_width * features_matrix_height
+                     + feature_idx],
+                block_features[plane]);
+        }
     }
 }
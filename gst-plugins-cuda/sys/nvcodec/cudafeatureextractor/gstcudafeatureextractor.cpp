@@ -31,15 +31,22 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <glib-object.h>
 #include <glibconfig.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeatureswindow.h>
 #include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeaturesstats.h>
+#include <gst/cuda/of/gstcudaofroi.h>
 #include <gst/cuda/of/gstmetaopticalflow.h>
 #include <gst/gst.h>
+#include <gst/video/gstvideometa.h>
 #include <opencv2/core/cuda.hpp>
 #include <opencv2/cudaoptflow.hpp>
+#include <opencv2/imgcodecs.hpp>
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
@@ -74,8 +81,8 @@ GST_DEBUG_CATEGORY_STATIC(gst_cuda_feature_extractor_debug);
 #endif
 
 #define GST_CUDA_FEATURE_EXTRACTOR_KERNEL "gst_cuda_feature_extractor_kernel"
-#define GST_CUDA_FEATURE_CONSOLIDATION_KERNEL \
-    "gst_cuda_feature_consolidation_kernel"
+#define GST_CUDA_FEATURE_EXTRACTOR_ROI_KERNEL \
+    "gst_cuda_feature_extractor_roi_kernel"
 
 /****************************** Static Variables ******************************/
 
@@ -107,6 +114,14 @@ static const gint default_device_id = -1;
  */
 static const gboolean default_enable_debug = FALSE;
 
+/**
+ * \brief The default setting for the feature-mask property.
+ *
+ * \notes By default, all 6 features are extracted alongside the spatial
+ * magnitude.
+ */
+static const guint default_feature_mask = ALGORITHM_FEATURE_FLAGS_ALL;
+
 /**
  * \brief The default setting for the features-matrix-height property.
  */
@@ -136,6 +151,32 @@ static const gchar *default_kernel_source_location
  */
 static const gfloat default_magnitude_quadrant_threshold_squared = 2.25f;
 
+/**
+ * \brief The default setting for the roi-from-meta property.
+ */
+static const gboolean default_roi_from_meta = FALSE;
+
+/**
+ * \brief The default setting for the roi-mask-location property.
+ *
+ * \notes By default, no bitmask is loaded.
+ */
+static const gchar *default_roi_mask_location = NULL;
+
+/**
+ * \brief The default setting for the roi-polygons property.
+ *
+ * \notes By default, no polygons are used.
+ */
+static const gchar *default_roi_polygons = NULL;
+
+/**
+ * \brief The default setting for the statistics-window-size property.
+ *
+ * \notes By default, no statistics are calculated.
+ */
+static const guint default_statistics_window_size = 0u;
+
 /**
  * \brief The maximum multiplier for the features matrix dimensions prior to
  * being accumulated down to the requested features matrix dimensions.
@@ -172,6 +213,11 @@ enum
      */
     PROP_ENABLE_DEBUG,
 
+    /**
+     * ID number for the feature-mask property.
+     */
+    PROP_FEATURE_MASK,
+
     /**
      * ID number for the features-matrix-height property.
      */
@@ -192,6 +238,26 @@ enum
      */
     PROP_MAGNITUDE_QUADRANT_THRESHOLD_SQUARED,
 
+    /**
+     * ID number for the roi-from-meta flag property.
+     */
+    PROP_ROI_FROM_META,
+
+    /**
+     * ID number for the roi-mask-location property.
+     */
+    PROP_ROI_MASK_LOCATION,
+
+    /**
+     * ID number for the roi-polygons property.
+     */
+    PROP_ROI_POLYGONS,
+
+    /**
+     * ID number for the statistics-window-size property.
+     */
+    PROP_STATISTICS_WINDOW_SIZE,
+
     /**
      * \brief Number of property ID numbers in this enum.
      */
@@ -360,6 +426,15 @@ typedef struct _GstCudaFeatureExtractor
      */
     gboolean enable_debug;
 
+    /**
+     * \brief The GstAlgorithmFeatureFlags of the features extracted alongside
+     * the spatial magnitude.
+     *
+     * \details The features that are not selected are skipped by the feature
+     * extractor kernel, and are neither copied to host memory nor attached.
+     */
+    guint feature_mask;
+
     /**
      * \brief The number of rows in the features matrix extracted by the
      * plugin.
@@ -374,7 +449,7 @@ typedef struct _GstCudaFeatureExtractor
 
     /**
      * \brief The path to the file containing the source code for the feature
-     * extractor & consolidator CUDA kernels.
+     * extractor CUDA kernels.
      */
     gchar *kernel_source_location;
 
@@ -396,6 +471,34 @@ typedef struct _GstCudaFeatureExtractor
      *   negative, its value is added to the Y1ToY0Magnitude feature.
      */
     gfloat magnitude_quadrant_threshold_squared;
+
+    /**
+     * \brief A flag that determines if the GstVideoRegionOfInterestMeta
+     * instances attached to each buffer are used as regions of interest.
+     */
+    gboolean roi_from_meta;
+
+    /**
+     * \brief The path to an 8-bit image used as a bitmask of regions of
+     * interest, or NULL.
+     *
+     * \details Each distinct non-zero value of the image is a region, with
+     * the value as its ID. The image is scaled to the frame.
+     */
+    gchar *roi_mask_location;
+
+    /**
+     * \brief A list of polygons used as regions of interest, or NULL.
+     *
+     * \details See gst_cuda_of_roi_set_parse_polygons() for the format.
+     */
+    gchar *roi_polygons;
+
+    /**
+     * \brief The number of frames the statistics of the features are
+     * calculated over, or 0 if they are not calculated.
+     */
+    guint statistics_window_size;
 } GstCudaFeatureExtractor;
 
 /*
@@ -408,7 +511,7 @@ typedef struct _GstCudaFeatureExtractorPrivate
 
     /**
      * \brief The run-time compiled CUDA kernel module containing the
-     * feature-extractor & feature-consolidator kernels.
+     * feature-extractor kernels.
      */
     CUmodule cuda_module;
 
@@ -424,16 +527,107 @@ typedef struct _GstCudaFeatureExtractorPrivate
     CUfunction feature_extractor_kernel;
 
     /**
-     * \brief A pointer to the CUDA kernel function for the
-     * feature-consolidator.
+     * \brief The consolidated features of the frame, with the spatial
+     * magnitude followed by each selected feature.
+     *
+     * \details This is kept between frames, so that it is only allocated
+     * again if the features matrix or the feature mask change.
+     */
+    cv::cuda::GpuMat *features;
+
+    /**
+     * \brief The host copy of the features of the most recent frame, of the
+     * whole frame or of the regions of interest.
+     *
+     * \details This is kept between frames, so that downloading the features
+     * does not allocate.
+     */
+    cv::Mat *host_features;
+
+    /**
+     * \brief The pool of slabs holding the features of the
+     * GstMetaAlgorithmFeatures instances, or NULL if none were extracted yet.
+     *
+     * \details The pool is only created again if the size of the features
+     * changes, so that the slabs of the buffers that were released are reused
+     * for the next frames.
      */
-    CUfunction feature_consolidator_kernel;
+    GstAlgorithmFeaturesPool *features_pool;
 
     /**
      * \brief The timestamp of the most recent frame that has been processed by
      * the feature extractor plugin.
      */
     GstClockTime frame_timestamp;
+
+    /**
+     * \brief A pointer to the CUDA kernel function for the feature-extractor
+     * restricted to regions of interest.
+     */
+    CUfunction feature_extractor_roi_kernel;
+
+    /**
+     * \brief The regions of interest loaded from the roi-mask-location and
+     * roi-polygons properties on start, or NULL if there are none.
+     */
+    GstCudaOfRoiSet *static_roi_set;
+
+    /**
+     * \brief The regions of interest the membership mask and the list of
+     * active tiles were last prepared for, or NULL if there are none.
+     *
+     * \details The membership mask and the list of tiles are only prepared
+     * again if the regions, the frame or the tiles change, which for static
+     * regions is once per stream.
+     */
+    GstCudaOfRoiSet *roi_set;
+    guint roi_frame_width;
+    guint roi_frame_height;
+    guint roi_tile_width;
+    guint roi_tile_height;
+
+    /**
+     * \brief The membership mask of the regions of interest, with one 32-bit
+     * mask per pixel of the frame.
+     */
+    cv::cuda::GpuMat *roi_mask;
+
+    /**
+     * \brief The indices of the tiles containing any region of interest, and
+     * the number of them.
+     */
+    cv::cuda::GpuMat *roi_tiles;
+    guint roi_number_of_tiles;
+
+    /**
+     * \brief The features of the union of the regions of interest, followed
+     * by the features of each region.
+     */
+    cv::cuda::GpuMat *roi_features;
+
+    /**
+     * \brief The sliding window of the features of the most recent frames, or
+     * NULL if no statistics were calculated yet.
+     *
+     * \details The window is only created again if the layout of the
+     * features changes, and is emptied on a discontinuity.
+     */
+    GstAlgorithmFeaturesWindow *statistics_window;
+
+    /**
+     * \brief The layout of the features the sliding window was created for.
+     */
+    guint statistics_features_matrix_width;
+    guint statistics_features_matrix_height;
+    guint statistics_feature_mask;
+    guint statistics_number_of_rois;
+
+    /**
+     * \brief The pool of slabs holding the statistics of the
+     * GstMetaAlgorithmFeaturesStats instances, or NULL if none were
+     * calculated yet.
+     */
+    GstAlgorithmFeaturesPool *statistics_pool;
 } GstCudaFeatureExtractorPrivate;
 
 /**
@@ -526,6 +720,18 @@ class GstCudaException : public std::logic_error
 
 /*************************** Function Declarations ****************************/
 
+/**
+ * \brief Releases the regions of interest and the GPU memory prepared for
+ * them.
+ *
+ * \param[in,out] self A GstCudaFeatureExtractor GObject instance to release
+ * the regions of interest from.
+ *
+ * \notes The CUDA context must be pushed before calling this method.
+ */
+static void
+gst_cuda_feature_extractor_clear_roi_set(GstCudaFeatureExtractor *self);
+
 /**
  * \brief Calculate the multiplier value for the initial features matrix.
  *
@@ -550,6 +756,27 @@ static gsize gst_cuda_feature_extractor_calculate_dimensions_multiplier(
     const gsize features_matrix_width,
     const gsize features_matrix_height);
 
+/**
+ * \brief Retrieves a pool of slabs for the features or the statistics
+ * metadata.
+ *
+ * \details The pool is created again if its slabs are not of the given size,
+ * e.g. if the features matrix, the feature mask or the number of regions of
+ * interest change. The buffers holding slabs of the previous pool keep it
+ * alive until they are released.
+ *
+ * \param[in] self A GstCudaFeatureExtractor GObject instance to get the pool
+ * for.
+ * \param[in,out] pool The pool held by self, e.g. the features pool.
+ * \param[in] slab_size The number of bytes of each slab.
+ *
+ * \returns The pool, owned by self.
+ */
+static GstAlgorithmFeaturesPool *gst_cuda_feature_extractor_get_features_pool(
+    GstCudaFeatureExtractor *self,
+    GstAlgorithmFeaturesPool **pool,
+    gsize slab_size);
+
 /**
  * \brief Disposal method for the GstCudaFeatureExtractor GObject type.
  *
@@ -565,26 +792,63 @@ static void gst_cuda_feature_extractor_dispose(GObject *gobject);
 /**
  * \brief Extracts features from optical flow metadata.
  *
- * \details Using the loaded feature-extractor and feature-consolidator
- * kernels, the spatial (magnitude) features are extracted from the optical
- * flow matrix stored in the optical flow metadata. The features are copied
- * from GPU to host memory, then stored within a GArray instance to be stored
- * within a GstMetaAlgorithmFeatures metadata instance.
+ * \details Using the loaded feature-extractor kernel, the spatial (magnitude)
+ * features and the features selected by the feature-mask property are
+ * extracted from the optical flow matrix stored in the optical flow metadata
+ * in a single pass, with the consolidation happening within the same kernel
+ * launch. The features are copied from GPU to host memory, then aggregated
+ * into a slab from the features pool held by a GstMetaAlgorithmFeatures
+ * metadata instance.
  *
  * \param[in] self A GstCudaFeatureExtractor GObject instance to get various
  * parameters and handles needed to perform the feature extraction procedure.
  * \param[in] frame The current frame being processed by the plugin.
  * \param[in] optical_flow_metadata The GstMetaOpticalFlow instance to extract
  * the optical flow matrix from.
+ * \param[out] algorithm_features_metadata The GstMetaAlgorithmFeatures
+ * instance to store the features within.
  *
- * \returns A reference to a GArray instance. Alternatively, NULL will be
- * returned if an error occurs during the
- * feature-extraction/feature-consolidation procedures.
+ * \returns TRUE if the features were extracted, FALSE if an error occurs
+ * during the feature-extraction procedure.
  */
-static GArray *gst_cuda_feature_extractor_extract_features(
+static gboolean gst_cuda_feature_extractor_extract_features(
     GstCudaFeatureExtractor *self,
     const GstVideoFrame *frame,
-    const GstMetaOpticalFlow *optical_flow_metadata);
+    const GstMetaOpticalFlow *optical_flow_metadata,
+    GstMetaAlgorithmFeatures *algorithm_features_metadata);
+
+/**
+ * \brief Extracts features from optical flow metadata for regions of
+ * interest.
+ *
+ * \details Using the loaded region of interest feature-extractor kernel, the
+ * spatial (magnitude) features are extracted for the union of the regions and
+ * for each region separately, and the features selected by the feature-mask
+ * property for the union of the regions. The kernel is only launched over the
+ * tiles of the frame containing a region, so the cost scales with the area of
+ * the regions rather than the area of the frame. The consolidation happens
+ * within the same kernel launch.
+ *
+ * \param[in] self A GstCudaFeatureExtractor GObject instance to get various
+ * parameters and handles needed to perform the feature extraction procedure.
+ * \param[in] frame The current frame being processed by the plugin.
+ * \param[in] optical_flow_metadata The GstMetaOpticalFlow instance to extract
+ * the optical flow matrix from.
+ * \param[in] roi_set The regions of interest for the frame. Ownership of the
+ * set is taken by this method.
+ * \param[out] algorithm_features_metadata The GstMetaAlgorithmFeatures
+ * instance to store the features of the union of the regions, and of each
+ * region, within.
+ *
+ * \returns TRUE if the features were extracted, FALSE if an error occurs
+ * during the feature-extraction procedure.
+ */
+static gboolean gst_cuda_feature_extractor_extract_roi_features(
+    GstCudaFeatureExtractor *self,
+    const GstVideoFrame *frame,
+    const GstMetaOpticalFlow *optical_flow_metadata,
+    GstCudaOfRoiSet *roi_set,
+    GstMetaAlgorithmFeatures *algorithm_features_metadata);
 
 /**
  * \brief Wrapper around gst_cuda_feature_extractor_get_instance_private.
@@ -626,6 +890,37 @@ static void gst_cuda_feature_extractor_get_property(
     GValue *value,
     GParamSpec *pspec);
 
+/**
+ * \brief Gathers the regions of interest for a frame.
+ *
+ * \details The regions loaded from the roi-mask-location and roi-polygons
+ * properties are combined with the GstVideoRegionOfInterestMeta instances of
+ * the frame's buffer, if the roi-from-meta property is enabled.
+ *
+ * \param[in] self A GstCudaFeatureExtractor GObject instance to get the
+ * regions from.
+ * \param[in] frame The current frame being processed by the plugin.
+ *
+ * \returns A new GstCudaOfRoiSet instance to be freed by the caller, or NULL if
+ * there are no regions of interest and the whole frame is processed.
+ */
+static GstCudaOfRoiSet *gst_cuda_feature_extractor_get_roi_set(
+    GstCudaFeatureExtractor *self,
+    const GstVideoFrame *frame);
+
+/**
+ * \brief Loads the regions of interest from the roi-mask-location and
+ * roi-polygons properties.
+ *
+ * \param[in] self A GstCudaFeatureExtractor GObject instance to load the
+ * regions for.
+ *
+ * \returns TRUE if the regions were loaded, FALSE if the bitmask could not be
+ * read or the polygons could not be parsed.
+ */
+static gboolean
+gst_cuda_feature_extractor_load_roi_set(GstCudaFeatureExtractor *self);
+
 /**
  * \brief Debugging method to output features to the filesystem as JSON files.
  *
@@ -639,6 +934,9 @@ static void gst_cuda_feature_extractor_get_property(
  * \param[in] frame The current frame being processed by the plugin.
  * \param[in] algorithm_features_metadata The metadata containing the features
  * matrix that will be output by the plugin.
+ * \param[in] algorithm_features_stats_metadata The metadata containing the
+ * statistics of the features that will be output by the plugin, or NULL if
+ * there are none.
  *
  * \returns TRUE if outputting the features matrix to a JSON file was
  * successful. FALSE otherwise.
@@ -646,7 +944,8 @@ static void gst_cuda_feature_extractor_get_property(
 static gboolean gst_cuda_feature_extractor_output_features_json(
     GstCudaFeatureExtractor *self,
     const GstVideoFrame *frame,
-    const GstMetaAlgorithmFeatures *algorithm_features_metadata);
+    const GstMetaAlgorithmFeatures *algorithm_features_metadata,
+    const GstMetaAlgorithmFeaturesStats *algorithm_features_stats_metadata);
 
 /**
  * \brief Debugging method to output motion vectors to the filesystem as binary
@@ -768,6 +1067,35 @@ static GstFlowReturn gst_cuda_feature_extractor_transform_frame(
     GstVideoFrame *out_frame,
     GstCudaMemory *out_cuda_mem);
 
+/**
+ * \brief Pushes the features of the current frame into the sliding window,
+ * and attaches their statistics over the window as metadata to the buffer.
+ *
+ * \details The spatial magnitude and the selected features are pushed as the
+ * single block they are stored as in the GstMetaAlgorithmFeatures instance,
+ * so the mean, maximum and variance of every aggregate are updated in O(1)
+ * per aggregate, however large the window is. When regions of interest are
+ * used, the statistics cover the union of the regions.
+ *
+ * \details The window is emptied on a discontinuity, and created again if
+ * the layout of the features changes, so the statistics never mix frames
+ * that are not comparable.
+ *
+ * \param[in] self A GstCudaFeatureExtractor GObject instance holding the
+ * sliding window.
+ * \param[in] buffer The buffer of the current frame.
+ * \param[in] algorithm_features_metadata The features extracted for the
+ * current frame.
+ *
+ * \returns The GstMetaAlgorithmFeaturesStats instance attached to the buffer,
+ * or NULL if an error occurs.
+ */
+static GstMetaAlgorithmFeaturesStats *
+gst_cuda_feature_extractor_update_statistics(
+    GstCudaFeatureExtractor *self,
+    GstBuffer *buffer,
+    const GstMetaAlgorithmFeatures *algorithm_features_metadata);
+
 /**
  * \brief Opens a file for writting formatted metadata from the current buffer
  * into.
@@ -791,6 +1119,22 @@ static std::ofstream open_output_metadata_file(
     const GstVideoFrame *frame,
     const std::string &file_type);
 
+/**
+ * \brief Serialises the statistics of an array of features into a JSON
+ * object with a "Mean", a "Max" and a "Variance" array.
+ *
+ * \param[in] statistics The statistics of the array.
+ * \param[in] length The number of aggregates in the array.
+ * \param[in] allocator The allocator of the JSON document the object will be
+ * added to.
+ *
+ * \returns The JSON object.
+ */
+static rapidjson::Value statistics_to_json(
+    const GstAlgorithmFeaturesStatistics &statistics,
+    guint32 length,
+    rapidjson::Document::AllocatorType &allocator);
+
 /************************** GObject Type Definitions **************************/
 
 /*
@@ -813,11 +1157,6 @@ static inline guint ceil_div_guint(guint size, guint divisor)
     return ((size + divisor - 1) / (divisor));
 }
 
-static inline gsize ceil_div_gsize(gsize size, gsize divisor)
-{
-    return ((size + divisor - 1) / (divisor));
-}
-
 static gsize gst_cuda_feature_extractor_calculate_dimensions_multiplier(
     const gsize optical_flow_matrix_width,
     const gsize optical_flow_matrix_height,
@@ -900,6 +1239,27 @@ static gsize gst_cuda_feature_extractor_calculate_dimensions_multiplier(
     return dimensions_multiplier;
 }
 
+static void
+gst_cuda_feature_extractor_clear_roi_set(GstCudaFeatureExtractor *self)
+{
+    GstCudaFeatureExtractorPrivate *self_private
+        = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
+
+    gst_cuda_of_roi_set_free(self_private->static_roi_set);
+    self_private->static_roi_set = NULL;
+    gst_cuda_of_roi_set_free(self_private->roi_set);
+    self_private->roi_set = NULL;
+
+    delete self_private->roi_mask;
+    self_private->roi_mask = nullptr;
+    delete self_private->roi_tiles;
+    self_private->roi_tiles = nullptr;
+    delete self_private->roi_features;
+    self_private->roi_features = nullptr;
+
+    self_private->roi_number_of_tiles = 0;
+}
+
 /**
  * \brief Initialisation function for the GstCudaFeatureExtractorClass
  * GObjectClass type.
@@ -964,6 +1324,15 @@ gst_cuda_feature_extractor_class_init(GstCudaFeatureExtractorClass *klass)
         default_enable_debug,
         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    properties[PROP_FEATURE_MASK] = g_param_spec_flags(
+        "feature-mask",
+        "Feature Mask",
+        "Selects the features extracted alongside the spatial magnitude. The "
+        "features that are not selected are not calculated.",
+        GST_TYPE_ALGORITHM_FEATURE_FLAGS,
+        default_feature_mask,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
     properties[PROP_FEATURES_MATRIX_HEIGHT] = g_param_spec_uint(
         "features-matrix-height",
         "Features Matrix Height",
@@ -1002,6 +1371,45 @@ gst_cuda_feature_extractor_class_init(GstCudaFeatureExtractorClass *klass)
         default_magnitude_quadrant_threshold_squared,
         (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
 
+    properties[PROP_ROI_FROM_META] = g_param_spec_boolean(
+        "roi-from-meta",
+        "ROI From Meta",
+        "Uses the GstVideoRegionOfInterestMeta attached to each buffer as "
+        "regions of interest, in addition to roi-mask-location and "
+        "roi-polygons.",
+        default_roi_from_meta,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_ROI_MASK_LOCATION] = g_param_spec_string(
+        "roi-mask-location",
+        "ROI Mask Location",
+        "Specifies the filepath for an 8-bit image used as a bitmask of "
+        "regions of interest. Each distinct non-zero value is a region with "
+        "the value as its ID.",
+        default_roi_mask_location,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_ROI_POLYGONS] = g_param_spec_string(
+        "roi-polygons",
+        "ROI Polygons",
+        "Specifies polygons used as regions of interest, separated by "
+        "semicolons, with each vertex as x,y in pixels and an optional id: "
+        "prefix, e.g. \"0,0 320,0 320,240; 7: 10,10 50,10 50,50 10,50\". "
+        "Only the tiles containing a region are processed.",
+        default_roi_polygons,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_STATISTICS_WINDOW_SIZE] = g_param_spec_uint(
+        "statistics-window-size",
+        "Statistics Window Size",
+        "The number of most recent frames the mean, maximum and variance of "
+        "each feature are calculated over, attached as "
+        "GstMetaAlgorithmFeaturesStats. 0 disables the statistics.",
+        0,
+        G_MAXUINT16,
+        default_statistics_window_size,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
     g_object_class_install_properties(gobject_class, N_PROPERTIES, properties);
 
     gst_element_class_add_pad_template(
@@ -1031,6 +1439,30 @@ gst_cuda_feature_extractor_class_init(GstCudaFeatureExtractorClass *klass)
         = GST_DEBUG_FUNCPTR(gst_cuda_feature_extractor_transform_frame);
 }
 
+static GstAlgorithmFeaturesPool *gst_cuda_feature_extractor_get_features_pool(
+    GstCudaFeatureExtractor *self,
+    GstAlgorithmFeaturesPool **pool,
+    gsize slab_size)
+{
+    if(*pool != NULL
+       && gst_algorithm_features_pool_get_slab_size(*pool) != slab_size)
+    {
+        gst_algorithm_features_pool_unref(*pool);
+        *pool = NULL;
+    }
+
+    if(*pool == NULL)
+    {
+        GST_DEBUG_OBJECT(
+            self,
+            "Creating a pool with slabs of %" G_GSIZE_FORMAT " bytes",
+            slab_size);
+        *pool = gst_algorithm_features_pool_new(slab_size);
+    }
+
+    return *pool;
+}
+
 static void gst_cuda_feature_extractor_dispose(GObject *gobject)
 {
     GstCudaBaseTransform *filter = GST_CUDA_BASE_TRANSFORM(gobject);
@@ -1042,8 +1474,8 @@ static void gst_cuda_feature_extractor_dispose(GObject *gobject)
     {
         if(gst_cuda_context_push(filter->context))
         {
-            self_private->feature_consolidator_kernel = NULL;
             self_private->feature_extractor_kernel = NULL;
+            self_private->feature_extractor_roi_kernel = NULL;
 
             if(self_private->cuda_module != NULL)
             {
@@ -1051,10 +1483,37 @@ static void gst_cuda_feature_extractor_dispose(GObject *gobject)
                 self_private->cuda_module = NULL;
             }
 
+            delete self_private->features;
+            self_private->features = nullptr;
+            delete self_private->host_features;
+            self_private->host_features = nullptr;
+
+            gst_cuda_feature_extractor_clear_roi_set(self);
+
             gst_cuda_context_pop(NULL);
         }
     }
 
+    if(self_private->features_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(self_private->features_pool);
+        self_private->features_pool = NULL;
+    }
+
+    gst_algorithm_features_window_free(self_private->statistics_window);
+    self_private->statistics_window = NULL;
+
+    if(self_private->statistics_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(self_private->statistics_pool);
+        self_private->statistics_pool = NULL;
+    }
+
+    g_free(self->roi_mask_location);
+    self->roi_mask_location = NULL;
+    g_free(self->roi_polygons);
+    self->roi_polygons = NULL;
+
     if(G_OBJECT_CLASS(gst_cuda_feature_extractor_parent_class)->dispose != NULL)
     {
         G_OBJECT_CLASS(gst_cuda_feature_extractor_parent_class)
@@ -1062,15 +1521,16 @@ static void gst_cuda_feature_extractor_dispose(GObject *gobject)
     }
 }
 
-static GArray *gst_cuda_feature_extractor_extract_features(
+static gboolean gst_cuda_feature_extractor_extract_features(
     GstCudaFeatureExtractor *self,
     const GstVideoFrame *frame,
-    const GstMetaOpticalFlow *optical_flow_metadata)
+    const GstMetaOpticalFlow *optical_flow_metadata,
+    GstMetaAlgorithmFeatures *algorithm_features_metadata)
 {
     GstCudaFeatureExtractorPrivate *self_private
         = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
 
-    GArray *features_array = NULL;
+    gboolean result = TRUE;
 
     const cv::cuda::GpuMat *optical_flow_matrix
         = optical_flow_metadata->optical_flow_vectors;
@@ -1095,46 +1555,27 @@ static GArray *gst_cuda_feature_extractor_extract_features(
     frame_dimensions.width = frame->info.width;
     frame_dimensions.height = frame->info.height;
 
-    const gsize features_matrix_width = self->features_matrix_width;
-    const gsize features_matrix_height = self->features_matrix_height;
-    const gsize features_matrix_pitch
-        = self->features_matrix_width * sizeof(float);
-    const gsize features_matrix_elem_size = sizeof(float);
-
-    const gsize optical_flow_matrix_width = optical_flow_matrix->cols;
-    const gsize optical_flow_matrix_height = optical_flow_matrix->rows;
-    const gsize optical_flow_matrix_pitch = optical_flow_matrix->step;
-    const gsize optical_flow_matrix_elem_size = optical_flow_matrix->elemSize();
+    const guint features_matrix_width = self->features_matrix_width;
+    const guint features_matrix_height = self->features_matrix_height;
+    const gsize features_array_length
+        = (gsize)features_matrix_width * features_matrix_height;
+    const guint feature_mask = self->feature_mask & ALGORITHM_FEATURE_FLAGS_ALL;
+    const guint number_of_planes
+        = gst_algorithm_features_get_number_of_planes(feature_mask);
 
-    const size_t dimensions_multiplier
-        = gst_cuda_feature_extractor_calculate_dimensions_multiplier(
+    const guint dimensions_multiplier
+        = (guint)gst_cuda_feature_extractor_calculate_dimensions_multiplier(
             frame_dimensions.width,
             frame_dimensions.height,
             features_matrix_width,
             features_matrix_height);
 
-    CUDA2DPitchedArray gpu_features_matrix
-        = {NULL,
-           features_matrix_pitch * dimensions_multiplier,
-           features_matrix_width * features_matrix_elem_size
-               * dimensions_multiplier,
-           features_matrix_height * dimensions_multiplier,
-           features_matrix_elem_size};
-    CUDA2DPitchedArray consolidated_gpu_features_matrix
-        = {NULL,
-           features_matrix_pitch,
-           features_matrix_width * features_matrix_elem_size,
-           features_matrix_height,
-           features_matrix_elem_size};
     CUDA2DPitchedArray gpu_optical_flow_matrix
         = {optical_flow_matrix->data,
-           optical_flow_matrix_pitch,
-           optical_flow_matrix_width * optical_flow_matrix_elem_size,
-           optical_flow_matrix_height,
-           optical_flow_matrix_elem_size};
-
-    std::vector<float> host_features_matrix(
-        features_matrix_width * features_matrix_height);
+           optical_flow_matrix->step,
+           optical_flow_matrix->cols * optical_flow_matrix->elemSize(),
+           (gsize)optical_flow_matrix->rows,
+           optical_flow_matrix->elemSize()};
 
     float gpu_features_threshold = self->magnitude_quadrant_threshold_squared;
 
@@ -1150,23 +1591,36 @@ static GArray *gst_cuda_feature_extractor_extract_features(
         guint original_block_dimension_y = ceil_div_guint(
             frame_dimensions.height, original_grid_dimension_y);
 
-        if(!gst_cuda_result(CuMemAllocPitch(
-               (CUdeviceptr *)&(gpu_features_matrix.device_ptr),
-               &(gpu_features_matrix.pitch),
-               gpu_features_matrix.width,
-               gpu_features_matrix.height,
-               16)))
+        if(self_private->features == nullptr)
         {
-            throw GstCudaException(
-                "Could not allocate GPU memory for the features matrix.");
-        };
+            self_private->features = new cv::cuda::GpuMat();
+        }
+
+        /*
+         * The blocks add their features straight into the consolidated
+         * features matrix, so it has to start from zero. Each feature is a
+         * separate plane, so a consumer of one feature only reads that plane.
+         */
+        self_private->features->create(
+            1, (int)(features_array_length * number_of_planes), CV_32FC1);
+        self_private->features->setTo(cv::Scalar::all(0));
+
+        gpointer gpu_features = self_private->features->data;
+        guint gpu_feature_mask = feature_mask;
+        guint gpu_dimensions_multiplier = dimensions_multiplier;
+        guint gpu_features_matrix_width = features_matrix_width;
+        guint gpu_features_matrix_height = features_matrix_height;
 
         gpointer feature_extractor_kernel_args[]
             = {&gpu_optical_flow_matrix,
                &frame_dimensions,
                (gpointer)(&optical_flow_vector_grid_size),
                &gpu_features_threshold,
-               &gpu_features_matrix};
+               &gpu_feature_mask,
+               &gpu_dimensions_multiplier,
+               &gpu_features_matrix_width,
+               &gpu_features_matrix_height,
+               &gpu_features};
 
         if(!gst_cuda_result(CuLaunchKernel(
                self_private->feature_extractor_kernel,
@@ -1185,142 +1639,343 @@ static GArray *gst_cuda_feature_extractor_extract_features(
                 "Could not launch feature extractor CUDA kernel.");
         }
 
-        guint consolidated_grid_dimension_x = features_matrix_width;
-        guint consolidated_grid_dimension_y = features_matrix_height;
+        if(self_private->host_features == nullptr)
+        {
+            self_private->host_features = new cv::Mat();
+        }
 
-        guint consolidated_block_dimension_x = dimensions_multiplier;
-        guint consolidated_block_dimension_y = dimensions_multiplier;
+        self_private->features->download(*self_private->host_features);
 
-        if(!gst_cuda_result(CuMemAllocPitch(
-               (CUdeviceptr *)&(consolidated_gpu_features_matrix.device_ptr),
-               &(consolidated_gpu_features_matrix.pitch),
-               consolidated_gpu_features_matrix.width,
-               consolidated_gpu_features_matrix.height,
-               16)))
+        const gfloat *host_features = reinterpret_cast<const gfloat *>(
+            self_private->host_features->data);
+
+        GstAlgorithmFeaturesPool *features_pool
+            = gst_cuda_feature_extractor_get_features_pool(
+                self,
+                &self_private->features_pool,
+                gst_meta_algorithm_features_get_slab_size(
+                    features_matrix_width,
+                    features_matrix_height,
+                    features_per_aggregation,
+                    feature_mask,
+                    0));
+
+        if(!gst_meta_algorithm_features_set_layout(
+               algorithm_features_metadata,
+               features_pool,
+               features_matrix_width,
+               features_matrix_height,
+               features_per_aggregation,
+               feature_mask,
+               0))
         {
-            throw GstCudaException(
-                "Could not allocate GPU memory for the consolidated features "
-                "matrix.");
+            throw std::runtime_error(
+                "Could not acquire the memory for the features.");
         }
 
-        gpointer feature_consolidator_kernel_args[]
-            = {&gpu_features_matrix, &consolidated_gpu_features_matrix};
-
-        if(!gst_cuda_result(CuLaunchKernel(
-               self_private->feature_consolidator_kernel,
-               consolidated_grid_dimension_x,
-               consolidated_grid_dimension_y,
-               1,
-               consolidated_block_dimension_x,
-               consolidated_block_dimension_y,
-               1,
-               0,
-               NULL,
-               feature_consolidator_kernel_args,
-               NULL)))
+        /*
+         * The planes are in the same order as the arrays of the metadata, so
+         * each one is aggregated straight into its array.
+         */
+        gst_algorithm_features_aggregate(
+            host_features,
+            features_array_length,
+            features_per_aggregation,
+            algorithm_features_metadata->features);
+
+        for(guint feature = 0, plane = 1;
+            feature < ALGORITHM_NUMBER_OF_FEATURES;
+            feature++)
         {
-            throw GstCudaException(
-                "Could not launch feature consolidator CUDA kernel.");
+            if(feature_mask & (1u << feature))
+            {
+                gst_algorithm_features_aggregate(
+                    host_features + features_array_length * plane,
+                    features_array_length,
+                    features_per_aggregation,
+                    algorithm_features_metadata->feature_arrays[feature]);
+                plane++;
+            }
         }
+    }
+    catch(std::exception &ex)
+    {
+        GST_ERROR_OBJECT(self, "%s", ex.what());
+        result = FALSE;
+    }
 
-        CUDA_MEMCPY2D feature_memcpy_args = {
-            0,
-        };
+    return result;
+}
 
-        feature_memcpy_args.srcMemoryType = CU_MEMORYTYPE_DEVICE;
-        feature_memcpy_args.srcDevice
-            = (CUdeviceptr)(consolidated_gpu_features_matrix.device_ptr);
-        feature_memcpy_args.srcPitch = consolidated_gpu_features_matrix.pitch;
+static gboolean gst_cuda_feature_extractor_extract_roi_features(
+    GstCudaFeatureExtractor *self,
+    const GstVideoFrame *frame,
+    const GstMetaOpticalFlow *optical_flow_metadata,
+    GstCudaOfRoiSet *roi_set,
+    GstMetaAlgorithmFeatures *algorithm_features_metadata)
+{
+    GstCudaFeatureExtractorPrivate *self_private
+        = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
 
-        feature_memcpy_args.dstMemoryType = CU_MEMORYTYPE_HOST;
-        feature_memcpy_args.dstHost = host_features_matrix.data();
-        feature_memcpy_args.dstPitch = sizeof(float) * features_matrix_width;
+    gboolean result = TRUE;
 
-        feature_memcpy_args.WidthInBytes
-            = sizeof(float) * features_matrix_width;
-        feature_memcpy_args.Height = features_matrix_height;
+    const cv::cuda::GpuMat *optical_flow_matrix
+        = optical_flow_metadata->optical_flow_vectors;
+    const int optical_flow_vector_grid_size
+        = optical_flow_metadata->optical_flow_vector_grid_size;
 
-        if(!gst_cuda_result(CuMemcpy2D(&feature_memcpy_args)))
-        {
-            throw GstCudaException(
-                "Could not copy features matrix to host memory.");
-        }
+    FrameDimensions frame_dimensions;
+    frame_dimensions.width = frame->info.width;
+    frame_dimensions.height = frame->info.height;
 
-        gsize features_array_length
-            = features_matrix_width * features_matrix_height;
-        gsize aggregate_features_array_length
-            = ceil_div_gsize(features_array_length, features_per_aggregation);
+    const guint features_matrix_width = self->features_matrix_width;
+    const guint features_matrix_height = self->features_matrix_height;
+    const gsize features_array_length
+        = (gsize)features_matrix_width * features_matrix_height;
+    const guint number_of_rois = gst_cuda_of_roi_set_get_size(roi_set);
+    const guint feature_mask = self->feature_mask & ALGORITHM_FEATURE_FLAGS_ALL;
 
-        features_array = g_array_sized_new(
-            FALSE, TRUE, sizeof(gfloat), aggregate_features_array_length);
+    /*
+     * The spatial magnitude of the union of the regions and of each region,
+     * followed by the selected features of the union of the regions.
+     */
+    const guint number_of_planes
+        = gst_algorithm_features_get_number_of_planes(feature_mask)
+          + number_of_rois;
 
-        /**
-         * In addition to the feature extraction performed by the CUDA
-         * kernel(s), the features will be aggregated in groups of 10 (by
-         * default) using the MAX aggregation operator.
-         *
-         * Due to CUDA limitations (limited ability to define critical
-         * sections), this is done on the CPU instead.
+    /*
+     * The tiles are the blocks of the feature extractor kernel, so that the
+     * features of a region match the features of the whole frame wherever the
+     * region covers a whole cell.
+     */
+    const guint dimensions_multiplier
+        = (guint)gst_cuda_feature_extractor_calculate_dimensions_multiplier(
+            frame_dimensions.width,
+            frame_dimensions.height,
+            features_matrix_width,
+            features_matrix_height);
+    const guint tile_width = ceil_div_guint(
+        frame_dimensions.width, features_matrix_width * dimensions_multiplier);
+    const guint tile_height = ceil_div_guint(
+        frame_dimensions.height,
+        features_matrix_height * dimensions_multiplier);
+    const guint tiles_per_row
+        = ceil_div_guint(frame_dimensions.width, tile_width);
+
+    CUDA2DPitchedArray gpu_optical_flow_matrix
+        = {optical_flow_matrix->data,
+           optical_flow_matrix->step,
+           optical_flow_matrix->cols * optical_flow_matrix->elemSize(),
+           (gsize)optical_flow_matrix->rows,
+           optical_flow_matrix->elemSize()};
+
+    float gpu_features_threshold = self->magnitude_quadrant_threshold_squared;
+
+    try
+    {
+        /*
+         * Rasterising the regions and uploading the membership mask costs far
+         * more than the kernel itself, so it is only done when the regions,
+         * the frame or the tiles change.
          */
-        for(gsize aggregate_idx = 0;
-            aggregate_idx < aggregate_features_array_length;
-            aggregate_idx++)
+        if(!gst_cuda_of_roi_set_equal(roi_set, self_private->roi_set)
+           || self_private->roi_mask == nullptr
+           || self_private->roi_frame_width != frame_dimensions.width
+           || self_private->roi_frame_height != frame_dimensions.height
+           || self_private->roi_tile_width != tile_width
+           || self_private->roi_tile_height != tile_height)
         {
-            gfloat maximum_spatial_magnitude = 0.0f;
+            cv::Mat host_roi_mask(
+                frame_dimensions.height, frame_dimensions.width, CV_32SC1);
+            std::vector<guint32> host_roi_tiles(
+                tiles_per_row
+                * ceil_div_guint(frame_dimensions.height, tile_height));
+
+            gst_cuda_of_roi_set_rasterize(
+                roi_set,
+                frame_dimensions.width,
+                frame_dimensions.height,
+                reinterpret_cast<guint32 *>(host_roi_mask.data));
+
+            self_private->roi_number_of_tiles = gst_cuda_of_roi_active_tiles(
+                reinterpret_cast<guint32 *>(host_roi_mask.data),
+                frame_dimensions.width,
+                frame_dimensions.height,
+                tile_width,
+                tile_height,
+                host_roi_tiles.data());
+
+            if(self_private->roi_mask == nullptr)
+            {
+                self_private->roi_mask = new cv::cuda::GpuMat();
+                self_private->roi_tiles = new cv::cuda::GpuMat();
+                self_private->roi_features = new cv::cuda::GpuMat();
+            }
+
+            self_private->roi_mask->upload(host_roi_mask);
 
-            for(gsize idx = 0;
-                idx < features_per_aggregation
-                && (aggregate_idx * features_per_aggregation + idx)
-                       < features_array_length;
-                idx++)
+            if(self_private->roi_number_of_tiles > 0)
             {
-                maximum_spatial_magnitude = MAX(
-                    maximum_spatial_magnitude,
-                    host_features_matrix
-                        [aggregate_idx * features_per_aggregation + idx]);
+                self_private->roi_tiles->upload(cv::Mat(
+                    1,
+                    self_private->roi_number_of_tiles,
+                    CV_32SC1,
+                    host_roi_tiles.data()));
             }
 
-            g_array_append_val(features_array, maximum_spatial_magnitude);
+            gst_cuda_of_roi_set_free(self_private->roi_set);
+            self_private->roi_set = roi_set;
+            roi_set = NULL;
+
+            self_private->roi_frame_width = frame_dimensions.width;
+            self_private->roi_frame_height = frame_dimensions.height;
+            self_private->roi_tile_width = tile_width;
+            self_private->roi_tile_height = tile_height;
+
+            GST_DEBUG_OBJECT(
+                self,
+                "Prepared %u regions of interest covering %u of %u tiles",
+                number_of_rois,
+                self_private->roi_number_of_tiles,
+                (guint)host_roi_tiles.size());
         }
 
-        if(consolidated_gpu_features_matrix.device_ptr != NULL)
+        self_private->roi_features->create(
+            1, (int)(features_array_length * number_of_planes), CV_32FC1);
+        self_private->roi_features->setTo(cv::Scalar::all(0));
+
+        /*
+         * No tile contains a region, e.g. if the regions lie outside of the
+         * frame, so every feature is zero without launching the kernel.
+         */
+        if(self_private->roi_number_of_tiles > 0)
         {
-            CuMemFree(
-                (CUdeviceptr)(consolidated_gpu_features_matrix.device_ptr));
-            consolidated_gpu_features_matrix.device_ptr = NULL;
+            CUDA2DPitchedArray gpu_roi_mask
+                = {self_private->roi_mask->data,
+                   self_private->roi_mask->step,
+                   self_private->roi_mask->cols * sizeof(guint32),
+                   (gsize)self_private->roi_mask->rows,
+                   sizeof(guint32)};
+            gpointer gpu_roi_tiles = self_private->roi_tiles->data;
+            gpointer gpu_roi_features = self_private->roi_features->data;
+            guint gpu_feature_mask = feature_mask;
+            guint gpu_tiles_per_row = tiles_per_row;
+            guint gpu_dimensions_multiplier = dimensions_multiplier;
+            guint gpu_features_matrix_width = features_matrix_width;
+            guint gpu_features_matrix_height = features_matrix_height;
+            guint gpu_number_of_rois = number_of_rois;
+
+            gpointer feature_extractor_roi_kernel_args[]
+                = {&gpu_optical_flow_matrix,
+                   &frame_dimensions,
+                   (gpointer)(&optical_flow_vector_grid_size),
+                   &gpu_features_threshold,
+                   &gpu_feature_mask,
+                   &gpu_roi_mask,
+                   &gpu_roi_tiles,
+                   &gpu_tiles_per_row,
+                   &gpu_dimensions_multiplier,
+                   &gpu_features_matrix_width,
+                   &gpu_features_matrix_height,
+                   &gpu_number_of_rois,
+                   &gpu_roi_features};
+
+            if(!gst_cuda_result(CuLaunchKernel(
+                   self_private->feature_extractor_roi_kernel,
+                   self_private->roi_number_of_tiles,
+                   1,
+                   1,
+                   tile_width,
+                   tile_height,
+                   1,
+                   sizeof(float) * number_of_planes,
+                   NULL,
+                   feature_extractor_roi_kernel_args,
+                   NULL)))
+            {
+                throw GstCudaException(
+                    "Could not launch region of interest feature extractor "
+                    "CUDA kernel.");
+            }
         }
 
-        if(gpu_features_matrix.device_ptr != NULL)
+        if(self_private->host_features == nullptr)
         {
-            CuMemFree((CUdeviceptr)(gpu_features_matrix.device_ptr));
-            gpu_features_matrix.device_ptr = NULL;
+            self_private->host_features = new cv::Mat();
         }
-    }
-    catch(std::exception &ex)
-    {
-        GST_ERROR_OBJECT(self, "%s", ex.what());
 
-        if(consolidated_gpu_features_matrix.device_ptr != NULL)
+        self_private->roi_features->download(*self_private->host_features);
+
+        const gfloat *host_features = reinterpret_cast<const gfloat *>(
+            self_private->host_features->data);
+
+        GstAlgorithmFeaturesPool *features_pool
+            = gst_cuda_feature_extractor_get_features_pool(
+                self,
+                &self_private->features_pool,
+                gst_meta_algorithm_features_get_slab_size(
+                    features_matrix_width,
+                    features_matrix_height,
+                    features_per_aggregation,
+                    feature_mask,
+                    number_of_rois));
+
+        if(!gst_meta_algorithm_features_set_layout(
+               algorithm_features_metadata,
+               features_pool,
+               features_matrix_width,
+               features_matrix_height,
+               features_per_aggregation,
+               feature_mask,
+               number_of_rois))
         {
-            CuMemFree(
-                (CUdeviceptr)(consolidated_gpu_features_matrix.device_ptr));
-            consolidated_gpu_features_matrix.device_ptr = NULL;
+            throw std::runtime_error(
+                "Could not acquire the memory for the features.");
         }
 
-        if(gpu_features_matrix.device_ptr != NULL)
+        gst_algorithm_features_aggregate(
+            host_features,
+            features_array_length,
+            features_per_aggregation,
+            algorithm_features_metadata->features);
+
+        for(guint idx = 0; idx < number_of_rois; idx++)
         {
-            CuMemFree((CUdeviceptr)(gpu_features_matrix.device_ptr));
-            gpu_features_matrix.device_ptr = NULL;
+            algorithm_features_metadata->roi_ids[idx]
+                = gst_cuda_of_roi_set_get_id(self_private->roi_set, idx);
+
+            gst_algorithm_features_aggregate(
+                host_features + features_array_length * (1 + idx),
+                features_array_length,
+                features_per_aggregation,
+                algorithm_features_metadata->roi_features
+                    + (gsize)algorithm_features_metadata->length * idx);
         }
 
-        if(features_array != NULL)
+        for(guint feature = 0, plane = 1 + number_of_rois;
+            feature < ALGORITHM_NUMBER_OF_FEATURES;
+            feature++)
         {
-            g_array_unref(features_array);
-            features_array = NULL;
+            if(feature_mask & (1u << feature))
+            {
+                gst_algorithm_features_aggregate(
+                    host_features + features_array_length * plane,
+                    features_array_length,
+                    features_per_aggregation,
+                    algorithm_features_metadata->feature_arrays[feature]);
+                plane++;
+            }
         }
     }
+    catch(std::exception &ex)
+    {
+        GST_ERROR_OBJECT(self, "%s", ex.what());
+        result = FALSE;
+    }
+
+    gst_cuda_of_roi_set_free(roi_set);
 
-    return features_array;
+    return result;
 }
 
 static GstCudaFeatureExtractorPrivate *
@@ -1359,6 +2014,9 @@ static void gst_cuda_feature_extractor_get_property(
             g_value_set_boolean(
                 value, gst_cuda_feature_extractor->enable_debug);
             break;
+        case PROP_FEATURE_MASK:
+            g_value_set_flags(value, gst_cuda_feature_extractor->feature_mask);
+            break;
         case PROP_FEATURES_MATRIX_HEIGHT:
             g_value_set_uint(
                 value, gst_cuda_feature_extractor->features_matrix_height);
@@ -1377,11 +2035,63 @@ static void gst_cuda_feature_extractor_get_property(
                 gst_cuda_feature_extractor
                     ->magnitude_quadrant_threshold_squared);
             break;
+        case PROP_ROI_FROM_META:
+            g_value_set_boolean(
+                value, gst_cuda_feature_extractor->roi_from_meta);
+            break;
+        case PROP_ROI_MASK_LOCATION:
+            g_value_set_string(
+                value, gst_cuda_feature_extractor->roi_mask_location);
+            break;
+        case PROP_ROI_POLYGONS:
+            g_value_set_string(
+                value, gst_cuda_feature_extractor->roi_polygons);
+            break;
+        case PROP_STATISTICS_WINDOW_SIZE:
+            g_value_set_uint(
+                value, gst_cuda_feature_extractor->statistics_window_size);
+            break;
         default:
             g_assert_not_reached();
     }
 }
 
+static GstCudaOfRoiSet *gst_cuda_feature_extractor_get_roi_set(
+    GstCudaFeatureExtractor *self,
+    const GstVideoFrame *frame)
+{
+    GstCudaFeatureExtractorPrivate *self_private
+        = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
+
+    GstCudaOfRoiSet *roi_set = NULL;
+
+    if(self_private->static_roi_set != NULL)
+    {
+        roi_set = gst_cuda_of_roi_set_copy(self_private->static_roi_set);
+    }
+
+    if(self->roi_from_meta
+       && gst_buffer_get_meta(
+              frame->buffer, GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+              != NULL)
+    {
+        if(roi_set == NULL)
+        {
+            roi_set = gst_cuda_of_roi_set_new();
+        }
+
+        gst_cuda_of_roi_set_add_from_buffer(roi_set, frame->buffer);
+    }
+
+    if(roi_set != NULL && gst_cuda_of_roi_set_get_size(roi_set) == 0)
+    {
+        gst_cuda_of_roi_set_free(roi_set);
+        roi_set = NULL;
+    }
+
+    return roi_set;
+}
+
 /**
  * \brief Initialisation function for GstCudaFeatureExtractor instances.
  *
@@ -1407,17 +2117,41 @@ static void gst_cuda_feature_extractor_init(GstCudaFeatureExtractor *self)
     self->parent.device_id = default_device_id;
 
     self->enable_debug = default_enable_debug;
+    self->feature_mask = default_feature_mask;
     self->features_matrix_height = default_features_matrix_height;
     self->features_matrix_width = default_features_matrix_width;
     self->kernel_source_location = g_strdup(default_kernel_source_location);
     self->magnitude_quadrant_threshold_squared
         = default_magnitude_quadrant_threshold_squared;
+    self->roi_from_meta = default_roi_from_meta;
+    self->roi_mask_location = g_strdup(default_roi_mask_location);
+    self->roi_polygons = g_strdup(default_roi_polygons);
+    self->statistics_window_size = default_statistics_window_size;
 
     self_private->cuda_module = NULL;
-    self_private->feature_consolidator_kernel = NULL;
     self_private->feature_extractor_kernel = NULL;
+    self_private->features = nullptr;
+    self_private->host_features = nullptr;
+    self_private->features_pool = NULL;
     self_private->frame_num = 0;
     self_private->frame_timestamp = GST_CLOCK_TIME_NONE;
+    self_private->feature_extractor_roi_kernel = NULL;
+    self_private->static_roi_set = NULL;
+    self_private->roi_set = NULL;
+    self_private->roi_frame_width = 0;
+    self_private->roi_frame_height = 0;
+    self_private->roi_tile_width = 0;
+    self_private->roi_tile_height = 0;
+    self_private->roi_mask = nullptr;
+    self_private->roi_tiles = nullptr;
+    self_private->roi_number_of_tiles = 0;
+    self_private->roi_features = nullptr;
+    self_private->statistics_window = NULL;
+    self_private->statistics_features_matrix_width = 0;
+    self_private->statistics_features_matrix_height = 0;
+    self_private->statistics_feature_mask = 0;
+    self_private->statistics_number_of_rois = 0;
+    self_private->statistics_pool = NULL;
 
     gst_base_transform_set_in_place(trans, TRUE);
     gst_base_transform_set_gap_aware(trans, FALSE);
@@ -1425,6 +2159,68 @@ static void gst_cuda_feature_extractor_init(GstCudaFeatureExtractor *self)
     gst_base_transform_set_prefer_passthrough(trans, FALSE);
 }
 
+static gboolean
+gst_cuda_feature_extractor_load_roi_set(GstCudaFeatureExtractor *self)
+{
+    GstCudaFeatureExtractorPrivate *self_private
+        = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
+
+    gboolean result = TRUE;
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    if(self->roi_mask_location != NULL && *self->roi_mask_location != '\0')
+    {
+        cv::Mat roi_mask
+            = cv::imread(self->roi_mask_location, cv::IMREAD_GRAYSCALE);
+
+        if(roi_mask.empty())
+        {
+            GST_ERROR_OBJECT(
+                self,
+                "Could not read the region of interest bitmask from %s.",
+                self->roi_mask_location);
+            result = FALSE;
+        }
+        else if(!gst_cuda_of_roi_set_add_mask(
+                    roi_set,
+                    roi_mask.data,
+                    roi_mask.cols,
+                    roi_mask.rows,
+                    roi_mask.step))
+        {
+            GST_ERROR_OBJECT(
+                self,
+                "The region of interest bitmask %s is empty or has more than "
+                "%u labels.",
+                self->roi_mask_location,
+                GST_CUDA_OF_ROI_SET_MAX_SIZE);
+            result = FALSE;
+        }
+    }
+
+    if(result && !gst_cuda_of_roi_set_parse_polygons(roi_set, self->roi_polygons))
+    {
+        GST_ERROR_OBJECT(
+            self,
+            "Could not parse the region of interest polygons \"%s\".",
+            self->roi_polygons);
+        result = FALSE;
+    }
+
+    gst_cuda_of_roi_set_free(self_private->static_roi_set);
+    self_private->static_roi_set = NULL;
+
+    if(result && gst_cuda_of_roi_set_get_size(roi_set) > 0)
+    {
+        self_private->static_roi_set = roi_set;
+        roi_set = NULL;
+    }
+
+    gst_cuda_of_roi_set_free(roi_set);
+
+    return result;
+}
+
 gboolean gst_cuda_feature_extractor_plugin_init(GstPlugin *plugin)
 {
     /*
@@ -1471,7 +2267,8 @@ gboolean gst_cuda_feature_extractor_plugin_init(GstPlugin *plugin)
 static gboolean gst_cuda_feature_extractor_output_features_json(
     GstCudaFeatureExtractor *self,
     const GstVideoFrame *frame,
-    const GstMetaAlgorithmFeatures *algorithm_features_metadata)
+    const GstMetaAlgorithmFeatures *algorithm_features_metadata,
+    const GstMetaAlgorithmFeaturesStats *algorithm_features_stats_metadata)
 {
     gboolean result = TRUE;
 
@@ -1497,8 +2294,7 @@ static gboolean gst_cuda_feature_extractor_output_features_json(
         std::ofstream algorithm_features_file
             = open_output_metadata_file(self, frame, ".json");
 
-        guint32 feature_array_length
-            = algorithm_features_metadata->features->len;
+        guint32 feature_array_length = algorithm_features_metadata->length;
 
         rapidjson::Document document;
         document.SetObject();
@@ -1513,7 +2309,10 @@ static gboolean gst_cuda_feature_extractor_output_features_json(
             rapidjson::Value(self_private->frame_timestamp),
             allocator);
         document.AddMember(
-            "Number-Of-Features", rapidjson::Value(1), allocator);
+            "Number-Of-Features",
+            rapidjson::Value(gst_algorithm_features_get_number_of_planes(
+                algorithm_features_metadata->feature_mask)),
+            allocator);
         document.AddMember(
             "Feature-Array-Length",
             rapidjson::Value(feature_array_length),
@@ -1524,8 +2323,8 @@ static gboolean gst_cuda_feature_extractor_output_features_json(
 
         for(guint32 idx = 0; idx < feature_array_length; idx++)
         {
-            gfloat spatial_magnitude = g_array_index(
-                algorithm_features_metadata->features, gfloat, idx);
+            gfloat spatial_magnitude
+                = algorithm_features_metadata->features[idx];
             spatial_magnitude_array.PushBack(
                 rapidjson::Value(spatial_magnitude), allocator);
         }
@@ -1533,8 +2332,111 @@ static gboolean gst_cuda_feature_extractor_output_features_json(
         features.AddMember(
             "Spatial-Magnitude", spatial_magnitude_array, allocator);
 
+        for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES;
+            feature++)
+        {
+            const gfloat *feature_array
+                = algorithm_features_metadata->feature_arrays[feature];
+
+            if(feature_array == NULL)
+            {
+                continue;
+            }
+
+            rapidjson::Value feature_values(rapidjson::kArrayType);
+
+            for(guint32 idx = 0; idx < feature_array_length; idx++)
+            {
+                feature_values.PushBack(
+                    rapidjson::Value(feature_array[idx]), allocator);
+            }
+
+            features.AddMember(
+                rapidjson::StringRef(gst_algorithm_feature_get_name(
+                    static_cast<GstAlgorithmFeature>(feature))),
+                feature_values,
+                allocator);
+        }
+
         document.AddMember("Features", features, allocator);
 
+        if(algorithm_features_metadata->roi_ids != NULL
+           && algorithm_features_metadata->roi_features != NULL)
+        {
+            rapidjson::Value regions_of_interest(rapidjson::kArrayType);
+
+            for(guint roi_idx = 0;
+                roi_idx < algorithm_features_metadata->number_of_rois;
+                roi_idx++)
+            {
+                const gfloat *roi_features
+                    = algorithm_features_metadata->roi_features
+                      + (gsize)feature_array_length * roi_idx;
+                rapidjson::Value region_of_interest(rapidjson::kObjectType);
+                rapidjson::Value roi_spatial_magnitude_array(
+                    rapidjson::kArrayType);
+
+                for(guint32 idx = 0; idx < feature_array_length; idx++)
+                {
+                    roi_spatial_magnitude_array.PushBack(
+                        rapidjson::Value(roi_features[idx]), allocator);
+                }
+
+                region_of_interest.AddMember(
+                    "Id",
+                    rapidjson::Value(
+                        algorithm_features_metadata->roi_ids[roi_idx]),
+                    allocator);
+                region_of_interest.AddMember(
+                    "Spatial-Magnitude",
+                    roi_spatial_magnitude_array,
+                    allocator);
+                regions_of_interest.PushBack(region_of_interest, allocator);
+            }
+
+            document.AddMember(
+                "Regions-Of-Interest", regions_of_interest, allocator);
+        }
+
+        if(algorithm_features_stats_metadata != NULL
+           && algorithm_features_stats_metadata->features.mean != NULL)
+        {
+            const GstMetaAlgorithmFeaturesStats *stats
+                = algorithm_features_stats_metadata;
+            rapidjson::Value statistics(rapidjson::kObjectType);
+            rapidjson::Value statistics_features(rapidjson::kObjectType);
+
+            statistics_features.AddMember(
+                "Spatial-Magnitude",
+                statistics_to_json(stats->features, stats->length, allocator),
+                allocator);
+
+            for(guint feature = 0; feature < ALGORITHM_NUMBER_OF_FEATURES;
+                feature++)
+            {
+                if(stats->feature_arrays[feature].mean != NULL)
+                {
+                    statistics_features.AddMember(
+                        rapidjson::StringRef(gst_algorithm_feature_get_name(
+                            static_cast<GstAlgorithmFeature>(feature))),
+                        statistics_to_json(
+                            stats->feature_arrays[feature],
+                            stats->length,
+                            allocator),
+                        allocator);
+                }
+            }
+
+            statistics.AddMember(
+                "Window-Size", rapidjson::Value(stats->window_size), allocator);
+            statistics.AddMember(
+                "Number-Of-Frames",
+                rapidjson::Value(stats->number_of_frames),
+                allocator);
+            statistics.AddMember("Features", statistics_features, allocator);
+            document.AddMember("Statistics", statistics, allocator);
+        }
+
         rapidjson::StringBuffer buffer;
         rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
         document.Accept(writer);
@@ -1651,6 +2553,9 @@ static void gst_cuda_feature_extractor_set_property(
             gst_cuda_feature_extractor->enable_debug
                 = g_value_get_boolean(value);
             break;
+        case PROP_FEATURE_MASK:
+            gst_cuda_feature_extractor->feature_mask = g_value_get_flags(value);
+            break;
         case PROP_FEATURES_MATRIX_HEIGHT:
             gst_cuda_feature_extractor->features_matrix_height
                 = g_value_get_uint(value);
@@ -1673,6 +2578,24 @@ static void gst_cuda_feature_extractor_set_property(
             gst_cuda_feature_extractor->magnitude_quadrant_threshold_squared
                 = g_value_get_float(value);
             break;
+        case PROP_ROI_FROM_META:
+            gst_cuda_feature_extractor->roi_from_meta
+                = g_value_get_boolean(value);
+            break;
+        case PROP_ROI_MASK_LOCATION:
+            g_free(gst_cuda_feature_extractor->roi_mask_location);
+            gst_cuda_feature_extractor->roi_mask_location
+                = g_value_dup_string(value);
+            break;
+        case PROP_ROI_POLYGONS:
+            g_free(gst_cuda_feature_extractor->roi_polygons);
+            gst_cuda_feature_extractor->roi_polygons
+                = g_value_dup_string(value);
+            break;
+        case PROP_STATISTICS_WINDOW_SIZE:
+            gst_cuda_feature_extractor->statistics_window_size
+                = g_value_get_uint(value);
+            break;
         default:
             g_assert_not_reached();
     }
@@ -1762,23 +2685,29 @@ static gboolean gst_cuda_feature_extractor_start(GstBaseTransform *trans)
                 }
 
                 if(!gst_cuda_result(CuModuleGetFunction(
-                       &self_private->feature_consolidator_kernel,
-                       self_private->cuda_module,
-                       GST_CUDA_FEATURE_CONSOLIDATION_KERNEL)))
+                       &(self_private->feature_extractor_kernel),
+                       (self_private->cuda_module),
+                       GST_CUDA_FEATURE_EXTRACTOR_KERNEL)))
                 {
                     throw GstCudaException(
-                        "Could not successfully load feature consolidation "
+                        "Could not successfully load feature extractor "
                         "kernel from NVRTC module.");
                 }
 
                 if(!gst_cuda_result(CuModuleGetFunction(
-                       &(self_private->feature_extractor_kernel),
+                       &(self_private->feature_extractor_roi_kernel),
                        (self_private->cuda_module),
-                       GST_CUDA_FEATURE_EXTRACTOR_KERNEL)))
+                       GST_CUDA_FEATURE_EXTRACTOR_ROI_KERNEL)))
                 {
                     throw GstCudaException(
-                        "Could not successfully load feature extractor "
-                        "kernel from NVRTC module.");
+                        "Could not successfully load region of interest "
+                        "feature extractor kernel from NVRTC module.");
+                }
+
+                if(!gst_cuda_feature_extractor_load_roi_set(self))
+                {
+                    throw std::runtime_error(
+                        "Could not load the regions of interest.");
                 }
 
                 if(ptx != NULL)
@@ -1790,7 +2719,7 @@ static gboolean gst_cuda_feature_extractor_start(GstBaseTransform *trans)
             catch(std::exception &ex)
             {
                 self_private->feature_extractor_kernel = NULL;
-                self_private->feature_consolidator_kernel = NULL;
+                self_private->feature_extractor_roi_kernel = NULL;
 
                 if(self_private->cuda_module != NULL)
                 {
@@ -1833,8 +2762,8 @@ static gboolean gst_cuda_feature_extractor_stop(GstBaseTransform *trans)
 
     if(gst_cuda_context_push(filter->context))
     {
-        self_private->feature_consolidator_kernel = NULL;
         self_private->feature_extractor_kernel = NULL;
+        self_private->feature_extractor_roi_kernel = NULL;
 
         if(self_private->cuda_module != NULL)
         {
@@ -1842,9 +2771,31 @@ static gboolean gst_cuda_feature_extractor_stop(GstBaseTransform *trans)
             self_private->cuda_module = FALSE;
         }
 
+        delete self_private->features;
+        self_private->features = nullptr;
+        delete self_private->host_features;
+        self_private->host_features = nullptr;
+
+        gst_cuda_feature_extractor_clear_roi_set(self);
+
         gst_cuda_context_pop(NULL);
     }
 
+    if(self_private->features_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(self_private->features_pool);
+        self_private->features_pool = NULL;
+    }
+
+    gst_algorithm_features_window_free(self_private->statistics_window);
+    self_private->statistics_window = NULL;
+
+    if(self_private->statistics_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(self_private->statistics_pool);
+        self_private->statistics_pool = NULL;
+    }
+
     result = GST_BASE_TRANSFORM_CLASS(parent_class)->stop(trans);
 
     return result;
@@ -1889,6 +2840,20 @@ static GstFlowReturn gst_cuda_feature_extractor_transform_frame(
             = reinterpret_cast<GstMetaOpticalFlow *>(gst_buffer_get_meta(
                 in_frame->buffer, gst_meta_optical_flow_api_get_type()));
 
+        /*
+         * Deserialised optical flow metadata only holds its values in host
+         * memory, which the CUDA kernels cannot read from.
+         */
+        if(optical_flow_metadata != NULL
+           && optical_flow_metadata->optical_flow_vectors == nullptr)
+        {
+            GST_DEBUG_OBJECT(
+                self,
+                "The optical flow metadata has no values on the GPU, so no "
+                "features are extracted");
+            optical_flow_metadata = NULL;
+        }
+
         if(optical_flow_metadata != NULL)
         {
             if(self->enable_debug == TRUE)
@@ -1897,21 +2862,49 @@ static GstFlowReturn gst_cuda_feature_extractor_transform_frame(
                     self, in_frame, optical_flow_metadata);
             }
 
-            GArray *features_array
-                = gst_cuda_feature_extractor_extract_features(
-                    self, in_frame, optical_flow_metadata);
+            GstCudaOfRoiSet *roi_set
+                = gst_cuda_feature_extractor_get_roi_set(self, in_frame);
 
             GstMetaAlgorithmFeatures *algorithm_features_meta
                 = GST_META_ALGORITHM_FEATURES_ADD(out_frame->buffer);
+            GstMetaAlgorithmFeaturesStats *algorithm_features_stats_meta
+                = NULL;
+            gboolean extracted = FALSE;
 
-            algorithm_features_meta->features = features_array;
+            if(roi_set != NULL)
+            {
+                extracted = gst_cuda_feature_extractor_extract_roi_features(
+                    self,
+                    in_frame,
+                    optical_flow_metadata,
+                    roi_set,
+                    algorithm_features_meta);
+            }
+            else
+            {
+                extracted = gst_cuda_feature_extractor_extract_features(
+                    self,
+                    in_frame,
+                    optical_flow_metadata,
+                    algorithm_features_meta);
+            }
+
+            if(extracted && self->statistics_window_size > 0)
+            {
+                algorithm_features_stats_meta
+                    = gst_cuda_feature_extractor_update_statistics(
+                        self, out_frame->buffer, algorithm_features_meta);
+            }
 
             if(self->enable_debug == TRUE)
             {
                 if(algorithm_features_meta != NULL)
                 {
                     gst_cuda_feature_extractor_output_features_json(
-                        self, in_frame, algorithm_features_meta);
+                        self,
+                        in_frame,
+                        algorithm_features_meta,
+                        algorithm_features_stats_meta);
                 }
             }
         }
@@ -1948,6 +2941,127 @@ static GstFlowReturn gst_cuda_feature_extractor_transform_frame(
     return result;
 }
 
+static GstMetaAlgorithmFeaturesStats *
+gst_cuda_feature_extractor_update_statistics(
+    GstCudaFeatureExtractor *self,
+    GstBuffer *buffer,
+    const GstMetaAlgorithmFeatures *algorithm_features_metadata)
+{
+    GstCudaFeatureExtractorPrivate *self_private
+        = gst_cuda_feature_extractor_get_instance_private_typesafe(self);
+    GstMetaAlgorithmFeaturesStats *algorithm_features_stats_metadata = NULL;
+
+    try
+    {
+        const GstMetaAlgorithmFeatures *features = algorithm_features_metadata;
+
+        if(features == NULL || features->features == NULL)
+        {
+            throw std::invalid_argument(
+                "The given algorithm features metadata holds no features.");
+        }
+
+        gsize block_length
+            = (gsize)features->length
+              * gst_algorithm_features_get_number_of_planes(
+                  features->feature_mask);
+
+        if(self_private->statistics_window == NULL
+           || gst_algorithm_features_window_get_window_size(
+                  self_private->statistics_window)
+                  != self->statistics_window_size
+           || gst_algorithm_features_window_get_length(
+                  self_private->statistics_window)
+                  != block_length
+           || self_private->statistics_features_matrix_width
+                  != features->features_matrix_width
+           || self_private->statistics_features_matrix_height
+                  != features->features_matrix_height
+           || self_private->statistics_feature_mask != features->feature_mask
+           || self_private->statistics_number_of_rois
+                  != features->number_of_rois)
+        {
+            GST_DEBUG_OBJECT(
+                self,
+                "Creating a statistics window of %u frames of %" G_GSIZE_FORMAT
+                " features",
+                self->statistics_window_size,
+                block_length);
+
+            gst_algorithm_features_window_free(self_private->statistics_window);
+            self_private->statistics_window = gst_algorithm_features_window_new(
+                self->statistics_window_size, block_length, 0);
+            self_private->statistics_features_matrix_width
+                = features->features_matrix_width;
+            self_private->statistics_features_matrix_height
+                = features->features_matrix_height;
+            self_private->statistics_feature_mask = features->feature_mask;
+            self_private->statistics_number_of_rois = features->number_of_rois;
+        }
+        else if(GST_BUFFER_IS_DISCONT(buffer))
+        {
+            gst_algorithm_features_window_reset(
+                self_private->statistics_window);
+        }
+
+        gst_algorithm_features_window_push(
+            self_private->statistics_window, features->features);
+
+        GstAlgorithmFeaturesPool *statistics_pool
+            = gst_cuda_feature_extractor_get_features_pool(
+                self,
+                &self_private->statistics_pool,
+                gst_meta_algorithm_features_stats_get_slab_size(
+                    features->features_matrix_width,
+                    features->features_matrix_height,
+                    features->features_per_aggregation,
+                    features->feature_mask));
+
+        algorithm_features_stats_metadata
+            = GST_META_ALGORITHM_FEATURES_STATS_ADD(buffer);
+
+        if(!gst_meta_algorithm_features_stats_set_layout(
+               algorithm_features_stats_metadata,
+               statistics_pool,
+               features->features_matrix_width,
+               features->features_matrix_height,
+               features->features_per_aggregation,
+               features->feature_mask))
+        {
+            gst_buffer_remove_meta(
+                buffer, GST_META_CAST(algorithm_features_stats_metadata));
+            algorithm_features_stats_metadata = NULL;
+
+            throw std::runtime_error(
+                "Could not acquire a slab for the feature statistics.");
+        }
+
+        algorithm_features_stats_metadata->window_size
+            = self->statistics_window_size;
+        algorithm_features_stats_metadata->number_of_frames
+            = gst_algorithm_features_window_get_number_of_frames(
+                self_private->statistics_window);
+
+        gst_algorithm_features_window_get_statistics(
+            self_private->statistics_window,
+            algorithm_features_stats_metadata->features.mean,
+            algorithm_features_stats_metadata->features.max,
+            algorithm_features_stats_metadata->features.variance);
+    }
+    catch(std::invalid_argument &ex)
+    {
+        GST_ERROR_OBJECT(self, "Invalid argument error - %s", ex.what());
+        algorithm_features_stats_metadata = NULL;
+    }
+    catch(std::runtime_error &ex)
+    {
+        GST_ERROR_OBJECT(self, "Runtime error - %s", ex.what());
+        algorithm_features_stats_metadata = NULL;
+    }
+
+    return algorithm_features_stats_metadata;
+}
+
 static std::ofstream open_output_metadata_file(
     GstCudaFeatureExtractor *self,
     const GstVideoFrame *frame,
@@ -2003,4 +3117,29 @@ static std::ofstream open_output_metadata_file(
     return output_metadata_file;
 }
 
+static rapidjson::Value statistics_to_json(
+    const GstAlgorithmFeaturesStatistics &statistics,
+    guint32 length,
+    rapidjson::Document::AllocatorType &allocator)
+{
+    rapidjson::Value statistics_object(rapidjson::kObjectType);
+    rapidjson::Value means(rapidjson::kArrayType);
+    rapidjson::Value maxes(rapidjson::kArrayType);
+    rapidjson::Value variances(rapidjson::kArrayType);
+
+    for(guint32 idx = 0; idx < length; idx++)
+    {
+        means.PushBack(rapidjson::Value(statistics.mean[idx]), allocator);
+        maxes.PushBack(rapidjson::Value(statistics.max[idx]), allocator);
+        variances.PushBack(
+            rapidjson::Value(statistics.variance[idx]), allocator);
+    }
+
+    statistics_object.AddMember("Mean", means, allocator);
+    statistics_object.AddMember("Max", maxes, allocator);
+    statistics_object.AddMember("Variance", variances, allocator);
+
+    return statistics_object;
+}
+
 /******************************************************************************/
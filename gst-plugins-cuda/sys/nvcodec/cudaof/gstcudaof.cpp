@@ -4,15 +4,23 @@
 
 #include "gstcudaof.h"
 
+#include <cstring>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <glib-object.h>
 #include <glibconfig.h>
 #include <gst/base/gstbasetransform.h>
 #include <gst/cuda/of/gstcudaofalgorithm.h>
+#include <gst/cuda/of/gstcudaofflowscale.h>
 #include <gst/cuda/of/gstcudaofhintvectorgridsize.h>
+#include <gst/cuda/of/gstcudaoflateframes.h>
+#include <gst/cuda/of/gstcudaofmotiongate.h>
 #include <gst/cuda/of/gstcudaofoutputvectorgridsize.h>
 #include <gst/cuda/of/gstcudaofperformancepreset.h>
+#include <gst/cuda/of/gstcudaofroi.h>
+#include <gst/cuda/of/gstcudaofwarmstart.h>
 #include <gst/cuda/of/gstmetaopticalflow.h>
 #include <gst/gst.h>
 #include <gst/gstbuffer.h>
@@ -20,9 +28,14 @@
 #include <gst/gstinfo.h>
 #include <gst/gstmemory.h>
 #include <gst/gstmeta.h>
+#include <gst/video/gstvideometa.h>
 #include <opencv2/core/cuda.hpp>
 #include <opencv2/core/types.hpp>
+#include <opencv2/cudaarithm.hpp>
+#include <opencv2/cudaimgproc.hpp>
 #include <opencv2/cudaoptflow.hpp>
+#include <opencv2/cudawarping.hpp>
+#include <opencv2/imgcodecs.hpp>
 #include <opencv2/video/tracking.hpp>
 
 #include <gst/cuda/nvcodec/gstcudabasetransform.h>
@@ -57,8 +70,21 @@ static const gint default_farneback_number_of_levels = 10;
 static const gint default_farneback_polynomial_expansion_n = 5;
 static const gdouble default_farneback_polynomial_expansion_sigma = 1.1;
 static const gdouble default_farneback_pyramid_scale = 0.5;
+static const gint default_farneback_warm_start = WARM_START_DISABLED;
+static const gdouble default_farneback_warm_start_tolerance = 0.05;
 static const gint default_farneback_window_size = 13;
 
+static const gint default_flow_scale = OPTICAL_FLOW_SCALE_1;
+
+static const gint default_late_frames = LATE_FRAMES_PROCESS;
+static const guint64 default_latency_budget = 0;
+
+static const gint default_motion_gate = MOTION_GATE_DISABLED;
+static const gint default_motion_gate_metric = MOTION_GATE_METRIC_SAD;
+static const gint default_motion_gate_subsample = 4;
+static const gint default_motion_gate_synthetic = MOTION_GATE_SYNTHETIC_ZERO;
+static const gdouble default_motion_gate_threshold = 0.01;
+
 static const gboolean default_nvidia_enable_cost_buffer = FALSE;
 static const gboolean default_nvidia_enable_external_hints = FALSE;
 static const gboolean default_nvidia_enable_temporal_hints = FALSE;
@@ -72,6 +98,26 @@ static const gint default_nvidia_performance_preset
 static const gint default_optical_flow_algorithm
     = OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0;
 
+static const gboolean default_roi_from_meta = FALSE;
+static const gchar *default_roi_mask_location = NULL;
+static const gchar *default_roi_polygons = NULL;
+
+/*
+ * The latency budget controller waits this many processed frames after each
+ * change of the quality level before it judges the new level, so that the
+ * cost of re-creating the algorithm and the warm-up of its caches are not
+ * mistaken for its steady-state processing time.
+ */
+static const guint quality_hold_frames = 30;
+
+/*
+ * NVIDIA optical flow 2.0 takes at most 8 regions of interest, which are
+ * aligned to its 16x16 macroblocks here. More regions are merged into their
+ * bounding rectangle.
+ */
+static const guint nvidia_roi_alignment = 16;
+static const gsize nvidia_roi_max = 8;
+
 // clang-format off
 /**
  * \brief Anonymous enumeration containing the list of properties available for
@@ -143,6 +189,29 @@ enum
     // clang-format on
     PROP_FARNEBACK_PYRAMID_SCALE,
 
+    // clang-format off
+    /**
+     * \brief ID number for the read-only Farneback Optical Flow statistics
+     * property.
+     */
+    // clang-format on
+    PROP_FARNEBACK_STATS,
+
+    // clang-format off
+    /**
+     * \brief ID number for the Farneback Optical Flow warm start property.
+     */
+    // clang-format on
+    PROP_FARNEBACK_WARM_START,
+
+    // clang-format off
+    /**
+     * \brief ID number for the Farneback Optical Flow warm start tolerance
+     * property.
+     */
+    // clang-format on
+    PROP_FARNEBACK_WARM_START_TOLERANCE,
+
     // clang-format off
     /**
      * \brief ID number for the Farneback Optical Flow window size property.
@@ -150,6 +219,69 @@ enum
     // clang-format on
     PROP_FARNEBACK_WINDOW_SIZE,
 
+    // clang-format off
+    /**
+     * \brief ID number for the optical flow scale property.
+     */
+    // clang-format on
+    PROP_FLOW_SCALE,
+
+    // clang-format off
+    /**
+     * \brief ID number for the late frames property.
+     */
+    // clang-format on
+    PROP_LATE_FRAMES,
+
+    // clang-format off
+    /**
+     * \brief ID number for the latency budget property.
+     */
+    // clang-format on
+    PROP_LATENCY_BUDGET,
+
+    // clang-format off
+    /**
+     * \brief ID number for the motion gate property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE,
+
+    // clang-format off
+    /**
+     * \brief ID number for the motion gate metric property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE_METRIC,
+
+    // clang-format off
+    /**
+     * \brief ID number for the read-only motion gate statistics property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE_STATS,
+
+    // clang-format off
+    /**
+     * \brief ID number for the motion gate subsample property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE_SUBSAMPLE,
+
+    // clang-format off
+    /**
+     * \brief ID number for the motion gate synthetic optical flow property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE_SYNTHETIC,
+
+    // clang-format off
+    /**
+     * \brief ID number for the motion gate threshold property.
+     */
+    // clang-format on
+    PROP_MOTION_GATE_THRESHOLD,
+
     // clang-format off
     /**
      * \brief ID number for the NVIDIA Optical Flow enable cost buffer
@@ -204,6 +336,34 @@ enum
     // clang-format on
     PROP_OPTICAL_FLOW_ALGORITHM,
 
+    // clang-format off
+    /**
+     * \brief ID number for the read-only quality level property.
+     */
+    // clang-format on
+    PROP_QUALITY_LEVEL,
+
+    // clang-format off
+    /**
+     * \brief ID number for the roi-from-meta property.
+     */
+    // clang-format on
+    PROP_ROI_FROM_META,
+
+    // clang-format off
+    /**
+     * \brief ID number for the roi-mask-location property.
+     */
+    // clang-format on
+    PROP_ROI_MASK_LOCATION,
+
+    // clang-format off
+    /**
+     * \brief ID number for the roi-polygons property.
+     */
+    // clang-format on
+    PROP_ROI_POLYGONS,
+
     // clang-format off
     /**
      * \brief Number of property ID numbers in this enum.
@@ -396,6 +556,26 @@ typedef struct _GstCudaOf
     // clang-format on
     gdouble farneback_pyramid_scale;
 
+    // clang-format off
+    /**
+     * \brief The mode for re-using the previous optical flow vectors as the
+     * initial estimate of the Farneback optical flow algorithm.
+     *
+     * \notes This sets cv::OPTFLOW_USE_INITIAL_FLOW for the frames that have
+     * a previous optical flow to start from, regardless of farneback_flags.
+     */
+    // clang-format on
+    gint farneback_warm_start;
+
+    // clang-format off
+    /**
+     * \brief The mean change, in pixels, of the optical flow vectors relative
+     * to their initial estimate below which the adaptive warm start lowers
+     * the number of iterations and levels.
+     */
+    // clang-format on
+    gdouble farneback_warm_start_tolerance;
+
     // clang-format off
     /**
      * \brief The window size to use for either the Gaussian Blur or Box
@@ -404,6 +584,71 @@ typedef struct _GstCudaOf
     // clang-format on
     gint farneback_window_size;
 
+    // clang-format off
+    /******************************** Latency *********************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief How frames that the QoS events received from downstream report
+     * as late are handled.
+     */
+    // clang-format on
+    gint late_frames;
+
+    // clang-format off
+    /**
+     * \brief The processing time per frame, in nanoseconds, the quality
+     * controller keeps the optical flow calculation within, or 0 to always
+     * use the configured parameters.
+     */
+    // clang-format on
+    guint64 latency_budget;
+
+    // clang-format off
+    /****************************** Motion Gate *******************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief The implementation of the motion gate, or MOTION_GATE_DISABLED
+     * to calculate the optical flow for every pair of frames.
+     */
+    // clang-format on
+    gint motion_gate;
+
+    // clang-format off
+    /**
+     * \brief The metric used by the motion gate to measure the difference
+     * between the current and the previous frame.
+     */
+    // clang-format on
+    gint motion_gate_metric;
+
+    // clang-format off
+    /**
+     * \brief The distance, in rows, between two rows of luma sampled by the
+     * motion gate.
+     */
+    // clang-format on
+    gint motion_gate_subsample;
+
+    // clang-format off
+    /**
+     * \brief The optical flow vectors attached to the frames skipped by the
+     * motion gate.
+     */
+    // clang-format on
+    gint motion_gate_synthetic;
+
+    // clang-format off
+    /**
+     * \brief The normalised difference, in the range [0, 1], below which the
+     * motion gate skips the calculation of the optical flow.
+     */
+    // clang-format on
+    gdouble motion_gate_threshold;
+
     // clang-format off
     /********************************* NVIDIA *********************************/
     // clang-format on
@@ -490,6 +735,17 @@ typedef struct _GstCudaOf
     /******************************* Algorithms *******************************/
     // clang-format on
 
+    // clang-format off
+    /**
+     * \brief The factor the width and height of the luma are divided by
+     * before the optical flow is calculated.
+     *
+     * \notes The optical flow vectors are scaled back up, so that they are
+     * always measured in pixels of the frame.
+     */
+    // clang-format on
+    gint flow_scale;
+
     // clang-format off
     /**
      * \brief The optical flow algorithm that will be used to perform optical
@@ -504,6 +760,35 @@ typedef struct _GstCudaOf
      */
     // clang-format on
     gint optical_flow_algorithm;
+
+    // clang-format off
+    /************************** Regions of Interest ***************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief A flag that determines if the GstVideoRegionOfInterestMeta
+     * instances attached to each buffer are used as regions of interest.
+     */
+    // clang-format on
+    gboolean roi_from_meta;
+
+    // clang-format off
+    /**
+     * \brief The path to an 8-bit image used as a bitmask of regions of
+     * interest, or NULL.
+     */
+    // clang-format on
+    gchar *roi_mask_location;
+
+    // clang-format off
+    /**
+     * \brief A list of polygons used as regions of interest, or NULL.
+     *
+     * \details See gst_cuda_of_roi_set_parse_polygons() for the format.
+     */
+    // clang-format on
+    gchar *roi_polygons;
 } GstCudaOf;
 
 // clang-format off
@@ -597,115 +882,362 @@ typedef struct _GstCudaOfPrivate
      */
     // clang-format on
     GstBuffer *prev_buffer;
-} GstCudaOfPrivate;
 
-// clang-format off
-/**
- * \brief The structure for the GstCudaOf GStreamer element type containing the
- * class' data.
- *
- * \details This structure contains class-level data and the virtual function
- * table for itself and its parent classes. This structure will be shared
- * between all instances of the GstCudaOf type.
- */
-// clang-format on
-typedef struct _GstCudaOfClass
-{
     // clang-format off
-    /********************************** Base **********************************/
+    /**
+     * \brief A pointer to the optical flow vectors last calculated by the
+     * optical flow algorithm.
+     *
+     * \notes These are shared with the metadata of the frames skipped by the
+     * motion gate when re-using the previous optical flow vectors.
+     */
     // clang-format on
+    cv::cuda::GpuMat *prev_optical_flow;
 
     // clang-format off
     /**
-     * \brief The parent class' structure.
-     *
-     * \details This is the structure for the parent class, containing the
-     * virtual function table and class-level data for the parent class. When a
-     * pointer to an instance of this class is cast to an instance to the
-     * parent class or any other classes higher up in the class hierarchy, only
-     * the variables and virtual functions available to that class will be
-     * available to be modified or used.
-     *
-     * \notes As per above, this relies on a bit of trickery regarding how C
-     * stores its data structures in memory. The order that the structures are
-     * defined here are the order they will be stored in memory by C. That
-     * allows us to "cheat" by casting a pointer to this structure to a pointer
-     * of the parent structure(s); thereby giving us an inheritance-like
-     * nature to these structures.
+     * \brief A pointer to the zero optical flow vectors shared with the
+     * metadata of the frames skipped by the motion gate.
      */
     // clang-format on
-    GstCudaBaseTransformClass parent_class;
-} GstCudaOfClass;
+    cv::cuda::GpuMat *zero_optical_flow;
 
-// clang-format off
-/**
- * \brief Exception representing errors utilising GStreamer's CUDA
- * methods/data-types.
- *
- * \details This exception represents serveral potential errors that can occur
- * during the usage of the GstCudaContext data-type, or other possible GStreamer
- * CUDA methods/data-types.
- */
-// clang-format on
-class GstCudaException : public std::logic_error
-{
-    public:
     // clang-format off
-    /************************ Public Member Functions *************************/
+    /******************************* Farneback ********************************/
     // clang-format on
 
     // clang-format off
     /**
-     * \brief Default constructor.
+     * \brief The number of iterations and levels the Farneback optical flow
+     * algorithm currently runs with.
      *
-     * \details Constructs an instance of this exception with the given
-     * message.
+     * \notes These only differ from the properties while the adaptive warm
+     * start has lowered them.
      */
     // clang-format on
-    explicit GstCudaException(const std::string &what_arg)
-        : std::logic_error(what_arg)
-    {
-    }
+    gint farneback_number_of_iterations;
+    gint farneback_number_of_levels;
 
     // clang-format off
     /**
-     * \brief Default constructor.
+     * \brief Scratch device memory holding the change of the optical flow
+     * vectors relative to their initial estimate.
+     */
+    // clang-format on
+    cv::cuda::GpuMat *farneback_scratch;
+
+    // clang-format off
+    /**
+     * \brief The number of frames calculated by the Farneback optical flow
+     * algorithm, how many of those were warm-started, and the accumulated and
+     * last convergence (mean change of the vectors relative to their initial
+     * estimate, in pixels) and processing time.
      *
-     * \details Constructs an instance of this exception with the given
-     * message.
+     * \notes These are protected by the object lock, as they are read from
+     * the application thread through the farneback-stats property.
      */
     // clang-format on
-    explicit GstCudaException(const char *what_arg) : std::logic_error(what_arg)
-    {
-    }
+    guint64 farneback_frames;
+    guint64 farneback_frames_warm_started;
+    gdouble farneback_total_residual;
+    gdouble farneback_last_residual;
+    GstClockTime farneback_total_time;
+    GstClockTime farneback_last_time;
+
+    // clang-format off
+    /******************************* Flow Scale *******************************/
+    // clang-format on
 
     // clang-format off
     /**
-     * \brief Copy constructor.
+     * \brief The downscaled luma of the current and the previous frame.
      *
-     * \details Constructs an instance of this exception with the message from
-     * another instance of this exception.
+     * \notes The two are swapped after each calculation, so that every frame
+     * is only downscaled once and no memory is allocated per frame.
      */
     // clang-format on
-    GstCudaException(const GstCudaException &other) noexcept
-        : GstCudaException(other.what())
-    {
-    }
+    cv::cuda::GpuMat *flow_scale_current;
+    cv::cuda::GpuMat *flow_scale_prev;
 
     // clang-format off
     /**
-     * \brief Returns the instance's message.
+     * \brief A flag that is set while flow_scale_prev holds the downscaled
+     * luma of the previous buffer.
      *
-     * \returns The instance's message.
+     * \notes This is cleared whenever a buffer is passed on without
+     * calculating its optical flow.
      */
     // clang-format on
-    const char *what() const noexcept override
-    {
-        return std::logic_error::what();
-    }
-};
+    gboolean flow_scale_has_prev;
 
-// clang-format off
+    // clang-format off
+    /******************************* Motion Gate ******************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief A flag that is set once the signature (sampled rows or
+     * histogram) of a frame was retained to compare the next frame to.
+     */
+    // clang-format on
+    gboolean motion_gate_has_reference;
+
+    // clang-format off
+    /**
+     * \brief The width and number of rows of the luma sampled by the motion
+     * gate.
+     */
+    // clang-format on
+    guint motion_gate_width;
+    guint motion_gate_rows;
+
+    // clang-format off
+    /**
+     * \brief Host copies of the luma rows sampled from the current and the
+     * previous frame by the CPU motion gate.
+     *
+     * \notes The two are swapped after each frame, so that the rows are
+     * downloaded exactly once and no memory is allocated per frame.
+     */
+    // clang-format on
+    guint8 *motion_gate_host_rows;
+    guint8 *motion_gate_prev_host_rows;
+
+    // clang-format off
+    /**
+     * \brief The luma histogram of the previous frame.
+     */
+    // clang-format on
+    guint32 motion_gate_prev_histogram[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS];
+
+    // clang-format off
+    /**
+     * \brief Scratch device memory of the CUDA motion gate, holding either the
+     * absolute differences or the histogram of the sampled luma.
+     */
+    // clang-format on
+    cv::cuda::GpuMat *motion_gate_scratch;
+
+    // clang-format off
+    /**
+     * \brief The number of frames compared by the motion gate, the number of
+     * those that were skipped and the difference measured for the last one.
+     *
+     * \notes These are protected by the object lock, as they are read from
+     * the application thread through the motion-gate-stats property.
+     */
+    // clang-format on
+    guint64 motion_gate_frames;
+    guint64 motion_gate_frames_skipped;
+    gdouble motion_gate_last_score;
+
+    // clang-format off
+    /********************************* Quality ********************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief The current quality level, from 0 (the configured parameters) to
+     * quality_max_level (the cheapest parameters the controller steps down
+     * to).
+     *
+     * \notes The quality level is protected by the object lock, as it is
+     * read from the application thread through the quality-level property.
+     */
+    // clang-format on
+    gint quality_level;
+    gint quality_max_level;
+
+    // clang-format off
+    /**
+     * \brief The parameters of the optical flow algorithms for the current
+     * quality level.
+     *
+     * \notes These equal the properties at quality level 0.
+     */
+    // clang-format on
+    gint quality_farneback_number_of_levels;
+    gint quality_farneback_window_size;
+    gint quality_nvidia_hint_vector_grid_size;
+    gint quality_nvidia_output_vector_grid_size;
+    gint quality_nvidia_performance_preset;
+
+    // clang-format off
+    /**
+     * \brief The moving average of the processing time per frame at the
+     * current quality level, or GST_CLOCK_TIME_NONE if no frame was processed
+     * at this level yet.
+     */
+    // clang-format on
+    GstClockTime quality_processing_time;
+
+    // clang-format off
+    /**
+     * \brief The number of processed frames left before the controller
+     * judges the current quality level.
+     */
+    // clang-format on
+    guint quality_hold;
+
+    // clang-format off
+    /**
+     * \brief The earliest running time, and the proportion, reported by the
+     * last QoS event received from downstream, and the number of frames
+     * processed and dropped since.
+     *
+     * \notes These are protected by the object lock, as QoS events arrive on
+     * the streaming thread of the source pad.
+     */
+    // clang-format on
+    GstClockTime qos_earliest_time;
+    gdouble qos_proportion;
+    guint64 qos_processed;
+    guint64 qos_dropped;
+
+    // clang-format off
+    /************************** Regions of Interest ***************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief The regions of interest loaded from the roi-mask-location and
+     * roi-polygons properties on start, or NULL if there are none.
+     */
+    // clang-format on
+    GstCudaOfRoiSet *static_roi_set;
+
+    // clang-format off
+    /**
+     * \brief The regions of interest of the current frame, or NULL if the
+     * whole frame is processed.
+     *
+     * \notes NVIDIA optical flow 2.0 takes its regions on creation, so the
+     * algorithm is created again whenever they change.
+     */
+    // clang-format on
+    GstCudaOfRoiSet *roi_set;
+
+    // clang-format off
+    /**
+     * \brief The rectangle of the downscaled luma the Farneback optical flow
+     * is calculated on, covering the regions of interest plus a margin.
+     *
+     * \notes This covers the whole luma if there are no regions of interest.
+     */
+    // clang-format on
+    gint roi_x;
+    gint roi_y;
+    gint roi_width;
+    gint roi_height;
+} GstCudaOfPrivate;
+
+// clang-format off
+/**
+ * \brief The structure for the GstCudaOf GStreamer element type containing the
+ * class' data.
+ *
+ * \details This structure contains class-level data and the virtual function
+ * table for itself and its parent classes. This structure will be shared
+ * between all instances of the GstCudaOf type.
+ */
+// clang-format on
+typedef struct _GstCudaOfClass
+{
+    // clang-format off
+    /********************************** Base **********************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief The parent class' structure.
+     *
+     * \details This is the structure for the parent class, containing the
+     * virtual function table and class-level data for the parent class. When a
+     * pointer to an instance of this class is cast to an instance to the
+     * parent class or any other classes higher up in the class hierarchy, only
+     * the variables and virtual functions available to that class will be
+     * available to be modified or used.
+     *
+     * \notes As per above, this relies on a bit of trickery regarding how C
+     * stores its data structures in memory. The order that the structures are
+     * defined here are the order they will be stored in memory by C. That
+     * allows us to "cheat" by casting a pointer to this structure to a pointer
+     * of the parent structure(s); thereby giving us an inheritance-like
+     * nature to these structures.
+     */
+    // clang-format on
+    GstCudaBaseTransformClass parent_class;
+} GstCudaOfClass;
+
+// clang-format off
+/**
+ * \brief Exception representing errors utilising GStreamer's CUDA
+ * methods/data-types.
+ *
+ * \details This exception represents serveral potential errors that can occur
+ * during the usage of the GstCudaContext data-type, or other possible GStreamer
+ * CUDA methods/data-types.
+ */
+// clang-format on
+class GstCudaException : public std::logic_error
+{
+    public:
+    // clang-format off
+    /************************ Public Member Functions *************************/
+    // clang-format on
+
+    // clang-format off
+    /**
+     * \brief Default constructor.
+     *
+     * \details Constructs an instance of this exception with the given
+     * message.
+     */
+    // clang-format on
+    explicit GstCudaException(const std::string &what_arg)
+        : std::logic_error(what_arg)
+    {
+    }
+
+    // clang-format off
+    /**
+     * \brief Default constructor.
+     *
+     * \details Constructs an instance of this exception with the given
+     * message.
+     */
+    // clang-format on
+    explicit GstCudaException(const char *what_arg) : std::logic_error(what_arg)
+    {
+    }
+
+    // clang-format off
+    /**
+     * \brief Copy constructor.
+     *
+     * \details Constructs an instance of this exception with the message from
+     * another instance of this exception.
+     */
+    // clang-format on
+    GstCudaException(const GstCudaException &other) noexcept
+        : GstCudaException(other.what())
+    {
+    }
+
+    // clang-format off
+    /**
+     * \brief Returns the instance's message.
+     *
+     * \returns The instance's message.
+     */
+    // clang-format on
+    const char *what() const noexcept override
+    {
+        return std::logic_error::what();
+    }
+};
+
+// clang-format off
 /*************************** Function Declarations ****************************/
 // clang-format on
 
@@ -741,6 +1273,52 @@ static cv::cuda::GpuMat gst_cuda_of_calculate_optical_flow(
     GstBuffer *current_buffer,
     GstBuffer *previous_buffer);
 
+// clang-format off
+/**
+ * \brief Calculates the Farneback optical flow between two frames, starting
+ * from the previous optical flow vectors if warm start is enabled.
+ *
+ * \details If warm start is enabled and the previous optical flow vectors
+ * match the frames, they are copied into the output matrix and passed to the
+ * algorithm with cv::OPTFLOW_USE_INITIAL_FLOW. The mean change of the vectors
+ * relative to that estimate is measured as the convergence of the frame, and
+ * the adaptive mode uses it to step the number of iterations and levels down
+ * while it stays below the tolerance, and back up otherwise.
+ *
+ * \details The convergence and the processing time of the frame are added to
+ * the statistics reported by the farneback-stats property.
+ *
+ * \details Only the given rectangle of the luma is processed. The vectors
+ * outside of it are zero.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ * \param[in] current_gpu_mat The luma of the current frame.
+ * \param[in] prev_gpu_mat The luma of the previous frame.
+ * \param[in] roi The rectangle of the luma to calculate the optical flow for.
+ *
+ * \exception cv::Exception If an error occurred during the usage of the
+ * OpenCV optical flow algorithm.
+ *
+ * \returns A cv::cuda::GpuMat instance, representing a 2-channel 2D matrix of
+ * 32-bit floating point vectors hosted on the GPU.
+ */
+// clang-format on
+static cv::cuda::GpuMat gst_cuda_of_calculate_farneback_optical_flow(
+    GstCudaOf *self,
+    const cv::cuda::GpuMat &current_gpu_mat,
+    const cv::cuda::GpuMat &prev_gpu_mat,
+    const cv::Rect &roi);
+
+// clang-format off
+/**
+ * \brief Finalisation method for the GstCudaOf GObject type.
+ *
+ * \param[in,out] gobject A GstCudaOf GObject instance to release the
+ * property strings from.
+ */
+// clang-format on
+static void gst_cuda_of_finalize(GObject *gobject);
+
 // clang-format off
 /**
  * \brief Extracts the GstCudaMemory pointer from a buffer.
@@ -764,6 +1342,17 @@ static cv::cuda::GpuMat gst_cuda_of_calculate_optical_flow(
 static GstCudaMemory *
 gst_cuda_of_get_cuda_memory(GstCudaOf *self, GstBuffer *buf);
 
+// clang-format off
+/**
+ * \brief Retrieves the size of the luma the optical flow is calculated on.
+ *
+ * \param[in] self An instance of the GstCudaOf GObject type.
+ *
+ * \returns The size of the frames divided by the flow-scale property.
+ */
+// clang-format on
+static cv::Size gst_cuda_of_get_flow_size(GstCudaOf *self);
+
 // clang-format off
 /**
  * \brief Wrapper around gst_cuda_of_get_instance_private.
@@ -806,6 +1395,19 @@ static void gst_cuda_of_get_property(
     GValue *value,
     GParamSpec *pspec);
 
+// clang-format off
+/**
+ * \brief Retrieves the vector grid size of the optical flow vectors produced
+ * by the selected optical flow algorithm.
+ *
+ * \param[in] self An instance of the GstCudaOf GObject type.
+ *
+ * \returns The number of pixels of the frame along each side of the square
+ * covered by a single optical flow vector, including the flow-scale.
+ */
+// clang-format on
+static gint gst_cuda_of_get_vector_grid_size(GstCudaOf *self);
+
 // clang-format off
 /**
  * \brief Initialisation function for the optical flow algorithms.
@@ -836,6 +1438,90 @@ static void gst_cuda_of_get_property(
 static void
 gst_cuda_of_init_algorithm(GstCudaOf *self, GstCudaOfAlgorithm algorithm_type);
 
+// clang-format off
+/**
+ * \brief Determines whether a buffer is late according to the last QoS event
+ * received from downstream.
+ *
+ * \param[in] self An instance of the GstCudaOf GObject type.
+ * \param[in] buffer The buffer being processed by the element.
+ * \param[out] running_time The running time of the buffer, or
+ * GST_CLOCK_TIME_NONE if it has none.
+ *
+ * \returns TRUE if the running time of the buffer lies before the earliest
+ * time downstream can still display. FALSE otherwise, or if no QoS event was
+ * received yet.
+ */
+// clang-format on
+static gboolean gst_cuda_of_is_late(
+    GstCudaOf *self,
+    GstBuffer *buffer,
+    GstClockTime *running_time);
+
+// clang-format off
+/**
+ * \brief Loads the regions of interest from the roi-mask-location and
+ * roi-polygons properties.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ *
+ * \returns TRUE if the regions were loaded, FALSE if the bitmask could not be
+ * read or the polygons could not be parsed.
+ */
+// clang-format on
+static gboolean gst_cuda_of_load_roi_set(GstCudaOf *self);
+
+// clang-format off
+/**
+ * \brief Decides whether the optical flow between the previous and current
+ * buffers needs to be calculated.
+ *
+ * \details Every motion-gate-subsample-th row of the luma of the current
+ * buffer is compared to the same rows of the previous buffer, using either
+ * their mean absolute difference or the distance between their histograms.
+ * If the difference is below the motion-gate-threshold, the buffer is
+ * considered static.
+ *
+ * \details The CPU implementation downloads the sampled rows with a single
+ * strided copy and compares them to the rows retained from the previous
+ * buffer. The CUDA implementation compares the rows on the GPU and only
+ * downloads the result.
+ *
+ * \details The signature of the current buffer is retained, and the
+ * statistics of the motion gate are updated.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ * \param[in] current_buffer The current buffer being processed by the
+ * element.
+ * \param[in] previous_buffer The previous buffer that has been processed by
+ * the element, or NULL for the first buffer.
+ *
+ * \exception cv::Exception If an error occurred during the usage of one of
+ * the OpenCV CUDA functions.
+ *
+ * \returns TRUE if the calculation of the optical flow can be skipped. FALSE
+ * if it is required, or if there is nothing to compare the buffer to yet.
+ */
+// clang-format on
+static gboolean gst_cuda_of_motion_gate_check(
+    GstCudaOf *self,
+    GstBuffer *current_buffer,
+    GstBuffer *previous_buffer);
+
+// clang-format off
+/**
+ * \brief Releases the host and device memory held across frames: the previous
+ * and synthetic optical flow vectors, the downscaled luma, and the scratch
+ * memory of the motion gate and the Farneback warm start.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ *
+ * \notes The CUDA context of the element must be pushed, if the device memory
+ * was allocated.
+ */
+// clang-format on
+static void gst_cuda_of_motion_gate_clear(GstCudaOf *self);
+
 // clang-format off
 /**
  * \brief Property setter for instances of the GstCudaOf GObject.
@@ -861,6 +1547,60 @@ static void gst_cuda_of_set_property(
     const GValue *value,
     GParamSpec *pspec);
 
+// clang-format off
+/**
+ * \brief Sets the quality level, and derives the parameters of the optical
+ * flow algorithms from it.
+ *
+ * \details Each level above 0 makes the calculation cheaper by one step. For
+ * Farneback, a step removes one level from the Gaussian pyramids and shrinks
+ * the window by 2 pixels. For the NVIDIA algorithms, a step moves the
+ * performance preset towards FAST first, and then, for NVIDIA optical flow
+ * 2.0, makes the output vector grid coarser.
+ *
+ * \details The NVIDIA algorithms can only change these parameters on
+ * creation, so they are re-created before the next frame if any of them
+ * changed.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ * \param[in] quality_level The quality level, which is clamped to the range
+ * [0, quality_max_level].
+ */
+// clang-format on
+static void gst_cuda_of_set_quality_level(GstCudaOf *self, gint quality_level);
+
+// clang-format off
+/**
+ * \brief Handles the events received on the sink pad of the element.
+ *
+ * \details The QoS state is reset on a flush, as the running times reported
+ * before it no longer apply. All events are then passed on to the parent
+ * class' implementation.
+ *
+ * \param[in] trans A GstCudaOf GObject instance.
+ * \param[in] event The event received on the sink pad.
+ *
+ * \returns The result of the parent class' implementation.
+ */
+// clang-format on
+static gboolean gst_cuda_of_sink_event(GstBaseTransform *trans, GstEvent *event);
+
+// clang-format off
+/**
+ * \brief Handles the events received on the source pad of the element.
+ *
+ * \details The earliest running time downstream can still display is taken
+ * from QoS events, so that late frames can be dropped or skipped. All events
+ * are then passed on to the parent class' implementation.
+ *
+ * \param[in] trans A GstCudaOf GObject instance.
+ * \param[in] event The event received on the source pad.
+ *
+ * \returns The result of the parent class' implementation.
+ */
+// clang-format on
+static gboolean gst_cuda_of_src_event(GstBaseTransform *trans, GstEvent *event);
+
 // clang-format off
 /**
  * \brief Sets up the element to begin processing.
@@ -899,6 +1639,28 @@ static gboolean gst_cuda_of_start(GstBaseTransform *trans);
 // clang-format on
 static gboolean gst_cuda_of_stop(GstBaseTransform *trans);
 
+// clang-format off
+/**
+ * \brief Returns the optical flow vectors to attach to a buffer skipped by
+ * the motion gate.
+ *
+ * \details Depending on the motion-gate-synthetic property, this is either
+ * the last optical flow vectors calculated by the optical flow algorithm or a
+ * matrix of zero vectors of the size and type the algorithm currently
+ * produces. The zero vectors are allocated once and shared between all
+ * skipped buffers.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ *
+ * \exception cv::Exception If an error occurred while allocating the zero
+ * vectors.
+ *
+ * \returns A cv::cuda::GpuMat instance sharing the synthetic optical flow
+ * vectors.
+ */
+// clang-format on
+static cv::cuda::GpuMat gst_cuda_of_synthetic_optical_flow(GstCudaOf *self);
+
 // clang-format off
 /**
  * \brief Calculates the optical flow between the previous and current buffers,
@@ -935,6 +1697,43 @@ static GstFlowReturn gst_cuda_of_transform(
     GstBuffer *inbuf,
     GstBuffer *outbuf);
 
+// clang-format off
+/**
+ * \brief Adds the processing time of a frame to the moving average of the
+ * current quality level, and steps the quality level down or up to keep it
+ * within the latency budget.
+ *
+ * \details The quality level is stepped down (made cheaper) while the
+ * average exceeds the budget, and stepped up again once it falls below half
+ * of the budget. After each step, the controller waits for
+ * quality_hold_frames frames before judging the new level, and posts a
+ * "cudaof-quality" element message describing it.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ * \param[in] processing_time The time it took to process the frame.
+ */
+// clang-format on
+static void
+gst_cuda_of_update_quality(GstCudaOf *self, GstClockTime processing_time);
+
+// clang-format off
+/**
+ * \brief Gathers the regions of interest for a frame.
+ *
+ * \details The regions loaded from the properties are combined with the
+ * GstVideoRegionOfInterestMeta instances of the buffer, if the roi-from-meta
+ * property is enabled. The Farneback rectangle is set to the bounding
+ * rectangle of the regions, grown by twice the window size so that the
+ * window of the finest level stays within it along the border of the
+ * regions. If the regions changed, the NVIDIA optical flow 2.0 algorithm is
+ * released to be created again with them.
+ *
+ * \param[in,out] self An instance of the GstCudaOf GObject type.
+ * \param[in] buffer The buffer of the current frame.
+ */
+// clang-format on
+static void gst_cuda_of_update_roi_set(GstCudaOf *self, GstBuffer *buffer);
+
 // clang-format off
 /************************** GObject Type Definitions **************************/
 // clang-format on
@@ -1004,19 +1803,63 @@ static cv::cuda::GpuMat gst_cuda_of_calculate_optical_flow(
                 prev_buffer_map_info.data,
                 prev_buffer_cuda_memory->stride);
 
+            /*
+             * The area interpolation of an integer factor averages each block
+             * of pixels in a single pass straight out of the luma plane of
+             * the NV12 buffer. The previous frame was already downscaled when
+             * it was the current frame, so only one frame is downscaled per
+             * calculation.
+             */
+            if(self->flow_scale > OPTICAL_FLOW_SCALE_1)
+            {
+                cv::Size flow_size = gst_cuda_of_get_flow_size(self);
+
+                if(self_private->flow_scale_current == nullptr)
+                {
+                    self_private->flow_scale_current = new cv::cuda::GpuMat();
+                    self_private->flow_scale_prev = new cv::cuda::GpuMat();
+                }
+
+                cv::cuda::resize(
+                    current_buffer_gpu_mat,
+                    *(self_private->flow_scale_current),
+                    flow_size,
+                    0.0,
+                    0.0,
+                    cv::INTER_AREA);
+
+                if(!self_private->flow_scale_has_prev)
+                {
+                    cv::cuda::resize(
+                        prev_buffer_gpu_mat,
+                        *(self_private->flow_scale_prev),
+                        flow_size,
+                        0.0,
+                        0.0,
+                        cv::INTER_AREA);
+                }
+
+                current_buffer_gpu_mat = *(self_private->flow_scale_current);
+                prev_buffer_gpu_mat = *(self_private->flow_scale_prev);
+            }
+
             switch(self->optical_flow_algorithm)
             {
                 case OPTICAL_FLOW_ALGORITHM_FARNEBACK:
                     {
-                        optical_flow_gpu_mat = cv::cuda::GpuMat(
-                            self->parent.in_info.height,
-                            self->parent.in_info.width,
-                            CV_32FC2);
-                        self_private->algorithms.dense_optical_flow_algorithm
-                            ->calc(
-                                prev_buffer_gpu_mat,
+                        optical_flow_gpu_mat
+                            = gst_cuda_of_calculate_farneback_optical_flow(
+                                self,
                                 current_buffer_gpu_mat,
-                                optical_flow_gpu_mat);
+                                prev_buffer_gpu_mat,
+                                cv::Rect(
+                                    self_private->roi_x,
+                                    self_private->roi_y,
+                                    self_private->roi_width,
+                                    self_private->roi_height)
+                                    & cv::Rect(
+                                        cv::Point(0, 0),
+                                        current_buffer_gpu_mat.size()));
                     }
                     break;
                 case OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0:
@@ -1040,6 +1883,27 @@ static cv::cuda::GpuMat gst_cuda_of_calculate_optical_flow(
                 default:
                     break;
             }
+
+            /*
+             * The Farneback vectors are already scaled up, as the warm start
+             * compares them to the previous vectors.
+             */
+            if(self->flow_scale > OPTICAL_FLOW_SCALE_1
+               && self->optical_flow_algorithm
+                      != OPTICAL_FLOW_ALGORITHM_FARNEBACK
+               && !optical_flow_gpu_mat.empty())
+            {
+                optical_flow_gpu_mat.convertTo(
+                    optical_flow_gpu_mat, -1, (gdouble)self->flow_scale);
+            }
+
+            if(self->flow_scale > OPTICAL_FLOW_SCALE_1)
+            {
+                std::swap(
+                    self_private->flow_scale_current,
+                    self_private->flow_scale_prev);
+                self_private->flow_scale_has_prev = TRUE;
+            }
         }
 
         if(current_buffer_map_result)
@@ -1060,6 +1924,217 @@ static cv::cuda::GpuMat gst_cuda_of_calculate_optical_flow(
     return optical_flow_gpu_mat;
 }
 
+static cv::cuda::GpuMat gst_cuda_of_calculate_farneback_optical_flow(
+    GstCudaOf *self,
+    const cv::cuda::GpuMat &current_gpu_mat,
+    const cv::cuda::GpuMat &prev_gpu_mat,
+    const cv::Rect &roi)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    cv::Ptr<cv::cuda::FarnebackOpticalFlow> farneback
+        = self_private->algorithms.dense_optical_flow_algorithm
+              .dynamicCast<cv::cuda::FarnebackOpticalFlow>();
+    cv::cuda::GpuMat *prev_optical_flow = self_private->prev_optical_flow;
+    cv::cuda::GpuMat optical_flow_gpu_mat;
+    cv::cuda::GpuMat prev_roi_optical_flow;
+    gboolean full_frame = roi.size() == current_gpu_mat.size();
+    gboolean warm_start = FALSE;
+    gdouble residual = 0.0;
+    gint64 start_time = 0;
+    GstClockTime elapsed = 0;
+
+    warm_start = self->farneback_warm_start != WARM_START_DISABLED
+                 && !farneback.empty() && prev_optical_flow != nullptr
+                 && !prev_optical_flow->empty()
+                 && prev_optical_flow->type() == CV_32FC2
+                 && prev_optical_flow->size() == current_gpu_mat.size();
+
+    if(warm_start)
+    {
+        prev_roi_optical_flow = (*prev_optical_flow)(roi);
+    }
+
+    if(!warm_start)
+    {
+        self_private->farneback_number_of_iterations
+            = self->farneback_number_of_iterations;
+        self_private->farneback_number_of_levels
+            = self_private->quality_farneback_number_of_levels;
+    }
+    else
+    {
+        /*
+         * The latency budget controller may have lowered the number of
+         * levels since the previous frame.
+         */
+        self_private->farneback_number_of_levels
+            = MIN(self_private->farneback_number_of_levels,
+                  self_private->quality_farneback_number_of_levels);
+    }
+
+    start_time = g_get_monotonic_time();
+
+    /*
+     * The previous optical flow vectors are still referenced by the metadata
+     * of the previous buffer, so the algorithm refines a copy of them rather
+     * than the vectors themselves.
+     */
+    if(warm_start)
+    {
+        if(self->flow_scale > OPTICAL_FLOW_SCALE_1)
+        {
+            prev_roi_optical_flow.convertTo(
+                optical_flow_gpu_mat, -1, 1.0 / (gdouble)self->flow_scale);
+        }
+        else
+        {
+            prev_roi_optical_flow.copyTo(optical_flow_gpu_mat);
+        }
+        farneback->setFlags(self->farneback_flags | cv::OPTFLOW_USE_INITIAL_FLOW);
+    }
+    else
+    {
+        optical_flow_gpu_mat = cv::cuda::GpuMat(roi.size(), CV_32FC2);
+
+        /*
+         * With warm start disabled, the flags are used exactly as configured,
+         * so cv::OPTFLOW_USE_INITIAL_FLOW is only cleared for the frames that
+         * have no previous optical flow to start from.
+         */
+        if(self->farneback_warm_start != WARM_START_DISABLED
+           && !farneback.empty())
+        {
+            farneback->setFlags(
+                self->farneback_flags & ~cv::OPTFLOW_USE_INITIAL_FLOW);
+        }
+    }
+
+    if(!farneback.empty())
+    {
+        farneback->setNumIters(self_private->farneback_number_of_iterations);
+        farneback->setNumLevels(self_private->farneback_number_of_levels);
+        farneback->setWinSize(self_private->quality_farneback_window_size);
+    }
+
+    self_private->algorithms.dense_optical_flow_algorithm->calc(
+        prev_gpu_mat(roi), current_gpu_mat(roi), optical_flow_gpu_mat);
+
+    /*
+     * Vectors calculated on downscaled luma are scaled back up to pixels of
+     * the frame, so the convergence and everything downstream are measured
+     * in the same units at any flow-scale.
+     */
+    if(self->flow_scale > OPTICAL_FLOW_SCALE_1)
+    {
+        optical_flow_gpu_mat.convertTo(
+            optical_flow_gpu_mat, -1, (gdouble)self->flow_scale);
+    }
+
+    if(warm_start)
+    {
+        cv::Scalar sum;
+
+        if(self_private->farneback_scratch == nullptr)
+        {
+            self_private->farneback_scratch = new cv::cuda::GpuMat();
+        }
+
+        cv::cuda::absdiff(
+            optical_flow_gpu_mat,
+            prev_roi_optical_flow,
+            *(self_private->farneback_scratch));
+        sum = cv::cuda::sum(*(self_private->farneback_scratch));
+        residual = (sum[0] + sum[1]) / (gdouble)optical_flow_gpu_mat.total();
+    }
+
+    /*
+     * Downstream expects one vector per pixel of the luma, so the vectors of
+     * the rectangle are placed into a zeroed matrix of the full size. The
+     * previous matrix may still be referenced by metadata, so a new one is
+     * allocated.
+     */
+    if(!full_frame)
+    {
+        cv::cuda::GpuMat roi_optical_flow_gpu_mat = optical_flow_gpu_mat;
+
+        optical_flow_gpu_mat = cv::cuda::GpuMat(
+            current_gpu_mat.size(), CV_32FC2, cv::Scalar::all(0));
+        roi_optical_flow_gpu_mat.copyTo(optical_flow_gpu_mat(roi));
+    }
+
+    cv::cuda::Stream::Null().waitForCompletion();
+    elapsed = (GstClockTime)(g_get_monotonic_time() - start_time) * GST_USECOND;
+
+    GST_LOG_OBJECT(
+        self,
+        "Farneback %s with %d iterations and %d levels, convergence %f, "
+        "took %" GST_TIME_FORMAT,
+        warm_start ? "warm-started" : "cold-started",
+        self_private->farneback_number_of_iterations,
+        self_private->farneback_number_of_levels,
+        residual,
+        GST_TIME_ARGS(elapsed));
+
+    /*
+     * The change relative to the estimate measures both how far the algorithm
+     * still had to move and how much the motion itself changed. While it is
+     * small, fewer iterations and levels are enough to get there; the levels
+     * only matter for displacements the estimate does not already cover. If
+     * it is large, the estimate was poor, e.g. after a scene cut, and the
+     * configured values are restored at once.
+     */
+    if(warm_start && self->farneback_warm_start == WARM_START_ADAPTIVE)
+    {
+        if(residual <= self->farneback_warm_start_tolerance)
+        {
+            if(self_private->farneback_number_of_iterations > 1)
+            {
+                self_private->farneback_number_of_iterations--;
+            }
+            else if(self_private->farneback_number_of_levels > 1)
+            {
+                self_private->farneback_number_of_levels--;
+            }
+        }
+        else if(residual <= 4.0 * self->farneback_warm_start_tolerance)
+        {
+            if(self_private->farneback_number_of_levels
+               < self_private->quality_farneback_number_of_levels)
+            {
+                self_private->farneback_number_of_levels++;
+            }
+            else if(
+                self_private->farneback_number_of_iterations
+                < self->farneback_number_of_iterations)
+            {
+                self_private->farneback_number_of_iterations++;
+            }
+        }
+        else
+        {
+            self_private->farneback_number_of_iterations
+                = self->farneback_number_of_iterations;
+            self_private->farneback_number_of_levels
+                = self_private->quality_farneback_number_of_levels;
+        }
+    }
+
+    GST_OBJECT_LOCK(self);
+    self_private->farneback_frames++;
+    if(warm_start)
+    {
+        self_private->farneback_frames_warm_started++;
+        self_private->farneback_total_residual += residual;
+        self_private->farneback_last_residual = residual;
+    }
+    self_private->farneback_total_time += elapsed;
+    self_private->farneback_last_time = elapsed;
+    GST_OBJECT_UNLOCK(self);
+
+    return optical_flow_gpu_mat;
+}
+
 // clang-format off
 /**
  * \brief Initialisation function for the GstCudaOfClass GObjectClass type.
@@ -1100,6 +2175,7 @@ static void gst_cuda_of_class_init(GstCudaOfClass *klass)
 
     gobject_class->set_property = GST_DEBUG_FUNCPTR(gst_cuda_of_set_property);
     gobject_class->get_property = GST_DEBUG_FUNCPTR(gst_cuda_of_get_property);
+    gobject_class->finalize = GST_DEBUG_FUNCPTR(gst_cuda_of_finalize);
 
     properties[PROP_DEVICE_ID] = g_param_spec_int(
         "cuda-device-id",
@@ -1169,25 +2245,173 @@ static void gst_cuda_of_class_init(GstCudaOfClass *klass)
         default_farneback_polynomial_expansion_sigma,
         (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
 
-    properties[PROP_FARNEBACK_PYRAMID_SCALE] = g_param_spec_double(
-        "farneback-pyramid-scale",
-        "Farneback Pyramid Scale",
-        "Sets the scale for the pyramid, which is used to determine the number "
-        "of levels used for the pyramid. If using the fast pyramids setting, "
-        "the value for the pyramid scale must be 0.5.",
-        0.0f,
-        G_MAXDOUBLE,
-        default_farneback_pyramid_scale,
+    properties[PROP_FARNEBACK_PYRAMID_SCALE] = g_param_spec_double(
+        "farneback-pyramid-scale",
+        "Farneback Pyramid Scale",
+        "Sets the scale for the pyramid, which is used to determine the number "
+        "of levels used for the pyramid. If using the fast pyramids setting, "
+        "the value for the pyramid scale must be 0.5.",
+        0.0f,
+        G_MAXDOUBLE,
+        default_farneback_pyramid_scale,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_STATS] = g_param_spec_boxed(
+        "farneback-stats",
+        "Farneback Statistics",
+        "Statistics of the Farneback optical flow algorithm: the number of "
+        "frames calculated (frames) and warm-started (warm-started), the last "
+        "and mean convergence of the warm-started frames in pixels "
+        "(last-convergence, mean-convergence), the last and mean processing "
+        "time per frame (last-time, mean-time) and the number of iterations "
+        "and levels currently used (number-of-iterations, number-of-levels).",
+        GST_TYPE_STRUCTURE,
+        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_WARM_START] = g_param_spec_enum(
+        "farneback-warm-start",
+        "Farneback Warm Start",
+        "Uses the optical flow vectors of the previous frame as the initial "
+        "estimate of the Farneback optical flow algorithm (enabled). The "
+        "adaptive mode also lowers the number of iterations and levels while "
+        "the vectors converge close to that estimate (adaptive).",
+        gst_cuda_of_warm_start_get_type(),
+        default_farneback_warm_start,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_WARM_START_TOLERANCE] = g_param_spec_double(
+        "farneback-warm-start-tolerance",
+        "Farneback Warm Start Tolerance",
+        "Sets the mean change, in pixels, of the optical flow vectors relative "
+        "to their initial estimate below which the adaptive warm start lowers "
+        "the number of iterations and levels.",
+        0.0,
+        G_MAXDOUBLE,
+        default_farneback_warm_start_tolerance,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_WINDOW_SIZE] = g_param_spec_int(
+        "farneback-window-size",
+        "Farneback Window Size",
+        "Sets the size of the window that is used for the Gaussian Blur or Box "
+        "filters .",
+        0,
+        G_MAXINT,
+        default_farneback_window_size,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    /*
+     * The feature extractor only looks at a coarse grid of magnitudes, so
+     * most of a full resolution optical flow is averaged away again. A
+     * quarter of the resolution costs a sixteenth of the compute and memory,
+     * for all of the algorithms.
+     */
+    properties[PROP_FLOW_SCALE] = g_param_spec_enum(
+        "flow-scale",
+        "Optical Flow Scale",
+        "Sets the resolution, relative to the frames, the optical flow is "
+        "calculated at. The luma is downscaled before the calculation and "
+        "each optical flow vector covers correspondingly more pixels; the "
+        "vectors themselves are still measured in pixels of the frame.",
+        gst_cuda_of_flow_scale_get_type(),
+        default_flow_scale,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_LATE_FRAMES] = g_param_spec_enum(
+        "late-frames",
+        "Late Frames",
+        "Sets how frames that downstream reports as late through QoS events "
+        "are handled: processed as usual (process), dropped (drop) or passed "
+        "on with synthetic optical flow vectors (skip).",
+        gst_cuda_of_late_frames_get_type(),
+        default_late_frames,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    /*
+     * The parameters of the optical flow algorithms are chosen for the best
+     * vectors a deployment can afford, but the load on a shared GPU is not
+     * constant. Rather than falling further behind, the controller trades
+     * some accuracy for time while the GPU is busy, and takes it back once
+     * it is not.
+     */
+    properties[PROP_LATENCY_BUDGET] = g_param_spec_uint64(
+        "latency-budget",
+        "Latency Budget",
+        "Sets the processing time per frame, in nanoseconds, to keep the "
+        "optical flow calculation within by stepping the quality of the "
+        "algorithm parameters down or up (0 = always use the configured "
+        "parameters).",
+        0,
+        G_MAXUINT64,
+        default_latency_budget,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    /*
+     * Most of the camera hours we process are static scenes, where the
+     * optical flow algorithms spend most of their time confirming that
+     * nothing moved. The motion gate compares a sample of the luma first and
+     * only runs the algorithm if enough of it changed.
+     */
+    properties[PROP_MOTION_GATE] = g_param_spec_enum(
+        "motion-gate",
+        "Motion Gate",
+        "Skips the optical flow calculation for frames that barely differ "
+        "from the previous frame. The difference is measured either on the "
+        "host (cpu) or on the GPU (cuda).",
+        gst_cuda_of_motion_gate_get_type(),
+        default_motion_gate,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_MOTION_GATE_METRIC] = g_param_spec_enum(
+        "motion-gate-metric",
+        "Motion Gate Metric",
+        "Sets the metric the motion gate uses to measure the difference "
+        "between two frames: the mean absolute difference of the sampled luma "
+        "(sad) or the distance between the histograms of the sampled luma "
+        "(histogram).",
+        gst_cuda_of_motion_gate_metric_get_type(),
+        default_motion_gate_metric,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_MOTION_GATE_STATS] = g_param_spec_boxed(
+        "motion-gate-stats",
+        "Motion Gate Statistics",
+        "Statistics of the motion gate: the number of frames compared "
+        "(frames), the number of those skipped (skipped), the ratio of the "
+        "two (skip-rate) and the difference measured for the last frame "
+        "(last-score).",
+        GST_TYPE_STRUCTURE,
+        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_MOTION_GATE_SUBSAMPLE] = g_param_spec_int(
+        "motion-gate-subsample",
+        "Motion Gate Subsample",
+        "Sets the distance, in rows, between two rows of luma compared by the "
+        "motion gate.",
+        1,
+        64,
+        default_motion_gate_subsample,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_MOTION_GATE_SYNTHETIC] = g_param_spec_enum(
+        "motion-gate-synthetic",
+        "Motion Gate Synthetic Optical Flow",
+        "Sets the optical flow vectors attached to frames skipped by the "
+        "motion gate: zero vectors (zero) or the last calculated vectors "
+        "(reuse). The metadata of these frames is flagged as synthetic and "
+        "its vectors are shared, so they must not be modified.",
+        gst_cuda_of_motion_gate_synthetic_get_type(),
+        default_motion_gate_synthetic,
         (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
 
-    properties[PROP_FARNEBACK_WINDOW_SIZE] = g_param_spec_int(
-        "farneback-window-size",
-        "Farneback Window Size",
-        "Sets the size of the window that is used for the Gaussian Blur or Box "
-        "filters .",
-        0,
-        G_MAXINT,
-        default_farneback_window_size,
+    properties[PROP_MOTION_GATE_THRESHOLD] = g_param_spec_double(
+        "motion-gate-threshold",
+        "Motion Gate Threshold",
+        "Sets the normalised difference between two frames, from 0 (identical) "
+        "to 1, below which the optical flow calculation is skipped.",
+        0.0,
+        1.0,
+        default_motion_gate_threshold,
         (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
 
     properties[PROP_NVIDIA_ENABLE_COST_BUFFER] = g_param_spec_boolean(
@@ -1265,6 +2489,45 @@ static void gst_cuda_of_class_init(GstCudaOfClass *klass)
         default_optical_flow_algorithm,
         (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
 
+    properties[PROP_QUALITY_LEVEL] = g_param_spec_int(
+        "quality-level",
+        "Quality Level",
+        "The quality level the latency budget controller currently runs at, "
+        "from 0 (the configured parameters) upwards (cheaper parameters).",
+        0,
+        G_MAXINT,
+        0,
+        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_ROI_FROM_META] = g_param_spec_boolean(
+        "roi-from-meta",
+        "ROI From Meta",
+        "Uses the GstVideoRegionOfInterestMeta attached to each buffer as "
+        "regions of interest, in addition to roi-mask-location and "
+        "roi-polygons.",
+        default_roi_from_meta,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_ROI_MASK_LOCATION] = g_param_spec_string(
+        "roi-mask-location",
+        "ROI Mask Location",
+        "Specifies the filepath for an 8-bit image used as a bitmask of "
+        "regions of interest. Each distinct non-zero value is a region with "
+        "the value as its ID.",
+        default_roi_mask_location,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_ROI_POLYGONS] = g_param_spec_string(
+        "roi-polygons",
+        "ROI Polygons",
+        "Specifies polygons used as regions of interest, separated by "
+        "semicolons, with each vertex as x,y in pixels and an optional id: "
+        "prefix. Farneback only calculates the bounding rectangle of the "
+        "regions, NVIDIA optical flow 2.0 is given up to 8 of them, and "
+        "NVIDIA optical flow 1.0 ignores them.",
+        default_roi_polygons,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
     g_object_class_install_properties(gobject_class, N_PROPERTIES, properties);
 
     gst_element_class_add_pad_template(
@@ -1282,6 +2545,9 @@ static void gst_cuda_of_class_init(GstCudaOfClass *klass)
         "optical flow data and store it as buffer metadata.",
         "icetana");
 
+    gstbasetransform_class->sink_event
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_sink_event);
+    gstbasetransform_class->src_event = GST_DEBUG_FUNCPTR(gst_cuda_of_src_event);
     gstbasetransform_class->start = GST_DEBUG_FUNCPTR(gst_cuda_of_start);
     gstbasetransform_class->stop = GST_DEBUG_FUNCPTR(gst_cuda_of_stop);
     gstbasetransform_class->transform
@@ -1291,6 +2557,18 @@ static void gst_cuda_of_class_init(GstCudaOfClass *klass)
     gstbasetransform_class->transform_ip_on_passthrough = FALSE;
 }
 
+static void gst_cuda_of_finalize(GObject *gobject)
+{
+    GstCudaOf *self = GST_CUDA_OF(gobject);
+
+    g_free(self->roi_mask_location);
+    self->roi_mask_location = NULL;
+    g_free(self->roi_polygons);
+    self->roi_polygons = NULL;
+
+    G_OBJECT_CLASS(parent_class)->finalize(gobject);
+}
+
 static GstCudaMemory *
 gst_cuda_of_get_cuda_memory(GstCudaOf *self, GstBuffer *buf)
 {
@@ -1329,6 +2607,13 @@ gst_cuda_of_get_cuda_memory(GstCudaOf *self, GstBuffer *buf)
     return result;
 }
 
+static cv::Size gst_cuda_of_get_flow_size(GstCudaOf *self)
+{
+    return cv::Size(
+        self->parent.in_info.width / self->flow_scale,
+        self->parent.in_info.height / self->flow_scale);
+}
+
 static GstCudaOfPrivate *
 gst_cuda_of_get_instance_private_typesafe(GstCudaOf *self)
 {
@@ -1385,9 +2670,116 @@ static void gst_cuda_of_get_property(
         case PROP_FARNEBACK_PYRAMID_SCALE:
             g_value_set_double(value, gst_cuda_of->farneback_pyramid_scale);
             break;
+        case PROP_FARNEBACK_STATS:
+            {
+                GstCudaOfPrivate *self_private
+                    = gst_cuda_of_get_instance_private_typesafe(gst_cuda_of);
+                guint64 frames = 0;
+                guint64 warm_started = 0;
+                GstStructure *stats = NULL;
+
+                GST_OBJECT_LOCK(gst_cuda_of);
+                frames = self_private->farneback_frames;
+                warm_started = self_private->farneback_frames_warm_started;
+                stats = gst_structure_new(
+                    "farneback-stats",
+                    "frames",
+                    G_TYPE_UINT64,
+                    frames,
+                    "warm-started",
+                    G_TYPE_UINT64,
+                    warm_started,
+                    "last-convergence",
+                    G_TYPE_DOUBLE,
+                    self_private->farneback_last_residual,
+                    "mean-convergence",
+                    G_TYPE_DOUBLE,
+                    warm_started > 0 ? self_private->farneback_total_residual
+                                           / (gdouble)warm_started
+                                     : 0.0,
+                    "last-time",
+                    GST_TYPE_CLOCK_TIME,
+                    self_private->farneback_last_time,
+                    "mean-time",
+                    GST_TYPE_CLOCK_TIME,
+                    frames > 0 ? self_private->farneback_total_time / frames
+                               : (GstClockTime)0,
+                    "number-of-iterations",
+                    G_TYPE_INT,
+                    self_private->farneback_number_of_iterations,
+                    "number-of-levels",
+                    G_TYPE_INT,
+                    self_private->farneback_number_of_levels,
+                    NULL);
+                GST_OBJECT_UNLOCK(gst_cuda_of);
+
+                g_value_take_boxed(value, stats);
+            }
+            break;
+        case PROP_FARNEBACK_WARM_START:
+            g_value_set_enum(value, gst_cuda_of->farneback_warm_start);
+            break;
+        case PROP_FARNEBACK_WARM_START_TOLERANCE:
+            g_value_set_double(
+                value, gst_cuda_of->farneback_warm_start_tolerance);
+            break;
         case PROP_FARNEBACK_WINDOW_SIZE:
             g_value_set_int(value, gst_cuda_of->farneback_window_size);
             break;
+        case PROP_FLOW_SCALE:
+            g_value_set_enum(value, gst_cuda_of->flow_scale);
+            break;
+        case PROP_LATE_FRAMES:
+            g_value_set_enum(value, gst_cuda_of->late_frames);
+            break;
+        case PROP_LATENCY_BUDGET:
+            g_value_set_uint64(value, gst_cuda_of->latency_budget);
+            break;
+        case PROP_MOTION_GATE:
+            g_value_set_enum(value, gst_cuda_of->motion_gate);
+            break;
+        case PROP_MOTION_GATE_METRIC:
+            g_value_set_enum(value, gst_cuda_of->motion_gate_metric);
+            break;
+        case PROP_MOTION_GATE_STATS:
+            {
+                GstCudaOfPrivate *self_private
+                    = gst_cuda_of_get_instance_private_typesafe(gst_cuda_of);
+                GstStructure *stats = NULL;
+
+                GST_OBJECT_LOCK(gst_cuda_of);
+                stats = gst_structure_new(
+                    "motion-gate-stats",
+                    "frames",
+                    G_TYPE_UINT64,
+                    self_private->motion_gate_frames,
+                    "skipped",
+                    G_TYPE_UINT64,
+                    self_private->motion_gate_frames_skipped,
+                    "skip-rate",
+                    G_TYPE_DOUBLE,
+                    self_private->motion_gate_frames > 0
+                        ? (gdouble)self_private->motion_gate_frames_skipped
+                              / (gdouble)self_private->motion_gate_frames
+                        : 0.0,
+                    "last-score",
+                    G_TYPE_DOUBLE,
+                    self_private->motion_gate_last_score,
+                    NULL);
+                GST_OBJECT_UNLOCK(gst_cuda_of);
+
+                g_value_take_boxed(value, stats);
+            }
+            break;
+        case PROP_MOTION_GATE_SUBSAMPLE:
+            g_value_set_int(value, gst_cuda_of->motion_gate_subsample);
+            break;
+        case PROP_MOTION_GATE_SYNTHETIC:
+            g_value_set_enum(value, gst_cuda_of->motion_gate_synthetic);
+            break;
+        case PROP_MOTION_GATE_THRESHOLD:
+            g_value_set_double(value, gst_cuda_of->motion_gate_threshold);
+            break;
         case PROP_NVIDIA_ENABLE_COST_BUFFER:
             g_value_set_boolean(value, gst_cuda_of->nvidia_enable_cost_buffer);
             break;
@@ -1412,11 +2804,54 @@ static void gst_cuda_of_get_property(
         case PROP_OPTICAL_FLOW_ALGORITHM:
             g_value_set_enum(value, gst_cuda_of->optical_flow_algorithm);
             break;
+        case PROP_QUALITY_LEVEL:
+            {
+                GstCudaOfPrivate *self_private
+                    = gst_cuda_of_get_instance_private_typesafe(gst_cuda_of);
+
+                GST_OBJECT_LOCK(gst_cuda_of);
+                g_value_set_int(value, self_private->quality_level);
+                GST_OBJECT_UNLOCK(gst_cuda_of);
+            }
+            break;
+        case PROP_ROI_FROM_META:
+            g_value_set_boolean(value, gst_cuda_of->roi_from_meta);
+            break;
+        case PROP_ROI_MASK_LOCATION:
+            g_value_set_string(value, gst_cuda_of->roi_mask_location);
+            break;
+        case PROP_ROI_POLYGONS:
+            g_value_set_string(value, gst_cuda_of->roi_polygons);
+            break;
         default:
             g_assert_not_reached();
     }
 }
 
+static gint gst_cuda_of_get_vector_grid_size(GstCudaOf *self)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    gint result = OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_1;
+
+    switch(self->optical_flow_algorithm)
+    {
+        case OPTICAL_FLOW_ALGORITHM_FARNEBACK:
+            result = OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_1;
+            break;
+        case OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0:
+            result = OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_4;
+            break;
+        case OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0:
+            result = self_private->quality_nvidia_output_vector_grid_size;
+            break;
+        default:
+            break;
+    }
+
+    return result * self->flow_scale;
+}
+
 // clang-format off
 /**
  * \brief Initialisation function for GstCudaOf instances.
@@ -1456,8 +2891,22 @@ static void gst_cuda_of_init(GstCudaOf *self)
     self->farneback_polynomial_expansion_sigma
         = default_farneback_polynomial_expansion_sigma;
     self->farneback_pyramid_scale = default_farneback_pyramid_scale;
+    self->farneback_warm_start = default_farneback_warm_start;
+    self->farneback_warm_start_tolerance
+        = default_farneback_warm_start_tolerance;
     self->farneback_window_size = default_farneback_window_size;
 
+    self->flow_scale = default_flow_scale;
+
+    self->late_frames = default_late_frames;
+    self->latency_budget = default_latency_budget;
+
+    self->motion_gate = default_motion_gate;
+    self->motion_gate_metric = default_motion_gate_metric;
+    self->motion_gate_subsample = default_motion_gate_subsample;
+    self->motion_gate_synthetic = default_motion_gate_synthetic;
+    self->motion_gate_threshold = default_motion_gate_threshold;
+
     self->nvidia_enable_cost_buffer = default_nvidia_enable_cost_buffer;
     self->nvidia_enable_external_hints = default_nvidia_enable_external_hints;
     self->nvidia_enable_temporal_hints = default_nvidia_enable_temporal_hints;
@@ -1468,8 +2917,65 @@ static void gst_cuda_of_init(GstCudaOf *self)
 
     self->optical_flow_algorithm = default_optical_flow_algorithm;
 
+    self->roi_from_meta = default_roi_from_meta;
+    self->roi_mask_location = g_strdup(default_roi_mask_location);
+    self->roi_polygons = g_strdup(default_roi_polygons);
+
     self_private->algorithm_is_initialised = FALSE;
     self_private->prev_buffer = NULL;
+    self_private->prev_optical_flow = nullptr;
+    self_private->zero_optical_flow = nullptr;
+
+    self_private->farneback_number_of_iterations
+        = default_farneback_number_of_iterations;
+    self_private->farneback_number_of_levels
+        = default_farneback_number_of_levels;
+    self_private->farneback_scratch = nullptr;
+    self_private->farneback_frames = 0;
+    self_private->farneback_frames_warm_started = 0;
+    self_private->farneback_total_residual = 0.0;
+    self_private->farneback_last_residual = 0.0;
+    self_private->farneback_total_time = 0;
+    self_private->farneback_last_time = 0;
+
+    self_private->flow_scale_current = nullptr;
+    self_private->flow_scale_prev = nullptr;
+    self_private->flow_scale_has_prev = FALSE;
+
+    self_private->motion_gate_has_reference = FALSE;
+    self_private->motion_gate_width = 0;
+    self_private->motion_gate_rows = 0;
+    self_private->motion_gate_host_rows = NULL;
+    self_private->motion_gate_prev_host_rows = NULL;
+    self_private->motion_gate_scratch = nullptr;
+    self_private->motion_gate_frames = 0;
+    self_private->motion_gate_frames_skipped = 0;
+    self_private->motion_gate_last_score = 0.0;
+
+    self_private->quality_level = 0;
+    self_private->quality_max_level = 0;
+    self_private->quality_farneback_number_of_levels
+        = default_farneback_number_of_levels;
+    self_private->quality_farneback_window_size = default_farneback_window_size;
+    self_private->quality_nvidia_hint_vector_grid_size
+        = default_nvidia_hint_vector_grid_size;
+    self_private->quality_nvidia_output_vector_grid_size
+        = default_nvidia_output_vector_grid_size;
+    self_private->quality_nvidia_performance_preset
+        = default_nvidia_performance_preset;
+    self_private->quality_processing_time = GST_CLOCK_TIME_NONE;
+    self_private->quality_hold = 0;
+    self_private->qos_earliest_time = GST_CLOCK_TIME_NONE;
+    self_private->qos_proportion = 1.0;
+    self_private->qos_processed = 0;
+    self_private->qos_dropped = 0;
+
+    self_private->static_roi_set = NULL;
+    self_private->roi_set = NULL;
+    self_private->roi_x = 0;
+    self_private->roi_y = 0;
+    self_private->roi_width = 0;
+    self_private->roi_height = 0;
 
     gst_base_transform_set_in_place(trans, TRUE);
     gst_base_transform_set_gap_aware(trans, FALSE);
@@ -1491,10 +2997,10 @@ gst_cuda_of_init_algorithm(GstCudaOf *self, GstCudaOfAlgorithm algorithm_type)
         case OPTICAL_FLOW_ALGORITHM_FARNEBACK:
             self_private->algorithms.dense_optical_flow_algorithm
                 = cv::cuda::FarnebackOpticalFlow::create(
-                    self->farneback_number_of_levels,
+                    self_private->quality_farneback_number_of_levels,
                     self->farneback_pyramid_scale,
                     self->farneback_fast_pyramids,
-                    self->farneback_window_size,
+                    self_private->quality_farneback_window_size,
                     self->farneback_number_of_iterations,
                     self->farneback_polynomial_expansion_n,
                     self->farneback_polynomial_expansion_sigma,
@@ -1504,12 +3010,10 @@ gst_cuda_of_init_algorithm(GstCudaOf *self, GstCudaOfAlgorithm algorithm_type)
         case OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0:
             self_private->algorithms.nvidia_optical_flow_algorithm
                 = cv::cuda::NvidiaOpticalFlow_1_0::create(
-                    cv::Size(
-                        self->parent.in_info.width,
-                        self->parent.in_info.height),
+                    gst_cuda_of_get_flow_size(self),
                     static_cast<
                         cv::cuda::NvidiaOpticalFlow_1_0::NVIDIA_OF_PERF_LEVEL>(
-                        self->nvidia_performance_preset),
+                        self_private->quality_nvidia_performance_preset),
                     self->nvidia_enable_temporal_hints,
                     self->nvidia_enable_external_hints,
                     self->nvidia_enable_cost_buffer,
@@ -1517,31 +3021,430 @@ gst_cuda_of_init_algorithm(GstCudaOf *self, GstCudaOfAlgorithm algorithm_type)
             self_private->algorithm_is_initialised = TRUE;
             break;
         case OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0:
-            self_private->algorithms.nvidia_optical_flow_algorithm
-                = cv::cuda::NvidiaOpticalFlow_2_0::create(
-                    cv::Size(
-                        self->parent.in_info.width,
-                        self->parent.in_info.height),
-                    static_cast<
-                        cv::cuda::NvidiaOpticalFlow_2_0::NVIDIA_OF_PERF_LEVEL>(
-                        self->nvidia_performance_preset),
-                    static_cast<cv::cuda::NvidiaOpticalFlow_2_0::
-                                    NVIDIA_OF_OUTPUT_VECTOR_GRID_SIZE>(
-                        self->nvidia_output_vector_grid_size),
-                    static_cast<cv::cuda::NvidiaOpticalFlow_2_0::
-                                    NVIDIA_OF_HINT_VECTOR_GRID_SIZE>(
-                        self->nvidia_hint_vector_grid_size),
-                    self->nvidia_enable_temporal_hints,
-                    self->nvidia_enable_external_hints,
-                    self->nvidia_enable_cost_buffer,
-                    device_id);
-            self_private->algorithm_is_initialised = TRUE;
+            {
+                cv::Size flow_size = gst_cuda_of_get_flow_size(self);
+                guint number_of_rois
+                    = gst_cuda_of_roi_set_get_size(self_private->roi_set);
+                std::vector<cv::Rect> roi_data;
+
+                /*
+                 * The regions are given in pixels of the downscaled luma,
+                 * grown to whole macroblocks.
+                 */
+                for(guint idx = 0; idx < number_of_rois; idx++)
+                {
+                    guint x = 0;
+                    guint y = 0;
+                    guint width = 0;
+                    guint height = 0;
+
+                    if(!gst_cuda_of_roi_set_get_bounds(
+                           self_private->roi_set,
+                           number_of_rois > nvidia_roi_max ? -1 : (gint)idx,
+                           self->parent.in_info.width,
+                           self->parent.in_info.height,
+                           &x,
+                           &y,
+                           &width,
+                           &height))
+                    {
+                        continue;
+                    }
+
+                    gint x_start = (gint)(x / self->flow_scale
+                                          / nvidia_roi_alignment
+                                          * nvidia_roi_alignment);
+                    gint y_start = (gint)(y / self->flow_scale
+                                          / nvidia_roi_alignment
+                                          * nvidia_roi_alignment);
+                    gint x_end = (gint)(((x + width + self->flow_scale - 1)
+                                             / self->flow_scale
+                                         + nvidia_roi_alignment - 1)
+                                        / nvidia_roi_alignment
+                                        * nvidia_roi_alignment);
+                    gint y_end = (gint)(((y + height + self->flow_scale - 1)
+                                             / self->flow_scale
+                                         + nvidia_roi_alignment - 1)
+                                        / nvidia_roi_alignment
+                                        * nvidia_roi_alignment);
+
+                    cv::Rect roi_rect
+                        = cv::Rect(
+                              x_start, y_start, x_end - x_start, y_end - y_start)
+                          & cv::Rect(cv::Point(0, 0), flow_size);
+
+                    if(!roi_rect.empty())
+                    {
+                        roi_data.push_back(roi_rect);
+                    }
+
+                    if(number_of_rois > nvidia_roi_max)
+                    {
+                        break;
+                    }
+                }
+
+                self_private->algorithms.nvidia_optical_flow_algorithm
+                    = cv::cuda::NvidiaOpticalFlow_2_0::create(
+                        flow_size,
+                        roi_data,
+                        static_cast<
+                            cv::cuda::NvidiaOpticalFlow_2_0::NVIDIA_OF_PERF_LEVEL>(
+                            self_private->quality_nvidia_performance_preset),
+                        static_cast<cv::cuda::NvidiaOpticalFlow_2_0::
+                                        NVIDIA_OF_OUTPUT_VECTOR_GRID_SIZE>(
+                            self_private->quality_nvidia_output_vector_grid_size),
+                        static_cast<cv::cuda::NvidiaOpticalFlow_2_0::
+                                        NVIDIA_OF_HINT_VECTOR_GRID_SIZE>(
+                            self_private->quality_nvidia_hint_vector_grid_size),
+                        self->nvidia_enable_temporal_hints,
+                        self->nvidia_enable_external_hints,
+                        self->nvidia_enable_cost_buffer,
+                        device_id);
+                self_private->algorithm_is_initialised = TRUE;
+            }
             break;
         default:
             break;
     }
 }
 
+static gboolean gst_cuda_of_is_late(
+    GstCudaOf *self,
+    GstBuffer *buffer,
+    GstClockTime *running_time)
+{
+    GstBaseTransform *trans = GST_BASE_TRANSFORM(self);
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    GstClockTime earliest_time = GST_CLOCK_TIME_NONE;
+
+    *running_time = GST_CLOCK_TIME_NONE;
+
+    if(!GST_BUFFER_PTS_IS_VALID(buffer)
+       || trans->segment.format != GST_FORMAT_TIME)
+    {
+        return FALSE;
+    }
+
+    *running_time = gst_segment_to_running_time(
+        &trans->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+
+    GST_OBJECT_LOCK(self);
+    earliest_time = self_private->qos_earliest_time;
+    GST_OBJECT_UNLOCK(self);
+
+    return GST_CLOCK_TIME_IS_VALID(*running_time)
+           && GST_CLOCK_TIME_IS_VALID(earliest_time)
+           && *running_time <= earliest_time;
+}
+
+static gboolean gst_cuda_of_load_roi_set(GstCudaOf *self)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    gboolean result = TRUE;
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    if(self->roi_mask_location != NULL && *self->roi_mask_location != '\0')
+    {
+        cv::Mat roi_mask
+            = cv::imread(self->roi_mask_location, cv::IMREAD_GRAYSCALE);
+
+        if(roi_mask.empty()
+           || !gst_cuda_of_roi_set_add_mask(
+               roi_set,
+               roi_mask.data,
+               roi_mask.cols,
+               roi_mask.rows,
+               roi_mask.step))
+        {
+            GST_ERROR_OBJECT(
+                self,
+                "Could not read a region of interest bitmask with at most %u "
+                "labels from %s.",
+                GST_CUDA_OF_ROI_SET_MAX_SIZE,
+                self->roi_mask_location);
+            result = FALSE;
+        }
+    }
+
+    if(result
+       && !gst_cuda_of_roi_set_parse_polygons(roi_set, self->roi_polygons))
+    {
+        GST_ERROR_OBJECT(
+            self,
+            "Could not parse the region of interest polygons \"%s\".",
+            self->roi_polygons);
+        result = FALSE;
+    }
+
+    gst_cuda_of_roi_set_free(self_private->static_roi_set);
+    self_private->static_roi_set = NULL;
+    gst_cuda_of_roi_set_free(self_private->roi_set);
+    self_private->roi_set = NULL;
+
+    if(result && gst_cuda_of_roi_set_get_size(roi_set) > 0)
+    {
+        self_private->static_roi_set = roi_set;
+        roi_set = NULL;
+    }
+
+    gst_cuda_of_roi_set_free(roi_set);
+
+    return result;
+}
+
+static gboolean gst_cuda_of_motion_gate_check(
+    GstCudaOf *self,
+    GstBuffer *current_buffer,
+    GstBuffer *previous_buffer)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+
+    GstCudaMemory *current_buffer_cuda_memory = NULL;
+    GstCudaMemory *prev_buffer_cuda_memory = NULL;
+
+    gboolean current_buffer_map_result = FALSE;
+    gboolean prev_buffer_map_result = FALSE;
+
+    GstMapInfo current_buffer_map_info;
+    GstMapInfo prev_buffer_map_info;
+
+    guint width = (guint)self->parent.in_info.width;
+    guint subsample = (guint)self->motion_gate_subsample;
+    guint rows = ((guint)self->parent.in_info.height + subsample - 1) / subsample;
+
+    guint32 histogram[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS];
+    gboolean has_score = FALSE;
+    gdouble score = 0.0;
+    gboolean result = FALSE;
+
+    /*
+     * Only the CUDA implementation of the SAD metric looks at the previous
+     * buffer itself. Every other combination compares against a signature
+     * retained from the previous buffer, which has to be dropped whenever the
+     * frame size changes.
+     */
+    if(width != self_private->motion_gate_width
+       || rows != self_private->motion_gate_rows)
+    {
+        g_free(self_private->motion_gate_host_rows);
+        g_free(self_private->motion_gate_prev_host_rows);
+        self_private->motion_gate_host_rows = NULL;
+        self_private->motion_gate_prev_host_rows = NULL;
+
+        self_private->motion_gate_width = width;
+        self_private->motion_gate_rows = rows;
+        self_private->motion_gate_has_reference = FALSE;
+    }
+
+    current_buffer_cuda_memory
+        = gst_cuda_of_get_cuda_memory(self, current_buffer);
+
+    if(current_buffer_cuda_memory == NULL || width == 0 || rows == 0)
+    {
+        return FALSE;
+    }
+
+    current_buffer_map_result = gst_memory_map(
+        GST_MEMORY_CAST(current_buffer_cuda_memory),
+        &current_buffer_map_info,
+        (GstMapFlags)(GST_MAP_CUDA));
+
+    if(!current_buffer_map_result)
+    {
+        return FALSE;
+    }
+
+    /*
+     * A step of subsample times the stride turns every subsample-th row of
+     * the luma plane into a contiguous matrix, without copying anything.
+     */
+    cv::cuda::GpuMat current_rows = cv::cuda::GpuMat(
+        rows,
+        width,
+        CV_8UC1,
+        current_buffer_map_info.data,
+        current_buffer_cuda_memory->stride * subsample);
+
+    if(self->motion_gate == MOTION_GATE_CPU)
+    {
+        if(self_private->motion_gate_host_rows == NULL)
+        {
+            self_private->motion_gate_host_rows
+                = (guint8 *)g_malloc((gsize)width * rows);
+            self_private->motion_gate_prev_host_rows
+                = (guint8 *)g_malloc((gsize)width * rows);
+        }
+
+        cv::Mat host_rows = cv::Mat(
+            rows, width, CV_8UC1, self_private->motion_gate_host_rows);
+        current_rows.download(host_rows);
+
+        if(self->motion_gate_metric == MOTION_GATE_METRIC_HISTOGRAM)
+        {
+            gst_cuda_of_motion_gate_histogram(
+                self_private->motion_gate_host_rows,
+                width,
+                width,
+                rows,
+                histogram);
+        }
+        else if(self_private->motion_gate_has_reference)
+        {
+            score = gst_cuda_of_motion_gate_sad(
+                self_private->motion_gate_host_rows,
+                width,
+                self_private->motion_gate_prev_host_rows,
+                width,
+                width,
+                rows);
+            has_score = TRUE;
+        }
+
+        std::swap(
+            self_private->motion_gate_host_rows,
+            self_private->motion_gate_prev_host_rows);
+    }
+    else if(self->motion_gate_metric == MOTION_GATE_METRIC_HISTOGRAM)
+    {
+        if(self_private->motion_gate_scratch == nullptr)
+        {
+            self_private->motion_gate_scratch = new cv::cuda::GpuMat();
+        }
+
+        cv::cuda::histEven(
+            current_rows,
+            *(self_private->motion_gate_scratch),
+            GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS,
+            0,
+            256);
+
+        cv::Mat host_histogram = cv::Mat(
+            1, GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS, CV_32SC1, histogram);
+        self_private->motion_gate_scratch->download(host_histogram);
+    }
+    else if(previous_buffer != NULL)
+    {
+        prev_buffer_cuda_memory
+            = gst_cuda_of_get_cuda_memory(self, previous_buffer);
+
+        if(prev_buffer_cuda_memory != NULL)
+        {
+            prev_buffer_map_result = gst_memory_map(
+                GST_MEMORY_CAST(prev_buffer_cuda_memory),
+                &prev_buffer_map_info,
+                (GstMapFlags)(GST_MAP_CUDA));
+        }
+
+        if(prev_buffer_map_result)
+        {
+            cv::cuda::GpuMat prev_rows = cv::cuda::GpuMat(
+                rows,
+                width,
+                CV_8UC1,
+                prev_buffer_map_info.data,
+                prev_buffer_cuda_memory->stride * subsample);
+
+            if(self_private->motion_gate_scratch == nullptr)
+            {
+                self_private->motion_gate_scratch = new cv::cuda::GpuMat();
+            }
+
+            cv::cuda::absdiff(
+                current_rows, prev_rows, *(self_private->motion_gate_scratch));
+            score = cv::cuda::sum(*(self_private->motion_gate_scratch))[0]
+                    / (255.0 * (gdouble)width * (gdouble)rows);
+            has_score = TRUE;
+
+            gst_memory_unmap(
+                GST_MEMORY_CAST(prev_buffer_cuda_memory),
+                &prev_buffer_map_info);
+        }
+    }
+
+    gst_memory_unmap(
+        GST_MEMORY_CAST(current_buffer_cuda_memory), &current_buffer_map_info);
+
+    if(self->motion_gate_metric == MOTION_GATE_METRIC_HISTOGRAM)
+    {
+        if(self_private->motion_gate_has_reference)
+        {
+            score = gst_cuda_of_motion_gate_histogram_difference(
+                histogram, self_private->motion_gate_prev_histogram);
+            has_score = TRUE;
+        }
+
+        memcpy(
+            self_private->motion_gate_prev_histogram,
+            histogram,
+            sizeof(histogram));
+    }
+
+    self_private->motion_gate_has_reference = TRUE;
+
+    /*
+     * A buffer can only be skipped if there is a previous buffer for the
+     * synthetic optical flow to stand in for.
+     */
+    if(has_score && previous_buffer != NULL)
+    {
+        result = score < self->motion_gate_threshold;
+
+        GST_OBJECT_LOCK(self);
+        self_private->motion_gate_frames++;
+        if(result)
+        {
+            self_private->motion_gate_frames_skipped++;
+        }
+        self_private->motion_gate_last_score = score;
+        GST_OBJECT_UNLOCK(self);
+
+        GST_LOG_OBJECT(
+            self,
+            "Motion gate score %f, %s optical flow",
+            score,
+            result ? "skipping" : "calculating");
+    }
+
+    return result;
+}
+
+static void gst_cuda_of_motion_gate_clear(GstCudaOf *self)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+
+    delete self_private->prev_optical_flow;
+    self_private->prev_optical_flow = nullptr;
+
+    delete self_private->zero_optical_flow;
+    self_private->zero_optical_flow = nullptr;
+
+    delete self_private->farneback_scratch;
+    self_private->farneback_scratch = nullptr;
+
+    delete self_private->flow_scale_current;
+    delete self_private->flow_scale_prev;
+    self_private->flow_scale_current = nullptr;
+    self_private->flow_scale_prev = nullptr;
+    self_private->flow_scale_has_prev = FALSE;
+
+    delete self_private->motion_gate_scratch;
+    self_private->motion_gate_scratch = nullptr;
+
+    g_free(self_private->motion_gate_host_rows);
+    g_free(self_private->motion_gate_prev_host_rows);
+    self_private->motion_gate_host_rows = NULL;
+    self_private->motion_gate_prev_host_rows = NULL;
+
+    self_private->motion_gate_width = 0;
+    self_private->motion_gate_rows = 0;
+    self_private->motion_gate_has_reference = FALSE;
+}
+
 gboolean gst_cuda_of_plugin_init(GstPlugin *plugin)
 {
     /*
@@ -1753,6 +3656,27 @@ static void gst_cuda_of_set_property(
                 }
             }
             break;
+        case PROP_FARNEBACK_WARM_START:
+            if(gst_cuda_of->farneback_warm_start != g_value_get_enum(value))
+            {
+                gst_cuda_of->farneback_warm_start = g_value_get_enum(value);
+                g_assert(properties[PROP_FARNEBACK_WARM_START] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_FARNEBACK_WARM_START]);
+            }
+            break;
+        case PROP_FARNEBACK_WARM_START_TOLERANCE:
+            if(gst_cuda_of->farneback_warm_start_tolerance
+               != g_value_get_double(value))
+            {
+                gst_cuda_of->farneback_warm_start_tolerance
+                    = g_value_get_double(value);
+                g_assert(
+                    properties[PROP_FARNEBACK_WARM_START_TOLERANCE] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_FARNEBACK_WARM_START_TOLERANCE]);
+            }
+            break;
         case PROP_FARNEBACK_WINDOW_SIZE:
             if(gst_cuda_of->farneback_window_size != g_value_get_int(value))
             {
@@ -1762,6 +3686,76 @@ static void gst_cuda_of_set_property(
                     gobject, properties[PROP_FARNEBACK_WINDOW_SIZE]);
             }
             break;
+        case PROP_FLOW_SCALE:
+            if(gst_cuda_of->flow_scale != g_value_get_enum(value))
+            {
+                gst_cuda_of->flow_scale = g_value_get_enum(value);
+                g_assert(properties[PROP_FLOW_SCALE] != NULL);
+                g_object_notify_by_pspec(gobject, properties[PROP_FLOW_SCALE]);
+            }
+            break;
+        case PROP_LATE_FRAMES:
+            if(gst_cuda_of->late_frames != g_value_get_enum(value))
+            {
+                gst_cuda_of->late_frames = g_value_get_enum(value);
+                g_assert(properties[PROP_LATE_FRAMES] != NULL);
+                g_object_notify_by_pspec(gobject, properties[PROP_LATE_FRAMES]);
+            }
+            break;
+        case PROP_LATENCY_BUDGET:
+            if(gst_cuda_of->latency_budget != g_value_get_uint64(value))
+            {
+                gst_cuda_of->latency_budget = g_value_get_uint64(value);
+                g_assert(properties[PROP_LATENCY_BUDGET] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_LATENCY_BUDGET]);
+            }
+            break;
+        case PROP_MOTION_GATE:
+            if(gst_cuda_of->motion_gate != g_value_get_enum(value))
+            {
+                gst_cuda_of->motion_gate = g_value_get_enum(value);
+                g_assert(properties[PROP_MOTION_GATE] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_MOTION_GATE]);
+            }
+            break;
+        case PROP_MOTION_GATE_METRIC:
+            if(gst_cuda_of->motion_gate_metric != g_value_get_enum(value))
+            {
+                gst_cuda_of->motion_gate_metric = g_value_get_enum(value);
+                g_assert(properties[PROP_MOTION_GATE_METRIC] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_MOTION_GATE_METRIC]);
+            }
+            break;
+        case PROP_MOTION_GATE_SUBSAMPLE:
+            if(gst_cuda_of->motion_gate_subsample != g_value_get_int(value))
+            {
+                gst_cuda_of->motion_gate_subsample = g_value_get_int(value);
+                g_assert(properties[PROP_MOTION_GATE_SUBSAMPLE] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_MOTION_GATE_SUBSAMPLE]);
+            }
+            break;
+        case PROP_MOTION_GATE_SYNTHETIC:
+            if(gst_cuda_of->motion_gate_synthetic != g_value_get_enum(value))
+            {
+                gst_cuda_of->motion_gate_synthetic = g_value_get_enum(value);
+                g_assert(properties[PROP_MOTION_GATE_SYNTHETIC] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_MOTION_GATE_SYNTHETIC]);
+            }
+            break;
+        case PROP_MOTION_GATE_THRESHOLD:
+            if(gst_cuda_of->motion_gate_threshold != g_value_get_double(value))
+            {
+                gst_cuda_of->motion_gate_threshold = g_value_get_double(value);
+                g_assert(properties[PROP_MOTION_GATE_THRESHOLD] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_MOTION_GATE_THRESHOLD]);
+            }
+            break;
         case PROP_NVIDIA_ENABLE_COST_BUFFER:
             if(gst_cuda_of->nvidia_enable_cost_buffer
                != g_value_get_boolean(value))
@@ -1838,11 +3832,219 @@ static void gst_cuda_of_set_property(
                     gobject, properties[PROP_OPTICAL_FLOW_ALGORITHM]);
             }
             break;
+        case PROP_ROI_FROM_META:
+            if(gst_cuda_of->roi_from_meta != g_value_get_boolean(value))
+            {
+                gst_cuda_of->roi_from_meta = g_value_get_boolean(value);
+                g_assert(properties[PROP_ROI_FROM_META] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_ROI_FROM_META]);
+            }
+            break;
+        case PROP_ROI_MASK_LOCATION:
+            if(g_strcmp0(
+                   gst_cuda_of->roi_mask_location, g_value_get_string(value)))
+            {
+                g_free(gst_cuda_of->roi_mask_location);
+                gst_cuda_of->roi_mask_location = g_value_dup_string(value);
+                g_assert(properties[PROP_ROI_MASK_LOCATION] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_ROI_MASK_LOCATION]);
+            }
+            break;
+        case PROP_ROI_POLYGONS:
+            if(g_strcmp0(gst_cuda_of->roi_polygons, g_value_get_string(value)))
+            {
+                g_free(gst_cuda_of->roi_polygons);
+                gst_cuda_of->roi_polygons = g_value_dup_string(value);
+                g_assert(properties[PROP_ROI_POLYGONS] != NULL);
+                g_object_notify_by_pspec(
+                    gobject, properties[PROP_ROI_POLYGONS]);
+            }
+            break;
         default:
             g_assert_not_reached();
     }
 }
 
+static void gst_cuda_of_set_quality_level(GstCudaOf *self, gint quality_level)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    gint max_level = 0;
+    gint performance_preset = self->nvidia_performance_preset;
+    gint output_vector_grid_size = self->nvidia_output_vector_grid_size;
+    gint hint_vector_grid_size = self->nvidia_hint_vector_grid_size;
+    gboolean nvidia_changed = FALSE;
+
+    switch(self->optical_flow_algorithm)
+    {
+        case OPTICAL_FLOW_ALGORITHM_FARNEBACK:
+            max_level = MAX(
+                MAX(self->farneback_number_of_levels - 1,
+                    (self->farneback_window_size - 5) / 2),
+                0);
+            break;
+        case OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0:
+        case OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0:
+            if(performance_preset == OPTICAL_FLOW_PERFORMANCE_PRESET_SLOW)
+            {
+                max_level += 2;
+            }
+            else if(
+                performance_preset == OPTICAL_FLOW_PERFORMANCE_PRESET_MEDIUM)
+            {
+                max_level += 1;
+            }
+
+            /*
+             * Only NVIDIA optical flow 2.0 supports output vector grids other
+             * than 4x4.
+             */
+            if(self->optical_flow_algorithm
+               == OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0)
+            {
+                if(output_vector_grid_size
+                   == OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_1)
+                {
+                    max_level += 2;
+                }
+                else if(
+                    output_vector_grid_size
+                    == OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_2)
+                {
+                    max_level += 1;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+
+    quality_level = CLAMP(quality_level, 0, max_level);
+
+    /*
+     * The presets are stepped first, as a faster preset costs less accuracy
+     * than a coarser grid, which also changes the size of the vectors seen
+     * downstream. The hint vector grid can not be finer than the output
+     * vector grid.
+     */
+    for(gint step = 0; step < quality_level
+                       && self->optical_flow_algorithm
+                              != OPTICAL_FLOW_ALGORITHM_FARNEBACK;
+        step++)
+    {
+        if(performance_preset == OPTICAL_FLOW_PERFORMANCE_PRESET_SLOW)
+        {
+            performance_preset = OPTICAL_FLOW_PERFORMANCE_PRESET_MEDIUM;
+        }
+        else if(performance_preset == OPTICAL_FLOW_PERFORMANCE_PRESET_MEDIUM)
+        {
+            performance_preset = OPTICAL_FLOW_PERFORMANCE_PRESET_FAST;
+        }
+        else
+        {
+            output_vector_grid_size *= 2;
+            hint_vector_grid_size
+                = MAX(hint_vector_grid_size, output_vector_grid_size);
+        }
+    }
+
+    nvidia_changed
+        = performance_preset != self_private->quality_nvidia_performance_preset
+          || output_vector_grid_size
+                 != self_private->quality_nvidia_output_vector_grid_size
+          || hint_vector_grid_size
+                 != self_private->quality_nvidia_hint_vector_grid_size;
+
+    self_private->quality_farneback_number_of_levels
+        = MAX(self->farneback_number_of_levels - quality_level,
+              MIN(self->farneback_number_of_levels, 1));
+    self_private->quality_farneback_window_size
+        = MAX(self->farneback_window_size - 2 * quality_level,
+              MIN(self->farneback_window_size, 5));
+    self_private->quality_nvidia_hint_vector_grid_size = hint_vector_grid_size;
+    self_private->quality_nvidia_output_vector_grid_size
+        = output_vector_grid_size;
+    self_private->quality_nvidia_performance_preset = performance_preset;
+
+    /*
+     * The Farneback parameters are set on the algorithm before each frame,
+     * but the NVIDIA algorithms only take theirs on creation.
+     */
+    if(nvidia_changed && self_private->algorithm_is_initialised
+       && !self_private->algorithms.nvidia_optical_flow_algorithm.empty())
+    {
+        self_private->algorithms.nvidia_optical_flow_algorithm
+            ->collectGarbage();
+        self_private->algorithms.nvidia_optical_flow_algorithm.reset();
+        self_private->algorithm_is_initialised = FALSE;
+    }
+
+    GST_OBJECT_LOCK(self);
+    self_private->quality_level = quality_level;
+    self_private->quality_max_level = max_level;
+    GST_OBJECT_UNLOCK(self);
+}
+
+static gboolean gst_cuda_of_sink_event(GstBaseTransform *trans, GstEvent *event)
+{
+    GstCudaOf *self = GST_CUDA_OF(trans);
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+
+    if(GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP)
+    {
+        GST_OBJECT_LOCK(self);
+        self_private->qos_earliest_time = GST_CLOCK_TIME_NONE;
+        self_private->qos_proportion = 1.0;
+        GST_OBJECT_UNLOCK(self);
+    }
+
+    return GST_BASE_TRANSFORM_CLASS(parent_class)->sink_event(trans, event);
+}
+
+static gboolean gst_cuda_of_src_event(GstBaseTransform *trans, GstEvent *event)
+{
+    GstCudaOf *self = GST_CUDA_OF(trans);
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+
+    if(GST_EVENT_TYPE(event) == GST_EVENT_QOS)
+    {
+        gdouble proportion = 1.0;
+        GstClockTimeDiff diff = 0;
+        GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+
+        gst_event_parse_qos(event, NULL, &proportion, &diff, &timestamp);
+
+        GST_OBJECT_LOCK(self);
+        self_private->qos_proportion = proportion;
+
+        /*
+         * If downstream is late, the next frame it can display is at least as
+         * far after the late one as it was late by; see the QoS design
+         * document of GStreamer.
+         */
+        if(!GST_CLOCK_TIME_IS_VALID(timestamp))
+        {
+            self_private->qos_earliest_time = GST_CLOCK_TIME_NONE;
+        }
+        else if(diff > 0)
+        {
+            self_private->qos_earliest_time = timestamp + 2 * diff;
+        }
+        else
+        {
+            self_private->qos_earliest_time
+                = (GstClockTimeDiff)timestamp + diff > 0 ? timestamp + diff : 0;
+        }
+        GST_OBJECT_UNLOCK(self);
+    }
+
+    return GST_BASE_TRANSFORM_CLASS(parent_class)->src_event(trans, event);
+}
+
 static gboolean gst_cuda_of_start(GstBaseTransform *trans)
 {
     GstCudaOf *self = GST_CUDA_OF(trans);
@@ -1861,8 +4063,34 @@ static gboolean gst_cuda_of_start(GstBaseTransform *trans)
         }
 
         self_private->algorithm_is_initialised = FALSE;
-
-        result = TRUE;
+        self_private->flow_scale_has_prev = FALSE;
+        self_private->motion_gate_has_reference = FALSE;
+
+        gst_cuda_of_set_quality_level(self, 0);
+        self_private->quality_processing_time = GST_CLOCK_TIME_NONE;
+        self_private->quality_hold = 0;
+
+        GST_OBJECT_LOCK(self);
+        self_private->farneback_number_of_iterations
+            = self->farneback_number_of_iterations;
+        self_private->farneback_number_of_levels
+            = self_private->quality_farneback_number_of_levels;
+        self_private->farneback_frames = 0;
+        self_private->farneback_frames_warm_started = 0;
+        self_private->farneback_total_residual = 0.0;
+        self_private->farneback_last_residual = 0.0;
+        self_private->farneback_total_time = 0;
+        self_private->farneback_last_time = 0;
+        self_private->motion_gate_frames = 0;
+        self_private->motion_gate_frames_skipped = 0;
+        self_private->motion_gate_last_score = 0.0;
+        self_private->qos_earliest_time = GST_CLOCK_TIME_NONE;
+        self_private->qos_proportion = 1.0;
+        self_private->qos_processed = 0;
+        self_private->qos_dropped = 0;
+        GST_OBJECT_UNLOCK(self);
+
+        result = gst_cuda_of_load_roi_set(self);
     }
 
     return result;
@@ -1894,11 +4122,81 @@ static gboolean gst_cuda_of_stop(GstBaseTransform *trans)
 
     self_private->algorithms.sparse_optical_flow_algorithm.reset();
 
+    gst_cuda_of_roi_set_free(self_private->static_roi_set);
+    self_private->static_roi_set = NULL;
+    gst_cuda_of_roi_set_free(self_private->roi_set);
+    self_private->roi_set = NULL;
+
+    /*
+     * The statistics are left untouched, so that they can still be read
+     * once the pipeline was shut down at EOS.
+     */
+    if(self->parent.context != NULL
+       && gst_cuda_context_push(self->parent.context))
+    {
+        gst_cuda_of_motion_gate_clear(self);
+        gst_cuda_context_pop(NULL);
+    }
+
     result = GST_BASE_TRANSFORM_CLASS(parent_class)->stop(trans);
 
     return result;
 }
 
+static cv::cuda::GpuMat gst_cuda_of_synthetic_optical_flow(GstCudaOf *self)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    gint grid_size = gst_cuda_of_get_vector_grid_size(self) / self->flow_scale;
+    cv::Size flow_size = gst_cuda_of_get_flow_size(self);
+    gint rows = 0;
+    gint cols = 0;
+    gint type = 0;
+
+    /*
+     * The size and type are those the algorithm would produce right now: one
+     * 32-bit floating point vector per pixel of the downscaled luma for
+     * Farneback, one S10.5 fixed point vector per grid cell for the NVIDIA
+     * algorithms. The last calculated vectors are only re-used while they
+     * still match, as the latency budget controller may have changed the grid
+     * size since.
+     */
+    rows = (flow_size.height + grid_size - 1) / grid_size;
+    cols = (flow_size.width + grid_size - 1) / grid_size;
+    type = self->optical_flow_algorithm == OPTICAL_FLOW_ALGORITHM_FARNEBACK
+               ? CV_32FC2
+               : CV_16SC2;
+
+    if(self->motion_gate_synthetic == MOTION_GATE_SYNTHETIC_REUSE
+       && self_private->prev_optical_flow != nullptr
+       && self_private->prev_optical_flow->rows == rows
+       && self_private->prev_optical_flow->cols == cols
+       && self_private->prev_optical_flow->type() == type)
+    {
+        return *(self_private->prev_optical_flow);
+    }
+
+    if(self_private->zero_optical_flow == nullptr)
+    {
+        self_private->zero_optical_flow = new cv::cuda::GpuMat();
+    }
+
+    if(self_private->zero_optical_flow->rows != rows
+       || self_private->zero_optical_flow->cols != cols
+       || self_private->zero_optical_flow->type() != type)
+    {
+        /*
+         * The previous zero vectors may still be referenced by metadata
+         * downstream, so a new matrix is allocated rather than re-using its
+         * memory.
+         */
+        *(self_private->zero_optical_flow)
+            = cv::cuda::GpuMat(rows, cols, type, cv::Scalar::all(0));
+    }
+
+    return *(self_private->zero_optical_flow);
+}
+
 static GstFlowReturn gst_cuda_of_transform(
     GstBaseTransform *trans,
     GstBuffer *inbuf,
@@ -1908,6 +4206,55 @@ static GstFlowReturn gst_cuda_of_transform(
     GstCudaOfPrivate *self_private
         = gst_cuda_of_get_instance_private_typesafe(self);
     GstFlowReturn result = GST_FLOW_OK;
+    GstClockTime running_time = GST_CLOCK_TIME_NONE;
+    gboolean late = FALSE;
+
+    if(self->late_frames != LATE_FRAMES_PROCESS)
+    {
+        late = gst_cuda_of_is_late(self, inbuf, &running_time);
+    }
+
+    /*
+     * A dropped frame never reaches downstream, so the previous buffer is
+     * kept and the next optical flow spans both frames; exactly the motion
+     * between the frames that are displayed.
+     */
+    if(late && self->late_frames == LATE_FRAMES_DROP)
+    {
+        GstMessage *qos_message = NULL;
+        GstClockTimeDiff jitter = 0;
+        gdouble proportion = 1.0;
+        guint64 processed = 0;
+        guint64 dropped = 0;
+
+        GST_OBJECT_LOCK(self);
+        jitter = GST_CLOCK_DIFF(
+            running_time, self_private->qos_earliest_time);
+        proportion = self_private->qos_proportion;
+        processed = self_private->qos_processed;
+        dropped = ++self_private->qos_dropped;
+        GST_OBJECT_UNLOCK(self);
+
+        GST_DEBUG_OBJECT(
+            self,
+            "Dropping late frame at running time %" GST_TIME_FORMAT,
+            GST_TIME_ARGS(running_time));
+
+        qos_message = gst_message_new_qos(
+            GST_OBJECT(self),
+            FALSE,
+            running_time,
+            gst_segment_to_stream_time(
+                &trans->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(inbuf)),
+            GST_BUFFER_PTS(inbuf),
+            GST_BUFFER_DURATION(inbuf));
+        gst_message_set_qos_values(qos_message, jitter, proportion, 1000000);
+        gst_message_set_qos_stats(
+            qos_message, GST_FORMAT_BUFFERS, processed, dropped);
+        gst_element_post_message(GST_ELEMENT(self), qos_message);
+
+        return GST_BASE_TRANSFORM_FLOW_DROPPED;
+    }
 
     try
     {
@@ -1916,45 +4263,62 @@ static GstFlowReturn gst_cuda_of_transform(
             throw GstCudaException("Could not push CUDA context.");
         }
 
+        gst_cuda_of_update_roi_set(self, inbuf);
+
         if(!self_private->algorithm_is_initialised)
         {
             gst_cuda_of_init_algorithm(
                 self, (GstCudaOfAlgorithm)(self->optical_flow_algorithm));
         }
 
+        gboolean skip_optical_flow = late;
+
+        if(!late && self->motion_gate != MOTION_GATE_DISABLED)
+        {
+            skip_optical_flow = gst_cuda_of_motion_gate_check(
+                self, inbuf, self_private->prev_buffer);
+        }
+
         if(self_private->prev_buffer != NULL)
         {
-            cv::cuda::GpuMat optical_flow_vectors
-                = gst_cuda_of_calculate_optical_flow(
+            cv::cuda::GpuMat optical_flow_vectors;
+
+            if(skip_optical_flow)
+            {
+                optical_flow_vectors = gst_cuda_of_synthetic_optical_flow(self);
+                self_private->flow_scale_has_prev = FALSE;
+            }
+            else
+            {
+                gint64 start_time = g_get_monotonic_time();
+
+                optical_flow_vectors = gst_cuda_of_calculate_optical_flow(
                     self, inbuf, self_private->prev_buffer);
+
+                if(self_private->prev_optical_flow == nullptr)
+                {
+                    self_private->prev_optical_flow = new cv::cuda::GpuMat();
+                }
+                *(self_private->prev_optical_flow) = optical_flow_vectors;
+
+                if(self->latency_budget > 0)
+                {
+                    cv::cuda::Stream::Null().waitForCompletion();
+                    gst_cuda_of_update_quality(
+                        self,
+                        (GstClockTime)(g_get_monotonic_time() - start_time)
+                            * GST_USECOND);
+                }
+            }
+
             GstMetaOpticalFlow *meta = GST_META_OPTICAL_FLOW_ADD(outbuf);
             meta->optical_flow_vectors
                 = new cv::cuda::GpuMat(optical_flow_vectors);
             meta->context
                 = GST_CUDA_CONTEXT(gst_object_ref(self->parent.context));
-
-            switch(self->optical_flow_algorithm)
-            {
-                case OPTICAL_FLOW_ALGORITHM_FARNEBACK:
-                    {
-                        meta->optical_flow_vector_grid_size = 1;
-                    }
-                    break;
-                case OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0:
-                    {
-                        meta->optical_flow_vector_grid_size
-                            = OPTICAL_FLOW_OUTPUT_VECTOR_GRID_SIZE_4;
-                    }
-                    break;
-                case OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0:
-                    {
-                        meta->optical_flow_vector_grid_size
-                            = self->nvidia_output_vector_grid_size;
-                    }
-                    break;
-                default:
-                    break;
-            }
+            meta->optical_flow_vector_grid_size
+                = gst_cuda_of_get_vector_grid_size(self);
+            meta->synthetic = skip_optical_flow;
 
             gst_buffer_unref(self_private->prev_buffer);
         }
@@ -1962,6 +4326,10 @@ static GstFlowReturn gst_cuda_of_transform(
         self_private->prev_buffer = gst_buffer_copy(inbuf);
 
         gst_cuda_context_pop(NULL);
+
+        GST_OBJECT_LOCK(self);
+        self_private->qos_processed++;
+        GST_OBJECT_UNLOCK(self);
     }
     catch(GstCudaException &ex)
     {
@@ -1992,6 +4360,202 @@ static GstFlowReturn gst_cuda_of_transform(
     return result;
 }
 
+static void
+gst_cuda_of_update_quality(GstCudaOf *self, GstClockTime processing_time)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    gint prev_quality_level = self_private->quality_level;
+    gint quality_level = prev_quality_level;
+
+    if(!GST_CLOCK_TIME_IS_VALID(self_private->quality_processing_time))
+    {
+        self_private->quality_processing_time = processing_time;
+    }
+    else
+    {
+        self_private->quality_processing_time
+            = (7 * self_private->quality_processing_time + processing_time) / 8;
+    }
+
+    if(self_private->quality_hold > 0)
+    {
+        self_private->quality_hold--;
+        return;
+    }
+
+    /*
+     * Stepping back up only below half of the budget leaves enough room for
+     * the more expensive level, so the controller does not oscillate between
+     * two neighbouring levels.
+     */
+    if(self_private->quality_processing_time > self->latency_budget)
+    {
+        quality_level++;
+    }
+    else if(self_private->quality_processing_time < self->latency_budget / 2)
+    {
+        quality_level--;
+    }
+
+    if(quality_level == prev_quality_level)
+    {
+        return;
+    }
+
+    gst_cuda_of_set_quality_level(self, quality_level);
+
+    if(self_private->quality_level == prev_quality_level)
+    {
+        return;
+    }
+
+    GST_INFO_OBJECT(
+        self,
+        "Processing time %" GST_TIME_FORMAT " against a budget of %" GST_TIME_FORMAT
+        ", changing quality level from %d to %d",
+        GST_TIME_ARGS(self_private->quality_processing_time),
+        GST_TIME_ARGS(self->latency_budget),
+        prev_quality_level,
+        self_private->quality_level);
+
+    gst_element_post_message(
+        GST_ELEMENT(self),
+        gst_message_new_element(
+            GST_OBJECT(self),
+            gst_structure_new(
+                "cudaof-quality",
+                "quality-level",
+                G_TYPE_INT,
+                self_private->quality_level,
+                "previous-quality-level",
+                G_TYPE_INT,
+                prev_quality_level,
+                "max-quality-level",
+                G_TYPE_INT,
+                self_private->quality_max_level,
+                "processing-time",
+                GST_TYPE_CLOCK_TIME,
+                self_private->quality_processing_time,
+                "latency-budget",
+                GST_TYPE_CLOCK_TIME,
+                self->latency_budget,
+                "farneback-number-of-levels",
+                G_TYPE_INT,
+                self_private->quality_farneback_number_of_levels,
+                "farneback-window-size",
+                G_TYPE_INT,
+                self_private->quality_farneback_window_size,
+                "nvidia-performance-preset",
+                gst_cuda_of_performance_preset_get_type(),
+                self_private->quality_nvidia_performance_preset,
+                "nvidia-output-vector-grid-size",
+                gst_cuda_of_output_vector_grid_size_get_type(),
+                self_private->quality_nvidia_output_vector_grid_size,
+                NULL)));
+
+    self_private->quality_processing_time = GST_CLOCK_TIME_NONE;
+    self_private->quality_hold = quality_hold_frames;
+}
+
+static void gst_cuda_of_update_roi_set(GstCudaOf *self, GstBuffer *buffer)
+{
+    GstCudaOfPrivate *self_private
+        = gst_cuda_of_get_instance_private_typesafe(self);
+    GstCudaOfRoiSet *roi_set = NULL;
+    cv::Size flow_size = gst_cuda_of_get_flow_size(self);
+    guint x = 0;
+    guint y = 0;
+    guint width = 0;
+    guint height = 0;
+
+    if(self_private->static_roi_set != NULL)
+    {
+        roi_set = gst_cuda_of_roi_set_copy(self_private->static_roi_set);
+    }
+
+    if(self->roi_from_meta
+       && gst_buffer_get_meta(
+              buffer, GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+              != NULL)
+    {
+        if(roi_set == NULL)
+        {
+            roi_set = gst_cuda_of_roi_set_new();
+        }
+
+        gst_cuda_of_roi_set_add_from_buffer(roi_set, buffer);
+    }
+
+    if(!gst_cuda_of_roi_set_equal(roi_set, self_private->roi_set))
+    {
+        GST_DEBUG_OBJECT(
+            self,
+            "Regions of interest changed to %u regions",
+            gst_cuda_of_roi_set_get_size(roi_set));
+
+        gst_cuda_of_roi_set_free(self_private->roi_set);
+        self_private->roi_set = roi_set;
+        roi_set = NULL;
+
+        if(self->optical_flow_algorithm == OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0
+           && self_private->algorithm_is_initialised
+           && !self_private->algorithms.nvidia_optical_flow_algorithm.empty())
+        {
+            self_private->algorithms.nvidia_optical_flow_algorithm
+                ->collectGarbage();
+            self_private->algorithms.nvidia_optical_flow_algorithm.reset();
+            self_private->algorithm_is_initialised = FALSE;
+        }
+    }
+
+    gst_cuda_of_roi_set_free(roi_set);
+
+    self_private->roi_x = 0;
+    self_private->roi_y = 0;
+    self_private->roi_width = flow_size.width;
+    self_private->roi_height = flow_size.height;
+
+    /*
+     * Regions that do not cover any pixel of the frame leave the whole frame
+     * to be processed, rather than an empty matrix no algorithm accepts.
+     */
+    if(gst_cuda_of_roi_set_get_size(self_private->roi_set) > 0
+       && gst_cuda_of_roi_set_get_bounds(
+           self_private->roi_set,
+           -1,
+           self->parent.in_info.width,
+           self->parent.in_info.height,
+           &x,
+           &y,
+           &width,
+           &height))
+    {
+        gint margin = 2 * self_private->quality_farneback_window_size;
+        gint x_start = (gint)x / self->flow_scale - margin;
+        gint y_start = (gint)y / self->flow_scale - margin;
+        gint x_end = ((gint)(x + width) + self->flow_scale - 1)
+                         / self->flow_scale
+                     + margin;
+        gint y_end = ((gint)(y + height) + self->flow_scale - 1)
+                         / self->flow_scale
+                     + margin;
+
+        x_start = CLAMP(x_start, 0, flow_size.width);
+        y_start = CLAMP(y_start, 0, flow_size.height);
+        x_end = CLAMP(x_end, 0, flow_size.width);
+        y_end = CLAMP(y_end, 0, flow_size.height);
+
+        if(x_start < x_end && y_start < y_end)
+        {
+            self_private->roi_x = x_start;
+            self_private->roi_y = y_start;
+            self_private->roi_width = x_end - x_start;
+            self_private->roi_height = y_end - y_start;
+        }
+    }
+}
+
 // clang-format off
 /******************************************************************************/
 // clang-format on
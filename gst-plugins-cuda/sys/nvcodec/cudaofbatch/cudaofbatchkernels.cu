@@ -0,0 +1,87 @@
+typedef struct _CUDA2DPitchedArray
+{
+    void *device_ptr;
+    size_t pitch;
+    size_t width;
+    size_t height;
+    size_t elem_size;
+} CUDA2DPitchedArray;
+
+typedef struct _FrameDimensions
+{
+    size_t width;
+    size_t height;
+} FrameDimensions;
+
+extern "C" __global__ void gst_cuda_of_batch_feature_kernel(
+    const CUDA2DPitchedArray flow_vector_matrix,
+    const FrameDimensions frame_dimensions,
+    const unsigned int slot_rows,
+    const unsigned int features_matrix_width,
+    const unsigned int features_matrix_height,
+    const float flow_vector_threshold,
+    float *flow_features)
+{
+    unsigned int x_start
+        = (blockIdx.x * frame_dimensions.width + features_matrix_width - 1)
+          / features_matrix_width;
+    unsigned int x_end
+        = ((blockIdx.x + 1) * frame_dimensions.width + features_matrix_width - 1)
+          / features_matrix_width;
+    unsigned int y_start
+        = (blockIdx.y * frame_dimensions.height + features_matrix_height - 1)
+          / features_matrix_height;
+    unsigned int y_end
+        = ((blockIdx.y + 1) * frame_dimensions.height + features_matrix_height
+           - 1)
+          / features_matrix_height;
+
+    float spatial_magnitude = 0.0f;
+
+    __shared__ float block_spatial_magnitude;
+
+    if(threadIdx.x == 0 && threadIdx.y == 0)
+    {
+        block_spatial_magnitude = 0.0f;
+    }
+
+    __syncthreads();
+
+    for(unsigned int y_idx = y_start + threadIdx.y; y_idx < y_end;
+        y_idx += blockDim.y)
+    {
+        float2 *flow_vectors
+            = (float2 *)((char *)(flow_vector_matrix.device_ptr)
+                         + (blockIdx.z * slot_rows + y_idx)
+                               * flow_vector_matrix.pitch);
+
+        for(unsigned int x_idx = x_start + threadIdx.x; x_idx < x_end;
+            x_idx += blockDim.x)
+        {
+            float2 flow_vector = flow_vectors[x_idx];
+
+            if(flow_vector.x * flow_vector.x > flow_vector_threshold)
+            {
+                spatial_magnitude += fabsf(flow_vector.x);
+            }
+
+            if(flow_vector.y * flow_vector.y > flow_vector_threshold)
+            {
+                spatial_magnitude += fabsf(flow_vector.y);
+            }
+        }
+    }
+
+    atomicAdd(&block_spatial_magnitude, spatial_magnitude);
+
+    __syncthreads();
+
+    if(threadIdx.x == 0 && threadIdx.y == 0)
+    {
+        flow_features
+            [(blockIdx.z * features_matrix_height + blockIdx.y)
+                 * features_matrix_width
+             + blockIdx.x]
+            = block_spatial_magnitude;
+    }
+}
@@ -0,0 +1,2532 @@
+/**************************** Includes and Macros *****************************/
+
+/*
+ * Just an explanation for the below macro section:
+ *
+ * Up until GCC version 8, the support for the C++17 filesystem library within
+ * the STL was considered experimental. Thus, we need a different include path
+ * when dealing with older GCC versions.
+ */
+#include "gstcudaofbatch.h"
+
+#ifdef __GNUC__
+#include <features.h>
+#if __GNUC_PREREQ(8, 0)
+#include <filesystem>
+#else
+#include <experimental/filesystem>
+#endif
+#else
+#include <filesystem>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glib-object.h>
+#include <glibconfig.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
+#include <gst/cuda/of/gstcudaofbatch.h>
+#include <gst/cuda/of/gstmetaopticalflow.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <opencv2/core.hpp>
+#include <opencv2/core/cuda.hpp>
+#include <opencv2/core/cuda_stream_accessor.hpp>
+#include <opencv2/cudaoptflow.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <gst/cuda/nvcodec/gstcudacontext.h>
+#include <gst/cuda/nvcodec/gstcudaloader.h>
+#include <gst/cuda/nvcodec/gstcudamemory.h>
+#include <gst/cuda/nvcodec/gstcudanvrtc.h>
+#include <gst/cuda/nvcodec/gstcudautils.h>
+#include <gst/cuda/nvcodec/gstnvrtcloader.h>
+
+/*
+ * Just some setup for the GStreamer debug logger.
+ */
+GST_DEBUG_CATEGORY_STATIC(gst_cuda_of_batch_debug);
+#define GST_CAT_DEFAULT gst_cuda_of_batch_debug
+
+#define GST_CUDA_OF_BATCH(obj) \
+    (G_TYPE_CHECK_INSTANCE_CAST((obj), gst_cuda_of_batch_get_type(), GstCudaOfBatch))
+
+#define gst_cuda_of_batch_parent_class parent_class
+
+#ifndef GST_CUDA_OF_BATCH_KERNEL_SOURCE_PATH
+#define GST_CUDA_OF_BATCH_KERNEL_SOURCE_PATH "./cudaofbatchkernels.cu"
+#endif
+
+#define GST_CUDA_OF_BATCH_FEATURE_KERNEL "gst_cuda_of_batch_feature_kernel"
+
+/****************************** Static Variables ******************************/
+
+/**
+ * \brief The number of threads along the X and Y dimensions of a block of the
+ * feature kernel.
+ *
+ * \notes Each block loops over the vectors of its features matrix cell, so
+ * this is independent of the frame and features matrix dimensions.
+ */
+static const guint32 cuda_feature_kernel_block_dimension = 16u;
+
+/**
+ * \brief The default setting for the backend property.
+ */
+static const gint default_backend = BATCH_BACKEND_CUDA;
+
+/**
+ * \brief The default setting for the device-id property.
+ *
+ * \notes The default setting will result in the plugin either using the GPU
+ * used by a preceeding plugin in the pipeline, or use the first listed GPU
+ * installed into the system.
+ */
+static const gint default_device_id = -1;
+
+/**
+ * \brief The default setting for the farneback-number-of-levels property.
+ *
+ * \notes This is lower than the default of the cudaof element, as the rows
+ * separating the stacked frames double with every level of the pyramid.
+ * Three levels are plenty for the low resolution streams this element is
+ * meant for.
+ */
+static const gint default_farneback_number_of_levels = 3;
+
+/**
+ * \brief The default setting for the farneback-window-size property.
+ */
+static const gint default_farneback_window_size = 13;
+
+/**
+ * \brief The default setting for the features-matrix-height property.
+ */
+static const guint32 default_features_matrix_height = 20u;
+
+/**
+ * \brief The default setting for the features-matrix-width property.
+ */
+static const guint32 default_features_matrix_width = 20u;
+
+/**
+ * \brief The default setting for the kernel-source-location property.
+ *
+ * \notes By default, it will look for CUDA kernels source file via the
+ * following path: `$PREFIX/share/CUDA/cudaofbatchkernels.cu`.
+ */
+static const gchar *default_kernel_source_location
+    = GST_CUDA_OF_BATCH_KERNEL_SOURCE_PATH;
+
+/**
+ * \brief The default setting for the magnitude-quadrant-threshold-squared
+ * property.
+ *
+ * \notes This is the same threshold as used by the cudafeatureextractor
+ * element, so that the features of both elements can be compared.
+ */
+static const gfloat default_magnitude_quadrant_threshold_squared = 2.25f;
+
+/**
+ * \brief The default setting for the timeout property.
+ *
+ * \notes This is about a third of the frame duration of a 30 FPS stream, so
+ * the frames of streams that are not synchronised to each other still end up
+ * in the same batch most of the time.
+ */
+static const guint64 default_timeout = 10 * GST_MSECOND;
+
+/**
+ * \brief The Farneback parameters that are not exposed as properties.
+ *
+ * \notes These are the defaults of the cudaof element. The polynomial
+ * expansion neighbourhood in particular is assumed by
+ * gst_cuda_of_batch_slot_rows.
+ */
+static const gint farneback_number_of_iterations = 10;
+static const gint farneback_polynomial_expansion_n = 5;
+static const gdouble farneback_polynomial_expansion_sigma = 1.1;
+static const gdouble farneback_pyramid_scale = 0.5;
+
+/**
+ * \brief The number of features to use per aggregation operation for creating
+ * the aggregate output features array.
+ *
+ * \notes This matches the cudafeatureextractor element, so the output of this
+ * element can replace the output of a cudaof ! cudafeatureextractor pair.
+ */
+static const guint32 features_per_aggregation = 10u;
+
+/**
+ * \brief Anonymous enumeration containing the list of properties available for
+ * the GstCudaOfBatch GObject type this module defines.
+ */
+enum
+{
+    /**
+     * \brief ID number for the backend property.
+     */
+    PROP_BACKEND = 1,
+
+    /**
+     * \brief ID number for the GPU Device ID property.
+     */
+    PROP_DEVICE_ID,
+
+    /**
+     * \brief ID number for the farneback-number-of-levels property.
+     */
+    PROP_FARNEBACK_NUMBER_OF_LEVELS,
+
+    /**
+     * \brief ID number for the farneback-window-size property.
+     */
+    PROP_FARNEBACK_WINDOW_SIZE,
+
+    /**
+     * \brief ID number for the features-matrix-height property.
+     */
+    PROP_FEATURES_MATRIX_HEIGHT,
+
+    /**
+     * \brief ID number for the features-matrix-width property.
+     */
+    PROP_FEATURES_MATRIX_WIDTH,
+
+    /**
+     * \brief ID number for the kernel-source-location property.
+     */
+    PROP_KERNEL_SOURCE_LOCATION,
+
+    /**
+     * \brief ID number for the Magnitude Quadrant Threshold Squared property.
+     */
+    PROP_MAGNITUDE_QUADRANT_THRESHOLD_SQUARED,
+
+    /**
+     * \brief ID number for the timeout property.
+     */
+    PROP_TIMEOUT,
+
+    /**
+     * \brief Number of property ID numbers in this enum.
+     */
+    N_PROPERTIES
+};
+
+/**
+ * An array of GParamSpec instances representing the parameter specifications
+ * for the parameters installed on the GstCudaOfBatch GObject type.
+ */
+static GParamSpec *properties[N_PROPERTIES] = {
+    NULL,
+};
+
+/*
+ * Each stream gets a pair of pads. The sink pad is requested by the
+ * application, and the matching source pad is added at the same time, so the
+ * element behaves like a cudaof instance per stream to the rest of the
+ * pipeline.
+ */
+
+/**
+ * \brief Sink pad template for the GstCudaOfBatch GObject type.
+ *
+ * \notes The CUDAMemory caps are accepted by the CUDA backend and the system
+ * memory caps by the CPU backend. Only the luma plane is used.
+ */
+static GstStaticPadTemplate gst_cuda_of_batch_sink_template
+    = GST_STATIC_PAD_TEMPLATE(
+        "sink_%u",
+        GST_PAD_SINK,
+        GST_PAD_REQUEST,
+        GST_STATIC_CAPS(
+            "video/x-raw(memory:CUDAMemory), format = (string) NV12; "
+            "video/x-raw, format = (string) { NV12, I420, GRAY8 }"));
+
+/**
+ * \brief Source pad template for the GstCudaOfBatch GObject type.
+ *
+ * \notes The buffers of a stream leave the element unmodified, apart from the
+ * attached metadata, so the caps of a source pad are those of its sink pad.
+ */
+static GstStaticPadTemplate gst_cuda_of_batch_src_template
+    = GST_STATIC_PAD_TEMPLATE(
+        "src_%u",
+        GST_PAD_SRC,
+        GST_PAD_SOMETIMES,
+        GST_STATIC_CAPS(
+            "video/x-raw(memory:CUDAMemory), format = (string) NV12; "
+            "video/x-raw, format = (string) { NV12, I420, GRAY8 }"));
+
+/************************** Type/Struct Definitions ***************************/
+
+/**
+ * \brief A structure for representing an allocation of 2D pitched memory
+ * within GPU memory.
+ *
+ * \notes This structure is also defined within the CUDA kernel source-code,
+ * and it is the same structure as the one of the cudafeatureextractor element.
+ * It should NOT BE TOUCHED without changing the CUDA kernel source-code.
+ */
+typedef struct _CUDA2DPitchedArray
+{
+    /**
+     * \brief The pointer to the device (GPU) memory.
+     */
+    void *device_ptr;
+
+    /**
+     * \brief The pitch for the allocated 2D memory space.
+     */
+    gsize pitch;
+
+    /**
+     * \brief The width for the allocated 2D memory space in bytes.
+     */
+    gsize width;
+
+    /**
+     * \brief The height for the allocated 2D memory space in bytes.
+     */
+    gsize height;
+
+    /**
+     * \brief The size of the data-type for each element within the 2D memory
+     * space.
+     */
+    gsize elem_size;
+} CUDA2DPitchedArray;
+
+/**
+ * \brief A structure for representing the dimensions of a video frame.
+ *
+ * \notes This structure is also defined within the CUDA kernel source-code.
+ * It should NOT BE TOUCHED without changing the CUDA kernel source-code.
+ */
+typedef struct _FrameDimensions
+{
+    /**
+     * \brief The width of the frame in pixels.
+     */
+    size_t width;
+    /**
+     * \brief The height of the frame in pixels.
+     */
+    size_t height;
+} FrameDimensions;
+
+/**
+ * \brief The state of one of the streams batched by the element.
+ *
+ * \details All fields are protected by the lock of the element, except for
+ * the buffer and has_prev of a stream that is part of the batch currently
+ * being processed. Those are only touched by the thread processing the batch,
+ * as the streaming thread of the stream is blocked until its buffer has been
+ * processed.
+ */
+typedef struct _GstCudaOfBatchStream
+{
+    /**
+     * \brief The requested sink pad of the stream.
+     */
+    GstPad *sinkpad;
+
+    /**
+     * \brief The source pad of the stream, added along with the sink pad.
+     */
+    GstPad *srcpad;
+
+    /**
+     * \brief The index of the stream's frame within the stacked matrices.
+     */
+    guint slot;
+
+    /**
+     * \brief The buffer waiting to be batched, or NULL.
+     */
+    GstBuffer *buffer;
+
+    /**
+     * \brief The processed buffer waiting to be pushed by the streaming thread
+     * of the stream, or NULL.
+     */
+    GstBuffer *output;
+
+    /**
+     * \brief The result of processing the batch the buffer was part of.
+     */
+    GstFlowReturn flow_return;
+
+    /**
+     * \brief A flag that is set once the buffer has been processed.
+     */
+    gboolean done;
+
+    /**
+     * \brief A flag that is set while the buffer is part of the batch being
+     * processed.
+     */
+    gboolean in_batch;
+
+    /**
+     * \brief A flag that is set once the stream has received EOS.
+     */
+    gboolean eos;
+
+    /**
+     * \brief A flag that is set between a flush-start and a flush-stop.
+     */
+    gboolean flushing;
+
+    /**
+     * \brief A flag that is set once the previous frame of the stream is in
+     * its slot of the stacked previous frames matrix.
+     */
+    gboolean has_prev;
+
+    /**
+     * \brief The video information of the negotiated caps of the stream.
+     */
+    GstVideoInfo info;
+
+    /**
+     * \brief A flag that is set once caps have been negotiated.
+     */
+    gboolean has_info;
+} GstCudaOfBatchStream;
+
+/*
+ * \brief The structure for the GstCudaOfBatch GStreamer element type
+ * containing the public instance data.
+ */
+typedef struct _GstCudaOfBatch
+{
+    /**
+     * \brief The parent class' instance data.
+     *
+     * \details This is the structure for the parent class' instance data. When
+     * a pointer to an instance of this class is cast to an instance to the
+     * parent class or any other classes higher up in the class hierarchy, only
+     * the variables available to that class will be available to be modified
+     * or used.
+     */
+    GstElement parent;
+
+    /********************************* Public *********************************/
+
+    /**
+     * \brief The backend the batches are processed with.
+     */
+    gint backend;
+
+    /**
+     * \brief The ID of the GPU used by the CUDA backend.
+     */
+    gint device_id;
+
+    /**
+     * \brief The number of levels of the Farneback pyramid.
+     */
+    gint farneback_number_of_levels;
+
+    /**
+     * \brief The size of the Farneback window.
+     */
+    gint farneback_window_size;
+
+    /**
+     * \brief The number of rows in the features matrix of each stream.
+     */
+    guint32 features_matrix_height;
+
+    /**
+     * \brief The number of columns in the features matrix of each stream.
+     */
+    guint32 features_matrix_width;
+
+    /**
+     * \brief The path to the file containing the source code for the batched
+     * feature CUDA kernel.
+     */
+    gchar *kernel_source_location;
+
+    /**
+     * \brief The threshold the squared X and Y values of a vector have to
+     * exceed to contribute to the features.
+     */
+    gfloat magnitude_quadrant_threshold_squared;
+
+    /**
+     * \brief The time to wait for the frames of the other streams after the
+     * first frame of a batch arrived, in nanoseconds.
+     *
+     * \notes 0 waits until every stream that has not received EOS has a frame
+     * in the batch.
+     */
+    guint64 timeout;
+} GstCudaOfBatch;
+
+/*
+ * \brief The structure for the GstCudaOfBatch GStreamer element type
+ * containing the private instance data.
+ */
+typedef struct _GstCudaOfBatchPrivate
+{
+    /******************************** Batching ********************************/
+
+    /**
+     * \brief The lock protecting the streams and the batch state.
+     */
+    GMutex lock;
+
+    /**
+     * \brief The condition signalled whenever a buffer arrives, a batch has
+     * been processed or a stream changes its state.
+     */
+    GCond cond;
+
+    /**
+     * \brief The array of GstCudaOfBatchStream pointers, one per requested
+     * sink pad.
+     */
+    GPtrArray *streams;
+
+    /**
+     * \brief The monotonic time at which the current batch is processed even
+     * if not every stream has a frame in it, or 0 if the batch is empty.
+     */
+    gint64 deadline;
+
+    /**
+     * \brief A flag that is set while a batch is processed.
+     */
+    gboolean processing;
+
+    /**
+     * \brief The number of slots of the stacked matrices.
+     */
+    guint slots;
+
+    /******************************** Geometry ********************************/
+
+    /**
+     * \brief The width of the frames of all streams.
+     */
+    gint width;
+
+    /**
+     * \brief The height of the frames of all streams.
+     */
+    gint height;
+
+    /**
+     * \brief The number of rows between the first rows of two stacked frames.
+     */
+    guint slot_rows;
+
+    /********************************** CUDA **********************************/
+
+    /**
+     * \brief The CUDA context used by the CUDA backend.
+     */
+    GstCudaContext *context;
+
+    /**
+     * \brief The run-time compiled CUDA kernel module containing the batched
+     * feature kernel.
+     */
+    CUmodule cuda_module;
+
+    /**
+     * \brief A pointer to the CUDA kernel function for the batched features.
+     */
+    CUfunction feature_kernel;
+
+    /**
+     * \brief The stream every operation of a batch is enqueued on.
+     */
+    cv::cuda::Stream *cuda_stream;
+
+    /**
+     * \brief The Farneback algorithm shared by all streams.
+     */
+    cv::Ptr<cv::cuda::FarnebackOpticalFlow> *farneback;
+
+    /**
+     * \brief The stacked luma of the current frames of all streams.
+     */
+    cv::cuda::GpuMat *current_stack;
+
+    /**
+     * \brief The stacked luma of the previous frames of all streams.
+     */
+    cv::cuda::GpuMat *prev_stack;
+
+    /**
+     * \brief The features of all streams, as written by the feature kernel.
+     */
+    cv::cuda::GpuMat *features;
+
+    /*********************************** CPU **********************************/
+
+    /**
+     * \brief The stacked luma of the current frames of all streams.
+     */
+    cv::Mat *host_current_stack;
+
+    /**
+     * \brief The stacked luma of the previous frames of all streams.
+     */
+    cv::Mat *host_prev_stack;
+
+    /********************************* Common *********************************/
+
+    /**
+     * \brief The pool of slabs holding the features of the
+     * GstMetaAlgorithmFeatures instances, or NULL if none were attached yet.
+     */
+    GstAlgorithmFeaturesPool *features_pool;
+} GstCudaOfBatchPrivate;
+
+/**
+ * \brief The structure for the GstCudaOfBatch GStreamer element type
+ * containing the class' data.
+ */
+typedef struct _GstCudaOfBatchClass
+{
+    /********************************** Base **********************************/
+
+    /**
+     * \brief The parent class' structure.
+     */
+    GstElementClass parent_class;
+} GstCudaOfBatchClass;
+
+/**
+ * \brief Exception representing errors utilising GStreamer's CUDA
+ * methods/data-types.
+ */
+class GstCudaException : public std::logic_error
+{
+    public:
+    /************************ Public Member Functions *************************/
+
+    /**
+     * \brief Default constructor.
+     *
+     * \details Constructs an instance of this exception with the given
+     * message.
+     */
+    explicit GstCudaException(const std::string &what_arg)
+        : std::logic_error(what_arg)
+    {
+    }
+
+    /**
+     * \brief Default constructor.
+     *
+     * \details Constructs an instance of this exception with the given
+     * message.
+     */
+    explicit GstCudaException(const char *what_arg) : std::logic_error(what_arg)
+    {
+    }
+
+    /**
+     * \brief Copy constructor.
+     *
+     * \details Constructs an instance of this exception with the message from
+     * another instance of this exception.
+     */
+    GstCudaException(const GstCudaException &other) noexcept
+        : GstCudaException(other.what())
+    {
+    }
+
+    /**
+     * \brief Returns the instance's message.
+     *
+     * \returns The instance's message.
+     */
+    const char *what() const noexcept override
+    {
+        return std::logic_error::what();
+    }
+};
+
+/*************************** Function Declarations ****************************/
+
+/**
+ * \brief Aggregates the features of a stream in groups using the MAX operator
+ * and attaches them to its buffer as a GstMetaAlgorithmFeatures instance.
+ *
+ * \details The aggregates are written into a slab from the features pool, so
+ * this does not allocate once the pool holds a slab per buffer in flight.
+ *
+ * \param[in] self A GstCudaOfBatch GObject instance.
+ * \param[in,out] buffer The writable buffer of the stream.
+ * \param[in] features A pointer to the features of the stream.
+ */
+static void gst_cuda_of_batch_attach_features(
+    GstCudaOfBatch *self,
+    GstBuffer *buffer,
+    const gfloat *features);
+
+/**
+ * \brief State change handler for the GstCudaOfBatch element.
+ *
+ * \details The backend is set up when going from READY to PAUSED. When going
+ * from PAUSED to READY, every stream is flushed first to release the
+ * streaming threads waiting for a batch, then the backend is released.
+ *
+ * \param[in,out] element A GstCudaOfBatch instance.
+ * \param[in] transition The state transition to perform.
+ *
+ * \returns The result of the state change.
+ */
+static GstStateChangeReturn gst_cuda_of_batch_change_state(
+    GstElement *element,
+    GstStateChange transition);
+
+/**
+ * \brief Takes every waiting buffer into a batch, processes it and hands the
+ * processed buffers back to their streams.
+ *
+ * \details This is called by whichever streaming thread notices the batch is
+ * ready, with the lock held. The lock is released while the batch is processed.
+ * Every streaming thread pushes its own buffer once woken up, so a downstream
+ * element that blocks, e.g. a sink prerolling, only blocks its own stream.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ */
+static void gst_cuda_of_batch_collect(GstCudaOfBatch *self);
+
+/**
+ * \brief Disposal method for the GstCudaOfBatch GObject type.
+ *
+ * \param[in,out] gobject A GstCudaOfBatch GObject instance to release all
+ * held resources from.
+ */
+static void gst_cuda_of_batch_dispose(GObject *gobject);
+
+/**
+ * \brief Finalisation method for the GstCudaOfBatch GObject type.
+ *
+ * \param[in,out] gobject A GstCudaOfBatch GObject instance to free.
+ */
+static void gst_cuda_of_batch_finalize(GObject *gobject);
+
+/**
+ * \brief Returns the caps accepted by the selected backend.
+ *
+ * \param[in] self A GstCudaOfBatch instance.
+ *
+ * \returns A new reference to the caps of the backend.
+ */
+static GstCaps *gst_cuda_of_batch_get_backend_caps(GstCudaOfBatch *self);
+
+/**
+ * \brief Wrapper around gst_cuda_of_batch_get_instance_private.
+ *
+ * \param[in] self A GstCudaOfBatch GObject instance.
+ *
+ * \returns A pointer to the GstCudaOfBatchPrivate instance for the given
+ * GstCudaOfBatch instance.
+ */
+static GstCudaOfBatchPrivate *
+gst_cuda_of_batch_get_instance_private_typesafe(GstCudaOfBatch *self);
+
+/**
+ * \brief Property getter for instances of the GstCudaOfBatch GObject.
+ *
+ * \param[in] gobject A GstCudaOfBatch GObject instance to get the property
+ * from.
+ * \param[in] prop_id The ID number for the property to get.
+ * \param[out] value The GValue instance that will contain the value of the
+ * property.
+ * \param[in] pspec The property specification instance for the property.
+ */
+static void gst_cuda_of_batch_get_property(
+    GObject *gobject,
+    guint prop_id,
+    GValue *value,
+    GParamSpec *pspec);
+
+/**
+ * \brief Checks whether the waiting buffers should be processed as a batch.
+ *
+ * \details A batch is ready once every stream that has neither received EOS
+ * nor is flushing has a buffer waiting, or once the deadline set by the first
+ * buffer of the batch has passed. Only a single batch is processed at a time.
+ *
+ * \param[in] self A GstCudaOfBatch instance, with the lock held.
+ *
+ * \returns TRUE if the waiting buffers should be processed. FALSE otherwise.
+ */
+static gboolean gst_cuda_of_batch_is_ready(GstCudaOfBatch *self);
+
+/**
+ * \brief Iterates over the pad linked internally to the given pad.
+ *
+ * \details The sink pad and the source pad of a stream are linked internally,
+ * which lets the default query and event handlers proxy the caps, allocation
+ * and upstream events of a stream.
+ *
+ * \param[in] pad A pad of the element.
+ * \param[in] parent The element.
+ *
+ * \returns A new iterator over the internally linked pad.
+ */
+static GstIterator *
+gst_cuda_of_batch_iterate_internal_links(GstPad *pad, GstObject *parent);
+
+/**
+ * \brief Processes a batch of buffers, attaching the metadata to them.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ * \param[in,out] batch The streams whose buffers are part of the batch.
+ *
+ * \returns GST_FLOW_OK if the batch was processed. GST_FLOW_ERROR if an error
+ * occurred, which is also posted on the bus.
+ */
+static GstFlowReturn
+gst_cuda_of_batch_process(GstCudaOfBatch *self, GPtrArray *batch);
+
+/**
+ * \brief Processes a batch of buffers on the host.
+ *
+ * \details The luma of every buffer is copied into its slot of the stacked
+ * current frames matrix, after the previous contents of the slot have been
+ * moved to the stacked previous frames matrix. The optical flow of every slot
+ * is then calculated by a single Farneback calculation over the stacked
+ * matrices, and the features of every slot by a single pass over the stacked
+ * optical flow.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ * \param[in,out] batch The streams whose buffers are part of the batch.
+ *
+ * \exception std::runtime_error If a buffer cannot be mapped.
+ */
+static void gst_cuda_of_batch_process_cpu(GstCudaOfBatch *self, GPtrArray *batch);
+
+/**
+ * \brief Processes a batch of buffers on the GPU.
+ *
+ * \details This is the same procedure as gst_cuda_of_batch_process_cpu, with
+ * the copies, the Farneback calculation, the feature kernel and the download
+ * of the features all enqueued on a single CUDA stream. The stream is
+ * synchronised once per batch.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ * \param[in,out] batch The streams whose buffers are part of the batch.
+ *
+ * \exception GstCudaException If a CUDA operation fails.
+ */
+static void gst_cuda_of_batch_process_cuda(GstCudaOfBatch *self, GPtrArray *batch);
+
+/**
+ * \brief Handles the queries on the pads of the element.
+ *
+ * \details The CUDA context is shared with the neighbouring elements. The caps
+ * of the sink pads are restricted to those of the selected backend. Every
+ * other query is proxied between the pads of a stream.
+ *
+ * \param[in] pad The pad the query was received on.
+ * \param[in] parent The element.
+ * \param[in,out] query The query.
+ *
+ * \returns TRUE if the query was answered. FALSE otherwise.
+ */
+static gboolean
+gst_cuda_of_batch_query(GstPad *pad, GstObject *parent, GstQuery *query);
+
+/**
+ * \brief Releases a requested sink pad, along with its source pad.
+ *
+ * \param[in,out] element A GstCudaOfBatch instance.
+ * \param[in] pad The sink pad to release.
+ */
+static void gst_cuda_of_batch_release_pad(GstElement *element, GstPad *pad);
+
+/**
+ * \brief Creates a new sink pad, along with its source pad.
+ *
+ * \param[in,out] element A GstCudaOfBatch instance.
+ * \param[in] templ The template of the requested pad.
+ * \param[in] name The requested name, or NULL to pick the next free index.
+ * \param[in] caps Unused.
+ *
+ * \returns The new sink pad, or NULL if the name is taken.
+ */
+static GstPad *gst_cuda_of_batch_request_new_pad(
+    GstElement *element,
+    GstPadTemplate *templ,
+    const gchar *name,
+    const GstCaps *caps);
+
+/**
+ * \brief Shares the CUDA context of the pipeline with the element.
+ *
+ * \param[in,out] element A GstCudaOfBatch instance.
+ * \param[in] context The context set on the element.
+ */
+static void
+gst_cuda_of_batch_set_context(GstElement *element, GstContext *context);
+
+/**
+ * \brief Property setter for instances of the GstCudaOfBatch GObject.
+ *
+ * \param[in,out] gobject A GstCudaOfBatch GObject instance to set the
+ * property on.
+ * \param[in] prop_id The ID number for the property to set.
+ * \param[in] value The GValue instance containing the new value.
+ * \param[in] pspec The property specification instance for the property.
+ */
+static void gst_cuda_of_batch_set_property(
+    GObject *gobject,
+    guint prop_id,
+    const GValue *value,
+    GParamSpec *pspec);
+
+/**
+ * \brief Receives a buffer of a stream, blocks until it was processed as part
+ * of a batch and pushes it.
+ *
+ * \details Blocking the streaming thread of a stream until its buffer has
+ * been processed and pushed keeps the buffers and the serialised events of
+ * the stream in order, and limits every stream to a single buffer in flight.
+ *
+ * \param[in] pad The sink pad of the stream.
+ * \param[in] parent The element.
+ * \param[in] buffer The buffer.
+ *
+ * \returns The result of pushing the buffer on the source pad of the stream.
+ */
+static GstFlowReturn
+gst_cuda_of_batch_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer);
+
+/**
+ * \brief Handles the events received on a sink pad.
+ *
+ * \details The caps of every stream must have the same dimensions, as the
+ * frames are stacked. EOS and flushing events update the state of the stream
+ * and wake up the streams waiting for a batch. Every event is forwarded on
+ * the source pad of the stream.
+ *
+ * \param[in] pad The sink pad of the stream.
+ * \param[in] parent The element.
+ * \param[in] event The event.
+ *
+ * \returns TRUE if the event was handled. FALSE otherwise.
+ */
+static gboolean
+gst_cuda_of_batch_sink_event(GstPad *pad, GstObject *parent, GstEvent *event);
+
+/**
+ * \brief Sets up the selected backend.
+ *
+ * \details For the CUDA backend, the CUDA context is retrieved, the batched
+ * feature kernel is compiled with NVRTC, and the Farneback algorithm and the
+ * CUDA stream are created.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ *
+ * \returns TRUE if the backend was set up. FALSE otherwise.
+ */
+static gboolean gst_cuda_of_batch_start(GstCudaOfBatch *self);
+
+/**
+ * \brief Releases the resources of the backend.
+ *
+ * \param[in,out] self A GstCudaOfBatch instance.
+ */
+static void gst_cuda_of_batch_stop(GstCudaOfBatch *self);
+
+/************************** GObject Type Definitions **************************/
+
+G_DEFINE_TYPE_WITH_PRIVATE(GstCudaOfBatch, gst_cuda_of_batch, GST_TYPE_ELEMENT)
+
+/**************************** Function Definitions ****************************/
+
+static void gst_cuda_of_batch_attach_features(
+    GstCudaOfBatch *self,
+    GstBuffer *buffer,
+    const gfloat *features)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    gsize slab_size = gst_meta_algorithm_features_get_slab_size(
+        self->features_matrix_width,
+        self->features_matrix_height,
+        features_per_aggregation,
+        0,
+        0);
+
+    if(self_private->features_pool != NULL
+       && gst_algorithm_features_pool_get_slab_size(self_private->features_pool)
+              != slab_size)
+    {
+        gst_algorithm_features_pool_unref(self_private->features_pool);
+        self_private->features_pool = NULL;
+    }
+
+    if(self_private->features_pool == NULL)
+    {
+        self_private->features_pool
+            = gst_algorithm_features_pool_new(slab_size);
+    }
+
+    GstMetaAlgorithmFeatures *algorithm_features_meta
+        = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    if(gst_meta_algorithm_features_set_layout(
+           algorithm_features_meta,
+           self_private->features_pool,
+           self->features_matrix_width,
+           self->features_matrix_height,
+           features_per_aggregation,
+           0,
+           0))
+    {
+        gst_algorithm_features_aggregate(
+            features,
+            (gsize)self->features_matrix_width * self->features_matrix_height,
+            features_per_aggregation,
+            algorithm_features_meta->features);
+    }
+}
+
+static GstStateChangeReturn gst_cuda_of_batch_change_state(
+    GstElement *element,
+    GstStateChange transition)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(element);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    GstStateChangeReturn result = GST_STATE_CHANGE_SUCCESS;
+
+    switch(transition)
+    {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            if(!gst_cuda_of_batch_start(self))
+            {
+                gst_cuda_of_batch_stop(self);
+                return GST_STATE_CHANGE_FAILURE;
+            }
+            break;
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /*
+             * The sink pads are deactivated while chaining up, which waits
+             * for the streaming threads. Those may be waiting for a batch
+             * that will never be complete, so they are released first.
+             */
+            g_mutex_lock(&self_private->lock);
+            for(guint idx = 0; idx < self_private->streams->len; idx++)
+            {
+                auto *stream = static_cast<GstCudaOfBatchStream *>(
+                    g_ptr_array_index(self_private->streams, idx));
+                stream->flushing = TRUE;
+            }
+            g_cond_broadcast(&self_private->cond);
+            g_mutex_unlock(&self_private->lock);
+            break;
+        default:
+            break;
+    }
+
+    result = GST_ELEMENT_CLASS(parent_class)->change_state(element, transition);
+
+    switch(transition)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            gst_cuda_of_batch_stop(self);
+
+            g_mutex_lock(&self_private->lock);
+            for(guint idx = 0; idx < self_private->streams->len; idx++)
+            {
+                auto *stream = static_cast<GstCudaOfBatchStream *>(
+                    g_ptr_array_index(self_private->streams, idx));
+                stream->eos = FALSE;
+                stream->flushing = FALSE;
+                stream->has_prev = FALSE;
+                stream->has_info = FALSE;
+            }
+            self_private->deadline = 0;
+            self_private->width = 0;
+            self_private->height = 0;
+            g_mutex_unlock(&self_private->lock);
+            break;
+        default:
+            break;
+    }
+
+    return result;
+}
+
+/**
+ * \brief Initialisation function for the GstCudaOfBatchClass GObjectClass
+ * type.
+ *
+ * \param[in,out] klass The instance of the GstCudaOfBatchClass GObjectClass
+ * structure.
+ */
+static void gst_cuda_of_batch_class_init(GstCudaOfBatchClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *gstelement_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->dispose = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_dispose);
+    gobject_class->finalize = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_finalize);
+    gobject_class->set_property
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_set_property);
+    gobject_class->get_property
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_get_property);
+
+    properties[PROP_BACKEND] = g_param_spec_enum(
+        "backend",
+        "Backend",
+        "The backend the batched optical flow and features are calculated "
+        "with.",
+        GST_TYPE_CUDA_OF_BATCH_BACKEND,
+        default_backend,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_DEVICE_ID] = g_param_spec_int(
+        "cuda-device-id",
+        "Cuda Device ID",
+        "Set the GPU device to use for operations (-1 = auto)",
+        -1,
+        G_MAXINT,
+        default_device_id,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_NUMBER_OF_LEVELS] = g_param_spec_int(
+        "farneback-number-of-levels",
+        "Farneback Number of Levels",
+        "The number of pyramid levels of the Farneback algorithm. The rows "
+        "separating the stacked frames double with every level.",
+        1,
+        G_MAXINT,
+        default_farneback_number_of_levels,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FARNEBACK_WINDOW_SIZE] = g_param_spec_int(
+        "farneback-window-size",
+        "Farneback Window Size",
+        "The averaging window size of the Farneback algorithm.",
+        1,
+        G_MAXINT,
+        default_farneback_window_size,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FEATURES_MATRIX_HEIGHT] = g_param_spec_uint(
+        "features-matrix-height",
+        "Features Matrix Height",
+        "The number of rows for the features matrix of each stream.",
+        1,
+        G_MAXUINT16,
+        default_features_matrix_height,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_FEATURES_MATRIX_WIDTH] = g_param_spec_uint(
+        "features-matrix-width",
+        "Features Matrix Width",
+        "The number of columns for the features matrix of each stream.",
+        1,
+        G_MAXUINT16,
+        default_features_matrix_width,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_KERNEL_SOURCE_LOCATION] = g_param_spec_string(
+        "kernel-source-location",
+        "Kernel Source Location",
+        "Specifies the filepath for the batched feature kernel source "
+        "compiled by NVRTC during runtime.",
+        default_kernel_source_location,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_MAGNITUDE_QUADRANT_THRESHOLD_SQUARED] = g_param_spec_float(
+        "magnitude-quadrant-threshold-squared",
+        "Magnitude Quadrant Threshold Squared",
+        "The threshold the squared X and Y values of a vector have to exceed "
+        "to contribute to the features.",
+        0.0f,
+        G_MAXFLOAT,
+        default_magnitude_quadrant_threshold_squared,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+    properties[PROP_TIMEOUT] = g_param_spec_uint64(
+        "timeout",
+        "Timeout",
+        "The time in nanoseconds to wait for the frames of the other streams "
+        "after the first frame of a batch arrived (0 = wait for every "
+        "stream).",
+        0,
+        G_MAXUINT64,
+        default_timeout,
+        (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_properties(gobject_class, N_PROPERTIES, properties);
+
+    gst_element_class_add_pad_template(
+        gstelement_class,
+        gst_static_pad_template_get(&gst_cuda_of_batch_sink_template));
+    gst_element_class_add_pad_template(
+        gstelement_class,
+        gst_static_pad_template_get(&gst_cuda_of_batch_src_template));
+
+    gst_element_class_set_metadata(
+        gstelement_class,
+        "CUDA Batched Optical Flow",
+        "Filter/Video/Hardware",
+        "Calculates the optical flow and features of many streams at once, by "
+        "stacking their frames, and attaches them as buffer metadata to each "
+        "stream.",
+        "icetana");
+
+    gstelement_class->change_state
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_change_state);
+    gstelement_class->release_pad
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_release_pad);
+    gstelement_class->request_new_pad
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_request_new_pad);
+    gstelement_class->set_context
+        = GST_DEBUG_FUNCPTR(gst_cuda_of_batch_set_context);
+}
+
+static void gst_cuda_of_batch_collect(GstCudaOfBatch *self)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    GPtrArray *batch = g_ptr_array_new();
+    guint slots = 0;
+
+    for(guint idx = 0; idx < self_private->streams->len; idx++)
+    {
+        auto *stream = static_cast<GstCudaOfBatchStream *>(
+            g_ptr_array_index(self_private->streams, idx));
+
+        slots = MAX(slots, stream->slot + 1);
+
+        if(stream->buffer != NULL && !stream->in_batch)
+        {
+            stream->in_batch = TRUE;
+            g_ptr_array_add(batch, stream);
+        }
+    }
+
+    /*
+     * The stacked matrices are reallocated when streams are added past the
+     * current number of slots, which loses the previous frames of every
+     * stream. This normally only happens while the first batch is collected.
+     */
+    if(slots != self_private->slots)
+    {
+        for(guint idx = 0; idx < self_private->streams->len; idx++)
+        {
+            auto *stream = static_cast<GstCudaOfBatchStream *>(
+                g_ptr_array_index(self_private->streams, idx));
+            stream->has_prev = FALSE;
+        }
+
+        self_private->slots = slots;
+    }
+
+    self_private->processing = TRUE;
+    self_private->deadline = 0;
+
+    g_mutex_unlock(&self_private->lock);
+
+    GST_LOG_OBJECT(
+        self, "Processing a batch of %u of %u streams", batch->len, slots);
+
+    GstFlowReturn result = gst_cuda_of_batch_process(self, batch);
+
+    g_mutex_lock(&self_private->lock);
+
+    for(guint idx = 0; idx < batch->len; idx++)
+    {
+        auto *stream
+            = static_cast<GstCudaOfBatchStream *>(g_ptr_array_index(batch, idx));
+
+        if(result == GST_FLOW_OK)
+        {
+            stream->output = stream->buffer;
+        }
+        else
+        {
+            gst_buffer_unref(stream->buffer);
+        }
+
+        stream->buffer = NULL;
+        stream->flow_return = result;
+        stream->in_batch = FALSE;
+        stream->done = TRUE;
+    }
+
+    self_private->processing = FALSE;
+    g_cond_broadcast(&self_private->cond);
+
+    g_ptr_array_unref(batch);
+}
+
+static void gst_cuda_of_batch_dispose(GObject *gobject)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(gobject);
+
+    gst_cuda_of_batch_stop(self);
+
+    G_OBJECT_CLASS(parent_class)->dispose(gobject);
+}
+
+static void gst_cuda_of_batch_finalize(GObject *gobject)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(gobject);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+
+    /*
+     * The streams are freed when their pads are released, which happens
+     * while the element is disposed.
+     */
+    g_ptr_array_unref(self_private->streams);
+    g_mutex_clear(&self_private->lock);
+    g_cond_clear(&self_private->cond);
+    g_free(self->kernel_source_location);
+
+    G_OBJECT_CLASS(parent_class)->finalize(gobject);
+}
+
+static GstCaps *gst_cuda_of_batch_get_backend_caps(GstCudaOfBatch *self)
+{
+    GstCaps *template_caps
+        = gst_static_pad_template_get_caps(&gst_cuda_of_batch_sink_template);
+    GstCaps *caps = gst_caps_new_empty();
+    gboolean cuda = self->backend == BATCH_BACKEND_CUDA;
+
+    for(guint idx = 0; idx < gst_caps_get_size(template_caps); idx++)
+    {
+        GstCapsFeatures *features = gst_caps_get_features(template_caps, idx);
+
+        if(cuda
+           == gst_caps_features_contains(
+               features, GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY))
+        {
+            caps = gst_caps_merge_structure_full(
+                caps,
+                gst_structure_copy(gst_caps_get_structure(template_caps, idx)),
+                gst_caps_features_copy(features));
+        }
+    }
+
+    gst_caps_unref(template_caps);
+
+    return caps;
+}
+
+static GstCudaOfBatchPrivate *
+gst_cuda_of_batch_get_instance_private_typesafe(GstCudaOfBatch *self)
+{
+    return static_cast<GstCudaOfBatchPrivate *>(
+        gst_cuda_of_batch_get_instance_private(self));
+}
+
+static void gst_cuda_of_batch_get_property(
+    GObject *gobject,
+    guint prop_id,
+    GValue *value,
+    GParamSpec *pspec)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(gobject);
+
+    switch(prop_id)
+    {
+        case PROP_BACKEND:
+            g_value_set_enum(value, self->backend);
+            break;
+        case PROP_DEVICE_ID:
+            g_value_set_int(value, self->device_id);
+            break;
+        case PROP_FARNEBACK_NUMBER_OF_LEVELS:
+            g_value_set_int(value, self->farneback_number_of_levels);
+            break;
+        case PROP_FARNEBACK_WINDOW_SIZE:
+            g_value_set_int(value, self->farneback_window_size);
+            break;
+        case PROP_FEATURES_MATRIX_HEIGHT:
+            g_value_set_uint(value, self->features_matrix_height);
+            break;
+        case PROP_FEATURES_MATRIX_WIDTH:
+            g_value_set_uint(value, self->features_matrix_width);
+            break;
+        case PROP_KERNEL_SOURCE_LOCATION:
+            g_value_set_string(value, self->kernel_source_location);
+            break;
+        case PROP_MAGNITUDE_QUADRANT_THRESHOLD_SQUARED:
+            g_value_set_float(value, self->magnitude_quadrant_threshold_squared);
+            break;
+        case PROP_TIMEOUT:
+            GST_OBJECT_LOCK(self);
+            g_value_set_uint64(value, self->timeout);
+            GST_OBJECT_UNLOCK(self);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(gobject, prop_id, pspec);
+            break;
+    }
+}
+
+/**
+ * \brief Initialisation function for GstCudaOfBatch instances.
+ *
+ * \param[in,out] self An instance of the GstCudaOfBatch GObject type.
+ */
+static void gst_cuda_of_batch_init(GstCudaOfBatch *self)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+
+    self->backend = default_backend;
+    self->device_id = default_device_id;
+    self->farneback_number_of_levels = default_farneback_number_of_levels;
+    self->farneback_window_size = default_farneback_window_size;
+    self->features_matrix_height = default_features_matrix_height;
+    self->features_matrix_width = default_features_matrix_width;
+    self->kernel_source_location = g_strdup(default_kernel_source_location);
+    self->magnitude_quadrant_threshold_squared
+        = default_magnitude_quadrant_threshold_squared;
+    self->timeout = default_timeout;
+
+    g_mutex_init(&self_private->lock);
+    g_cond_init(&self_private->cond);
+    self_private->streams = g_ptr_array_new();
+    self_private->deadline = 0;
+    self_private->processing = FALSE;
+    self_private->slots = 0;
+
+    self_private->width = 0;
+    self_private->height = 0;
+    self_private->slot_rows = 0;
+
+    self_private->context = NULL;
+    self_private->cuda_module = NULL;
+    self_private->feature_kernel = NULL;
+    self_private->cuda_stream = nullptr;
+    self_private->farneback = nullptr;
+    self_private->current_stack = nullptr;
+    self_private->prev_stack = nullptr;
+    self_private->features = nullptr;
+
+    self_private->host_current_stack = nullptr;
+    self_private->host_prev_stack = nullptr;
+
+    self_private->features_pool = NULL;
+}
+
+static gboolean gst_cuda_of_batch_is_ready(GstCudaOfBatch *self)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    guint active = 0;
+    guint waiting = 0;
+    guint64 timeout;
+
+    if(self_private->processing)
+    {
+        return FALSE;
+    }
+
+    for(guint idx = 0; idx < self_private->streams->len; idx++)
+    {
+        auto *stream = static_cast<GstCudaOfBatchStream *>(
+            g_ptr_array_index(self_private->streams, idx));
+
+        if(!stream->eos && !stream->flushing)
+        {
+            active++;
+        }
+
+        if(stream->buffer != NULL && !stream->in_batch)
+        {
+            waiting++;
+        }
+    }
+
+    if(waiting == 0)
+    {
+        return FALSE;
+    }
+
+    if(waiting >= active)
+    {
+        return TRUE;
+    }
+
+    GST_OBJECT_LOCK(self);
+    timeout = self->timeout;
+    GST_OBJECT_UNLOCK(self);
+
+    return timeout > 0 && g_get_monotonic_time() >= self_private->deadline;
+}
+
+static GstIterator *
+gst_cuda_of_batch_iterate_internal_links(GstPad *pad, GstObject *parent)
+{
+    auto *stream
+        = static_cast<GstCudaOfBatchStream *>(gst_pad_get_element_private(pad));
+    GstPad *otherpad = NULL;
+    GstIterator *it = NULL;
+    GValue value = G_VALUE_INIT;
+
+    if(stream == NULL)
+    {
+        return NULL;
+    }
+
+    otherpad = pad == stream->sinkpad ? stream->srcpad : stream->sinkpad;
+
+    g_value_init(&value, GST_TYPE_PAD);
+    g_value_set_object(&value, otherpad);
+    it = gst_iterator_new_single(GST_TYPE_PAD, &value);
+    g_value_unset(&value);
+
+    return it;
+}
+
+gboolean gst_cuda_of_batch_plugin_init(GstPlugin *plugin)
+{
+    GST_DEBUG_CATEGORY_INIT(
+        gst_cuda_of_batch_debug,
+        "cudaofbatch",
+        0,
+        "CUDA batched optical flow");
+
+    return gst_element_register(
+        plugin, "cudaofbatch", GST_RANK_NONE, gst_cuda_of_batch_get_type());
+}
+
+static GstFlowReturn
+gst_cuda_of_batch_process(GstCudaOfBatch *self, GPtrArray *batch)
+{
+    GstFlowReturn result = GST_FLOW_OK;
+
+    try
+    {
+        switch(self->backend)
+        {
+            case BATCH_BACKEND_CPU:
+                gst_cuda_of_batch_process_cpu(self, batch);
+                break;
+            case BATCH_BACKEND_CUDA:
+            default:
+                gst_cuda_of_batch_process_cuda(self, batch);
+                break;
+        }
+    }
+    catch(GstCudaException &ex)
+    {
+        GST_ELEMENT_ERROR(
+            self,
+            LIBRARY,
+            FAILED,
+            ("GStreamer CUDA error - %s", ex.what()),
+            (NULL));
+
+        result = GST_FLOW_ERROR;
+    }
+    catch(cv::Exception &ex)
+    {
+        GST_ELEMENT_ERROR(
+            self, LIBRARY, FAILED, ("OpenCV error - %s", ex.what()), (NULL));
+
+        result = GST_FLOW_ERROR;
+    }
+    catch(std::exception &ex)
+    {
+        GST_ELEMENT_ERROR(
+            self, LIBRARY, FAILED, ("General error - %s", ex.what()), (NULL));
+
+        result = GST_FLOW_ERROR;
+    }
+
+    return result;
+}
+
+static void gst_cuda_of_batch_process_cpu(GstCudaOfBatch *self, GPtrArray *batch)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    const guint slots = self_private->slots;
+    const guint slot_rows = self_private->slot_rows;
+    const gint width = self_private->width;
+    const gint height = self_private->height;
+    const gsize features_per_slot
+        = (gsize)self->features_matrix_width * self->features_matrix_height;
+    const gint rows = (gint)(slots * slot_rows);
+
+    if(self_private->host_current_stack == nullptr)
+    {
+        self_private->host_current_stack = new cv::Mat();
+        self_private->host_prev_stack = new cv::Mat();
+    }
+
+    /*
+     * The rows separating the frames are zero and stay zero, as only the rows
+     * of the frames themselves are ever written.
+     */
+    if(self_private->host_current_stack->rows != rows
+       || self_private->host_current_stack->cols != width)
+    {
+        *(self_private->host_current_stack) = cv::Mat::zeros(rows, width, CV_8UC1);
+        *(self_private->host_prev_stack) = cv::Mat::zeros(rows, width, CV_8UC1);
+    }
+
+    for(guint idx = 0; idx < batch->len; idx++)
+    {
+        auto *stream
+            = static_cast<GstCudaOfBatchStream *>(g_ptr_array_index(batch, idx));
+        GstVideoFrame frame;
+        cv::Range slot_range(
+            (gint)(stream->slot * slot_rows),
+            (gint)(stream->slot * slot_rows) + height);
+        cv::Mat current_slot = self_private->host_current_stack->rowRange(slot_range);
+
+        if(!gst_video_frame_map(&frame, &stream->info, stream->buffer, GST_MAP_READ))
+        {
+            throw std::runtime_error("Could not map the buffer of a stream.");
+        }
+
+        if(stream->has_prev)
+        {
+            current_slot.copyTo(self_private->host_prev_stack->rowRange(slot_range));
+        }
+
+        cv::Mat(
+            height,
+            width,
+            CV_8UC1,
+            GST_VIDEO_FRAME_PLANE_DATA(&frame, 0),
+            GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0))
+            .copyTo(current_slot);
+
+        gst_video_frame_unmap(&frame);
+    }
+
+    cv::Mat flow;
+    std::vector<gfloat> features(features_per_slot * slots);
+
+    cv::calcOpticalFlowFarneback(
+        *(self_private->host_prev_stack),
+        *(self_private->host_current_stack),
+        flow,
+        farneback_pyramid_scale,
+        self->farneback_number_of_levels,
+        self->farneback_window_size,
+        farneback_number_of_iterations,
+        farneback_polynomial_expansion_n,
+        farneback_polynomial_expansion_sigma,
+        0);
+
+    gst_cuda_of_batch_features(
+        flow.ptr<gfloat>(),
+        flow.step,
+        (guint)width,
+        (guint)height,
+        slot_rows,
+        slots,
+        self->features_matrix_width,
+        self->features_matrix_height,
+        self->magnitude_quadrant_threshold_squared,
+        features.data());
+
+    for(guint idx = 0; idx < batch->len; idx++)
+    {
+        auto *stream
+            = static_cast<GstCudaOfBatchStream *>(g_ptr_array_index(batch, idx));
+
+        if(stream->has_prev)
+        {
+            stream->buffer = gst_buffer_make_writable(stream->buffer);
+
+            gst_cuda_of_batch_attach_features(
+                self,
+                stream->buffer,
+                features.data() + features_per_slot * stream->slot);
+        }
+
+        stream->has_prev = TRUE;
+    }
+}
+
+static void gst_cuda_of_batch_process_cuda(GstCudaOfBatch *self, GPtrArray *batch)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    const guint slots = self_private->slots;
+    const guint slot_rows = self_private->slot_rows;
+    const gint width = self_private->width;
+    const gint height = self_private->height;
+    const gsize features_per_slot
+        = (gsize)self->features_matrix_width * self->features_matrix_height;
+    const gint rows = (gint)(slots * slot_rows);
+
+    std::vector<GstMapInfo> map_infos(batch->len);
+    std::vector<GstMemory *> memories(batch->len, nullptr);
+    std::vector<gfloat> host_features(features_per_slot * slots);
+
+    if(!gst_cuda_context_push(self_private->context))
+    {
+        throw GstCudaException("Could not push CUDA context.");
+    }
+
+    try
+    {
+        cv::cuda::Stream &cuda_stream = *(self_private->cuda_stream);
+
+        if(self_private->current_stack == nullptr)
+        {
+            self_private->current_stack = new cv::cuda::GpuMat();
+            self_private->prev_stack = new cv::cuda::GpuMat();
+            self_private->features = new cv::cuda::GpuMat();
+        }
+
+        if(self_private->current_stack->rows != rows
+           || self_private->current_stack->cols != width)
+        {
+            self_private->current_stack->create(rows, width, CV_8UC1);
+            self_private->prev_stack->create(rows, width, CV_8UC1);
+            self_private->current_stack->setTo(cv::Scalar::all(0), cuda_stream);
+            self_private->prev_stack->setTo(cv::Scalar::all(0), cuda_stream);
+        }
+
+        self_private->features->create(
+            1, (gint)(features_per_slot * slots), CV_32FC1);
+
+        /*
+         * The copies of the individual frames are the only per-stream
+         * operations left. They are queued on the same stream as the
+         * calculation, so nothing waits on them.
+         */
+        for(guint idx = 0; idx < batch->len; idx++)
+        {
+            auto *stream = static_cast<GstCudaOfBatchStream *>(
+                g_ptr_array_index(batch, idx));
+            GstMemory *memory = gst_buffer_peek_memory(stream->buffer, 0);
+            cv::Range slot_range(
+                (gint)(stream->slot * slot_rows),
+                (gint)(stream->slot * slot_rows) + height);
+            cv::cuda::GpuMat current_slot
+                = self_private->current_stack->rowRange(slot_range);
+
+            if(!gst_is_cuda_memory(memory)
+               || !gst_memory_map(
+                   memory, &map_infos[idx], (GstMapFlags)(GST_MAP_READ | GST_MAP_CUDA)))
+            {
+                throw GstCudaException(
+                    "Could not map the CUDA memory of a stream.");
+            }
+
+            memories[idx] = memory;
+
+            if(stream->has_prev)
+            {
+                current_slot.copyTo(
+                    self_private->prev_stack->rowRange(slot_range), cuda_stream);
+            }
+
+            cv::cuda::GpuMat(
+                height,
+                width,
+                CV_8UC1,
+                map_infos[idx].data,
+                GST_CUDA_MEMORY_CAST(memory)->stride)
+                .copyTo(current_slot, cuda_stream);
+        }
+
+        /*
+         * A new matrix is allocated for every batch, as the metadata of the
+         * previous batch may still be referencing the previous one.
+         */
+        cv::cuda::GpuMat flow(rows, width, CV_32FC2);
+
+        (*(self_private->farneback))
+            ->calc(
+                *(self_private->prev_stack),
+                *(self_private->current_stack),
+                flow,
+                cuda_stream);
+
+        CUDA2DPitchedArray gpu_flow
+            = {flow.data,
+               flow.step,
+               flow.cols * flow.elemSize(),
+               (gsize)flow.rows,
+               flow.elemSize()};
+        FrameDimensions frame_dimensions = {(size_t)width, (size_t)height};
+        guint32 features_matrix_width = self->features_matrix_width;
+        guint32 features_matrix_height = self->features_matrix_height;
+        gfloat threshold = self->magnitude_quadrant_threshold_squared;
+        CUdeviceptr features_ptr = (CUdeviceptr)self_private->features->data;
+
+        gpointer feature_kernel_args[]
+            = {&gpu_flow,
+               &frame_dimensions,
+               (gpointer)(&slot_rows),
+               &features_matrix_width,
+               &features_matrix_height,
+               &threshold,
+               &features_ptr};
+
+        if(!gst_cuda_result(CuLaunchKernel(
+               self_private->feature_kernel,
+               features_matrix_width,
+               features_matrix_height,
+               slots,
+               cuda_feature_kernel_block_dimension,
+               cuda_feature_kernel_block_dimension,
+               1,
+               0,
+               (CUstream)cv::cuda::StreamAccessor::getStream(cuda_stream),
+               feature_kernel_args,
+               NULL)))
+        {
+            throw GstCudaException("Could not launch batched feature CUDA kernel.");
+        }
+
+        cv::Mat host_features_mat(
+            1, (gint)host_features.size(), CV_32FC1, host_features.data());
+        self_private->features->download(host_features_mat, cuda_stream);
+
+        cuda_stream.waitForCompletion();
+
+        for(guint idx = 0; idx < batch->len; idx++)
+        {
+            gst_memory_unmap(memories[idx], &map_infos[idx]);
+            memories[idx] = nullptr;
+        }
+
+        for(guint idx = 0; idx < batch->len; idx++)
+        {
+            auto *stream = static_cast<GstCudaOfBatchStream *>(
+                g_ptr_array_index(batch, idx));
+
+            if(stream->has_prev)
+            {
+                stream->buffer = gst_buffer_make_writable(stream->buffer);
+
+                GstMetaOpticalFlow *optical_flow_meta
+                    = GST_META_OPTICAL_FLOW_ADD(stream->buffer);
+                optical_flow_meta->optical_flow_vectors = new cv::cuda::GpuMat(
+                    flow.rowRange(
+                        (gint)(stream->slot * slot_rows),
+                        (gint)(stream->slot * slot_rows) + height));
+                optical_flow_meta->context = GST_CUDA_CONTEXT(
+                    gst_object_ref(self_private->context));
+                optical_flow_meta->optical_flow_vector_grid_size = 1;
+                optical_flow_meta->synthetic = FALSE;
+
+                gst_cuda_of_batch_attach_features(
+                    self,
+                    stream->buffer,
+                    host_features.data() + features_per_slot * stream->slot);
+            }
+
+            stream->has_prev = TRUE;
+        }
+    }
+    catch(...)
+    {
+        for(guint idx = 0; idx < batch->len; idx++)
+        {
+            if(memories[idx] != nullptr)
+            {
+                gst_memory_unmap(memories[idx], &map_infos[idx]);
+            }
+        }
+
+        gst_cuda_context_pop(NULL);
+        throw;
+    }
+
+    gst_cuda_context_pop(NULL);
+}
+
+static gboolean
+gst_cuda_of_batch_query(GstPad *pad, GstObject *parent, GstQuery *query)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(parent);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    auto *stream
+        = static_cast<GstCudaOfBatchStream *>(gst_pad_get_element_private(pad));
+
+    switch(GST_QUERY_TYPE(query))
+    {
+        case GST_QUERY_CONTEXT:
+            if(gst_cuda_handle_context_query(
+                   GST_ELEMENT(self), query, self_private->context))
+            {
+                return TRUE;
+            }
+            break;
+        case GST_QUERY_CAPS:
+            if(GST_PAD_IS_SINK(pad) && stream != NULL)
+            {
+                GstCaps *backend_caps = gst_cuda_of_batch_get_backend_caps(self);
+                GstCaps *filter = NULL;
+                GstCaps *peer_caps = NULL;
+                GstCaps *result = NULL;
+
+                gst_query_parse_caps(query, &filter);
+
+                if(filter != NULL)
+                {
+                    GstCaps *filtered = gst_caps_intersect_full(
+                        filter, backend_caps, GST_CAPS_INTERSECT_FIRST);
+                    gst_caps_unref(backend_caps);
+                    backend_caps = filtered;
+                }
+
+                peer_caps = gst_pad_peer_query_caps(stream->srcpad, backend_caps);
+                result = gst_caps_intersect_full(
+                    peer_caps, backend_caps, GST_CAPS_INTERSECT_FIRST);
+
+                gst_query_set_caps_result(query, result);
+
+                gst_caps_unref(result);
+                gst_caps_unref(peer_caps);
+                gst_caps_unref(backend_caps);
+                return TRUE;
+            }
+            break;
+        case GST_QUERY_ACCEPT_CAPS:
+            if(GST_PAD_IS_SINK(pad))
+            {
+                GstCaps *backend_caps = gst_cuda_of_batch_get_backend_caps(self);
+                GstCaps *caps = NULL;
+
+                gst_query_parse_accept_caps(query, &caps);
+                gst_query_set_accept_caps_result(
+                    query, gst_caps_is_subset(caps, backend_caps));
+
+                gst_caps_unref(backend_caps);
+                return TRUE;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return gst_pad_query_default(pad, parent, query);
+}
+
+static void gst_cuda_of_batch_release_pad(GstElement *element, GstPad *pad)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(element);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    auto *stream
+        = static_cast<GstCudaOfBatchStream *>(gst_pad_get_element_private(pad));
+
+    if(stream == NULL)
+    {
+        return;
+    }
+
+    /*
+     * The streaming thread of the stream has to leave the chain function
+     * before the stream can be freed, so the pad is deactivated first.
+     */
+    g_mutex_lock(&self_private->lock);
+    stream->flushing = TRUE;
+    g_cond_broadcast(&self_private->cond);
+    g_mutex_unlock(&self_private->lock);
+
+    gst_pad_set_active(stream->sinkpad, FALSE);
+    gst_pad_set_active(stream->srcpad, FALSE);
+
+    g_mutex_lock(&self_private->lock);
+    g_ptr_array_remove(self_private->streams, stream);
+    g_cond_broadcast(&self_private->cond);
+    g_mutex_unlock(&self_private->lock);
+
+    gst_pad_set_element_private(stream->sinkpad, NULL);
+    gst_pad_set_element_private(stream->srcpad, NULL);
+
+    if(GST_OBJECT_PARENT(stream->srcpad) == GST_OBJECT_CAST(element))
+    {
+        gst_element_remove_pad(element, stream->srcpad);
+    }
+
+    gst_element_remove_pad(element, stream->sinkpad);
+
+    g_free(stream);
+}
+
+static GstPad *gst_cuda_of_batch_request_new_pad(
+    GstElement *element,
+    GstPadTemplate *templ,
+    const gchar *name,
+    const GstCaps *caps)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(element);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    GstCudaOfBatchStream *stream = NULL;
+    guint slot = 0;
+    gchar *src_name = NULL;
+    gchar *sink_name = NULL;
+
+    g_mutex_lock(&self_private->lock);
+
+    if(name != NULL && sscanf(name, "sink_%u", &slot) == 1)
+    {
+        for(guint idx = 0; idx < self_private->streams->len; idx++)
+        {
+            auto *other = static_cast<GstCudaOfBatchStream *>(
+                g_ptr_array_index(self_private->streams, idx));
+
+            if(other->slot == slot)
+            {
+                g_mutex_unlock(&self_private->lock);
+                GST_ERROR_OBJECT(self, "The pad %s already exists", name);
+                return NULL;
+            }
+        }
+    }
+    else
+    {
+        /*
+         * The lowest free slot keeps the stacked matrices as small as the
+         * number of streams allows.
+         */
+        for(slot = 0;; slot++)
+        {
+            gboolean taken = FALSE;
+
+            for(guint idx = 0; idx < self_private->streams->len; idx++)
+            {
+                auto *other = static_cast<GstCudaOfBatchStream *>(
+                    g_ptr_array_index(self_private->streams, idx));
+                taken |= other->slot == slot;
+            }
+
+            if(!taken)
+            {
+                break;
+            }
+        }
+    }
+
+    stream = g_new0(GstCudaOfBatchStream, 1);
+    stream->slot = slot;
+    stream->flow_return = GST_FLOW_OK;
+
+    sink_name = g_strdup_printf("sink_%u", slot);
+    src_name = g_strdup_printf("src_%u", slot);
+
+    stream->sinkpad = gst_pad_new_from_template(templ, sink_name);
+    stream->srcpad = gst_pad_new_from_static_template(
+        &gst_cuda_of_batch_src_template, src_name);
+
+    g_free(sink_name);
+    g_free(src_name);
+
+    g_ptr_array_add(self_private->streams, stream);
+
+    g_mutex_unlock(&self_private->lock);
+
+    gst_pad_set_element_private(stream->sinkpad, stream);
+    gst_pad_set_element_private(stream->srcpad, stream);
+
+    gst_pad_set_chain_function(
+        stream->sinkpad, GST_DEBUG_FUNCPTR(gst_cuda_of_batch_sink_chain));
+    gst_pad_set_event_function(
+        stream->sinkpad, GST_DEBUG_FUNCPTR(gst_cuda_of_batch_sink_event));
+    gst_pad_set_query_function(
+        stream->sinkpad, GST_DEBUG_FUNCPTR(gst_cuda_of_batch_query));
+    gst_pad_set_iterate_internal_links_function(
+        stream->sinkpad,
+        GST_DEBUG_FUNCPTR(gst_cuda_of_batch_iterate_internal_links));
+    GST_PAD_SET_PROXY_ALLOCATION(stream->sinkpad);
+
+    gst_pad_set_query_function(
+        stream->srcpad, GST_DEBUG_FUNCPTR(gst_cuda_of_batch_query));
+    gst_pad_set_iterate_internal_links_function(
+        stream->srcpad,
+        GST_DEBUG_FUNCPTR(gst_cuda_of_batch_iterate_internal_links));
+    GST_PAD_SET_PROXY_CAPS(stream->srcpad);
+    gst_pad_use_fixed_caps(stream->srcpad);
+
+    if(GST_STATE(element) > GST_STATE_READY)
+    {
+        gst_pad_set_active(stream->srcpad, TRUE);
+        gst_pad_set_active(stream->sinkpad, TRUE);
+    }
+
+    /*
+     * The sink pad is added first, so that the element releases it before
+     * removing the source pad when it is disposed.
+     */
+    gst_element_add_pad(element, stream->sinkpad);
+    gst_element_add_pad(element, stream->srcpad);
+
+    return stream->sinkpad;
+}
+
+static void gst_cuda_of_batch_set_context(GstElement *element, GstContext *context)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(element);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+
+    gst_cuda_handle_set_context(
+        element, context, self->device_id, &self_private->context);
+
+    GST_ELEMENT_CLASS(parent_class)->set_context(element, context);
+}
+
+static void gst_cuda_of_batch_set_property(
+    GObject *gobject,
+    guint prop_id,
+    const GValue *value,
+    GParamSpec *pspec)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(gobject);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+
+    switch(prop_id)
+    {
+        case PROP_BACKEND:
+            self->backend = g_value_get_enum(value);
+            break;
+        case PROP_DEVICE_ID:
+            self->device_id = g_value_get_int(value);
+            break;
+        case PROP_FARNEBACK_NUMBER_OF_LEVELS:
+            self->farneback_number_of_levels = g_value_get_int(value);
+            break;
+        case PROP_FARNEBACK_WINDOW_SIZE:
+            self->farneback_window_size = g_value_get_int(value);
+            break;
+        case PROP_FEATURES_MATRIX_HEIGHT:
+            self->features_matrix_height = g_value_get_uint(value);
+            break;
+        case PROP_FEATURES_MATRIX_WIDTH:
+            self->features_matrix_width = g_value_get_uint(value);
+            break;
+        case PROP_KERNEL_SOURCE_LOCATION:
+            if(g_strcmp0(self->kernel_source_location, g_value_get_string(value)))
+            {
+                g_free(self->kernel_source_location);
+                self->kernel_source_location = g_strdup(g_value_get_string(value));
+            }
+            break;
+        case PROP_MAGNITUDE_QUADRANT_THRESHOLD_SQUARED:
+            self->magnitude_quadrant_threshold_squared = g_value_get_float(value);
+            break;
+        case PROP_TIMEOUT:
+            /*
+             * The waiting streaming threads are woken up, so a shorter timeout
+             * takes effect for the batch that is currently being collected.
+             */
+            GST_OBJECT_LOCK(self);
+            self->timeout = g_value_get_uint64(value);
+            GST_OBJECT_UNLOCK(self);
+
+            g_mutex_lock(&self_private->lock);
+            g_cond_broadcast(&self_private->cond);
+            g_mutex_unlock(&self_private->lock);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(gobject, prop_id, pspec);
+            break;
+    }
+}
+
+static GstFlowReturn
+gst_cuda_of_batch_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(parent);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    auto *stream
+        = static_cast<GstCudaOfBatchStream *>(gst_pad_get_element_private(pad));
+    GstFlowReturn result = GST_FLOW_OK;
+    guint64 timeout;
+
+    GST_OBJECT_LOCK(self);
+    timeout = self->timeout;
+    GST_OBJECT_UNLOCK(self);
+
+    g_mutex_lock(&self_private->lock);
+
+    if(stream->flushing)
+    {
+        g_mutex_unlock(&self_private->lock);
+        gst_buffer_unref(buffer);
+        return GST_FLOW_FLUSHING;
+    }
+
+    if(!stream->has_info)
+    {
+        g_mutex_unlock(&self_private->lock);
+        gst_buffer_unref(buffer);
+        GST_ELEMENT_ERROR(
+            self, CORE, NEGOTIATION, (NULL), ("No caps on %s", GST_PAD_NAME(pad)));
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    stream->buffer = buffer;
+    stream->done = FALSE;
+
+    if(self_private->deadline == 0)
+    {
+        self_private->deadline
+            = g_get_monotonic_time() + (gint64)(timeout / GST_USECOND);
+    }
+
+    g_cond_broadcast(&self_private->cond);
+
+    while(!stream->done)
+    {
+        /*
+         * A buffer that is already part of a batch is processed regardless, and
+         * dropped below once it has been.
+         */
+        if(stream->flushing && !stream->in_batch)
+        {
+            gst_buffer_unref(stream->buffer);
+            stream->buffer = NULL;
+            stream->done = TRUE;
+            stream->flow_return = GST_FLOW_FLUSHING;
+            break;
+        }
+
+        if(gst_cuda_of_batch_is_ready(self))
+        {
+            gst_cuda_of_batch_collect(self);
+            continue;
+        }
+
+        GST_OBJECT_LOCK(self);
+        timeout = self->timeout;
+        GST_OBJECT_UNLOCK(self);
+
+        if(timeout > 0 && self_private->deadline != 0)
+        {
+            g_cond_wait_until(
+                &self_private->cond, &self_private->lock, self_private->deadline);
+        }
+        else
+        {
+            g_cond_wait(&self_private->cond, &self_private->lock);
+        }
+    }
+
+    GstBuffer *output = stream->output;
+
+    result = stream->flow_return;
+    stream->output = NULL;
+    stream->done = FALSE;
+
+    if(output != NULL && stream->flushing)
+    {
+        gst_buffer_unref(output);
+        output = NULL;
+        result = GST_FLOW_FLUSHING;
+    }
+
+    g_mutex_unlock(&self_private->lock);
+
+    /*
+     * The lock is not held while pushing, so that the other streams keep
+     * being batched however long downstream of this stream takes.
+     */
+    if(output != NULL)
+    {
+        result = gst_pad_push(stream->srcpad, output);
+    }
+
+    return result;
+}
+
+static gboolean
+gst_cuda_of_batch_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    GstCudaOfBatch *self = GST_CUDA_OF_BATCH(parent);
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    auto *stream
+        = static_cast<GstCudaOfBatchStream *>(gst_pad_get_element_private(pad));
+
+    switch(GST_EVENT_TYPE(event))
+    {
+        case GST_EVENT_CAPS:
+            {
+                GstCaps *caps = NULL;
+                GstVideoInfo info;
+
+                gst_event_parse_caps(event, &caps);
+
+                if(!gst_video_info_from_caps(&info, caps))
+                {
+                    gst_event_unref(event);
+                    return FALSE;
+                }
+
+                g_mutex_lock(&self_private->lock);
+
+                gboolean has_geometry = FALSE;
+
+                for(guint idx = 0; idx < self_private->streams->len; idx++)
+                {
+                    auto *other = static_cast<GstCudaOfBatchStream *>(
+                        g_ptr_array_index(self_private->streams, idx));
+                    has_geometry |= other != stream && other->has_info;
+                }
+
+                /*
+                 * Every frame occupies a slot of the same size in the stacked
+                 * matrices, so all streams have to agree on the dimensions.
+                 */
+                if(has_geometry
+                   && (GST_VIDEO_INFO_WIDTH(&info) != self_private->width
+                       || GST_VIDEO_INFO_HEIGHT(&info) != self_private->height))
+                {
+                    g_mutex_unlock(&self_private->lock);
+                    GST_ELEMENT_ERROR(
+                        self,
+                        STREAM,
+                        FORMAT,
+                        (NULL),
+                        ("%s has %dx%d frames, the other streams have %dx%d "
+                         "frames",
+                         GST_PAD_NAME(pad),
+                         GST_VIDEO_INFO_WIDTH(&info),
+                         GST_VIDEO_INFO_HEIGHT(&info),
+                         self_private->width,
+                         self_private->height));
+                    gst_event_unref(event);
+                    return FALSE;
+                }
+
+                if(GST_VIDEO_INFO_WIDTH(&info) != self_private->width
+                   || GST_VIDEO_INFO_HEIGHT(&info) != self_private->height)
+                {
+                    self_private->width = GST_VIDEO_INFO_WIDTH(&info);
+                    self_private->height = GST_VIDEO_INFO_HEIGHT(&info);
+                    self_private->slot_rows = gst_cuda_of_batch_slot_rows(
+                        (guint)self_private->height,
+                        (guint)self->farneback_window_size,
+                        (guint)self->farneback_number_of_levels);
+                }
+
+                stream->info = info;
+                stream->has_info = TRUE;
+                stream->has_prev = FALSE;
+
+                g_mutex_unlock(&self_private->lock);
+            }
+            break;
+        case GST_EVENT_EOS:
+            g_mutex_lock(&self_private->lock);
+            stream->eos = TRUE;
+            g_cond_broadcast(&self_private->cond);
+            g_mutex_unlock(&self_private->lock);
+            break;
+        case GST_EVENT_FLUSH_START:
+            g_mutex_lock(&self_private->lock);
+            stream->flushing = TRUE;
+            g_cond_broadcast(&self_private->cond);
+            g_mutex_unlock(&self_private->lock);
+            break;
+        case GST_EVENT_FLUSH_STOP:
+            g_mutex_lock(&self_private->lock);
+            stream->eos = FALSE;
+            stream->flushing = FALSE;
+            stream->has_prev = FALSE;
+            g_mutex_unlock(&self_private->lock);
+            break;
+        case GST_EVENT_STREAM_START:
+            g_mutex_lock(&self_private->lock);
+            stream->eos = FALSE;
+            g_mutex_unlock(&self_private->lock);
+            break;
+        default:
+            break;
+    }
+
+    return gst_pad_push_event(stream->srcpad, event);
+}
+
+static gboolean gst_cuda_of_batch_start(GstCudaOfBatch *self)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+    gboolean result = TRUE;
+
+    self_private->deadline = 0;
+    self_private->processing = FALSE;
+    self_private->slots = 0;
+
+    if(self->backend != BATCH_BACKEND_CUDA)
+    {
+        return TRUE;
+    }
+
+    if(!gst_cuda_load_library() || !gst_nvrtc_load_library())
+    {
+        GST_ELEMENT_ERROR(
+            self,
+            LIBRARY,
+            INIT,
+            ("Could not load the CUDA and NVRTC libraries."),
+            (NULL));
+        return FALSE;
+    }
+
+    if(!gst_cuda_ensure_element_context(
+           GST_ELEMENT(self), self->device_id, &self_private->context))
+    {
+        GST_ELEMENT_ERROR(
+            self, LIBRARY, INIT, ("Could not get a CUDA context."), (NULL));
+        return FALSE;
+    }
+
+    if(!gst_cuda_context_push(self_private->context))
+    {
+        GST_ELEMENT_ERROR(
+            self, LIBRARY, INIT, ("Could not push CUDA context."), (NULL));
+        return FALSE;
+    }
+
+    gchar *ptx = NULL;
+
+    try
+    {
+#ifdef __GNUC__
+#if __GNUC_PREREQ(8, 0)
+        namespace fs = std::filesystem;
+#else
+        namespace fs = std::experimental::filesystem;
+#endif
+#else
+        namespace fs = std::filesystem;
+#endif
+
+        std::ifstream kernel_source_file = std::ifstream(
+            fs::absolute(self->kernel_source_location), std::ios_base::in);
+
+        if(!kernel_source_file.is_open())
+        {
+            throw std::runtime_error(
+                "Could not open the batched feature kernel source file.");
+        }
+
+        std::stringstream kernel_source;
+        kernel_source << kernel_source_file.rdbuf();
+
+        ptx = gst_cuda_nvrtc_compile(kernel_source.str().c_str());
+
+        if(ptx == NULL)
+        {
+            throw GstCudaException(
+                "Could not successfully compile the batched feature kernel "
+                "with NVRTC.");
+        }
+
+        if(!gst_cuda_result(CuModuleLoadData(&self_private->cuda_module, ptx)))
+        {
+            throw GstCudaException(
+                "Could not successfully load the batched feature kernel with "
+                "NVRTC.");
+        }
+
+        if(!gst_cuda_result(CuModuleGetFunction(
+               &self_private->feature_kernel,
+               self_private->cuda_module,
+               GST_CUDA_OF_BATCH_FEATURE_KERNEL)))
+        {
+            throw GstCudaException(
+                "Could not successfully load the batched feature kernel from "
+                "NVRTC module.");
+        }
+
+        self_private->cuda_stream = new cv::cuda::Stream();
+        self_private->farneback = new cv::Ptr<cv::cuda::FarnebackOpticalFlow>(
+            cv::cuda::FarnebackOpticalFlow::create(
+                self->farneback_number_of_levels,
+                farneback_pyramid_scale,
+                false,
+                self->farneback_window_size,
+                farneback_number_of_iterations,
+                farneback_polynomial_expansion_n,
+                farneback_polynomial_expansion_sigma,
+                0));
+    }
+    catch(std::exception &ex)
+    {
+        GST_ELEMENT_ERROR(self, LIBRARY, INIT, ("%s", ex.what()), (NULL));
+        result = FALSE;
+    }
+
+    g_free(ptx);
+
+    gst_cuda_context_pop(NULL);
+
+    return result;
+}
+
+static void gst_cuda_of_batch_stop(GstCudaOfBatch *self)
+{
+    GstCudaOfBatchPrivate *self_private
+        = gst_cuda_of_batch_get_instance_private_typesafe(self);
+
+    delete self_private->host_current_stack;
+    self_private->host_current_stack = nullptr;
+    delete self_private->host_prev_stack;
+    self_private->host_prev_stack = nullptr;
+
+    if(self_private->context != NULL
+       && gst_cuda_context_push(self_private->context))
+    {
+        delete self_private->current_stack;
+        self_private->current_stack = nullptr;
+        delete self_private->prev_stack;
+        self_private->prev_stack = nullptr;
+        delete self_private->features;
+        self_private->features = nullptr;
+        delete self_private->farneback;
+        self_private->farneback = nullptr;
+        delete self_private->cuda_stream;
+        self_private->cuda_stream = nullptr;
+
+        self_private->feature_kernel = NULL;
+
+        if(self_private->cuda_module != NULL)
+        {
+            gst_cuda_result(CuModuleUnload(self_private->cuda_module));
+            self_private->cuda_module = NULL;
+        }
+
+        gst_cuda_context_pop(NULL);
+    }
+
+    if(self_private->features_pool != NULL)
+    {
+        gst_algorithm_features_pool_unref(self_private->features_pool);
+        self_private->features_pool = NULL;
+    }
+
+    gst_clear_object(&self_private->context);
+}
+
+/******************************************************************************/
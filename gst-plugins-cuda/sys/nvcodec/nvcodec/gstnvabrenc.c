@@ -0,0 +1,1200 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-nvh264abrenc
+ * @title: nvh264abrenc
+ *
+ * Encodes a single CUDA memory input into an adaptive bitrate ladder of
+ * H.264 renditions, one per source pad. The input is scaled into all the
+ * renditions by a single kernel launch, into input pictures which stay
+ * registered with one NVENC session per rendition, so no rendition copies
+ * the input on its own.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 filesrc location=in.mp4 ! parsebin ! nvh264dec ! \
+ *     nvh264abrenc name=abr renditions="1280x720:3000,640x360:800" \
+ *     abr.src_0 ! h264parse ! mp4mux ! filesink location=720p.mp4 \
+ *     abr.src_1 ! h264parse ! mp4mux ! filesink location=360p.mp4
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstnvabrenc.h"
+
+#include <string.h>
+
+#include <gst/cuda/nvcodec/gstcudamemory.h>
+#include <gst/cuda/nvcodec/gstcudanvrtc.h>
+#include <gst/cuda/nvcodec/gstcudautils.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_nv_abr_enc_debug);
+#define GST_CAT_DEFAULT gst_nv_abr_enc_debug
+
+typedef struct
+{
+  GstCaps *src_caps;
+  guint cuda_device_id;
+  gboolean is_default;
+} GstNvAbrEncClassData;
+
+/* the encode session of a rendition, see GstCudaAbrSessionFuncs */
+typedef struct
+{
+  GstNvAbrEnc *self;
+  guint index;
+  guint width;
+  guint height;
+  gpointer encoder;
+  guint32 frame_idx;
+
+  /* per input slot */
+  NV_ENC_REGISTERED_PTR *registered;
+  NV_ENC_INPUT_PTR *mapped;
+  NV_ENC_OUTPUT_PTR *bitstream;
+  GstClockTime *input_pts;
+} GstNvAbrEncSession;
+
+static GstElementClass *parent_class = NULL;
+
+enum
+{
+  PROP_0,
+  PROP_RENDITIONS,
+  PROP_GOP_SIZE,
+  PROP_BFRAMES,
+};
+
+#define DEFAULT_RENDITIONS "1280x720:3000,640x360:800"
+#define DEFAULT_GOP_SIZE 60
+#define DEFAULT_BFRAMES 0
+
+#define CUDA_BLOCK_X 16
+#define CUDA_BLOCK_Y 16
+#define DIV_UP(size,block) (((size) + ((block) - 1)) / (block))
+
+/* matches the alignment CuMemAllocPitch() picks for encoder input */
+#define INPUT_PITCH_ALIGN 256
+
+#define SCALE_KERNEL_FUNC "gst_nv_abr_enc_scale"
+
+/* must match the layout of struct Rendition in the kernel */
+typedef struct
+{
+  gint width;
+  gint height;
+  gint pitch;
+  gfloat scale_x;
+  gfloat scale_y;
+  guint64 luma_offset;
+  guint64 chroma_offset;
+} GstNvAbrEncKernelRendition;
+
+typedef struct
+{
+  GstNvAbrEncKernelRendition renditions[GST_CUDA_ABR_LADDER_MAX_RENDITIONS];
+} GstNvAbrEncKernelLadder;
+
+/* *INDENT-OFF* */
+/* One thread per luma pixel of every rendition, blockIdx.z selects the
+ * rendition. The threads of even pixels also write the chroma sample */
+static const gchar scale_kernel_source[] =
+"extern \"C\" {\n"
+"struct Rendition\n"
+"{\n"
+"  int width;\n"
+"  int height;\n"
+"  int pitch;\n"
+"  float scale_x;\n"
+"  float scale_y;\n"
+"  unsigned long long luma_offset;\n"
+"  unsigned long long chroma_offset;\n"
+"};\n"
+"\n"
+"struct Ladder\n"
+"{\n"
+"  Rendition renditions[" G_STRINGIFY (GST_CUDA_ABR_LADDER_MAX_RENDITIONS) "];\n"
+"};\n"
+"\n"
+"__device__ float\n"
+"sample (const unsigned char *plane, int pitch, int width, int height,\n"
+"    int pstride, float x, float y)\n"
+"{\n"
+"  int x0, y0, x1, y1;\n"
+"  float fx, fy, top, bottom;\n"
+"  x = fminf (fmaxf (x, 0.0f), width - 1.0f);\n"
+"  y = fminf (fmaxf (y, 0.0f), height - 1.0f);\n"
+"  x0 = (int) x;\n"
+"  y0 = (int) y;\n"
+"  x1 = min (x0 + 1, width - 1);\n"
+"  y1 = min (y0 + 1, height - 1);\n"
+"  fx = x - x0;\n"
+"  fy = y - y0;\n"
+"  top = plane[y0 * pitch + x0 * pstride] * (1.0f - fx) +\n"
+"      plane[y0 * pitch + x1 * pstride] * fx;\n"
+"  bottom = plane[y1 * pitch + x0 * pstride] * (1.0f - fx) +\n"
+"      plane[y1 * pitch + x1 * pstride] * fx;\n"
+"  return top * (1.0f - fy) + bottom * fy;\n"
+"}\n"
+"\n"
+"__global__ void\n"
+SCALE_KERNEL_FUNC " (const unsigned char *src_luma,\n"
+"    const unsigned char *src_chroma, int src_pitch, int src_width,\n"
+"    int src_height, unsigned char *dst, Ladder ladder)\n"
+"{\n"
+"  Rendition r = ladder.renditions[blockIdx.z];\n"
+"  int x = blockIdx.x * blockDim.x + threadIdx.x;\n"
+"  int y = blockIdx.y * blockDim.y + threadIdx.y;\n"
+"  if (x >= r.width || y >= r.height)\n"
+"    return;\n"
+"  dst[r.luma_offset + y * r.pitch + x] = (unsigned char) (sample (src_luma,\n"
+"      src_pitch, src_width, src_height, 1, (x + 0.5f) * r.scale_x - 0.5f,\n"
+"      (y + 0.5f) * r.scale_y - 0.5f) + 0.5f);\n"
+"  if ((x & 1) == 0 && (y & 1) == 0) {\n"
+"    float cx = (x / 2 + 0.5f) * r.scale_x - 0.5f;\n"
+"    float cy = (y / 2 + 0.5f) * r.scale_y - 0.5f;\n"
+"    unsigned char *uv = dst + r.chroma_offset + (y / 2) * r.pitch + x;\n"
+"    uv[0] = (unsigned char) (sample (src_chroma, src_pitch, src_width / 2,\n"
+"        src_height / 2, 2, cx, cy) + 0.5f);\n"
+"    uv[1] = (unsigned char) (sample (src_chroma + 1, src_pitch,\n"
+"        src_width / 2, src_height / 2, 2, cx, cy) + 0.5f);\n"
+"  }\n"
+"}\n"
+"}\n";
+/* *INDENT-ON* */
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY, "NV12")));
+
+static void gst_nv_abr_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nv_abr_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_nv_abr_enc_finalize (GObject * object);
+static void gst_nv_abr_enc_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_nv_abr_enc_change_state (GstElement * element,
+    GstStateChange transition);
+static gboolean gst_nv_abr_enc_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+static gboolean gst_nv_abr_enc_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
+static GstFlowReturn gst_nv_abr_enc_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer);
+
+static gpointer gst_nv_abr_enc_session_open (gpointer user_data, guint index,
+    const GstCudaAbrRendition * rendition);
+static GstCudaAbrEncodeStatus gst_nv_abr_enc_session_encode (gpointer session,
+    gint slot, GstClockTime pts, GstClockTime duration);
+static GstBuffer *gst_nv_abr_enc_session_lock_bitstream (gpointer session,
+    gint slot);
+static GstFlowReturn gst_nv_abr_enc_session_push (gpointer user_data,
+    guint index, GstBuffer * buffer);
+static void gst_nv_abr_enc_session_close (gpointer session);
+
+static const GstCudaAbrSessionFuncs session_funcs = {
+  gst_nv_abr_enc_session_open,
+  gst_nv_abr_enc_session_encode,
+  gst_nv_abr_enc_session_lock_bitstream,
+  gst_nv_abr_enc_session_push,
+  gst_nv_abr_enc_session_close,
+};
+
+static void
+gst_nv_abr_enc_class_init (GstNvAbrEncClass * klass, gpointer data)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstNvAbrEncClassData *cdata = (GstNvAbrEncClassData *) data;
+  gchar *long_name;
+
+  parent_class = (GstElementClass *) g_type_class_peek_parent (klass);
+
+  gobject_class->set_property = gst_nv_abr_enc_set_property;
+  gobject_class->get_property = gst_nv_abr_enc_get_property;
+  gobject_class->finalize = gst_nv_abr_enc_finalize;
+
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_nv_abr_enc_set_context);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_nv_abr_enc_change_state);
+
+  /**
+   * GstNvAbrEnc:renditions:
+   *
+   * Comma separated list of WIDTHxHEIGHT:KBPS renditions, encoded by one
+   * NVENC session each and output on the source pad of the same index.
+   * The renditions cannot be larger than the input.
+   */
+  g_object_class_install_property (gobject_class, PROP_RENDITIONS,
+      g_param_spec_string ("renditions", "Renditions",
+          "Comma separated list of WIDTHxHEIGHT:KBPS renditions",
+          DEFAULT_RENDITIONS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GOP_SIZE,
+      g_param_spec_int ("gop-size", "GOP size",
+          "Number of frames between intra frames, aligned across the "
+          "renditions (-1 = infinite)",
+          -1, G_MAXINT, DEFAULT_GOP_SIZE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BFRAMES,
+      g_param_spec_uint ("bframes", "B-Frames",
+          "Number of B-frames between I and P", 0, 4, DEFAULT_BFRAMES,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  if (cdata->is_default)
+    long_name = g_strdup ("NVENC H.264 ABR Ladder Video Encoder");
+  else
+    long_name = g_strdup_printf ("NVENC H.264 ABR Ladder Video Encoder with "
+        "devide-id %d", cdata->cuda_device_id);
+
+  gst_element_class_set_metadata (element_class, long_name,
+      "Codec/Encoder/Video/Hardware",
+      "Encode H.264 adaptive bitrate renditions of a video stream "
+      "using NVENC", "icetana");
+  g_free (long_name);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_pad_template (element_class,
+      gst_pad_template_new ("src_%u", GST_PAD_SRC, GST_PAD_SOMETIMES,
+          cdata->src_caps));
+
+  klass->cuda_device_id = cdata->cuda_device_id;
+
+  gst_caps_unref (cdata->src_caps);
+  g_free (cdata);
+}
+
+static void
+gst_nv_abr_enc_init (GstNvAbrEnc * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_nv_abr_enc_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_nv_abr_enc_sink_event));
+  gst_pad_set_query_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_nv_abr_enc_sink_query));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpads = g_ptr_array_new ();
+  self->renditions = g_strdup (DEFAULT_RENDITIONS);
+  self->gop_size = DEFAULT_GOP_SIZE;
+  self->bframes = DEFAULT_BFRAMES;
+}
+
+static void
+gst_nv_abr_enc_finalize (GObject * object)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) object;
+
+  g_ptr_array_unref (self->srcpads);
+  g_free (self->renditions);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_nv_abr_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) object;
+
+  switch (prop_id) {
+    case PROP_RENDITIONS:
+      g_free (self->renditions);
+      self->renditions = g_value_dup_string (value);
+      break;
+    case PROP_GOP_SIZE:
+      self->gop_size = g_value_get_int (value);
+      break;
+    case PROP_BFRAMES:
+      self->bframes = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_nv_abr_enc_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) object;
+
+  switch (prop_id) {
+    case PROP_RENDITIONS:
+      g_value_set_string (value, self->renditions);
+      break;
+    case PROP_GOP_SIZE:
+      g_value_set_int (value, self->gop_size);
+      break;
+    case PROP_BFRAMES:
+      g_value_set_uint (value, self->bframes);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_nv_abr_enc_set_context (GstElement * element, GstContext * context)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) element;
+  GstNvAbrEncClass *klass = (GstNvAbrEncClass *) G_OBJECT_GET_CLASS (self);
+
+  gst_cuda_handle_set_context (element, context, klass->cuda_device_id,
+      &self->cuda_ctx);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static gboolean
+gst_nv_abr_enc_open (GstNvAbrEnc * self)
+{
+  GstNvAbrEncClass *klass = (GstNvAbrEncClass *) G_OBJECT_GET_CLASS (self);
+  gchar *ptx;
+  gboolean ret = FALSE;
+
+  if (!gst_cuda_ensure_element_context (GST_ELEMENT_CAST (self),
+          klass->cuda_device_id, &self->cuda_ctx)) {
+    GST_ERROR_OBJECT (self, "failed to create CUDA context");
+    return FALSE;
+  }
+
+  ptx = gst_cuda_nvrtc_compile (scale_kernel_source);
+  if (!ptx) {
+    GST_ERROR_OBJECT (self, "could not compile the scale kernel");
+    return FALSE;
+  }
+
+  if (!gst_cuda_context_push (self->cuda_ctx)) {
+    g_free (ptx);
+    return FALSE;
+  }
+
+  if (!gst_cuda_result (CuStreamCreate (&self->cuda_stream,
+              CU_STREAM_DEFAULT))) {
+    GST_WARNING_OBJECT (self,
+        "Could not create cuda stream, will use default stream");
+    self->cuda_stream = NULL;
+  }
+
+  if (!gst_cuda_result (CuModuleLoadData (&self->cuda_module, ptx))) {
+    GST_ERROR_OBJECT (self, "could not load the scale kernel");
+    self->cuda_module = NULL;
+  } else if (!gst_cuda_result (CuModuleGetFunction (&self->scale_func,
+              self->cuda_module, SCALE_KERNEL_FUNC))) {
+    GST_ERROR_OBJECT (self, "could not get the scale kernel");
+  } else {
+    ret = TRUE;
+  }
+
+  gst_cuda_context_pop (NULL);
+  g_free (ptx);
+
+  return ret;
+}
+
+static void
+gst_nv_abr_enc_close (GstNvAbrEnc * self)
+{
+  if (self->cuda_ctx && gst_cuda_context_push (self->cuda_ctx)) {
+    if (self->cuda_module)
+      gst_cuda_result (CuModuleUnload (self->cuda_module));
+    if (self->cuda_stream)
+      gst_cuda_result (CuStreamDestroy (self->cuda_stream));
+    gst_cuda_context_pop (NULL);
+  }
+
+  self->cuda_module = NULL;
+  self->scale_func = NULL;
+  self->cuda_stream = NULL;
+  gst_clear_object (&self->cuda_ctx);
+}
+
+/* frees the encode sessions and the input slots */
+static void
+gst_nv_abr_enc_free_ladder (GstNvAbrEnc * self)
+{
+  guint i;
+
+  g_clear_pointer (&self->ladder, gst_cuda_abr_ladder_free);
+
+  if (self->slots && gst_cuda_context_push (self->cuda_ctx)) {
+    for (i = 0; i < self->n_slots; i++) {
+      if (self->slots[i])
+        gst_cuda_result (CuMemFree (self->slots[i]));
+    }
+    gst_cuda_context_pop (NULL);
+  }
+
+  g_clear_pointer (&self->slots, g_free);
+  self->n_slots = 0;
+  g_clear_pointer (&self->rendition_array, g_array_unref);
+}
+
+static void
+gst_nv_abr_enc_reset (GstNvAbrEnc * self)
+{
+  guint i;
+
+  gst_nv_abr_enc_free_ladder (self);
+
+  for (i = 0; i < self->srcpads->len; i++) {
+    gst_element_remove_pad (GST_ELEMENT (self),
+        g_ptr_array_index (self->srcpads, i));
+  }
+  g_ptr_array_set_size (self->srcpads, 0);
+}
+
+static GstStateChangeReturn
+gst_nv_abr_enc_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) element;
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_nv_abr_enc_open (self)) {
+        gst_nv_abr_enc_close (self);
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_nv_abr_enc_reset (self);
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_nv_abr_enc_close (self);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_nv_abr_enc_session_free (GstNvAbrEncSession * session)
+{
+  GstNvAbrEnc *self = session->self;
+  guint i;
+
+  gst_cuda_context_push (self->cuda_ctx);
+  for (i = 0; i < self->n_slots; i++) {
+    if (session->mapped[i])
+      NvEncUnmapInputResource (session->encoder, session->mapped[i]);
+    if (session->registered[i])
+      NvEncUnregisterResource (session->encoder, session->registered[i]);
+    if (session->bitstream[i])
+      NvEncDestroyBitstreamBuffer (session->encoder, session->bitstream[i]);
+  }
+  if (session->encoder)
+    NvEncDestroyEncoder (session->encoder);
+  gst_cuda_context_pop (NULL);
+
+  g_free (session->registered);
+  g_free (session->mapped);
+  g_free (session->bitstream);
+  g_free (session->input_pts);
+  g_free (session);
+}
+
+static gboolean
+gst_nv_abr_enc_session_init (GstNvAbrEncSession * session,
+    const GstCudaAbrRendition * rendition)
+{
+  GstNvAbrEnc *self = session->self;
+  GstVideoInfo *info = &self->in_info;
+  NV_ENC_OPEN_ENCODE_SESSION_EX_PARAMS open_params = { 0, };
+  NV_ENC_INITIALIZE_PARAMS params = { 0, };
+  NV_ENC_PRESET_CONFIG preset_config = { 0, };
+  NV_ENC_CONFIG *config = &preset_config.presetCfg;
+  NVENCSTATUS nv_ret;
+  guint i;
+
+  open_params.version = gst_nvenc_get_open_encode_session_ex_params_version ();
+  open_params.apiVersion = gst_nvenc_get_api_version ();
+  open_params.device = gst_cuda_context_get_handle (self->cuda_ctx);
+  open_params.deviceType = NV_ENC_DEVICE_TYPE_CUDA;
+
+  nv_ret = NvEncOpenEncodeSessionEx (&open_params, &session->encoder);
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_ERROR_OBJECT (self, "Failed to open encode session %u: %d",
+        session->index, nv_ret);
+    session->encoder = NULL;
+    return FALSE;
+  }
+
+  preset_config.version = gst_nvenc_get_preset_config_version ();
+  preset_config.presetCfg.version = gst_nvenc_get_config_version ();
+
+  nv_ret = NvEncGetEncodePresetConfig (session->encoder,
+      NV_ENC_CODEC_H264_GUID, NV_ENC_PRESET_DEFAULT_GUID, &preset_config);
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_ERROR_OBJECT (self, "Failed to get encode preset configuration: %d",
+        nv_ret);
+    return FALSE;
+  }
+
+  params.version = gst_nvenc_get_initialize_params_version ();
+  params.encodeGUID = NV_ENC_CODEC_H264_GUID;
+  params.presetGUID = NV_ENC_PRESET_DEFAULT_GUID;
+  params.encodeWidth = params.maxEncodeWidth = rendition->width;
+  params.encodeHeight = params.maxEncodeHeight = rendition->height;
+  params.darWidth = rendition->width;
+  params.darHeight = rendition->height;
+  params.enablePTD = 1;
+  params.encodeConfig = config;
+
+  if (info->fps_n > 0 && info->fps_d > 0) {
+    params.frameRateNum = info->fps_n;
+    params.frameRateDen = info->fps_d;
+  } else {
+    params.frameRateNum = 0;
+    params.frameRateDen = 1;
+  }
+
+  /* the same GOP structure in every rendition, so that players can switch
+   * between them at any IDR */
+  if (self->gop_size < 0) {
+    config->gopLength = NVENC_INFINITE_GOPLENGTH;
+    config->frameIntervalP = 1;
+  } else {
+    config->gopLength = MAX (self->gop_size, 1);
+    config->frameIntervalP = self->bframes + 1;
+  }
+
+  config->profileGUID = NV_ENC_H264_PROFILE_HIGH_GUID;
+  config->rcParams.rateControlMode = NV_ENC_PARAMS_RC_CBR;
+  config->rcParams.averageBitRate = rendition->bitrate * 1024;
+  config->rcParams.maxBitRate = rendition->bitrate * 1024;
+  config->encodeCodecConfig.h264Config.idrPeriod = config->gopLength;
+  config->encodeCodecConfig.h264Config.repeatSPSPPS = 1;
+  config->encodeCodecConfig.h264Config.chromaFormatIDC = 1;
+
+  nv_ret = NvEncInitializeEncoder (session->encoder, &params);
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_ERROR_OBJECT (self, "Failed to init encoder %u: %d", session->index,
+        nv_ret);
+    return FALSE;
+  }
+
+  for (i = 0; i < self->n_slots; i++) {
+    const GstCudaAbrPlaneLayout *layout = &self->layouts[session->index];
+    NV_ENC_REGISTER_RESOURCE resource = { 0, };
+    NV_ENC_CREATE_BITSTREAM_BUFFER bitstream = { 0, };
+
+    /* the chroma plane directly follows the luma plane, as NVENC expects */
+    resource.version = gst_nvenc_get_register_resource_version ();
+    resource.resourceType = NV_ENC_INPUT_RESOURCE_TYPE_CUDADEVICEPTR;
+    resource.width = rendition->width;
+    resource.height = rendition->height;
+    resource.pitch = layout->pitch;
+    resource.bufferFormat = NV_ENC_BUFFER_FORMAT_NV12;
+    resource.resourceToRegister =
+        (gpointer) (self->slots[i] + layout->luma_offset);
+
+    nv_ret = NvEncRegisterResource (session->encoder, &resource);
+    if (nv_ret != NV_ENC_SUCCESS) {
+      GST_ERROR_OBJECT (self, "Failed to register input slot %u: %d", i,
+          nv_ret);
+      return FALSE;
+    }
+    session->registered[i] = resource.registeredResource;
+
+    /* an encoded picture rarely exceeds the size of the raw NV12 picture of
+     * the rendition, 1 MB is kept as the minimum for the small ones */
+    bitstream.version = gst_nvenc_get_create_bitstream_buffer_version ();
+    bitstream.size = MAX (1024 * 1024,
+        GST_ROUND_UP_2 (rendition->width) * GST_ROUND_UP_2 (rendition->height)
+        * 3 / 2);
+    bitstream.memoryHeap = NV_ENC_MEMORY_HEAP_SYSMEM_CACHED;
+
+    nv_ret = NvEncCreateBitstreamBuffer (session->encoder, &bitstream);
+    if (nv_ret != NV_ENC_SUCCESS) {
+      GST_ERROR_OBJECT (self, "Failed to allocate output buffer: %d", nv_ret);
+      return FALSE;
+    }
+    session->bitstream[i] = bitstream.bitstreamBuffer;
+  }
+
+  return TRUE;
+}
+
+static gpointer
+gst_nv_abr_enc_session_open (gpointer user_data, guint index,
+    const GstCudaAbrRendition * rendition)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) user_data;
+  GstNvAbrEncSession *session;
+  gboolean ret;
+
+  session = g_new0 (GstNvAbrEncSession, 1);
+  session->self = self;
+  session->index = index;
+  session->width = rendition->width;
+  session->height = rendition->height;
+  session->registered = g_new0 (NV_ENC_REGISTERED_PTR, self->n_slots);
+  session->mapped = g_new0 (NV_ENC_INPUT_PTR, self->n_slots);
+  session->bitstream = g_new0 (NV_ENC_OUTPUT_PTR, self->n_slots);
+  session->input_pts = g_new0 (GstClockTime, self->n_slots);
+
+  if (!gst_cuda_context_push (self->cuda_ctx)) {
+    gst_nv_abr_enc_session_free (session);
+    return NULL;
+  }
+
+  ret = gst_nv_abr_enc_session_init (session, rendition);
+  gst_cuda_context_pop (NULL);
+
+  if (!ret) {
+    gst_nv_abr_enc_session_free (session);
+    return NULL;
+  }
+
+  GST_INFO_OBJECT (self, "opened session %u for %ux%u at %u kbps", index,
+      rendition->width, rendition->height, rendition->bitrate);
+
+  return session;
+}
+
+static GstCudaAbrEncodeStatus
+gst_nv_abr_enc_session_encode (gpointer user_data, gint slot,
+    GstClockTime pts, GstClockTime duration)
+{
+  GstNvAbrEncSession *session = (GstNvAbrEncSession *) user_data;
+  GstNvAbrEnc *self = session->self;
+  NV_ENC_PIC_PARAMS pic_params = { 0, };
+  NVENCSTATUS nv_ret;
+
+  pic_params.version = gst_nvenc_get_pic_params_version ();
+
+  if (!gst_cuda_context_push (self->cuda_ctx))
+    return GST_CUDA_ABR_ENCODE_ERROR;
+
+  if (slot < 0) {
+    pic_params.encodePicFlags = NV_ENC_PIC_FLAG_EOS;
+  } else {
+    NV_ENC_MAP_INPUT_RESOURCE map = { 0, };
+
+    map.version = gst_nvenc_get_map_input_resource_version ();
+    map.registeredResource = session->registered[slot];
+
+    nv_ret = NvEncMapInputResource (session->encoder, &map);
+    if (nv_ret != NV_ENC_SUCCESS) {
+      gst_cuda_context_pop (NULL);
+      GST_ERROR_OBJECT (self, "Failed to map input slot %d: %d", slot, nv_ret);
+      return GST_CUDA_ABR_ENCODE_ERROR;
+    }
+
+    session->mapped[slot] = map.mappedResource;
+    session->input_pts[slot] = pts;
+
+    pic_params.inputBuffer = map.mappedResource;
+    pic_params.bufferFmt = map.mappedBufferFmt;
+    pic_params.inputWidth = session->width;
+    pic_params.inputHeight = session->height;
+    pic_params.inputPitch = self->layouts[session->index].pitch;
+    pic_params.outputBitstream = session->bitstream[slot];
+    pic_params.pictureStruct = NV_ENC_PIC_STRUCT_FRAME;
+    pic_params.inputTimeStamp = pts;
+    pic_params.inputDuration = GST_CLOCK_TIME_IS_VALID (duration) ?
+        duration : 0;
+    pic_params.frameIdx = session->frame_idx++;
+  }
+
+  nv_ret = NvEncEncodePicture (session->encoder, &pic_params);
+
+  if (nv_ret != NV_ENC_SUCCESS && nv_ret != NV_ENC_ERR_NEED_MORE_INPUT
+      && slot >= 0) {
+    NvEncUnmapInputResource (session->encoder, session->mapped[slot]);
+    session->mapped[slot] = NULL;
+  }
+
+  gst_cuda_context_pop (NULL);
+
+  if (nv_ret == NV_ENC_SUCCESS)
+    return GST_CUDA_ABR_ENCODE_OK;
+  if (nv_ret == NV_ENC_ERR_NEED_MORE_INPUT)
+    return GST_CUDA_ABR_ENCODE_NEED_MORE_INPUT;
+
+  GST_ERROR_OBJECT (self, "Failed to encode picture of rendition %u: %d",
+      session->index, nv_ret);
+
+  return GST_CUDA_ABR_ENCODE_ERROR;
+}
+
+static GstBuffer *
+gst_nv_abr_enc_session_lock_bitstream (gpointer user_data, gint slot)
+{
+  GstNvAbrEncSession *session = (GstNvAbrEncSession *) user_data;
+  GstNvAbrEnc *self = session->self;
+  NV_ENC_LOCK_BITSTREAM lock_bs = { 0, };
+  GstBuffer *buffer = NULL;
+  GstClockTime input_pts;
+  NVENCSTATUS nv_ret;
+
+  lock_bs.version = gst_nvenc_get_lock_bitstream_version ();
+  lock_bs.outputBitstream = session->bitstream[slot];
+
+  if (!gst_cuda_context_push (self->cuda_ctx))
+    return NULL;
+
+  nv_ret = NvEncLockBitstream (session->encoder, &lock_bs);
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_ERROR_OBJECT (self, "Failed to lock bitstream of rendition %u: %d",
+        session->index, nv_ret);
+    goto done;
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, lock_bs.bitstreamSizeInBytes, NULL);
+  gst_buffer_fill (buffer, 0, lock_bs.bitstreamBufferPtr,
+      lock_bs.bitstreamSizeInBytes);
+
+  /* the pictures are output in decoding order, the timestamps of the input
+   * pictures give the decoding timestamps */
+  input_pts = session->input_pts[slot];
+  GST_BUFFER_PTS (buffer) = lock_bs.outputTimeStamp;
+  GST_BUFFER_DURATION (buffer) = lock_bs.outputDuration;
+  if (GST_CLOCK_TIME_IS_VALID (input_pts) && input_pts >= self->dts_offset)
+    GST_BUFFER_DTS (buffer) = input_pts - self->dts_offset;
+
+  if (lock_bs.pictureType != NV_ENC_PIC_TYPE_IDR)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  NvEncUnlockBitstream (session->encoder, session->bitstream[slot]);
+
+done:
+  NvEncUnmapInputResource (session->encoder, session->mapped[slot]);
+  session->mapped[slot] = NULL;
+  gst_cuda_context_pop (NULL);
+
+  return buffer;
+}
+
+static GstFlowReturn
+gst_nv_abr_enc_session_push (gpointer user_data, guint index,
+    GstBuffer * buffer)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) user_data;
+
+  return gst_pad_push (g_ptr_array_index (self->srcpads, index), buffer);
+}
+
+static void
+gst_nv_abr_enc_session_close (gpointer user_data)
+{
+  gst_nv_abr_enc_session_free ((GstNvAbrEncSession *) user_data);
+}
+
+static GstCaps *
+gst_nv_abr_enc_get_src_caps (GstNvAbrEnc * self,
+    const GstCudaAbrRendition * rendition)
+{
+  return gst_caps_new_simple ("video/x-h264",
+      "width", G_TYPE_INT, rendition->width,
+      "height", G_TYPE_INT, rendition->height,
+      "framerate", GST_TYPE_FRACTION, self->in_info.fps_n,
+      self->in_info.fps_d,
+      "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au",
+      "profile", G_TYPE_STRING, "high", NULL);
+}
+
+/* adds the missing source pads, each starting its own stream */
+static void
+gst_nv_abr_enc_ensure_srcpads (GstNvAbrEnc * self)
+{
+  GstElementClass *klass = GST_ELEMENT_GET_CLASS (self);
+  gboolean added = FALSE;
+  guint i;
+
+  for (i = self->srcpads->len; i < self->rendition_array->len; i++) {
+    GstPad *pad;
+    gchar *name;
+    gchar *stream_id;
+
+    name = g_strdup_printf ("src_%u", i);
+    pad = gst_pad_new_from_template (gst_element_class_get_pad_template (klass,
+            "src_%u"), name);
+    g_free (name);
+
+    gst_pad_use_fixed_caps (pad);
+    gst_pad_set_active (pad, TRUE);
+
+    stream_id = gst_pad_create_stream_id_printf (pad, GST_ELEMENT (self),
+        "%u", i);
+    gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    g_ptr_array_add (self->srcpads, pad);
+    gst_element_add_pad (GST_ELEMENT (self), pad);
+    added = TRUE;
+  }
+
+  if (added)
+    gst_element_no_more_pads (GST_ELEMENT (self));
+}
+
+/* opens one encode session per rendition, each starting from an IDR, with
+ * all the input slots free */
+static gboolean
+gst_nv_abr_enc_open_ladder (GstNvAbrEnc * self)
+{
+  self->ladder = gst_cuda_abr_ladder_new (&session_funcs, self,
+      (const GstCudaAbrRendition *) self->rendition_array->data,
+      self->rendition_array->len, self->n_slots);
+  if (!self->ladder) {
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL),
+        ("Failed to open the encode sessions"));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_nv_abr_enc_set_caps (GstNvAbrEnc * self, GstCaps * caps)
+{
+  GstCudaAbrRendition *renditions;
+  GArray *rendition_array;
+  gsize slot_size;
+  guint n_renditions;
+  guint i;
+
+  if (!gst_video_info_from_caps (&self->in_info, caps)) {
+    GST_ERROR_OBJECT (self, "invalid caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  rendition_array = gst_cuda_abr_rendition_parse (self->renditions);
+  if (!rendition_array) {
+    GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS, (NULL),
+        ("Invalid renditions \"%s\"", self->renditions));
+    return FALSE;
+  }
+
+  renditions = (GstCudaAbrRendition *) rendition_array->data;
+  n_renditions = rendition_array->len;
+
+  for (i = 0; i < n_renditions; i++) {
+    if (renditions[i].width > GST_VIDEO_INFO_WIDTH (&self->in_info) ||
+        renditions[i].height > GST_VIDEO_INFO_HEIGHT (&self->in_info)) {
+      GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS, (NULL),
+          ("Rendition %ux%u is larger than the %dx%d input",
+              renditions[i].width, renditions[i].height,
+              GST_VIDEO_INFO_WIDTH (&self->in_info),
+              GST_VIDEO_INFO_HEIGHT (&self->in_info)));
+      g_array_unref (rendition_array);
+      return FALSE;
+    }
+  }
+
+  /* a renegotiation restarts every rendition from an IDR */
+  if (self->ladder)
+    gst_cuda_abr_ladder_drain (self->ladder);
+  gst_nv_abr_enc_free_ladder (self);
+
+  self->rendition_array = rendition_array;
+  slot_size = gst_cuda_abr_rendition_get_layout (renditions, n_renditions,
+      INPUT_PITCH_ALIGN, self->layouts);
+
+  /* a session holds on to up to bframes pictures plus the one being
+   * submitted, one more slot lets the next picture be scaled meanwhile */
+  self->n_slots = self->bframes + 2;
+  self->slots = g_new0 (CUdeviceptr, self->n_slots);
+
+  if (!gst_cuda_context_push (self->cuda_ctx))
+    return FALSE;
+
+  for (i = 0; i < self->n_slots; i++) {
+    if (!gst_cuda_result (CuMemAlloc (&self->slots[i], slot_size))) {
+      gst_cuda_context_pop (NULL);
+      GST_ERROR_OBJECT (self, "Failed to allocate input slot");
+      return FALSE;
+    }
+  }
+  gst_cuda_context_pop (NULL);
+
+  self->dts_offset = 0;
+  if (self->bframes > 0) {
+    if (self->in_info.fps_n > 0 && self->in_info.fps_d > 0) {
+      self->dts_offset = gst_util_uint64_scale (self->bframes * GST_SECOND,
+          self->in_info.fps_d, self->in_info.fps_n);
+    } else {
+      self->dts_offset = gst_util_uint64_scale (self->bframes, GST_SECOND, 30);
+    }
+  }
+
+  if (!gst_nv_abr_enc_open_ladder (self))
+    return FALSE;
+
+  gst_nv_abr_enc_ensure_srcpads (self);
+
+  for (i = 0; i < n_renditions; i++) {
+    GstCaps *src_caps = gst_nv_abr_enc_get_src_caps (self, &renditions[i]);
+
+    gst_pad_push_event (g_ptr_array_index (self->srcpads, i),
+        gst_event_new_caps (src_caps));
+    gst_caps_unref (src_caps);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_nv_abr_enc_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) parent;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_STREAM_START:
+      /* every source pad starts its own stream */
+      gst_event_unref (event);
+      return TRUE;
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+      gboolean ret;
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_nv_abr_enc_set_caps (self, caps);
+      gst_event_unref (event);
+
+      return ret;
+    }
+    case GST_EVENT_EOS:
+      if (self->ladder)
+        gst_cuda_abr_ladder_drain (self->ladder);
+      break;
+    case GST_EVENT_FLUSH_START:
+      /* the ladder belongs to the streaming thread, which returns once the
+       * renditions report flushing. It is reset on flush-stop */
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      /* drops the pictures the sessions still hold on to along with their
+       * input slots, and restarts every rendition from an IDR */
+      if (self->ladder) {
+        GST_DEBUG_OBJECT (self, "resetting the encode sessions");
+
+        g_clear_pointer (&self->ladder, gst_cuda_abr_ladder_free);
+        /* downstream still has to stop flushing if this fails, the error is
+         * posted and the next buffer is refused */
+        gst_nv_abr_enc_open_ladder (self);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_nv_abr_enc_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) parent;
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT &&
+      gst_cuda_handle_context_query (GST_ELEMENT (self), query,
+          self->cuda_ctx)) {
+    return TRUE;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static gboolean
+gst_nv_abr_enc_scale (GstNvAbrEnc * self, GstBuffer * buffer, gint slot)
+{
+  GstNvAbrEncKernelLadder ladder = { 0, };
+  GstVideoFrame vframe;
+  CUdeviceptr src_luma;
+  CUdeviceptr src_chroma;
+  CUdeviceptr dst = self->slots[slot];
+  gint src_pitch;
+  gint src_width = GST_VIDEO_INFO_WIDTH (&self->in_info);
+  gint src_height = GST_VIDEO_INFO_HEIGHT (&self->in_info);
+  guint max_width = 0;
+  guint max_height = 0;
+  gpointer args[] = { &src_luma, &src_chroma, &src_pitch, &src_width,
+    &src_height, &dst, &ladder
+  };
+  gboolean ret;
+  guint i;
+
+  for (i = 0; i < self->rendition_array->len; i++) {
+    GstCudaAbrRendition *rendition =
+        &g_array_index (self->rendition_array, GstCudaAbrRendition, i);
+
+    ladder.renditions[i].width = rendition->width;
+    ladder.renditions[i].height = rendition->height;
+    ladder.renditions[i].pitch = self->layouts[i].pitch;
+    ladder.renditions[i].scale_x = (gfloat) src_width / rendition->width;
+    ladder.renditions[i].scale_y = (gfloat) src_height / rendition->height;
+    ladder.renditions[i].luma_offset = self->layouts[i].luma_offset;
+    ladder.renditions[i].chroma_offset = self->layouts[i].chroma_offset;
+
+    max_width = MAX (max_width, rendition->width);
+    max_height = MAX (max_height, rendition->height);
+  }
+
+  if (!gst_video_frame_map (&vframe, &self->in_info, buffer,
+          GST_MAP_READ | GST_MAP_CUDA)) {
+    GST_ERROR_OBJECT (self, "Failed to map input buffer");
+    return FALSE;
+  }
+
+  src_luma = (CUdeviceptr) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
+  src_chroma = (CUdeviceptr) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 1);
+  src_pitch = GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
+
+  if (!gst_cuda_context_push (self->cuda_ctx)) {
+    gst_video_frame_unmap (&vframe);
+    return FALSE;
+  }
+
+  ret = gst_cuda_result (CuLaunchKernel (self->scale_func,
+          DIV_UP (max_width, CUDA_BLOCK_X), DIV_UP (max_height, CUDA_BLOCK_Y),
+          self->rendition_array->len, CUDA_BLOCK_X, CUDA_BLOCK_Y, 1, 0,
+          self->cuda_stream, args, NULL));
+
+  /* NVENC reads the input from its own stream */
+  if (ret)
+    ret = gst_cuda_result (CuStreamSynchronize (self->cuda_stream));
+
+  gst_cuda_context_pop (NULL);
+  gst_video_frame_unmap (&vframe);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_nv_abr_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstNvAbrEnc *self = (GstNvAbrEnc *) parent;
+  GstFlowReturn ret;
+  gint slot;
+
+  if (!self->ladder) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  slot = gst_cuda_abr_ladder_acquire_slot (self->ladder);
+  if (slot < 0) {
+    GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+        ("No free input slot"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_ERROR;
+  }
+
+  if (!gst_nv_abr_enc_scale (self, buffer, slot)) {
+    GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+        ("Failed to scale the input into the renditions"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_ERROR;
+  }
+
+  ret = gst_cuda_abr_ladder_submit (self->ladder, slot,
+      GST_BUFFER_PTS (buffer), GST_BUFFER_DURATION (buffer));
+  gst_buffer_unref (buffer);
+
+  if (ret == GST_FLOW_ERROR) {
+    GST_ELEMENT_ERROR (self, STREAM, ENCODE, (NULL),
+        ("Failed to encode the renditions"));
+  }
+
+  return ret;
+}
+
+void
+gst_nv_abr_enc_register (GstPlugin * plugin, guint device_id, guint rank,
+    GstCaps * src_caps)
+{
+  GType type;
+  gchar *type_name;
+  gchar *feature_name;
+  GstNvAbrEncClassData *cdata;
+  gboolean is_default = TRUE;
+  GTypeInfo type_info = {
+    sizeof (GstNvAbrEncClass),
+    NULL,
+    NULL,
+    (GClassInitFunc) gst_nv_abr_enc_class_init,
+    NULL,
+    NULL,
+    sizeof (GstNvAbrEnc),
+    0,
+    (GInstanceInitFunc) gst_nv_abr_enc_init,
+  };
+
+  GST_DEBUG_CATEGORY_INIT (gst_nv_abr_enc_debug, "nvabrenc", 0,
+      "NVENC ABR ladder encoder");
+
+  cdata = g_new0 (GstNvAbrEncClassData, 1);
+  cdata->src_caps = gst_caps_ref (src_caps);
+  cdata->cuda_device_id = device_id;
+  type_info.class_data = cdata;
+  /* class data will be leaked if the element never gets instantiated */
+  GST_MINI_OBJECT_FLAG_SET (src_caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  type_name = g_strdup ("GstNvH264AbrEnc");
+  feature_name = g_strdup ("nvh264abrenc");
+
+  if (g_type_from_name (type_name) != 0) {
+    g_free (type_name);
+    g_free (feature_name);
+    type_name = g_strdup_printf ("GstNvH264Device%dAbrEnc", device_id);
+    feature_name = g_strdup_printf ("nvh264device%dabrenc", device_id);
+    is_default = FALSE;
+  }
+
+  cdata->is_default = is_default;
+  type = g_type_register_static (GST_TYPE_ELEMENT, type_name, &type_info, 0);
+
+  /* make lower rank than default device */
+  if (rank > 0 && !is_default)
+    rank--;
+
+  if (!gst_element_register (plugin, feature_name, rank, type))
+    GST_WARNING ("Failed to register plugin '%s'", type_name);
+
+  g_free (type_name);
+  g_free (feature_name);
+}
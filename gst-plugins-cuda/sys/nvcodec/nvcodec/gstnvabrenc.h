@@ -0,0 +1,74 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_NV_ABR_ENC_H_INCLUDED__
+#define __GST_NV_ABR_ENC_H_INCLUDED__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/cuda/nvcodec/gstcudacontext.h>
+#include <gst/cuda/nvcodec/gstcudaabrladder.h>
+
+#include "gstnvenc.h"
+
+G_BEGIN_DECLS
+
+typedef struct {
+  GstElement parent;
+
+  GstPad *sinkpad;
+  /* (GstPad) one per rendition, in rendition order */
+  GPtrArray *srcpads;
+
+  /* properties */
+  gchar *renditions;
+  gint gop_size;
+  guint bframes;
+
+  GstCudaContext *cuda_ctx;
+  CUstream cuda_stream;
+  CUmodule cuda_module;
+  CUfunction scale_func;
+
+  GstVideoInfo in_info;
+  GArray *rendition_array;
+  GstCudaAbrPlaneLayout layouts[GST_CUDA_ABR_LADDER_MAX_RENDITIONS];
+
+  /* the input slots, each holding the scaled pictures of all the
+   * renditions. They stay registered with every encode session */
+  CUdeviceptr *slots;
+  guint n_slots;
+
+  GstClockTime dts_offset;
+  GstCudaAbrLadder *ladder;
+} GstNvAbrEnc;
+
+typedef struct {
+  GstElementClass parent_class;
+
+  guint cuda_device_id;
+} GstNvAbrEncClass;
+
+void gst_nv_abr_enc_register (GstPlugin * plugin,
+                              guint device_id,
+                              guint rank,
+                              GstCaps * src_caps);
+
+G_END_DECLS
+
+#endif /* __GST_NV_ABR_ENC_H_INCLUDED__ */
@@ -42,8 +42,9 @@ GST_DEBUG_CATEGORY_EXTERN (gst_nvenc_debug);
 
 #define SUPPORTED_GL_APIS GST_GL_API_OPENGL3
 
-/* magic pointer value we can put in the async queue to signal shut down */
-#define SHUTDOWN_COOKIE ((gpointer)GINT_TO_POINTER (1))
+/* upper bound of gst_nv_base_enc_calculate_num_prealloc_buffers(), the
+ * queues can hold all the items without blocking */
+#define MAX_NUM_FRAME_STATES 48
 
 #define parent_class gst_nv_base_enc_parent_class
 G_DEFINE_ABSTRACT_TYPE (GstNvBaseEnc, gst_nv_base_enc, GST_TYPE_VIDEO_ENCODER);
@@ -172,6 +173,8 @@ enum
   PROP_QP_CONST_I,
   PROP_QP_CONST_P,
   PROP_QP_CONST_B,
+  PROP_EXTERNAL_ME_HINTS,
+  PROP_ME_HINT_POOLING,
 };
 
 #define DEFAULT_PRESET GST_NV_PRESET_DEFAULT
@@ -190,6 +193,8 @@ enum
 #define DEFAULT_CONST_QUALITY 0
 #define DEFAULT_I_ADAPT FALSE
 #define DEFAULT_QP_DETAIL -1
+#define DEFAULT_EXTERNAL_ME_HINTS FALSE
+#define DEFAULT_ME_HINT_POOLING ME_HINT_POOLING_MEAN
 
 /* This lock is needed to prevent the situation where multiple encoders are
  * initialised at the same time which appears to cause excessive CPU usage over
@@ -223,8 +228,15 @@ typedef struct
 {
   GstNvEncInputResource *in_buf;
   NV_ENC_OUTPUT_PTR out_buf;
+
+  /* NVENC_EXTERNAL_ME_HINT array of the submitted frame, one hint per
+   * macroblock. Only allocated with external-me-hints, and owned by the
+   * item so that it stays valid while the frame is pending */
+  guint32 *me_hints;
 } GstNvEncFrameState;
 
+G_STATIC_ASSERT (sizeof (NVENC_EXTERNAL_ME_HINT) == sizeof (guint32));
+
 static gboolean gst_nv_base_enc_open (GstVideoEncoder * enc);
 static gboolean gst_nv_base_enc_close (GstVideoEncoder * enc);
 static gboolean gst_nv_base_enc_start (GstVideoEncoder * enc);
@@ -445,10 +457,25 @@ gst_nv_base_enc_class_init (GstNvBaseEncClass * klass)
           DEFAULT_QP_DETAIL,
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_EXTERNAL_ME_HINTS,
+      g_param_spec_boolean ("external-me-hints", "External ME Hints",
+          "Use the optical flow meta of the input buffers (as attached by "
+          "cudaof) as motion estimation hints (H.264 only)",
+          DEFAULT_EXTERNAL_ME_HINTS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ME_HINT_POOLING,
+      g_param_spec_enum ("me-hint-pooling", "ME Hint Pooling",
+          "How the optical flow vectors of a macroblock are combined into "
+          "its motion estimation hint",
+          GST_TYPE_CUDA_OF_ME_HINT_POOLING, DEFAULT_ME_HINT_POOLING,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 
   gst_type_mark_as_plugin_api (GST_TYPE_NV_BASE_ENC, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_NV_PRESET, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_NV_RC_MODE, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_CUDA_OF_ME_HINT_POOLING, 0);
 }
 
 static gboolean
@@ -718,9 +745,10 @@ gst_nv_base_enc_start (GstVideoEncoder * enc)
 {
   GstNvBaseEnc *nvenc = GST_NV_BASE_ENC (enc);
 
-  nvenc->available_queue = g_async_queue_new ();
-  nvenc->pending_queue = g_async_queue_new ();
-  nvenc->bitstream_queue = g_async_queue_new ();
+  nvenc->available_queue = gst_cuda_spsc_ring_new (MAX_NUM_FRAME_STATES);
+  nvenc->pending_queue = gst_cuda_spsc_ring_new (MAX_NUM_FRAME_STATES);
+  nvenc->bitstream_queue = gst_cuda_spsc_ring_new (MAX_NUM_FRAME_STATES);
+  nvenc->spare_state = NULL;
   nvenc->items = g_array_new (FALSE, TRUE, sizeof (GstNvEncFrameState));
 
   nvenc->last_flow = GST_FLOW_OK;
@@ -758,18 +786,9 @@ gst_nv_base_enc_stop (GstVideoEncoder * enc)
     nvenc->input_state = NULL;
   }
 
-  if (nvenc->available_queue) {
-    g_async_queue_unref (nvenc->available_queue);
-    nvenc->available_queue = NULL;
-  }
-  if (nvenc->pending_queue) {
-    g_async_queue_unref (nvenc->pending_queue);
-    nvenc->pending_queue = NULL;
-  }
-  if (nvenc->bitstream_queue) {
-    g_async_queue_unref (nvenc->bitstream_queue);
-    nvenc->bitstream_queue = NULL;
-  }
+  g_clear_pointer (&nvenc->available_queue, gst_cuda_spsc_ring_free);
+  g_clear_pointer (&nvenc->pending_queue, gst_cuda_spsc_ring_free);
+  g_clear_pointer (&nvenc->bitstream_queue, gst_cuda_spsc_ring_free);
   if (nvenc->display) {
     gst_object_unref (nvenc->display);
     nvenc->display = NULL;
@@ -788,6 +807,8 @@ gst_nv_base_enc_stop (GstVideoEncoder * enc)
     nvenc->items = NULL;
   }
 
+  g_clear_pointer (&nvenc->me_hints, gst_cuda_of_me_hints_free);
+
   return TRUE;
 }
 
@@ -1043,6 +1064,8 @@ gst_nv_base_enc_init (GstNvBaseEnc * nvenc)
   nvenc->strict_gop = DEFAULT_STRICT_GOP;
   nvenc->const_quality = DEFAULT_CONST_QUALITY;
   nvenc->i_adapt = DEFAULT_I_ADAPT;
+  nvenc->external_me_hints = DEFAULT_EXTERNAL_ME_HINTS;
+  nvenc->me_hint_pooling = DEFAULT_ME_HINT_POOLING;
   nvenc->qp_min_detail = qp_detail;
   nvenc->qp_max_detail = qp_detail;
   nvenc->qp_const_detail = qp_detail;
@@ -1142,10 +1165,18 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
 
     GST_LOG_OBJECT (enc, "wait for bitstream buffer..");
 
-    state_in_queue = g_async_queue_pop (nvenc->bitstream_queue);
-    if ((gpointer) state_in_queue == SHUTDOWN_COOKIE)
+    /* NULL once the queue is closed and drained */
+    state_in_queue = gst_cuda_spsc_ring_pop (nvenc->bitstream_queue);
+    if (!state_in_queue)
       goto exit_thread;
 
+    if (g_atomic_int_get (&nvenc->discard_bitstream)) {
+      GST_INFO_OBJECT (nvenc, "discarding bitstream buffer %p",
+          state_in_queue);
+      gst_cuda_spsc_ring_push (nvenc->available_queue, state_in_queue);
+      continue;
+    }
+
     out_buf = state_in_queue->out_buf;
     resource = state_in_queue->in_buf;
 
@@ -1229,7 +1260,7 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
     memset (&resource->nv_mapped_resource, 0,
         sizeof (resource->nv_mapped_resource));
 
-    g_async_queue_push (nvenc->available_queue, state_in_queue);
+    gst_cuda_spsc_ring_push (nvenc->available_queue, state_in_queue);
 
     /* Ugly but no other way to get DTS offset since nvenc dose not adjust
      * dts/pts even if bframe was enabled. So the output PTS can be smaller
@@ -1287,7 +1318,7 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
     if (flow != GST_FLOW_OK) {
       GST_INFO_OBJECT (enc, "got flow %s", gst_flow_get_name (flow));
       g_atomic_int_set (&nvenc->last_flow, flow);
-      g_async_queue_push (nvenc->available_queue, SHUTDOWN_COOKIE);
+      gst_cuda_spsc_ring_close (nvenc->available_queue);
       goto exit_thread;
     }
   }
@@ -1301,7 +1332,7 @@ error_shutdown:
       nvenc->first_frame = NULL;
     }
     g_atomic_int_set (&nvenc->last_flow, GST_FLOW_ERROR);
-    g_async_queue_push (nvenc->available_queue, SHUTDOWN_COOKIE);
+    gst_cuda_spsc_ring_close (nvenc->available_queue);
 
     goto exit_thread;
   }
@@ -1326,7 +1357,12 @@ gst_nv_base_enc_start_bitstream_thread (GstNvBaseEnc * nvenc)
 
   g_assert (nvenc->bitstream_thread == NULL);
 
-  g_assert (g_async_queue_length (nvenc->bitstream_queue) == 0);
+  g_assert (gst_cuda_spsc_ring_get_length (nvenc->bitstream_queue) == 0);
+
+  /* the previous thread is gone, the queues can be reopened */
+  gst_cuda_spsc_ring_reopen (nvenc->available_queue);
+  gst_cuda_spsc_ring_reopen (nvenc->bitstream_queue);
+  g_atomic_int_set (&nvenc->discard_bitstream, FALSE);
 
   nvenc->bitstream_thread =
       g_thread_try_new (name, gst_nv_base_enc_bitstream_thread, nvenc, NULL);
@@ -1343,8 +1379,6 @@ gst_nv_base_enc_start_bitstream_thread (GstNvBaseEnc * nvenc)
 static gboolean
 gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc, gboolean force)
 {
-  GstNvEncFrameState *state;
-
   if (nvenc->bitstream_thread == NULL)
     return TRUE;
 
@@ -1353,22 +1387,13 @@ gst_nv_base_enc_stop_bitstream_thread (GstNvBaseEnc * nvenc, gboolean force)
    * enabled */
   gst_nv_base_enc_drain_encoder (nvenc);
 
-  if (force) {
-    g_async_queue_lock (nvenc->available_queue);
-    g_async_queue_lock (nvenc->pending_queue);
-    g_async_queue_lock (nvenc->bitstream_queue);
-    while ((state = g_async_queue_try_pop_unlocked (nvenc->bitstream_queue))) {
-      GST_INFO_OBJECT (nvenc, "stole bitstream buffer %p from queue", state);
-      g_async_queue_push_unlocked (nvenc->available_queue, state);
-    }
-    g_async_queue_push_unlocked (nvenc->bitstream_queue, SHUTDOWN_COOKIE);
-    g_async_queue_unlock (nvenc->available_queue);
-    g_async_queue_unlock (nvenc->pending_queue);
-    g_async_queue_unlock (nvenc->bitstream_queue);
-  } else {
-    /* wait for encoder to drain the remaining buffers */
-    g_async_queue_push (nvenc->bitstream_queue, SHUTDOWN_COOKIE);
-  }
+  /* only the bitstream thread dequeues, so it returns the remaining
+   * buffers itself instead of having them stolen from the queue */
+  if (force)
+    g_atomic_int_set (&nvenc->discard_bitstream, TRUE);
+
+  /* otherwise wait for encoder to drain the remaining buffers */
+  gst_cuda_spsc_ring_close (nvenc->bitstream_queue);
 
   if (!force) {
     /* temporary unlock during finish, so other thread can find and push frame */
@@ -1391,15 +1416,19 @@ gst_nv_base_enc_reset_queues (GstNvBaseEnc * nvenc)
 
   GST_INFO_OBJECT (nvenc, "clearing queues");
 
-  while ((ptr = g_async_queue_try_pop (nvenc->available_queue))) {
+  while ((ptr = gst_cuda_spsc_ring_try_pop (nvenc->available_queue))) {
     /* do nothing */
   }
-  while ((ptr = g_async_queue_try_pop (nvenc->pending_queue))) {
+  while ((ptr = gst_cuda_spsc_ring_try_pop (nvenc->pending_queue))) {
     /* do nothing */
   }
-  while ((ptr = g_async_queue_try_pop (nvenc->bitstream_queue))) {
+  while ((ptr = gst_cuda_spsc_ring_try_pop (nvenc->bitstream_queue))) {
     /* do nothing */
   }
+
+  nvenc->spare_state = NULL;
+  gst_cuda_spsc_ring_reopen (nvenc->available_queue);
+  gst_cuda_spsc_ring_reopen (nvenc->bitstream_queue);
 }
 
 static void
@@ -1424,6 +1453,9 @@ gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
     GstNvEncInputResource *in_buf =
         g_array_index (nvenc->items, GstNvEncFrameState, i).in_buf;
 
+    g_clear_pointer (&g_array_index (nvenc->items, GstNvEncFrameState,
+            i).me_hints, g_free);
+
     if (in_buf->mapped) {
       GST_LOG_OBJECT (nvenc, "Unmap resource %p", in_buf);
 
@@ -1614,7 +1646,7 @@ gst_nv_base_enc_calculate_num_prealloc_buffers (GstNvBaseEnc * enc,
    *   maximum allowed lookahead: 32
    *   max bfraems: 4 -> frameIntervalP: 5
    * "4 + 32 + 5" < "48" so it seems to sufficiently safe upper bound */
-  num_buffers = MIN (num_buffers, 48);
+  num_buffers = MIN (num_buffers, MAX_NUM_FRAME_STATES);
 
   GST_DEBUG_OBJECT (enc, "Calculated num buffers: %d "
       "(lookahead %d, frameIntervalP %d)",
@@ -1759,6 +1791,21 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
      * subsequent reconfigures */
     params->maxEncodeWidth = GST_VIDEO_INFO_WIDTH (info);
     params->maxEncodeHeight = GST_VIDEO_INFO_HEIGHT (info);
+
+    /* a single L0 hint per 16x16 macroblock. The hint order of HEVC depends
+     * on the CTB size, which is left to the driver, so only H.264 is
+     * supported for now */
+    params->enableExternalMEHints = 0;
+    params->maxMEHintCountsPerBlock[0].numCandsPerBlk16x16 = 0;
+    if (nvenc->external_me_hints) {
+      if (gst_nvenc_cmp_guid (nvenc_class->codec_id, NV_ENC_CODEC_H264_GUID)) {
+        params->enableExternalMEHints = 1;
+        params->maxMEHintCountsPerBlock[0].numCandsPerBlk16x16 = 1;
+      } else {
+        GST_WARNING_OBJECT (nvenc,
+            "external motion estimation hints are only supported for H.264");
+      }
+    }
   }
 
   preset_config.version = gst_nvenc_get_preset_config_version ();
@@ -1857,6 +1904,14 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
   nvenc->input_state = gst_video_codec_state_ref (state);
   GST_INFO_OBJECT (nvenc, "%sconfigured encoder", reconfigure ? "re" : "");
 
+  /* the hint arrays of the items are sized for the maximum resolution,
+   * only the converter follows the current one */
+  g_clear_pointer (&nvenc->me_hints, gst_cuda_of_me_hints_free);
+  if (params->enableExternalMEHints) {
+    nvenc->me_hints = gst_cuda_of_me_hints_new (GST_VIDEO_INFO_WIDTH (info),
+        GST_VIDEO_INFO_HEIGHT (info), nvenc->me_hint_pooling);
+  }
+
   /* now allocate some buffers only on first configuration */
   if (!reconfigure) {
     GstCapsFeatures *features;
@@ -1926,6 +1981,12 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
             resource, nv_ret);
 
       g_array_index (nvenc->items, GstNvEncFrameState, i).in_buf = resource;
+
+      if (nvenc->me_hints) {
+        g_array_index (nvenc->items, GstNvEncFrameState, i).me_hints =
+            g_new0 (guint32, gst_cuda_of_me_hints_get_num_blocks
+            (nvenc->me_hints));
+      }
     }
     gst_cuda_context_pop (NULL);
 
@@ -1956,8 +2017,8 @@ gst_nv_base_enc_set_format (GstVideoEncoder * enc, GstVideoCodecState * state)
       g_array_index (nvenc->items, GstNvEncFrameState, i).out_buf =
           cout_buf.bitstreamBuffer;
 
-      g_async_queue_push (nvenc->available_queue, &g_array_index (nvenc->items,
-              GstNvEncFrameState, i));
+      gst_cuda_spsc_ring_push (nvenc->available_queue,
+          &g_array_index (nvenc->items, GstNvEncFrameState, i));
     }
 
 #if 0
@@ -2285,11 +2346,20 @@ static GstFlowReturn
 _acquire_input_buffer (GstNvBaseEnc * nvenc, GstNvEncFrameState ** input)
 {
   GST_LOG_OBJECT (nvenc, "acquiring input buffer..");
+
+  if (nvenc->spare_state) {
+    *input = nvenc->spare_state;
+    nvenc->spare_state = NULL;
+
+    return GST_FLOW_OK;
+  }
+
   GST_VIDEO_ENCODER_STREAM_UNLOCK (nvenc);
-  *input = g_async_queue_pop (nvenc->available_queue);
+  *input = gst_cuda_spsc_ring_pop (nvenc->available_queue);
   GST_VIDEO_ENCODER_STREAM_LOCK (nvenc);
 
-  if (*input == SHUTDOWN_COOKIE)
+  /* the bitstream thread closed the queue on shutdown */
+  if (!*input)
     return g_atomic_int_get (&nvenc->last_flow);
 
   return GST_FLOW_OK;
@@ -2338,6 +2408,17 @@ _submit_input_buffer (GstNvBaseEnc * nvenc, GstVideoCodecFrame * frame,
   else
     pic_params.encodePicFlags = 0;
 
+  /* the optical flow was computed against the previous input frame, which
+   * NVENC scales to the actual reference distance */
+  if (nvenc->me_hints && state->me_hints
+      && !(pic_params.encodePicFlags & NV_ENC_PIC_FLAG_FORCEIDR)
+      && gst_cuda_of_me_hints_convert_buffer (nvenc->me_hints,
+          frame->input_buffer, state->me_hints)) {
+    pic_params.meHintCountsPerBlock[0].numCandsPerBlk16x16 = 1;
+    pic_params.meExternalHints = (NVENC_EXTERNAL_ME_HINT *) state->me_hints;
+    pic_params.meHintRefPicDist[0] = 1;
+  }
+
   if (nvenc_class->set_pic_params
       && !nvenc_class->set_pic_params (nvenc, frame, &pic_params)) {
     GST_ERROR_OBJECT (nvenc, "Subclass failed to submit buffer");
@@ -2360,14 +2441,13 @@ _submit_input_buffer (GstNvBaseEnc * nvenc, GstVideoCodecFrame * frame,
     GST_DEBUG_OBJECT (nvenc, "Encoded picture (encoder needs more input)");
   } else {
     GST_ERROR_OBJECT (nvenc, "Failed to encode picture: %d", nv_ret);
-    g_async_queue_push (nvenc->available_queue, state);
 
     return GST_FLOW_ERROR;
   }
 
   /* GstNvEncFrameState shouldn't be freed by DestroyNotify */
   gst_video_codec_frame_set_user_data (frame, state, NULL);
-  g_async_queue_push (nvenc->pending_queue, state);
+  gst_cuda_spsc_ring_push (nvenc->pending_queue, state);
 
   if (nv_ret == NV_ENC_SUCCESS) {
     GstNvEncFrameState *pending_state;
@@ -2390,15 +2470,11 @@ _submit_input_buffer (GstNvBaseEnc * nvenc, GstVideoCodecFrame * frame,
      */
     end = nvenc->rc_lookahead;
 
-    g_async_queue_lock (nvenc->pending_queue);
-
-    len = g_async_queue_length_unlocked (nvenc->pending_queue);
+    len = gst_cuda_spsc_ring_get_length (nvenc->pending_queue);
     for (i = len; i > end; i--) {
-      pending_state = g_async_queue_pop_unlocked (nvenc->pending_queue);
-      g_async_queue_push (nvenc->bitstream_queue, pending_state);
+      pending_state = gst_cuda_spsc_ring_try_pop (nvenc->pending_queue);
+      gst_cuda_spsc_ring_push (nvenc->bitstream_queue, pending_state);
     }
-
-    g_async_queue_unlock (nvenc->pending_queue);
   }
 
   return GST_FLOW_OK;
@@ -2476,7 +2552,7 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
   }
 
   flow = _acquire_input_buffer (nvenc, &state);
-  if (flow != GST_FLOW_OK || state == SHUTDOWN_COOKIE || !state)
+  if (flow != GST_FLOW_OK || !state)
     goto unmap_and_drop;
 
   resource = state->in_buf;
@@ -2540,7 +2616,7 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
 
   if (flow != GST_FLOW_OK) {
     GST_DEBUG_OBJECT (nvenc, "return state to pool");
-    g_async_queue_push (nvenc->available_queue, state);
+    nvenc->spare_state = state;
     goto unmap_and_drop;
   }
 
@@ -2602,12 +2678,10 @@ gst_nv_base_enc_drain_encoder (GstNvBaseEnc * nvenc)
   } else {
     GstNvEncFrameState *pending_state;
 
-    g_async_queue_lock (nvenc->pending_queue);
     while ((pending_state =
-            g_async_queue_try_pop_unlocked (nvenc->pending_queue))) {
-      g_async_queue_push (nvenc->bitstream_queue, pending_state);
+            gst_cuda_spsc_ring_try_pop (nvenc->pending_queue))) {
+      gst_cuda_spsc_ring_push (nvenc->bitstream_queue, pending_state);
     }
-    g_async_queue_unlock (nvenc->pending_queue);
   }
 
   gst_cuda_context_pop (NULL);
@@ -2735,6 +2809,15 @@ gst_nv_base_enc_set_property (GObject * object, guint prop_id,
     case PROP_QP_CONST_B:
       nvenc->qp_const_detail.qp_b = g_value_get_int (value);
       break;
+    case PROP_EXTERNAL_ME_HINTS:
+      /* only taken into account when the encoder is initialized */
+      nvenc->external_me_hints = g_value_get_boolean (value);
+      reconfig = FALSE;
+      break;
+    case PROP_ME_HINT_POOLING:
+      nvenc->me_hint_pooling = g_value_get_enum (value);
+      reconfig = FALSE;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       reconfig = FALSE;
@@ -2828,6 +2911,12 @@ gst_nv_base_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_QP_CONST_B:
       g_value_set_int (value, nvenc->qp_const_detail.qp_b);
       break;
+    case PROP_EXTERNAL_ME_HINTS:
+      g_value_set_boolean (value, nvenc->external_me_hints);
+      break;
+    case PROP_ME_HINT_POOLING:
+      g_value_set_enum (value, nvenc->me_hint_pooling);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
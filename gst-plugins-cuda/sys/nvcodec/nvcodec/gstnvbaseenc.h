@@ -22,6 +22,8 @@
 
 #include <gst/video/gstvideoencoder.h>
 #include <gst/cuda/nvcodec/gstcudacontext.h>
+#include <gst/cuda/nvcodec/gstcudaspscring.h>
+#include <gst/cuda/of/gstcudaofmehints.h>
 
 #include "gstnvenc.h"
 
@@ -108,6 +110,8 @@ typedef struct {
   gboolean        strict_gop;
   gdouble         const_quality;
   gboolean        i_adapt;
+  gboolean        external_me_hints;
+  GstCudaOfMeHintPooling me_hint_pooling;
 
   GstCudaContext * cuda_ctx;
   CUstream         cuda_stream;
@@ -127,16 +131,24 @@ typedef struct {
   GArray            *items;
 
   /* (GstNvEncFrameState) available empty items which could be submitted
-   * to encoder */
-  GAsyncQueue       *available_queue;
+   * to encoder. Filled by the bitstream thread, closed by it on shutdown */
+  GstCudaSpscRing   *available_queue;
+
+  /* (GstNvEncFrameState) item which could not be submitted, handed back
+   * to the streaming thread without going through available_queue */
+  gpointer           spare_state;
 
   /* (GstNvEncFrameState) submitted to encoder but not ready to finish
-   * (due to bframe or lookhead operation) */
-  GAsyncQueue       *pending_queue;
+   * (due to bframe or lookhead operation). Streaming thread only */
+  GstCudaSpscRing   *pending_queue;
 
   /* (GstNvEncFrameState) submitted to encoder and ready to finish.
-   * finished items will go back to available item queue */
-  GAsyncQueue       *bitstream_queue;
+   * finished items will go back to available item queue. Closed to stop
+   * the bitstream thread */
+  GstCudaSpscRing   *bitstream_queue;
+
+  /* bitstream thread returns the remaining items without finishing them */
+  gint               discard_bitstream;   /* ATOMIC */
 
   /* we spawn a thread that does the (blocking) waits for output buffers
    * to become available, so we can continue to feed data to the encoder
@@ -151,6 +163,10 @@ typedef struct {
 
   GstFlowReturn   last_flow;          /* ATOMIC */
 
+  /* converts the optical flow meta of the input buffers into motion
+   * estimation hints, NULL unless external-me-hints is enabled */
+  GstCudaOfMeHints *me_hints;
+
   /* the first frame when bframe was enabled */
   GstVideoCodecFrame *first_frame;
   GstClockTime dts_offset;
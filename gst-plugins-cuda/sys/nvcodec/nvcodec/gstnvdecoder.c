@@ -64,10 +64,33 @@ GST_DEBUG_CATEGORY_EXTERN (gst_nv_decoder_debug);
 #define SUPPORTED_GL_APIS (GST_GL_API_OPENGL | GST_GL_API_OPENGL3)
 #endif
 
-typedef struct _GstNvDecoderFrameInfo
+/* NVDEC cannot decode into more surfaces than this */
+#define MAX_DECODE_SURFACES 32
+
+/* Surfaces the pool may grow by when downstream holds on to more frames
+ * than the subclass asked for */
+#define DECODE_SURFACES_HEADROOM 4
+
+enum
+{
+  PROP_0,
+  PROP_ZERO_COPY,
+  PROP_SURFACE_WAIT_TIMEOUT,
+};
+
+#define DEFAULT_ZERO_COPY FALSE
+#define DEFAULT_SURFACE_WAIT_TIMEOUT 0
+
+/* NVDEC decoder instance. Frames mapped as zero-copy output keep a
+ * reference, so that they can still be unmapped once the decoder was
+ * reconfigured */
+struct _GstNvDecoderInstance
 {
-  gboolean available;
-} GstNvDecoderFrameInfo;
+  CUvideodecoder handle;
+  GstCudaContext *context;
+
+  gint ref_count;
+};
 
 typedef enum
 {
@@ -82,10 +105,16 @@ struct _GstNvDecoder
   GstObject parent;
   GstCudaContext *context;
   CUstream cuda_stream;
-  CUvideodecoder decoder_handle;
+  GstNvDecoderInstance *instance;
+
+  /* protected by the object lock, as flushing is set from other threads
+   * than the streaming thread replacing it */
+  GstCudaSurfacePool *frame_pool;
 
-  GstNvDecoderFrameInfo *frame_pool;
-  guint pool_size;
+  /* how long a new frame waits for downstream to release a surface, once
+   * the pool cannot grow anymore */
+  GstClockTime surface_wait_timeout;
+  gboolean flushing;
 
   GstVideoInfo info;
   GstVideoInfo coded_info;
@@ -98,6 +127,11 @@ struct _GstNvDecoder
   GstObject *other_gl_context;
 
   GstNvDecoderOutputType output_type;
+
+  /* wrap the mapped surfaces instead of copying them, if the output is
+   * CUDA memory */
+  gboolean zero_copy;
+  GstAllocator *allocator;
 };
 
 static void gst_nv_decoder_dispose (GObject * object);
@@ -134,6 +168,7 @@ gst_nv_decoder_dispose (GObject * object)
     }
   }
 
+  gst_clear_object (&self->allocator);
   gst_clear_object (&self->context);
   gst_clear_object (&self->gl_display);
   gst_clear_object (&self->gl_context);
@@ -211,17 +246,54 @@ output_format_from_video_format (GstVideoFormat format)
   return cudaVideoSurfaceFormat_NV12;
 }
 
-static gboolean
-gst_nv_decoder_prepare_frame_pool (GstNvDecoder * self, guint pool_size)
+static GstNvDecoderInstance *
+gst_nv_decoder_instance_new (GstCudaContext * context, CUvideodecoder handle)
 {
-  gint i;
+  GstNvDecoderInstance *instance = g_new0 (GstNvDecoderInstance, 1);
+
+  instance->handle = handle;
+  instance->context = gst_object_ref (context);
+  instance->ref_count = 1;
+
+  return instance;
+}
+
+static GstNvDecoderInstance *
+gst_nv_decoder_instance_ref (GstNvDecoderInstance * instance)
+{
+  g_atomic_int_add (&instance->ref_count, 1);
+
+  return instance;
+}
 
-  self->frame_pool = g_new (GstNvDecoderFrameInfo, pool_size);
+static void
+gst_nv_decoder_instance_unref (GstNvDecoderInstance * instance)
+{
+  if (!g_atomic_int_dec_and_test (&instance->ref_count))
+    return;
+
+  gst_cuda_context_push (instance->context);
+  CuvidDestroyDecoder (instance->handle);
+  gst_cuda_context_pop (NULL);
+
+  gst_object_unref (instance->context);
+  g_free (instance);
+}
+
+static gboolean
+gst_nv_decoder_prepare_frame_pool (GstNvDecoder * self, guint pool_size,
+    guint max_pool_size)
+{
+  GstCudaSurfacePool *frame_pool;
 
-  for (i = 0; i < pool_size; i++)
-    self->frame_pool[i].available = TRUE;
+  frame_pool = gst_cuda_surface_pool_new (pool_size, max_pool_size);
+  if (!frame_pool)
+    return FALSE;
 
-  self->pool_size = pool_size;
+  GST_OBJECT_LOCK (self);
+  gst_cuda_surface_pool_set_flushing (frame_pool, self->flushing);
+  self->frame_pool = frame_pool;
+  GST_OBJECT_UNLOCK (self);
 
   return TRUE;
 }
@@ -252,6 +324,42 @@ gst_nv_decoder_new (GstCudaContext * context)
   return self;
 }
 
+/* Applies the property values of @videodec, called from its open() once
+ * @decoder is created. With zero-copy, decoded frames are output as
+ * GstCudaMemory wrapping the mapped decoder surface if downstream accepts
+ * CUDA memory. The surface is unmapped and can be decoded into again once
+ * the memory is freed */
+void
+gst_nv_decoder_apply_settings (GstNvDecoder * decoder, GstElement * videodec,
+    const GstNvDecoderSettings * settings)
+{
+  g_return_if_fail (GST_IS_NV_DECODER (decoder));
+  g_return_if_fail (GST_IS_ELEMENT (videodec));
+  g_return_if_fail (settings != NULL);
+
+  GST_OBJECT_LOCK (videodec);
+  decoder->zero_copy = settings->zero_copy;
+  decoder->surface_wait_timeout = settings->surface_wait_timeout;
+  GST_OBJECT_UNLOCK (videodec);
+}
+
+/* Makes a new frame waiting for a surface give up, and new frames fail
+ * right away instead of waiting, until unset. Set on flush and when going
+ * from PAUSED to READY by the event and state change helpers below, so that
+ * a wait for downstream to release a surface cannot stall the streaming
+ * thread */
+void
+gst_nv_decoder_set_flushing (GstNvDecoder * decoder, gboolean flushing)
+{
+  g_return_if_fail (GST_IS_NV_DECODER (decoder));
+
+  GST_OBJECT_LOCK (decoder);
+  decoder->flushing = flushing;
+  if (decoder->frame_pool)
+    gst_cuda_surface_pool_set_flushing (decoder->frame_pool, flushing);
+  GST_OBJECT_UNLOCK (decoder);
+}
+
 gboolean
 gst_nv_decoder_is_configured (GstNvDecoder * decoder)
 {
@@ -263,15 +371,24 @@ gst_nv_decoder_is_configured (GstNvDecoder * decoder)
 static void
 gst_nv_decoder_reset (GstNvDecoder * self)
 {
-  g_clear_pointer (&self->frame_pool, g_free);
+  if (self->frame_pool) {
+    GstCudaSurfacePoolStats stats;
 
-  if (self->decoder_handle) {
-    gst_cuda_context_push (self->context);
-    CuvidDestroyDecoder (self->decoder_handle);
-    gst_cuda_context_pop (NULL);
-    self->decoder_handle = NULL;
+    gst_cuda_surface_pool_get_stats (self->frame_pool, &stats);
+    GST_DEBUG_OBJECT (self, "Frame pool stats: size %u/%u, peak in use %u, "
+        "acquired %u, waited %u, failed %u", stats.size, stats.max_size,
+        stats.peak_in_use, stats.num_acquired, stats.num_waits,
+        stats.num_failures);
+
+    /* frames still alive hold their own reference */
+    GST_OBJECT_LOCK (self);
+    gst_cuda_surface_pool_unref (self->frame_pool);
+    self->frame_pool = NULL;
+    GST_OBJECT_UNLOCK (self);
   }
 
+  g_clear_pointer (&self->instance, gst_nv_decoder_instance_unref);
+
   self->output_type = GST_NV_DECODER_OUTPUT_TYPE_SYSTEM;
   self->configured = FALSE;
 }
@@ -281,7 +398,9 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
     GstVideoInfo * info, gint coded_width, gint coded_height, guint pool_size)
 {
   CUVIDDECODECREATEINFO create_info = { 0, };
+  CUvideodecoder handle = NULL;
   GstVideoFormat format;
+  guint max_pool_size;
   gboolean ret;
 
   g_return_val_if_fail (GST_IS_NV_DECODER (decoder), FALSE);
@@ -299,10 +418,16 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
 
   format = GST_VIDEO_INFO_FORMAT (info);
 
+  /* NVDEC allocates all the decode surfaces up front, so the decoder is
+   * created with as many as the pool can grow to */
+  max_pool_size = MIN (pool_size + DECODE_SURFACES_HEADROOM,
+      MAX_DECODE_SURFACES);
+  max_pool_size = MAX (max_pool_size, pool_size);
+
   /* FIXME: check aligned resolution or actual coded resolution */
   create_info.ulWidth = GST_VIDEO_INFO_WIDTH (&decoder->coded_info);
   create_info.ulHeight = GST_VIDEO_INFO_HEIGHT (&decoder->coded_info);
-  create_info.ulNumDecodeSurfaces = pool_size;
+  create_info.ulNumDecodeSurfaces = max_pool_size;
   create_info.CodecType = codec;
   create_info.ChromaFormat = chroma_format_from_video_format (format);
   create_info.ulCreationFlags = cudaVideoCreate_Default;
@@ -318,8 +443,12 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
 
   create_info.ulTargetWidth = GST_VIDEO_INFO_WIDTH (info);
   create_info.ulTargetHeight = GST_VIDEO_INFO_HEIGHT (info);
-  /* we always copy decoded picture to output buffer */
-  create_info.ulNumOutputSurfaces = 1;
+  /* the decoded picture is copied to the output buffer, unless zero-copy
+   * output keeps a mapped surface per frame held downstream */
+  if (decoder->zero_copy)
+    create_info.ulNumOutputSurfaces = max_pool_size;
+  else
+    create_info.ulNumOutputSurfaces = 1;
 
   create_info.target_rect.left = 0;
   create_info.target_rect.top = 0;
@@ -331,8 +460,7 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
     return FALSE;
   }
 
-  ret = gst_cuda_result (CuvidCreateDecoder (&decoder->decoder_handle,
-          &create_info));
+  ret = gst_cuda_result (CuvidCreateDecoder (&handle, &create_info));
   gst_cuda_context_pop (NULL);
 
   if (!ret) {
@@ -340,7 +468,10 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
     return FALSE;
   }
 
-  if (!gst_nv_decoder_prepare_frame_pool (decoder, pool_size)) {
+  decoder->instance = gst_nv_decoder_instance_new (decoder->context, handle);
+
+  if (!gst_nv_decoder_prepare_frame_pool (decoder, pool_size,
+          max_pool_size)) {
     GST_ERROR_OBJECT (decoder, "Cannot prepare internal surface buffer pool");
     gst_nv_decoder_reset (decoder);
     return FALSE;
@@ -351,36 +482,51 @@ gst_nv_decoder_configure (GstNvDecoder * decoder, cudaVideoCodec codec,
   return TRUE;
 }
 
-GstNvDecoderFrame *
-gst_nv_decoder_new_frame (GstNvDecoder * decoder)
+GstFlowReturn
+gst_nv_decoder_new_frame (GstNvDecoder * decoder, GstNvDecoderFrame ** nv_frame)
 {
   GstNvDecoderFrame *frame;
-  gint i;
-  gint index_to_use = -1;
+  gint index_to_use;
 
-  g_return_val_if_fail (GST_IS_NV_DECODER (decoder), NULL);
+  g_return_val_if_fail (GST_IS_NV_DECODER (decoder), GST_FLOW_ERROR);
+  g_return_val_if_fail (decoder->frame_pool != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (nv_frame != NULL, GST_FLOW_ERROR);
 
-  for (i = 0; i < decoder->pool_size; i++) {
-    if (decoder->frame_pool[i].available) {
-      decoder->frame_pool[i].available = FALSE;
-      index_to_use = i;
-      break;
-    }
-  }
+  /* if all the surfaces are held downstream, optionally wait for one to
+   * come back rather than failing right away */
+  index_to_use = gst_cuda_surface_pool_acquire (decoder->frame_pool,
+      decoder->surface_wait_timeout);
 
   if (index_to_use < 0) {
-    GST_ERROR_OBJECT (decoder, "No available frame");
-    return NULL;
+    GstCudaSurfacePoolStats stats;
+    gboolean flushing;
+
+    GST_OBJECT_LOCK (decoder);
+    flushing = decoder->flushing;
+    GST_OBJECT_UNLOCK (decoder);
+
+    if (flushing) {
+      GST_DEBUG_OBJECT (decoder, "Flushing, no new frame");
+      return GST_FLOW_FLUSHING;
+    }
+
+    gst_cuda_surface_pool_get_stats (decoder->frame_pool, &stats);
+    GST_ERROR_OBJECT (decoder, "No available frame, %u/%u surfaces in use",
+        stats.in_use, stats.max_size);
+    return GST_FLOW_ERROR;
   }
 
   frame = g_new0 (GstNvDecoderFrame, 1);
   frame->index = index_to_use;
   frame->decoder = gst_object_ref (decoder);
+  frame->pool = gst_cuda_surface_pool_ref (decoder->frame_pool);
   frame->ref_count = 1;
 
   GST_LOG_OBJECT (decoder, "New frame %p (index %d)", frame, frame->index);
 
-  return frame;
+  *nv_frame = frame;
+
+  return GST_FLOW_OK;
 }
 
 /* must be called with gst_cuda_context_push */
@@ -404,12 +550,13 @@ gst_nv_decoder_frame_map (GstNvDecoderFrame * frame)
     return TRUE;
   }
 
-  if (!gst_cuda_result (CuvidMapVideoFrame (self->decoder_handle,
+  if (!gst_cuda_result (CuvidMapVideoFrame (self->instance->handle,
               frame->index, &frame->devptr, &frame->pitch, &params))) {
     GST_ERROR_OBJECT (self, "Cannot map picture");
     return FALSE;
   }
 
+  frame->instance = gst_nv_decoder_instance_ref (self->instance);
   frame->mapped = TRUE;
 
   return TRUE;
@@ -432,11 +579,12 @@ gst_nv_decoder_frame_unmap (GstNvDecoderFrame * frame)
     return;
   }
 
-  if (!gst_cuda_result (CuvidUnmapVideoFrame (self->decoder_handle,
+  if (!gst_cuda_result (CuvidUnmapVideoFrame (frame->instance->handle,
               frame->devptr))) {
     GST_ERROR_OBJECT (self, "Cannot unmap picture");
   }
 
+  g_clear_pointer (&frame->instance, gst_nv_decoder_instance_unref);
   frame->mapped = FALSE;
 }
 
@@ -467,16 +615,15 @@ gst_nv_decoder_frame_unref (GstNvDecoderFrame * frame)
         gst_cuda_context_pop (NULL);
       }
 
-      if (frame->index < self->pool_size) {
-        self->frame_pool[frame->index].available = TRUE;
-      } else {
-        GST_WARNING_OBJECT (self,
-            "Frame %p has invalid index %d", frame, frame->index);
-      }
-
       gst_object_unref (self);
     }
 
+    /* the pool may be the one of a previous configuration */
+    if (frame->pool) {
+      gst_cuda_surface_pool_release (frame->pool, frame->index);
+      gst_cuda_surface_pool_unref (frame->pool);
+    }
+
     g_free (frame);
   }
 }
@@ -494,7 +641,8 @@ gst_nv_decoder_decode_picture (GstNvDecoder * decoder, CUVIDPICPARAMS * params)
     return FALSE;
   }
 
-  if (!gst_cuda_result (CuvidDecodePicture (decoder->decoder_handle, params))) {
+  if (!gst_cuda_result (CuvidDecodePicture (decoder->instance->handle,
+              params))) {
     GST_ERROR_OBJECT (decoder, "Failed to decode picture");
     ret = FALSE;
   }
@@ -825,6 +973,66 @@ done:
   return ret;
 }
 
+static gboolean
+gst_nv_decoder_wrap_frame_as_cuda (GstNvDecoder * decoder,
+    GstNvDecoderFrame * frame, GstBuffer ** buffer)
+{
+  GstCudaAllocationParams params;
+  gsize offset[GST_VIDEO_MAX_PLANES] = { 0, };
+  GstVideoInfo *info = &decoder->info;
+  GstMemory *mem;
+  GstBuffer *outbuf;
+  gint i;
+
+  if (!gst_cuda_context_push (decoder->context)) {
+    GST_ERROR_OBJECT (decoder, "Failed to push CUDA context");
+    return FALSE;
+  }
+
+  if (!gst_nv_decoder_frame_map (frame)) {
+    GST_ERROR_OBJECT (decoder, "Couldn't map frame");
+    gst_cuda_context_pop (NULL);
+    return FALSE;
+  }
+
+  gst_cuda_context_pop (NULL);
+
+  if (!decoder->allocator)
+    decoder->allocator = gst_cuda_allocator_new (decoder->context);
+
+  memset (&params, 0, sizeof (GstCudaAllocationParams));
+  params.info = *info;
+
+  /* same layout as the one gst_nv_decoder_copy_frame_to_cuda() reads */
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++)
+    offset[i] = i * frame->pitch * GST_VIDEO_INFO_HEIGHT (info);
+
+  /* the memory owns a frame reference, the surface stays mapped and is
+   * not handed out again until downstream frees the memory */
+  mem = gst_cuda_allocator_alloc_wrapped (decoder->allocator, &params,
+      frame->devptr, frame->pitch, offset, gst_nv_decoder_frame_ref (frame),
+      (GDestroyNotify) gst_nv_decoder_frame_unref);
+  if (!mem) {
+    GST_ERROR_OBJECT (decoder, "Couldn't wrap frame %p", frame);
+    gst_nv_decoder_frame_unref (frame);
+    return FALSE;
+  }
+
+  outbuf = gst_buffer_new ();
+  gst_buffer_append_memory (outbuf, mem);
+  gst_buffer_add_video_meta_full (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+      info->offset, info->stride);
+
+  GST_LOG_OBJECT (decoder, "Wrapped frame %p (index %d) as CUDA memory",
+      frame, frame->index);
+
+  *buffer = outbuf;
+
+  return TRUE;
+}
+
 gboolean
 gst_nv_decoder_finish_frame (GstNvDecoder * decoder, GstVideoDecoder * videodec,
     GstNvDecoderFrame * frame, GstBuffer ** buffer)
@@ -837,6 +1045,10 @@ gst_nv_decoder_finish_frame (GstNvDecoder * decoder, GstVideoDecoder * videodec,
   g_return_val_if_fail (frame != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (buffer != NULL, GST_FLOW_ERROR);
 
+  if (decoder->zero_copy &&
+      decoder->output_type == GST_NV_DECODER_OUTPUT_TYPE_CUDA)
+    return gst_nv_decoder_wrap_frame_as_cuda (decoder, frame, buffer);
+
   outbuf = gst_video_decoder_allocate_output_buffer (videodec);
   if (!outbuf) {
     GST_ERROR_OBJECT (videodec, "Couldn't allocate output buffer");
@@ -1328,6 +1540,113 @@ gst_cuda_video_codec_to_string (cudaVideoCodec codec)
   return "unknown";
 }
 
+void
+gst_nv_decoder_install_properties (GObjectClass * object_class)
+{
+  /**
+   * GstNvDecoder:zero-copy:
+   *
+   * Output decoded frames as CUDA memory wrapping the decoder surface
+   * instead of copying them, if downstream supports CUDA memory. Each
+   * frame held downstream keeps a decoder surface busy.
+   *
+   * The property is read when the element opens the decoder, so it can
+   * only be changed in the NULL state.
+   */
+  g_object_class_install_property (object_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero Copy",
+          "Output CUDA memory wrapping the decoder surfaces without copy",
+          DEFAULT_ZERO_COPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNvDecoder:surface-wait-timeout:
+   *
+   * How long to wait for downstream to release a decoder surface when all
+   * of them are in use, before failing with an error. 0 fails right away,
+   * %GST_CLOCK_TIME_NONE waits until a surface is released. A flush or a
+   * state change to READY always interrupts the wait.
+   *
+   * Like #GstNvDecoder:zero-copy, it can only be changed in the NULL state.
+   */
+  g_object_class_install_property (object_class, PROP_SURFACE_WAIT_TIMEOUT,
+      g_param_spec_uint64 ("surface-wait-timeout", "Surface Wait Timeout",
+          "Nanoseconds to wait for downstream to release a decoder surface "
+          "when all are in use (0 = do not wait, -1 = wait until released)",
+          0, G_MAXUINT64, DEFAULT_SURFACE_WAIT_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+void
+gst_nv_decoder_settings_init (GstNvDecoderSettings * settings)
+{
+  g_return_if_fail (settings != NULL);
+
+  settings->zero_copy = DEFAULT_ZERO_COPY;
+  settings->surface_wait_timeout = DEFAULT_SURFACE_WAIT_TIMEOUT;
+}
+
+/* Returns FALSE if @prop_id is not one of the shared properties */
+gboolean
+gst_nv_decoder_settings_set_property (GstNvDecoderSettings * settings,
+    GstElement * videodec, guint prop_id, const GValue * value,
+    GParamSpec * pspec)
+{
+  g_return_val_if_fail (settings != NULL, FALSE);
+  g_return_val_if_fail (GST_IS_ELEMENT (videodec), FALSE);
+
+  if (prop_id != PROP_ZERO_COPY && prop_id != PROP_SURFACE_WAIT_TIMEOUT)
+    return FALSE;
+
+  GST_OBJECT_LOCK (videodec);
+  /* the decoder only picks the settings up in open(), a change afterwards
+   * would be silently ignored */
+  if (GST_STATE (videodec) != GST_STATE_NULL) {
+    GST_OBJECT_UNLOCK (videodec);
+    GST_WARNING_OBJECT (videodec,
+        "Property \"%s\" can only be changed in the NULL state", pspec->name);
+    return TRUE;
+  }
+
+  switch (prop_id) {
+    case PROP_ZERO_COPY:
+      settings->zero_copy = g_value_get_boolean (value);
+      break;
+    case PROP_SURFACE_WAIT_TIMEOUT:
+      settings->surface_wait_timeout = g_value_get_uint64 (value);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+  GST_OBJECT_UNLOCK (videodec);
+
+  return TRUE;
+}
+
+gboolean
+gst_nv_decoder_settings_get_property (GstNvDecoderSettings * settings,
+    GstElement * videodec, guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  g_return_val_if_fail (settings != NULL, FALSE);
+  g_return_val_if_fail (GST_IS_ELEMENT (videodec), FALSE);
+
+  GST_OBJECT_LOCK (videodec);
+  switch (prop_id) {
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, settings->zero_copy);
+      break;
+    case PROP_SURFACE_WAIT_TIMEOUT:
+      g_value_set_uint64 (value, settings->surface_wait_timeout);
+      break;
+    default:
+      GST_OBJECT_UNLOCK (videodec);
+      return FALSE;
+  }
+  GST_OBJECT_UNLOCK (videodec);
+
+  return TRUE;
+}
+
 gboolean
 gst_nv_decoder_handle_set_context (GstNvDecoder * decoder,
     GstElement * videodec, GstContext * context)
@@ -1346,6 +1665,46 @@ gst_nv_decoder_handle_set_context (GstNvDecoder * decoder,
   return FALSE;
 }
 
+/* Called from the sink event handler, before chaining up. A flush-start
+ * arrives without the stream lock, so this is what unblocks a decoding thread
+ * waiting for a surface in gst_nv_decoder_new_frame() */
+void
+gst_nv_decoder_handle_sink_event (GstNvDecoder * decoder, GstEvent * event)
+{
+  g_return_if_fail (GST_IS_NV_DECODER (decoder));
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      gst_nv_decoder_set_flushing (decoder, TRUE);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_nv_decoder_set_flushing (decoder, FALSE);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Called from the change_state handler, before chaining up, since
+ * deactivating the pads in PAUSED to READY needs the stream lock */
+void
+gst_nv_decoder_handle_change_state (GstNvDecoder * decoder,
+    GstStateChange transition)
+{
+  g_return_if_fail (GST_IS_NV_DECODER (decoder));
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_nv_decoder_set_flushing (decoder, FALSE);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_nv_decoder_set_flushing (decoder, TRUE);
+      break;
+    default:
+      break;
+  }
+}
+
 gboolean
 gst_nv_decoder_handle_context_query (GstNvDecoder * decoder,
     GstVideoDecoder * videodec, GstQuery * query)
@@ -23,6 +23,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/cuda/nvcodec/gstcudautils.h>
+#include <gst/cuda/nvcodec/gstcudasurfacepool.h>
 
 #include "gstcuvidloader.h"
 
@@ -32,6 +33,8 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (GstNvDecoder,
     gst_nv_decoder, GST, NV_DECODER, GstObject);
 
+typedef struct _GstNvDecoderInstance GstNvDecoderInstance;
+
 typedef struct _GstNvDecoderFrame
 {
   /* CUVIDPICPARAMS::CurrPicIdx */
@@ -43,12 +46,26 @@ typedef struct _GstNvDecoderFrame
 
   /*< private >*/
   GstNvDecoder *decoder;
+  GstCudaSurfacePool *pool;
+  GstNvDecoderInstance *instance;
 
   gint ref_count;
 } GstNvDecoderFrame;
 
+/* Values of the properties shared by the NVDEC decoder elements, see
+ * gst_nv_decoder_install_properties() */
+typedef struct _GstNvDecoderSettings
+{
+  gboolean zero_copy;
+  GstClockTime surface_wait_timeout;
+} GstNvDecoderSettings;
+
 GstNvDecoder * gst_nv_decoder_new (GstCudaContext * context);
 
+void           gst_nv_decoder_apply_settings (GstNvDecoder * decoder,
+                                              GstElement * videodec,
+                                              const GstNvDecoderSettings * settings);
+
 gboolean       gst_nv_decoder_is_configured (GstNvDecoder * decoder);
 
 gboolean       gst_nv_decoder_configure (GstNvDecoder * decoder,
@@ -58,7 +75,11 @@ gboolean       gst_nv_decoder_configure (GstNvDecoder * decoder,
                                          gint coded_height,
                                          guint pool_size);
 
-GstNvDecoderFrame * gst_nv_decoder_new_frame (GstNvDecoder * decoder);
+void           gst_nv_decoder_set_flushing (GstNvDecoder * decoder,
+                                            gboolean flushing);
+
+GstFlowReturn  gst_nv_decoder_new_frame (GstNvDecoder * decoder,
+                                         GstNvDecoderFrame ** frame);
 
 GstNvDecoderFrame * gst_nv_decoder_frame_ref (GstNvDecoderFrame * frame);
 
@@ -81,10 +102,32 @@ gboolean gst_nv_decoder_check_device_caps (CUcontext cuda_ctx,
 const gchar * gst_cuda_video_codec_to_string (cudaVideoCodec codec);
 
 /* helper methods */
+void     gst_nv_decoder_install_properties    (GObjectClass * object_class);
+
+void     gst_nv_decoder_settings_init         (GstNvDecoderSettings * settings);
+
+gboolean gst_nv_decoder_settings_set_property (GstNvDecoderSettings * settings,
+                                               GstElement * videodec,
+                                               guint prop_id,
+                                               const GValue * value,
+                                               GParamSpec * pspec);
+
+gboolean gst_nv_decoder_settings_get_property (GstNvDecoderSettings * settings,
+                                               GstElement * videodec,
+                                               guint prop_id,
+                                               GValue * value,
+                                               GParamSpec * pspec);
+
 gboolean gst_nv_decoder_handle_set_context   (GstNvDecoder * decoder,
                                               GstElement * videodec,
                                               GstContext * context);
 
+void     gst_nv_decoder_handle_sink_event     (GstNvDecoder * decoder,
+                                              GstEvent * event);
+
+void     gst_nv_decoder_handle_change_state   (GstNvDecoder * decoder,
+                                              GstStateChange transition);
+
 gboolean gst_nv_decoder_handle_context_query (GstNvDecoder * decoder,
                                               GstVideoDecoder * videodec,
                                               GstQuery * query);
@@ -27,6 +27,7 @@
 #include <gst/cuda/nvcodec/gstcudabufferpool.h>
 
 
+#include "gstnvabrenc.h"
 #include "gstnvh264enc.h"
 #include "gstnvh265enc.h"
 
@@ -839,6 +840,8 @@ gst_nv_enc_register (GstPlugin * plugin, GUID codec_id, const gchar * codec,
       if (gst_nvenc_cmp_guid (codec_id, NV_ENC_CODEC_H264_GUID)) {
         gst_nv_h264_enc_register (plugin, device_index, rank, sink_templ,
             src_templ, &device_caps);
+        gst_nv_abr_enc_register (plugin, device_index, GST_RANK_NONE,
+            src_templ);
       } else if (gst_nvenc_cmp_guid (codec_id, NV_ENC_CODEC_HEVC_GUID)) {
         gst_nv_h265_enc_register (plugin, device_index, rank, sink_templ,
             src_templ, &device_caps);
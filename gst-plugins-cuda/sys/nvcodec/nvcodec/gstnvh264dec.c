@@ -115,7 +115,7 @@ struct _GstNvH264Dec
 
   gboolean interlaced;
 
-  GArray *ref_list;
+  GstNvDecoderSettings settings;
 };
 
 struct _GstNvH264DecClass
@@ -127,8 +127,11 @@ struct _GstNvH264DecClass
 #define gst_nv_h264_dec_parent_class parent_class
 G_DEFINE_TYPE (GstNvH264Dec, gst_nv_h264_dec, GST_TYPE_H264_DECODER);
 
-static void gst_nv_h264_decoder_dispose (GObject * object);
 static void gst_nv_h264_decoder_finalize (GObject * object);
+static void gst_nv_h264_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nv_h264_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_nv_h264_dec_set_context (GstElement * element,
     GstContext * context);
 static gboolean gst_nv_h264_dec_open (GstVideoDecoder * decoder);
@@ -138,6 +141,10 @@ static gboolean gst_nv_h264_dec_decide_allocation (GstVideoDecoder *
     decoder, GstQuery * query);
 static gboolean gst_nv_h264_dec_src_query (GstVideoDecoder * decoder,
     GstQuery * query);
+static gboolean gst_nv_h264_dec_sink_event (GstVideoDecoder * decoder,
+    GstEvent * event);
+static GstStateChangeReturn gst_nv_h264_dec_change_state (GstElement * element,
+    GstStateChange transition);
 
 /* GstH264Decoder */
 static GstFlowReturn gst_nv_h264_dec_new_sequence (GstH264Decoder * decoder,
@@ -173,10 +180,16 @@ gst_nv_h264_dec_class_init (GstNvH264DecClass * klass)
    * Since: 1.18
    */
 
-  object_class->dispose = gst_nv_h264_decoder_dispose;
   object_class->finalize = gst_nv_h264_decoder_finalize;
 
+  object_class->set_property = gst_nv_h264_dec_set_property;
+  object_class->get_property = gst_nv_h264_dec_get_property;
+
+  gst_nv_decoder_install_properties (object_class);
+
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_nv_h264_dec_set_context);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_nv_h264_dec_change_state);
 
   decoder_class->open = GST_DEBUG_FUNCPTR (gst_nv_h264_dec_open);
   decoder_class->close = GST_DEBUG_FUNCPTR (gst_nv_h264_dec_close);
@@ -184,6 +197,7 @@ gst_nv_h264_dec_class_init (GstNvH264DecClass * klass)
   decoder_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_nv_h264_dec_decide_allocation);
   decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_nv_h264_dec_src_query);
+  decoder_class->sink_event = GST_DEBUG_FUNCPTR (gst_nv_h264_dec_sink_event);
 
   h264decoder_class->new_sequence =
       GST_DEBUG_FUNCPTR (gst_nv_h264_dec_new_sequence);
@@ -211,20 +225,29 @@ gst_nv_h264_dec_class_init (GstNvH264DecClass * klass)
 static void
 gst_nv_h264_dec_init (GstNvH264Dec * self)
 {
-  self->ref_list = g_array_sized_new (FALSE, TRUE,
-      sizeof (GstH264Picture *), 16);
-  g_array_set_clear_func (self->ref_list,
-      (GDestroyNotify) gst_h264_picture_clear);
+  gst_nv_decoder_settings_init (&self->settings);
 }
 
 static void
-gst_nv_h264_decoder_dispose (GObject * object)
+gst_nv_h264_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
 {
   GstNvH264Dec *self = GST_NV_H264_DEC (object);
 
-  g_clear_pointer (&self->ref_list, g_array_unref);
+  if (!gst_nv_decoder_settings_set_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_nv_h264_dec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvH264Dec *self = GST_NV_H264_DEC (object);
 
-  G_OBJECT_CLASS (parent_class)->dispose (object);
+  if (!gst_nv_decoder_settings_get_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 }
 
 static void
@@ -293,6 +316,9 @@ gst_nv_h264_dec_open (GstVideoDecoder * decoder)
     return FALSE;
   }
 
+  gst_nv_decoder_apply_settings (self->decoder, GST_ELEMENT (self),
+      &self->settings);
+
   gst_d3d11_h264_dec_reset (self);
 
   return TRUE;
@@ -362,6 +388,28 @@ gst_nv_h264_dec_src_query (GstVideoDecoder * decoder, GstQuery * query)
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_query (decoder, query);
 }
 
+static gboolean
+gst_nv_h264_dec_sink_event (GstVideoDecoder * decoder, GstEvent * event)
+{
+  GstNvH264Dec *self = GST_NV_H264_DEC (decoder);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_sink_event (self->decoder, event);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_event (decoder, event);
+}
+
+static GstStateChangeReturn
+gst_nv_h264_dec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNvH264Dec *self = GST_NV_H264_DEC (element);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_change_state (self->decoder, transition);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static GstFlowReturn
 gst_nv_h264_dec_new_sequence (GstH264Decoder * decoder, const GstH264SPS * sps,
     gint max_dpb_size)
@@ -471,11 +519,12 @@ gst_nv_h264_dec_new_picture (GstH264Decoder * decoder,
 {
   GstNvH264Dec *self = GST_NV_H264_DEC (decoder);
   GstNvDecoderFrame *nv_frame;
+  GstFlowReturn ret;
 
-  nv_frame = gst_nv_decoder_new_frame (self->decoder);
-  if (!nv_frame) {
-    GST_ERROR_OBJECT (self, "No available decoder frame");
-    return GST_FLOW_ERROR;
+  ret = gst_nv_decoder_new_frame (self->decoder, &nv_frame);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (self, "No decoder frame, %s", gst_flow_get_name (ret));
+    return ret;
   }
 
   GST_LOG_OBJECT (self,
@@ -728,8 +777,8 @@ gst_nv_h264_dec_start_picture (GstH264Decoder * decoder,
   const GstH264SPS *sps;
   const GstH264PPS *pps;
   GstNvDecoderFrame *frame;
-  GArray *ref_list = self->ref_list;
-  guint i, ref_frame_idx;
+  GstH264Picture *ref_list[GST_H264_DPB_MAX_NUM_PICTURES];
+  guint i, ref_frame_idx, num_refs;
 
   g_return_val_if_fail (slice_header->pps != NULL, FALSE);
   g_return_val_if_fail (slice_header->pps->sequence != NULL, FALSE);
@@ -790,24 +839,23 @@ gst_nv_h264_dec_start_picture (GstH264Decoder * decoder,
   gst_nv_h264_dec_picture_params_from_pps (self, pps, h264_params);
 
   ref_frame_idx = 0;
-  g_array_set_size (ref_list, 0);
 
   memset (&h264_params->dpb, 0, sizeof (h264_params->dpb));
-  gst_h264_dpb_get_pictures_short_term_ref (dpb, FALSE, FALSE, ref_list);
-  for (i = 0; ref_frame_idx < 16 && i < ref_list->len; i++) {
-    GstH264Picture *other = g_array_index (ref_list, GstH264Picture *, i);
-    gst_nv_h264_dec_fill_dpb (self, other, &h264_params->dpb[ref_frame_idx]);
+  num_refs = gst_h264_dpb_peek_pictures_short_term_ref (dpb, FALSE, FALSE,
+      ref_list, G_N_ELEMENTS (ref_list));
+  for (i = 0; ref_frame_idx < 16 && i < num_refs; i++) {
+    gst_nv_h264_dec_fill_dpb (self, ref_list[i],
+        &h264_params->dpb[ref_frame_idx]);
     ref_frame_idx++;
   }
-  g_array_set_size (ref_list, 0);
 
-  gst_h264_dpb_get_pictures_long_term_ref (dpb, FALSE, ref_list);
-  for (i = 0; ref_frame_idx < 16 && i < ref_list->len; i++) {
-    GstH264Picture *other = g_array_index (ref_list, GstH264Picture *, i);
-    gst_nv_h264_dec_fill_dpb (self, other, &h264_params->dpb[ref_frame_idx]);
+  num_refs = gst_h264_dpb_peek_pictures_long_term_ref (dpb, FALSE,
+      ref_list, G_N_ELEMENTS (ref_list));
+  for (i = 0; ref_frame_idx < 16 && i < num_refs; i++) {
+    gst_nv_h264_dec_fill_dpb (self, ref_list[i],
+        &h264_params->dpb[ref_frame_idx]);
     ref_frame_idx++;
   }
-  g_array_set_size (ref_list, 0);
 
   for (i = ref_frame_idx; i < 16; i++)
     h264_params->dpb[i].PicIdx = -1;
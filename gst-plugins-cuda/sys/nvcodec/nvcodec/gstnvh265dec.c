@@ -113,6 +113,8 @@ struct _GstNvH265Dec
   guint coded_width, coded_height;
   guint bitdepth;
   guint chroma_format_idc;
+
+  GstNvDecoderSettings settings;
 };
 
 struct _GstNvH265DecClass
@@ -125,6 +127,10 @@ struct _GstNvH265DecClass
 G_DEFINE_TYPE (GstNvH265Dec, gst_nv_h265_dec, GST_TYPE_H265_DECODER);
 
 static void gst_nv_h265_decoder_finalize (GObject * object);
+static void gst_nv_h265_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nv_h265_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_nv_h265_dec_set_context (GstElement * element,
     GstContext * context);
 static gboolean gst_nv_h265_dec_open (GstVideoDecoder * decoder);
@@ -134,6 +140,10 @@ static gboolean gst_nv_h265_dec_decide_allocation (GstVideoDecoder *
     decoder, GstQuery * query);
 static gboolean gst_nv_h265_dec_src_query (GstVideoDecoder * decoder,
     GstQuery * query);
+static gboolean gst_nv_h265_dec_sink_event (GstVideoDecoder * decoder,
+    GstEvent * event);
+static GstStateChangeReturn gst_nv_h265_dec_change_state (GstElement * element,
+    GstStateChange transition);
 
 /* GstH265Decoder */
 static GstFlowReturn gst_nv_h265_dec_new_sequence (GstH265Decoder * decoder,
@@ -166,7 +176,14 @@ gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
 
   object_class->finalize = gst_nv_h265_decoder_finalize;
 
+  object_class->set_property = gst_nv_h265_dec_set_property;
+  object_class->get_property = gst_nv_h265_dec_get_property;
+
+  gst_nv_decoder_install_properties (object_class);
+
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_nv_h265_dec_set_context);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_nv_h265_dec_change_state);
 
   decoder_class->open = GST_DEBUG_FUNCPTR (gst_nv_h265_dec_open);
   decoder_class->close = GST_DEBUG_FUNCPTR (gst_nv_h265_dec_close);
@@ -174,6 +191,7 @@ gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
   decoder_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_nv_h265_dec_decide_allocation);
   decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_nv_h265_dec_src_query);
+  decoder_class->sink_event = GST_DEBUG_FUNCPTR (gst_nv_h265_dec_sink_event);
 
   h265decoder_class->new_sequence =
       GST_DEBUG_FUNCPTR (gst_nv_h265_dec_new_sequence);
@@ -197,6 +215,29 @@ gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
 static void
 gst_nv_h265_dec_init (GstNvH265Dec * self)
 {
+  gst_nv_decoder_settings_init (&self->settings);
+}
+
+static void
+gst_nv_h265_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstNvH265Dec *self = GST_NV_H265_DEC (object);
+
+  if (!gst_nv_decoder_settings_set_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_nv_h265_dec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvH265Dec *self = GST_NV_H265_DEC (object);
+
+  if (!gst_nv_decoder_settings_get_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 }
 
 static void
@@ -251,6 +292,9 @@ gst_nv_h265_dec_open (GstVideoDecoder * decoder)
     return FALSE;
   }
 
+  gst_nv_decoder_apply_settings (self->decoder, GST_ELEMENT (self),
+      &self->settings);
+
   return TRUE;
 }
 
@@ -318,6 +362,28 @@ gst_nv_h265_dec_src_query (GstVideoDecoder * decoder, GstQuery * query)
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_query (decoder, query);
 }
 
+static gboolean
+gst_nv_h265_dec_sink_event (GstVideoDecoder * decoder, GstEvent * event)
+{
+  GstNvH265Dec *self = GST_NV_H265_DEC (decoder);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_sink_event (self->decoder, event);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_event (decoder, event);
+}
+
+static GstStateChangeReturn
+gst_nv_h265_dec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNvH265Dec *self = GST_NV_H265_DEC (element);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_change_state (self->decoder, transition);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static GstFlowReturn
 gst_nv_h265_dec_new_sequence (GstH265Decoder * decoder, const GstH265SPS * sps,
     gint max_dpb_size)
@@ -411,11 +477,12 @@ gst_nv_h265_dec_new_picture (GstH265Decoder * decoder,
 {
   GstNvH265Dec *self = GST_NV_H265_DEC (decoder);
   GstNvDecoderFrame *frame;
+  GstFlowReturn ret;
 
-  frame = gst_nv_decoder_new_frame (self->decoder);
-  if (!frame) {
-    GST_ERROR_OBJECT (self, "No available decoder frame");
-    return GST_FLOW_ERROR;
+  ret = gst_nv_decoder_new_frame (self->decoder, &frame);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (self, "No decoder frame, %s", gst_flow_get_name (ret));
+    return ret;
   }
 
   GST_LOG_OBJECT (self, "New decoder frame %p (index %d)", frame, frame->index);
@@ -655,7 +722,8 @@ gst_nv_h265_dec_start_picture (GstH265Decoder * decoder,
   const GstH265SPS *sps;
   const GstH265PPS *pps;
   GstNvDecoderFrame *frame;
-  GArray *dpb_array;
+  GstH265Picture *const *dpb_array;
+  guint num_pictures;
   gint num_ref_pic;
   gint i, j;
   const GstH265ScalingList *scaling_list = NULL;
@@ -748,11 +816,11 @@ gst_nv_h265_dec_start_picture (GstH265Decoder * decoder,
   h265_params->NumPocLtCurr = decoder->NumPocLtCurr;
   h265_params->CurrPicOrderCntVal = picture->pic_order_cnt;
 
-  dpb_array = gst_h265_dpb_get_pictures_all (dpb);
+  dpb_array = gst_h265_dpb_peek_pictures_all (dpb, &num_pictures);
   /* count only referenced frame */
   num_ref_pic = 0;
-  for (i = 0; i < dpb_array->len; i++) {
-    GstH265Picture *other = g_array_index (dpb_array, GstH265Picture *, i);
+  for (i = 0; i < num_pictures; i++) {
+    GstH265Picture *other = dpb_array[i];
     GstNvDecoderFrame *other_frame;
     gint picture_index = -1;
 
@@ -776,8 +844,6 @@ gst_nv_h265_dec_start_picture (GstH265Decoder * decoder,
     num_ref_pic++;
   }
 
-  g_array_unref (dpb_array);
-
   for (i = num_ref_pic; i < G_N_ELEMENTS (h265_params->RefPicIdx); i++)
     h265_params->RefPicIdx[i] = -1;
 
@@ -46,6 +46,8 @@ struct _GstNvVp8Dec
   CUVIDPICPARAMS params;
 
   guint width, height;
+
+  GstNvDecoderSettings settings;
 };
 
 struct _GstNvVp8DecClass
@@ -63,6 +65,10 @@ struct _GstNvVp8DecClass
  */
 G_DEFINE_TYPE (GstNvVp8Dec, gst_nv_vp8_dec, GST_TYPE_VP8_DECODER);
 
+static void gst_nv_vp8_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nv_vp8_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_nv_vp8_dec_set_context (GstElement * element,
     GstContext * context);
 static gboolean gst_nv_vp8_dec_open (GstVideoDecoder * decoder);
@@ -72,6 +78,10 @@ static gboolean gst_nv_vp8_dec_decide_allocation (GstVideoDecoder *
     decoder, GstQuery * query);
 static gboolean gst_nv_vp8_dec_src_query (GstVideoDecoder * decoder,
     GstQuery * query);
+static gboolean gst_nv_vp8_dec_sink_event (GstVideoDecoder * decoder,
+    GstEvent * event);
+static GstStateChangeReturn gst_nv_vp8_dec_change_state (GstElement * element,
+    GstStateChange transition);
 
 /* GstVp8Decoder */
 static GstFlowReturn gst_nv_vp8_dec_new_sequence (GstVp8Decoder * decoder,
@@ -88,11 +98,19 @@ static guint gst_nv_vp8_dec_get_preferred_output_delay (GstVp8Decoder * decoder,
 static void
 gst_nv_vp8_dec_class_init (GstNvVp8DecClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
   GstVp8DecoderClass *vp8decoder_class = GST_VP8_DECODER_CLASS (klass);
 
+  object_class->set_property = gst_nv_vp8_dec_set_property;
+  object_class->get_property = gst_nv_vp8_dec_get_property;
+
+  gst_nv_decoder_install_properties (object_class);
+
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_set_context);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_change_state);
 
   decoder_class->open = GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_open);
   decoder_class->close = GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_close);
@@ -100,6 +118,7 @@ gst_nv_vp8_dec_class_init (GstNvVp8DecClass * klass)
   decoder_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_decide_allocation);
   decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_src_query);
+  decoder_class->sink_event = GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_sink_event);
 
   vp8decoder_class->new_sequence =
       GST_DEBUG_FUNCPTR (gst_nv_vp8_dec_new_sequence);
@@ -121,6 +140,29 @@ gst_nv_vp8_dec_class_init (GstNvVp8DecClass * klass)
 static void
 gst_nv_vp8_dec_init (GstNvVp8Dec * self)
 {
+  gst_nv_decoder_settings_init (&self->settings);
+}
+
+static void
+gst_nv_vp8_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstNvVp8Dec *self = GST_NV_VP8_DEC (object);
+
+  if (!gst_nv_decoder_settings_set_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_nv_vp8_dec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvVp8Dec *self = GST_NV_VP8_DEC (object);
+
+  if (!gst_nv_decoder_settings_get_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 }
 
 static void
@@ -164,6 +206,9 @@ gst_nv_vp8_dec_open (GstVideoDecoder * decoder)
     return FALSE;
   }
 
+  gst_nv_decoder_apply_settings (self->decoder, GST_ELEMENT (self),
+      &self->settings);
+
   return TRUE;
 }
 
@@ -231,6 +276,28 @@ gst_nv_vp8_dec_src_query (GstVideoDecoder * decoder, GstQuery * query)
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_query (decoder, query);
 }
 
+static gboolean
+gst_nv_vp8_dec_sink_event (GstVideoDecoder * decoder, GstEvent * event)
+{
+  GstNvVp8Dec *self = GST_NV_VP8_DEC (decoder);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_sink_event (self->decoder, event);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_event (decoder, event);
+}
+
+static GstStateChangeReturn
+gst_nv_vp8_dec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNvVp8Dec *self = GST_NV_VP8_DEC (element);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_change_state (self->decoder, transition);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static GstFlowReturn
 gst_nv_vp8_dec_new_sequence (GstVp8Decoder * decoder,
     const GstVp8FrameHdr * frame_hdr)
@@ -289,11 +356,12 @@ gst_nv_vp8_dec_new_picture (GstVp8Decoder * decoder,
 {
   GstNvVp8Dec *self = GST_NV_VP8_DEC (decoder);
   GstNvDecoderFrame *nv_frame;
+  GstFlowReturn ret;
 
-  nv_frame = gst_nv_decoder_new_frame (self->decoder);
-  if (!nv_frame) {
-    GST_ERROR_OBJECT (self, "No available decoder frame");
-    return GST_FLOW_ERROR;
+  ret = gst_nv_decoder_new_frame (self->decoder, &nv_frame);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (self, "No decoder frame, %s", gst_flow_get_name (ret));
+    return ret;
   }
 
   GST_LOG_OBJECT (self,
@@ -47,6 +47,8 @@ struct _GstNvVp9Dec
 
   guint width, height;
   GstVP9Profile profile;
+
+  GstNvDecoderSettings settings;
 };
 
 struct _GstNvVp9DecClass
@@ -64,6 +66,10 @@ struct _GstNvVp9DecClass
  */
 G_DEFINE_TYPE (GstNvVp9Dec, gst_nv_vp9_dec, GST_TYPE_VP9_DECODER);
 
+static void gst_nv_vp9_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_nv_vp9_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void gst_nv_vp9_dec_set_context (GstElement * element,
     GstContext * context);
 static gboolean gst_nv_vp9_dec_open (GstVideoDecoder * decoder);
@@ -73,6 +79,10 @@ static gboolean gst_nv_vp9_dec_decide_allocation (GstVideoDecoder *
     decoder, GstQuery * query);
 static gboolean gst_nv_vp9_dec_src_query (GstVideoDecoder * decoder,
     GstQuery * query);
+static gboolean gst_nv_vp9_dec_sink_event (GstVideoDecoder * decoder,
+    GstEvent * event);
+static GstStateChangeReturn gst_nv_vp9_dec_change_state (GstElement * element,
+    GstStateChange transition);
 
 /* GstVp9Decoder */
 static GstFlowReturn gst_nv_vp9_dec_new_sequence (GstVp9Decoder * decoder,
@@ -91,11 +101,19 @@ static guint gst_nv_vp9_dec_get_preferred_output_delay (GstVp9Decoder * decoder,
 static void
 gst_nv_vp9_dec_class_init (GstNvVp9DecClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
   GstVp9DecoderClass *vp9decoder_class = GST_VP9_DECODER_CLASS (klass);
 
+  object_class->set_property = gst_nv_vp9_dec_set_property;
+  object_class->get_property = gst_nv_vp9_dec_get_property;
+
+  gst_nv_decoder_install_properties (object_class);
+
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_set_context);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_change_state);
 
   decoder_class->open = GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_open);
   decoder_class->close = GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_close);
@@ -103,6 +121,7 @@ gst_nv_vp9_dec_class_init (GstNvVp9DecClass * klass)
   decoder_class->decide_allocation =
       GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_decide_allocation);
   decoder_class->src_query = GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_src_query);
+  decoder_class->sink_event = GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_sink_event);
 
   vp9decoder_class->new_sequence =
       GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_new_sequence);
@@ -126,6 +145,29 @@ gst_nv_vp9_dec_class_init (GstNvVp9DecClass * klass)
 static void
 gst_nv_vp9_dec_init (GstNvVp9Dec * self)
 {
+  gst_nv_decoder_settings_init (&self->settings);
+}
+
+static void
+gst_nv_vp9_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstNvVp9Dec *self = GST_NV_VP9_DEC (object);
+
+  if (!gst_nv_decoder_settings_set_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+gst_nv_vp9_dec_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstNvVp9Dec *self = GST_NV_VP9_DEC (object);
+
+  if (!gst_nv_decoder_settings_get_property (&self->settings,
+          GST_ELEMENT (self), prop_id, value, pspec))
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 }
 
 static void
@@ -170,6 +212,9 @@ gst_nv_vp9_dec_open (GstVideoDecoder * decoder)
     return FALSE;
   }
 
+  gst_nv_decoder_apply_settings (self->decoder, GST_ELEMENT (self),
+      &self->settings);
+
   /* NVDEC doesn't support non-keyframe resolution change and it will result
    * in outputting broken frames */
   gst_vp9_decoder_set_non_keyframe_format_change_support (vp9dec, FALSE);
@@ -241,6 +286,28 @@ gst_nv_vp9_dec_src_query (GstVideoDecoder * decoder, GstQuery * query)
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_query (decoder, query);
 }
 
+static gboolean
+gst_nv_vp9_dec_sink_event (GstVideoDecoder * decoder, GstEvent * event)
+{
+  GstNvVp9Dec *self = GST_NV_VP9_DEC (decoder);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_sink_event (self->decoder, event);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_event (decoder, event);
+}
+
+static GstStateChangeReturn
+gst_nv_vp9_dec_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNvVp9Dec *self = GST_NV_VP9_DEC (element);
+
+  if (self->decoder)
+    gst_nv_decoder_handle_change_state (self->decoder, transition);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static GstFlowReturn
 gst_nv_vp9_dec_new_sequence (GstVp9Decoder * decoder,
     const GstVp9FrameHeader * frame_hdr)
@@ -296,11 +363,12 @@ gst_nv_vp9_dec_new_picture (GstVp9Decoder * decoder,
 {
   GstNvVp9Dec *self = GST_NV_VP9_DEC (decoder);
   GstNvDecoderFrame *nv_frame;
+  GstFlowReturn ret;
 
-  nv_frame = gst_nv_decoder_new_frame (self->decoder);
-  if (!nv_frame) {
-    GST_ERROR_OBJECT (self, "No available decoder frame");
-    return GST_FLOW_ERROR;
+  ret = gst_nv_decoder_new_frame (self->decoder, &nv_frame);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (self, "No decoder frame, %s", gst_flow_get_name (ret));
+    return ret;
   }
 
   GST_LOG_OBJECT (self,
@@ -40,7 +40,9 @@
 #include "nvcodec/gstcudaupload.h"
 #include "nvcodec/gstcudafilter.h"
 #include "cudaof/gstcudaof.h"
+#include "cudaofbatch/gstcudaofbatch.h"
 #include "cudafeatureextractor/gstcudafeatureextractor.h"
+#include "codecharness/gstcodecharness.h"
 
 GST_DEBUG_CATEGORY (gst_nvcodec_debug);
 GST_DEBUG_CATEGORY (gst_nvdec_debug);
@@ -71,6 +73,14 @@ plugin_init (GstPlugin * plugin)
   GST_DEBUG_CATEGORY_INIT (gst_nvenc_debug, "nvenc", 0, "nvenc");
   GST_DEBUG_CATEGORY_INIT (gst_nv_decoder_debug, "nvdecoder", 0, "nvdecoder");
 
+  /* the decoder harness only needs the codec base classes, register it even
+   * without any NVIDIA hardware */
+  gst_codec_harness_plugin_init (plugin);
+
+  /* the batched optical flow has a host backend for testing, it checks for
+   * CUDA itself once the CUDA backend is selected */
+  gst_cuda_of_batch_plugin_init (plugin);
+
   if (!gst_cuda_load_library ()) {
     GST_WARNING ("Failed to load cuda library");
     return TRUE;
@@ -0,0 +1,262 @@
+#include <vector>
+
+#include <gst/codecparsers/gstav1parser.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint8 default_tile_size_bytes = 2u;
+
+    GstAV1OBU MakeObu(GstAV1OBUType type, std::vector<guint8> &data, gsize size)
+    {
+        GstAV1OBU obu = {};
+
+        obu.obu_type = type;
+        obu.data = data.data();
+        obu.obu_size = static_cast<guint32>(size);
+
+        return obu;
+    }
+
+    /*
+     * Sets up the tile info a frame header would leave in the parser for a
+     * grid of tile_cols x tile_rows tiles, so that tile groups can be parsed
+     * without a sequence header and a frame header.
+     */
+    void SetTileInfo(GstAV1Parser *parser, guint8 tile_cols, guint8 tile_rows, guint8 tile_cols_log2,
+                     guint8 tile_rows_log2)
+    {
+        parser->state.seen_frame_header = 1;
+        parser->state.tile_cols = tile_cols;
+        parser->state.tile_rows = tile_rows;
+        parser->state.tile_cols_log2 = tile_cols_log2;
+        parser->state.tile_rows_log2 = tile_rows_log2;
+        parser->state.tile_size_bytes = default_tile_size_bytes;
+
+        for(guint idx = 0u; idx <= tile_cols && idx <= GST_AV1_MAX_TILE_COLS; idx++)
+        {
+            parser->state.mi_col_starts[idx] = idx * 16u;
+        }
+
+        for(guint idx = 0u; idx <= tile_rows && idx <= GST_AV1_MAX_TILE_ROWS; idx++)
+        {
+            parser->state.mi_row_starts[idx] = idx * 16u;
+        }
+    }
+
+    void AppendTile(std::vector<guint8> &data, guint size, bool with_size)
+    {
+        if(with_size)
+        {
+            /* le(TileSizeBytes) of tile_size_minus_1 */
+            data.push_back(static_cast<guint8>((size - 1u) & 0xff));
+            data.push_back(static_cast<guint8>((size - 1u) >> 8));
+        }
+
+        data.insert(data.end(), size, static_cast<guint8>(size));
+    }
+
+    void AppendTileListEntry(std::vector<guint8> &data, guint8 anchor_frame_idx, guint8 row, guint8 col, guint size)
+    {
+        data.push_back(anchor_frame_idx);
+        data.push_back(row);
+        data.push_back(col);
+        data.push_back(static_cast<guint8>((size - 1u) >> 8));
+        data.push_back(static_cast<guint8>((size - 1u) & 0xff));
+        data.insert(data.end(), size, static_cast<guint8>(size));
+    }
+}
+
+TEST(AV1ParserTest, TestTileGroupWholeFrame)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileGroupOBU tile_group;
+
+    SetTileInfo(parser, 2u, 2u, 1u, 1u);
+
+    /* tile_start_and_end_present_flag = 0, then byte alignment */
+    std::vector<guint8> data = {0x00};
+
+    AppendTile(data, 3u, true);
+    AppendTile(data, 5u, true);
+    AppendTile(data, 1u, true);
+    /* The size of the last tile is implied by the size of the OBU */
+    AppendTile(data, 4u, false);
+
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_GROUP, data, data.size());
+
+    ASSERT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_OK);
+    EXPECT_EQ(tile_group.num_tiles, 4u);
+    EXPECT_EQ(tile_group.tg_start, 0u);
+    EXPECT_EQ(tile_group.tg_end, 3u);
+
+    const guint32 expected_offsets[] = {3u, 8u, 15u, 16u};
+    const guint32 expected_sizes[] = {3u, 5u, 1u, 4u};
+
+    for(guint idx = 0u; idx < 4u; idx++)
+    {
+        EXPECT_EQ(tile_group.entry[idx].tile_offset, expected_offsets[idx]) << "Tile " << idx;
+        EXPECT_EQ(tile_group.entry[idx].tile_size, expected_sizes[idx]) << "Tile " << idx;
+        EXPECT_EQ(tile_group.entry[idx].tile_row, idx / 2u) << "Tile " << idx;
+        EXPECT_EQ(tile_group.entry[idx].tile_col, idx % 2u) << "Tile " << idx;
+        EXPECT_EQ(tile_group.entry[idx].mi_col_start, (idx % 2u) * 16u) << "Tile " << idx;
+        EXPECT_EQ(tile_group.entry[idx].mi_row_end, (idx / 2u + 1u) * 16u) << "Tile " << idx;
+    }
+
+    /* The last tile group of the frame was parsed */
+    EXPECT_EQ(parser->state.seen_frame_header, 0u);
+
+    gst_av1_parser_free(parser);
+}
+
+TEST(AV1ParserTest, TestTileGroupSubset)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileGroupOBU tile_group;
+
+    SetTileInfo(parser, 3u, 1u, 2u, 0u);
+
+    /* tile_start_and_end_present_flag = 1, tg_start = 1, tg_end = 2 */
+    std::vector<guint8> data = {0xb0};
+
+    AppendTile(data, 6u, true);
+    AppendTile(data, 2u, false);
+
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_GROUP, data, data.size());
+
+    ASSERT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_OK);
+    EXPECT_TRUE(tile_group.tile_start_and_end_present_flag);
+    EXPECT_EQ(tile_group.tg_start, 1u);
+    EXPECT_EQ(tile_group.tg_end, 2u);
+    EXPECT_EQ(tile_group.entry[1].tile_offset, 3u);
+    EXPECT_EQ(tile_group.entry[1].tile_size, 6u);
+    EXPECT_EQ(tile_group.entry[1].tile_col, 1u);
+    EXPECT_EQ(tile_group.entry[2].tile_offset, 9u);
+    EXPECT_EQ(tile_group.entry[2].tile_size, 2u);
+    EXPECT_EQ(tile_group.entry[2].tile_col, 2u);
+
+    gst_av1_parser_free(parser);
+}
+
+TEST(AV1ParserTest, TestTileGroupTruncated)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileGroupOBU tile_group;
+    std::vector<guint8> data = {0x00};
+
+    AppendTile(data, 3u, true);
+    AppendTile(data, 4u, false);
+
+    /* Cut in the middle of the tile size, and in the middle of the tile */
+    for(gsize size : {gsize(0u), gsize(2u), gsize(5u)})
+    {
+        SetTileInfo(parser, 2u, 1u, 1u, 0u);
+
+        GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_GROUP, data, size);
+
+        EXPECT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_NO_MORE_DATA)
+            << "Size " << size;
+    }
+
+    /* A tile size running past the end of the OBU */
+    std::vector<guint8> bad_size(data);
+
+    bad_size[1] = 0xff;
+    SetTileInfo(parser, 2u, 1u, 1u, 0u);
+
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_GROUP, bad_size, bad_size.size());
+
+    EXPECT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_NO_MORE_DATA);
+
+    gst_av1_parser_free(parser);
+}
+
+TEST(AV1ParserTest, TestTileGroupBounds)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileGroupOBU tile_group;
+
+    /* tg_end = 3 is past the last of the 3 tiles */
+    std::vector<guint8> past_end = {0x98, 0x00, 0x00, 0x00};
+
+    SetTileInfo(parser, 3u, 1u, 2u, 0u);
+
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_GROUP, past_end, past_end.size());
+
+    EXPECT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_BITSTREAM_ERROR);
+
+    /* More tiles than GST_AV1_MAX_TILE_COUNT, and no tile at all */
+    std::vector<guint8> data = {0x00, 0x00};
+
+    obu = MakeObu(GST_AV1_OBU_TILE_GROUP, data, data.size());
+
+    SetTileInfo(parser, GST_AV1_MAX_TILE_COLS, GST_AV1_MAX_TILE_ROWS, 6u, 6u);
+    EXPECT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_BITSTREAM_ERROR);
+
+    SetTileInfo(parser, 0u, 1u, 0u, 0u);
+    EXPECT_EQ(gst_av1_parser_parse_tile_group_obu(parser, &obu, &tile_group), GST_AV1_PARSER_BITSTREAM_ERROR);
+
+    gst_av1_parser_free(parser);
+}
+
+TEST(AV1ParserTest, TestTileList)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileListOBU tile_list;
+
+    /* 2x1 output frame of 2 tiles */
+    std::vector<guint8> data = {0x01, 0x00, 0x00, 0x01};
+
+    AppendTileListEntry(data, 0u, 0u, 1u, 3u);
+    AppendTileListEntry(data, 1u, 2u, 0u, 1u);
+
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_LIST, data, data.size());
+
+    ASSERT_EQ(gst_av1_parser_parse_tile_list_obu(parser, &obu, &tile_list), GST_AV1_PARSER_OK);
+    EXPECT_EQ(tile_list.output_frame_width_in_tiles_minus_1, 1u);
+    EXPECT_EQ(tile_list.output_frame_height_in_tiles_minus_1, 0u);
+    EXPECT_EQ(tile_list.tile_count_minus_1, 1u);
+
+    EXPECT_EQ(tile_list.entry[0].anchor_frame_idx, 0u);
+    EXPECT_EQ(tile_list.entry[0].anchor_tile_row, 0u);
+    EXPECT_EQ(tile_list.entry[0].anchor_tile_col, 1u);
+    EXPECT_EQ(tile_list.entry[0].tile_data_size_minus_1, 2u);
+    EXPECT_EQ(tile_list.entry[0].coded_tile_data, data.data() + 9);
+
+    EXPECT_EQ(tile_list.entry[1].anchor_frame_idx, 1u);
+    EXPECT_EQ(tile_list.entry[1].anchor_tile_row, 2u);
+    EXPECT_EQ(tile_list.entry[1].anchor_tile_col, 0u);
+    EXPECT_EQ(tile_list.entry[1].tile_data_size_minus_1, 0u);
+    EXPECT_EQ(tile_list.entry[1].coded_tile_data, data.data() + 17);
+
+    gst_av1_parser_free(parser);
+}
+
+TEST(AV1ParserTest, TestTileListTruncated)
+{
+    GstAV1Parser *parser = gst_av1_parser_new();
+    GstAV1TileListOBU tile_list;
+    std::vector<guint8> data = {0x01, 0x00, 0x00, 0x01};
+
+    AppendTileListEntry(data, 0u, 0u, 1u, 3u);
+    AppendTileListEntry(data, 1u, 2u, 0u, 1u);
+
+    /* Cut in the header, in an entry, and in the coded tile data */
+    for(gsize size : {gsize(0u), gsize(3u), gsize(6u), gsize(11u), gsize(data.size() - 1u)})
+    {
+        GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_LIST, data, size);
+
+        EXPECT_EQ(gst_av1_parser_parse_tile_list_obu(parser, &obu, &tile_list), GST_AV1_PARSER_NO_MORE_DATA)
+            << "Size " << size;
+    }
+
+    /* More tiles than GST_AV1_MAX_TILE_COUNT */
+    std::vector<guint8> too_many = {0x00, 0x00, static_cast<guint8>(GST_AV1_MAX_TILE_COUNT >> 8),
+                                    static_cast<guint8>(GST_AV1_MAX_TILE_COUNT & 0xff)};
+    GstAV1OBU obu = MakeObu(GST_AV1_OBU_TILE_LIST, too_many, too_many.size());
+
+    EXPECT_EQ(gst_av1_parser_parse_tile_list_obu(parser, &obu, &tile_list), GST_AV1_PARSER_BITSTREAM_ERROR);
+
+    gst_av1_parser_free(parser);
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <gst/cuda/featureextractor/gstalgorithmfeatureswindow.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeaturesstats.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr gsize default_length = 7u;
+    constexpr guint default_number_of_frames = 200u;
+
+    /* The statistics of the last frames, calculated from scratch */
+    struct NaiveWindow
+    {
+        guint window_size;
+        std::deque<std::vector<gfloat>> frames;
+
+        explicit NaiveWindow(guint window_size) : window_size(window_size) {}
+
+        void Push(const std::vector<gfloat> &features)
+        {
+            this->frames.push_back(features);
+
+            if(this->frames.size() > this->window_size)
+            {
+                this->frames.pop_front();
+            }
+        }
+
+        void Statistics(gsize idx, gdouble &mean, gfloat &max, gdouble &variance) const
+        {
+            gdouble sum = 0.0;
+
+            max = -INFINITY;
+
+            for(const std::vector<gfloat> &frame : this->frames)
+            {
+                sum += frame[idx];
+                max = std::max(max, frame[idx]);
+            }
+
+            mean = sum / this->frames.size();
+            variance = 0.0;
+
+            for(const std::vector<gfloat> &frame : this->frames)
+            {
+                variance += (frame[idx] - mean) * (frame[idx] - mean);
+            }
+
+            variance /= this->frames.size();
+        }
+    };
+
+    /*
+     * Pushes random frames into both windows, and compares the statistics
+     * after every frame. The features are rounded to quarters so that the
+     * maximum is often tied between frames.
+     */
+    void ExpectMatchesNaiveWindow(guint window_size, guint renormalisation_interval, gfloat offset, gdouble tolerance)
+    {
+        std::mt19937 generator(window_size * 31u + renormalisation_interval);
+        std::uniform_int_distribution<gint> distribution(-40, 40);
+        GstAlgorithmFeaturesWindow *window
+            = gst_algorithm_features_window_new(window_size, default_length, renormalisation_interval);
+        NaiveWindow naive_window(window_size);
+        std::vector<gfloat> features(default_length);
+        std::vector<gfloat> mean(default_length);
+        std::vector<gfloat> max(default_length);
+        std::vector<gfloat> variance(default_length);
+
+        for(guint frame = 0u; frame < default_number_of_frames; frame++)
+        {
+            for(gfloat &feature : features)
+            {
+                feature = offset + distribution(generator) / 4.0f;
+            }
+
+            gst_algorithm_features_window_push(window, features.data());
+            naive_window.Push(features);
+
+            ASSERT_EQ(gst_algorithm_features_window_get_number_of_frames(window), naive_window.frames.size());
+
+            gst_algorithm_features_window_get_statistics(window, mean.data(), max.data(), variance.data());
+
+            for(gsize idx = 0u; idx < default_length; idx++)
+            {
+                gdouble expected_mean = 0.0;
+                gfloat expected_max = 0.0f;
+                gdouble expected_variance = 0.0;
+
+                naive_window.Statistics(idx, expected_mean, expected_max, expected_variance);
+
+                ASSERT_NEAR(mean[idx], expected_mean, tolerance * std::max(1.0, std::fabs(expected_mean)))
+                    << "Frame " << frame << ", feature " << idx;
+                ASSERT_EQ(max[idx], expected_max) << "Frame " << frame << ", feature " << idx;
+                ASSERT_NEAR(variance[idx], expected_variance, tolerance * std::max(1.0, expected_variance))
+                    << "Frame " << frame << ", feature " << idx;
+            }
+        }
+
+        gst_algorithm_features_window_free(window);
+    }
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestEmpty)
+{
+    GstAlgorithmFeaturesWindow *window = gst_algorithm_features_window_new(4u, default_length, 0u);
+    std::vector<gfloat> mean(default_length, -1.0f);
+    std::vector<gfloat> max(default_length, -1.0f);
+    std::vector<gfloat> variance(default_length, -1.0f);
+
+    EXPECT_EQ(gst_algorithm_features_window_get_window_size(window), 4u);
+    EXPECT_EQ(gst_algorithm_features_window_get_length(window), default_length);
+    EXPECT_EQ(gst_algorithm_features_window_get_number_of_frames(window), 0u);
+
+    gst_algorithm_features_window_get_statistics(window, mean.data(), max.data(), variance.data());
+
+    for(gsize idx = 0u; idx < default_length; idx++)
+    {
+        EXPECT_EQ(mean[idx], 0.0f);
+        EXPECT_EQ(max[idx], 0.0f);
+        EXPECT_EQ(variance[idx], 0.0f);
+    }
+
+    gst_algorithm_features_window_free(window);
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestMatchesNaiveWindow)
+{
+    for(guint window_size : {1u, 2u, 5u, 16u})
+    {
+        ExpectMatchesNaiveWindow(window_size, 0u, 0.0f, 1e-5);
+    }
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestRenormalisationInterval)
+{
+    /* Renormalising more and less often than the window size */
+    for(guint renormalisation_interval : {1u, 3u, 50u})
+    {
+        ExpectMatchesNaiveWindow(8u, renormalisation_interval, 0.0f, 1e-5);
+    }
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestRenormalisationBoundsDrift)
+{
+    /*
+     * With a large offset the variance is a small difference between two
+     * large running sums, which is where their precision matters most.
+     */
+    ExpectMatchesNaiveWindow(10u, 0u, 4096.0f, 1e-3);
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestMaxLeavesWindow)
+{
+    GstAlgorithmFeaturesWindow *window = gst_algorithm_features_window_new(3u, 1u, 0u);
+    const gfloat sequence[] = {9.0f, 1.0f, 5.0f, 2.0f, 2.0f, 0.0f, 0.0f};
+    const gfloat expected_maxes[] = {9.0f, 9.0f, 9.0f, 5.0f, 5.0f, 2.0f, 2.0f};
+    gfloat mean = 0.0f;
+    gfloat max = 0.0f;
+    gfloat variance = 0.0f;
+
+    for(gsize frame = 0u; frame < G_N_ELEMENTS(sequence); frame++)
+    {
+        gst_algorithm_features_window_push(window, &sequence[frame]);
+        gst_algorithm_features_window_get_statistics(window, &mean, &max, &variance);
+
+        EXPECT_EQ(max, expected_maxes[frame]) << "Frame " << frame;
+    }
+
+    /* The last three frames are 2, 0 and 0 */
+    EXPECT_FLOAT_EQ(mean, 2.0f / 3.0f);
+    EXPECT_FLOAT_EQ(variance, 8.0f / 9.0f);
+
+    gst_algorithm_features_window_free(window);
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestReset)
+{
+    GstAlgorithmFeaturesWindow *window = gst_algorithm_features_window_new(4u, 1u, 0u);
+    const gfloat large_feature = 100.0f;
+    const gfloat small_feature = 1.0f;
+    gfloat mean = 0.0f;
+    gfloat max = 0.0f;
+    gfloat variance = 0.0f;
+
+    gst_algorithm_features_window_push(window, &large_feature);
+    gst_algorithm_features_window_push(window, &large_feature);
+    gst_algorithm_features_window_reset(window);
+
+    EXPECT_EQ(gst_algorithm_features_window_get_number_of_frames(window), 0u);
+
+    gst_algorithm_features_window_push(window, &small_feature);
+    gst_algorithm_features_window_get_statistics(window, &mean, &max, &variance);
+
+    EXPECT_EQ(gst_algorithm_features_window_get_number_of_frames(window), 1u);
+    EXPECT_FLOAT_EQ(mean, small_feature);
+    EXPECT_FLOAT_EQ(max, small_feature);
+    EXPECT_FLOAT_EQ(variance, 0.0f);
+
+    gst_algorithm_features_window_free(window);
+}
+
+TEST(AlgorithmFeaturesWindowTest, TestStatsMetaLayout)
+{
+    const guint feature_mask = ALGORITHM_FEATURE_FLAG_COUNT | ALGORITHM_FEATURE_FLAG_Y0_TO_Y1_MAGNITUDE;
+    const guint length = 40u;
+    const gsize block_length = 3u * length;
+    GstAlgorithmFeaturesPool *pool
+        = gst_algorithm_features_pool_new(gst_meta_algorithm_features_stats_get_slab_size(20u, 20u, 10u, feature_mask));
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaAlgorithmFeaturesStats *meta = GST_META_ALGORITHM_FEATURES_STATS_ADD(buffer);
+
+    EXPECT_EQ(meta->features.mean, nullptr);
+    ASSERT_TRUE(gst_meta_algorithm_features_stats_set_layout(meta, pool, 20u, 20u, 10u, feature_mask));
+
+    EXPECT_EQ(meta->length, length);
+    EXPECT_EQ(meta->feature_mask, feature_mask);
+
+    /* One block per statistic, each laid out like the features metadata */
+    EXPECT_EQ(meta->features.mean, static_cast<gfloat *>(meta->slab));
+    EXPECT_EQ(meta->features.max, meta->features.mean + block_length);
+    EXPECT_EQ(meta->features.variance, meta->features.max + block_length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_COUNT].mean, meta->features.mean + length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_COUNT].max, meta->features.max + length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE].variance,
+              meta->features.variance + 2u * length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_PIXELS].mean, nullptr);
+
+    meta->window_size = 30u;
+    meta->number_of_frames = 12u;
+    meta->features.variance[length - 1u] = 5.0f;
+
+    GstBuffer *copy = gst_buffer_copy(buffer);
+    GstMetaAlgorithmFeaturesStats *copy_meta = GST_META_ALGORITHM_FEATURES_STATS_GET(copy);
+
+    ASSERT_NE(copy_meta, nullptr);
+    EXPECT_NE(copy_meta->slab, meta->slab);
+    EXPECT_EQ(copy_meta->window_size, 30u);
+    EXPECT_EQ(copy_meta->number_of_frames, 12u);
+    EXPECT_EQ(copy_meta->features.variance[length - 1u], 5.0f);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(copy);
+    gst_algorithm_features_pool_unref(pool);
+}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr gfloat default_threshold = 2.25f;
+
+    /* A random optical flow matrix with padding at the end of each row */
+    struct Flow
+    {
+        guint width = 0u;
+        guint height = 0u;
+        gsize elem_size = 0u;
+        gsize stride = 0u;
+        std::vector<guint8> data;
+
+        Flow(guint width, guint height, gsize elem_size, std::mt19937 &generator)
+            : width(width), height(height), elem_size(elem_size), stride(width * elem_size + 16u),
+              data(stride * height)
+        {
+            std::uniform_real_distribution<gfloat> distribution(-6.0f, 6.0f);
+
+            for(guint row = 0u; row < height; row++)
+            {
+                for(guint column = 0u; column < 2u * width; column++)
+                {
+                    gfloat value = distribution(generator);
+
+                    if(elem_size == 2u * sizeof(gint16))
+                    {
+                        this->Row<gint16>(row)[column] = static_cast<gint16>(value * (1 << 5));
+                    }
+                    else
+                    {
+                        this->Row<gfloat>(row)[column] = value;
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        T *Row(guint row)
+        {
+            return reinterpret_cast<T *>(this->data.data() + this->stride * row);
+        }
+
+        void Vector(guint x, guint y, gfloat &flow_x, gfloat &flow_y)
+        {
+            if(this->elem_size == 2u * sizeof(gint16))
+            {
+                flow_x = this->Row<gint16>(y)[2u * x] / static_cast<gfloat>(1 << 5);
+                flow_y = this->Row<gint16>(y)[2u * x + 1u] / static_cast<gfloat>(1 << 5);
+            }
+            else
+            {
+                flow_x = this->Row<gfloat>(y)[2u * x];
+                flow_y = this->Row<gfloat>(y)[2u * x + 1u];
+            }
+        }
+    };
+
+    struct Layout
+    {
+        guint grid_size;
+        guint frame_width;
+        guint frame_height;
+        guint cell_width;
+        guint cell_height;
+        guint features_matrix_width;
+        guint features_matrix_height;
+    };
+
+    /* The features of every pixel, one at a time, as the CUDA kernel does */
+    std::vector<gfloat> ReferenceFeatures(Flow &flow, const Layout &layout, gfloat threshold, guint feature_mask)
+    {
+        gsize plane_size = static_cast<gsize>(layout.features_matrix_width) * layout.features_matrix_height;
+        std::vector<gfloat> features(plane_size * gst_algorithm_features_get_number_of_planes(feature_mask), 0.0f);
+
+        for(guint y = 0u; y < layout.frame_height; y++)
+        {
+            for(guint x = 0u; x < layout.frame_width; x++)
+            {
+                guint vector_x = x / layout.grid_size;
+                guint vector_y = y / layout.grid_size;
+
+                if(vector_x >= flow.width || vector_y >= flow.height)
+                {
+                    continue;
+                }
+
+                gfloat flow_x = 0.0f;
+                gfloat flow_y = 0.0f;
+                gfloat pixel_features[ALGORITHM_NUMBER_OF_FEATURES] = {};
+                bool x_qualifies = false;
+                bool y_qualifies = false;
+
+                flow.Vector(vector_x, vector_y, flow_x, flow_y);
+                x_qualifies = flow_x * flow_x > threshold;
+                y_qualifies = flow_y * flow_y > threshold;
+
+                pixel_features[ALGORITHM_FEATURE_COUNT] = (x_qualifies || y_qualifies) ? 1.0f : 0.0f;
+                pixel_features[ALGORITHM_FEATURE_PIXELS] = 1.0f;
+
+                if(x_qualifies)
+                {
+                    pixel_features[flow_x >= 0.0f ? ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE
+                                                  : ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE]
+                        = std::abs(flow_x);
+                }
+
+                if(y_qualifies)
+                {
+                    pixel_features[flow_y >= 0.0f ? ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE
+                                                  : ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE]
+                        = std::abs(flow_y);
+                }
+
+                gsize cell = static_cast<gsize>(std::min(y / layout.cell_height, layout.features_matrix_height - 1u))
+                                 * layout.features_matrix_width
+                             + std::min(x / layout.cell_width, layout.features_matrix_width - 1u);
+                gsize plane = 1u;
+
+                features[cell] += pixel_features[ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE]
+                                  + pixel_features[ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE]
+                                  + pixel_features[ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE]
+                                  + pixel_features[ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE];
+
+                for(guint feature = 0u; feature < ALGORITHM_NUMBER_OF_FEATURES; feature++)
+                {
+                    if(feature_mask & (1u << feature))
+                    {
+                        features[plane * plane_size + cell] += pixel_features[feature];
+                        plane++;
+                    }
+                }
+            }
+        }
+
+        return features;
+    }
+
+    std::vector<gfloat> HostFeatures(Flow &flow, const Layout &layout, gfloat threshold, guint feature_mask)
+    {
+        gsize plane_size = static_cast<gsize>(layout.features_matrix_width) * layout.features_matrix_height;
+        std::vector<gfloat> features(plane_size * gst_algorithm_features_get_number_of_planes(feature_mask), -1.0f);
+
+        gst_algorithm_features_extract(flow.data.data(),
+                                       flow.stride,
+                                       flow.elem_size,
+                                       flow.width,
+                                       flow.height,
+                                       layout.grid_size,
+                                       layout.frame_width,
+                                       layout.frame_height,
+                                       layout.cell_width,
+                                       layout.cell_height,
+                                       layout.features_matrix_width,
+                                       layout.features_matrix_height,
+                                       threshold,
+                                       feature_mask,
+                                       features.data());
+
+        return features;
+    }
+}
+
+TEST(AlgorithmFeaturesTest, TestFlagNicks)
+{
+    GFlagsClass *klass = G_FLAGS_CLASS(g_type_class_ref(GST_TYPE_ALGORITHM_FEATURE_FLAGS));
+
+    for(const char *nick : {"count", "pixels", "x0-to-x1-magnitude", "x1-to-x0-magnitude", "y0-to-y1-magnitude", "y1-to-y0-magnitude"})
+    {
+        ASSERT_NE(g_flags_get_value_by_nick(klass, nick), nullptr) << nick;
+    }
+
+    EXPECT_EQ(klass->mask, static_cast<guint>(ALGORITHM_FEATURE_FLAGS_ALL));
+    g_type_class_unref(klass);
+}
+
+TEST(AlgorithmFeaturesTest, TestNumberOfPlanes)
+{
+    EXPECT_EQ(gst_algorithm_features_get_number_of_planes(0u), 1u);
+    EXPECT_EQ(gst_algorithm_features_get_number_of_planes(ALGORITHM_FEATURE_FLAG_PIXELS), 2u);
+    EXPECT_EQ(gst_algorithm_features_get_number_of_planes(ALGORITHM_FEATURE_FLAGS_ALL), 7u);
+    EXPECT_STREQ(gst_algorithm_feature_get_name(ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE), "Y1-To-Y0-Magnitude");
+}
+
+TEST(AlgorithmFeaturesTest, TestDirections)
+{
+    std::mt19937 generator(1u);
+    Flow flow(2u, 1u, 2u * sizeof(gfloat), generator);
+    Layout layout = {1u, 2u, 1u, 1u, 1u, 2u, 1u};
+
+    /* One vector moving right and up, one moving left below the threshold */
+    flow.Row<gfloat>(0u)[0] = 2.0f;
+    flow.Row<gfloat>(0u)[1] = -3.0f;
+    flow.Row<gfloat>(0u)[2] = -1.0f;
+    flow.Row<gfloat>(0u)[3] = 0.5f;
+
+    std::vector<gfloat> features = HostFeatures(flow, layout, default_threshold, ALGORITHM_FEATURE_FLAGS_ALL);
+
+    EXPECT_FLOAT_EQ(features[0], 5.0f);
+    EXPECT_FLOAT_EQ(features[1], 0.0f);
+    /* Count, Pixels, X0ToX1, X1ToX0, Y0ToY1, Y1ToY0 of the first cell */
+    EXPECT_FLOAT_EQ(features[2 + 0], 1.0f);
+    EXPECT_FLOAT_EQ(features[4 + 0], 1.0f);
+    EXPECT_FLOAT_EQ(features[6 + 0], 2.0f);
+    EXPECT_FLOAT_EQ(features[8 + 0], 0.0f);
+    EXPECT_FLOAT_EQ(features[10 + 0], 0.0f);
+    EXPECT_FLOAT_EQ(features[12 + 0], 3.0f);
+    /* The second cell is covered, but does not move */
+    EXPECT_FLOAT_EQ(features[2 + 1], 0.0f);
+    EXPECT_FLOAT_EQ(features[4 + 1], 1.0f);
+}
+
+TEST(AlgorithmFeaturesTest, TestFeatureMaskPacksPlanes)
+{
+    std::mt19937 generator(2u);
+    Flow flow(16u, 9u, 2u * sizeof(gfloat), generator);
+    Layout layout = {4u, 61u, 33u, 16u, 9u, 4u, 4u};
+
+    std::vector<gfloat> all = HostFeatures(flow, layout, default_threshold, ALGORITHM_FEATURE_FLAGS_ALL);
+    std::vector<gfloat> some
+        = HostFeatures(flow, layout, default_threshold, ALGORITHM_FEATURE_FLAG_PIXELS | ALGORITHM_FEATURE_FLAG_Y0_TO_Y1_MAGNITUDE);
+
+    ASSERT_EQ(some.size(), 3u * 16u);
+
+    for(guint cell = 0u; cell < 16u; cell++)
+    {
+        EXPECT_FLOAT_EQ(some[cell], all[cell]) << "cell " << cell;
+        EXPECT_FLOAT_EQ(some[16u + cell], all[(1u + ALGORITHM_FEATURE_PIXELS) * 16u + cell]) << "cell " << cell;
+        EXPECT_FLOAT_EQ(some[32u + cell], all[(1u + ALGORITHM_FEATURE_Y0_TO_Y1_MAGNITUDE) * 16u + cell]) << "cell " << cell;
+    }
+}
+
+TEST(AlgorithmFeaturesTest, TestAggregate)
+{
+    const gfloat features[] = {1.0f, 5.0f, 2.0f, 0.0f, 3.0f, 4.0f, 9.0f};
+    gfloat aggregates[3] = {-1.0f, -1.0f, -1.0f};
+
+    ASSERT_EQ(gst_algorithm_features_get_number_of_aggregates(7u, 3u), 3u);
+    gst_algorithm_features_aggregate(features, 7u, 3u, aggregates);
+
+    EXPECT_FLOAT_EQ(aggregates[0], 5.0f);
+    EXPECT_FLOAT_EQ(aggregates[1], 4.0f);
+    /* The last aggregate only holds the remaining feature */
+    EXPECT_FLOAT_EQ(aggregates[2], 9.0f);
+}
+
+TEST(AlgorithmFeaturesTest, TestMatchesReference)
+{
+    std::mt19937 generator(3u);
+    std::uniform_int_distribution<guint> size(1u, 90u);
+    std::uniform_int_distribution<guint> small(1u, 6u);
+
+    for(guint trial = 0u; trial < 100u; trial++)
+    {
+        Layout layout = {};
+        layout.grid_size = small(generator) % 4u + 1u;
+        layout.frame_width = size(generator);
+        layout.frame_height = size(generator);
+        layout.features_matrix_width = small(generator);
+        layout.features_matrix_height = small(generator);
+        layout.cell_width = (layout.frame_width + layout.features_matrix_width - 1u) / layout.features_matrix_width;
+        layout.cell_height = (layout.frame_height + layout.features_matrix_height - 1u) / layout.features_matrix_height;
+
+        /* The flow may not cover the whole frame, or cover more than it */
+        guint flow_width = std::max(1u, (layout.frame_width + layout.grid_size - 1u) / layout.grid_size + small(generator) % 3u - 1u);
+        guint flow_height = std::max(1u, (layout.frame_height + layout.grid_size - 1u) / layout.grid_size + small(generator) % 3u - 1u);
+        gsize elem_size = trial % 2u == 0u ? 2u * sizeof(gint16) : 2u * sizeof(gfloat);
+        guint feature_mask = trial % 64u;
+
+        Flow flow(flow_width, flow_height, elem_size, generator);
+
+        std::vector<gfloat> reference = ReferenceFeatures(flow, layout, default_threshold, feature_mask);
+        std::vector<gfloat> host = HostFeatures(flow, layout, default_threshold, feature_mask);
+
+        ASSERT_EQ(host.size(), reference.size());
+
+        for(gsize idx = 0u; idx < host.size(); idx++)
+        {
+            EXPECT_NEAR(host[idx], reference[idx], 1e-3f * std::max(1.0f, std::abs(reference[idx])))
+                << "trial " << trial << " index " << idx;
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 60u;
+    constexpr guint default_num_bframes = 2u;
+
+    struct HarnessRun
+    {
+        bool eos = false;
+        guint64 pictures = 0u;
+        guint64 outputs = 0u;
+        guint64 slices = 0u;
+        guint pending = 0u;
+        guint max_pending = 0u;
+        guint max_dpb_size = 0u;
+        std::vector<GstClockTime> pts;
+    };
+
+    bool HasElements(std::initializer_list<const char *> names)
+    {
+        for(const char *name : names)
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    void OnHandoff(GstElement *, GstBuffer *buffer, GstPad *, gpointer user_data)
+    {
+        auto *run = static_cast<HarnessRun *>(user_data);
+
+        run->pts.push_back(GST_BUFFER_PTS(buffer));
+    }
+
+    HarnessRun RunHarnessPipeline(const std::string &description)
+    {
+        HarnessRun run;
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return run;
+        }
+
+        GstElement *dec = gst_bin_get_by_name(GST_BIN(pipeline), "dec");
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        g_signal_connect(sink, "handoff", G_CALLBACK(OnHandoff), &run);
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+
+        run.eos = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+        gst_message_unref(message);
+
+        GstStructure *stats = nullptr;
+
+        g_object_get(dec, "stats", &stats, nullptr);
+
+        if(stats != nullptr)
+        {
+            gst_structure_get(stats,
+                              "pictures", G_TYPE_UINT64, &run.pictures,
+                              "outputs", G_TYPE_UINT64, &run.outputs,
+                              "slices", G_TYPE_UINT64, &run.slices,
+                              nullptr);
+            gst_structure_get_uint(stats, "pending", &run.pending);
+            gst_structure_get_uint(stats, "max-pending", &run.max_pending);
+            gst_structure_get_uint(stats, "max-dpb-size", &run.max_dpb_size);
+            gst_structure_free(stats);
+        }
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(dec);
+        gst_object_unref(sink);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return run;
+    }
+
+    HarnessRun RunHarness(const char *backend)
+    {
+        return RunHarnessPipeline("videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+                                  + " pattern=ball ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+                                    "x264enc speed-preset=ultrafast bframes="
+                                  + std::to_string(default_num_bframes)
+                                  + " ! h264parse ! h264harnessdec name=dec backend=" + backend
+                                  + " ! fakesink name=sink signal-handoffs=true sync=false");
+    }
+}
+
+class CodecHarnessTestFixture : public ::testing::Test
+{
+    protected:
+    void SetUp() override
+    {
+        if(!HasElements({"videotestsrc", "x264enc", "h264parse", "h264harnessdec"}))
+        {
+            GTEST_SKIP() << "x264enc or h264parse not available";
+        }
+    }
+};
+
+TEST_F(CodecHarnessTestFixture, TestNullBackendCountsPictures)
+{
+    HarnessRun run = RunHarness("null");
+
+    EXPECT_TRUE(run.eos);
+    EXPECT_EQ(run.pictures, default_num_buffers);
+    EXPECT_EQ(run.outputs, default_num_buffers);
+    EXPECT_GE(run.slices, run.pictures);
+    EXPECT_EQ(run.pts.size(), default_num_buffers);
+}
+
+TEST_F(CodecHarnessTestFixture, TestDpbValidatorAcceptsReorderedStream)
+{
+    HarnessRun run = RunHarness("dpb-validator");
+
+    ASSERT_TRUE(run.eos);
+    EXPECT_EQ(run.outputs, default_num_buffers);
+    EXPECT_EQ(run.pending, 0u);
+    /* B-frames keep at least one reference picture waiting for output */
+    EXPECT_GT(run.max_pending, 1u);
+    EXPECT_LE(run.max_pending, run.max_dpb_size + 1u);
+}
+
+TEST_F(CodecHarnessTestFixture, TestOutputInPresentationOrder)
+{
+    HarnessRun run = RunHarness("dpb-validator");
+
+    ASSERT_EQ(run.pts.size(), default_num_buffers);
+
+    for(size_t i = 1; i < run.pts.size(); i++)
+    {
+        EXPECT_GT(run.pts[i], run.pts[i - 1]);
+    }
+}
+
+TEST(CodecHarnessTest, TestAV1TilesOfTheFrame)
+{
+    if(!HasElements({"videotestsrc", "av1enc", "av1parse", "av1harnessdec"}))
+    {
+        GTEST_SKIP() << "av1enc, av1parse or av1harnessdec not available";
+    }
+
+    /* Wide enough for two tile columns, the harness counts every tile as a slice */
+    HarnessRun run = RunHarnessPipeline("videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+                                        + " pattern=ball ! video/x-raw,width=640,height=240,framerate=30/1 ! "
+                                          "av1enc cpu-used=8 tile-columns=1 ! av1parse ! "
+                                          "av1harnessdec name=dec backend=dpb-validator ! "
+                                          "fakesink name=sink signal-handoffs=true sync=false");
+
+    ASSERT_TRUE(run.eos);
+    EXPECT_GT(run.pictures, 0u);
+    EXPECT_EQ(run.slices, 2u * run.pictures);
+    EXPECT_EQ(run.pts.size(), default_num_buffers);
+}
@@ -0,0 +1,251 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <gst/codecs/gsth264decoder.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gtest/gtest-param-test.h>
+#include <gtest/gtest.h>
+
+using ::testing::Values;
+
+namespace
+{
+    constexpr guint default_num_buffers = 300u;
+
+    /* A stateless H.264 decoder which does not decode anything, so that the
+     * measured throughput is the one of the base class alone. */
+    typedef struct
+    {
+        GstH264Decoder parent;
+
+        guint num_slices;
+        std::vector<GstClockTime> *output_pts;
+    } GstCountingH264Dec;
+
+    typedef struct
+    {
+        GstH264DecoderClass parent_class;
+    } GstCountingH264DecClass;
+
+    GstStaticPadTemplate counting_sink_template = GST_STATIC_PAD_TEMPLATE(
+        "sink",
+        GST_PAD_SINK,
+        GST_PAD_ALWAYS,
+        GST_STATIC_CAPS("video/x-h264, "
+                        "stream-format = (string) { avc, avc3, byte-stream }, "
+                        "alignment = (string) au"));
+
+    GstStaticPadTemplate counting_src_template = GST_STATIC_PAD_TEMPLATE(
+        "src",
+        GST_PAD_SRC,
+        GST_PAD_ALWAYS,
+        GST_STATIC_CAPS("video/x-raw"));
+
+    GType gst_counting_h264_dec_get_type(void);
+
+    G_DEFINE_TYPE(
+        GstCountingH264Dec, gst_counting_h264_dec, GST_TYPE_H264_DECODER);
+
+    void gst_counting_h264_dec_finalize(GObject *object)
+    {
+        auto *self = reinterpret_cast<GstCountingH264Dec *>(object);
+
+        delete self->output_pts;
+        self->output_pts = nullptr;
+
+        G_OBJECT_CLASS(gst_counting_h264_dec_parent_class)->finalize(object);
+    }
+
+    GstFlowReturn gst_counting_h264_dec_new_sequence(
+        GstH264Decoder *decoder, const GstH264SPS *sps, gint max_dpb_size)
+    {
+        GstVideoDecoder *video_decoder = GST_VIDEO_DECODER(decoder);
+        GstVideoCodecState *output_state = gst_video_decoder_set_output_state(
+            video_decoder,
+            GST_VIDEO_FORMAT_NV12,
+            sps->width,
+            sps->height,
+            decoder->input_state);
+
+        gst_video_codec_state_unref(output_state);
+
+        return gst_video_decoder_negotiate(video_decoder) ? GST_FLOW_OK
+                                                          : GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    GstFlowReturn gst_counting_h264_dec_decode_slice(
+        GstH264Decoder *decoder,
+        GstH264Picture *picture,
+        GstH264Slice *slice,
+        GArray *ref_pic_list0,
+        GArray *ref_pic_list1)
+    {
+        reinterpret_cast<GstCountingH264Dec *>(decoder)->num_slices++;
+
+        return GST_FLOW_OK;
+    }
+
+    GstFlowReturn gst_counting_h264_dec_output_picture(
+        GstH264Decoder *decoder,
+        GstVideoCodecFrame *frame,
+        GstH264Picture *picture)
+    {
+        auto *self = reinterpret_cast<GstCountingH264Dec *>(decoder);
+
+        self->output_pts->push_back(frame->pts);
+        gst_h264_picture_unref(picture);
+
+        frame->output_buffer = gst_buffer_new();
+
+        return gst_video_decoder_finish_frame(GST_VIDEO_DECODER(decoder), frame);
+    }
+
+    void gst_counting_h264_dec_class_init(GstCountingH264DecClass *klass)
+    {
+        GObjectClass *object_class = G_OBJECT_CLASS(klass);
+        GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+        GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS(klass);
+
+        object_class->finalize = gst_counting_h264_dec_finalize;
+
+        gst_element_class_add_static_pad_template(
+            element_class, &counting_sink_template);
+        gst_element_class_add_static_pad_template(
+            element_class, &counting_src_template);
+        gst_element_class_set_static_metadata(
+            element_class,
+            "Counting H.264 decoder",
+            "Codec/Decoder/Video",
+            "Counts pictures without decoding them",
+            "gst-plugins-custom");
+
+        h264decoder_class->new_sequence = gst_counting_h264_dec_new_sequence;
+        h264decoder_class->decode_slice = gst_counting_h264_dec_decode_slice;
+        h264decoder_class->output_picture
+            = gst_counting_h264_dec_output_picture;
+    }
+
+    void gst_counting_h264_dec_init(GstCountingH264Dec *self)
+    {
+        self->num_slices = 0u;
+        self->output_pts = new std::vector<GstClockTime>();
+    }
+
+    struct DecodeResult
+    {
+        guint num_slices = 0u;
+        std::vector<GstClockTime> output_pts;
+        double frames_per_second = 0.0;
+    };
+
+    bool HasRequiredElements()
+    {
+        for(const char *name : {"videotestsrc", "x264enc", "h264parse"})
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    DecodeResult RunCountingDecoder(bool pipelined, const std::string &format)
+    {
+        DecodeResult result;
+        std::string description
+            = "videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+              + " pattern=ball ! video/x-raw,width=320,height=240 ! "
+                "x264enc bframes=2 b-adapt=false key-int-max=30 "
+                "speed-preset=ultrafast ! h264parse ! video/x-h264,stream-format="
+              + format + " ! countingh264dec name=dec0 pipelined="
+              + (pipelined ? "true" : "false") + " ! fakesink sync=false";
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return result;
+        }
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+        auto start = std::chrono::steady_clock::now();
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(GST_MESSAGE_TYPE(message), GST_MESSAGE_EOS);
+        gst_message_unref(message);
+
+        GstElement *decoder = gst_bin_get_by_name(GST_BIN(pipeline), "dec0");
+        auto *counting = reinterpret_cast<GstCountingH264Dec *>(decoder);
+
+        result.num_slices = counting->num_slices;
+        result.output_pts = *counting->output_pts;
+        result.frames_per_second
+            = static_cast<double>(result.output_pts.size()) / elapsed.count();
+
+        gst_object_unref(decoder);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return result;
+    }
+}
+
+class CodecPreparserTestFixture : public ::testing::TestWithParam<std::string>
+{
+    protected:
+    void SetUp() override
+    {
+        if(!HasRequiredElements())
+        {
+            GTEST_SKIP() << "videotestsrc, x264enc or h264parse not available";
+        }
+
+        gst_element_register(
+            nullptr,
+            "countingh264dec",
+            GST_RANK_NONE,
+            gst_counting_h264_dec_get_type());
+    }
+};
+
+TEST_P(CodecPreparserTestFixture, TestPipelinedOutputMatchesSerial)
+{
+    DecodeResult serial = RunCountingDecoder(false, GetParam());
+    DecodeResult pipelined = RunCountingDecoder(true, GetParam());
+
+    EXPECT_EQ(serial.output_pts.size(), default_num_buffers);
+    EXPECT_EQ(pipelined.num_slices, serial.num_slices);
+    EXPECT_EQ(pipelined.output_pts, serial.output_pts);
+
+    ::testing::Test::RecordProperty(
+        "serial-frames-per-second",
+        std::to_string(static_cast<int>(serial.frames_per_second)));
+    ::testing::Test::RecordProperty(
+        "pipelined-frames-per-second",
+        std::to_string(static_cast<int>(pipelined.frames_per_second)));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    CodecPreparserTests,
+    CodecPreparserTestFixture,
+    Values(std::string("byte-stream"), std::string("avc")));
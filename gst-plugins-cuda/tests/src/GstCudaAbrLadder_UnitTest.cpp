@@ -0,0 +1,357 @@
+#include <deque>
+#include <set>
+#include <vector>
+
+#include <gst/cuda/nvcodec/gstcudaabrladder.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_n_slots = 5u;
+    constexpr std::size_t default_num_frames = 100u;
+    constexpr GstClockTime default_duration = GST_SECOND / 30;
+
+    struct Harness;
+
+    /* Stands in for an NVENC session. Like NvEncEncodePicture(), pictures
+     * are held back while they wait for the next reference picture when
+     * B-frames are enabled, and all the held pictures can be locked once it
+     * arrives */
+    struct FakeSession
+    {
+        Harness *harness = nullptr;
+        guint index = 0u;
+        guint n_bframes = 0u;
+        std::size_t n_submitted = 0u;
+        std::deque<std::pair<gint, GstClockTime>> in_flight;
+    };
+
+    struct Harness
+    {
+        std::vector<guint> n_bframes;
+        gint fail_open_index = -1;
+        gint fail_encode_index = -1;
+        std::vector<GstFlowReturn> push_flows;
+
+        std::vector<FakeSession *> sessions;
+        std::size_t n_opened = 0u;
+        std::size_t n_closed = 0u;
+        std::vector<std::vector<GstClockTime>> pushed;
+        std::set<std::pair<gint, guint>> held;
+        std::size_t n_out_of_order_locks = 0u;
+
+        /* whether any session still holds the picture of @slot */
+        bool IsHeld(gint slot) const
+        {
+            for(const auto &entry : this->held)
+            {
+                if(entry.first == slot)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    gpointer fake_open(gpointer user_data, guint index, const GstCudaAbrRendition *)
+    {
+        auto *harness = static_cast<Harness *>(user_data);
+
+        if(static_cast<gint>(index) == harness->fail_open_index)
+        {
+            return nullptr;
+        }
+
+        auto *session = new FakeSession();
+        session->harness = harness;
+        session->index = index;
+        session->n_bframes = index < harness->n_bframes.size() ? harness->n_bframes[index] : 0u;
+        harness->sessions.push_back(session);
+        harness->n_opened++;
+
+        return session;
+    }
+
+    GstCudaAbrEncodeStatus fake_encode(gpointer handle, gint slot, GstClockTime pts, GstClockTime)
+    {
+        auto *session = static_cast<FakeSession *>(handle);
+
+        if(static_cast<gint>(session->index) == session->harness->fail_encode_index)
+        {
+            return GST_CUDA_ABR_ENCODE_ERROR;
+        }
+
+        /* end of stream, flushes the B-frames */
+        if(slot < 0)
+        {
+            return GST_CUDA_ABR_ENCODE_OK;
+        }
+
+        session->in_flight.emplace_back(slot, pts);
+        session->harness->held.emplace(slot, session->index);
+
+        return session->n_submitted++ % (session->n_bframes + 1u) == 0u
+                   ? GST_CUDA_ABR_ENCODE_OK
+                   : GST_CUDA_ABR_ENCODE_NEED_MORE_INPUT;
+    }
+
+    GstBuffer *fake_lock_bitstream(gpointer handle, gint slot)
+    {
+        auto *session = static_cast<FakeSession *>(handle);
+        GstBuffer *buffer;
+
+        if(session->in_flight.empty())
+        {
+            return nullptr;
+        }
+
+        if(session->in_flight.front().first != slot)
+        {
+            session->harness->n_out_of_order_locks++;
+        }
+
+        buffer = gst_buffer_new();
+        GST_BUFFER_PTS(buffer) = session->in_flight.front().second;
+        session->harness->held.erase({slot, session->index});
+        session->in_flight.pop_front();
+
+        return buffer;
+    }
+
+    GstFlowReturn fake_push(gpointer user_data, guint index, GstBuffer *buffer)
+    {
+        auto *harness = static_cast<Harness *>(user_data);
+
+        harness->pushed[index].push_back(GST_BUFFER_PTS(buffer));
+        gst_buffer_unref(buffer);
+
+        return index < harness->push_flows.size() ? harness->push_flows[index] : GST_FLOW_OK;
+    }
+
+    void fake_close(gpointer handle)
+    {
+        auto *session = static_cast<FakeSession *>(handle);
+
+        session->harness->n_closed++;
+        delete session;
+    }
+
+    const GstCudaAbrSessionFuncs fake_funcs
+        = {fake_open, fake_encode, fake_lock_bitstream, fake_push, fake_close};
+
+    GstCudaAbrLadder *NewLadder(Harness &harness, guint n_renditions, guint n_slots)
+    {
+        std::vector<GstCudaAbrRendition> renditions(n_renditions);
+
+        for(guint idx = 0u; idx < n_renditions; idx++)
+        {
+            renditions[idx] = {1920u >> idx, 1080u >> idx, 6000u >> idx};
+        }
+
+        harness.pushed.assign(n_renditions, {});
+
+        return gst_cuda_abr_ladder_new(
+            &fake_funcs, &harness, renditions.data(), n_renditions, n_slots);
+    }
+}
+
+TEST(CudaAbrLadderTest, TestParseRenditions)
+{
+    GArray *renditions = gst_cuda_abr_rendition_parse("1920x1080:6000, 1280x720:3000,640x360:800");
+
+    ASSERT_NE(renditions, nullptr);
+    ASSERT_EQ(renditions->len, 3u);
+
+    GstCudaAbrRendition *rendition = &g_array_index(renditions, GstCudaAbrRendition, 1);
+    EXPECT_EQ(rendition->width, 1280u);
+    EXPECT_EQ(rendition->height, 720u);
+    EXPECT_EQ(rendition->bitrate, 3000u);
+
+    g_array_unref(renditions);
+
+    for(const gchar *invalid :
+        {"", "1280x720", "1280x720:", "1280:720:3000", "1280x720:3000,", "0x720:3000",
+         "1281x720:3000", "1280x721:3000", "-1280x720:3000", "1280x720:3000 kbps",
+         "2x2:1,2x2:1,2x2:1,2x2:1,2x2:1,2x2:1,2x2:1,2x2:1,2x2:1"})
+    {
+        EXPECT_EQ(gst_cuda_abr_rendition_parse(invalid), nullptr) << invalid;
+    }
+}
+
+TEST(CudaAbrLadderTest, TestLayoutIsPackedAndAligned)
+{
+    const GstCudaAbrRendition renditions[]
+        = {{1920u, 1080u, 6000u}, {1270u, 714u, 3000u}, {426u, 240u, 400u}};
+    GstCudaAbrPlaneLayout layouts[3];
+    gsize expected_offset = 0u;
+
+    gsize size = gst_cuda_abr_rendition_get_layout(renditions, 3u, 256u, layouts);
+
+    for(guint idx = 0u; idx < 3u; idx++)
+    {
+        EXPECT_GE(layouts[idx].pitch, renditions[idx].width);
+        EXPECT_EQ(layouts[idx].pitch % 256u, 0u);
+        EXPECT_EQ(layouts[idx].luma_offset, expected_offset);
+        EXPECT_EQ(layouts[idx].luma_offset % 256u, 0u);
+        EXPECT_EQ(
+            layouts[idx].chroma_offset,
+            layouts[idx].luma_offset + layouts[idx].pitch * renditions[idx].height);
+
+        expected_offset = layouts[idx].chroma_offset
+                          + layouts[idx].pitch * renditions[idx].height / 2u;
+    }
+
+    EXPECT_EQ(layouts[1].pitch, 1280u);
+    EXPECT_EQ(size, expected_offset);
+}
+
+TEST(CudaAbrLadderTest, TestEveryRenditionGetsEveryPictureInOrder)
+{
+    Harness harness;
+    harness.n_bframes = {0u, 2u, 3u};
+
+    GstCudaAbrLadder *ladder = NewLadder(harness, 3u, default_n_slots);
+    ASSERT_NE(ladder, nullptr);
+    EXPECT_EQ(gst_cuda_abr_ladder_get_n_renditions(ladder), 3u);
+
+    std::size_t n_reused_while_held = 0u;
+
+    for(std::size_t frame = 0u; frame < default_num_frames; frame++)
+    {
+        gint slot = gst_cuda_abr_ladder_acquire_slot(ladder);
+
+        ASSERT_GE(slot, 0) << "frame " << frame;
+
+        if(harness.IsHeld(slot))
+        {
+            n_reused_while_held++;
+        }
+
+        EXPECT_EQ(
+            gst_cuda_abr_ladder_submit(ladder, slot, frame * default_duration, default_duration),
+            GST_FLOW_OK);
+    }
+
+    EXPECT_EQ(gst_cuda_abr_ladder_drain(ladder), GST_FLOW_OK);
+
+    EXPECT_EQ(n_reused_while_held, 0u);
+    EXPECT_EQ(harness.n_out_of_order_locks, 0u);
+    EXPECT_TRUE(harness.held.empty());
+
+    for(const auto &pushed : harness.pushed)
+    {
+        ASSERT_EQ(pushed.size(), default_num_frames);
+
+        for(std::size_t frame = 0u; frame < default_num_frames; frame++)
+        {
+            EXPECT_EQ(pushed[frame], frame * default_duration);
+        }
+    }
+
+    /* Every slot is free after draining */
+    for(guint idx = 0u; idx < default_n_slots; idx++)
+    {
+        EXPECT_GE(gst_cuda_abr_ladder_acquire_slot(ladder), 0);
+    }
+
+    gst_cuda_abr_ladder_free(ladder);
+    EXPECT_EQ(harness.n_closed, 3u);
+}
+
+TEST(CudaAbrLadderTest, TestSlotIsHeldUntilEverySessionOutputs)
+{
+    Harness harness;
+    harness.n_bframes = {0u, 2u};
+
+    GstCudaAbrLadder *ladder = NewLadder(harness, 2u, 3u);
+    ASSERT_NE(ladder, nullptr);
+
+    /* The first picture is a reference, output by both sessions right away */
+    gint slot = gst_cuda_abr_ladder_acquire_slot(ladder);
+    gst_cuda_abr_ladder_submit(ladder, slot, 0, default_duration);
+    EXPECT_EQ(gst_cuda_abr_ladder_acquire_slot(ladder), slot);
+
+    /* The next ones wait for the next reference in the second session only */
+    gst_cuda_abr_ladder_submit(ladder, slot, default_duration, default_duration);
+    gst_cuda_abr_ladder_submit(
+        ladder, gst_cuda_abr_ladder_acquire_slot(ladder), 2 * default_duration, default_duration);
+
+    EXPECT_EQ(harness.pushed[0].size(), 3u);
+    EXPECT_EQ(harness.pushed[1].size(), 1u);
+
+    gint last_slot = gst_cuda_abr_ladder_acquire_slot(ladder);
+    ASSERT_GE(last_slot, 0);
+    EXPECT_EQ(gst_cuda_abr_ladder_acquire_slot(ladder), -1);
+
+    gst_cuda_abr_ladder_submit(ladder, last_slot, 3 * default_duration, default_duration);
+
+    EXPECT_EQ(harness.pushed[1].size(), 4u);
+    EXPECT_GE(gst_cuda_abr_ladder_acquire_slot(ladder), 0);
+
+    gst_cuda_abr_ladder_free(ladder);
+}
+
+TEST(CudaAbrLadderTest, TestUnlinkedRenditionDoesNotStopOthers)
+{
+    Harness harness;
+    GstCudaAbrLadder *ladder = NewLadder(harness, 3u, default_n_slots);
+
+    harness.push_flows = {GST_FLOW_OK, GST_FLOW_NOT_LINKED, GST_FLOW_EOS};
+    EXPECT_EQ(
+        gst_cuda_abr_ladder_submit(ladder, gst_cuda_abr_ladder_acquire_slot(ladder), 0, default_duration),
+        GST_FLOW_OK);
+
+    harness.push_flows = {GST_FLOW_NOT_LINKED, GST_FLOW_NOT_LINKED, GST_FLOW_NOT_LINKED};
+    EXPECT_EQ(
+        gst_cuda_abr_ladder_submit(ladder, gst_cuda_abr_ladder_acquire_slot(ladder), 0, default_duration),
+        GST_FLOW_NOT_LINKED);
+
+    harness.push_flows = {GST_FLOW_EOS, GST_FLOW_EOS, GST_FLOW_EOS};
+    EXPECT_EQ(
+        gst_cuda_abr_ladder_submit(ladder, gst_cuda_abr_ladder_acquire_slot(ladder), 0, default_duration),
+        GST_FLOW_EOS);
+
+    harness.push_flows = {GST_FLOW_OK, GST_FLOW_FLUSHING, GST_FLOW_OK};
+    EXPECT_EQ(
+        gst_cuda_abr_ladder_submit(ladder, gst_cuda_abr_ladder_acquire_slot(ladder), 0, default_duration),
+        GST_FLOW_FLUSHING);
+
+    /* Every rendition got every picture regardless */
+    for(const auto &pushed : harness.pushed)
+    {
+        EXPECT_EQ(pushed.size(), 4u);
+    }
+
+    gst_cuda_abr_ladder_free(ladder);
+}
+
+TEST(CudaAbrLadderTest, TestOpenFailureClosesOpenedSessions)
+{
+    Harness harness;
+    harness.fail_open_index = 2;
+
+    EXPECT_EQ(NewLadder(harness, 3u, default_n_slots), nullptr);
+    EXPECT_EQ(harness.n_opened, 2u);
+    EXPECT_EQ(harness.n_closed, 2u);
+}
+
+TEST(CudaAbrLadderTest, TestEncodeErrorReleasesSlot)
+{
+    Harness harness;
+    GstCudaAbrLadder *ladder = NewLadder(harness, 3u, 1u);
+
+    harness.fail_encode_index = 1;
+
+    gint slot = gst_cuda_abr_ladder_acquire_slot(ladder);
+    EXPECT_EQ(gst_cuda_abr_ladder_submit(ladder, slot, 0, default_duration), GST_FLOW_ERROR);
+
+    /* The first session output the picture and the others never got it */
+    EXPECT_EQ(harness.pushed[0].size(), 1u);
+    EXPECT_EQ(gst_cuda_abr_ladder_acquire_slot(ladder), slot);
+
+    gst_cuda_abr_ladder_free(ladder);
+    EXPECT_EQ(harness.n_closed, 3u);
+}
@@ -8,6 +8,7 @@
 
 #include <Poco/Path.h>
 #include <gst/app/gstappsink.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
 #include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
 #include <gst/cuda/of/gstcudaofalgorithm.h>
 #include <gst/cuda/of/gstmetaopticalflow.h>
@@ -409,6 +410,65 @@ class FeatureExtractorTestFixture
         return aggregations_array;
     }
 
+    /*
+     * Extracts every feature plane with the host implementation and
+     * aggregates each of them the same way as the spatial magnitude.
+     */
+    std::vector<std::vector<float>> ExtractFeaturePlanes(
+        const cv::Mat optical_flow_matrix,
+        cv::Size_<size_t> frame_dimensions,
+        size_t optical_flow_vector_grid_size,
+        guint feature_mask,
+        float optical_flow_vector_threshold
+        = default_magnitude_quadrant_threshold_squared,
+        cv::Size_<size_t> feature_grid_dimensions
+        = default_features_matrix_size)
+    {
+        cv::Size_<size_t> block_dimensions = this->CalculateBlockDimensions(
+            frame_dimensions, feature_grid_dimensions);
+        guint number_of_planes
+            = gst_algorithm_features_get_number_of_planes(feature_mask);
+        std::size_t plane_size = feature_grid_dimensions.area();
+        std::vector<float> features(plane_size * number_of_planes);
+
+        gst_algorithm_features_extract(
+            optical_flow_matrix.ptr<guint8>(),
+            optical_flow_matrix.step,
+            optical_flow_matrix.elemSize(),
+            optical_flow_matrix.cols,
+            optical_flow_matrix.rows,
+            optical_flow_vector_grid_size,
+            frame_dimensions.width,
+            frame_dimensions.height,
+            block_dimensions.width,
+            block_dimensions.height,
+            feature_grid_dimensions.width,
+            feature_grid_dimensions.height,
+            optical_flow_vector_threshold,
+            feature_mask,
+            features.data());
+
+        std::size_t aggregations_array_size
+            = ceil_div_int<size_t>(plane_size, features_per_aggregation);
+        std::vector<std::vector<float>> aggregations_planes(
+            number_of_planes, std::vector<float>(aggregations_array_size));
+
+        for(guint plane = 0u; plane < number_of_planes; plane++)
+        {
+            for(size_t idx = 0; idx < plane_size; idx++)
+            {
+                std::vector<float> &aggregations = aggregations_planes[plane];
+                size_t aggregate_idx = idx / features_per_aggregation;
+
+                aggregations[aggregate_idx] = std::max(
+                    aggregations[aggregate_idx],
+                    features[plane * plane_size + idx]);
+            }
+        }
+
+        return aggregations_planes;
+    }
+
     float ExtractFeaturesForBlock(
         cv::Point_<size_t> block_index,
         cv::Size_<size_t> block_dimensions,
@@ -562,7 +622,7 @@ TEST_P(FeatureExtractorTestFixture, TestFeatureExtractor)
                             features_per_aggregation);
 
                         gsize features_array_length
-                            = feature_extractor_metadata->features->len;
+                            = feature_extractor_metadata->length;
 
                         EXPECT_EQ(
                             aggregate_features_array.size(),
@@ -573,16 +633,66 @@ TEST_P(FeatureExtractorTestFixture, TestFeatureExtractor)
                         {
                             auto host_spatial_magnitude
                                 = aggregate_features_array[idx];
-                            gfloat gpu_spatial_magnitude = g_array_index(
-                                feature_extractor_metadata->features,
-                                gfloat,
-                                idx);
+                            gfloat gpu_spatial_magnitude
+                                = feature_extractor_metadata->features[idx];
 
                             EXPECT_NEAR(
                                 host_spatial_magnitude,
                                 gpu_spatial_magnitude,
                                 10.0f);
                         }
+
+                        /*
+                         * Every feature is extracted by default, so each one
+                         * should match the host implementation plane by plane.
+                         */
+                        EXPECT_EQ(
+                            feature_extractor_metadata->feature_mask,
+                            static_cast<guint>(ALGORITHM_FEATURE_FLAGS_ALL));
+
+                        auto aggregate_feature_planes
+                            = this->ExtractFeaturePlanes(
+                                host_optical_flow_matrix,
+                                test_frame_size,
+                                optical_flow_metadata
+                                    ->optical_flow_vector_grid_size,
+                                ALGORITHM_FEATURE_FLAGS_ALL);
+
+                        // Every feature array holds as many aggregates as
+                        // the spatial magnitude.
+                        ASSERT_EQ(
+                            feature_extractor_metadata->length,
+                            expected_array_size);
+
+                        for(guint feature = 0u;
+                            feature < ALGORITHM_NUMBER_OF_FEATURES;
+                            feature++)
+                        {
+                            const gfloat *feature_array
+                                = feature_extractor_metadata
+                                      ->feature_arrays[feature];
+
+                            ASSERT_NE(feature_array, nullptr);
+
+                            for(size_t idx = 0; idx < expected_array_size;
+                                idx++)
+                            {
+                                float host_feature
+                                    = aggregate_feature_planes[1u + feature].at(
+                                        idx);
+                                gfloat gpu_feature = feature_array[idx];
+
+                                EXPECT_NEAR(
+                                    host_feature,
+                                    gpu_feature,
+                                    std::max(
+                                        10.0f,
+                                        1e-4f * std::abs(host_feature)))
+                                    << gst_algorithm_feature_get_name(
+                                           static_cast<GstAlgorithmFeature>(
+                                               feature));
+                            }
+                        }
                     }
                 }
 
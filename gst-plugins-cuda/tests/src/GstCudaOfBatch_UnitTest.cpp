@@ -0,0 +1,230 @@
+#include <string>
+#include <vector>
+
+#include <gst/app/gstappsink.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
+#include <gst/cuda/of/gstcudaofbatch.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 10u;
+
+    /* A stacked 2-channel flow matrix with the guard rows filled in */
+    struct StackedFlow
+    {
+        guint width = 0u;
+        guint height = 0u;
+        guint slot_rows = 0u;
+        guint slots = 0u;
+        std::vector<gfloat> data;
+
+        StackedFlow(guint width, guint height, guint slot_rows, guint slots, gfloat guard)
+            : width(width), height(height), slot_rows(slot_rows), slots(slots),
+              data(static_cast<gsize>(width) * 2u * slot_rows * slots, guard)
+        {
+        }
+
+        void Fill(guint slot, gfloat x, gfloat y)
+        {
+            for(guint row = 0u; row < this->height; row++)
+            {
+                gfloat *vectors = this->Row(slot, row);
+
+                for(guint column = 0u; column < this->width; column++)
+                {
+                    vectors[2u * column] = x;
+                    vectors[2u * column + 1u] = y;
+                }
+            }
+        }
+
+        gfloat *Row(guint slot, guint row)
+        {
+            return this->data.data() + static_cast<gsize>(this->width) * 2u * (slot * this->slot_rows + row);
+        }
+
+        std::vector<gfloat> Features(guint features_width, guint features_height, gfloat threshold)
+        {
+            std::vector<gfloat> features(static_cast<gsize>(features_width) * features_height * this->slots);
+
+            gst_cuda_of_batch_features(this->data.data(),
+                                       sizeof(gfloat) * 2u * this->width,
+                                       this->width,
+                                       this->height,
+                                       this->slot_rows,
+                                       this->slots,
+                                       features_width,
+                                       features_height,
+                                       threshold,
+                                       features.data());
+
+            return features;
+        }
+    };
+
+    struct SinkRun
+    {
+        guint buffers = 0u;
+        guint metas = 0u;
+        guint features_length = 0u;
+    };
+
+    SinkRun PullAll(GstElement *pipeline, const char *name)
+    {
+        SinkRun run;
+        GstAppSink *appsink = GST_APP_SINK(gst_bin_get_by_name(GST_BIN(pipeline), name));
+
+        for(GstSample *sample = gst_app_sink_pull_sample(appsink);
+            sample != NULL;
+            sample = gst_app_sink_pull_sample(appsink))
+        {
+            GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_GET(gst_sample_get_buffer(sample));
+
+            if(meta != NULL && meta->features != NULL)
+            {
+                run.features_length = meta->length;
+                run.metas++;
+            }
+
+            run.buffers++;
+            gst_sample_unref(sample);
+        }
+
+        gst_object_unref(appsink);
+
+        return run;
+    }
+}
+
+TEST(CudaOfBatchTest, TestEnumNicks)
+{
+    GEnumClass *klass = G_ENUM_CLASS(g_type_class_ref(GST_TYPE_CUDA_OF_BATCH_BACKEND));
+
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "cuda"), nullptr);
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "cpu"), nullptr);
+    g_type_class_unref(klass);
+}
+
+TEST(CudaOfBatchTest, TestSlotRows)
+{
+    for(guint levels : {1u, 2u, 3u, 5u})
+    {
+        guint rows = gst_cuda_of_batch_slot_rows(48u, 13u, levels);
+
+        /* Every frame starts on the same row of every pyramid level */
+        EXPECT_EQ(rows % (1u << levels), 0u) << "levels " << levels;
+        EXPECT_GE(rows, 48u + ((13u / 2u) << (levels - 1u))) << "levels " << levels;
+    }
+
+    EXPECT_LT(gst_cuda_of_batch_slot_rows(48u, 13u, 1u), gst_cuda_of_batch_slot_rows(48u, 13u, 2u));
+    EXPECT_LT(gst_cuda_of_batch_slot_rows(48u, 5u, 3u), gst_cuda_of_batch_slot_rows(48u, 13u, 3u));
+}
+
+TEST(CudaOfBatchTest, TestFeaturesKeepSlotsApart)
+{
+    StackedFlow flow(8u, 4u, 6u, 2u, 100.0f);
+
+    flow.Fill(0u, 2.0f, 0.0f);
+    flow.Fill(1u, 0.0f, -3.0f);
+
+    std::vector<gfloat> features = flow.Features(2u, 2u, 2.25f);
+
+    /* Each cell holds 4x2 vectors, the guard rows never contribute */
+    for(guint cell = 0u; cell < 4u; cell++)
+    {
+        EXPECT_FLOAT_EQ(features[cell], 16.0f) << "cell " << cell;
+        EXPECT_FLOAT_EQ(features[4u + cell], 24.0f) << "cell " << cell;
+    }
+}
+
+TEST(CudaOfBatchTest, TestFeaturesThreshold)
+{
+    StackedFlow flow(4u, 4u, 4u, 1u, 0.0f);
+
+    flow.Fill(0u, 1.5f, -1.0f);
+
+    /* 1.5 ^ 2 does not exceed the default threshold of 2.25 */
+    std::vector<gfloat> features = flow.Features(1u, 1u, 2.25f);
+    EXPECT_FLOAT_EQ(features[0], 0.0f);
+
+    features = flow.Features(1u, 1u, 1.0f);
+    EXPECT_FLOAT_EQ(features[0], 16u * 1.5f);
+}
+
+TEST(CudaOfBatchTest, TestFeaturesUnevenCells)
+{
+    StackedFlow flow(5u, 3u, 3u, 1u, 0.0f);
+
+    flow.Fill(0u, 1.0f, 1.0f);
+
+    /* Columns 0-2 and 3-4, rows 0-1 and 2 */
+    std::vector<gfloat> features = flow.Features(2u, 2u, 0.0f);
+
+    EXPECT_FLOAT_EQ(features[0], 3u * 2u * 2.0f);
+    EXPECT_FLOAT_EQ(features[1], 2u * 2u * 2.0f);
+    EXPECT_FLOAT_EQ(features[2], 3u * 1u * 2.0f);
+    EXPECT_FLOAT_EQ(features[3], 2u * 1u * 2.0f);
+}
+
+TEST(CudaOfBatchTest, TestCpuBackendFansOutMetas)
+{
+    const std::string caps = " ! video/x-raw,format=NV12,width=64,height=48 ! ";
+    const std::string description
+        = "cudaofbatch name=batch backend=cpu "
+          "videotestsrc num-buffers=" + std::to_string(default_num_buffers) + " pattern=ball" + caps + "batch.sink_0 "
+          "videotestsrc num-buffers=" + std::to_string(default_num_buffers) + " pattern=snow" + caps + "batch.sink_1 "
+          "batch.src_0 ! appsink name=appsink0 sync=false "
+          "batch.src_1 ! appsink name=appsink1 sync=false";
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+    ASSERT_EQ(error, nullptr);
+    ASSERT_NE(pipeline, nullptr);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    for(const char *name : {"appsink0", "appsink1"})
+    {
+        SinkRun run = PullAll(pipeline, name);
+
+        EXPECT_EQ(run.buffers, default_num_buffers) << name;
+        /* The first buffer of a stream has nothing to compare to */
+        EXPECT_EQ(run.metas, default_num_buffers - 1u) << name;
+        /* 20x20 features aggregated in groups of 10 */
+        EXPECT_EQ(run.features_length, 40u) << name;
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+TEST(CudaOfBatchTest, TestBlockedStreamDoesNotStallOthers)
+{
+    const std::string caps = " ! video/x-raw,format=NV12,width=64,height=48 ! ";
+    const std::string description
+        = "cudaofbatch name=batch backend=cpu "
+          "videotestsrc num-buffers=" + std::to_string(default_num_buffers) + " pattern=ball" + caps + "batch.sink_0 "
+          "videotestsrc num-buffers=" + std::to_string(default_num_buffers) + " pattern=snow" + caps + "batch.sink_1 "
+          "batch.src_0 ! appsink name=appsink0 sync=false max-buffers=1 "
+          "batch.src_1 ! appsink name=appsink1 sync=false";
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+    ASSERT_EQ(error, nullptr);
+    ASSERT_NE(pipeline, nullptr);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    /* appsink0 is full and blocks its stream until appsink1 has been drained */
+    for(const char *name : {"appsink1", "appsink0"})
+    {
+        SinkRun run = PullAll(pipeline, name);
+
+        EXPECT_EQ(run.buffers, default_num_buffers) << name;
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
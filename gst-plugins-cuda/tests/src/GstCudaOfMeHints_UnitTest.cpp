@@ -0,0 +1,331 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gst/cuda/of/gstcudaofmehints.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+#include "nvEncodeAPI.h"
+
+namespace
+{
+    constexpr guint default_frame_width = 1280u;
+    constexpr guint default_frame_height = 720u;
+    constexpr std::size_t benchmark_iterations = 100u;
+
+    /* A host optical flow field, laid out like a downloaded cv::Mat */
+    struct FlowField
+    {
+        guint cols = 0u;
+        guint rows = 0u;
+        gsize element_size = 8u;
+        std::vector<guint8> data;
+
+        gsize Stride() const
+        {
+            return this->cols * this->element_size;
+        }
+
+        void Set(guint col, guint row, float x, float y)
+        {
+            guint8 *element = this->data.data() + row * this->Stride()
+                              + col * this->element_size;
+
+            if(this->element_size == 4u)
+            {
+                /* S10.5 fixed point */
+                gint16 vector[2] = {
+                    static_cast<gint16>(std::lround(x * 32.0f)),
+                    static_cast<gint16>(std::lround(y * 32.0f))};
+                std::memcpy(element, vector, sizeof(vector));
+            }
+            else
+            {
+                float vector[2] = {x, y};
+                std::memcpy(element, vector, sizeof(vector));
+            }
+        }
+    };
+
+    FlowField MakeConstantFlow(
+        guint cols, guint rows, gsize element_size, float x, float y)
+    {
+        FlowField flow;
+
+        flow.cols = cols;
+        flow.rows = rows;
+        flow.element_size = element_size;
+        flow.data.resize(flow.Stride() * rows);
+
+        for(guint row = 0u; row < rows; row++)
+        {
+            for(guint col = 0u; col < cols; col++)
+            {
+                flow.Set(col, row, x, y);
+            }
+        }
+
+        return flow;
+    }
+
+    std::vector<guint32> Convert(
+        GstCudaOfMeHints *hints, const FlowField &flow, guint grid_size)
+    {
+        std::vector<guint32> packed(gst_cuda_of_me_hints_get_num_blocks(hints));
+
+        EXPECT_TRUE(gst_cuda_of_me_hints_convert(
+            hints,
+            flow.data.data(),
+            flow.Stride(),
+            flow.element_size,
+            flow.cols,
+            flow.rows,
+            grid_size,
+            packed.data()));
+
+        return packed;
+    }
+
+    NVENC_EXTERNAL_ME_HINT Unpack(guint32 packed)
+    {
+        NVENC_EXTERNAL_ME_HINT hint;
+
+        static_assert(sizeof(hint) == sizeof(packed), "Unexpected hint size");
+        std::memcpy(&hint, &packed, sizeof(hint));
+
+        return hint;
+    }
+}
+
+TEST(CudaOfMeHintsTest, TestNumBlocks)
+{
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(1270u, 710u, ME_HINT_POOLING_MEAN);
+
+    EXPECT_EQ(gst_cuda_of_me_hints_get_num_blocks(hints), 80u * 45u);
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestConstantFlowAllGridSizes)
+{
+    for(gsize element_size : {4u, 8u})
+    {
+        for(guint grid_size : {1u, 2u, 4u, 8u})
+        {
+            GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(
+                default_frame_width, default_frame_height, ME_HINT_POOLING_MEAN);
+            FlowField flow = MakeConstantFlow(
+                default_frame_width / grid_size,
+                default_frame_height / grid_size,
+                element_size,
+                3.25f,
+                -7.75f);
+
+            for(guint32 packed : Convert(hints, flow, grid_size))
+            {
+                NVENC_EXTERNAL_ME_HINT hint = Unpack(packed);
+
+                /* The hint points back into the previous frame */
+                ASSERT_EQ(hint.mvx, -3) << "grid size " << grid_size;
+                ASSERT_EQ(hint.mvy, 8) << "grid size " << grid_size;
+                ASSERT_EQ(hint.refidx, 0);
+                ASSERT_EQ(hint.dir, 0);
+                ASSERT_EQ(hint.partType, 0);
+                ASSERT_EQ(hint.lastofPart, -1);
+                ASSERT_EQ(hint.lastOfMB, -1);
+            }
+
+            gst_cuda_of_me_hints_free(hints);
+        }
+    }
+}
+
+TEST(CudaOfMeHintsTest, TestBlocksFollowTheFlow)
+{
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(
+        default_frame_width, default_frame_height, ME_HINT_POOLING_MEAN);
+    FlowField flow = MakeConstantFlow(
+        default_frame_width / 4u, default_frame_height / 4u, 4u, 0.0f, 0.0f);
+
+    /* Each block moves by its own index, so that misplaced blocks show */
+    for(guint row = 0u; row < flow.rows; row++)
+    {
+        for(guint col = 0u; col < flow.cols; col++)
+        {
+            flow.Set(col, row, static_cast<float>(col / 4u % 64u), static_cast<float>(row / 4u));
+        }
+    }
+
+    std::vector<guint32> packed = Convert(hints, flow, 4u);
+
+    for(guint block_y = 0u; block_y < default_frame_height / 16u; block_y++)
+    {
+        for(guint block_x = 0u; block_x < default_frame_width / 16u; block_x++)
+        {
+            NVENC_EXTERNAL_ME_HINT hint = Unpack(packed[block_y * default_frame_width / 16u + block_x]);
+
+            ASSERT_EQ(hint.mvx, -static_cast<gint>(block_x % 64u));
+            ASSERT_EQ(hint.mvy, -static_cast<gint>(block_y));
+        }
+    }
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestMedianIgnoresOutliers)
+{
+    GstCudaOfMeHints *mean_hints = gst_cuda_of_me_hints_new(16u, 16u, ME_HINT_POOLING_MEAN);
+    GstCudaOfMeHints *median_hints = gst_cuda_of_me_hints_new(16u, 16u, ME_HINT_POOLING_MEDIAN);
+    FlowField flow = MakeConstantFlow(16u, 16u, 8u, 2.0f, 1.0f);
+
+    /* A quarter of the block belongs to a fast moving object */
+    for(guint row = 0u; row < 8u; row++)
+    {
+        for(guint col = 0u; col < 8u; col++)
+        {
+            flow.Set(col, row, 42.0f, -30.0f);
+        }
+    }
+
+    NVENC_EXTERNAL_ME_HINT mean = Unpack(Convert(mean_hints, flow, 1u)[0]);
+    NVENC_EXTERNAL_ME_HINT median = Unpack(Convert(median_hints, flow, 1u)[0]);
+
+    EXPECT_EQ(mean.mvx, -12);
+    EXPECT_EQ(mean.mvy, 7);
+    EXPECT_EQ(median.mvx, -2);
+    EXPECT_EQ(median.mvy, -1);
+
+    gst_cuda_of_me_hints_free(mean_hints);
+    gst_cuda_of_me_hints_free(median_hints);
+}
+
+TEST(CudaOfMeHintsTest, TestPartialGridAndEdgeBlocks)
+{
+    /* 1271 is not a multiple of the grid size, the NVIDIA Optical Flow
+     * then outputs one extra vector per row */
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(1271u, 713u, ME_HINT_POOLING_MEAN);
+    FlowField flow = MakeConstantFlow(318u, 179u, 4u, 0.0f, 0.0f);
+
+    for(guint row = 0u; row < flow.rows; row++)
+    {
+        flow.Set(flow.cols - 1u, row, -5.0f, 0.0f);
+    }
+
+    std::vector<guint32> packed = Convert(hints, flow, 4u);
+
+    ASSERT_EQ(packed.size(), 80u * 45u);
+
+    /* The last block column covers pixels 1264 to 1270, i.e. the vectors 316
+     * and 317 */
+    EXPECT_EQ(Unpack(packed[79]).mvx, 3);
+    EXPECT_EQ(Unpack(packed[78]).mvx, 0);
+    EXPECT_EQ(Unpack(packed[44u * 80u + 79u]).mvx, 3);
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestScaledFlow)
+{
+    /* Optical flow computed at half resolution */
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(
+        default_frame_width, default_frame_height, ME_HINT_POOLING_MEAN);
+    FlowField flow = MakeConstantFlow(
+        default_frame_width / 2u, default_frame_height / 2u, 8u, 1.5f, 2.0f);
+
+    for(guint32 packed : Convert(hints, flow, 1u))
+    {
+        ASSERT_EQ(Unpack(packed).mvx, -3);
+        ASSERT_EQ(Unpack(packed).mvy, -4);
+    }
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestClampsToHintRange)
+{
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(32u, 16u, ME_HINT_POOLING_MEAN);
+    FlowField flow = MakeConstantFlow(32u, 16u, 8u, 0.0f, 0.0f);
+
+    for(guint row = 0u; row < 16u; row++)
+    {
+        for(guint col = 0u; col < 16u; col++)
+        {
+            flow.Set(col, row, -5000.0f, 1000.0f);
+            flow.Set(col + 16u, row, NAN, 5000.0f);
+        }
+    }
+
+    std::vector<guint32> packed = Convert(hints, flow, 1u);
+
+    EXPECT_EQ(Unpack(packed[0]).mvx, 2047);
+    EXPECT_EQ(Unpack(packed[0]).mvy, -512);
+    EXPECT_EQ(Unpack(packed[1]).mvy, -512);
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestRejectsInvalidArguments)
+{
+    GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(32u, 32u, ME_HINT_POOLING_MEAN);
+    FlowField flow = MakeConstantFlow(8u, 8u, 8u, 0.0f, 0.0f);
+    std::vector<guint32> packed(gst_cuda_of_me_hints_get_num_blocks(hints));
+
+    EXPECT_FALSE(gst_cuda_of_me_hints_convert(
+        hints, flow.data.data(), flow.Stride(), 2u, flow.cols, flow.rows, 4u, packed.data()));
+    EXPECT_FALSE(gst_cuda_of_me_hints_convert(
+        hints, flow.data.data(), 4u, 8u, flow.cols, flow.rows, 4u, packed.data()));
+    EXPECT_FALSE(gst_cuda_of_me_hints_convert(
+        hints, flow.data.data(), flow.Stride(), 8u, flow.cols, flow.rows, 0u, packed.data()));
+
+    gst_cuda_of_me_hints_free(hints);
+}
+
+TEST(CudaOfMeHintsTest, TestConversionThroughput)
+{
+    std::mt19937 rng(0x4d45u);
+    std::normal_distribution<float> vector_dist(0.0f, 4.0f);
+    FlowField flow = MakeConstantFlow(1920u / 4u, 1080u / 4u, 4u, 0.0f, 0.0f);
+
+    for(guint row = 0u; row < flow.rows; row++)
+    {
+        for(guint col = 0u; col < flow.cols; col++)
+        {
+            flow.Set(col, row, vector_dist(rng), vector_dist(rng));
+        }
+    }
+
+    for(GstCudaOfMeHintPooling pooling : {ME_HINT_POOLING_MEAN, ME_HINT_POOLING_MEDIAN})
+    {
+        GstCudaOfMeHints *hints = gst_cuda_of_me_hints_new(1920u, 1080u, pooling);
+        std::vector<guint32> packed(gst_cuda_of_me_hints_get_num_blocks(hints));
+
+        auto start = std::chrono::steady_clock::now();
+
+        for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+        {
+            gst_cuda_of_me_hints_convert(
+                hints,
+                flow.data.data(),
+                flow.Stride(),
+                flow.element_size,
+                flow.cols,
+                flow.rows,
+                4u,
+                packed.data());
+        }
+
+        auto elapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start);
+
+        ::testing::Test::RecordProperty(
+            pooling == ME_HINT_POOLING_MEAN ? "mean-us-per-1080p-frame"
+                                            : "median-us-per-1080p-frame",
+            std::to_string(static_cast<int>(elapsed.count() / benchmark_iterations)));
+
+        gst_cuda_of_me_hints_free(hints);
+    }
+}
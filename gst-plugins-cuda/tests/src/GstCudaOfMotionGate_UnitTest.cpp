@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <gst/cuda/of/gstcudaofmotiongate.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_rows = 9u;
+    constexpr gsize default_padding = 13u;
+
+    /* A host luma plane with a stride larger than its width */
+    struct LumaPlane
+    {
+        guint width = 0u;
+        guint rows = 0u;
+        gsize stride = 0u;
+        std::vector<guint8> data;
+
+        guint8 &At(guint x, guint y)
+        {
+            return this->data[y * this->stride + x];
+        }
+    };
+
+    LumaPlane MakeRandomPlane(guint width, guint rows, gsize padding, guint seed)
+    {
+        LumaPlane plane;
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<int> distribution(0, 255);
+
+        plane.width = width;
+        plane.rows = rows;
+        plane.stride = width + padding;
+        plane.data.resize(plane.stride * rows);
+
+        for(guint8 &value : plane.data)
+        {
+            value = static_cast<guint8>(distribution(generator));
+        }
+
+        return plane;
+    }
+
+    double ReferenceSad(LumaPlane &current, LumaPlane &previous)
+    {
+        double sum = 0.0;
+
+        for(guint y = 0u; y < current.rows; y++)
+        {
+            for(guint x = 0u; x < current.width; x++)
+            {
+                sum += std::abs(static_cast<int>(current.At(x, y)) - static_cast<int>(previous.At(x, y)));
+            }
+        }
+
+        return sum / (255.0 * current.width * current.rows);
+    }
+
+    double Sad(LumaPlane &current, LumaPlane &previous)
+    {
+        return gst_cuda_of_motion_gate_sad(
+            current.data.data(),
+            current.stride,
+            previous.data.data(),
+            previous.stride,
+            current.width,
+            current.rows);
+    }
+}
+
+TEST(CudaOfMotionGateTest, TestEnumNicks)
+{
+    GEnumClass *klass = G_ENUM_CLASS(g_type_class_ref(GST_TYPE_CUDA_OF_MOTION_GATE));
+
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "disabled"), nullptr);
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "cpu"), nullptr);
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "cuda"), nullptr);
+    g_type_class_unref(klass);
+
+    klass = G_ENUM_CLASS(g_type_class_ref(GST_TYPE_CUDA_OF_MOTION_GATE_METRIC));
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "sad"), nullptr);
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "histogram"), nullptr);
+    g_type_class_unref(klass);
+
+    klass = G_ENUM_CLASS(g_type_class_ref(GST_TYPE_CUDA_OF_MOTION_GATE_SYNTHETIC));
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "zero"), nullptr);
+    ASSERT_NE(g_enum_get_value_by_nick(klass, "reuse"), nullptr);
+    g_type_class_unref(klass);
+}
+
+TEST(CudaOfMotionGateTest, TestSadIdenticalFrames)
+{
+    LumaPlane plane = MakeRandomPlane(1920u, default_rows, default_padding, 1u);
+
+    EXPECT_DOUBLE_EQ(Sad(plane, plane), 0.0);
+}
+
+TEST(CudaOfMotionGateTest, TestSadMatchesReference)
+{
+    /* Widths around the 16 pixel vector width exercise the scalar tail */
+    for(guint width : {1u, 15u, 16u, 17u, 31u, 33u, 640u, 1919u})
+    {
+        LumaPlane current = MakeRandomPlane(width, default_rows, default_padding, width);
+        LumaPlane previous = MakeRandomPlane(width, default_rows, default_padding + 3u, width + 1u);
+
+        EXPECT_NEAR(Sad(current, previous), ReferenceSad(current, previous), 1e-12) << "width " << width;
+        EXPECT_DOUBLE_EQ(Sad(current, previous), Sad(previous, current)) << "width " << width;
+    }
+}
+
+TEST(CudaOfMotionGateTest, TestSadExtremes)
+{
+    LumaPlane black = MakeRandomPlane(100u, default_rows, 0u, 1u);
+    LumaPlane white = MakeRandomPlane(100u, default_rows, 0u, 1u);
+
+    std::fill(black.data.begin(), black.data.end(), 0u);
+    std::fill(white.data.begin(), white.data.end(), 255u);
+
+    EXPECT_DOUBLE_EQ(Sad(black, white), 1.0);
+    EXPECT_DOUBLE_EQ(gst_cuda_of_motion_gate_sad(nullptr, 0u, nullptr, 0u, 0u, 0u), 0.0);
+}
+
+TEST(CudaOfMotionGateTest, TestSadSmallChangeBelowThreshold)
+{
+    LumaPlane previous = MakeRandomPlane(1280u, default_rows, default_padding, 7u);
+    LumaPlane current = previous;
+
+    /* Sensor noise of one level on every other pixel */
+    for(guint y = 0u; y < current.rows; y++)
+    {
+        for(guint x = 0u; x < current.width; x += 2u)
+        {
+            guint8 &value = current.At(x, y);
+            value = static_cast<guint8>(value == 255u ? 254u : value + 1u);
+        }
+    }
+
+    EXPECT_NEAR(Sad(current, previous), 0.5 / 255.0, 1e-12);
+    EXPECT_LT(Sad(current, previous), 0.01);
+}
+
+TEST(CudaOfMotionGateTest, TestHistogram)
+{
+    LumaPlane plane = MakeRandomPlane(333u, default_rows, default_padding, 3u);
+    guint32 bins[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS];
+    guint64 total = 0u;
+
+    gst_cuda_of_motion_gate_histogram(plane.data.data(), plane.stride, plane.width, plane.rows, bins);
+
+    for(guint32 count : bins)
+    {
+        total += count;
+    }
+
+    EXPECT_EQ(total, static_cast<guint64>(plane.width) * plane.rows);
+
+    /* Each bin covers 8 luma values */
+    std::fill(plane.data.begin(), plane.data.end(), 0u);
+    plane.At(0u, 0u) = 7u;
+    plane.At(1u, 0u) = 8u;
+    gst_cuda_of_motion_gate_histogram(plane.data.data(), plane.stride, plane.width, plane.rows, bins);
+
+    EXPECT_EQ(bins[0], plane.width * plane.rows - 1u);
+    EXPECT_EQ(bins[1], 1u);
+}
+
+TEST(CudaOfMotionGateTest, TestHistogramDifference)
+{
+    guint32 current[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS] = {0u};
+    guint32 previous[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS] = {0u};
+
+    EXPECT_DOUBLE_EQ(gst_cuda_of_motion_gate_histogram_difference(current, previous), 0.0);
+
+    current[0] = 100u;
+    previous[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS - 1] = 100u;
+    EXPECT_DOUBLE_EQ(gst_cuda_of_motion_gate_histogram_difference(current, previous), 1.0);
+
+    /* A quarter of the samples moved to the neighbouring bin */
+    previous[GST_CUDA_OF_MOTION_GATE_HISTOGRAM_BINS - 1] = 0u;
+    previous[0] = 75u;
+    previous[1] = 25u;
+    EXPECT_DOUBLE_EQ(gst_cuda_of_motion_gate_histogram_difference(current, previous), 0.25);
+    EXPECT_DOUBLE_EQ(gst_cuda_of_motion_gate_histogram_difference(previous, current), 0.25);
+}
@@ -0,0 +1,187 @@
+#include <vector>
+
+#include <gst/cuda/of/gstcudaofroi.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    std::vector<guint32> Rasterize(const GstCudaOfRoiSet *roi_set, guint width, guint height)
+    {
+        std::vector<guint32> mask(static_cast<gsize>(width) * height, 0xFFFFFFFFu);
+
+        gst_cuda_of_roi_set_rasterize(roi_set, width, height, mask.data());
+
+        return mask;
+    }
+}
+
+TEST(CudaOfRoiTest, TestParsePolygons)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_parse_polygons(roi_set, "0,0 32,0 32,24; 7: 10,10 50,10 50,50 10,50;"));
+    ASSERT_EQ(gst_cuda_of_roi_set_get_size(roi_set), 2u);
+
+    /* A polygon without an ID is numbered by its position */
+    EXPECT_EQ(gst_cuda_of_roi_set_get_id(roi_set, 0u), 0);
+    EXPECT_EQ(gst_cuda_of_roi_set_get_id(roi_set, 1u), 7);
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestParseInvalidPolygons)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    for(const gchar *polygons : {"0,0 32,0", "0,0 32 32,24", "x: 0,0 32,0 32,24", "0,0 32,0 32,24a"})
+    {
+        EXPECT_FALSE(gst_cuda_of_roi_set_parse_polygons(roi_set, polygons)) << polygons;
+    }
+
+    /* Nothing is added from a list that fails part way */
+    EXPECT_FALSE(gst_cuda_of_roi_set_parse_polygons(roi_set, "0,0 32,0 32,24; 0,0"));
+    EXPECT_EQ(gst_cuda_of_roi_set_get_size(roi_set), 0u);
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestRasterizeRectangle)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 3, 2, 1, 3, 2));
+
+    std::vector<guint32> mask = Rasterize(roi_set, 8u, 4u);
+
+    for(guint y = 0u; y < 4u; y++)
+    {
+        for(guint x = 0u; x < 8u; x++)
+        {
+            guint32 expected = (x >= 2u && x < 5u && y >= 1u && y < 3u) ? 1u : 0u;
+
+            EXPECT_EQ(mask[y * 8u + x], expected) << x << "," << y;
+        }
+    }
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestRasterizeOverlappingRegions)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 0, 0, 0, 4, 4));
+    /* A triangle covering the pixels below the diagonal */
+    ASSERT_TRUE(gst_cuda_of_roi_set_parse_polygons(roi_set, "0,0 0,4 4,4"));
+
+    std::vector<guint32> mask = Rasterize(roi_set, 4u, 4u);
+
+    EXPECT_EQ(mask[0], 1u);
+    EXPECT_EQ(mask[3], 1u);
+    EXPECT_EQ(mask[1 * 4 + 0], 3u);
+    EXPECT_EQ(mask[3 * 4 + 2], 3u);
+    EXPECT_EQ(mask[2 * 4 + 3], 1u);
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestMaskLabels)
+{
+    /* Labels 2 and 5 of a 4x2 bitmask, scaled to an 8x4 frame */
+    const guint8 labels[] = {0, 2, 2, 0, 0, 0, 0, 5};
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+    guint x = 0u;
+    guint y = 0u;
+    guint width = 0u;
+    guint height = 0u;
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_mask(roi_set, labels, 4u, 2u, 4u));
+    ASSERT_EQ(gst_cuda_of_roi_set_get_size(roi_set), 2u);
+    EXPECT_EQ(gst_cuda_of_roi_set_get_id(roi_set, 0u), 2);
+    EXPECT_EQ(gst_cuda_of_roi_set_get_id(roi_set, 1u), 5);
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_get_bounds(roi_set, 0, 8u, 4u, &x, &y, &width, &height));
+    EXPECT_EQ(x, 2u);
+    EXPECT_EQ(y, 0u);
+    EXPECT_EQ(width, 4u);
+    EXPECT_EQ(height, 2u);
+
+    std::vector<guint32> mask = Rasterize(roi_set, 8u, 4u);
+
+    EXPECT_EQ(mask[1 * 8 + 5], 1u);
+    EXPECT_EQ(mask[3 * 8 + 7], 2u);
+    EXPECT_EQ(mask[3 * 8 + 0], 0u);
+
+    /* An empty bitmask has no regions to add */
+    const guint8 empty[4] = {};
+    EXPECT_FALSE(gst_cuda_of_roi_set_add_mask(roi_set, empty, 2u, 2u, 2u));
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestBounds)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+    guint x = 0u;
+    guint y = 0u;
+    guint width = 0u;
+    guint height = 0u;
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 0, 4, 4, 4, 4));
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 1, 20, 10, 100, 100));
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_get_bounds(roi_set, -1, 32u, 16u, &x, &y, &width, &height));
+    EXPECT_EQ(x, 4u);
+    EXPECT_EQ(y, 4u);
+    /* The union is clipped to the frame */
+    EXPECT_EQ(width, 28u);
+    EXPECT_EQ(height, 12u);
+
+    /* A region outside of the frame covers nothing */
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 2, 40, 40, 4, 4));
+    EXPECT_FALSE(gst_cuda_of_roi_set_get_bounds(roi_set, 2, 32u, 16u, &x, &y, &width, &height));
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestEqual)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+    GstCudaOfRoiSet *other_roi_set = NULL;
+
+    /* NULL is equal to an empty set */
+    EXPECT_TRUE(gst_cuda_of_roi_set_equal(roi_set, NULL));
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_parse_polygons(roi_set, "0,0 8,0 8,8"));
+    EXPECT_FALSE(gst_cuda_of_roi_set_equal(roi_set, NULL));
+
+    other_roi_set = gst_cuda_of_roi_set_copy(roi_set);
+    EXPECT_TRUE(gst_cuda_of_roi_set_equal(roi_set, other_roi_set));
+
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(other_roi_set, 1, 0, 0, 2, 2));
+    EXPECT_FALSE(gst_cuda_of_roi_set_equal(roi_set, other_roi_set));
+
+    gst_cuda_of_roi_set_free(other_roi_set);
+    gst_cuda_of_roi_set_free(roi_set);
+}
+
+TEST(CudaOfRoiTest, TestActiveTiles)
+{
+    GstCudaOfRoiSet *roi_set = gst_cuda_of_roi_set_new();
+    std::vector<guint32> tiles(12u);
+
+    /* 10x7 pixels split into 4x4 tiles: 3 columns and 2 rows of tiles */
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 0, 3, 0, 2, 1));
+    ASSERT_TRUE(gst_cuda_of_roi_set_add_rectangle(roi_set, 1, 9, 6, 1, 1));
+
+    std::vector<guint32> mask = Rasterize(roi_set, 10u, 7u);
+    guint number_of_tiles = gst_cuda_of_roi_active_tiles(mask.data(), 10u, 7u, 4u, 4u, tiles.data());
+
+    ASSERT_EQ(number_of_tiles, 3u);
+    EXPECT_EQ(tiles[0], 0u);
+    EXPECT_EQ(tiles[1], 1u);
+    EXPECT_EQ(tiles[2], 5u);
+
+    gst_cuda_of_roi_set_free(roi_set);
+}
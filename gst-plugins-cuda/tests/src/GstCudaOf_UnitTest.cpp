@@ -789,4 +789,198 @@ namespace
         Values(
             OPTICAL_FLOW_ALGORITHM_NVIDIA_1_0,
             OPTICAL_FLOW_ALGORITHM_NVIDIA_2_0));
+
+    /*
+     * A ball moving at constant speed is the best case for the warm start:
+     * after the first pair, the previous vectors are almost exactly the
+     * answer, so the adaptive mode should step the iterations down.
+     */
+    TEST(FarnebackWarmStartTest, TestAdaptiveWarmStart)
+    {
+        constexpr guint num_buffers = 30u;
+        constexpr gint number_of_iterations = 10;
+
+        GstElement *pipeline = gst_parse_launch(
+            "videotestsrc num-buffers=30 pattern=ball ! "
+            "video/x-raw,format=NV12,width=320,height=240 ! "
+            "cudaupload ! "
+            "cudaof name=cudaof0 optical-flow-algorithm=farneback "
+            "farneback-number-of-iterations=10 "
+            "farneback-warm-start=adaptive ! "
+            "fakesink sync=false",
+            NULL);
+        ASSERT_NE(pipeline, nullptr);
+
+        GstElement *cudaof = gst_bin_get_by_name(GST_BIN(pipeline), "cudaof0");
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        EXPECT_EQ(GST_MESSAGE_TYPE(message), GST_MESSAGE_EOS);
+        gst_message_unref(message);
+
+        GstStructure *stats = NULL;
+        guint64 frames = 0;
+        guint64 warm_started = 0;
+        GstClockTime mean_time = 0;
+        gint iterations = 0;
+
+        g_object_get(cudaof, "farneback-stats", &stats, NULL);
+        ASSERT_NE(stats, nullptr);
+
+        // clang-format off
+        EXPECT_TRUE(gst_structure_get(stats,
+            "frames", G_TYPE_UINT64, &frames,
+            "warm-started", G_TYPE_UINT64, &warm_started,
+            "mean-time", GST_TYPE_CLOCK_TIME, &mean_time,
+            "number-of-iterations", G_TYPE_INT, &iterations,
+            NULL));
+        // clang-format on
+
+        /*
+         * The first buffer has nothing to compare to, and the first pair has
+         * no previous optical flow to start from.
+         */
+        EXPECT_EQ(frames, num_buffers - 1u);
+        EXPECT_EQ(warm_started, num_buffers - 2u);
+        EXPECT_GT(mean_time, 0u);
+        EXPECT_GE(iterations, 1);
+        EXPECT_LT(iterations, number_of_iterations);
+
+        gst_structure_free(stats);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(cudaof);
+        gst_object_unref(pipeline);
+    }
+
+    TEST(LatencyBudgetTest, TestQualityStepsDownOverBudget)
+    {
+        constexpr gint number_of_levels = 10;
+
+        /*
+         * No frame can be processed within a budget of a nanosecond, so the
+         * controller steps down after the first frame, and again after each
+         * hold-off.
+         */
+        GstElement *pipeline = gst_parse_launch(
+            "videotestsrc num-buffers=40 pattern=ball ! "
+            "video/x-raw,format=NV12,width=320,height=240 ! "
+            "cudaupload ! "
+            "cudaof name=cudaof0 optical-flow-algorithm=farneback "
+            "farneback-number-of-levels=10 latency-budget=1 ! "
+            "fakesink sync=false",
+            NULL);
+        ASSERT_NE(pipeline, nullptr);
+
+        GstElement *cudaof = gst_bin_get_by_name(GST_BIN(pipeline), "cudaof0");
+        GstBus *bus = gst_element_get_bus(pipeline);
+        gint last_quality_level = 0;
+        guint quality_messages = 0u;
+        gboolean eos = FALSE;
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        while(!eos)
+        {
+            GstMessage *message = gst_bus_timed_pop_filtered(
+                bus,
+                GST_CLOCK_TIME_NONE,
+                static_cast<GstMessageType>(
+                    GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_ELEMENT));
+
+            if(GST_MESSAGE_TYPE(message) == GST_MESSAGE_ELEMENT)
+            {
+                const GstStructure *structure
+                    = gst_message_get_structure(message);
+
+                if(gst_structure_has_name(structure, "cudaof-quality"))
+                {
+                    gint quality_level = 0;
+                    gint levels = 0;
+
+                    EXPECT_TRUE(gst_structure_get_int(
+                        structure, "quality-level", &quality_level));
+                    EXPECT_TRUE(gst_structure_get_int(
+                        structure, "farneback-number-of-levels", &levels));
+                    EXPECT_EQ(quality_level, last_quality_level + 1);
+                    EXPECT_EQ(levels, number_of_levels - quality_level);
+
+                    last_quality_level = quality_level;
+                    quality_messages++;
+                }
+            }
+            else
+            {
+                EXPECT_EQ(GST_MESSAGE_TYPE(message), GST_MESSAGE_EOS);
+                eos = TRUE;
+            }
+
+            gst_message_unref(message);
+        }
+
+        gint quality_level = 0;
+
+        g_object_get(cudaof, "quality-level", &quality_level, NULL);
+
+        EXPECT_EQ(quality_messages, 2u);
+        EXPECT_EQ(quality_level, last_quality_level);
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(cudaof);
+        gst_object_unref(pipeline);
+    }
+
+    TEST(FlowScaleTest, TestQuarterScaleFarneback)
+    {
+        constexpr gint flow_scale = 4;
+        constexpr gint width = 320;
+        constexpr gint height = 240;
+
+        GstElement *pipeline = gst_parse_launch(
+            "videotestsrc num-buffers=5 pattern=ball ! "
+            "video/x-raw,format=NV12,width=320,height=240 ! "
+            "cudaupload ! "
+            "cudaof optical-flow-algorithm=farneback flow-scale=1/4 ! "
+            "appsink name=appsink0 sync=false",
+            NULL);
+        ASSERT_NE(pipeline, nullptr);
+
+        GstAppSink *appsink
+            = GST_APP_SINK(gst_bin_get_by_name(GST_BIN(pipeline), "appsink0"));
+        guint metas = 0u;
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        for(GstSample *sample = gst_app_sink_pull_sample(appsink);
+            sample != NULL;
+            sample = gst_app_sink_pull_sample(appsink))
+        {
+            GstMetaOpticalFlow *meta
+                = GST_META_OPTICAL_FLOW_GET(gst_sample_get_buffer(sample));
+
+            if(meta != NULL)
+            {
+                EXPECT_EQ(meta->optical_flow_vector_grid_size, flow_scale);
+                EXPECT_EQ(meta->optical_flow_vectors->cols, width / flow_scale);
+                EXPECT_EQ(meta->optical_flow_vectors->rows, height / flow_scale);
+                EXPECT_EQ(meta->optical_flow_vectors->type(), CV_32FC2);
+                metas++;
+            }
+
+            gst_sample_unref(sample);
+        }
+
+        /* The first buffer has nothing to compare to */
+        EXPECT_EQ(metas, 4u);
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(appsink);
+        gst_object_unref(pipeline);
+    }
 }
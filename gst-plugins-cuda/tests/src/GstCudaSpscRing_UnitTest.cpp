@@ -0,0 +1,263 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gst/cuda/nvcodec/gstcudaspscring.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_capacity = 8u;
+    constexpr std::size_t default_num_items = 200000u;
+    constexpr std::size_t benchmark_num_items = 1000000u;
+
+    /* Tags the items, since the ring cannot hold NULL */
+    gpointer to_item(std::size_t value)
+    {
+        return GSIZE_TO_POINTER(value + 1u);
+    }
+
+    std::size_t from_item(gpointer item)
+    {
+        return GPOINTER_TO_SIZE(item) - 1u;
+    }
+
+    /* Round trip of the items between two threads, the way the encoder
+     * hands its frame states to the bitstream thread and gets them back */
+    template <typename Push, typename Pop>
+    double round_trip_ns(Push push, Pop pop, std::size_t num_items)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::thread worker(
+            [&]()
+            {
+                for(std::size_t idx = 0u; idx < num_items; idx++)
+                {
+                    push(1, pop(0));
+                }
+            });
+
+        for(std::size_t idx = 0u; idx < default_capacity; idx++)
+        {
+            push(0, to_item(idx));
+        }
+
+        for(std::size_t idx = 0u; idx < num_items; idx++)
+        {
+            gpointer item = pop(1);
+
+            if(idx + default_capacity < num_items)
+            {
+                push(0, item);
+            }
+        }
+
+        worker.join();
+
+        return std::chrono::duration<double, std::nano>(
+                   std::chrono::steady_clock::now() - start)
+                   .count()
+               / num_items;
+    }
+}
+
+TEST(CudaSpscRingTest, TestCapacityIsRoundedUp)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(5u);
+
+    EXPECT_EQ(gst_cuda_spsc_ring_get_capacity(ring), 8u);
+
+    for(std::size_t idx = 0u; idx < 8u; idx++)
+    {
+        EXPECT_TRUE(gst_cuda_spsc_ring_try_push(ring, to_item(idx)));
+    }
+
+    EXPECT_FALSE(gst_cuda_spsc_ring_try_push(ring, to_item(8u)));
+    EXPECT_EQ(gst_cuda_spsc_ring_get_length(ring), 8u);
+
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestItemsAreDequeuedInOrder)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(default_capacity);
+
+    EXPECT_EQ(gst_cuda_spsc_ring_try_pop(ring), nullptr);
+
+    /* Wraps around several times */
+    for(std::size_t round = 0u; round < 5u; round++)
+    {
+        for(std::size_t idx = 0u; idx < 6u; idx++)
+        {
+            ASSERT_TRUE(gst_cuda_spsc_ring_push(ring, to_item(round * 6u + idx)));
+        }
+
+        for(std::size_t idx = 0u; idx < 6u; idx++)
+        {
+            EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), round * 6u + idx);
+        }
+    }
+
+    EXPECT_EQ(gst_cuda_spsc_ring_get_length(ring), 0u);
+
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestCloseDrainsQueuedItems)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(default_capacity);
+
+    gst_cuda_spsc_ring_push(ring, to_item(0u));
+    gst_cuda_spsc_ring_push(ring, to_item(1u));
+    gst_cuda_spsc_ring_close(ring);
+
+    EXPECT_TRUE(gst_cuda_spsc_ring_is_closed(ring));
+    EXPECT_FALSE(gst_cuda_spsc_ring_push(ring, to_item(2u)));
+
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 0u);
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 1u);
+    EXPECT_EQ(gst_cuda_spsc_ring_pop(ring), nullptr);
+    EXPECT_EQ(gst_cuda_spsc_ring_pop(ring), nullptr);
+
+    /* Reopening keeps the queued items */
+    gst_cuda_spsc_ring_reopen(ring);
+    EXPECT_TRUE(gst_cuda_spsc_ring_push(ring, to_item(3u)));
+    gst_cuda_spsc_ring_close(ring);
+    gst_cuda_spsc_ring_reopen(ring);
+
+    EXPECT_FALSE(gst_cuda_spsc_ring_is_closed(ring));
+    EXPECT_TRUE(gst_cuda_spsc_ring_push(ring, to_item(4u)));
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 3u);
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 4u);
+
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestPopWaitsForPush)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(default_capacity);
+
+    std::thread producer(
+        [ring]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gst_cuda_spsc_ring_push(ring, to_item(42u));
+        });
+
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 42u);
+
+    producer.join();
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestCloseWakesUpWaitingPop)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(default_capacity);
+
+    std::thread closer(
+        [ring]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gst_cuda_spsc_ring_close(ring);
+        });
+
+    EXPECT_EQ(gst_cuda_spsc_ring_pop(ring), nullptr);
+
+    closer.join();
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestPushWaitsForRoom)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(2u);
+
+    gst_cuda_spsc_ring_push(ring, to_item(0u));
+    gst_cuda_spsc_ring_push(ring, to_item(1u));
+
+    std::thread consumer(
+        [ring]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gst_cuda_spsc_ring_pop(ring);
+        });
+
+    EXPECT_TRUE(gst_cuda_spsc_ring_push(ring, to_item(2u)));
+
+    consumer.join();
+
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 1u);
+    EXPECT_EQ(from_item(gst_cuda_spsc_ring_pop(ring)), 2u);
+
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestConcurrentTransfer)
+{
+    GstCudaSpscRing *ring = gst_cuda_spsc_ring_new(default_capacity);
+    std::size_t num_out_of_order = 0u;
+
+    std::thread producer(
+        [ring]()
+        {
+            for(std::size_t idx = 0u; idx < default_num_items; idx++)
+            {
+                gst_cuda_spsc_ring_push(ring, to_item(idx));
+            }
+
+            gst_cuda_spsc_ring_close(ring);
+        });
+
+    std::size_t expected = 0u;
+    gpointer item;
+
+    while((item = gst_cuda_spsc_ring_pop(ring)))
+    {
+        if(from_item(item) != expected)
+        {
+            num_out_of_order++;
+        }
+
+        expected++;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(expected, default_num_items);
+    EXPECT_EQ(num_out_of_order, 0u);
+
+    gst_cuda_spsc_ring_free(ring);
+}
+
+TEST(CudaSpscRingTest, TestRoundTripThroughput)
+{
+    GstCudaSpscRing *rings[2]
+        = {gst_cuda_spsc_ring_new(default_capacity),
+           gst_cuda_spsc_ring_new(default_capacity)};
+    GAsyncQueue *queues[2] = {g_async_queue_new(), g_async_queue_new()};
+
+    double ring_ns = round_trip_ns(
+        [&](int idx, gpointer item) { gst_cuda_spsc_ring_push(rings[idx], item); },
+        [&](int idx) { return gst_cuda_spsc_ring_pop(rings[idx]); },
+        benchmark_num_items);
+
+    double queue_ns = round_trip_ns(
+        [&](int idx, gpointer item) { g_async_queue_push(queues[idx], item); },
+        [&](int idx) { return g_async_queue_pop(queues[idx]); },
+        benchmark_num_items);
+
+    EXPECT_EQ(gst_cuda_spsc_ring_get_length(rings[0]), 0u);
+    EXPECT_EQ(gst_cuda_spsc_ring_get_length(rings[1]), 0u);
+
+    ::testing::Test::RecordProperty("ring-ns-per-item", std::to_string(ring_ns));
+    ::testing::Test::RecordProperty(
+        "async-queue-ns-per-item", std::to_string(queue_ns));
+
+    for(int idx = 0; idx < 2; idx++)
+    {
+        gst_cuda_spsc_ring_free(rings[idx]);
+        g_async_queue_unref(queues[idx]);
+    }
+}
@@ -0,0 +1,303 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gst/cuda/nvcodec/gstcudasurfacepool.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_initial_size = 20u;
+    constexpr guint default_max_size = 28u;
+    constexpr std::size_t default_num_threads = 4u;
+    constexpr std::size_t default_iterations = 20000u;
+    constexpr std::size_t benchmark_iterations = 1000000u;
+
+    /* The allocation scheme GstNvDecoder used before the pool */
+    class LinearScanPool
+    {
+        public:
+        explicit LinearScanPool(guint size) : available(size, TRUE)
+        {
+        }
+
+        gint Acquire()
+        {
+            for(std::size_t idx = 0u; idx < this->available.size(); idx++)
+            {
+                if(this->available[idx])
+                {
+                    this->available[idx] = FALSE;
+                    return static_cast<gint>(idx);
+                }
+            }
+
+            return -1;
+        }
+
+        void Release(gint index)
+        {
+            this->available[index] = TRUE;
+        }
+
+        private:
+        std::vector<gboolean> available;
+    };
+}
+
+TEST(CudaSurfacePoolTest, TestAcquireGrowsUpToMaxSize)
+{
+    GstCudaSurfacePool *pool
+        = gst_cuda_surface_pool_new(default_initial_size, default_max_size);
+    GstCudaSurfacePoolStats stats;
+
+    for(guint idx = 0u; idx < default_max_size; idx++)
+    {
+        ASSERT_EQ(gst_cuda_surface_pool_acquire(pool, 0), static_cast<gint>(idx));
+
+        gst_cuda_surface_pool_get_stats(pool, &stats);
+        EXPECT_EQ(stats.size, MAX(default_initial_size, idx + 1u));
+    }
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 0), -1);
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.max_size, default_max_size);
+    EXPECT_EQ(stats.in_use, default_max_size);
+    EXPECT_EQ(stats.peak_in_use, default_max_size);
+    EXPECT_EQ(stats.num_acquired, default_max_size);
+    EXPECT_EQ(stats.num_waits, 0u);
+    EXPECT_EQ(stats.num_failures, 1u);
+
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestReleasedSurfacesAreReusedBeforeGrowing)
+{
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(4u, 70u);
+    GstCudaSurfacePoolStats stats;
+
+    for(gint idx = 0; idx < 4; idx++)
+    {
+        ASSERT_EQ(gst_cuda_surface_pool_acquire(pool, 0), idx);
+    }
+
+    gst_cuda_surface_pool_release(pool, 2);
+    gst_cuda_surface_pool_release(pool, 1);
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 0), 1);
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 0), 2);
+
+    /* Across several bitmap words */
+    for(gint idx = 4; idx < 70; idx++)
+    {
+        ASSERT_EQ(gst_cuda_surface_pool_acquire(pool, 0), idx);
+    }
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 0), -1);
+
+    gst_cuda_surface_pool_release(pool, 65);
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 0), 65);
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.size, 70u);
+    EXPECT_EQ(stats.in_use, 70u);
+
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestAcquireTimesOut)
+{
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(2u, 2u);
+    GstCudaSurfacePoolStats stats;
+
+    gst_cuda_surface_pool_acquire(pool, 0);
+    gst_cuda_surface_pool_acquire(pool, 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 20 * GST_MSECOND), -1);
+    EXPECT_GE(
+        std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.num_waits, 1u);
+    EXPECT_EQ(stats.num_failures, 1u);
+
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestAcquireWaitsForRelease)
+{
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(2u, 2u);
+
+    gst_cuda_surface_pool_acquire(pool, 0);
+    gst_cuda_surface_pool_acquire(pool, 0);
+
+    std::thread releaser(
+        [pool]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gst_cuda_surface_pool_release(pool, 1);
+        });
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, GST_CLOCK_TIME_NONE), 1);
+
+    releaser.join();
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestFlushingInterruptsWait)
+{
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(1u, 1u);
+    GstCudaSurfacePoolStats stats;
+
+    gst_cuda_surface_pool_acquire(pool, 0);
+
+    std::thread flusher(
+        [pool]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gst_cuda_surface_pool_set_flushing(pool, TRUE);
+        });
+
+    /* Without flushing, this would wait forever */
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, GST_CLOCK_TIME_NONE), -1);
+
+    flusher.join();
+
+    /* While flushing, acquiring does not wait at all */
+    auto start = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, GST_SECOND), -1);
+    EXPECT_LT(
+        std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.num_failures, 2u);
+
+    /* Free surfaces are still handed out, and waiting works again afterwards */
+    gst_cuda_surface_pool_release(pool, 0);
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, GST_SECOND), 0);
+
+    gst_cuda_surface_pool_set_flushing(pool, FALSE);
+    EXPECT_EQ(gst_cuda_surface_pool_acquire(pool, 10 * GST_MSECOND), -1);
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.num_waits, 2u);
+
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestConcurrentAcquireRelease)
+{
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(4u, 8u);
+    std::vector<std::atomic<int>> owners(8u);
+    std::atomic<bool> double_acquire(false);
+    std::vector<std::thread> threads;
+    GstCudaSurfacePoolStats stats;
+
+    for(auto &owner : owners)
+    {
+        owner = 0;
+    }
+
+    /* Each thread holds up to two surfaces, so that the threads have to grow
+     * the pool and wait for each other without ever running out */
+    for(std::size_t thread_idx = 0u; thread_idx < default_num_threads; thread_idx++)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                for(std::size_t iteration = 0u; iteration < default_iterations;
+                    iteration++)
+                {
+                    gint first = gst_cuda_surface_pool_acquire(pool, GST_CLOCK_TIME_NONE);
+                    gint second = gst_cuda_surface_pool_acquire(pool, GST_CLOCK_TIME_NONE);
+
+                    if(owners[first].fetch_add(1) != 0
+                       || owners[second].fetch_add(1) != 0)
+                    {
+                        double_acquire = true;
+                    }
+
+                    owners[first].fetch_sub(1);
+                    owners[second].fetch_sub(1);
+                    gst_cuda_surface_pool_release(pool, second);
+                    gst_cuda_surface_pool_release(pool, first);
+                }
+            });
+    }
+
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_FALSE(double_acquire.load());
+
+    gst_cuda_surface_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.in_use, 0u);
+    EXPECT_LE(stats.peak_in_use, 8u);
+    EXPECT_LE(stats.size, 8u);
+    EXPECT_EQ(stats.num_acquired, 2u * default_num_threads * default_iterations);
+    EXPECT_EQ(stats.num_failures, 0u);
+
+    gst_cuda_surface_pool_unref(pool);
+}
+
+TEST(CudaSurfacePoolTest, TestAcquireReleaseThroughput)
+{
+    /* Typical H.264 decoding: the DPB holds most surfaces, a few are in
+     * flight */
+    GstCudaSurfacePool *pool = gst_cuda_surface_pool_new(default_initial_size, default_initial_size);
+    LinearScanPool linear_pool(default_initial_size);
+    gint checksum = 0;
+    gint linear_checksum = 0;
+
+    for(guint idx = 0u; idx < default_initial_size - 4u; idx++)
+    {
+        gst_cuda_surface_pool_acquire(pool, 0);
+        linear_pool.Acquire();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+    {
+        gint index = gst_cuda_surface_pool_acquire(pool, 0);
+
+        checksum += index;
+        gst_cuda_surface_pool_release(pool, index);
+    }
+
+    auto pool_elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+
+    for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+    {
+        gint index = linear_pool.Acquire();
+
+        linear_checksum += index;
+        linear_pool.Release(index);
+    }
+
+    auto linear_elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(checksum, linear_checksum);
+
+    ::testing::Test::RecordProperty(
+        "pool-ns-per-surface",
+        std::to_string(pool_elapsed.count() / benchmark_iterations));
+    ::testing::Test::RecordProperty(
+        "linear-scan-ns-per-surface",
+        std::to_string(linear_elapsed.count() / benchmark_iterations));
+
+    gst_cuda_surface_pool_unref(pool);
+}
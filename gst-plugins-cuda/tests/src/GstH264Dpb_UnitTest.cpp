@@ -0,0 +1,481 @@
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <gst/codecs/gsth264decoder.h>
+#include <gst/codecs/gsth264picture.h>
+#include <gst/codecs/gsth265picture.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr gint default_max_frame_num = 256;
+    constexpr gint default_max_num_ref_frames = GST_H264_DPB_MAX_SIZE - 1;
+    constexpr std::size_t stress_picture_count = 200000u;
+    constexpr std::size_t lookup_benchmark_count = 2000000u;
+
+    GstH264Picture *FindShortRefByLinearScan(GstH264Dpb *dpb, gint pic_num)
+    {
+        guint num_pictures = 0u;
+        GstH264Picture *const *pictures
+            = gst_h264_dpb_peek_pictures_all(dpb, &num_pictures);
+
+        for(guint idx = 0u; idx < num_pictures; idx++)
+        {
+            if(GST_H264_PICTURE_IS_SHORT_TERM_REF(pictures[idx])
+               && pictures[idx]->pic_num == pic_num)
+            {
+                return pictures[idx];
+            }
+        }
+
+        return nullptr;
+    }
+
+    GstH264Picture *
+    FindLongRefByLinearScan(GstH264Dpb *dpb, gint long_term_pic_num)
+    {
+        guint num_pictures = 0u;
+        GstH264Picture *const *pictures
+            = gst_h264_dpb_peek_pictures_all(dpb, &num_pictures);
+
+        for(guint idx = 0u; idx < num_pictures; idx++)
+        {
+            if(GST_H264_PICTURE_IS_LONG_TERM_REF(pictures[idx])
+               && pictures[idx]->long_term_pic_num == long_term_pic_num)
+            {
+                return pictures[idx];
+            }
+        }
+
+        return nullptr;
+    }
+
+    GstH264Picture *NewFramePicture(guint32 system_frame_number, gint frame_num)
+    {
+        GstH264Picture *picture = gst_h264_picture_new();
+
+        picture->system_frame_number = system_frame_number;
+        picture->frame_num = frame_num;
+        picture->pic_num = frame_num;
+        picture->pic_order_cnt = static_cast<gint>(system_frame_number) * 2;
+        picture->top_field_order_cnt = picture->pic_order_cnt;
+        picture->bottom_field_order_cnt = picture->pic_order_cnt;
+        picture->nal_ref_idc = 1;
+        picture->ref = GST_H264_PICTURE_REF_SHORT_TERM;
+        picture->ref_pic = TRUE;
+
+        return picture;
+    }
+}
+
+class H264DpbTestFixture : public ::testing::Test
+{
+    protected:
+    GstH264Dpb *dpb = nullptr;
+    gint max_long_term_frame_idx = 3;
+
+    void SetUp() override
+    {
+        // The DPB logs into the decoder's debug category.
+        g_type_class_unref(g_type_class_ref(GST_TYPE_H264_DECODER));
+
+        this->dpb = gst_h264_dpb_new();
+        gst_h264_dpb_set_max_num_frames(this->dpb, GST_H264_DPB_MAX_SIZE);
+        gst_h264_dpb_set_interlaced(this->dpb, FALSE);
+        gst_h264_dpb_set_max_num_reorder_frames(
+            this->dpb, GST_H264_DPB_MAX_SIZE);
+    }
+
+    void TearDown() override
+    {
+        if(this->dpb != nullptr)
+        {
+            gst_h264_dpb_free(this->dpb);
+            this->dpb = nullptr;
+        }
+    }
+
+    void SlidingWindowMarking()
+    {
+        while(gst_h264_dpb_num_ref_frames(this->dpb)
+              >= default_max_num_ref_frames)
+        {
+            GstH264Picture *to_unmark
+                = gst_h264_dpb_get_lowest_frame_num_short_ref(this->dpb);
+
+            if(to_unmark == nullptr)
+            {
+                break;
+            }
+
+            to_unmark->ref = GST_H264_PICTURE_REF_NONE;
+            gst_h264_picture_unref(to_unmark);
+        }
+    }
+
+    void ApplyMmco(GstH264Picture *current, std::size_t iteration)
+    {
+        GstH264RefPicMarking marking = {};
+
+        // MMCO-1 on a picture a few frames back.
+        marking.memory_management_control_operation = 1;
+        marking.difference_of_pic_nums_minus1 = iteration % 7u;
+        gint pic_num_x = current->pic_num
+                         - static_cast<gint>(
+                             marking.difference_of_pic_nums_minus1 + 1);
+        EXPECT_EQ(
+            gst_h264_dpb_get_short_ref_by_pic_num(this->dpb, pic_num_x),
+            FindShortRefByLinearScan(this->dpb, pic_num_x));
+        gst_h264_dpb_perform_memory_management_control_operation(
+            this->dpb, &marking, current);
+
+        // MMCO-3, short-term to long-term.
+        if(iteration % 4u == 0u)
+        {
+            marking.memory_management_control_operation = 3;
+            marking.difference_of_pic_nums_minus1 = 0;
+            marking.long_term_frame_idx
+                = iteration % (this->max_long_term_frame_idx + 1);
+            gst_h264_dpb_perform_memory_management_control_operation(
+                this->dpb, &marking, current);
+        }
+
+        // MMCO-2 on one of the long-term pictures.
+        if(iteration % 16u == 8u)
+        {
+            marking.memory_management_control_operation = 2;
+            marking.long_term_pic_num = iteration % 3u;
+            EXPECT_EQ(
+                gst_h264_dpb_get_long_ref_by_long_term_pic_num(
+                    this->dpb, marking.long_term_pic_num),
+                FindLongRefByLinearScan(this->dpb, marking.long_term_pic_num));
+            gst_h264_dpb_perform_memory_management_control_operation(
+                this->dpb, &marking, current);
+        }
+    }
+
+    void DecodePicture(guint32 system_frame_number)
+    {
+        gint frame_num = static_cast<gint>(
+            system_frame_number % static_cast<guint32>(default_max_frame_num));
+        GstH264Picture *picture
+            = NewFramePicture(system_frame_number, frame_num);
+
+        gst_h264_dpb_update_pic_nums(
+            this->dpb, picture, frame_num, default_max_frame_num);
+
+        if(system_frame_number > 0u)
+        {
+            this->ApplyMmco(picture, system_frame_number);
+        }
+
+        this->SlidingWindowMarking();
+        gst_h264_dpb_delete_unused(this->dpb);
+
+        while(gst_h264_dpb_needs_bump(
+            this->dpb, picture, GST_H264_DPB_BUMP_NORMAL_LATENCY))
+        {
+            GstH264Picture *to_output = gst_h264_dpb_bump(this->dpb, FALSE);
+
+            if(to_output == nullptr)
+            {
+                break;
+            }
+
+            gst_h264_picture_unref(to_output);
+        }
+
+        gst_h264_dpb_add(this->dpb, picture);
+    }
+};
+
+TEST_F(H264DpbTestFixture, TestIndexedLookupsMatchLinearScan)
+{
+    for(guint32 idx = 0u; idx < GST_H264_DPB_MAX_SIZE; idx++)
+    {
+        gst_h264_dpb_add(
+            this->dpb, NewFramePicture(idx, static_cast<gint>(idx)));
+    }
+
+    GstH264Picture *current = NewFramePicture(
+        GST_H264_DPB_MAX_SIZE, static_cast<gint>(GST_H264_DPB_MAX_SIZE));
+    gst_h264_dpb_update_pic_nums(
+        this->dpb,
+        current,
+        static_cast<gint>(GST_H264_DPB_MAX_SIZE),
+        default_max_frame_num);
+
+    for(gint pic_num = -4; pic_num < GST_H264_DPB_MAX_SIZE + 4; pic_num++)
+    {
+        EXPECT_EQ(
+            gst_h264_dpb_get_short_ref_by_pic_num(this->dpb, pic_num),
+            FindShortRefByLinearScan(this->dpb, pic_num));
+    }
+
+    for(guint32 idx = 0u; idx < GST_H264_DPB_MAX_SIZE; idx++)
+    {
+        GstH264Picture *picture = gst_h264_dpb_get_picture(this->dpb, idx);
+
+        ASSERT_NE(picture, nullptr);
+        EXPECT_EQ(picture->system_frame_number, idx);
+        gst_h264_picture_unref(picture);
+    }
+
+    EXPECT_EQ(
+        gst_h264_dpb_get_picture(this->dpb, GST_H264_DPB_MAX_SIZE + 1),
+        nullptr);
+
+    GstH264Picture *refs[GST_H264_DPB_MAX_NUM_PICTURES];
+    guint num_refs = gst_h264_dpb_peek_pictures_short_term_ref(
+        this->dpb, FALSE, FALSE, refs, G_N_ELEMENTS(refs));
+    EXPECT_EQ(num_refs, static_cast<guint>(GST_H264_DPB_MAX_SIZE));
+
+    gst_h264_picture_unref(current);
+}
+
+TEST_F(H264DpbTestFixture, TestStalePicNumsDoNotShadowReferences)
+{
+    // Non-reference pictures keep the pic_num they were decoded with, which
+    // a later reference picture may get as well.
+    for(guint32 idx = 0u; idx < 4u; idx++)
+    {
+        GstH264Picture *picture = NewFramePicture(idx, 7);
+
+        picture->ref = GST_H264_PICTURE_REF_NONE;
+        gst_h264_dpb_add(this->dpb, picture);
+    }
+
+    gst_h264_dpb_add(this->dpb, NewFramePicture(4u, 7));
+    gst_h264_dpb_add(this->dpb, NewFramePicture(5u, 9));
+
+    GstH264Picture *picture
+        = gst_h264_dpb_get_short_ref_by_pic_num(this->dpb, 7);
+
+    ASSERT_NE(picture, nullptr);
+    EXPECT_EQ(picture->system_frame_number, 4u);
+
+    // Removing pictures in front of the others renumbers their entries.
+    for(guint32 idx = 0u; idx < 4u; idx++)
+    {
+        GstH264Picture *output = gst_h264_dpb_bump(this->dpb, TRUE);
+
+        ASSERT_NE(output, nullptr);
+        gst_h264_picture_unref(output);
+    }
+
+    gst_h264_dpb_delete_unused(this->dpb);
+    ASSERT_EQ(gst_h264_dpb_get_size(this->dpb), 2);
+
+    for(gint pic_num = 6; pic_num < 11; pic_num++)
+    {
+        EXPECT_EQ(
+            gst_h264_dpb_get_short_ref_by_pic_num(this->dpb, pic_num),
+            FindShortRefByLinearScan(this->dpb, pic_num));
+    }
+
+    for(guint32 idx = 0u; idx < 6u; idx++)
+    {
+        picture = gst_h264_dpb_get_picture(this->dpb, idx);
+
+        EXPECT_EQ(picture != nullptr, idx >= 4u) << "Frame " << idx;
+        g_clear_pointer(&picture, gst_h264_picture_unref);
+    }
+}
+
+TEST_F(H264DpbTestFixture, TestPictureDroppedWhenFullIsNotLinked)
+{
+    GstH264Picture *first_field = NewFramePicture(0u, 0);
+
+    first_field->field = GST_H264_PICTURE_FIELD_TOP_FIELD;
+    gst_h264_dpb_add(this->dpb, first_field);
+
+    // Fills the DPB up, whatever its size, as the pictures are never bumped.
+    guint32 num_pictures = 1u;
+
+    while(gst_h264_dpb_get_size(this->dpb) == static_cast<gint>(num_pictures))
+    {
+        gst_h264_dpb_add(
+            this->dpb,
+            NewFramePicture(num_pictures, static_cast<gint>(num_pictures)));
+        num_pictures++;
+    }
+
+    GstH264Picture *second_field = NewFramePicture(num_pictures, 0);
+
+    second_field->field = GST_H264_PICTURE_FIELD_BOTTOM_FIELD;
+    second_field->second_field = TRUE;
+    second_field->other_field = first_field;
+    gst_h264_dpb_add(this->dpb, second_field);
+
+    // The dropped picture is not left behind as the other field.
+    EXPECT_EQ(first_field->other_field, nullptr);
+    EXPECT_EQ(
+        gst_h264_dpb_get_size(this->dpb), static_cast<gint>(num_pictures - 1u));
+}
+
+TEST_F(H264DpbTestFixture, TestIndexedLookupBenchmark)
+{
+    for(guint32 idx = 0u; idx < GST_H264_DPB_MAX_SIZE; idx++)
+    {
+        gst_h264_dpb_add(
+            this->dpb, NewFramePicture(idx, static_cast<gint>(idx)));
+    }
+
+    std::vector<gint> pic_nums(lookup_benchmark_count);
+    std::vector<GstH264Picture *> results(lookup_benchmark_count);
+
+    for(std::size_t idx = 0u; idx < lookup_benchmark_count; idx++)
+    {
+        // Mostly hits, as in a reference picture list modification.
+        pic_nums[idx]
+            = static_cast<gint>((idx * 7u) % (GST_H264_DPB_MAX_SIZE + 2));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t idx = 0u; idx < lookup_benchmark_count; idx++)
+    {
+        results[idx] = FindShortRefByLinearScan(this->dpb, pic_nums[idx]);
+    }
+
+    auto linear_elapsed
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+
+    for(std::size_t idx = 0u; idx < lookup_benchmark_count; idx++)
+    {
+        if(gst_h264_dpb_get_short_ref_by_pic_num(this->dpb, pic_nums[idx])
+           != results[idx])
+        {
+            ADD_FAILURE() << "Lookup of pic_num " << pic_nums[idx];
+        }
+    }
+
+    auto indexed_elapsed
+        = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start);
+
+    ::testing::Test::RecordProperty(
+        "linear-nanoseconds-per-lookup",
+        std::to_string(linear_elapsed.count() / lookup_benchmark_count));
+    ::testing::Test::RecordProperty(
+        "indexed-nanoseconds-per-lookup",
+        std::to_string(indexed_elapsed.count() / lookup_benchmark_count));
+}
+
+TEST_F(H264DpbTestFixture, TestMmcoHeavyStressBenchmark)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t idx = 0u; idx < stress_picture_count; idx++)
+    {
+        this->DecodePicture(static_cast<guint32>(idx));
+
+        ASSERT_LE(
+            gst_h264_dpb_get_size(this->dpb), GST_H264_DPB_MAX_SIZE + 1);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    ::testing::Test::RecordProperty(
+        "nanoseconds-per-picture",
+        std::to_string(elapsed.count() / stress_picture_count));
+
+    while(GstH264Picture *picture = gst_h264_dpb_bump(this->dpb, TRUE))
+    {
+        gst_h264_picture_unref(picture);
+    }
+
+    gst_h264_dpb_delete_unused(this->dpb);
+}
+
+TEST(H265DpbTest, TestIndexedPocLookups)
+{
+    GstH265Dpb *dpb = gst_h265_dpb_new();
+
+    gst_h265_dpb_set_max_num_pics(dpb, GST_H265_DPB_MAX_SIZE);
+
+    for(guint32 idx = 0u; idx < GST_H265_DPB_MAX_SIZE; idx++)
+    {
+        GstH265Picture *picture = gst_h265_picture_new();
+
+        picture->system_frame_number = idx;
+        picture->pic_order_cnt = static_cast<gint>(idx) * 2;
+        picture->pic_order_cnt_lsb = picture->pic_order_cnt & 0xf;
+        picture->output_flag = TRUE;
+
+        gst_h265_dpb_add(dpb, picture);
+    }
+
+    for(gint poc = 0; poc < GST_H265_DPB_MAX_SIZE * 2; poc += 2)
+    {
+        GstH265Picture *picture = gst_h265_dpb_get_short_ref_by_poc(dpb, poc);
+
+        ASSERT_NE(picture, nullptr);
+        EXPECT_EQ(picture->pic_order_cnt, poc);
+
+        // Unmarking invalidates the indexed entry without a rebuild.
+        picture->ref = FALSE;
+        gst_h265_picture_unref(picture);
+
+        EXPECT_EQ(gst_h265_dpb_get_short_ref_by_poc(dpb, poc), nullptr);
+    }
+
+    guint num_pictures = 0u;
+    gst_h265_dpb_peek_pictures_all(dpb, &num_pictures);
+    EXPECT_EQ(num_pictures, static_cast<guint>(GST_H265_DPB_MAX_SIZE));
+
+    gst_h265_dpb_free(dpb);
+}
+
+TEST(H265DpbTest, TestLookupsAfterRemoval)
+{
+    GstH265Dpb *dpb = gst_h265_dpb_new();
+
+    gst_h265_dpb_set_max_num_pics(dpb, GST_H265_DPB_MAX_SIZE);
+
+    for(guint32 idx = 0u; idx < GST_H265_DPB_MAX_SIZE; idx++)
+    {
+        GstH265Picture *picture = gst_h265_picture_new();
+
+        picture->system_frame_number = idx;
+        picture->pic_order_cnt = static_cast<gint>(idx) * 2;
+        picture->pic_order_cnt_lsb = picture->pic_order_cnt & 0xf;
+        picture->output_flag = FALSE;
+
+        gst_h265_dpb_add(dpb, picture);
+    }
+
+    // Every other picture is unused, the others move down to fill the holes.
+    for(guint32 idx = 1u; idx < GST_H265_DPB_MAX_SIZE; idx += 2u)
+    {
+        GstH265Picture *picture = gst_h265_dpb_get_picture(dpb, idx);
+
+        ASSERT_NE(picture, nullptr);
+        picture->ref = FALSE;
+        gst_h265_picture_unref(picture);
+    }
+
+    gst_h265_dpb_delete_unused(dpb);
+    EXPECT_EQ(gst_h265_dpb_get_size(dpb), (GST_H265_DPB_MAX_SIZE + 1) / 2);
+
+    for(guint32 idx = 0u; idx < GST_H265_DPB_MAX_SIZE; idx++)
+    {
+        GstH265Picture *picture = gst_h265_dpb_get_picture(dpb, idx);
+        GstH265Picture *ref
+            = gst_h265_dpb_get_ref_by_poc(dpb, static_cast<gint>(idx) * 2);
+
+        EXPECT_EQ(picture != nullptr, idx % 2u == 0u) << "Frame " << idx;
+        EXPECT_EQ(ref, picture) << "Frame " << idx;
+
+        g_clear_pointer(&picture, gst_h265_picture_unref);
+        g_clear_pointer(&ref, gst_h265_picture_unref);
+    }
+
+    gst_h265_dpb_free(dpb);
+}
@@ -0,0 +1,254 @@
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gst/codecparsers/gstjpegparser.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr std::size_t default_num_restarts = 64u;
+    constexpr std::size_t default_interval_size = 512u;
+    /* About the size of a 4K MJPEG frame */
+    constexpr std::size_t benchmark_interval_size = 8192u;
+    constexpr std::size_t benchmark_num_restarts = 128u;
+    constexpr std::size_t benchmark_iterations = 200u;
+
+    struct SyntheticJpeg
+    {
+        std::vector<guint8> data;
+        std::vector<GstJpegMarker> markers;
+        std::vector<guint> restarts;
+    };
+
+    void AppendMarker(SyntheticJpeg &jpeg, GstJpegMarker marker)
+    {
+        jpeg.data.push_back(0xff);
+        jpeg.data.push_back(static_cast<guint8>(marker));
+    }
+
+    void AppendSegment(SyntheticJpeg &jpeg, GstJpegMarker marker, std::size_t payload_size)
+    {
+        std::size_t length = payload_size + 2u;
+
+        AppendMarker(jpeg, marker);
+        jpeg.markers.push_back(marker);
+        jpeg.data.push_back(static_cast<guint8>(length >> 8));
+        jpeg.data.push_back(static_cast<guint8>(length & 0xff));
+        jpeg.data.insert(jpeg.data.end(), payload_size, 0x11);
+    }
+
+    /* Entropy coded data has stuffed 0xff00 pairs and may have fill bytes in
+     * front of a marker */
+    void AppendEntropyCodedData(SyntheticJpeg &jpeg, std::mt19937 &rng, std::size_t size)
+    {
+        std::uniform_int_distribution<int> byte_dist(0, 255);
+
+        for(std::size_t idx = 0u; idx < size; idx++)
+        {
+            auto byte = static_cast<guint8>(byte_dist(rng));
+
+            jpeg.data.push_back(byte);
+
+            if(byte == 0xff)
+            {
+                jpeg.data.push_back(0x00);
+            }
+        }
+    }
+
+    SyntheticJpeg BuildJpeg(std::size_t num_restarts, std::size_t interval_size)
+    {
+        std::mt19937 rng(0x4a50u);
+        SyntheticJpeg jpeg;
+
+        AppendMarker(jpeg, GST_JPEG_MARKER_SOI);
+        jpeg.markers.push_back(GST_JPEG_MARKER_SOI);
+        AppendSegment(jpeg, GST_JPEG_MARKER_APP0, 14u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_DQT, 65u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_DQT, 65u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_SOF0, 15u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_DHT, 29u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_DHT, 179u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_DRI, 2u);
+        AppendSegment(jpeg, GST_JPEG_MARKER_SOS, 10u);
+
+        for(std::size_t idx = 0u; idx < num_restarts; idx++)
+        {
+            AppendEntropyCodedData(jpeg, rng, interval_size);
+
+            if(idx % 2u)
+            {
+                jpeg.data.push_back(0xff);
+            }
+
+            AppendMarker(
+                jpeg, static_cast<GstJpegMarker>(GST_JPEG_MARKER_RST_MIN + idx % 8u));
+            jpeg.restarts.push_back(static_cast<guint>(jpeg.data.size()));
+        }
+
+        AppendEntropyCodedData(jpeg, rng, interval_size);
+        AppendMarker(jpeg, GST_JPEG_MARKER_EOI);
+        jpeg.markers.push_back(GST_JPEG_MARKER_EOI);
+
+        return jpeg;
+    }
+
+    /* The byte by byte scan used before */
+    gint ScanForMarkerCodeByteByByte(const guint8 *data, gsize size, guint offset)
+    {
+        guint idx = offset + 1u;
+
+        while(idx < size)
+        {
+            const guint8 value = data[idx];
+
+            if(value < 0xc0)
+            {
+                idx += 2u;
+            }
+            else if(value < 0xff && data[idx - 1u] == 0xff)
+            {
+                return static_cast<gint>(idx - 1u);
+            }
+            else
+            {
+                idx++;
+            }
+        }
+
+        return -1;
+    }
+}
+
+TEST(JpegParserTest, TestParseMatchesByteByByteScan)
+{
+    std::mt19937 rng(0x4d4au);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    std::uniform_int_distribution<std::size_t> size_dist(0u, 300u);
+
+    for(std::size_t buffer_idx = 0u; buffer_idx < 2000u; buffer_idx++)
+    {
+        std::vector<guint8> data(size_dist(rng));
+
+        /* Mostly 0xff, so that fill bytes and stuffing show up everywhere */
+        for(guint8 &byte : data)
+        {
+            byte = byte_dist(rng) < 96 ? 0xff : static_cast<guint8>(byte_dist(rng));
+        }
+
+        /* Only keep markers without length field, so that gst_jpeg_parse()
+         * does not fail on the random segment lengths */
+        for(std::size_t idx = 1u; idx < data.size(); idx++)
+        {
+            if(data[idx - 1u] == 0xff && data[idx] >= 0xc0 && data[idx] < 0xff)
+            {
+                data[idx] = static_cast<guint8>(GST_JPEG_MARKER_RST_MIN + data[idx] % 10u);
+            }
+        }
+
+        for(guint offset = 0u; offset < data.size(); offset++)
+        {
+            GstJpegSegment seg;
+            gint expected = ScanForMarkerCodeByteByByte(data.data(), data.size(), offset);
+            gboolean found = gst_jpeg_parse(&seg, data.data(), data.size(), offset);
+
+            if(expected < 0)
+            {
+                EXPECT_FALSE(found);
+                continue;
+            }
+
+            ASSERT_TRUE(found) << "buffer " << buffer_idx << " offset " << offset;
+            EXPECT_EQ(seg.offset, static_cast<guint>(expected) + 2u);
+            EXPECT_EQ(seg.marker, static_cast<GstJpegMarker>(data[expected + 1]));
+        }
+    }
+}
+
+TEST(JpegParserTest, TestParseAllSegments)
+{
+    SyntheticJpeg jpeg = BuildJpeg(default_num_restarts, default_interval_size);
+    GstJpegSegmentIndex index;
+
+    gst_jpeg_segment_index_init(&index);
+
+    ASSERT_TRUE(gst_jpeg_parse_all_segments(&index, jpeg.data.data(), jpeg.data.size(), 0u));
+    ASSERT_EQ(index.segments->len, jpeg.markers.size());
+
+    for(guint idx = 0u; idx < index.segments->len; idx++)
+    {
+        EXPECT_EQ(g_array_index(index.segments, GstJpegSegment, idx).marker, jpeg.markers[idx]);
+    }
+
+    EXPECT_EQ(index.sof, 4);
+    EXPECT_EQ(index.sos, 8);
+    EXPECT_EQ(index.eoi, static_cast<gint>(jpeg.markers.size()) - 1);
+
+    ASSERT_EQ(index.restarts->len, jpeg.restarts.size());
+
+    for(guint idx = 0u; idx < index.restarts->len; idx++)
+    {
+        EXPECT_EQ(g_array_index(index.restarts, guint, idx), jpeg.restarts[idx]);
+    }
+
+    /* The index is reused for the next frame */
+    ASSERT_TRUE(gst_jpeg_parse_all_segments(&index, jpeg.data.data(), jpeg.data.size(), 0u));
+    EXPECT_EQ(index.segments->len, jpeg.markers.size());
+    EXPECT_EQ(index.restarts->len, jpeg.restarts.size());
+
+    gst_jpeg_segment_index_clear(&index);
+}
+
+TEST(JpegParserTest, TestParseAllSegmentsTruncated)
+{
+    SyntheticJpeg jpeg = BuildJpeg(default_num_restarts, default_interval_size);
+    GstJpegSegmentIndex index;
+
+    gst_jpeg_segment_index_init(&index);
+
+    /* Cut in the middle of the scan, the headers are still usable */
+    EXPECT_TRUE(gst_jpeg_parse_all_segments(
+        &index, jpeg.data.data(), jpeg.data.size() / 2u, 0u));
+    EXPECT_EQ(index.eoi, -1);
+    EXPECT_LT(index.restarts->len, jpeg.restarts.size());
+
+    /* Cut in the middle of the frame header */
+    EXPECT_FALSE(gst_jpeg_parse_all_segments(&index, jpeg.data.data(), 170u, 0u));
+    EXPECT_EQ(index.sof, -1);
+
+    gst_jpeg_segment_index_clear(&index);
+}
+
+TEST(JpegParserTest, TestParseAllSegmentsThroughput)
+{
+    SyntheticJpeg jpeg = BuildJpeg(benchmark_num_restarts, benchmark_interval_size);
+    GstJpegSegmentIndex index;
+    std::size_t num_segments = 0u;
+
+    gst_jpeg_segment_index_init(&index);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+    {
+        gst_jpeg_parse_all_segments(&index, jpeg.data.data(), jpeg.data.size(), 0u);
+        num_segments += index.segments->len + index.restarts->len;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(
+        num_segments,
+        benchmark_iterations * (jpeg.markers.size() + jpeg.restarts.size()));
+
+    ::testing::Test::RecordProperty(
+        "megabytes-per-second",
+        std::to_string(static_cast<int>(
+            jpeg.data.size() * benchmark_iterations / elapsed.count() / 1e6)));
+
+    gst_jpeg_segment_index_clear(&index);
+}
@@ -0,0 +1,203 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <malloc.h>
+#include <vector>
+
+#include <gst/cuda/featureextractor/gstalgorithmfeatures.h>
+#include <gst/cuda/featureextractor/gstalgorithmfeaturespool.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+/*
+ * The allocations of the thread running a test are counted by interposing the
+ * allocation functions of glibc, which GLib and the C++ runtime both end up
+ * in. This replaces them for the whole executable, which is why these tests
+ * are built into their own one. They are only counted while an
+ * AllocationCounter is alive.
+ */
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t number, size_t size);
+    void *__libc_realloc(void *pointer, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+    thread_local bool count_allocations = false;
+    thread_local std::size_t number_of_allocations = 0u;
+
+    class AllocationCounter
+    {
+        public:
+        AllocationCounter()
+        {
+            number_of_allocations = 0u;
+            count_allocations = true;
+        }
+
+        ~AllocationCounter()
+        {
+            count_allocations = false;
+        }
+
+        std::size_t Count() const
+        {
+            return number_of_allocations;
+        }
+    };
+
+    void CountAllocation()
+    {
+        if(count_allocations)
+        {
+            number_of_allocations++;
+        }
+    }
+}
+
+extern "C" void *malloc(size_t size)
+{
+    CountAllocation();
+
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t number, size_t size)
+{
+    CountAllocation();
+
+    return __libc_calloc(number, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    CountAllocation();
+
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size)
+{
+    CountAllocation();
+
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    CountAllocation();
+
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+    CountAllocation();
+
+    if(alignment % sizeof(void *) != 0u || (alignment & (alignment - 1u)) != 0u)
+    {
+        return EINVAL;
+    }
+
+    void *memory = __libc_memalign(alignment, size);
+
+    if(memory == nullptr)
+    {
+        return ENOMEM;
+    }
+
+    *pointer = memory;
+
+    return 0;
+}
+
+namespace
+{
+    constexpr guint default_features_matrix_width = 20u;
+    constexpr guint default_features_matrix_height = 20u;
+    constexpr guint default_features_per_aggregation = 10u;
+    constexpr std::size_t steady_state_iterations = 1000u;
+}
+
+TEST(MetaAlgorithmFeaturesAllocationsTest, TestCounterSeesEveryAllocator)
+{
+    AllocationCounter counter;
+    void *memory = nullptr;
+
+    g_free(g_malloc(16u));
+    g_free(g_malloc0(16u));
+    g_free(g_realloc(nullptr, 16u));
+
+    /* Volatile, so that the compiler cannot elide the pairs of calls */
+    void *volatile aligned_memory = aligned_alloc(64u, 64u);
+    free(aligned_memory);
+    aligned_memory = memalign(64u, 16u);
+    free(aligned_memory);
+    ASSERT_EQ(posix_memalign(&memory, 64u, 16u), 0);
+    aligned_memory = memory;
+    free(aligned_memory);
+
+    EXPECT_EQ(counter.Count(), 6u);
+}
+
+TEST(MetaAlgorithmFeaturesAllocationsTest, TestSteadyStateDoesNotAllocate)
+{
+    GstAlgorithmFeaturesPool *pool = gst_algorithm_features_pool_new(
+        gst_meta_algorithm_features_get_slab_size(default_features_matrix_width,
+                                                  default_features_matrix_height,
+                                                  default_features_per_aggregation,
+                                                  ALGORITHM_FEATURE_FLAGS_ALL,
+                                                  0u));
+    GstBuffer *buffer = gst_buffer_new();
+    std::vector<gfloat> cells(static_cast<gsize>(default_features_matrix_width) * default_features_matrix_height, 1.0f);
+    std::size_t total_allocations = 0u;
+
+    for(std::size_t iteration = 0u; iteration <= steady_state_iterations; iteration++)
+    {
+        /*
+         * Adding the metadata to a buffer allocates within GStreamer, so only
+         * what happens once it is added is counted, which is the part the
+         * feature extractor does for every frame.
+         */
+        GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+        {
+            AllocationCounter counter;
+
+            ASSERT_TRUE(gst_meta_algorithm_features_set_layout(meta,
+                                                               pool,
+                                                               default_features_matrix_width,
+                                                               default_features_matrix_height,
+                                                               default_features_per_aggregation,
+                                                               ALGORITHM_FEATURE_FLAGS_ALL,
+                                                               0u));
+
+            gst_algorithm_features_aggregate(
+                cells.data(), cells.size(), default_features_per_aggregation, meta->features);
+
+            for(guint feature = 0u; feature < ALGORITHM_NUMBER_OF_FEATURES; feature++)
+            {
+                gst_algorithm_features_aggregate(
+                    cells.data(), cells.size(), default_features_per_aggregation, meta->feature_arrays[feature]);
+            }
+
+            ASSERT_TRUE(gst_buffer_remove_meta(buffer, GST_META_CAST(meta)));
+
+            /* The first iteration fills the pool */
+            if(iteration > 0u)
+            {
+                total_allocations += counter.Count();
+            }
+        }
+    }
+
+    EXPECT_EQ(total_allocations, 0u);
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(pool), 1u);
+
+    gst_buffer_unref(buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
@@ -0,0 +1,371 @@
+#include <vector>
+
+#include <gst/cuda/featureextractor/gstalgorithmfeaturespool.h>
+#include <gst/cuda/featureextractor/gstmetaalgorithmfeatures.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_features_matrix_width = 20u;
+    constexpr guint default_features_matrix_height = 20u;
+    constexpr guint default_features_per_aggregation = 10u;
+    constexpr guint default_length = 40u;
+
+    GstAlgorithmFeaturesPool *NewPool(guint feature_mask, guint number_of_rois)
+    {
+        return gst_algorithm_features_pool_new(gst_meta_algorithm_features_get_slab_size(
+            default_features_matrix_width,
+            default_features_matrix_height,
+            default_features_per_aggregation,
+            feature_mask,
+            number_of_rois));
+    }
+
+    gboolean SetLayout(GstMetaAlgorithmFeatures *meta, GstAlgorithmFeaturesPool *pool, guint feature_mask, guint number_of_rois)
+    {
+        return gst_meta_algorithm_features_set_layout(meta,
+                                                      pool,
+                                                      default_features_matrix_width,
+                                                      default_features_matrix_height,
+                                                      default_features_per_aggregation,
+                                                      feature_mask,
+                                                      number_of_rois);
+    }
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestPoolReusesSlabs)
+{
+    GstAlgorithmFeaturesPool *pool = gst_algorithm_features_pool_new(64u);
+
+    gpointer first_slab = gst_algorithm_features_pool_acquire(pool);
+    gpointer second_slab = gst_algorithm_features_pool_acquire(pool);
+
+    EXPECT_NE(first_slab, second_slab);
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(pool), 2u);
+
+    /* The most recently released slab is handed out first */
+    gst_algorithm_features_pool_release(pool, first_slab);
+    gst_algorithm_features_pool_release(pool, second_slab);
+    EXPECT_EQ(gst_algorithm_features_pool_acquire(pool), second_slab);
+    EXPECT_EQ(gst_algorithm_features_pool_acquire(pool), first_slab);
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(pool), 2u);
+
+    gst_algorithm_features_pool_release(pool, first_slab);
+    gst_algorithm_features_pool_release(pool, second_slab);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestLayout)
+{
+    const guint feature_mask = ALGORITHM_FEATURE_FLAG_PIXELS | ALGORITHM_FEATURE_FLAG_Y1_TO_Y0_MAGNITUDE;
+    GstAlgorithmFeaturesPool *pool = NewPool(feature_mask, 0u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    EXPECT_EQ(meta->features, nullptr);
+    ASSERT_TRUE(SetLayout(meta, pool, feature_mask, 0u));
+
+    EXPECT_EQ(meta->features_matrix_width, default_features_matrix_width);
+    EXPECT_EQ(meta->features_matrix_height, default_features_matrix_height);
+    EXPECT_EQ(meta->features_per_aggregation, default_features_per_aggregation);
+    EXPECT_EQ(meta->length, default_length);
+    EXPECT_EQ(meta->feature_mask, feature_mask);
+
+    /* The selected arrays follow the spatial magnitude in feature order */
+    EXPECT_EQ(meta->features, static_cast<gfloat *>(meta->slab));
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_PIXELS], meta->features + default_length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_Y1_TO_Y0_MAGNITUDE], meta->features + 2u * default_length);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_COUNT], nullptr);
+    EXPECT_EQ(meta->feature_arrays[ALGORITHM_FEATURE_X0_TO_X1_MAGNITUDE], nullptr);
+    EXPECT_EQ(meta->number_of_rois, 0u);
+    EXPECT_EQ(meta->roi_ids, nullptr);
+    EXPECT_EQ(meta->roi_features, nullptr);
+
+    gst_buffer_unref(buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestRoiLayout)
+{
+    GstAlgorithmFeaturesPool *pool = NewPool(0u, 3u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    ASSERT_TRUE(SetLayout(meta, pool, 0u, 3u));
+
+    EXPECT_EQ(meta->number_of_rois, 3u);
+    EXPECT_EQ(meta->roi_features, meta->features + default_length);
+    EXPECT_EQ(reinterpret_cast<gfloat *>(meta->roi_ids), meta->features + 4u * default_length);
+
+    for(guint idx = 0u; idx < ALGORITHM_NUMBER_OF_FEATURES; idx++)
+    {
+        EXPECT_EQ(meta->feature_arrays[idx], nullptr);
+    }
+
+    gst_buffer_unref(buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestSlabTooSmall)
+{
+    GstAlgorithmFeaturesPool *pool = NewPool(0u, 0u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    EXPECT_FALSE(SetLayout(meta, pool, ALGORITHM_FEATURE_FLAGS_ALL, 0u));
+    EXPECT_EQ(meta->features, nullptr);
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(pool), 0u);
+
+    gst_buffer_unref(buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestCopy)
+{
+    GstAlgorithmFeaturesPool *pool = NewPool(ALGORITHM_FEATURE_FLAG_COUNT, 1u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    ASSERT_TRUE(SetLayout(meta, pool, ALGORITHM_FEATURE_FLAG_COUNT, 1u));
+
+    for(guint idx = 0u; idx < default_length; idx++)
+    {
+        meta->features[idx] = static_cast<gfloat>(idx);
+        meta->feature_arrays[ALGORITHM_FEATURE_COUNT][idx] = 2.0f * idx;
+        meta->roi_features[idx] = 3.0f * idx;
+    }
+
+    meta->roi_ids[0] = 7;
+
+    /* The buffers keep the pool alive for as long as they hold a slab */
+    gst_algorithm_features_pool_unref(pool);
+
+    GstBuffer *copy = gst_buffer_copy(buffer);
+    GstMetaAlgorithmFeatures *copy_meta = GST_META_ALGORITHM_FEATURES_GET(copy);
+
+    ASSERT_NE(copy_meta, nullptr);
+    EXPECT_NE(copy_meta->slab, meta->slab);
+    EXPECT_EQ(copy_meta->pool, meta->pool);
+    EXPECT_EQ(copy_meta->length, default_length);
+    EXPECT_EQ(copy_meta->feature_mask, static_cast<guint>(ALGORITHM_FEATURE_FLAG_COUNT));
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(copy_meta->pool), 2u);
+    ASSERT_EQ(copy_meta->number_of_rois, 1u);
+    EXPECT_EQ(copy_meta->roi_ids[0], 7);
+
+    for(guint idx = 0u; idx < default_length; idx++)
+    {
+        EXPECT_FLOAT_EQ(copy_meta->features[idx], static_cast<gfloat>(idx));
+        EXPECT_FLOAT_EQ(copy_meta->feature_arrays[ALGORITHM_FEATURE_COUNT][idx], 2.0f * idx);
+        EXPECT_FLOAT_EQ(copy_meta->roi_features[idx], 3.0f * idx);
+    }
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(copy);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestSerializationRoundTrip)
+{
+    const guint feature_mask = ALGORITHM_FEATURE_FLAG_COUNT | ALGORITHM_FEATURE_FLAG_X1_TO_X0_MAGNITUDE;
+    GstAlgorithmFeaturesPool *pool = NewPool(feature_mask, 2u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *deserialized_buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    ASSERT_TRUE(SetLayout(meta, pool, feature_mask, 2u));
+
+    meta->roi_ids[0] = 7;
+    meta->roi_ids[1] = -3;
+
+    for(guint idx = 0u; idx < default_length; idx++)
+    {
+        meta->features[idx] = static_cast<gfloat>(idx);
+        meta->feature_arrays[ALGORITHM_FEATURE_COUNT][idx] = 2.0f * idx;
+        meta->feature_arrays[ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE][idx] = -0.5f * idx;
+        meta->roi_features[idx] = 3.0f * idx;
+        meta->roi_features[default_length + idx] = 4.0f * idx;
+    }
+
+    std::vector<guint8> data(gst_meta_algorithm_features_get_serialized_size(meta));
+
+    /* The header is followed by the slab as is */
+    EXPECT_EQ(data.size(), 28u + gst_algorithm_features_pool_get_slab_size(pool));
+    ASSERT_FALSE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size() - 1u));
+    ASSERT_TRUE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size()));
+
+    EXPECT_EQ(data[0], 'G');
+    EXPECT_EQ(data[1], 'A');
+    EXPECT_EQ(data[2], 'F');
+    EXPECT_EQ(data[3], 'T');
+    EXPECT_EQ(data[4], GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION);
+
+    GstMetaAlgorithmFeatures *deserialized_meta
+        = gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, data.data(), data.size());
+
+    ASSERT_NE(deserialized_meta, nullptr);
+    EXPECT_EQ(GST_META_ALGORITHM_FEATURES_GET(deserialized_buffer), deserialized_meta);
+    EXPECT_EQ(deserialized_meta->features_matrix_width, default_features_matrix_width);
+    EXPECT_EQ(deserialized_meta->features_matrix_height, default_features_matrix_height);
+    EXPECT_EQ(deserialized_meta->features_per_aggregation, default_features_per_aggregation);
+    EXPECT_EQ(deserialized_meta->length, default_length);
+    EXPECT_EQ(deserialized_meta->feature_mask, feature_mask);
+    EXPECT_EQ(deserialized_meta->feature_arrays[ALGORITHM_FEATURE_PIXELS], nullptr);
+    ASSERT_EQ(deserialized_meta->number_of_rois, 2u);
+    EXPECT_EQ(deserialized_meta->roi_ids[0], 7);
+    EXPECT_EQ(deserialized_meta->roi_ids[1], -3);
+
+    for(guint idx = 0u; idx < default_length; idx++)
+    {
+        EXPECT_EQ(deserialized_meta->features[idx], static_cast<gfloat>(idx));
+        EXPECT_EQ(deserialized_meta->feature_arrays[ALGORITHM_FEATURE_COUNT][idx], 2.0f * idx);
+        EXPECT_EQ(deserialized_meta->feature_arrays[ALGORITHM_FEATURE_X1_TO_X0_MAGNITUDE][idx], -0.5f * idx);
+        EXPECT_EQ(deserialized_meta->roi_features[idx], 3.0f * idx);
+        EXPECT_EQ(deserialized_meta->roi_features[default_length + idx], 4.0f * idx);
+    }
+
+    /* Serialising the deserialised metadata gives the same bytes */
+    std::vector<guint8> reserialized_data(gst_meta_algorithm_features_get_serialized_size(deserialized_meta));
+
+    ASSERT_TRUE(
+        gst_meta_algorithm_features_serialize(deserialized_meta, reserialized_data.data(), reserialized_data.size()));
+    EXPECT_EQ(reserialized_data, data);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(deserialized_buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestSerializationWithoutFeatures)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *deserialized_buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+    std::vector<guint8> data(gst_meta_algorithm_features_get_serialized_size(meta));
+
+    EXPECT_EQ(data.size(), 28u);
+    ASSERT_TRUE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size()));
+
+    GstMetaAlgorithmFeatures *deserialized_meta
+        = gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, data.data(), data.size());
+
+    ASSERT_NE(deserialized_meta, nullptr);
+    EXPECT_EQ(deserialized_meta->slab, nullptr);
+    EXPECT_EQ(deserialized_meta->features, nullptr);
+    EXPECT_EQ(deserialized_meta->length, 0u);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(deserialized_buffer);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestDeserializationUsesGivenPool)
+{
+    GstAlgorithmFeaturesPool *pool = NewPool(ALGORITHM_FEATURE_FLAGS_ALL, 0u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *deserialized_buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    ASSERT_TRUE(SetLayout(meta, pool, ALGORITHM_FEATURE_FLAG_PIXELS, 0u));
+
+    std::vector<guint8> data(gst_meta_algorithm_features_get_serialized_size(meta));
+
+    ASSERT_TRUE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size()));
+
+    GstMetaAlgorithmFeatures *deserialized_meta
+        = gst_meta_algorithm_features_deserialize(deserialized_buffer, pool, data.data(), data.size());
+
+    ASSERT_NE(deserialized_meta, nullptr);
+    EXPECT_EQ(deserialized_meta->pool, pool);
+    EXPECT_EQ(gst_algorithm_features_pool_get_number_of_slabs(pool), 2u);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(deserialized_buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestDeserializationRejectsInvalidData)
+{
+    GstAlgorithmFeaturesPool *pool = NewPool(ALGORITHM_FEATURE_FLAG_COUNT, 0u);
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *deserialized_buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+
+    ASSERT_TRUE(SetLayout(meta, pool, ALGORITHM_FEATURE_FLAG_COUNT, 0u));
+
+    std::vector<guint8> data(gst_meta_algorithm_features_get_serialized_size(meta));
+
+    ASSERT_TRUE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size()));
+
+    /* Truncated data */
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, data.data(), 27u), nullptr);
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, data.data(), data.size() - 4u),
+              nullptr);
+
+    /* A bad magic number */
+    std::vector<guint8> bad_magic(data);
+    bad_magic[0] = 'X';
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, bad_magic.data(), bad_magic.size()),
+              nullptr);
+
+    /* A later version of the format */
+    std::vector<guint8> bad_version(data);
+    bad_version[4] = GST_META_ALGORITHM_FEATURES_SERIALIZATION_VERSION + 1;
+    EXPECT_EQ(
+        gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, bad_version.data(), bad_version.size()),
+        nullptr);
+
+    /* A feature that does not exist */
+    std::vector<guint8> bad_mask(data);
+    bad_mask[23] = 0x80;
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, bad_mask.data(), bad_mask.size()),
+              nullptr);
+
+    EXPECT_EQ(GST_META_ALGORITHM_FEATURES_GET(deserialized_buffer), nullptr);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(deserialized_buffer);
+    gst_algorithm_features_pool_unref(pool);
+}
+
+TEST(MetaAlgorithmFeaturesTest, TestDeserializationRejectsMalformedLayout)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *deserialized_buffer = gst_buffer_new();
+    GstMetaAlgorithmFeatures *meta = GST_META_ALGORITHM_FEATURES_ADD(buffer);
+    std::vector<guint8> data(gst_meta_algorithm_features_get_serialized_size(meta));
+
+    ASSERT_TRUE(gst_meta_algorithm_features_serialize(meta, data.data(), data.size()));
+
+    /*
+     * A layout whose slab size wraps around to the size of the data would
+     * otherwise describe arrays far beyond the slab.
+     */
+    std::vector<guint8> huge_grid(data);
+    GST_WRITE_UINT32_LE(huge_grid.data() + 8, G_MAXUINT32);
+    GST_WRITE_UINT32_LE(huge_grid.data() + 12, G_MAXUINT32);
+    GST_WRITE_UINT32_LE(huge_grid.data() + 16, 1u);
+    GST_WRITE_UINT32_LE(huge_grid.data() + 20, ALGORITHM_FEATURE_FLAGS_ALL);
+    GST_WRITE_UINT32_LE(huge_grid.data() + 24, G_MAXUINT32);
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, huge_grid.data(), huge_grid.size()),
+              nullptr);
+
+    /* Just past the largest grid */
+    std::vector<guint8> wide_grid(data);
+    GST_WRITE_UINT32_LE(wide_grid.data() + 8, G_MAXUINT16 + 1u);
+    GST_WRITE_UINT32_LE(wide_grid.data() + 12, 1u);
+    GST_WRITE_UINT32_LE(wide_grid.data() + 16, G_MAXUINT16 + 1u);
+    wide_grid.resize(wide_grid.size() + sizeof(gfloat));
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(deserialized_buffer, NULL, wide_grid.data(), wide_grid.size()),
+              nullptr);
+
+    /* Regions of interest without any aggregation */
+    std::vector<guint8> no_aggregation(data);
+    GST_WRITE_UINT32_LE(no_aggregation.data() + 24, 1u);
+    EXPECT_EQ(gst_meta_algorithm_features_deserialize(
+                  deserialized_buffer, NULL, no_aggregation.data(), no_aggregation.size()),
+              nullptr);
+
+    EXPECT_EQ(GST_META_ALGORITHM_FEATURES_GET(deserialized_buffer), nullptr);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(deserialized_buffer);
+}
@@ -0,0 +1,214 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include <gst/cuda/of/gstmetaopticalflow.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+
+namespace
+{
+    constexpr guint32 default_cols = 3u;
+    constexpr guint32 default_rows = 2u;
+    constexpr gint32 default_grid_size = 4;
+    constexpr gsize default_header_size = 24u;
+
+    void WriteUint32(std::vector<guint8> &data, gsize offset, guint32 value)
+    {
+        GST_WRITE_UINT32_LE(data.data() + offset, value);
+    }
+
+    /*
+     * Builds serialised metadata by hand, holding a synthetic
+     * default_rows x default_cols matrix of CV_32FC2 values, so that the tests
+     * do not need a GPU to create the metadata.
+     */
+    std::vector<guint8> SerializedOpticalFlow()
+    {
+        const gsize number_of_values = static_cast<gsize>(default_cols) * default_rows * 2u;
+        std::vector<guint8> data(default_header_size + number_of_values * sizeof(gfloat));
+
+        data[0] = 'G';
+        data[1] = 'O';
+        data[2] = 'F';
+        data[3] = 'L';
+        data[4] = GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION;
+        data[5] = 0x01u;
+        WriteUint32(data, 8u, static_cast<guint32>(default_grid_size));
+        WriteUint32(data, 12u, default_cols);
+        WriteUint32(data, 16u, default_rows);
+        WriteUint32(data, 20u, CV_32FC2);
+
+        for(gsize idx = 0u; idx < number_of_values; idx++)
+        {
+            GST_WRITE_FLOAT_LE(data.data() + default_header_size + idx * sizeof(gfloat), idx * 0.25f - 1.0f);
+        }
+
+        return data;
+    }
+
+    void ExpectDefaultValues(const GstMetaOpticalFlow *meta)
+    {
+        ASSERT_NE(meta->host_optical_flow_vectors, nullptr);
+        ASSERT_EQ(meta->host_optical_flow_vectors->cols, static_cast<gint>(default_cols));
+        ASSERT_EQ(meta->host_optical_flow_vectors->rows, static_cast<gint>(default_rows));
+        ASSERT_EQ(meta->host_optical_flow_vectors->type(), CV_32FC2);
+
+        for(guint32 row = 0u; row < default_rows; row++)
+        {
+            for(guint32 col = 0u; col < default_cols; col++)
+            {
+                gsize idx = (static_cast<gsize>(row) * default_cols + col) * 2u;
+                const cv::Vec2f &value = meta->host_optical_flow_vectors->at<cv::Vec2f>(row, col);
+
+                EXPECT_EQ(value[0], idx * 0.25f - 1.0f) << "Row " << row << ", column " << col;
+                EXPECT_EQ(value[1], (idx + 1u) * 0.25f - 1.0f) << "Row " << row << ", column " << col;
+            }
+        }
+    }
+}
+
+TEST(MetaOpticalFlowTest, TestSerializationRoundTrip)
+{
+    std::vector<guint8> data = SerializedOpticalFlow();
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaOpticalFlow *meta = gst_meta_optical_flow_deserialize(buffer, data.data(), data.size(), -1);
+
+    ASSERT_NE(meta, nullptr);
+    EXPECT_EQ(GST_META_OPTICAL_FLOW_GET(buffer), meta);
+    EXPECT_EQ(meta->optical_flow_vectors, nullptr);
+    EXPECT_EQ(meta->context, nullptr);
+    EXPECT_EQ(meta->optical_flow_vector_grid_size, default_grid_size);
+    EXPECT_TRUE(meta->synthetic);
+    EXPECT_EQ(meta->shared_memory, nullptr);
+    ExpectDefaultValues(meta);
+
+    /* Serialising the deserialised metadata gives the same bytes */
+    std::vector<guint8> reserialized_data(gst_meta_optical_flow_get_serialized_size(meta, FALSE));
+
+    ASSERT_EQ(reserialized_data.size(), data.size());
+    ASSERT_FALSE(gst_meta_optical_flow_serialize(meta, reserialized_data.data(), reserialized_data.size() - 1u, FALSE));
+    ASSERT_TRUE(gst_meta_optical_flow_serialize(meta, reserialized_data.data(), reserialized_data.size(), FALSE));
+    EXPECT_EQ(reserialized_data, data);
+
+    gst_buffer_unref(buffer);
+}
+
+TEST(MetaOpticalFlowTest, TestSharedMemoryRoundTrip)
+{
+    std::vector<guint8> data = SerializedOpticalFlow();
+    GstBuffer *buffer = gst_buffer_new();
+    GstBuffer *shared_buffer = gst_buffer_new();
+    GstMetaOpticalFlow *meta = gst_meta_optical_flow_deserialize(buffer, data.data(), data.size(), -1);
+
+    ASSERT_NE(meta, nullptr);
+
+    gint fd = gst_meta_optical_flow_export_shared_memory(meta);
+
+    ASSERT_GE(fd, 0);
+
+    /* The receiving process can rely on the file not changing */
+    gint seals = fcntl(fd, F_GET_SEALS);
+    EXPECT_TRUE(seals & F_SEAL_WRITE);
+    EXPECT_TRUE(seals & F_SEAL_SHRINK);
+
+    /* Only the header is serialised, as the values are in the file */
+    std::vector<guint8> header(gst_meta_optical_flow_get_serialized_size(meta, TRUE));
+
+    ASSERT_EQ(header.size(), default_header_size);
+    ASSERT_TRUE(gst_meta_optical_flow_serialize(meta, header.data(), header.size(), TRUE));
+
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(shared_buffer, header.data(), header.size(), -1), nullptr);
+
+    GstMetaOpticalFlow *shared_meta = gst_meta_optical_flow_deserialize(shared_buffer, header.data(), header.size(), fd);
+
+    /* The mapping outlives the file descriptor */
+    EXPECT_EQ(close(fd), 0);
+
+    ASSERT_NE(shared_meta, nullptr);
+    EXPECT_NE(shared_meta->shared_memory, nullptr);
+    EXPECT_EQ(shared_meta->host_optical_flow_vectors->data, shared_meta->shared_memory);
+    EXPECT_EQ(shared_meta->optical_flow_vector_grid_size, default_grid_size);
+    ExpectDefaultValues(shared_meta);
+
+    gst_buffer_unref(buffer);
+    gst_buffer_unref(shared_buffer);
+}
+
+TEST(MetaOpticalFlowTest, TestCopy)
+{
+    std::vector<guint8> data = SerializedOpticalFlow();
+    GstBuffer *buffer = gst_buffer_new();
+    GstMetaOpticalFlow *meta = gst_meta_optical_flow_deserialize(buffer, data.data(), data.size(), -1);
+
+    ASSERT_NE(meta, nullptr);
+
+    GstBuffer *copy = gst_buffer_copy(buffer);
+    GstMetaOpticalFlow *copy_meta = GST_META_OPTICAL_FLOW_GET(copy);
+
+    /* The copy holds its own values, so it outlives the original */
+    gst_buffer_unref(buffer);
+
+    ASSERT_NE(copy_meta, nullptr);
+    EXPECT_EQ(copy_meta->optical_flow_vectors, nullptr);
+    EXPECT_EQ(copy_meta->optical_flow_vector_grid_size, default_grid_size);
+    EXPECT_TRUE(copy_meta->synthetic);
+    ExpectDefaultValues(copy_meta);
+
+    gst_buffer_unref(copy);
+}
+
+TEST(MetaOpticalFlowTest, TestWithoutValues)
+{
+    std::vector<guint8> data = SerializedOpticalFlow();
+    GstBuffer *buffer = gst_buffer_new();
+
+    data.resize(default_header_size);
+    WriteUint32(data, 12u, 0u);
+    WriteUint32(data, 16u, 0u);
+
+    GstMetaOpticalFlow *meta = gst_meta_optical_flow_deserialize(buffer, data.data(), data.size(), -1);
+
+    ASSERT_NE(meta, nullptr);
+    EXPECT_EQ(meta->host_optical_flow_vectors, nullptr);
+    EXPECT_EQ(gst_meta_optical_flow_get_serialized_size(meta, FALSE), default_header_size);
+    EXPECT_EQ(gst_meta_optical_flow_export_shared_memory(meta), -1);
+
+    gst_buffer_unref(buffer);
+}
+
+TEST(MetaOpticalFlowTest, TestDeserializationRejectsInvalidData)
+{
+    std::vector<guint8> data = SerializedOpticalFlow();
+    GstBuffer *buffer = gst_buffer_new();
+
+    /* Truncated data */
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, data.data(), default_header_size - 1u, -1), nullptr);
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, data.data(), data.size() - 1u, -1), nullptr);
+
+    /* A bad magic number */
+    std::vector<guint8> bad_magic(data);
+    bad_magic[3] = 'X';
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, bad_magic.data(), bad_magic.size(), -1), nullptr);
+
+    /* A later version of the format */
+    std::vector<guint8> bad_version(data);
+    bad_version[4] = GST_META_OPTICAL_FLOW_SERIALIZATION_VERSION + 1;
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, bad_version.data(), bad_version.size(), -1), nullptr);
+
+    /* A type the optical flow algorithms never output */
+    std::vector<guint8> bad_type(data);
+    WriteUint32(bad_type, 20u, CV_64FC2);
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, bad_type.data(), bad_type.size(), -1), nullptr);
+
+    /* Values in shared memory without a file */
+    std::vector<guint8> bad_shared_memory(data.begin(), data.begin() + default_header_size);
+    bad_shared_memory[5] |= 0x02u;
+    EXPECT_EQ(gst_meta_optical_flow_deserialize(buffer, bad_shared_memory.data(), bad_shared_memory.size(), -1),
+              nullptr);
+
+    EXPECT_EQ(GST_META_OPTICAL_FLOW_GET(buffer), nullptr);
+
+    gst_buffer_unref(buffer);
+}
@@ -0,0 +1,214 @@
+#include <initializer_list>
+#include <string>
+
+#include <gst/app/gstappsink.h>
+#include <gst/cuda/nvcodec/gstcudacontext.h>
+#include <gst/cuda/nvcodec/gstcudaloader.h>
+#include <gst/cuda/nvcodec/gstcudamemory.h>
+#include <gst/cuda/nvcodec/gstcudautils.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_width = 320u;
+    constexpr guint default_height = 240u;
+    constexpr guint default_num_buffers = 10u;
+
+    bool HasElements(std::initializer_list<const char *> names)
+    {
+        for(const char *name : names)
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    void CountNotify(gpointer user_data)
+    {
+        (*static_cast<guint *>(user_data))++;
+    }
+
+    /*
+     * Decodes a white test pattern with nvh264dec in zero-copy mode, and
+     * returns the first decoded buffer once the pipeline, and with it the
+     * decoder, is gone.
+     */
+    GstBuffer *DecodeFirstBufferAndTearDown()
+    {
+        std::string description = "videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+                                  + " pattern=white ! video/x-raw,format=NV12,width=" + std::to_string(default_width)
+                                  + ",height=" + std::to_string(default_height)
+                                  + ",framerate=30/1 ! nvh264enc ! h264parse ! nvh264dec zero-copy=true ! "
+                                    "video/x-raw(memory:CUDAMemory) ! appsink name=sink sync=false";
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return nullptr;
+        }
+
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+        GstBuffer *buffer = nullptr;
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+
+        if(sample != nullptr)
+        {
+            buffer = gst_buffer_ref(gst_sample_get_buffer(sample));
+            gst_sample_unref(sample);
+        }
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(sink);
+        gst_object_unref(pipeline);
+
+        return buffer;
+    }
+}
+
+TEST(NvDecoderTest, TestWrappedMemoryNotifiesOnLastUnref)
+{
+    if(!gst_cuda_load_library())
+    {
+        GTEST_SKIP() << "CUDA not available";
+    }
+
+    GstCudaContext *context = gst_cuda_context_new(0);
+
+    if(context == nullptr)
+    {
+        GTEST_SKIP() << "No CUDA device";
+    }
+
+    GstAllocator *allocator = gst_cuda_allocator_new(context);
+    GstCudaAllocationParams params = {};
+    gsize offset[GST_VIDEO_MAX_PLANES] = {};
+    CUdeviceptr data = 0;
+    guint notify_count = 0u;
+
+    gst_video_info_set_format(&params.info, GST_VIDEO_FORMAT_NV12, default_width, default_height);
+    offset[1] = static_cast<gsize>(default_width) * default_height;
+
+    ASSERT_TRUE(gst_cuda_context_push(context));
+    ASSERT_TRUE(gst_cuda_result(CuMemAlloc(&data, GST_VIDEO_INFO_SIZE(&params.info))));
+    gst_cuda_context_pop(nullptr);
+
+    GstMemory *memory = gst_cuda_allocator_alloc_wrapped(
+        allocator, &params, data, default_width, offset, &notify_count, CountNotify);
+    GstBuffer *buffer = gst_buffer_new();
+
+    ASSERT_NE(memory, nullptr);
+    EXPECT_TRUE(gst_is_cuda_memory(memory));
+    gst_buffer_append_memory(buffer, memory);
+
+    /* The copy shares the memory, which the owner only gets back once both are gone */
+    GstBuffer *copy = gst_buffer_copy(buffer);
+
+    gst_buffer_unref(buffer);
+    gst_object_unref(allocator);
+    EXPECT_EQ(notify_count, 0u);
+
+    gst_buffer_unref(copy);
+    EXPECT_EQ(notify_count, 1u);
+
+    ASSERT_TRUE(gst_cuda_context_push(context));
+    EXPECT_TRUE(gst_cuda_result(CuMemFree(data)));
+    gst_cuda_context_pop(nullptr);
+
+    gst_object_unref(context);
+}
+
+TEST(NvDecoderTest, TestZeroCopyBufferOutlivesDecoder)
+{
+    if(!HasElements({"videotestsrc", "nvh264enc", "h264parse", "nvh264dec"}))
+    {
+        GTEST_SKIP() << "nvh264enc, h264parse or nvh264dec not available";
+    }
+
+    GstBuffer *buffer = DecodeFirstBufferAndTearDown();
+
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(gst_buffer_n_memory(buffer), 1u);
+    EXPECT_TRUE(gst_is_cuda_memory(gst_buffer_peek_memory(buffer, 0)));
+
+    /*
+     * The wrapped surface is still mapped against the decoder instance the
+     * frame came from, which the memory keeps alive after the element closed
+     * its decoder.
+     */
+    GstMapInfo map;
+
+    ASSERT_TRUE(gst_buffer_map(buffer, &map, GST_MAP_READ));
+    /* White is 235 in limited range luma, give or take the encoder */
+    EXPECT_NEAR(map.data[0], 235, 4);
+    gst_buffer_unmap(buffer, &map);
+
+    gst_buffer_unref(buffer);
+}
+
+TEST(NvDecoderTest, TestZeroCopyOnlyChangesInNullState)
+{
+    if(!HasElements({"nvh264dec"}))
+    {
+        GTEST_SKIP() << "nvh264dec not available";
+    }
+
+    GstElement *decoder = gst_element_factory_make("nvh264dec", nullptr);
+    gboolean zero_copy = FALSE;
+
+    ASSERT_NE(decoder, nullptr);
+
+    g_object_set(decoder, "zero-copy", TRUE, nullptr);
+    g_object_get(decoder, "zero-copy", &zero_copy, nullptr);
+    EXPECT_TRUE(zero_copy);
+
+    if(gst_element_set_state(decoder, GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS)
+    {
+        /* The decoder was opened with zero-copy, so the change is refused */
+        g_object_set(decoder, "zero-copy", FALSE, nullptr);
+        g_object_get(decoder, "zero-copy", &zero_copy, nullptr);
+        EXPECT_TRUE(zero_copy);
+    }
+
+    gst_element_set_state(decoder, GST_STATE_NULL);
+    gst_object_unref(decoder);
+}
+
+TEST(NvDecoderTest, TestSurfaceWaitTimeoutDefaultsToNoWait)
+{
+    if(!HasElements({"nvh264dec"}))
+    {
+        GTEST_SKIP() << "nvh264dec not available";
+    }
+
+    GstElement *decoder = gst_element_factory_make("nvh264dec", nullptr);
+    guint64 timeout = G_MAXUINT64;
+
+    ASSERT_NE(decoder, nullptr);
+
+    /* Failing right away when all the surfaces are held downstream, as before */
+    g_object_get(decoder, "surface-wait-timeout", &timeout, nullptr);
+    EXPECT_EQ(timeout, 0u);
+
+    g_object_set(decoder, "surface-wait-timeout", static_cast<guint64>(GST_CLOCK_TIME_NONE), nullptr);
+    g_object_get(decoder, "surface-wait-timeout", &timeout, nullptr);
+    EXPECT_EQ(timeout, GST_CLOCK_TIME_NONE);
+
+    gst_object_unref(decoder);
+}
@@ -0,0 +1,230 @@
+#include <string>
+#include <vector>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/transcoder/gsttranscoder.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 150u;
+    constexpr guint default_key_int = 15u;
+    constexpr GstClockTime default_clip_start = 700 * GST_MSECOND;
+    constexpr GstClockTime default_clip_stop = 3300 * GST_MSECOND;
+    constexpr guint default_num_clip_frames = 78u;
+    constexpr const char *default_profile = "video/mpegts,systemstream=true:video/x-h264";
+
+    struct OutputFrames
+    {
+        std::vector<GstClockTime> pts;
+        std::vector<bool> keyframes;
+    };
+
+    bool HasRequiredElements()
+    {
+        for(const char *name : {"videotestsrc",
+                                "x264enc",
+                                "h264parse",
+                                "mp4mux",
+                                "mpegtsmux",
+                                "tsdemux",
+                                "uritranscodebin",
+                                "urisourcebin",
+                                "concat",
+                                "parsebin"})
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    bool RunPipeline(const std::string &description)
+    {
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return false;
+        }
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        bool ret = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+
+        gst_message_unref(message);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return ret;
+    }
+
+    void OnHandoff(GstElement *, GstBuffer *buffer, GstPad *, gpointer user_data)
+    {
+        auto *frames = static_cast<OutputFrames *>(user_data);
+
+        frames->pts.push_back(GST_BUFFER_PTS(buffer));
+        frames->keyframes.push_back(!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+    }
+
+    OutputFrames ReadFrames(const std::string &location)
+    {
+        OutputFrames frames;
+        std::string description = "filesrc location=" + location
+                                  + " ! tsdemux ! h264parse ! fakesink name=sink "
+                                    "signal-handoffs=true sync=false";
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return frames;
+        }
+
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        g_signal_connect(sink, "handoff", G_CALLBACK(OnHandoff), &frames);
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+
+        EXPECT_EQ(GST_MESSAGE_TYPE(message), GST_MESSAGE_EOS);
+        gst_message_unref(message);
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(sink);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return frames;
+    }
+
+    OutputFrames Clip(const std::string &source, const std::string &dest, bool smart_render)
+    {
+        gchar *source_uri = gst_filename_to_uri(source.c_str(), nullptr);
+        gchar *dest_uri = gst_filename_to_uri(dest.c_str(), nullptr);
+        GstTranscoder *transcoder = gst_transcoder_new(source_uri, dest_uri, default_profile);
+        GError *error = nullptr;
+
+        gst_transcoder_set_clip_range(transcoder, default_clip_start, default_clip_stop);
+        gst_transcoder_set_smart_render(transcoder, smart_render);
+
+        EXPECT_TRUE(gst_transcoder_run(transcoder, &error));
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        gst_object_unref(transcoder);
+        g_free(source_uri);
+        g_free(dest_uri);
+
+        return ReadFrames(dest);
+    }
+
+    guint CountKeyframes(const OutputFrames &frames)
+    {
+        guint num_keyframes = 0u;
+
+        for(bool keyframe : frames.keyframes)
+        {
+            num_keyframes += keyframe ? 1u : 0u;
+        }
+
+        return num_keyframes;
+    }
+}
+
+class TranscoderClipTestFixture : public ::testing::Test
+{
+    protected:
+    std::string _source;
+    std::string _transcoded;
+    std::string _smart_rendered;
+
+    void SetUp() override
+    {
+        if(!HasRequiredElements())
+        {
+            GTEST_SKIP() << "x264enc, mp4mux, mpegtsmux, tsdemux or uritranscodebin not available";
+        }
+
+        gchar *dir = g_dir_make_tmp("gst-transcoder-clip-XXXXXX", nullptr);
+
+        ASSERT_NE(dir, nullptr);
+        _source = std::string(dir) + "/source.mp4";
+        _transcoded = std::string(dir) + "/transcoded.ts";
+        _smart_rendered = std::string(dir) + "/smart-rendered.ts";
+        g_free(dir);
+
+        ASSERT_TRUE(RunPipeline(
+            "videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+            + " pattern=ball ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+              "x264enc key-int-max="
+            + std::to_string(default_key_int)
+            + " speed-preset=ultrafast ! h264parse ! mp4mux ! filesink location=" + _source));
+    }
+
+    void TearDown() override
+    {
+        for(const std::string &path : {_source, _transcoded, _smart_rendered})
+        {
+            if(!path.empty())
+            {
+                g_remove(path.c_str());
+            }
+        }
+    }
+};
+
+TEST_F(TranscoderClipTestFixture, TestSmartRenderKeepsClipRange)
+{
+    OutputFrames transcoded = Clip(_source, _transcoded, false);
+    OutputFrames smart_rendered = Clip(_source, _smart_rendered, true);
+
+    EXPECT_NEAR(transcoded.pts.size(), default_num_clip_frames, 1u);
+    EXPECT_EQ(smart_rendered.pts.size(), transcoded.pts.size());
+}
+
+TEST_F(TranscoderClipTestFixture, TestSmartRenderStartsWithKeyframe)
+{
+    OutputFrames smart_rendered = Clip(_source, _smart_rendered, true);
+
+    ASSERT_FALSE(smart_rendered.keyframes.empty());
+    EXPECT_TRUE(smart_rendered.keyframes.front());
+}
+
+TEST_F(TranscoderClipTestFixture, TestSmartRenderCopiesInnerGops)
+{
+    OutputFrames transcoded = Clip(_source, _transcoded, false);
+    OutputFrames smart_rendered = Clip(_source, _smart_rendered, true);
+
+    /* the copied GOPs keep the keyframe interval of the source, which is
+     * shorter than the one of the encoder of the profile */
+    EXPECT_GT(CountKeyframes(smart_rendered), CountKeyframes(transcoded));
+    EXPECT_GE(CountKeyframes(smart_rendered), 4u);
+}
@@ -0,0 +1,363 @@
+#include <string>
+#include <vector>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+#include <gst/transcoder/gsttranscoder.h>
+#include <gst/transcoder/gsttranscoderqueue.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 60u;
+    constexpr guint default_progress_update_interval_ms = 10u;
+    constexpr guint64 default_message_timeout = 60u * GST_SECOND;
+
+    struct QueueProgress
+    {
+        gint cpu_usage;
+        guint n_pending;
+        guint n_running;
+        guint n_done;
+        guint n_failed;
+    };
+
+    struct QueueMessages
+    {
+        std::vector<guint> done_ids;
+        std::vector<guint> failed_ids;
+        std::vector<QueueProgress> progress;
+        GstClockTime position = GST_CLOCK_TIME_NONE;
+        GstClockTime duration = GST_CLOCK_TIME_NONE;
+    };
+
+    bool HasRequiredElements()
+    {
+        for(const char *name : {"videotestsrc", "x264enc", "h264parse", "mp4mux", "uritranscodebin"})
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    bool RunPipeline(const std::string &description)
+    {
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return false;
+        }
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        bool ret = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+
+        gst_message_unref(message);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return ret;
+    }
+
+    GstEncodingProfile *MakeProfile()
+    {
+        GstCaps *container_caps = gst_caps_from_string("video/quicktime,variant=iso");
+        GstCaps *video_caps = gst_caps_from_string("video/x-h264");
+        GstEncodingContainerProfile *profile
+            = gst_encoding_container_profile_new("mp4", nullptr, container_caps, nullptr);
+
+        gst_encoding_container_profile_add_profile(
+            profile, GST_ENCODING_PROFILE(gst_encoding_video_profile_new(video_caps, nullptr, nullptr, 0)));
+
+        gst_caps_unref(container_caps);
+        gst_caps_unref(video_caps);
+
+        return GST_ENCODING_PROFILE(profile);
+    }
+
+    GstTranscoderQueue *NewQueue(guint max_jobs)
+    {
+        return GST_TRANSCODER_QUEUE(g_object_new(GST_TYPE_TRANSCODER_QUEUE,
+                                                 "max-jobs",
+                                                 max_jobs,
+                                                 "progress-update-interval",
+                                                 default_progress_update_interval_ms,
+                                                 nullptr));
+    }
+
+    /*
+     * Pops the messages of the queue until num_jobs jobs are done, and the
+     * progress message posted once the queue is idle.
+     */
+    QueueMessages CollectMessages(GstTranscoderQueue *queue, guint num_jobs)
+    {
+        QueueMessages messages;
+        GstBus *bus = gst_transcoder_queue_get_message_bus(queue);
+        bool idle = false;
+
+        while(!idle)
+        {
+            GstMessage *message = gst_bus_timed_pop_filtered(bus, default_message_timeout, GST_MESSAGE_APPLICATION);
+
+            if(message == nullptr)
+            {
+                ADD_FAILURE() << "Timed out waiting for the queue";
+                break;
+            }
+
+            const GstStructure *structure = gst_message_get_structure(message);
+            GstTranscoderMessage type = GST_TRANSCODER_MESSAGE_POSITION_UPDATED;
+
+            EXPECT_TRUE(gst_transcoder_is_transcoder_message(message));
+            gst_structure_get(structure, "transcoder-message-type", GST_TYPE_TRANSCODER_MESSAGE, &type, nullptr);
+
+            if(type == GST_TRANSCODER_MESSAGE_JOB_DONE)
+            {
+                guint job_id = 0u;
+                GError *error = nullptr;
+
+                gst_transcoder_message_parse_job_done(message, &job_id, &error);
+                (error ? messages.failed_ids : messages.done_ids).push_back(job_id);
+                g_clear_error(&error);
+            }
+            else if(type == GST_TRANSCODER_MESSAGE_QUEUE_PROGRESS)
+            {
+                QueueProgress progress = {};
+
+                gst_structure_get(structure,
+                                  "cpu-usage",
+                                  G_TYPE_INT,
+                                  &progress.cpu_usage,
+                                  "n-pending",
+                                  G_TYPE_UINT,
+                                  &progress.n_pending,
+                                  "n-running",
+                                  G_TYPE_UINT,
+                                  &progress.n_running,
+                                  "n-done",
+                                  G_TYPE_UINT,
+                                  &progress.n_done,
+                                  "n-failed",
+                                  G_TYPE_UINT,
+                                  &progress.n_failed,
+                                  nullptr);
+                gst_transcoder_message_parse_queue_progress(message, &messages.position, &messages.duration, nullptr);
+                messages.progress.push_back(progress);
+
+                idle = progress.n_pending == 0u && progress.n_running == 0u
+                       && messages.done_ids.size() + messages.failed_ids.size() == num_jobs;
+            }
+
+            gst_message_unref(message);
+        }
+
+        gst_object_unref(bus);
+
+        return messages;
+    }
+}
+
+class TranscoderQueueTestFixture : public ::testing::Test
+{
+    protected:
+    std::string _dir;
+    std::string _source_uri;
+    std::vector<std::string> _outputs;
+    GstEncodingProfile *_profile = nullptr;
+
+    void SetUp() override
+    {
+        if(!HasRequiredElements())
+        {
+            GTEST_SKIP() << "x264enc, mp4mux or uritranscodebin not available";
+        }
+
+        gchar *dir = g_dir_make_tmp("gst-transcoder-queue-XXXXXX", nullptr);
+
+        ASSERT_NE(dir, nullptr);
+        _dir = dir;
+        g_free(dir);
+
+        std::string source = _dir + "/source.mp4";
+        gchar *source_uri = gst_filename_to_uri(source.c_str(), nullptr);
+
+        _outputs.push_back(source);
+        _source_uri = source_uri;
+        g_free(source_uri);
+
+        ASSERT_TRUE(RunPipeline("videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+                                + " ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+                                  "x264enc speed-preset=ultrafast ! h264parse ! mp4mux ! filesink location="
+                                + source));
+
+        _profile = MakeProfile();
+    }
+
+    void TearDown() override
+    {
+        for(const std::string &path : _outputs)
+        {
+            g_remove(path.c_str());
+        }
+
+        if(!_dir.empty())
+        {
+            g_rmdir(_dir.c_str());
+        }
+
+        g_clear_object(&_profile);
+    }
+
+    guint AddJob(GstTranscoderQueue *queue, gint priority)
+    {
+        std::string dest = _dir + "/output-" + std::to_string(_outputs.size()) + ".mp4";
+        gchar *dest_uri = gst_filename_to_uri(dest.c_str(), nullptr);
+        guint id = gst_transcoder_queue_add_job(queue, _source_uri.c_str(), dest_uri, _profile, priority);
+
+        _outputs.push_back(dest);
+        g_free(dest_uri);
+
+        return id;
+    }
+};
+
+TEST_F(TranscoderQueueTestFixture, TestPriorityAndFifoOrdering)
+{
+    GstTranscoderQueue *queue = NewQueue(1u);
+
+    /*
+     * The first job may start before the others are added, so it has the
+     * highest priority for the order to be the same either way.
+     */
+    guint first = AddJob(queue, 10);
+    guint low_1 = AddJob(queue, 0);
+    guint high_1 = AddJob(queue, 5);
+    guint high_2 = AddJob(queue, 5);
+    guint low_2 = AddJob(queue, 0);
+
+    QueueMessages messages = CollectMessages(queue, 5u);
+
+    /* One job at a time, so they are done in the order they were started */
+    std::vector<guint> expected_ids = {first, high_1, high_2, low_1, low_2};
+
+    EXPECT_EQ(messages.done_ids, expected_ids);
+    EXPECT_TRUE(messages.failed_ids.empty());
+    EXPECT_TRUE(gst_transcoder_queue_wait(queue, nullptr));
+
+    gst_object_unref(queue);
+}
+
+TEST_F(TranscoderQueueTestFixture, TestMaxJobsBound)
+{
+    GstTranscoderQueue *queue = NewQueue(2u);
+
+    for(guint idx = 0u; idx < 5u; idx++)
+    {
+        AddJob(queue, 0);
+    }
+
+    QueueMessages messages = CollectMessages(queue, 5u);
+
+    ASSERT_FALSE(messages.progress.empty());
+
+    for(const QueueProgress &progress : messages.progress)
+    {
+        EXPECT_LE(progress.n_running, 2u);
+        EXPECT_EQ(progress.n_pending + progress.n_running + progress.n_done + progress.n_failed, 5u);
+    }
+
+    EXPECT_EQ(messages.done_ids.size(), 5u);
+
+    gst_object_unref(queue);
+}
+
+TEST_F(TranscoderQueueTestFixture, TestAdmissionControlOnceCpuUsageIsSampled)
+{
+    GstTranscoderQueue *queue = NewQueue(4u);
+
+    /* Lets the queue measure its CPU usage before any job is added */
+    g_usleep(5u * default_progress_update_interval_ms * 1000u);
+
+    for(guint idx = 0u; idx < 4u; idx++)
+    {
+        AddJob(queue, 0);
+    }
+
+    QueueMessages messages = CollectMessages(queue, 4u);
+    guint num_started = 1u;
+
+    ASSERT_FALSE(messages.progress.empty());
+
+    /*
+     * While the usage of the last job started is not known yet, no other job
+     * is started, so at most one more job runs every time the usage is
+     * sampled, however much CPU there is to spare.
+     */
+    for(const QueueProgress &progress : messages.progress)
+    {
+        guint started = progress.n_running + progress.n_done + progress.n_failed;
+
+        EXPECT_GE(progress.cpu_usage, 0);
+        EXPECT_LE(started, num_started + 1u);
+        num_started = MAX(num_started, started);
+    }
+
+    EXPECT_EQ(messages.done_ids.size(), 4u);
+
+    gst_object_unref(queue);
+}
+
+TEST_F(TranscoderQueueTestFixture, TestJobDoneAndProgressMessages)
+{
+    GstTranscoderQueue *queue = NewQueue(2u);
+    guint done_id = AddJob(queue, 0);
+    guint failed_id = gst_transcoder_queue_add_job(
+        queue, "file:///nonexistent/source.mp4", "file:///nonexistent/output.mp4", _profile, 0);
+
+    EXPECT_NE(done_id, 0u);
+    EXPECT_NE(failed_id, done_id);
+
+    QueueMessages messages = CollectMessages(queue, 2u);
+
+    EXPECT_EQ(messages.done_ids, std::vector<guint>({done_id}));
+    EXPECT_EQ(messages.failed_ids, std::vector<guint>({failed_id}));
+
+    /* The last progress message accounts for both jobs */
+    ASSERT_FALSE(messages.progress.empty());
+    EXPECT_EQ(messages.progress.back().n_done, 1u);
+    EXPECT_EQ(messages.progress.back().n_failed, 1u);
+
+    /* Only the job which succeeded knows its duration, all of it transcoded */
+    ASSERT_TRUE(GST_CLOCK_TIME_IS_VALID(messages.duration));
+    EXPECT_GT(messages.duration, 0u);
+    EXPECT_EQ(messages.position, messages.duration);
+
+    GError *error = nullptr;
+
+    EXPECT_FALSE(gst_transcoder_queue_wait(queue, &error));
+    EXPECT_NE(error, nullptr);
+    g_clear_error(&error);
+
+    gst_object_unref(queue);
+}
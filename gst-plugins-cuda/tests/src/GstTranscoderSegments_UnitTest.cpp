@@ -0,0 +1,219 @@
+#include <string>
+#include <vector>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/transcoder/gsttranscoder.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 150u;
+    constexpr guint default_key_int = 15u;
+    constexpr guint default_num_segments = 3u;
+    constexpr const char *default_profile = "video/quicktime,variant=iso:video/x-h264";
+
+    struct OutputFrames
+    {
+        std::vector<GstClockTime> pts;
+        std::vector<bool> keyframes;
+    };
+
+    bool HasRequiredElements()
+    {
+        for(const char *name : {"videotestsrc",
+                                "x264enc",
+                                "h264parse",
+                                "mp4mux",
+                                "qtdemux",
+                                "uritranscodebin",
+                                "concat",
+                                "parsebin"})
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    bool RunPipeline(const std::string &description)
+    {
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return false;
+        }
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        bool ret = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+
+        gst_message_unref(message);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return ret;
+    }
+
+    void OnHandoff(GstElement *, GstBuffer *buffer, GstPad *, gpointer user_data)
+    {
+        auto *frames = static_cast<OutputFrames *>(user_data);
+
+        frames->pts.push_back(GST_BUFFER_PTS(buffer));
+        frames->keyframes.push_back(!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+    }
+
+    OutputFrames ReadFrames(const std::string &location)
+    {
+        OutputFrames frames;
+        std::string description = "filesrc location=" + location
+                                  + " ! qtdemux ! h264parse ! fakesink name=sink "
+                                    "signal-handoffs=true sync=false";
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return frames;
+        }
+
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        g_signal_connect(sink, "handoff", G_CALLBACK(OnHandoff), &frames);
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+
+        EXPECT_EQ(GST_MESSAGE_TYPE(message), GST_MESSAGE_EOS);
+        gst_message_unref(message);
+
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(sink);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return frames;
+    }
+
+    OutputFrames Transcode(const std::string &source, const std::string &dest, guint n_segments)
+    {
+        gchar *source_uri = gst_filename_to_uri(source.c_str(), nullptr);
+        gchar *dest_uri = gst_filename_to_uri(dest.c_str(), nullptr);
+        GstTranscoder *transcoder = gst_transcoder_new(source_uri, dest_uri, default_profile);
+        GError *error = nullptr;
+
+        gst_transcoder_set_n_segments(transcoder, n_segments);
+
+        EXPECT_TRUE(gst_transcoder_run(transcoder, &error));
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        gst_object_unref(transcoder);
+        g_free(source_uri);
+        g_free(dest_uri);
+
+        return ReadFrames(dest);
+    }
+}
+
+class TranscoderSegmentsTestFixture : public ::testing::Test
+{
+    protected:
+    std::string _source;
+    std::string _serial;
+    std::string _segmented;
+
+    void SetUp() override
+    {
+        if(!HasRequiredElements())
+        {
+            GTEST_SKIP() << "x264enc, mp4mux, qtdemux or uritranscodebin not available";
+        }
+
+        gchar *dir = g_dir_make_tmp("gst-transcoder-segments-XXXXXX", nullptr);
+
+        ASSERT_NE(dir, nullptr);
+        _source = std::string(dir) + "/source.mp4";
+        _serial = std::string(dir) + "/serial.mp4";
+        _segmented = std::string(dir) + "/segmented.mp4";
+        g_free(dir);
+
+        ASSERT_TRUE(RunPipeline(
+            "videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+            + " pattern=ball ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+              "x264enc key-int-max="
+            + std::to_string(default_key_int)
+            + " speed-preset=ultrafast ! h264parse ! mp4mux ! filesink location=" + _source));
+    }
+
+    void TearDown() override
+    {
+        for(const std::string &path : {_source, _serial, _segmented})
+        {
+            if(!path.empty())
+            {
+                g_remove(path.c_str());
+            }
+        }
+    }
+};
+
+TEST_F(TranscoderSegmentsTestFixture, TestSegmentedOutputMatchesSerial)
+{
+    OutputFrames serial = Transcode(_source, _serial, 1u);
+    OutputFrames segmented = Transcode(_source, _segmented, default_num_segments);
+
+    EXPECT_EQ(serial.pts.size(), default_num_buffers);
+    EXPECT_EQ(segmented.pts, serial.pts);
+}
+
+TEST_F(TranscoderSegmentsTestFixture, TestEverySegmentStartsWithKeyframe)
+{
+    OutputFrames segmented = Transcode(_source, _segmented, default_num_segments);
+    guint num_keyframes = 0u;
+
+    ASSERT_FALSE(segmented.keyframes.empty());
+    EXPECT_TRUE(segmented.keyframes.front());
+
+    for(bool keyframe : segmented.keyframes)
+    {
+        num_keyframes += keyframe ? 1u : 0u;
+    }
+
+    EXPECT_GE(num_keyframes, default_num_segments);
+}
+
+TEST_F(TranscoderSegmentsTestFixture, TestSegmentedOutputIsDeterministic)
+{
+    OutputFrames first = Transcode(_source, _segmented, default_num_segments);
+    OutputFrames second = Transcode(_source, _segmented, default_num_segments);
+
+    EXPECT_EQ(first.pts, second.pts);
+    EXPECT_EQ(first.keyframes, second.keyframes);
+}
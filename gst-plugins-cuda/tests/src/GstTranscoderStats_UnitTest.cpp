@@ -0,0 +1,227 @@
+#include <string>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/transcoder/gsttranscoder.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr guint default_num_buffers = 90u;
+    constexpr const char *default_profile = "video/quicktime,variant=iso:video/x-h264";
+
+    struct CollectedStats
+    {
+        guint num_messages = 0u;
+        GstStructure *elements = nullptr;
+    };
+
+    bool HasRequiredElements()
+    {
+        for(const char *name : {"videotestsrc", "x264enc", "h264parse", "mp4mux", "uritranscodebin"})
+        {
+            GstElementFactory *factory = gst_element_factory_find(name);
+
+            if(factory == nullptr)
+            {
+                return false;
+            }
+
+            gst_object_unref(factory);
+        }
+
+        return true;
+    }
+
+    bool RunPipeline(const std::string &description)
+    {
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.c_str(), &error);
+
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        if(pipeline == nullptr)
+        {
+            return false;
+        }
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+            bus,
+            GST_CLOCK_TIME_NONE,
+            static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        bool ret = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+
+        gst_message_unref(message);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(bus);
+        gst_object_unref(pipeline);
+
+        return ret;
+    }
+
+    void OnStats(GstTranscoderSignalAdapter *, gdouble fps, gdouble realtime_factor, GstStructure *elements, gpointer user_data)
+    {
+        auto *stats = static_cast<CollectedStats *>(user_data);
+
+        EXPECT_GE(fps, 0.0);
+        EXPECT_GE(realtime_factor, 0.0);
+
+        stats->num_messages++;
+
+        if(stats->elements != nullptr)
+        {
+            gst_structure_free(stats->elements);
+        }
+
+        stats->elements = gst_structure_copy(elements);
+    }
+
+    const GstStructure *FindElementStats(const GstStructure *elements, const char *prefix)
+    {
+        for(gint i = 0; i < gst_structure_n_fields(elements); i++)
+        {
+            const gchar *name = gst_structure_nth_field_name(elements, i);
+
+            if(g_str_has_prefix(name, prefix))
+            {
+                return gst_value_get_structure(gst_structure_get_value(elements, name));
+            }
+        }
+
+        return nullptr;
+    }
+}
+
+class TranscoderStatsTestFixture : public ::testing::Test
+{
+    protected:
+    std::string _source;
+    std::string _dest;
+    std::string _trace;
+    CollectedStats _stats;
+
+    void SetUp() override
+    {
+        if(!HasRequiredElements())
+        {
+            GTEST_SKIP() << "x264enc, mp4mux or uritranscodebin not available";
+        }
+
+        gchar *dir = g_dir_make_tmp("gst-transcoder-stats-XXXXXX", nullptr);
+
+        ASSERT_NE(dir, nullptr);
+        _source = std::string(dir) + "/source.mp4";
+        _dest = std::string(dir) + "/dest.mp4";
+        _trace = std::string(dir) + "/trace.json";
+        g_free(dir);
+
+        ASSERT_TRUE(RunPipeline(
+            "videotestsrc num-buffers=" + std::to_string(default_num_buffers)
+            + " ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+              "x264enc speed-preset=ultrafast ! h264parse ! mp4mux ! filesink location="
+            + _source));
+    }
+
+    void TearDown() override
+    {
+        if(_stats.elements != nullptr)
+        {
+            gst_structure_free(_stats.elements);
+        }
+
+        for(const std::string &path : {_source, _dest, _trace})
+        {
+            if(!path.empty())
+            {
+                g_remove(path.c_str());
+            }
+        }
+    }
+
+    void Transcode(bool collect_stats)
+    {
+        gchar *source_uri = gst_filename_to_uri(_source.c_str(), nullptr);
+        gchar *dest_uri = gst_filename_to_uri(_dest.c_str(), nullptr);
+        GstTranscoder *transcoder = gst_transcoder_new(source_uri, dest_uri, default_profile);
+        GstTranscoderSignalAdapter *adapter = gst_transcoder_get_signal_adapter(transcoder, nullptr);
+        GError *error = nullptr;
+
+        gst_transcoder_set_collect_stats(transcoder, collect_stats);
+        gst_transcoder_set_stats_trace_file(transcoder, _trace.c_str());
+        g_signal_connect(adapter, "stats", G_CALLBACK(OnStats), &_stats);
+
+        EXPECT_TRUE(gst_transcoder_run(transcoder, &error));
+        EXPECT_EQ(error, nullptr);
+        g_clear_error(&error);
+
+        g_object_unref(adapter);
+        gst_object_unref(transcoder);
+        g_free(source_uri);
+        g_free(dest_uri);
+    }
+};
+
+TEST_F(TranscoderStatsTestFixture, TestEncoderStats)
+{
+    Transcode(true);
+
+    ASSERT_GT(_stats.num_messages, 0u);
+    ASSERT_NE(_stats.elements, nullptr);
+
+    const GstStructure *encoder = FindElementStats(_stats.elements, "x264enc");
+    guint64 buffers = 0u;
+    GstClockTime latency_mean = 0u;
+    GstClockTime latency_max = 0u;
+
+    ASSERT_NE(encoder, nullptr);
+    EXPECT_TRUE(gst_structure_get(encoder,
+                                  "buffers", G_TYPE_UINT64, &buffers,
+                                  "latency-mean", GST_TYPE_CLOCK_TIME, &latency_mean,
+                                  "latency-max", GST_TYPE_CLOCK_TIME, &latency_max,
+                                  nullptr));
+    EXPECT_EQ(buffers, default_num_buffers);
+    EXPECT_GT(latency_mean, 0u);
+    EXPECT_GE(latency_max, latency_mean);
+
+    const GValue *histogram = gst_structure_get_value(encoder, "latency-histogram");
+    guint64 num_latencies = 0u;
+
+    ASSERT_NE(histogram, nullptr);
+    for(guint i = 0; i < gst_value_array_get_size(histogram); i++)
+    {
+        num_latencies += g_value_get_uint64(gst_value_array_get_value(histogram, i));
+    }
+
+    EXPECT_EQ(num_latencies, buffers);
+}
+
+TEST_F(TranscoderStatsTestFixture, TestTraceFile)
+{
+    Transcode(true);
+
+    gchar *contents = nullptr;
+
+    ASSERT_TRUE(g_file_get_contents(_trace.c_str(), &contents, nullptr, nullptr));
+
+    std::string trace(contents);
+
+    g_free(contents);
+
+    EXPECT_EQ(trace.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"throughput\""), std::string::npos);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+}
+
+TEST_F(TranscoderStatsTestFixture, TestNoStatsByDefault)
+{
+    Transcode(false);
+
+    EXPECT_EQ(_stats.num_messages, 0u);
+    EXPECT_FALSE(g_file_test(_trace.c_str(), G_FILE_TEST_EXISTS));
+}
@@ -0,0 +1,385 @@
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gst/codecparsers/gstvpxbooldecoder.h>
+#include <gst/gst.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr std::size_t default_num_streams = 500u;
+    constexpr std::size_t default_max_bools = 4096u;
+    /* Roughly the number of booleans in a VP8 key frame header with
+     * coefficient probability updates */
+    constexpr std::size_t frame_header_bools = 1500u;
+    constexpr std::size_t benchmark_iterations = 20000u;
+
+    /* The VP8 boolean encoder from RFC 6386, section 7.3 */
+    class BoolEncoder
+    {
+        public:
+        void Write(bool bit, guint8 prob)
+        {
+            guint32 split = 1u + (((this->range - 1u) * prob) >> 8);
+
+            if(bit)
+            {
+                this->bottom += split;
+                this->range -= split;
+            }
+            else
+            {
+                this->range = split;
+            }
+
+            while(this->range < 128u)
+            {
+                this->range <<= 1;
+
+                if(this->bottom & (1u << 31))
+                {
+                    this->AddOne();
+                }
+
+                this->bottom <<= 1;
+
+                if(!--this->bit_count)
+                {
+                    this->output.push_back(
+                        static_cast<guint8>((this->bottom >> 24) & 0xff));
+                    this->bottom &= (1u << 24) - 1u;
+                    this->bit_count = 8;
+                }
+            }
+        }
+
+        std::vector<guint8> Flush()
+        {
+            guint32 value = this->bottom;
+
+            if(value & (1u << (32 - this->bit_count)))
+            {
+                this->AddOne();
+            }
+
+            value <<= this->bit_count & 7;
+
+            for(int i = (this->bit_count >> 3) - 1; i >= 0; i--)
+            {
+                value <<= 8;
+            }
+
+            for(int i = 0; i < 4; i++)
+            {
+                this->output.push_back(static_cast<guint8>((value >> 24) & 0xff));
+                value <<= 8;
+            }
+
+            return this->output;
+        }
+
+        private:
+        void AddOne()
+        {
+            auto it = this->output.rbegin();
+
+            while(it != this->output.rend() && *it == 0xff)
+            {
+                *it++ = 0;
+            }
+
+            if(it != this->output.rend())
+            {
+                ++*it;
+            }
+        }
+
+        guint32 range = 255u;
+        guint32 bottom = 0u;
+        int bit_count = 24;
+        std::vector<guint8> output;
+    };
+
+    /* The byte-at-a-time decoder from RFC 6386, section 7.3, which the
+     * parsers used before switching to the 64-bit window */
+    class ReferenceBoolDecoder
+    {
+        public:
+        ReferenceBoolDecoder(const guint8 *data, std::size_t size)
+            : input(data), input_end(data + size)
+        {
+            for(int i = 0; i < 2; i++)
+            {
+                this->value = (this->value << 8) | this->NextByte();
+            }
+        }
+
+        bool Read(guint8 prob)
+        {
+            guint32 split = 1u + (((this->range - 1u) * prob) >> 8);
+            guint32 big_split = split << 8;
+            bool bit;
+
+            if(this->value >= big_split)
+            {
+                bit = true;
+                this->range -= split;
+                this->value -= big_split;
+            }
+            else
+            {
+                bit = false;
+                this->range = split;
+            }
+
+            while(this->range < 128u)
+            {
+                this->value <<= 1;
+                this->range <<= 1;
+
+                if(++this->bit_count == 8)
+                {
+                    this->bit_count = 0;
+                    this->value |= this->NextByte();
+                }
+            }
+
+            return bit;
+        }
+
+        private:
+        guint32 NextByte()
+        {
+            return this->input < this->input_end ? *this->input++ : 0u;
+        }
+
+        const guint8 *input;
+        const guint8 *input_end;
+        guint32 range = 255u;
+        guint32 value = 0u;
+        int bit_count = 0;
+    };
+
+    struct EncodedStream
+    {
+        std::vector<bool> bits;
+        std::vector<guint8> probs;
+        std::vector<guint8> data;
+    };
+
+    EncodedStream EncodeStream(std::mt19937 &rng, std::vector<guint8> probs)
+    {
+        std::uniform_int_distribution<int> byte_dist(0, 255);
+        EncodedStream stream;
+        BoolEncoder encoder;
+
+        for(guint8 prob : probs)
+        {
+            bool bit = byte_dist(rng) >= prob;
+
+            encoder.Write(bit, prob);
+            stream.bits.push_back(bit);
+        }
+
+        stream.probs = std::move(probs);
+        stream.data = encoder.Flush();
+
+        return stream;
+    }
+
+    EncodedStream EncodeRandomStream(std::mt19937 &rng, std::size_t num_bools)
+    {
+        std::uniform_int_distribution<int> prob_dist(1, 255);
+        std::vector<guint8> probs(num_bools);
+
+        for(guint8 &prob : probs)
+        {
+            prob = static_cast<guint8>(prob_dist(rng));
+        }
+
+        return EncodeStream(rng, std::move(probs));
+    }
+
+    /* Frame headers mostly code update flags with a probability close to 255
+     * and only a few literals */
+    EncodedStream EncodeFrameHeaderLikeStream(std::mt19937 &rng, std::size_t num_bools)
+    {
+        std::uniform_int_distribution<int> flag_dist(0, 7);
+        std::uniform_int_distribution<int> prob_dist(240, 255);
+        std::vector<guint8> probs(num_bools);
+
+        for(guint8 &prob : probs)
+        {
+            prob = flag_dist(rng) != 0 ? static_cast<guint8>(prob_dist(rng)) : 128u;
+        }
+
+        return EncodeStream(rng, std::move(probs));
+    }
+}
+
+TEST(VpxBoolDecoderTest, TestDecodesEncodedStreams)
+{
+    std::mt19937 rng(0x5650u);
+    std::uniform_int_distribution<std::size_t> size_dist(1u, default_max_bools);
+
+    for(std::size_t stream_idx = 0u; stream_idx < default_num_streams; stream_idx++)
+    {
+        EncodedStream stream = EncodeRandomStream(rng, size_dist(rng));
+        GstVpxBoolDecoder bd;
+
+        ASSERT_TRUE(
+            gst_vpx_bool_decoder_init(&bd, stream.data.data(), stream.data.size()));
+
+        for(std::size_t idx = 0u; idx < stream.bits.size(); idx++)
+        {
+            ASSERT_EQ(
+                gst_vpx_bool_decoder_read(&bd, stream.probs[idx]) != FALSE,
+                stream.bits[idx])
+                << "stream " << stream_idx << " boolean " << idx;
+        }
+
+        EXPECT_FALSE(gst_vpx_bool_decoder_has_error(&bd));
+    }
+}
+
+TEST(VpxBoolDecoderTest, TestMatchesReferenceDecoderOnArbitraryData)
+{
+    std::mt19937 rng(0x5638u);
+    std::uniform_int_distribution<std::size_t> size_dist(0u, 64u);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+
+    for(std::size_t stream_idx = 0u; stream_idx < default_num_streams; stream_idx++)
+    {
+        std::vector<guint8> data(size_dist(rng));
+
+        for(guint8 &byte : data)
+        {
+            byte = static_cast<guint8>(byte_dist(rng));
+        }
+
+        /* An encoder never emits 0xff as first byte, the decoding window
+         * would start out of range */
+        if(!data.empty() && data[0] == 0xff)
+        {
+            data[0] = 0xfe;
+        }
+
+        ReferenceBoolDecoder reference(data.data(), data.size());
+        GstVpxBoolDecoder bd;
+
+        gst_vpx_bool_decoder_init(&bd, data.data(), data.size());
+
+        /* Also decode well past the end of the data, where both decoders
+         * shift in zeros */
+        for(std::size_t idx = 0u; idx < 8u * data.size() + 128u; idx++)
+        {
+            auto prob = static_cast<guint8>(byte_dist(rng));
+
+            ASSERT_EQ(gst_vpx_bool_decoder_read(&bd, prob) != FALSE, reference.Read(prob))
+                << "stream " << stream_idx << " boolean " << idx;
+        }
+    }
+}
+
+TEST(VpxBoolDecoderTest, TestReadLiteral)
+{
+    BoolEncoder encoder;
+    std::vector<guint8> data;
+    GstVpxBoolDecoder bd;
+
+    for(guint32 value : {0x0u, 0x5u, 0x7fu, 0xa5a5u, 0xdeadbeefu})
+    {
+        for(int bit = 31; bit >= 0; bit--)
+        {
+            encoder.Write((value >> bit) & 1u, 128);
+        }
+    }
+
+    data = encoder.Flush();
+    gst_vpx_bool_decoder_init(&bd, data.data(), data.size());
+
+    for(guint32 value : {0x0u, 0x5u, 0x7fu, 0xa5a5u, 0xdeadbeefu})
+    {
+        EXPECT_EQ(gst_vpx_bool_decoder_read_literal(&bd, 32), value);
+    }
+
+    EXPECT_FALSE(gst_vpx_bool_decoder_has_error(&bd));
+}
+
+TEST(VpxBoolDecoderTest, TestReportsReadsPastTheEnd)
+{
+    const guint8 data[4] = {0x00, 0x00, 0x00, 0x00};
+    GstVpxBoolDecoder bd;
+
+    gst_vpx_bool_decoder_init(&bd, data, sizeof(data));
+
+    /* Decoding a boolean of probability 1/2 consumes about one bit, on top of
+     * the 8 bits the comparison window needs */
+    for(int idx = 0; idx < 16; idx++)
+    {
+        gst_vpx_bool_decoder_read(&bd, 128);
+    }
+
+    EXPECT_FALSE(gst_vpx_bool_decoder_has_error(&bd));
+
+    for(int idx = 0; idx < 128; idx++)
+    {
+        gst_vpx_bool_decoder_read(&bd, 128);
+    }
+
+    EXPECT_TRUE(gst_vpx_bool_decoder_has_error(&bd));
+}
+
+TEST(VpxBoolDecoderTest, TestFrameHeaderDecodingThroughput)
+{
+    std::mt19937 rng(0x4844u);
+    EncodedStream stream = EncodeFrameHeaderLikeStream(rng, frame_header_bools);
+    guint checksum = 0u;
+    guint reference_checksum = 0u;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+    {
+        GstVpxBoolDecoder bd;
+
+        gst_vpx_bool_decoder_init(&bd, stream.data.data(), stream.data.size());
+
+        for(guint8 prob : stream.probs)
+        {
+            checksum += gst_vpx_bool_decoder_read(&bd, prob);
+        }
+    }
+
+    auto window_elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+
+    for(std::size_t iteration = 0u; iteration < benchmark_iterations; iteration++)
+    {
+        ReferenceBoolDecoder reference(stream.data.data(), stream.data.size());
+
+        for(guint8 prob : stream.probs)
+        {
+            reference_checksum += reference.Read(prob);
+        }
+    }
+
+    auto reference_elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(checksum, reference_checksum);
+
+    ::testing::Test::RecordProperty(
+        "window-ns-per-header",
+        std::to_string(static_cast<int>(window_elapsed.count() / benchmark_iterations)));
+    ::testing::Test::RecordProperty(
+        "reference-ns-per-header",
+        std::to_string(
+            static_cast<int>(reference_elapsed.count() / benchmark_iterations)));
+}